@@ -0,0 +1,175 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef mitkExtractSliceCache_h_Included
+#define mitkExtractSliceCache_h_Included
+
+#include "MitkCoreExports.h"
+#include "mitkImage.h"
+
+#include <itkObject.h>
+#include <itkMutexLock.h>
+#include <itkConditionVariable.h>
+#include <itkMultiThreader.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+
+#include <deque>
+#include <list>
+#include <vector>
+
+namespace mitk
+{
+  /**
+  \brief Least recently used cache of slices extracted by an ExtractSliceFilter.
+
+  Slices are identified by the input image, its modification time, the time step and the
+  complete configuration of the vtkImageReslice (reslice axes, transform, output extent,
+  spacing and interpolation). A slice is therefore only reused if vtkImageReslice would
+  produce exactly the same output. Modifying the image invalidates all its slices.
+
+  Slices can be computed ahead of time by a background thread (see Prefetch()), this is
+  used by ExtractSliceFilter to extract the neighbouring slices in scroll direction.
+
+  The cache counts hits and misses and the time needed to provide a slice in either case,
+  which allows to judge the benefit for a given workflow.
+
+  \sa ExtractSliceFilter::SetSliceCache
+  */
+  class MITKCORE_EXPORT ExtractSliceCache : public itk::Object
+  {
+  public:
+
+    mitkClassMacroItkParent(ExtractSliceCache, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /** \brief Identifies a slice, see CreateKey().*/
+    struct Key
+    {
+      const Image* m_Image;
+      unsigned long m_ImageMTime;
+      unsigned int m_TimeStep;
+      std::vector<double> m_ResliceParameters;
+
+      bool operator==(const Key& other) const;
+    };
+
+    /** \brief Creates the key for the slice that reslice extracts from the given time step of image.
+    * The reslice has to be set up completely.
+    */
+    static Key CreateKey(const Image* image, unsigned int timeStep, vtkImageReslice* reslice);
+
+    /** \brief Copies the cached slice for key into slice. Returns false if the slice is not cached.*/
+    bool Lookup(const Key& key, vtkImageData* slice);
+
+    /** \brief Stores a copy of slice. Least recently used slices are removed if the cache exceeds its maximum size.*/
+    void Insert(const Key& key, vtkImageData* slice);
+
+    /** \brief Returns true if the slice for key is cached or waiting to be prefetched.*/
+    bool Contains(const Key& key);
+
+    /** \brief Extracts the given slices in a background thread and stores them in the cache.
+    * Each reslice must be set up completely and must not be used by the caller anymore.
+    * image is kept alive until the slices are extracted. Pending slices of a previous call are discarded.
+    * The background thread reads the image through an ImageReadAccessor and skips slices of images that
+    * are being written or were modified since the call. Prefetched slices never replace cached slices.
+    */
+    void Prefetch(const Image* image, const std::vector<Key>& keys, const std::vector<vtkSmartPointer<vtkImageReslice> >& reslices);
+
+    /** \brief Removes all slices of image.*/
+    void Invalidate(const Image* image);
+
+    /** \brief Removes all slices.*/
+    void Clear();
+
+    /** \brief Maximum memory used by the cached slices in bytes.*/
+    void SetMaximumSize(unsigned long maximumSize);
+    itkGetConstMacro(MaximumSize, unsigned long);
+
+    /** \brief Memory used by the cached slices in bytes.*/
+    unsigned long GetSize();
+
+    /** \brief Number of slices that are extracted ahead in scroll direction (0 disables prefetching).*/
+    itkSetMacro(NumberOfPrefetchedSlices, unsigned int);
+    itkGetConstMacro(NumberOfPrefetchedSlices, unsigned int);
+
+    /** \brief Records how long it took to provide a slice, called by ExtractSliceFilter.*/
+    void RecordAccess(bool hit, double seconds);
+
+    unsigned long GetNumberOfHits();
+    unsigned long GetNumberOfMisses();
+    unsigned long GetNumberOfPrefetches();
+    /** \brief Fraction of the requests that were served from the cache.*/
+    double GetHitRate();
+    /** \brief Mean time in seconds to provide a cached slice.*/
+    double GetMeanHitLatency();
+    /** \brief Mean time in seconds to extract a slice that was not cached.*/
+    double GetMeanMissLatency();
+    void ResetStatistics();
+
+  protected:
+    ExtractSliceCache();
+    virtual ~ExtractSliceCache();
+
+    struct Entry
+    {
+      Key m_Key;
+      vtkSmartPointer<vtkImageData> m_Slice;
+      unsigned long m_Size;
+    };
+
+    struct PrefetchRequest
+    {
+      Key m_Key;
+      vtkSmartPointer<vtkImageReslice> m_Reslice;
+      Image::ConstPointer m_Image; // keeps the voxel data alive while the slice is extracted
+    };
+
+    /** \brief Stores a copy of slice, a prefetched slice is only stored if it fits into the free space.*/
+    void Insert(const Key& key, vtkImageData* slice, bool prefetched);
+
+    /** \brief Removes least recently used slices until the cache fits into size, m_Mutex has to be locked.*/
+    void Shrink(unsigned long size);
+
+    /** \brief Finds the slice for key and removes outdated slices of its image, m_Mutex has to be locked.*/
+    std::list<Entry>::iterator Find(const Key& key);
+
+    static ITK_THREAD_RETURN_TYPE PrefetchThread(void* pInfoStruct);
+
+    std::list<Entry> m_Entries; // most recently used first
+    unsigned long m_Size;
+    unsigned long m_MaximumSize;
+    unsigned int m_NumberOfPrefetchedSlices;
+
+    std::deque<PrefetchRequest> m_PrefetchQueue;
+
+    unsigned long m_NumberOfHits;
+    unsigned long m_NumberOfMisses;
+    unsigned long m_NumberOfPrefetches;
+    double m_HitTime;
+    double m_MissTime;
+
+    itk::SimpleMutexLock m_Mutex;
+    itk::ConditionVariable::Pointer m_PrefetchCondition;
+    itk::MultiThreader::Pointer m_MultiThreader;
+    int m_ThreadId;
+    bool m_StopThread;
+  };
+}
+
+#endif // mitkExtractSliceCache_h_Included
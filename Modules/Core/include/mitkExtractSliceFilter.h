@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "MitkCoreExports.h"
 #include "mitkImageToImageFilter.h"
+#include "mitkExtractSliceCache.h"
 #include <vtkSmartPointer.h>
 
 #include <vtkImageReslice.h>
@@ -57,6 +58,11 @@ namespace mitk
   - a transform NULL (No transform is set).
   - time step 0.
   - resample by geometry false (Corresponds to input image).
+
+  Optionally, extracted slices can be kept in an ExtractSliceCache (see SetSliceCache()). Slices
+  are then reused as long as the image is not modified, and the neighbouring slices in the
+  direction the world geometry was moved (or the next time steps if only the time step changed)
+  are extracted in the background. This is used when scrolling through a volume in ImageVtkMapper2D.
   */
   class MITKCORE_EXPORT ExtractSliceFilter : public ImageToImageFilter
   {
@@ -141,6 +147,22 @@ namespace mitk
 
     void SetInterpolationMode( ExtractSliceFilter::ResliceInterpolation interpolation){ this->m_InterpolationMode = interpolation; }
 
+    /** \brief Set a cache for the extracted slices, NULL disables caching (default).
+    * The cache is only used for plane geometries and if the filter uses a plain vtkImageReslice.
+    */
+    void SetSliceCache(ExtractSliceCache* cache){ this->m_SliceCache = cache; }
+    ExtractSliceCache* GetSliceCache(){ return this->m_SliceCache; }
+
+    /** \brief Extract slices of planes that lie on the voxel grid of the image by copying the voxels
+    * instead of resampling them with vtkImageReslice (default true).
+    * This is only possible if a reslice transform is set and the output is 2D.
+    */
+    void SetAxisAlignedExtraction(bool enabled){ this->m_AxisAlignedExtraction = enabled; }
+    bool GetAxisAlignedExtraction(){ return this->m_AxisAlignedExtraction; }
+
+    /** \brief Returns true if the last update copied the slice instead of resampling it with vtkImageReslice.*/
+    bool GetSliceCopied(){ return this->m_SliceCopied; }
+
   protected:
     ExtractSliceFilter(vtkImageReslice* reslicer = nullptr);
     virtual ~ExtractSliceFilter();
@@ -149,6 +171,21 @@ namespace mitk
     virtual void GenerateOutputInformation() override;
     virtual void GenerateInputRequestedRegion() override;
 
+    /** \brief Calculates the output extent of the slice in pixels.
+    * Returns false if the plane does not intersect the reference geometry.
+    */
+    bool CalculateSliceExtent(const PlaneGeometry* planeGeometry, const Vector2D& extent, int& xMin, int& xMax, int& yMin, int& yMax);
+
+    /** \brief Copies the slice into the output of m_Reslicer if the plane lies on the voxel grid.
+    * origin is the center of the first pixel of the plane, right and bottom are normalized.
+    * Returns false if the slice has to be resampled.
+    */
+    bool ExtractAxisAlignedSlice(Image* input, const Point3D& origin, const Vector3D& right, const Vector3D& bottom,
+                                 int xMin, int xMax, int yMin, int yMax);
+
+    /** \brief Sets up reslicers for the slices that are likely requested next and passes them to the slice cache.*/
+    void PrefetchSlices(const Image* input, const PlaneGeometry* planeGeometry, const Vector2D& extent);
+
     const PlaneGeometry* m_WorldGeometry;
     vtkSmartPointer<vtkImageReslice> m_Reslicer;
 
@@ -173,6 +210,18 @@ namespace mitk
     bool m_VtkOutputRequested;
 
     double m_BackgroundLevel;
+
+    ExtractSliceCache::Pointer m_SliceCache;
+
+    bool m_AxisAlignedExtraction;
+
+    bool m_SliceCopied;
+
+    // position of the previously extracted slice, used to determine the scroll direction
+    const Image* m_LastInput;
+    Point3D m_LastOrigin;
+    Vector3D m_LastNormal;
+    unsigned int m_LastTimeStep;
   };
 }
 
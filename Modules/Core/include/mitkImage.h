@@ -238,6 +238,33 @@ public:
   //## @sa SetPicChannel
   virtual bool SetImportChannel(void *data, int n = 0, ImportMemoryManagementType importMemoryManagement = CopyMemory );
 
+  //##Documentation
+  //## @brief Use the mapped range of @a mappedFile as data of channel @a n (out-of-core image).
+  //##
+  //## Nothing is read or copied: the operating system pages in the parts of the file
+  //## that are accessed (e.g. the slices and time steps being viewed) and can drop clean
+  //## pages again under memory pressure, instead of swapping a heap copy. Volumes and
+  //## slices of the channel refer to the mapping, so image accessors work as usual.
+  //## The mapped range has to contain the raw pixel data of the channel in the native
+  //## byte order and has to be at least as large as the channel.
+  //## @sa MemoryMappedFile, IsMemoryMapped, PrefetchVolume, EvictVolume
+  virtual bool SetMemoryMappedChannel(MemoryMappedFile* mappedFile, int n = 0);
+
+  //##Documentation
+  //## @brief Check whether the data of channel @a n is a memory mapped file
+  bool IsMemoryMapped(int n = 0) const;
+
+  //##Documentation
+  //## @brief Hint that the volume at time @a t in channel @a n will be accessed soon.
+  //## Only has an effect for memory mapped channels.
+  void PrefetchVolume(int t = 0, int n = 0) const;
+
+  //##Documentation
+  //## @brief Hint that the volume at time @a t in channel @a n is not needed anymore,
+  //## so that its pages can be dropped from main memory. Only has an effect for memory
+  //## mapped channels; the data is paged in again on next access.
+  void EvictVolume(int t = 0, int n = 0) const;
+
   //##Documentation
   //## initialize new (or re-initialize) image information
   //## @warning Initialize() by pic assumes a plane, evenly spaced geometry starting at (0,0,0).
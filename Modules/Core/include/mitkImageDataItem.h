@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include <mitkIpPic.h>
 //#include "mitkPixelType.h"
 #include "mitkImageDescriptor.h"
+#include "mitkMemoryMappedFile.h"
 //#include "mitkImageVtkAccessor.h"
 
 class vtkImageData;
@@ -48,6 +49,10 @@ namespace mitk {
   //## The class is mainly used to extract sub-images inside of mitk::Image, like single slices etc.
   //## It should not be used outside of this.
   //##
+  //## The data of an ImageDataItem is either a block in main memory or, for out-of-core
+  //## data, a memory mapped file (see MemoryMappedFile). Sub-items of a memory mapped item
+  //## refer to the same mapping, so accessors work unchanged on both.
+  //##
   //## @param manageMemory Determines if image data is removed while destruction of ImageDataItem or not.
   //## @ingroup Data
   class MITKCORE_EXPORT ImageDataItem : public itk::LightObject
@@ -88,6 +93,14 @@ namespace mitk {
 
     ImageDataItem(const mitk::PixelType& type, int timestep, unsigned int dimension, unsigned int* dimensions, void* data, bool manageMemory);
 
+    /**
+    * @brief Constructs an item whose data is the memory mapped range of @a mappedFile.
+    *
+    * The mapping is kept alive by the item (and all its sub-items). It has to be at least as
+    * large as the item described by @a desc, with the pixel type of @a channel.
+    */
+    ImageDataItem(const mitk::ImageDescriptor::Pointer desc, int timestep, MemoryMappedFile* mappedFile, int channel);
+
     ImageDataItem(const ImageDataItem &other);
 
    /**
@@ -171,6 +184,23 @@ namespace mitk {
 
     virtual void Modified() const;
 
+    /**
+    * @brief Returns true if the data of this item (or of the item it is part of) is a memory mapped file.
+    */
+    bool IsMemoryMapped() const;
+
+    /**
+    * @brief Hints that the data of this item will be accessed soon. Does nothing for items in main memory.
+    */
+    void Prefetch() const;
+
+    /**
+    * @brief Hints that the data of this item is not needed anymore, so that a memory mapped
+    * item can be dropped from main memory. It is paged in again on next access.
+    * Does nothing for items in main memory.
+    */
+    void Evict() const;
+
   protected:
     unsigned char* m_Data;
 
@@ -188,6 +218,9 @@ namespace mitk {
     unsigned long m_Size;
 
   private:
+    /** Returns the mapping the data belongs to and the offset of the data within the mapping. */
+    const MemoryMappedFile* GetMappedFile(size_t& offset) const;
+
     void ComputeItemSize( const unsigned int* dimensions, unsigned int dimension);
 
     ImageDataItem::ConstPointer m_Parent;
@@ -198,6 +231,8 @@ namespace mitk {
 
     int m_Timestep;
 
+    MemoryMappedFile::Pointer m_MappedFile;
+
   };
 
 } // namespace mitk
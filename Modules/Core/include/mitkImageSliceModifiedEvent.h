@@ -0,0 +1,63 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIMAGESLICEMODIFIEDEVENT_H
+#define MITKIMAGESLICEMODIFIEDEVENT_H
+
+#include <MitkCoreExports.h>
+#include <mitkPlaneGeometry.h>
+
+#include <itkEventObject.h>
+
+namespace mitk
+{
+  /**
+  * \brief Tells the observers of an image that only the pixels within a slice have been written.
+  *
+  * Invoked on the image after the slice has been written and before Modified() is called,
+  * e.g. by the segmentation tools and by undo/redo of their slice operations. Observers that
+  * keep results derived from the image can update them for the slice instead of the whole
+  * image. The following ModifiedEvent belongs to the same change.
+  */
+  class MITKCORE_EXPORT ImageSliceModifiedEvent : public itk::AnyEvent
+  {
+  public:
+    typedef ImageSliceModifiedEvent Self;
+    typedef itk::AnyEvent Superclass;
+
+    ImageSliceModifiedEvent(const PlaneGeometry* slice = nullptr, unsigned int timeStep = 0)
+      : m_Slice(slice), m_TimeStep(timeStep) {}
+    virtual ~ImageSliceModifiedEvent() {}
+    virtual const char * GetEventName() const override { return "ImageSliceModifiedEvent"; }
+    virtual bool CheckEvent(const ::itk::EventObject* e) const override
+      { return dynamic_cast<const Self*>(e); }
+    virtual ::itk::EventObject* MakeObject() const override
+      { return new Self(m_Slice, m_TimeStep); }
+
+    /** \brief World geometry of the written slice. */
+    const PlaneGeometry* GetSlice() const { return m_Slice; }
+
+    unsigned int GetTimeStep() const { return m_TimeStep; }
+
+  private:
+    PlaneGeometry::ConstPointer m_Slice;
+    unsigned int m_TimeStep;
+    ImageSliceModifiedEvent(const Self&);
+    void operator=(const Self&);
+  };
+}
+
+#endif
@@ -89,6 +89,8 @@ namespace mitk {
  *   - \b "texture interpolation": (BoolProperty) texture interpolation of the image
  *   - \b "reslice interpolation": (VtkResliceInterpolationProperty) reslice interpolation of the image
  *   - \b "in plane resample extent by geometry": (BoolProperty) Do it or not
+ *   - \b "Image Rendering.Slice Cache": (BoolProperty) Cache the extracted slices and extract the next slices
+ *     in scroll direction in the background, see mitk::ExtractSliceCache (default: off)
  *   - \b "bounding box": (BoolProperty) Is the Bounding Box of the image shown or not
  *   - \b "layer": (IntProperty) Layer of the image
  *   - \b "volume annotation color": (ColorProperty) color of the volume annotation, TODO has to be reimplemented
@@ -184,6 +186,9 @@ public:
     /** \brief Timestamp of last update of stored data. */
     itk::TimeStamp m_LastUpdateTime;
 
+    /** \brief Time step displayed at the last update, used to prefetch and evict memory mapped volumes. */
+    int m_LastTimeStep;
+
     /** \brief mmPerPixel relation between pixel and mm. (World spacing).*/
     mitk::ScalarType* m_mmPerPixel;
 
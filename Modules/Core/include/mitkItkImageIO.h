@@ -40,6 +40,13 @@ public:
   ItkImageIO(itk::ImageIOBase::Pointer imageIO);
   ItkImageIO(const CustomMimeType& mimeType, itk::ImageIOBase::Pointer imageIO, int rank);
 
+  /**
+   * Reader option: if true, uncompressed NRRD and MetaImage files are not read into
+   * memory but memory mapped (see Image::SetMemoryMappedChannel). Files that cannot be
+   * mapped (compressed data, foreign byte order, ...) are read as usual.
+   */
+  static std::string OPTION_MEMORY_MAPPING();
+
   // -------------- AbstractFileReader -------------
 
   using AbstractFileReader::Read;
@@ -59,6 +66,13 @@ protected:
   // Fills the m_DefaultMetaDataKeys vector with default values
   virtual void InitializeDefaultMetaDataKeys();
 
+  /**
+   * Determines the file and offset of the raw pixel data if the file read by m_ImageIO
+   * stores it uncompressed, unsplit, in native byte order and with the vector or list axis
+   * (if any) as the fastest axis. Returns false otherwise.
+   */
+  virtual bool GetRawPixelDataLocation(const std::string& path, std::string& dataFile, size_t& offset) const;
+
 private:
 
   ItkImageIO(const ItkImageIO& other);
@@ -103,6 +103,20 @@ public:
   //## corresponding to the given values; if nothing found, then returns NULL
   virtual OperationEvent* GetLastOfType(OperationActor* destination, OperationType opType) override;
 
+  //##Documentation
+  //## @brief Limits the memory held by the items of the undo and redo stack (in bytes, 0 = unlimited)
+  //##
+  //## When a new item exceeds the limit, the oldest items of the undo stack are removed
+  //## (all items of an object event at once) and an UndoFullEvent is invoked. The
+  //## newest item is always kept, even if it alone exceeds the limit.
+  //## @sa UndoStackItem::GetMemoryUsage
+  void SetMemoryLimit(size_t memoryLimit);
+  size_t GetMemoryLimit() const;
+
+  //##Documentation
+  //## @brief Returns the memory in bytes held by the items of the undo and redo stack
+  size_t GetMemoryUsage() const;
+
 protected:
   //##Documentation
   //## Constructor
@@ -120,6 +134,11 @@ protected:
 
   UndoContainer m_RedoList;
 
+  size_t m_MemoryLimit;
+
+  //## @brief Removes the oldest items of the undo stack until the memory limit is met
+  void EnforceMemoryLimit();
+
 private:
   int FirstObjectEventIdOfCurrentGroup(UndoContainer& stack);
 
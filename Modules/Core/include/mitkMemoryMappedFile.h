@@ -0,0 +1,140 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKMEMORYMAPPEDFILE_H
+#define MITKMEMORYMAPPEDFILE_H
+
+#include <MitkCoreExports.h>
+#include <mitkCommon.h>
+
+#include <itkLightObject.h>
+
+#include <string>
+
+namespace mitk
+{
+  /**
+  * \brief Maps a byte range of a file into the address space of the process.
+  *
+  * The mapped range is paged in by the operating system on first access, so only
+  * the parts of the file that are actually touched become resident. This is used
+  * as an out-of-core backing store for image data (see ImageDataItem and
+  * Image::SetMemoryMappedChannel()): multi-GB volumes can be
+  * opened without allocating (and copying into) a heap block of the full size.
+  *
+  * The mapping is released on destruction. Since ImageDataItems hold a smart
+  * pointer to the mapping, it stays valid as long as any image data refers to it.
+  *
+  * \ingroup Data
+  */
+  class MITKCORE_EXPORT MemoryMappedFile : public itk::LightObject
+  {
+  public:
+    mitkClassMacroItkParent(MemoryMappedFile, itk::LightObject);
+    itkFactorylessNewMacro(Self);
+
+    /**
+    * \brief Determines how writes to the mapped memory are handled.
+    *
+    * ReadOnly: the memory must not be written (write access crashes the process).
+    * CopyOnWrite: written pages become private copies, the file is never modified.
+    * ReadWrite: written pages are flushed back to the file.
+    */
+    enum AccessMode { ReadOnly, CopyOnWrite, ReadWrite };
+
+    /**
+    * \brief Maps @a length bytes of file @a fileName, starting at byte @a offset.
+    *
+    * If @a length is 0, everything from @a offset to the end of the file is mapped.
+    * An existing mapping is released first.
+    *
+    * \throw mitk::Exception if the file cannot be opened or mapped, or if the
+    *        requested range exceeds the file size.
+    */
+    void Open(const std::string& fileName, size_t offset = 0, size_t length = 0, AccessMode mode = CopyOnWrite);
+
+    /** \brief Releases the mapping. Pointers obtained by GetData() become invalid. */
+    void Close();
+
+    bool IsOpen() const;
+
+    /** \brief Start of the mapped range (i.e. the byte at @a offset in the file). */
+    void* GetData() const;
+
+    /** \brief Size of the mapped range in bytes. */
+    size_t GetLength() const;
+
+    const std::string& GetFileName() const;
+
+    AccessMode GetAccessMode() const;
+
+    /**
+    * \brief Hints the operating system that the given range will be accessed soon,
+    * e.g. the volume of the time step that is about to be displayed.
+    * @a offset is relative to GetData().
+    */
+    void Prefetch(size_t offset, size_t length) const;
+
+    /**
+    * \brief Hints the operating system that the given range is not needed anymore.
+    *
+    * The pages are dropped from the working set and will be paged in from the file
+    * again on next access. In CopyOnWrite mode, modified pages only exist in memory:
+    * on Linux, only the pages that have not been written are dropped, on other POSIX
+    * platforms nothing is evicted. The range must not be written concurrently.
+    * @a offset is relative to GetData().
+    */
+    void Evict(size_t offset, size_t length) const;
+
+    /** \brief Size of the pages in which data is mapped and evicted. */
+    static size_t GetPageSize();
+
+  protected:
+    MemoryMappedFile();
+    virtual ~MemoryMappedFile();
+
+  private:
+    MemoryMappedFile(const MemoryMappedFile&);
+    MemoryMappedFile& operator=(const MemoryMappedFile&);
+
+    /** \brief Computes the page aligned sub-range of [offset, offset+length) in the mapped view. */
+    bool GetAlignedRange(size_t offset, size_t length, char*& begin, size_t& alignedLength) const;
+
+#ifndef _WIN32
+    /** \brief Drops the pages of a CopyOnWrite mapping in the given page aligned range that still match the file. */
+    void EvictCleanPages(char* begin, size_t length) const;
+#endif
+
+    std::string m_FileName;
+    AccessMode m_AccessMode;
+
+    // the view starts at a page boundary, m_Data points m_ViewOffset bytes into it
+    char* m_View;
+    size_t m_ViewLength;
+    size_t m_ViewOffset;
+    char* m_Data;
+    size_t m_Length;
+
+#ifdef _WIN32
+    void* m_FileHandle;
+    void* m_MappingHandle;
+#else
+    int m_FileDescriptor;
+#endif
+  };
+}
+
+#endif
@@ -34,6 +34,25 @@ public:
    */
   static size_t GetProcessMemoryUsage();
 
+  /**
+   * Returns the resident memory of the current process in bytes
+   * (the RES column in top, the working set size on windows).
+   */
+  static size_t GetResidentProcessMemoryUsage();
+
+  /**
+   * Returns the peak resident memory (high water mark) of the current process in bytes.
+   * On windows, this refers to the peak working set size.
+   */
+  static size_t GetPeakProcessMemoryUsage();
+
+  /**
+   * Resets the peak resident memory to the current resident memory, so that the peak
+   * of a single operation can be measured. Returns false if the platform does not
+   * support this (only linux does).
+   */
+  static bool ResetPeakProcessMemoryUsage();
+
   /**
    * Returns the total size of phyiscal memory in bytes
    */
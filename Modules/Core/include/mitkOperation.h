@@ -43,6 +43,12 @@ public:
 
   OperationType GetOperationType();
 
+  //##Documentation
+  //## @brief Returns the memory in bytes that is held by the operation, e.g. the
+  //## data kept for undo/redo. Used to limit the memory of undo models.
+  //## Operations without significant data return 0.
+  virtual size_t GetMemoryUsage() const;
+
   protected:
   OperationType m_OperationType;
 };
@@ -84,6 +84,10 @@ class MITKCORE_EXPORT UndoStackItem
     virtual void ReverseOperations();
     virtual void ReverseAndExecute();
 
+    //##Documentation
+    //## @brief Returns the memory in bytes held by the operations of this item
+    virtual size_t GetMemoryUsage() const;
+
     //##Documentation
     //## @brief Sets the current ObjectEventId to be incremended when ExecuteIncrement is called
     //## For example if a button click generates operations the ObjectEventId has to be incremented to be able to undo the operations.
@@ -173,6 +177,9 @@ public:
   //##reverses and executes both operations (used, when moved from undo to redo stack)
   virtual void ReverseAndExecute() override;
 
+  //## @brief Returns the sum of the memory held by operation and undo operation
+  virtual size_t GetMemoryUsage() const override;
+
   //## @brief returns true if the destination still is present
   //## and false if it already has been deleted
   virtual bool IsValid();
@@ -0,0 +1,435 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkExtractSliceCache.h"
+#include "mitkImageReadAccessor.h"
+
+#include <vtkMatrix4x4.h>
+#include <vtkHomogeneousTransform.h>
+
+bool mitk::ExtractSliceCache::Key::operator==(const Key& other) const
+{
+  return m_Image == other.m_Image
+      && m_ImageMTime == other.m_ImageMTime
+      && m_TimeStep == other.m_TimeStep
+      && m_ResliceParameters == other.m_ResliceParameters;
+}
+
+mitk::ExtractSliceCache::ExtractSliceCache()
+  : m_Size(0),
+    m_MaximumSize(16 * 1024 * 1024),
+    m_NumberOfPrefetchedSlices(2),
+    m_NumberOfHits(0),
+    m_NumberOfMisses(0),
+    m_NumberOfPrefetches(0),
+    m_HitTime(0.0),
+    m_MissTime(0.0),
+    m_PrefetchCondition(itk::ConditionVariable::New()),
+    m_MultiThreader(itk::MultiThreader::New()),
+    m_ThreadId(-1),
+    m_StopThread(false)
+{
+}
+
+mitk::ExtractSliceCache::~ExtractSliceCache()
+{
+  m_Mutex.Lock();
+  m_StopThread = true;
+  m_PrefetchQueue.clear();
+  m_Mutex.Unlock();
+  m_PrefetchCondition->Broadcast();
+
+  if (m_ThreadId >= 0)
+  {
+    m_MultiThreader->TerminateThread(m_ThreadId);
+  }
+}
+
+mitk::ExtractSliceCache::Key mitk::ExtractSliceCache::CreateKey(const Image* image, unsigned int timeStep, vtkImageReslice* reslice)
+{
+  Key key;
+  key.m_Image = image;
+  key.m_ImageMTime = image != nullptr ? image->GetMTime() : 0;
+  key.m_TimeStep = timeStep;
+
+  std::vector<double>& parameters = key.m_ResliceParameters;
+  parameters.reserve(48);
+
+  // axes (direction cosines and origin of the plane)
+  vtkMatrix4x4* axes = reslice->GetResliceAxes();
+  for (int i = 0; i < 4; ++i)
+  {
+    for (int j = 0; j < 4; ++j)
+    {
+      parameters.push_back(axes != nullptr ? axes->GetElement(i, j) : (i == j ? 1.0 : 0.0));
+    }
+  }
+
+  // transform of the image geometry
+  vtkHomogeneousTransform* transform = vtkHomogeneousTransform::SafeDownCast(reslice->GetResliceTransform());
+  if (transform != nullptr)
+  {
+    vtkMatrix4x4* matrix = transform->GetMatrix();
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        parameters.push_back(matrix->GetElement(i, j));
+      }
+    }
+  }
+  else if (reslice->GetResliceTransform() != nullptr)
+  {
+    // non-linear transforms cannot be compared, they are identified by the object itself
+    parameters.push_back(static_cast<double>(reinterpret_cast<size_t>(reslice->GetResliceTransform())));
+    parameters.push_back(static_cast<double>(reslice->GetResliceTransform()->GetMTime()));
+  }
+
+  int extent[6];
+  reslice->GetOutputExtent(extent);
+  parameters.insert(parameters.end(), extent, extent + 6);
+
+  double spacing[3];
+  reslice->GetOutputSpacing(spacing);
+  parameters.insert(parameters.end(), spacing, spacing + 3);
+
+  double origin[3];
+  reslice->GetOutputOrigin(origin);
+  parameters.insert(parameters.end(), origin, origin + 3);
+
+  parameters.push_back(reslice->GetInterpolationMode());
+  parameters.push_back(reslice->GetOutputDimensionality());
+  parameters.push_back(reslice->GetBackgroundLevel());
+
+  return key;
+}
+
+std::list<mitk::ExtractSliceCache::Entry>::iterator mitk::ExtractSliceCache::Find(const Key& key)
+{
+  auto iter = m_Entries.begin();
+  while (iter != m_Entries.end())
+  {
+    if (iter->m_Key.m_Image == key.m_Image && iter->m_Key.m_ImageMTime < key.m_ImageMTime)
+    {
+      // the image was modified since the slice was extracted, slices that are newer
+      // than key are kept
+      m_Size -= iter->m_Size;
+      iter = m_Entries.erase(iter);
+    }
+    else if (iter->m_Key == key)
+    {
+      return iter;
+    }
+    else
+    {
+      ++iter;
+    }
+  }
+  return m_Entries.end();
+}
+
+bool mitk::ExtractSliceCache::Lookup(const Key& key, vtkImageData* slice)
+{
+  m_Mutex.Lock();
+  auto iter = this->Find(key);
+  bool found = iter != m_Entries.end();
+  if (found)
+  {
+    // move to the front, the end of the list is removed first
+    m_Entries.splice(m_Entries.begin(), m_Entries, iter);
+    slice->DeepCopy(m_Entries.front().m_Slice);
+  }
+  m_Mutex.Unlock();
+
+  return found;
+}
+
+void mitk::ExtractSliceCache::Insert(const Key& key, vtkImageData* slice)
+{
+  this->Insert(key, slice, false);
+}
+
+void mitk::ExtractSliceCache::Insert(const Key& key, vtkImageData* slice, bool prefetched)
+{
+  if (slice == nullptr)
+    return;
+
+  Entry entry;
+  entry.m_Key = key;
+  entry.m_Slice = vtkSmartPointer<vtkImageData>::New();
+  entry.m_Slice->DeepCopy(slice);
+  entry.m_Size = entry.m_Slice->GetActualMemorySize() * 1024;
+
+  m_Mutex.Lock();
+  auto iter = this->Find(key);
+  if (prefetched)
+  {
+    // a prefetched slice must not replace slices that were requested, it is
+    // only stored if it is not outdated and fits into the free space
+    bool outdated = false;
+    for (auto other = m_Entries.begin(); other != m_Entries.end() && !outdated; ++other)
+    {
+      outdated = other->m_Key.m_Image == key.m_Image && other->m_Key.m_ImageMTime > key.m_ImageMTime;
+    }
+    if (iter == m_Entries.end() && !outdated && m_Size + entry.m_Size <= m_MaximumSize)
+    {
+      // least recently used, it is moved to the front once it is requested
+      m_Entries.push_back(entry);
+      m_Size += entry.m_Size;
+    }
+    m_Mutex.Unlock();
+    return;
+  }
+
+  if (iter != m_Entries.end())
+  {
+    m_Size -= iter->m_Size;
+    m_Entries.erase(iter);
+  }
+  if (entry.m_Size <= m_MaximumSize)
+  {
+    this->Shrink(m_MaximumSize - entry.m_Size);
+    m_Entries.push_front(entry);
+    m_Size += entry.m_Size;
+  }
+  m_Mutex.Unlock();
+}
+
+bool mitk::ExtractSliceCache::Contains(const Key& key)
+{
+  m_Mutex.Lock();
+  bool found = this->Find(key) != m_Entries.end();
+  for (auto iter = m_PrefetchQueue.begin(); !found && iter != m_PrefetchQueue.end(); ++iter)
+  {
+    found = iter->m_Key == key;
+  }
+  m_Mutex.Unlock();
+
+  return found;
+}
+
+void mitk::ExtractSliceCache::Shrink(unsigned long size)
+{
+  while (m_Size > size && !m_Entries.empty())
+  {
+    m_Size -= m_Entries.back().m_Size;
+    m_Entries.pop_back();
+  }
+}
+
+void mitk::ExtractSliceCache::Prefetch(const Image* image, const std::vector<Key>& keys, const std::vector<vtkSmartPointer<vtkImageReslice> >& reslices)
+{
+  std::deque<PrefetchRequest> discardedRequests;
+
+  m_Mutex.Lock();
+  // slices requested before are not of interest anymore, e.g. the scroll direction changed
+  discardedRequests.swap(m_PrefetchQueue);
+  for (size_t i = 0; i < keys.size() && i < reslices.size(); ++i)
+  {
+    PrefetchRequest request;
+    request.m_Key = keys[i];
+    request.m_Reslice = reslices[i];
+    request.m_Image = image;
+    m_PrefetchQueue.push_back(request);
+  }
+
+  if (m_ThreadId < 0 && !m_PrefetchQueue.empty())
+  {
+    m_ThreadId = m_MultiThreader->SpawnThread(this->PrefetchThread, this);
+  }
+  m_Mutex.Unlock();
+
+  m_PrefetchCondition->Signal();
+}
+
+ITK_THREAD_RETURN_TYPE mitk::ExtractSliceCache::PrefetchThread(void* pInfoStruct)
+{
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+  ExtractSliceCache* thisObject = static_cast<ExtractSliceCache*>(pInfo->UserData);
+
+  thisObject->m_Mutex.Lock();
+  while (!thisObject->m_StopThread)
+  {
+    if (thisObject->m_PrefetchQueue.empty())
+    {
+      thisObject->m_PrefetchCondition->Wait(&thisObject->m_Mutex);
+      continue;
+    }
+
+    PrefetchRequest request = thisObject->m_PrefetchQueue.front();
+    thisObject->m_PrefetchQueue.pop_front();
+    bool cached = thisObject->Find(request.m_Key) != thisObject->m_Entries.end();
+    thisObject->m_Mutex.Unlock();
+
+    bool extracted = false;
+    if (!cached)
+    {
+      try
+      {
+        // the voxels must not be written while the slice is extracted, a prefetch is
+        // not worth waiting for a writer
+        ImageReadAccessor accessor(request.m_Image,
+          request.m_Image->GetVolumeData(request.m_Key.m_TimeStep),
+          ImageAccessorBase::ExceptionIfLocked);
+
+        // the image may have been modified since the request was made
+        if (request.m_Image->GetMTime() == request.m_Key.m_ImageMTime)
+        {
+          request.m_Reslice->Update();
+          thisObject->Insert(request.m_Key, request.m_Reslice->GetOutput(), true);
+          extracted = true;
+        }
+      }
+      catch (const mitk::MemoryIsLockedException&)
+      {
+        // the image is being written, the slice would be outdated anyway
+      }
+    }
+
+    // the image is not kept alive beyond its slices
+    request.m_Reslice = nullptr;
+    request.m_Image = nullptr;
+
+    thisObject->m_Mutex.Lock();
+    if (extracted)
+    {
+      ++thisObject->m_NumberOfPrefetches;
+    }
+  }
+  thisObject->m_Mutex.Unlock();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::ExtractSliceCache::Invalidate(const Image* image)
+{
+  m_Mutex.Lock();
+  auto iter = m_Entries.begin();
+  while (iter != m_Entries.end())
+  {
+    if (iter->m_Key.m_Image == image)
+    {
+      m_Size -= iter->m_Size;
+      iter = m_Entries.erase(iter);
+    }
+    else
+    {
+      ++iter;
+    }
+  }
+  m_Mutex.Unlock();
+}
+
+void mitk::ExtractSliceCache::Clear()
+{
+  m_Mutex.Lock();
+  m_Entries.clear();
+  m_Size = 0;
+  m_Mutex.Unlock();
+}
+
+void mitk::ExtractSliceCache::SetMaximumSize(unsigned long maximumSize)
+{
+  m_Mutex.Lock();
+  m_MaximumSize = maximumSize;
+  this->Shrink(m_MaximumSize);
+  m_Mutex.Unlock();
+  this->Modified();
+}
+
+unsigned long mitk::ExtractSliceCache::GetSize()
+{
+  m_Mutex.Lock();
+  unsigned long size = m_Size;
+  m_Mutex.Unlock();
+  return size;
+}
+
+void mitk::ExtractSliceCache::RecordAccess(bool hit, double seconds)
+{
+  m_Mutex.Lock();
+  if (hit)
+  {
+    ++m_NumberOfHits;
+    m_HitTime += seconds;
+  }
+  else
+  {
+    ++m_NumberOfMisses;
+    m_MissTime += seconds;
+  }
+  m_Mutex.Unlock();
+}
+
+unsigned long mitk::ExtractSliceCache::GetNumberOfHits()
+{
+  m_Mutex.Lock();
+  unsigned long hits = m_NumberOfHits;
+  m_Mutex.Unlock();
+  return hits;
+}
+
+unsigned long mitk::ExtractSliceCache::GetNumberOfMisses()
+{
+  m_Mutex.Lock();
+  unsigned long misses = m_NumberOfMisses;
+  m_Mutex.Unlock();
+  return misses;
+}
+
+unsigned long mitk::ExtractSliceCache::GetNumberOfPrefetches()
+{
+  m_Mutex.Lock();
+  unsigned long prefetches = m_NumberOfPrefetches;
+  m_Mutex.Unlock();
+  return prefetches;
+}
+
+double mitk::ExtractSliceCache::GetHitRate()
+{
+  m_Mutex.Lock();
+  unsigned long requests = m_NumberOfHits + m_NumberOfMisses;
+  double hitRate = requests > 0 ? static_cast<double>(m_NumberOfHits) / requests : 0.0;
+  m_Mutex.Unlock();
+  return hitRate;
+}
+
+double mitk::ExtractSliceCache::GetMeanHitLatency()
+{
+  m_Mutex.Lock();
+  double latency = m_NumberOfHits > 0 ? m_HitTime / m_NumberOfHits : 0.0;
+  m_Mutex.Unlock();
+  return latency;
+}
+
+double mitk::ExtractSliceCache::GetMeanMissLatency()
+{
+  m_Mutex.Lock();
+  double latency = m_NumberOfMisses > 0 ? m_MissTime / m_NumberOfMisses : 0.0;
+  m_Mutex.Unlock();
+  return latency;
+}
+
+void mitk::ExtractSliceCache::ResetStatistics()
+{
+  m_Mutex.Lock();
+  m_NumberOfHits = 0;
+  m_NumberOfMisses = 0;
+  m_NumberOfPrefetches = 0;
+  m_HitTime = 0.0;
+  m_MissTime = 0.0;
+  m_Mutex.Unlock();
+}
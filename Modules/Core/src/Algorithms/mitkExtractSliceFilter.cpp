@@ -21,6 +21,49 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkAbstractTransformGeometry.h>
 #include <vtkGeneralTransform.h>
 #include <mitkPlaneClipping.h>
+#include <vtkTransform.h>
+#include <vtkHomogeneousTransform.h>
+#include <itkTimeProbe.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+  /** Copies height rows of width pixels, neighbouring pixels of the slice are columnStride pixels apart in the volume. */
+  template <typename TPixel>
+  void CopyAxisAlignedSlice(const TPixel* source, TPixel* target, int width, int height, vtkIdType columnStride, vtkIdType rowStride)
+  {
+    for (int y = 0; y < height; ++y, source += rowStride, target += width)
+    {
+      if (columnStride == 1)
+      {
+        std::memcpy(target, source, width * sizeof(TPixel));
+      }
+      else
+      {
+        const TPixel* column = source;
+        for (int x = 0; x < width; ++x, column += columnStride)
+        {
+          target[x] = *column;
+        }
+      }
+    }
+  }
+
+  /** Same as above for pixels of arbitrary size, e.g. RGB. */
+  void CopyAxisAlignedSlice(const char* source, char* target, size_t pixelSize, int width, int height, vtkIdType columnStride, vtkIdType rowStride)
+  {
+    for (int y = 0; y < height; ++y)
+    {
+      const char* column = source + y * rowStride * static_cast<vtkIdType>(pixelSize);
+      for (int x = 0; x < width; ++x, column += columnStride * static_cast<vtkIdType>(pixelSize), target += pixelSize)
+      {
+        std::memcpy(target, column, pixelSize);
+      }
+    }
+  }
+}
 
 mitk::ExtractSliceFilter::ExtractSliceFilter(vtkImageReslice* reslicer ){
   if(reslicer == nullptr){
@@ -43,6 +86,11 @@ mitk::ExtractSliceFilter::ExtractSliceFilter(vtkImageReslice* reslicer ){
   m_ZMax = 0;
   m_VtkOutputRequested = false;
   m_BackgroundLevel = -32768.0;
+  m_SliceCache = nullptr;
+  m_AxisAlignedExtraction = true;
+  m_SliceCopied = false;
+  m_LastInput = nullptr;
+  m_LastTimeStep = 0;
 }
 
 mitk::ExtractSliceFilter::~ExtractSliceFilter(){
@@ -79,6 +127,7 @@ mitk::ScalarType* mitk::ExtractSliceFilter::GetOutputSpacing(){
 
 void mitk::ExtractSliceFilter::GenerateData(){
   mitk::Image *input = const_cast< mitk::Image * >( this->GetInput() );
+  m_SliceCopied = false;
 
   if (!input)
   {
@@ -303,28 +352,7 @@ void mitk::ExtractSliceFilter::GenerateData(){
 
   /*========== BEGIN setup extent of the slice ==========*/
   int xMin, xMax, yMin, yMax;
-
-  xMin = yMin = 0;
-  xMax = static_cast< int >( extent[0]);
-  yMax = static_cast< int >( extent[1]);
-
-  double sliceBounds[6];
-  if (m_WorldGeometry->GetReferenceGeometry())
-  {
-    for (auto & sliceBound : sliceBounds)
-    {
-      sliceBound = 0.0;
-    }
-
-    if (this->GetClippedPlaneBounds( m_WorldGeometry->GetReferenceGeometry(), planeGeometry, sliceBounds ))
-    {
-      // Calculate output extent (integer values)
-      xMin = static_cast< int >( sliceBounds[0] / m_OutPutSpacing[0] + 0.5 );
-      xMax = static_cast< int >( sliceBounds[1] / m_OutPutSpacing[0] + 0.5 );
-      yMin = static_cast< int >( sliceBounds[2] / m_OutPutSpacing[1] + 0.5 );
-      yMax = static_cast< int >( sliceBounds[3] / m_OutPutSpacing[1] + 0.5 );
-    } // ELSE we use the default values
-  }
+  this->CalculateSliceExtent(planeGeometry, extent, xMin, xMax, yMin, yMax);
 
   // Set the output extents! First included pixel index and last included pixel index
   // xMax and yMax are one after the last pixel. so they have to be decremented by 1.
@@ -337,13 +365,63 @@ void mitk::ExtractSliceFilter::GenerateData(){
 
   m_Reslicer->SetOutputSpacing( m_OutPutSpacing[0], m_OutPutSpacing[1], m_ZSpacing );
 
-  //TODO check the following lines, they are responsible wether vtk error outputs appear or not
-  m_Reslicer->UpdateWholeExtent(); //this produces a bad allocation error for 2D images
-  //m_Reslicer->GetOutput()->UpdateInformation();
-  //m_Reslicer->GetOutput()->SetUpdateExtentToWholeExtent();
+  // curved planes and derived reslicers (e.g. for overwriting) are never cached
+  bool useCache = m_SliceCache.IsNotNull() && abstractGeometry == nullptr
+    && std::strcmp(m_Reslicer->GetClassName(), "vtkImageReslice") == 0;
+
+  itk::TimeProbe timeProbe;
+  timeProbe.Start();
+
+  ExtractSliceCache::Key cacheKey;
+  bool cacheHit = false;
+  if (useCache)
+  {
+    cacheKey = ExtractSliceCache::CreateKey(input, m_TimeStep, m_Reslicer);
+    cacheHit = m_SliceCache->Lookup(cacheKey, m_Reslicer->GetOutput());
+  }
+
+  if (!cacheHit)
+  {
+    if (useCache)
+    {
+      // the output may contain a cached slice, so vtkImageReslice has to execute in any case
+      m_Reslicer->Modified();
+    }
+
+    // planes on the voxel grid do not need to be resampled (derived reslicers may do more than resampling)
+    bool copied = m_AxisAlignedExtraction && abstractGeometry == nullptr
+      && std::strcmp(m_Reslicer->GetClassName(), "vtkImageReslice") == 0
+      && this->ExtractAxisAlignedSlice(input, origin, right, bottom, xMin, xMax, yMin, yMax);
+
+    m_SliceCopied = copied;
+    if (copied)
+    {
+      // the output was not produced by vtkImageReslice, make sure it executes on the next update
+      m_Reslicer->Modified();
+    }
+    else
+    {
+      //TODO check the following lines, they are responsible wether vtk error outputs appear or not
+      m_Reslicer->UpdateWholeExtent(); //this produces a bad allocation error for 2D images
+      //m_Reslicer->GetOutput()->UpdateInformation();
+      //m_Reslicer->GetOutput()->SetUpdateExtentToWholeExtent();
+
+      //start the pipeline
+      m_Reslicer->Update();
+    }
+  }
+
+  if (useCache)
+  {
+    if (!cacheHit)
+    {
+      m_SliceCache->Insert(cacheKey, m_Reslicer->GetOutput());
+    }
+    timeProbe.Stop();
+    m_SliceCache->RecordAccess(cacheHit, timeProbe.GetTotal());
 
-  //start the pipeline
-  m_Reslicer->Update();
+    this->PrefetchSlices(input, planeGeometry, extent);
+  }
 
   /*================ #END setup vtkImageRslice properties================*/
 
@@ -435,6 +513,258 @@ void mitk::ExtractSliceFilter::GenerateData(){
   }
 }
 
+bool mitk::ExtractSliceFilter::CalculateSliceExtent(const PlaneGeometry* planeGeometry, const Vector2D& extent,
+                                                    int& xMin, int& xMax, int& yMin, int& yMax)
+{
+  xMin = yMin = 0;
+  xMax = static_cast< int >( extent[0]);
+  yMax = static_cast< int >( extent[1]);
+
+  double sliceBounds[6];
+  if (m_WorldGeometry->GetReferenceGeometry())
+  {
+    for (auto & sliceBound : sliceBounds)
+    {
+      sliceBound = 0.0;
+    }
+
+    if (this->GetClippedPlaneBounds( m_WorldGeometry->GetReferenceGeometry(), planeGeometry, sliceBounds ))
+    {
+      // Calculate output extent (integer values)
+      xMin = static_cast< int >( sliceBounds[0] / m_OutPutSpacing[0] + 0.5 );
+      xMax = static_cast< int >( sliceBounds[1] / m_OutPutSpacing[0] + 0.5 );
+      yMin = static_cast< int >( sliceBounds[2] / m_OutPutSpacing[1] + 0.5 );
+      yMax = static_cast< int >( sliceBounds[3] / m_OutPutSpacing[1] + 0.5 );
+    }
+    else
+    {
+      // we use the default values
+      return false;
+    }
+  }
+  return true;
+}
+
+bool mitk::ExtractSliceFilter::ExtractAxisAlignedSlice(Image* input, const Point3D& origin, const Vector3D& right, const Vector3D& bottom,
+                                                       int xMin, int xMax, int yMin, int yMax)
+{
+  // the unit spacing input and the reslice transform map world coordinates to voxel indices,
+  // for 1D and 2D images the vtkImageData has an additional origin
+  if (m_ResliceTransform.IsNull() || input->GetDimension() < 3 || m_ZMin != 0 || m_ZMax != 0)
+    return false;
+
+  vtkImageData* volume = input->GetVtkImageData(m_TimeStep);
+  if (volume == nullptr || volume->GetScalarPointer() == nullptr)
+    return false;
+
+  const int width = std::max(0, xMax-1) - xMin + 1;
+  const int height = std::max(0, yMax-1) - yMin + 1;
+  if (width <= 0 || height <= 0)
+    return false;
+
+  // index of the first pixel and the index steps to the next pixel in a row and in a column
+  Point3D firstPoint = origin + right * (xMin * m_OutPutSpacing[0]) + bottom * (yMin * m_OutPutSpacing[1]);
+  Point3D firstIndex;
+  Vector3D columnStep, rowStep;
+  m_ResliceTransform->WorldToIndex(firstPoint, firstIndex);
+  m_ResliceTransform->WorldToIndex(right * m_OutPutSpacing[0], columnStep);
+  m_ResliceTransform->WorldToIndex(bottom * m_OutPutSpacing[1], rowStep);
+
+  // all positions have to hit voxel centers, otherwise the interpolation changes the values
+  const double tolerance = 1e-4;
+  int start[3], column[3], row[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    start[i] = static_cast<int>(std::floor(firstIndex[i] + 0.5));
+    column[i] = static_cast<int>(std::floor(columnStep[i] + 0.5));
+    row[i] = static_cast<int>(std::floor(rowStep[i] + 0.5));
+    if (std::abs(firstIndex[i] - start[i]) > tolerance
+        || std::abs(columnStep[i] - column[i]) > tolerance
+        || std::abs(rowStep[i] - row[i]) > tolerance)
+      return false;
+  }
+
+  // a step has to move by exactly one voxel along one axis, rows and columns along different axes
+  int columnSteps = 0, rowSteps = 0, sharedAxes = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    columnSteps += std::abs(column[i]);
+    rowSteps += std::abs(row[i]);
+    sharedAxes += std::abs(column[i] * row[i]);
+  }
+  if (columnSteps != 1 || rowSteps != 1 || sharedAxes != 0)
+    return false;
+
+  // the slice must be completely inside of the volume, the reslicer fills the rest with the background level
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+  for (int i = 0; i < 3; ++i)
+  {
+    const int last = start[i] + column[i] * (width - 1) + row[i] * (height - 1);
+    if (start[i] < 0 || start[i] >= dimensions[i] || last < 0 || last >= dimensions[i])
+      return false;
+  }
+
+  const vtkIdType increments[3] = { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  vtkIdType startOffset = 0, columnStride = 0, rowStride = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    startOffset += start[i] * increments[i];
+    columnStride += column[i] * increments[i];
+    rowStride += row[i] * increments[i];
+  }
+
+  // set up the output as vtkImageReslice would do
+  vtkImageData* output = m_Reslicer->GetOutput();
+  output->SetExtent(xMin, xMin + width - 1, yMin, yMin + height - 1, 0, 0);
+  output->SetSpacing(m_OutPutSpacing[0], m_OutPutSpacing[1], m_ZSpacing);
+  output->SetOrigin(0.0, 0.0, 0.0);
+  output->AllocateScalars(volume->GetScalarType(), volume->GetNumberOfScalarComponents());
+
+  const size_t pixelSize = volume->GetScalarSize() * volume->GetNumberOfScalarComponents();
+  const char* source = static_cast<const char*>(volume->GetScalarPointer()) + startOffset * static_cast<vtkIdType>(pixelSize);
+  char* target = static_cast<char*>(output->GetScalarPointer());
+
+  switch (pixelSize)
+  {
+  case 1:
+    CopyAxisAlignedSlice(reinterpret_cast<const vtkTypeUInt8*>(source), reinterpret_cast<vtkTypeUInt8*>(target), width, height, columnStride, rowStride);
+    break;
+  case 2:
+    CopyAxisAlignedSlice(reinterpret_cast<const vtkTypeUInt16*>(source), reinterpret_cast<vtkTypeUInt16*>(target), width, height, columnStride, rowStride);
+    break;
+  case 4:
+    CopyAxisAlignedSlice(reinterpret_cast<const vtkTypeUInt32*>(source), reinterpret_cast<vtkTypeUInt32*>(target), width, height, columnStride, rowStride);
+    break;
+  case 8:
+    CopyAxisAlignedSlice(reinterpret_cast<const vtkTypeUInt64*>(source), reinterpret_cast<vtkTypeUInt64*>(target), width, height, columnStride, rowStride);
+    break;
+  default:
+    CopyAxisAlignedSlice(source, target, pixelSize, width, height, columnStride, rowStride);
+  }
+
+  output->Modified();
+  return true;
+}
+
+void mitk::ExtractSliceFilter::PrefetchSlices(const Image* input, const PlaneGeometry* planeGeometry, const Vector2D& extent)
+{
+  const Point3D origin = planeGeometry->GetOrigin();
+  Vector3D normal = planeGeometry->GetNormal();
+  normal.Normalize();
+
+  // determine whether the plane was moved along its normal (scrolling) or the time step changed (cine)
+  Vector3D step;
+  step.Fill(0.0);
+  int timeStepIncrement = 0;
+  if (input == m_LastInput && normal == m_LastNormal)
+  {
+    Vector3D movement = origin - m_LastOrigin;
+    const ScalarType distance = movement * normal;
+    const bool alongNormal = (movement - normal * distance).GetNorm() < mitk::eps;
+
+    if (m_TimeStep == m_LastTimeStep && alongNormal && std::abs(distance) > mitk::eps)
+    {
+      step = normal * distance;
+    }
+    else if (m_TimeStep != m_LastTimeStep && movement.GetNorm() < mitk::eps)
+    {
+      timeStepIncrement = static_cast<int>(m_TimeStep) - static_cast<int>(m_LastTimeStep);
+    }
+  }
+
+  m_LastInput = input;
+  m_LastOrigin = origin;
+  m_LastNormal = normal;
+  m_LastTimeStep = m_TimeStep;
+
+  std::vector<ExtractSliceCache::Key> keys;
+  std::vector<vtkSmartPointer<vtkImageReslice> > reslices;
+
+  const TimeGeometry* timeGeometry = input->GetTimeGeometry();
+  const bool isImageTransform = m_ResliceTransform.GetPointer() == timeGeometry->GetGeometryForTimeStep(m_TimeStep).GetPointer();
+
+  const bool scrolling = step.GetNorm() > 0.0;
+  for (unsigned int i = 1; i <= m_SliceCache->GetNumberOfPrefetchedSlices() && (scrolling || timeStepIncrement != 0); ++i)
+  {
+    unsigned int timeStep = m_TimeStep;
+    int outputExtent[6];
+    m_Reslicer->GetOutputExtent(outputExtent);
+
+    vtkSmartPointer<vtkMatrix4x4> axes = vtkSmartPointer<vtkMatrix4x4>::New();
+    axes->DeepCopy(m_Reslicer->GetResliceAxes());
+
+    if (scrolling)
+    {
+      PlaneGeometry::Pointer nextPlane = planeGeometry->Clone();
+      nextPlane->SetOrigin(origin + step * static_cast<ScalarType>(i));
+
+      int xMin, xMax, yMin, yMax;
+      if (!this->CalculateSliceExtent(nextPlane, extent, xMin, xMax, yMin, yMax))
+        break; // outside of the image
+
+      outputExtent[0] = xMin;
+      outputExtent[1] = std::max(0, xMax-1);
+      outputExtent[2] = yMin;
+      outputExtent[3] = std::max(0, yMax-1);
+
+      for (int j = 0; j < 3; ++j)
+      {
+        axes->SetElement(j, 3, axes->GetElement(j, 3) + step[j] * i);
+      }
+    }
+    else
+    {
+      int nextTimeStep = static_cast<int>(m_TimeStep) + timeStepIncrement * static_cast<int>(i);
+      if (nextTimeStep < 0 || !timeGeometry->IsValidTimeStep(nextTimeStep) || !input->IsVolumeSet(nextTimeStep))
+        break;
+      timeStep = static_cast<unsigned int>(nextTimeStep);
+    }
+
+    // the slice is extracted in another thread, so the voxel data is referenced by an own vtkImageData
+    vtkSmartPointer<vtkImageData> volume = vtkSmartPointer<vtkImageData>::New();
+    volume->ShallowCopy(const_cast<Image*>(input)->GetVtkImageData(timeStep));
+
+    vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
+    if (m_ResliceTransform.IsNotNull())
+    {
+      // same as the unit spacing filter in GenerateData()
+      volume->SetSpacing(1.0, 1.0, 1.0);
+
+      const BaseGeometry* resliceGeometry = isImageTransform
+        ? timeGeometry->GetGeometryForTimeStep(timeStep).GetPointer() : m_ResliceTransform.GetPointer();
+      vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+      transform->SetMatrix(resliceGeometry->GetVtkTransform()->GetLinearInverse()->GetMatrix());
+      reslice->SetResliceTransform(transform);
+    }
+    else if (vtkHomogeneousTransform* homogeneous = vtkHomogeneousTransform::SafeDownCast(m_Reslicer->GetResliceTransform()))
+    {
+      vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+      transform->SetMatrix(homogeneous->GetMatrix());
+      reslice->SetResliceTransform(transform);
+    }
+
+    reslice->SetInputData(volume);
+    reslice->SetResliceAxes(axes);
+    reslice->SetOutputDimensionality(m_Reslicer->GetOutputDimensionality());
+    reslice->SetInterpolationMode(m_Reslicer->GetInterpolationMode());
+    reslice->SetBackgroundLevel(m_Reslicer->GetBackgroundLevel());
+    reslice->SetOutputExtent(outputExtent);
+    reslice->SetOutputOrigin(m_Reslicer->GetOutputOrigin());
+    reslice->SetOutputSpacing(m_Reslicer->GetOutputSpacing());
+
+    ExtractSliceCache::Key key = ExtractSliceCache::CreateKey(input, timeStep, reslice);
+    if (!m_SliceCache->Contains(key))
+    {
+      keys.push_back(key);
+      reslices.push_back(reslice);
+    }
+  }
+
+  // called in any case to discard slices that were requested for another scroll direction
+  m_SliceCache->Prefetch(input, keys, reslices);
+}
+
 bool mitk::ExtractSliceFilter::GetClippedPlaneBounds(double bounds[6]){
   if(!m_WorldGeometry || !this->GetInput())
     return false;
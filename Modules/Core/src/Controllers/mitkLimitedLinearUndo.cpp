@@ -19,8 +19,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkRenderingManager.h>
 
 mitk::LimitedLinearUndo::LimitedLinearUndo()
+  : m_MemoryLimit(0)
 {
-  // nothing to do
 }
 
 mitk::LimitedLinearUndo::~LimitedLinearUndo()
@@ -56,9 +56,64 @@ bool mitk::LimitedLinearUndo::SetOperationEvent(UndoStackItem* stackItem)
 
   InvokeEvent( UndoNotEmptyEvent() );
 
+  this->EnforceMemoryLimit();
+
   return true;
 }
 
+void mitk::LimitedLinearUndo::SetMemoryLimit(size_t memoryLimit)
+{
+  m_MemoryLimit = memoryLimit;
+  this->EnforceMemoryLimit();
+}
+
+size_t mitk::LimitedLinearUndo::GetMemoryLimit() const
+{
+  return m_MemoryLimit;
+}
+
+size_t mitk::LimitedLinearUndo::GetMemoryUsage() const
+{
+  size_t memoryUsage = 0;
+  for (auto iter = m_UndoList.begin(); iter != m_UndoList.end(); ++iter)
+  {
+    memoryUsage += (*iter)->GetMemoryUsage();
+  }
+  for (auto iter = m_RedoList.begin(); iter != m_RedoList.end(); ++iter)
+  {
+    memoryUsage += (*iter)->GetMemoryUsage();
+  }
+  return memoryUsage;
+}
+
+void mitk::LimitedLinearUndo::EnforceMemoryLimit()
+{
+  if (m_MemoryLimit == 0) return;
+
+  size_t memoryUsage = this->GetMemoryUsage();
+  bool removedItems = false;
+
+  // remove whole object events from the bottom of the stack, but keep the newest one
+  while (memoryUsage > m_MemoryLimit && !m_UndoList.empty()
+         && m_UndoList.front()->GetObjectEventId() != m_UndoList.back()->GetObjectEventId())
+  {
+    int oldestObjectEventId = m_UndoList.front()->GetObjectEventId();
+    while (!m_UndoList.empty() && m_UndoList.front()->GetObjectEventId() == oldestObjectEventId)
+    {
+      UndoStackItem* item = m_UndoList.front();
+      memoryUsage -= item->GetMemoryUsage();
+      m_UndoList.erase(m_UndoList.begin());
+      delete item;
+    }
+    removedItems = true;
+  }
+
+  if (removedItems)
+  {
+    InvokeEvent( UndoFullEvent() );
+  }
+}
+
 bool mitk::LimitedLinearUndo::Undo(bool fine)
 {
   if (fine)
@@ -98,6 +98,11 @@ void mitk::UndoStackItem::ReverseAndExecute()
   ReverseOperations();
 }
 
+size_t mitk::UndoStackItem::GetMemoryUsage() const
+{
+  return 0;
+}
+
 // ******************** mitk::OperationEvent ********************
 
 mitk::Operation* mitk::OperationEvent::GetOperation()
@@ -173,3 +178,13 @@ bool mitk::OperationEvent::IsValid()
 {
   return !m_Invalid;
 }
+
+size_t mitk::OperationEvent::GetMemoryUsage() const
+{
+  size_t memoryUsage = 0;
+  if (m_Operation != nullptr)
+    memoryUsage += m_Operation->GetMemoryUsage();
+  if (m_UndoOperation != nullptr)
+    memoryUsage += m_UndoOperation->GetMemoryUsage();
+  return memoryUsage;
+}
@@ -41,6 +41,8 @@ bool mitk::VerboseLimitedLinearUndo::SetOperationEvent(UndoStackItem* undoStackI
 
   InvokeEvent( UndoNotEmptyEvent() );
 
+  this->EnforceMemoryLimit();
+
   return true;
 }
 
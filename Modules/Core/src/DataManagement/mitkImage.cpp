@@ -742,6 +742,73 @@ bool mitk::Image::SetImportChannel(void *data, int n, ImportMemoryManagementType
   return true;
 }
 
+bool mitk::Image::SetMemoryMappedChannel(MemoryMappedFile* mappedFile, int n)
+{
+  if(IsValidChannel(n)==false || mappedFile == nullptr || !mappedFile->IsOpen()) return false;
+
+  const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+  if(mappedFile->GetLength() < m_OffsetTable[4]*(ptypeSize))
+  {
+    MITK_ERROR << "Memory mapped file " << mappedFile->GetFileName() << " is too small for the image channel";
+    return false;
+  }
+
+  const bool wasSet = IsChannelSet(n);
+
+  {
+    MutexHolder lock(m_ImageDataArraysLock);
+
+    // volumes and slices of this channel refer to the previous data
+    for(unsigned int t=0; t<m_Dimensions[3]; ++t)
+    {
+      m_Volumes[GetVolumeIndex(t,n)] = nullptr;
+      for(unsigned int s=0; s<m_Dimensions[2]; ++s)
+      {
+        m_Slices[GetSliceIndex(s,t,n)] = nullptr;
+      }
+    }
+
+    ImageDataItemPointer ch = new ImageDataItem(this->m_ImageDescriptor, -1, mappedFile, n);
+    ch->SetComplete(true);
+    m_Channels[n] = ch;
+    if(n == 0)
+    {
+      m_CompleteData = nullptr;
+    }
+    this->m_ImageDescriptor->GetChannelDescriptor(n).SetData( ch->GetData() );
+  }
+
+  if(wasSet)
+  {
+    //we have changed the data: call Modified()!
+    Modified();
+  }
+  return true;
+}
+
+bool mitk::Image::IsMemoryMapped(int n) const
+{
+  if(IsValidChannel(n)==false) return false;
+
+  MutexHolder lock(m_ImageDataArraysLock);
+  ImageDataItemPointer ch=m_Channels[n];
+  return ch.IsNotNull() && ch->IsMemoryMapped();
+}
+
+void mitk::Image::PrefetchVolume(int t, int n) const
+{
+  if(IsMemoryMapped(n)==false || IsValidVolume(t,n)==false) return;
+
+  GetVolumeData(t,n)->Prefetch();
+}
+
+void mitk::Image::EvictVolume(int t, int n) const
+{
+  if(IsMemoryMapped(n)==false || IsValidVolume(t,n)==false) return;
+
+  GetVolumeData(t,n)->Evict();
+}
+
 void mitk::Image::Initialize()
 {
   ImageDataItemPointerArray::iterator it, end;
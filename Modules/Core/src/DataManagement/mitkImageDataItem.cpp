@@ -35,6 +35,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkImageVtkReadAccessor.h>
 #include <mitkImageVtkWriteAccessor.h>
 #include <mitkImage.h>
+#include <mitkException.h>
 
 
 mitk::ImageDataItem::ImageDataItem(const ImageDataItem& aParent, const mitk::ImageDescriptor::Pointer desc, int timestep, unsigned int dimension, void *data, bool manageMemory, size_t offset)
@@ -167,6 +168,41 @@ mitk::ImageDataItem::ImageDataItem(const mitk::PixelType& type, int timestep,
   m_ReferenceCountLock.Unlock();
 }
 
+mitk::ImageDataItem::ImageDataItem(const mitk::ImageDescriptor::Pointer desc, int timestep,
+                                   MemoryMappedFile* mappedFile, int channel)
+  : m_Data(static_cast<unsigned char*>(mappedFile->GetData()))
+  , m_PixelType(new mitk::PixelType(desc->GetChannelDescriptor(channel).GetPixelType()))
+  , m_ManageMemory(false)
+  , m_VtkImageData(nullptr)
+  , m_VtkImageReadAccessor(nullptr)
+  , m_VtkImageWriteAccessor(nullptr)
+  , m_Offset(0)
+  , m_IsComplete(false)
+  , m_Size(0)
+  , m_Parent(nullptr)
+  , m_Dimension(desc->GetNumberOfDimensions())
+  , m_Timestep(timestep)
+  , m_MappedFile(mappedFile)
+{
+  const unsigned int *dimensions = desc->GetDimensions();
+  for( unsigned int i=0; i<m_Dimension; i++)
+  {
+    m_Dimensions[i] = dimensions[i];
+  }
+
+  this->ComputeItemSize(m_Dimensions, m_Dimension );
+
+  if(m_Data == nullptr || mappedFile->GetLength() < m_Size)
+  {
+    mitkThrow() << "Memory mapped file " << mappedFile->GetFileName() << " is smaller than the image data ("
+                << mappedFile->GetLength() << " < " << m_Size << " bytes)";
+  }
+
+  m_ReferenceCountLock.Lock();
+  m_ReferenceCount = 0;
+  m_ReferenceCountLock.Unlock();
+}
+
 mitk::ImageDataItem::ImageDataItem(const ImageDataItem &other)
   : itk::LightObject()
   , m_Data(other.m_Data)
@@ -181,6 +217,7 @@ mitk::ImageDataItem::ImageDataItem(const ImageDataItem &other)
   , m_Parent(other.m_Parent)
   , m_Dimension(other.m_Dimension)
   , m_Timestep(other.m_Timestep)
+  , m_MappedFile(other.m_MappedFile)
 {
   // copy m_Data ??
     for (int i = 0; i < MAX_IMAGE_DIMENSIONS; ++i)
@@ -341,3 +378,45 @@ mitk::ImageVtkWriteAccessor* mitk::ImageDataItem::GetVtkImageAccessor(ImagePoint
   return m_VtkImageWriteAccessor;
 }
 
+
+const mitk::MemoryMappedFile* mitk::ImageDataItem::GetMappedFile(size_t& offset) const
+{
+  // sub-items only reference the data of their root item, which holds the mapping
+  const ImageDataItem* root = this;
+  while(root->m_Parent.IsNotNull())
+  {
+    root = root->m_Parent.GetPointer();
+  }
+  if(root->m_MappedFile.IsNull())
+  {
+    return nullptr;
+  }
+  offset = static_cast<size_t>(m_Data - root->m_Data);
+  return root->m_MappedFile.GetPointer();
+}
+
+bool mitk::ImageDataItem::IsMemoryMapped() const
+{
+  size_t offset = 0;
+  return this->GetMappedFile(offset) != nullptr;
+}
+
+void mitk::ImageDataItem::Prefetch() const
+{
+  size_t offset = 0;
+  const MemoryMappedFile* mappedFile = this->GetMappedFile(offset);
+  if(mappedFile != nullptr)
+  {
+    mappedFile->Prefetch(offset, m_Size);
+  }
+}
+
+void mitk::ImageDataItem::Evict() const
+{
+  size_t offset = 0;
+  const MemoryMappedFile* mappedFile = this->GetMappedFile(offset);
+  if(mappedFile != nullptr)
+  {
+    mappedFile->Evict(offset, m_Size);
+  }
+}
@@ -0,0 +1,363 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkMemoryMappedFile.h"
+#include "mitkException.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <cerrno>
+  #include <cstring>
+  #include <algorithm>
+  #include <stdint.h>
+  #include <vector>
+#endif
+
+mitk::MemoryMappedFile::MemoryMappedFile()
+  : m_AccessMode(CopyOnWrite)
+  , m_View(nullptr)
+  , m_ViewLength(0)
+  , m_ViewOffset(0)
+  , m_Data(nullptr)
+  , m_Length(0)
+#ifdef _WIN32
+  , m_FileHandle(INVALID_HANDLE_VALUE)
+  , m_MappingHandle(nullptr)
+#else
+  , m_FileDescriptor(-1)
+#endif
+{
+}
+
+mitk::MemoryMappedFile::~MemoryMappedFile()
+{
+  this->Close();
+}
+
+size_t mitk::MemoryMappedFile::GetPageSize()
+{
+#ifdef _WIN32
+  // views have to start at the allocation granularity, not only at page boundaries
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  return systemInfo.dwAllocationGranularity;
+#else
+  return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void mitk::MemoryMappedFile::Open(const std::string& fileName, size_t offset, size_t length, AccessMode mode)
+{
+  this->Close();
+
+  const size_t pageSize = GetPageSize();
+  const size_t viewStart = (offset / pageSize) * pageSize;
+
+#ifdef _WIN32
+  DWORD desiredAccess = GENERIC_READ;
+  DWORD protection = PAGE_READONLY;
+  DWORD viewAccess = FILE_MAP_READ;
+  if (mode == ReadWrite)
+  {
+    desiredAccess |= GENERIC_WRITE;
+    protection = PAGE_READWRITE;
+    viewAccess = FILE_MAP_WRITE;
+  }
+  else if (mode == CopyOnWrite)
+  {
+    protection = PAGE_WRITECOPY;
+    viewAccess = FILE_MAP_COPY;
+  }
+
+  HANDLE file = CreateFileA(fileName.c_str(), desiredAccess, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    mitkThrow() << "Could not open " << fileName << " for memory mapping (error " << GetLastError() << ")";
+  }
+  m_FileHandle = file;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize))
+  {
+    this->Close();
+    mitkThrow() << "Could not determine size of " << fileName;
+  }
+  const size_t size = static_cast<size_t>(fileSize.QuadPart);
+#else
+  int flags = (mode == ReadWrite) ? O_RDWR : O_RDONLY;
+  int fd = ::open(fileName.c_str(), flags);
+  if (fd < 0)
+  {
+    mitkThrow() << "Could not open " << fileName << " for memory mapping: " << std::strerror(errno);
+  }
+  m_FileDescriptor = fd;
+
+  struct stat fileStatus;
+  if (fstat(fd, &fileStatus) != 0)
+  {
+    this->Close();
+    mitkThrow() << "Could not determine size of " << fileName << ": " << std::strerror(errno);
+  }
+  const size_t size = static_cast<size_t>(fileStatus.st_size);
+#endif
+
+  if (length == 0 && offset < size)
+  {
+    length = size - offset;
+  }
+  if (length == 0 || offset + length > size)
+  {
+    this->Close();
+    mitkThrow() << "Cannot map " << length << " bytes at offset " << offset << " of " << fileName << " (" << size << " bytes)";
+  }
+
+  m_ViewOffset = offset - viewStart;
+  m_ViewLength = m_ViewOffset + length;
+
+#ifdef _WIN32
+  m_MappingHandle = CreateFileMappingA(file, nullptr, protection, 0, 0, nullptr);
+  if (m_MappingHandle == nullptr)
+  {
+    this->Close();
+    mitkThrow() << "Could not create file mapping for " << fileName << " (error " << GetLastError() << ")";
+  }
+  const unsigned long long start = viewStart;
+  m_View = static_cast<char*>(MapViewOfFile(m_MappingHandle, viewAccess,
+    static_cast<DWORD>(start >> 32), static_cast<DWORD>(start & 0xFFFFFFFF), m_ViewLength));
+  if (m_View == nullptr)
+  {
+    this->Close();
+    mitkThrow() << "Could not map view of " << fileName << " (error " << GetLastError() << ")";
+  }
+#else
+  int protection = PROT_READ;
+  if (mode != ReadOnly)
+  {
+    protection |= PROT_WRITE;
+  }
+  void* view = mmap(nullptr, m_ViewLength, protection, mode == ReadWrite ? MAP_SHARED : MAP_PRIVATE, fd, static_cast<off_t>(viewStart));
+  if (view == MAP_FAILED)
+  {
+    this->Close();
+    mitkThrow() << "Could not map " << fileName << ": " << std::strerror(errno);
+  }
+  m_View = static_cast<char*>(view);
+#endif
+
+  m_FileName = fileName;
+  m_AccessMode = mode;
+  m_Data = m_View + m_ViewOffset;
+  m_Length = length;
+}
+
+void mitk::MemoryMappedFile::Close()
+{
+#ifdef _WIN32
+  if (m_View != nullptr)
+  {
+    UnmapViewOfFile(m_View);
+  }
+  if (m_MappingHandle != nullptr)
+  {
+    CloseHandle(m_MappingHandle);
+    m_MappingHandle = nullptr;
+  }
+  if (m_FileHandle != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(m_FileHandle);
+    m_FileHandle = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (m_View != nullptr)
+  {
+    munmap(m_View, m_ViewLength);
+  }
+  if (m_FileDescriptor >= 0)
+  {
+    ::close(m_FileDescriptor);
+    m_FileDescriptor = -1;
+  }
+#endif
+
+  m_View = nullptr;
+  m_ViewLength = 0;
+  m_ViewOffset = 0;
+  m_Data = nullptr;
+  m_Length = 0;
+  m_FileName.clear();
+}
+
+bool mitk::MemoryMappedFile::IsOpen() const
+{
+  return m_Data != nullptr;
+}
+
+void* mitk::MemoryMappedFile::GetData() const
+{
+  return m_Data;
+}
+
+size_t mitk::MemoryMappedFile::GetLength() const
+{
+  return m_Length;
+}
+
+const std::string& mitk::MemoryMappedFile::GetFileName() const
+{
+  return m_FileName;
+}
+
+mitk::MemoryMappedFile::AccessMode mitk::MemoryMappedFile::GetAccessMode() const
+{
+  return m_AccessMode;
+}
+
+bool mitk::MemoryMappedFile::GetAlignedRange(size_t offset, size_t length, char*& begin, size_t& alignedLength) const
+{
+  if (m_View == nullptr || offset >= m_Length || length == 0)
+    return false;
+
+  if (offset + length > m_Length)
+    length = m_Length - offset;
+
+  // advice calls need page aligned addresses; the view itself starts at a page boundary
+  const size_t pageSize = GetPageSize();
+  const size_t viewBegin = ((m_ViewOffset + offset) / pageSize) * pageSize;
+  const size_t viewEnd = m_ViewOffset + offset + length;
+
+  begin = m_View + viewBegin;
+  alignedLength = viewEnd - viewBegin;
+  return true;
+}
+
+void mitk::MemoryMappedFile::Prefetch(size_t offset, size_t length) const
+{
+  char* begin = nullptr;
+  size_t alignedLength = 0;
+  if (!this->GetAlignedRange(offset, length, begin, alignedLength))
+    return;
+
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = begin;
+  range.NumberOfBytes = alignedLength;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+  madvise(begin, alignedLength, MADV_WILLNEED);
+#endif
+}
+
+void mitk::MemoryMappedFile::Evict(size_t offset, size_t length) const
+{
+  char* begin = nullptr;
+  size_t alignedLength = 0;
+  if (!this->GetAlignedRange(offset, length, begin, alignedLength))
+    return;
+
+#ifdef _WIN32
+  // unlocking pages that are not locked removes them from the working set
+  // without discarding their content, this is safe for all access modes
+  VirtualUnlock(begin, alignedLength);
+#else
+  if (m_AccessMode == CopyOnWrite)
+  {
+    // MADV_DONTNEED would drop private (modified) pages and lose their content,
+    // so only the pages that still match the file are dropped
+    this->EvictCleanPages(begin, alignedLength);
+    return;
+  }
+  if (m_AccessMode == ReadWrite)
+  {
+    msync(begin, alignedLength, MS_ASYNC);
+  }
+  madvise(begin, alignedLength, MADV_DONTNEED);
+#endif
+}
+
+#ifndef _WIN32
+void mitk::MemoryMappedFile::EvictCleanPages(char* begin, size_t length) const
+{
+#ifdef __linux__
+  // the page map tells for every page whether it is still backed by the file; pages
+  // that have been written are private anonymous copies (resident or swapped out)
+  int pageMap = ::open("/proc/self/pagemap", O_RDONLY);
+  if (pageMap < 0)
+    return;
+
+  const uint64_t present = uint64_t(1) << 63;
+  const uint64_t swapped = uint64_t(1) << 62;
+  const uint64_t filePage = uint64_t(1) << 61;
+
+  const size_t pageSize = GetPageSize();
+  const size_t firstPage = reinterpret_cast<size_t>(begin) / pageSize;
+  const size_t numPages = (length + pageSize - 1) / pageSize;
+  const size_t chunkSize = 4096;
+  std::vector<uint64_t> entries(chunkSize);
+
+  // first page of the current run of clean pages
+  size_t runBegin = 0;
+  bool inRun = false;
+  for (size_t chunk = 0; chunk < numPages; chunk += chunkSize)
+  {
+    const size_t count = std::min(chunkSize, numPages - chunk);
+    const off_t fileOffset = static_cast<off_t>((firstPage + chunk) * sizeof(uint64_t));
+    if (pread(pageMap, &entries[0], count * sizeof(uint64_t), fileOffset) != static_cast<ssize_t>(count * sizeof(uint64_t)))
+    {
+      // without page information, nothing else is known to be clean
+      if (inRun)
+      {
+        madvise(begin + runBegin * pageSize, (chunk - runBegin) * pageSize, MADV_DONTNEED);
+      }
+      ::close(pageMap);
+      return;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const uint64_t entry = entries[i];
+      const bool clean = (entry & present) ? (entry & filePage) != 0 : (entry & swapped) == 0;
+      const size_t page = chunk + i;
+      if (clean && !inRun)
+      {
+        runBegin = page;
+        inRun = true;
+      }
+      else if (!clean && inRun)
+      {
+        madvise(begin + runBegin * pageSize, (page - runBegin) * pageSize, MADV_DONTNEED);
+        inRun = false;
+      }
+    }
+  }
+  if (inRun)
+  {
+    madvise(begin + runBegin * pageSize, (numPages - runBegin) * pageSize, MADV_DONTNEED);
+  }
+  ::close(pageMap);
+#else
+  // written pages cannot be told apart from clean ones, keep everything
+  (void)begin;
+  (void)length;
+#endif
+}
+#endif
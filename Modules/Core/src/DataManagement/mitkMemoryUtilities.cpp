@@ -25,7 +25,9 @@ See LICENSE.txt or http://www.mitk.org for details.
   #include <mach/mach_init.h>
   #include <mach/mach_host.h>
   #include <sys/sysctl.h>
+  #include <sys/resource.h>
 #else
+  #include <sys/resource.h>
   #include <sys/sysinfo.h>
   #include <unistd.h>
 #endif
@@ -70,6 +72,100 @@ size_t mitk::MemoryUtilities::GetProcessMemoryUsage()
 }
 
 
+/**
+ * Returns the resident memory of the current process in bytes
+ * (the RES column in top, the working set size on windows).
+ */
+size_t mitk::MemoryUtilities::GetResidentProcessMemoryUsage()
+{
+#if _MSC_VER || __MINGW32__
+  size_t size = 0;
+  PROCESS_MEMORY_COUNTERS pmc;
+  if ( GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof(pmc)) )
+  {
+    size = pmc.WorkingSetSize;
+  }
+  return size;
+#elif defined(__APPLE__)
+  struct task_basic_info t_info;
+  mach_msg_type_number_t t_info_count = TASK_BASIC_INFO_COUNT;
+  task_info(current_task(), TASK_BASIC_INFO, (task_info_t)&t_info, &t_info_count);
+  return t_info.resident_size;
+#else
+  int size, res, shared, text, sharedLibs, stack, dirtyPages;
+  if ( ! ReadStatmFromProcFS( &size, &res, &shared, &text, &sharedLibs, &stack, &dirtyPages ) )
+    return (size_t) res * getpagesize();
+  else
+    return 0;
+#endif
+}
+
+
+/**
+ * Returns the peak resident memory (high water mark) of the current process in bytes.
+ * On windows, this refers to the peak working set size.
+ */
+size_t mitk::MemoryUtilities::GetPeakProcessMemoryUsage()
+{
+#if _MSC_VER || __MINGW32__
+  size_t size = 0;
+  PROCESS_MEMORY_COUNTERS pmc;
+  if ( GetProcessMemoryInfo( GetCurrentProcess(), &pmc, sizeof(pmc)) )
+  {
+    size = pmc.PeakWorkingSetSize;
+  }
+  return size;
+#else
+#if !defined(__APPLE__)
+  // VmHWM follows ResetPeakProcessMemoryUsage(), ru_maxrss does not
+  FILE* f = fopen( "/proc/self/status", "r" );
+  if ( f )
+  {
+    char line[256];
+    unsigned long kiloBytes = 0;
+    bool found = false;
+    while ( !found && fgets( line, sizeof(line), f ) )
+    {
+      found = sscanf( line, "VmHWM: %lu kB", &kiloBytes ) == 1;
+    }
+    fclose( f );
+    if ( found )
+      return (size_t) kiloBytes * 1024;
+  }
+#endif
+  struct rusage usage;
+  if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+    return 0;
+#if defined(__APPLE__)
+  // bytes on Mac OS X
+  return (size_t) usage.ru_maxrss;
+#else
+  // kilobytes on linux
+  return (size_t) usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+
+/**
+ * Resets the peak resident memory to the current resident memory. Returns false
+ * if the platform does not support this (only linux does).
+ */
+bool mitk::MemoryUtilities::ResetPeakProcessMemoryUsage()
+{
+#if _MSC_VER || __MINGW32__ || defined(__APPLE__)
+  return false;
+#else
+  // writing 5 to clear_refs resets the high water mark of the resident set (linux >= 4.0)
+  FILE* f = fopen( "/proc/self/clear_refs", "w" );
+  if ( !f )
+    return false;
+  const bool written = fputs( "5", f ) >= 0;
+  return fclose( f ) == 0 && written;
+#endif
+}
+
+
 /**
  * Returns the total size of phyiscal memory in bytes
  */
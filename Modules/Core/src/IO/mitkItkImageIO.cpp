@@ -19,26 +19,40 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkImage.h>
 #include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkMemoryUtilities.h>
 #include <mitkCustomMimeType.h>
 #include <mitkIOMimeTypes.h>
 #include <mitkLocaleSwitch.h>
 #include <mitkCoreServices.h>
 #include <mitkIPropertyPersistence.h>
 #include <mitkArbitraryTimeGeometry.h>
+#include <mitkMemoryMappedFile.h>
 
 #include <itkImage.h>
 #include <itkImageIOFactory.h>
 #include <itkImageFileReader.h>
 #include <itkImageIORegion.h>
 #include <itkMetaDataObject.h>
+#include <itkByteSwapper.h>
+#include <itksys/SystemTools.hxx>
 
 #include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 
 namespace mitk {
 
 const char * const PROPERTY_KEY_TIMEGEOMETRY_TYPE = "org.mitk.timegeometry.type";
 const char * const PROPERTY_KEY_TIMEGEOMETRY_TIMEPOINTS = "org.mitk.timegeometry.timepoints";
 
+std::string ItkImageIO::OPTION_MEMORY_MAPPING()
+{
+  static std::string s = "Memory mapping";
+  return s;
+}
+
 ItkImageIO::ItkImageIO(const ItkImageIO& other)
   : AbstractFileIO(other)
   , m_ImageIO(dynamic_cast<itk::ImageIOBase*>(other.m_ImageIO->Clone().GetPointer()))
@@ -110,6 +124,10 @@ ItkImageIO::ItkImageIO(itk::ImageIOBase::Pointer imageIO)
   this->AbstractFileReader::SetMimeTypePrefix(IOMimeTypes::DEFAULT_BASE_NAME() + ".image.");
   this->InitializeDefaultMetaDataKeys();
 
+  Options defaultOptions;
+  defaultOptions[OPTION_MEMORY_MAPPING()] = us::Any(false);
+  this->SetDefaultReaderOptions(defaultOptions);
+
   std::vector<std::string> readExtensions = m_ImageIO->GetSupportedReadExtensions();
 
   if (readExtensions.empty())
@@ -177,6 +195,10 @@ ItkImageIO::ItkImageIO(const CustomMimeType& mimeType, itk::ImageIOBase::Pointer
   this->AbstractFileReader::SetMimeTypePrefix(IOMimeTypes::DEFAULT_BASE_NAME() + ".image.");
   this->InitializeDefaultMetaDataKeys();
 
+  Options defaultOptions;
+  defaultOptions[OPTION_MEMORY_MAPPING()] = us::Any(false);
+  this->SetDefaultReaderOptions(defaultOptions);
+
   if (rank)
   {
     this->AbstractFileReader::SetRanking(rank);
@@ -207,6 +229,184 @@ std::vector<TimePointType> ConvertMetaDataObjectToTimePointList(const itk::MetaD
   return result;
 };
 
+/**Helper function that removes leading and trailing white space.*/
+static std::string TrimHeaderValue(const std::string& value)
+{
+  const std::string whitespace = " \t\r\n";
+  std::string::size_type begin = value.find_first_not_of(whitespace);
+  if (begin == std::string::npos)
+  {
+    return std::string();
+  }
+  std::string::size_type end = value.find_last_not_of(whitespace);
+  return value.substr(begin, end - begin + 1);
+}
+
+bool ItkImageIO::GetRawPixelDataLocation(const std::string& path, std::string& dataFile, size_t& offset) const
+{
+  const std::string imageIOName = m_ImageIO->GetNameOfClass();
+  const bool isNrrd = imageIOName == "NrrdImageIO";
+  const bool isMetaImage = imageIOName == "MetaImageIO";
+  if (!isNrrd && !isMetaImage)
+  {
+    return false;
+  }
+
+  if (m_ImageIO->GetComponentSize() > 1)
+  {
+    const itk::ImageIOBase::ByteOrder systemByteOrder = itk::ByteSwapper<int>::SystemIsBigEndian()
+      ? itk::ImageIOBase::BigEndian : itk::ImageIOBase::LittleEndian;
+    if (m_ImageIO->GetByteOrder() != systemByteOrder)
+    {
+      return false;
+    }
+  }
+
+  std::ifstream header(path.c_str(), std::ios::in | std::ios::binary);
+  if (!header.is_open())
+  {
+    return false;
+  }
+
+  const std::string separator = isNrrd ? ":" : "=";
+  std::string encoding = isNrrd ? "raw" : "false";
+  std::string detachedFile;
+  long long skip = 0;
+  long long lineSkip = 0;
+  bool permutedAxes = false;
+  bool attached = false;
+  std::streamoff headerEnd = 0;
+
+  std::string line;
+  while (std::getline(header, line))
+  {
+    line = TrimHeaderValue(line);
+    if (isNrrd && line.empty())
+    {
+      // an empty line terminates the header of attached NRRD data
+      attached = true;
+      break;
+    }
+    std::string::size_type pos = line.find(separator);
+    if (pos == std::string::npos)
+    {
+      continue;
+    }
+    std::string key = TrimHeaderValue(line.substr(0, pos));
+    std::string value = TrimHeaderValue(line.substr(pos + separator.size()));
+    if (isNrrd && !value.empty() && value[0] == '=')
+    {
+      // key/value pairs ("key:=value") are meta data
+      continue;
+    }
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+    if (isNrrd)
+    {
+      if (key == "encoding")
+      {
+        encoding = value;
+      }
+      else if (key == "data file" || key == "datafile")
+      {
+        detachedFile = value;
+      }
+      else if (key == "byte skip" || key == "byteskip")
+      {
+        skip = atoll(value.c_str());
+      }
+      else if (key == "line skip" || key == "lineskip")
+      {
+        lineSkip = atoll(value.c_str());
+      }
+      else if (key == "kinds")
+      {
+        // ITK moves a vector or list axis (any non-domain axis) to the front, so the pixel data
+        // in the file only matches the image if that axis is the fastest one already
+        std::istringstream kinds(value);
+        std::string kind;
+        for (int axis = 0; kinds >> kind; ++axis)
+        {
+          std::transform(kind.begin(), kind.end(), kind.begin(), ::tolower);
+          const bool isDomain = kind == "domain" || kind == "space" || kind == "time" || kind == "???" || kind == "none";
+          if (!isDomain && axis > 0)
+          {
+            permutedAxes = true;
+          }
+        }
+      }
+    }
+    else
+    {
+      std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+      if (key == "compresseddata")
+      {
+        encoding = value;
+      }
+      else if (key == "headersize")
+      {
+        skip = atoll(value.c_str());
+      }
+      else if (key == "elementdatafile")
+      {
+        // ElementDataFile is the last header entry
+        std::string fileName = TrimHeaderValue(line.substr(pos + separator.size()));
+        attached = value == "local";
+        if (!attached)
+        {
+          detachedFile = fileName;
+        }
+        break;
+      }
+    }
+  }
+  headerEnd = header.tellg();
+  header.close();
+
+  if ((isNrrd && encoding != "raw") || (isMetaImage && encoding != "false") || lineSkip != 0 || permutedAxes)
+  {
+    return false;
+  }
+
+  if (attached)
+  {
+    if (headerEnd < 0)
+    {
+      return false;
+    }
+    dataFile = path;
+  }
+  else
+  {
+    // lists and format strings of data files split the pixel data
+    if (detachedFile.empty() || detachedFile.find(' ') != std::string::npos || detachedFile.find('%') != std::string::npos
+        || itksys::SystemTools::LowerCase(detachedFile) == "list")
+    {
+      return false;
+    }
+    dataFile = itksys::SystemTools::CollapseFullPath(detachedFile, itksys::SystemTools::GetFilenamePath(path));
+    headerEnd = 0;
+  }
+
+  const unsigned long long fileSize = itksys::SystemTools::FileLength(dataFile);
+  const unsigned long long imageSize = m_ImageIO->GetImageSizeInBytes();
+  if (skip < 0)
+  {
+    // data is stored at the end of the file
+    if (fileSize < imageSize)
+    {
+      return false;
+    }
+    offset = static_cast<size_t>(fileSize - imageSize);
+  }
+  else
+  {
+    offset = static_cast<size_t>(headerEnd + skip);
+  }
+
+  return offset + imageSize <= fileSize;
+}
+
 std::vector<BaseData::Pointer> ItkImageIO::Read()
 {
   std::vector<BaseData::Pointer> result;
@@ -295,11 +495,79 @@ std::vector<BaseData::Pointer> ItkImageIO::Read()
 
   MITK_INFO << "ioRegion: " << ioRegion << std::endl;
   m_ImageIO->SetIORegion( ioRegion );
-  void* buffer = new unsigned char[m_ImageIO->GetImageSizeInBytes()];
-  m_ImageIO->Read( buffer );
 
   image->Initialize( MakePixelType(m_ImageIO), ndim, dimensions );
-  image->SetImportChannel( buffer, 0, Image::ManageMemory );
+
+  bool memoryMapped = false;
+  bool useMemoryMapping = false;
+  try
+  {
+    useMemoryMapping = us::any_cast<bool>(this->GetReaderOptions()[OPTION_MEMORY_MAPPING()]);
+  }
+  catch (const us::BadAnyCastException& e)
+  {
+    MITK_WARN << "Unexpected error: " << e.what();
+  }
+
+  if (useMemoryMapping)
+  {
+    std::string dataFile;
+    size_t offset = 0;
+    if (this->GetRawPixelDataLocation(path, dataFile, offset))
+    {
+      try
+      {
+        MemoryMappedFile::Pointer mappedFile = MemoryMappedFile::New();
+        mappedFile->Open(dataFile, offset, m_ImageIO->GetImageSizeInBytes());
+        memoryMapped = image->SetMemoryMappedChannel(mappedFile);
+      }
+      catch (const mitk::Exception& e)
+      {
+        MITK_WARN << e.GetDescription();
+      }
+    }
+
+    if (memoryMapped)
+    {
+      MITK_INFO << "memory mapped pixel data of " << dataFile << " at offset " << offset;
+    }
+    else
+    {
+      MITK_WARN << "Pixel data of " << path << " cannot be memory mapped, reading it into memory.";
+    }
+  }
+
+  if (!memoryMapped)
+  {
+    size_t channelSize = image->GetPixelType().GetSize();
+    for ( i = 0; i < image->GetDimension(); ++i )
+    {
+      channelSize *= image->GetDimension( i );
+    }
+
+    if ( channelSize >= m_ImageIO->GetImageSizeInBytes() )
+    {
+      // let ITK read directly into the channel allocated by the image, which
+      // avoids a temporary buffer of the full image size
+      ImageWriteAccessor imageAccess( image );
+      m_ImageIO->Read( imageAccess.GetData() );
+    }
+    else
+    {
+      // files with more than MAXDIM dimensions are larger than the image
+      unsigned char* buffer = mitk::MemoryUtilities::AllocateElements<unsigned char>( m_ImageIO->GetImageSizeInBytes() );
+      try
+      {
+        m_ImageIO->Read( buffer );
+      }
+      catch (...)
+      {
+        mitk::MemoryUtilities::DeleteElements( buffer );
+        throw;
+      }
+      image->SetImportChannel( buffer, 0, Image::ManageMemory );
+    }
+  }
 
   const itk::MetaDataDictionary& dictionary = m_ImageIO->GetMetaDataDictionary();
 
@@ -377,7 +645,6 @@ std::vector<BaseData::Pointer> ItkImageIO::Read()
 
   image->SetTimeGeometry(timeGeometry);
 
-  buffer = NULL;
   MITK_INFO << "number of image components: "<< image->GetPixelType().GetNumberOfComponents() << std::endl;
 
   for (itk::MetaDataDictionary::ConstIterator iter = dictionary.Begin(), iterEnd = dictionary.End();
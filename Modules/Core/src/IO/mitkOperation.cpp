@@ -30,3 +30,8 @@ mitk::OperationType mitk::Operation::GetOperationType()
 {
   return m_OperationType;
 }
+
+size_t mitk::Operation::GetMemoryUsage() const
+{
+  return 0;
+}
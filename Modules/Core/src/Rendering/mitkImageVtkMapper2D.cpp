@@ -166,6 +166,19 @@ void mitk::ImageVtkMapper2D::GenerateDataForRenderer( mitk::BaseRenderer *render
   datanode->GetBoolProperty("in plane resample extent by geometry", inPlaneResampleExtentByGeometry, renderer);
   localStorage->m_Reslicer->SetInPlaneResampleExtentByGeometry(inPlaneResampleExtentByGeometry);
 
+  // extracted slices are only cached on request, caching does not pay off for images that are
+  // modified frequently, e.g. segmentations while they are painted
+  bool sliceCache = false;
+  datanode->GetBoolProperty("Image Rendering.Slice Cache", sliceCache, renderer);
+  if (!sliceCache)
+  {
+    localStorage->m_Reslicer->SetSliceCache(nullptr);
+  }
+  else if (localStorage->m_Reslicer->GetSliceCache() == nullptr)
+  {
+    localStorage->m_Reslicer->SetSliceCache(mitk::ExtractSliceCache::New());
+  }
+
 
   // Initialize the interpolation mode for resampling; switch to nearest
   // neighbor if the input image is too small.
@@ -655,6 +668,19 @@ void mitk::ImageVtkMapper2D::Update(mitk::BaseRenderer* renderer)
   data->UpdateOutputInformation();
   LocalStorage *localStorage = m_LSH.GetLocalStorage(renderer);
 
+  // memory mapped images are paged in on access: hint that the volume of the new time step
+  // is needed now and that the volume shown before may be dropped from main memory
+  const int timeStep = this->GetTimestep();
+  if ( localStorage->m_LastTimeStep != timeStep && data->IsMemoryMapped() )
+  {
+    if ( localStorage->m_LastTimeStep >= 0 && dataTimeGeometry->IsValidTimeStep( localStorage->m_LastTimeStep ) )
+    {
+      data->EvictVolume( localStorage->m_LastTimeStep );
+    }
+    data->PrefetchVolume( timeStep );
+  }
+  localStorage->m_LastTimeStep = timeStep;
+
   //check if something important has changed and we need to rerender
   if ( (localStorage->m_LastUpdateTime < node->GetMTime()) //was the node modified?
        || (localStorage->m_LastUpdateTime < data->GetPipelineMTime()) //Was the data modified?
@@ -1033,6 +1059,7 @@ mitk::ImageVtkMapper2D::LocalStorage::~LocalStorage()
 
 mitk::ImageVtkMapper2D::LocalStorage::LocalStorage()
   : m_VectorComponentExtractor(vtkSmartPointer<vtkImageExtractComponents>::New())
+  , m_LastTimeStep(-1)
 {
 
   m_LevelWindowFilter = vtkSmartPointer<vtkMitkLevelWindowFilter>::New();
@@ -0,0 +1,205 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkTestFixture.h"
+
+#include <mitkExtractSliceCache.h>
+#include <mitkExtractSliceFilter.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkPlaneGeometry.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+
+class mitkExtractSliceCacheTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkExtractSliceCacheTestSuite);
+  MITK_TEST(Update_SameSliceTwice_SecondIsHit);
+  MITK_TEST(Update_ImageModified_IsMiss);
+  MITK_TEST(Update_Scrolling_NextSlicesArePrefetched);
+  MITK_TEST(Update_ScrollingWhileImageIsWritten_NothingIsPrefetched);
+  MITK_TEST(Update_ScrollingWithFullCache_RequestedSlicesAreKept);
+  MITK_TEST(Insert_ExceedsMaximumSize_OldestSlicesAreRemoved);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::Image::Pointer m_Image;
+  mitk::ExtractSliceCache::Pointer m_Cache;
+  mitk::ExtractSliceFilter::Pointer m_Filter;
+
+  mitk::PlaneGeometry::Pointer CreatePlane(unsigned int slice)
+  {
+    mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+    plane->InitializeStandardPlane(m_Image->GetGeometry(), mitk::PlaneGeometry::Axial, slice);
+    plane->SetReferenceGeometry(m_Image->GetGeometry());
+    return plane;
+  }
+
+  /** Extracts the slice and checks that it matches the voxel data of the volume. */
+  bool ExtractSlice(unsigned int slice)
+  {
+    mitk::PlaneGeometry::Pointer plane = this->CreatePlane(slice);
+    m_Filter->SetWorldGeometry(plane);
+    m_Filter->Modified();
+    m_Filter->Update();
+
+    vtkImageData* output = m_Filter->GetVtkOutput();
+    const unsigned char* data = static_cast<const unsigned char*>(output->GetScalarPointer());
+    bool equal = data != nullptr;
+    for (unsigned int i = 0; equal && i < 32 * 24; ++i)
+    {
+      equal = data[i] == this->PixelValue(slice * 32 * 24 + i);
+    }
+    return equal;
+  }
+
+  unsigned char PixelValue(unsigned int index) const
+  {
+    return static_cast<unsigned char>(index % 253);
+  }
+
+public:
+
+  void setUp() override
+  {
+    unsigned int dimensions[3] = { 32, 24, 16 };
+    m_Image = mitk::Image::New();
+    m_Image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 3, dimensions);
+    {
+      mitk::ImageWriteAccessor writeAccess(m_Image);
+      unsigned char* data = static_cast<unsigned char*>(writeAccess.GetData());
+      for (unsigned int i = 0; i < 32 * 24 * 16; ++i)
+      {
+        data[i] = this->PixelValue(i);
+      }
+    }
+
+    m_Cache = mitk::ExtractSliceCache::New();
+    m_Filter = mitk::ExtractSliceFilter::New();
+    m_Filter->SetInput(m_Image);
+    m_Filter->SetVtkOutputRequest(true);
+    m_Filter->SetSliceCache(m_Cache);
+  }
+
+  void tearDown() override
+  {
+    m_Filter = nullptr;
+    m_Cache = nullptr;
+    m_Image = nullptr;
+  }
+
+  void Update_SameSliceTwice_SecondIsHit()
+  {
+    CPPUNIT_ASSERT_MESSAGE("First extraction is correct", this->ExtractSlice(5));
+    CPPUNIT_ASSERT_EQUAL(1ul, m_Cache->GetNumberOfMisses());
+
+    CPPUNIT_ASSERT_MESSAGE("Cached slice is correct", this->ExtractSlice(5));
+    CPPUNIT_ASSERT_EQUAL(1ul, m_Cache->GetNumberOfHits());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, m_Cache->GetHitRate(), mitk::eps);
+  }
+
+  void Update_ImageModified_IsMiss()
+  {
+    this->ExtractSlice(5);
+    m_Image->Modified();
+    this->ExtractSlice(5);
+
+    CPPUNIT_ASSERT_EQUAL(0ul, m_Cache->GetNumberOfHits());
+    CPPUNIT_ASSERT_EQUAL(2ul, m_Cache->GetNumberOfMisses());
+  }
+
+  void Update_Scrolling_NextSlicesArePrefetched()
+  {
+    m_Cache->SetNumberOfPrefetchedSlices(2);
+    this->ExtractSlice(5);
+    this->ExtractSlice(6);
+
+    // slices 7 and 8 are extracted in the background
+    for (unsigned int i = 0; i < 100 && m_Cache->GetNumberOfPrefetches() < 2; ++i)
+    {
+      itksys::SystemTools::Delay(20);
+    }
+    CPPUNIT_ASSERT_EQUAL(2ul, m_Cache->GetNumberOfPrefetches());
+
+    CPPUNIT_ASSERT_MESSAGE("Prefetched slice is correct", this->ExtractSlice(7));
+    CPPUNIT_ASSERT_MESSAGE("Prefetched slice is correct", this->ExtractSlice(8));
+    CPPUNIT_ASSERT_EQUAL(2ul, m_Cache->GetNumberOfHits());
+  }
+
+  void Update_ScrollingWhileImageIsWritten_NothingIsPrefetched()
+  {
+    m_Cache->SetNumberOfPrefetchedSlices(2);
+    {
+      mitk::ImageWriteAccessor writeAccess(m_Image);
+      this->ExtractSlice(5);
+      this->ExtractSlice(6);
+      // give the background thread the chance to extract slices 7 and 8
+      itksys::SystemTools::Delay(200);
+    }
+    CPPUNIT_ASSERT_EQUAL(0ul, m_Cache->GetNumberOfPrefetches());
+
+    CPPUNIT_ASSERT_MESSAGE("Slice is correct", this->ExtractSlice(7));
+    CPPUNIT_ASSERT_EQUAL(0ul, m_Cache->GetNumberOfHits());
+  }
+
+  void Update_ScrollingWithFullCache_RequestedSlicesAreKept()
+  {
+    m_Cache->SetNumberOfPrefetchedSlices(0);
+    this->ExtractSlice(0);
+    const unsigned long sliceSize = m_Cache->GetSize();
+    m_Cache->SetMaximumSize(2 * sliceSize);
+
+    m_Cache->SetNumberOfPrefetchedSlices(2);
+    this->ExtractSlice(5);
+    this->ExtractSlice(6);
+    for (unsigned int i = 0; i < 100 && m_Cache->GetNumberOfPrefetches() < 2; ++i)
+    {
+      itksys::SystemTools::Delay(20);
+    }
+
+    // slices 7 and 8 do not fit into the cache without removing the requested slices
+    CPPUNIT_ASSERT_EQUAL(2 * sliceSize, m_Cache->GetSize());
+    CPPUNIT_ASSERT_MESSAGE("Requested slice is correct", this->ExtractSlice(6));
+    CPPUNIT_ASSERT_MESSAGE("Requested slice is correct", this->ExtractSlice(5));
+    CPPUNIT_ASSERT_EQUAL(2ul, m_Cache->GetNumberOfHits());
+  }
+
+  void Insert_ExceedsMaximumSize_OldestSlicesAreRemoved()
+  {
+    m_Cache->SetNumberOfPrefetchedSlices(0);
+    this->ExtractSlice(0);
+    const unsigned long sliceSize = m_Cache->GetSize();
+    CPPUNIT_ASSERT_MESSAGE("Slice is cached", sliceSize > 0);
+
+    m_Cache->SetMaximumSize(3 * sliceSize);
+    for (unsigned int slice = 1; slice < 5; ++slice)
+    {
+      this->ExtractSlice(slice);
+    }
+    CPPUNIT_ASSERT_EQUAL(3 * sliceSize, m_Cache->GetSize());
+
+    // slice 4 is still cached, slice 0 is not
+    this->ExtractSlice(4);
+    CPPUNIT_ASSERT_EQUAL(1ul, m_Cache->GetNumberOfHits());
+    this->ExtractSlice(0);
+    CPPUNIT_ASSERT_EQUAL(1ul, m_Cache->GetNumberOfHits());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkExtractSliceCache)
@@ -0,0 +1,138 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkExtractSliceFilter.h"
+#include "mitkImageWriteAccessor.h"
+#include "mitkPlaneGeometry.h"
+
+#include <itkRGBPixel.h>
+#include <itkTimeProbe.h>
+
+#include <vtkImageData.h>
+
+#include <cstring>
+
+namespace
+{
+  const unsigned int repetitions = 20;
+
+  double ExtractSlices(mitk::ExtractSliceFilter* filter)
+  {
+    itk::TimeProbe timeProbe;
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+      timeProbe.Start();
+      filter->Modified();
+      filter->Update();
+      timeProbe.Stop();
+    }
+    return timeProbe.GetMean();
+  }
+
+  bool SlicesAreEqual(vtkImageData* slice1, vtkImageData* slice2)
+  {
+    int extent1[6], extent2[6];
+    slice1->GetExtent(extent1);
+    slice2->GetExtent(extent2);
+    if (std::memcmp(extent1, extent2, sizeof(extent1)) != 0)
+      return false;
+    if (slice1->GetScalarType() != slice2->GetScalarType()
+        || slice1->GetNumberOfScalarComponents() != slice2->GetNumberOfScalarComponents())
+      return false;
+
+    const size_t size = slice1->GetNumberOfPoints() * slice1->GetScalarSize() * slice1->GetNumberOfScalarComponents();
+    return std::memcmp(slice1->GetScalarPointer(), slice2->GetScalarPointer(), size) == 0;
+  }
+
+  /** Compares the axis aligned extraction to vtkImageReslice for the three standard planes of a volume. */
+  template <typename TComponent>
+  void BenchmarkPixelType(const std::string& name, const mitk::PixelType& pixelType)
+  {
+    unsigned int dimensions[3] = { 256, 256, 128 };
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(pixelType, 3, dimensions);
+    {
+      mitk::ImageWriteAccessor writeAccess(image);
+      TComponent* data = static_cast<TComponent*>(writeAccess.GetData());
+      const size_t numberOfComponents = dimensions[0] * dimensions[1] * dimensions[2] * pixelType.GetNumberOfComponents();
+      for (size_t i = 0; i < numberOfComponents; ++i)
+      {
+        data[i] = static_cast<TComponent>(i % 251);
+      }
+    }
+
+    const mitk::PlaneGeometry::PlaneOrientation orientations[3] =
+      { mitk::PlaneGeometry::Axial, mitk::PlaneGeometry::Sagittal, mitk::PlaneGeometry::Frontal };
+    const char* orientationNames[3] = { "axial", "sagittal", "coronal" };
+    const unsigned int positions[3] = { dimensions[2] / 2, dimensions[0] / 2, dimensions[1] / 2 };
+
+    for (int o = 0; o < 3; ++o)
+    {
+      mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+      plane->InitializeStandardPlane(image->GetGeometry(), orientations[o], positions[o]);
+      plane->SetReferenceGeometry(image->GetGeometry());
+
+      mitk::ExtractSliceFilter::Pointer copyFilter = mitk::ExtractSliceFilter::New();
+      mitk::ExtractSliceFilter::Pointer resliceFilter = mitk::ExtractSliceFilter::New();
+      resliceFilter->SetAxisAlignedExtraction(false);
+
+      mitk::ExtractSliceFilter* filters[2] = { copyFilter, resliceFilter };
+      for (int f = 0; f < 2; ++f)
+      {
+        filters[f]->SetInput(image);
+        filters[f]->SetWorldGeometry(plane);
+        filters[f]->SetResliceTransformByGeometry(image->GetGeometry());
+        filters[f]->SetVtkOutputRequest(true);
+      }
+
+      const double copyTime = ExtractSlices(copyFilter);
+      const double resliceTime = ExtractSlices(resliceFilter);
+
+      vtkImageData* copiedSlice = copyFilter->GetVtkOutput();
+      vtkImageData* reslicedSlice = resliceFilter->GetVtkOutput();
+      const double megaPixels = copiedSlice->GetNumberOfPoints() / 1.0e6;
+
+      MITK_INFO << name << " " << orientationNames[o] << " (" << copiedSlice->GetDimensions()[0] << "x" << copiedSlice->GetDimensions()[1] << "):"
+                << " reslice " << resliceTime * 1000.0 << " ms (" << (resliceTime > 0.0 ? megaPixels / resliceTime : 0.0) << " MPixel/s),"
+                << " copy " << copyTime * 1000.0 << " ms (" << (copyTime > 0.0 ? megaPixels / copyTime : 0.0) << " MPixel/s),"
+                << " speedup " << (copyTime > 0.0 ? resliceTime / copyTime : 0.0);
+
+      MITK_TEST_CONDITION(copyFilter->GetSliceCopied(), "Axis aligned " << orientationNames[o] << " " << name << " slice is copied");
+      MITK_TEST_CONDITION(!resliceFilter->GetSliceCopied(), orientationNames[o] << " " << name << " slice is resampled if axis aligned extraction is disabled");
+      MITK_TEST_CONDITION(SlicesAreEqual(copiedSlice, reslicedSlice),
+        "Axis aligned extraction of " << orientationNames[o] << " " << name << " slice equals vtkImageReslice");
+    }
+  }
+}
+
+/**
+ * Measures the time to extract the axial, sagittal and coronal slice of a volume with
+ * vtkImageReslice and with the axis aligned extraction of ExtractSliceFilter for several
+ * pixel types, and checks that both yield the same slice.
+ */
+int mitkExtractSliceFilterPerformanceTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("ExtractSliceFilterPerformance")
+
+  BenchmarkPixelType<unsigned char>("unsigned char", mitk::MakeScalarPixelType<unsigned char>());
+  BenchmarkPixelType<short>("short", mitk::MakeScalarPixelType<short>());
+  BenchmarkPixelType<float>("float", mitk::MakeScalarPixelType<float>());
+  BenchmarkPixelType<double>("double", mitk::MakeScalarPixelType<double>());
+  BenchmarkPixelType<unsigned char>("RGB", mitk::MakePixelType<itk::Image<itk::RGBPixel<unsigned char>, 3> >());
+
+  MITK_TEST_END()
+}
@@ -0,0 +1,104 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkIOUtil.h"
+#include "mitkImage.h"
+#include "mitkMemoryUtilities.h"
+
+#include <itkTimeProbe.h>
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+
+/**
+ * Loads each image given on the command line several times and reports the load time,
+ * the throughput in MB/s (of uncompressed pixel data) and the peak resident memory per format.
+ *
+ * Reading must not need more than the image itself plus a small overhead, i.e. the pixel
+ * data must not be buffered and copied. The peak of every load is measured from the resident
+ * memory before the load. Where the peak cannot be reset (windows, mac), it is only known if
+ * the load raised the peak of the process, other loads are not checked.
+ */
+int mitkItkImageIOPerformanceTest(int argc, char* argv[])
+{
+  MITK_TEST_BEGIN("ItkImageIOPerformance")
+
+  MITK_TEST_CONDITION_REQUIRED(argc > 1, "At least one image file is given");
+
+  const unsigned int repetitions = 3;
+  const double megaByte = 1024.0 * 1024.0;
+
+  // small images are dominated by reader setup, so allow a fixed overhead
+  const size_t overhead = 16 * 1024 * 1024;
+
+  for (int arg = 1; arg < argc; ++arg)
+  {
+    const std::string fileName = argv[arg];
+    const std::string extension = itksys::SystemTools::GetFilenameLastExtension(fileName);
+
+    itk::TimeProbe timeProbe;
+    size_t imageSize = 0;
+    size_t additionalPeakMemory = 0;
+    unsigned int measuredRepetitions = 0;
+
+    for (unsigned int r = 0; r < repetitions; ++r)
+    {
+      // the image of the previous repetition has been released, start from a fresh baseline
+      const bool peakReset = mitk::MemoryUtilities::ResetPeakProcessMemoryUsage();
+      const size_t residentBefore = mitk::MemoryUtilities::GetResidentProcessMemoryUsage();
+      const size_t peakBefore = mitk::MemoryUtilities::GetPeakProcessMemoryUsage();
+
+      timeProbe.Start();
+      mitk::Image::Pointer image = mitk::IOUtil::LoadImage(fileName);
+      timeProbe.Stop();
+
+      const size_t peakAfter = mitk::MemoryUtilities::GetPeakProcessMemoryUsage();
+
+      MITK_TEST_CONDITION_REQUIRED(image.IsNotNull(), "Loaded " << fileName);
+
+      imageSize = image->GetPixelType().GetSize();
+      for (unsigned int i = 0; i < image->GetDimension(); ++i)
+      {
+        imageSize *= image->GetDimension(i);
+      }
+
+      // without a reset, an unchanged peak may stem from an earlier, larger allocation
+      if (peakReset || peakAfter > peakBefore)
+      {
+        const size_t growth = peakAfter > residentBefore ? peakAfter - residentBefore : 0;
+        additionalPeakMemory = std::max(additionalPeakMemory, growth);
+        ++measuredRepetitions;
+
+        MITK_TEST_CONDITION(growth <= imageSize + overhead,
+          "Reading " << fileName << " (run " << r << ") does not need a second copy of the pixel data ("
+          << growth / megaByte << " MB for " << imageSize / megaByte << " MB of pixel data)");
+      }
+    }
+
+    const double seconds = timeProbe.GetMean();
+    const double throughput = seconds > 0.0 ? (imageSize / megaByte) / seconds : 0.0;
+
+    MITK_INFO << "[" << extension << "] " << fileName;
+    MITK_INFO << "  image size:      " << imageSize / megaByte << " MB";
+    MITK_INFO << "  mean load time:  " << seconds * 1000.0 << " ms (" << repetitions << " runs)";
+    MITK_INFO << "  throughput:      " << throughput << " MB/s";
+    MITK_INFO << "  peak RSS:        " << mitk::MemoryUtilities::GetPeakProcessMemoryUsage() / megaByte << " MB";
+    MITK_INFO << "  peak RSS growth: " << additionalPeakMemory / megaByte << " MB (" << measuredRepetitions << " of " << repetitions << " runs measured)";
+  }
+
+  MITK_TEST_END()
+}
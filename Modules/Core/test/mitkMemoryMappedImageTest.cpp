@@ -0,0 +1,259 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include "mitkTestFixture.h"
+
+#include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkIOUtil.h>
+#include <mitkItkImageIO.h>
+#include <mitkMemoryMappedFile.h>
+
+#include <itksys/SystemTools.hxx>
+
+#include <fstream>
+#include <vector>
+
+class mitkMemoryMappedImageTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMemoryMappedImageTestSuite);
+  MITK_TEST(Open_WithOffset_MapsFileContent);
+  MITK_TEST(Open_RangeExceedsFile_Throws);
+  MITK_TEST(SetMemoryMappedChannel_AccessorsSeeFileContent);
+  MITK_TEST(WriteAccess_CopyOnWrite_DoesNotModifyFile);
+  MITK_TEST(EvictVolume_CopyOnWrite_KeepsWrittenData);
+  MITK_TEST(Load_RawNrrdWithMemoryMapping_IsMemoryMapped);
+  MITK_TEST(Load_NrrdWithSlowVectorAxis_IsReadIntoMemory);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  static const unsigned int HEADER_SIZE = 100;
+
+  unsigned int m_Dimensions[4];
+  size_t m_DataSize;
+  std::string m_FileName;
+
+  unsigned char PixelValue(size_t index) const
+  {
+    return static_cast<unsigned char>(index % 251);
+  }
+
+  std::vector<char> ReadFile(const std::string& fileName) const
+  {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Dimensions[0] = 64;
+    m_Dimensions[1] = 48;
+    m_Dimensions[2] = 5;
+    m_Dimensions[3] = 3;
+    m_DataSize = m_Dimensions[0] * m_Dimensions[1] * m_Dimensions[2] * m_Dimensions[3];
+
+    // a header of arbitrary size followed by the pixel data
+    std::ofstream tmpStream;
+    m_FileName = mitk::IOUtil::CreateTemporaryFile(tmpStream, std::ios_base::out | std::ios_base::binary, "MemoryMapped-XXXXXX.raw");
+    for (unsigned int i = 0; i < HEADER_SIZE; ++i)
+    {
+      tmpStream.put('#');
+    }
+    for (size_t i = 0; i < m_DataSize; ++i)
+    {
+      tmpStream.put(static_cast<char>(PixelValue(i)));
+    }
+    tmpStream.close();
+  }
+
+  void tearDown() override
+  {
+    itksys::SystemTools::RemoveFile(m_FileName.c_str());
+  }
+
+  void Open_WithOffset_MapsFileContent()
+  {
+    mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+    mappedFile->Open(m_FileName, HEADER_SIZE, m_DataSize, mitk::MemoryMappedFile::ReadOnly);
+
+    CPPUNIT_ASSERT_MESSAGE("File is mapped", mappedFile->IsOpen());
+    CPPUNIT_ASSERT_EQUAL(m_DataSize, mappedFile->GetLength());
+
+    const unsigned char* data = static_cast<const unsigned char*>(mappedFile->GetData());
+    bool equal = true;
+    for (size_t i = 0; i < m_DataSize; ++i)
+    {
+      equal = equal && data[i] == PixelValue(i);
+    }
+    CPPUNIT_ASSERT_MESSAGE("Mapped data starts at the given offset", equal);
+
+    mappedFile->Close();
+    CPPUNIT_ASSERT_MESSAGE("Mapping is released", !mappedFile->IsOpen());
+  }
+
+  void Open_RangeExceedsFile_Throws()
+  {
+    mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+    CPPUNIT_ASSERT_THROW(mappedFile->Open(m_FileName, HEADER_SIZE, m_DataSize + 1), mitk::Exception);
+    CPPUNIT_ASSERT_THROW(mappedFile->Open(m_FileName + ".missing"), mitk::Exception);
+  }
+
+  void SetMemoryMappedChannel_AccessorsSeeFileContent()
+  {
+    mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+    mappedFile->Open(m_FileName, HEADER_SIZE, m_DataSize);
+
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 4, m_Dimensions);
+    CPPUNIT_ASSERT_MESSAGE("Channel is set from mapping", image->SetMemoryMappedChannel(mappedFile));
+    CPPUNIT_ASSERT_MESSAGE("Image reports memory mapped channel", image->IsMemoryMapped());
+    CPPUNIT_ASSERT_MESSAGE("Volumes are complete", image->IsVolumeSet(2));
+
+    const size_t volumeSize = m_Dimensions[0] * m_Dimensions[1] * m_Dimensions[2];
+    image->PrefetchVolume(2);
+    mitk::ImageReadAccessor readAccess(image, image->GetVolumeData(2));
+    const unsigned char* data = static_cast<const unsigned char*>(readAccess.GetData());
+    bool equal = true;
+    for (size_t i = 0; i < volumeSize; ++i)
+    {
+      equal = equal && data[i] == PixelValue(2 * volumeSize + i);
+    }
+    CPPUNIT_ASSERT_MESSAGE("Volume data is read from the file", equal);
+
+    image->EvictVolume(2);
+    CPPUNIT_ASSERT_MESSAGE("Evicted data is paged in again", data[1] == PixelValue(2 * volumeSize + 1));
+  }
+
+  void WriteAccess_CopyOnWrite_DoesNotModifyFile()
+  {
+    std::vector<char> before = ReadFile(m_FileName);
+    {
+      mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+      mappedFile->Open(m_FileName, HEADER_SIZE, m_DataSize, mitk::MemoryMappedFile::CopyOnWrite);
+
+      mitk::Image::Pointer image = mitk::Image::New();
+      image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 4, m_Dimensions);
+      image->SetMemoryMappedChannel(mappedFile);
+
+      mitk::ImageWriteAccessor writeAccess(image, image->GetVolumeData(1));
+      unsigned char* data = static_cast<unsigned char*>(writeAccess.GetData());
+      data[0] = 255;
+      CPPUNIT_ASSERT_MESSAGE("Written data is visible", static_cast<unsigned char*>(writeAccess.GetData())[0] == 255);
+    }
+    CPPUNIT_ASSERT_MESSAGE("File content is unchanged", before == ReadFile(m_FileName));
+  }
+
+  void EvictVolume_CopyOnWrite_KeepsWrittenData()
+  {
+    mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+    mappedFile->Open(m_FileName, HEADER_SIZE, m_DataSize, mitk::MemoryMappedFile::CopyOnWrite);
+
+    mitk::Image::Pointer image = mitk::Image::New();
+    image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 4, m_Dimensions);
+    image->SetMemoryMappedChannel(mappedFile);
+
+    const size_t volumeSize = m_Dimensions[0] * m_Dimensions[1] * m_Dimensions[2];
+    mitk::ImageWriteAccessor writeAccess(image, image->GetVolumeData(1));
+    unsigned char* data = static_cast<unsigned char*>(writeAccess.GetData());
+    data[0] = 255;
+
+    // the written page only exists in memory, the other pages are paged in from the file again
+    image->EvictVolume(1);
+    CPPUNIT_ASSERT_MESSAGE("Written data survives eviction", data[0] == 255);
+    CPPUNIT_ASSERT_MESSAGE("Clean data is paged in again", data[volumeSize - 1] == PixelValue(2 * volumeSize - 1));
+  }
+
+  void Load_RawNrrdWithMemoryMapping_IsMemoryMapped()
+  {
+    std::ofstream tmpStream;
+    std::string nrrdFileName = mitk::IOUtil::CreateTemporaryFile(tmpStream, std::ios_base::out | std::ios_base::binary, "MemoryMapped-XXXXXX.nrrd");
+    tmpStream << "NRRD0004\n"
+              << "type: unsigned char\n"
+              << "dimension: 4\n"
+              << "sizes: " << m_Dimensions[0] << " " << m_Dimensions[1] << " " << m_Dimensions[2] << " " << m_Dimensions[3] << "\n"
+              << "encoding: raw\n"
+              << "\n";
+    for (size_t i = 0; i < m_DataSize; ++i)
+    {
+      tmpStream.put(static_cast<char>(PixelValue(i)));
+    }
+    tmpStream.close();
+
+    mitk::IFileReader::Options options;
+    options[mitk::ItkImageIO::OPTION_MEMORY_MAPPING()] = us::Any(true);
+    std::vector<mitk::BaseData::Pointer> data = mitk::IOUtil::Load(nrrdFileName, options);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), data.size());
+
+    mitk::Image::Pointer image = dynamic_cast<mitk::Image*>(data[0].GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Loaded image", image.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Raw NRRD payload is memory mapped", image->IsMemoryMapped());
+
+    mitk::ImageReadAccessor readAccess(image);
+    const unsigned char* pixels = static_cast<const unsigned char*>(readAccess.GetData());
+    CPPUNIT_ASSERT_MESSAGE("First pixel", pixels[0] == PixelValue(0));
+    CPPUNIT_ASSERT_MESSAGE("Last pixel", pixels[m_DataSize - 1] == PixelValue(m_DataSize - 1));
+
+    image = nullptr;
+    data.clear();
+    itksys::SystemTools::RemoveFile(nrrdFileName.c_str());
+  }
+
+  void Load_NrrdWithSlowVectorAxis_IsReadIntoMemory()
+  {
+    // ITK moves the vector axis to the front, so the file content does not match the pixel layout
+    std::ofstream tmpStream;
+    std::string nrrdFileName = mitk::IOUtil::CreateTemporaryFile(tmpStream, std::ios_base::out | std::ios_base::binary, "MemoryMapped-XXXXXX.nrrd");
+    tmpStream << "NRRD0004\n"
+              << "type: unsigned char\n"
+              << "dimension: 4\n"
+              << "sizes: " << m_Dimensions[0] << " " << m_Dimensions[1] << " " << m_Dimensions[2] << " " << m_Dimensions[3] << "\n"
+              << "kinds: domain domain domain vector\n"
+              << "encoding: raw\n"
+              << "\n";
+    for (size_t i = 0; i < m_DataSize; ++i)
+    {
+      tmpStream.put(static_cast<char>(PixelValue(i)));
+    }
+    tmpStream.close();
+
+    mitk::IFileReader::Options options;
+    options[mitk::ItkImageIO::OPTION_MEMORY_MAPPING()] = us::Any(true);
+    std::vector<mitk::BaseData::Pointer> data = mitk::IOUtil::Load(nrrdFileName, options);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), data.size());
+
+    mitk::Image::Pointer image = dynamic_cast<mitk::Image*>(data[0].GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Loaded image", image.IsNotNull());
+    CPPUNIT_ASSERT_MESSAGE("Permuted NRRD payload is not memory mapped", !image->IsMemoryMapped());
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(m_Dimensions[3]), image->GetPixelType().GetNumberOfComponents());
+
+    const size_t volumeSize = m_Dimensions[0] * m_Dimensions[1] * m_Dimensions[2];
+    mitk::ImageReadAccessor readAccess(image);
+    const unsigned char* pixels = static_cast<const unsigned char*>(readAccess.GetData());
+    CPPUNIT_ASSERT_MESSAGE("Second component of the first pixel", pixels[1] == PixelValue(volumeSize));
+    CPPUNIT_ASSERT_MESSAGE("First component of the second pixel", pixels[m_Dimensions[3]] == PixelValue(1));
+
+    image = nullptr;
+    data.clear();
+    itksys::SystemTools::RemoveFile(nrrdFileName.c_str());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMemoryMappedImage)
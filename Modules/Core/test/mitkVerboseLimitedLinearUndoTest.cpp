@@ -33,8 +33,8 @@ namespace mitk {
 class TestOperation : public Operation
 {
 public:
-  TestOperation(OperationType operationType)
-    : Operation(operationType)
+  TestOperation(OperationType operationType, size_t memoryUsage = 0)
+    : Operation(operationType), m_MemoryUsage(memoryUsage)
   {
     g_GlobalCounter++;
   };
@@ -43,6 +43,14 @@ public:
   {
     g_GlobalCounter--;
   };
+
+  virtual size_t GetMemoryUsage() const override
+  {
+    return m_MemoryUsage;
+  };
+
+private:
+  size_t m_MemoryUsage;
 };
 }//namespace
 
@@ -120,6 +128,30 @@ int mitkVerboseLimitedLinearUndoTest(int /* argc */, char* /*argv*/[])
   myUndoController->Clear();
   MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 0,"checking deleting all operations in UndoModel");
 
+  //limit the memory of the undo stack: each OperationEvent holds 2 * 100 bytes
+  mitk::LimitedLinearUndo* undoModel = dynamic_cast<mitk::LimitedLinearUndo*>(myUndoController->GetCurrentUndoModel());
+  MITK_TEST_CONDITION_REQUIRED(undoModel != nullptr, "checking access to the undo model");
+  undoModel->SetMemoryLimit(500);
+  for (int i = 0; i<4; i++)
+  {
+    auto  doOp = new mitk::TestOperation(mitk::OpTEST, 100);
+    auto undoOp = new mitk::TestOperation(mitk::OpTEST, 100);
+    mitk::OperationEvent *operationEvent = new mitk::OperationEvent(nullptr, doOp, undoOp, "Test");
+    myUndoController->SetOperationEvent(operationEvent);
+    mitk::OperationEvent::IncCurrObjectEventId();
+    mitk::UndoStackItem::ExecuteIncrement();
+  }
+  MITK_TEST_CONDITION_REQUIRED(undoModel->GetMemoryUsage() == 400, "checking reported memory usage of the undo stack");
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4, "checking that the oldest operations are deleted when exceeding the memory limit");
+
+  //lowering the limit removes further items, but the newest one is kept
+  undoModel->SetMemoryLimit(1);
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 2, "checking that the newest operation is kept");
+
+  undoModel->SetMemoryLimit(0);
+  myUndoController->Clear();
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 0, "checking deleting all operations in UndoModel");
+
   //sending two new OperationEvents
   for (int i = 0; i<2; i++)
   {
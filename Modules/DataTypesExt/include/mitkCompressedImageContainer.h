@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageDataItem.h"
 
 #include <itkObject.h>
+#include <itkMultiThreader.h>
 
 #include <vector>
 
@@ -33,7 +34,10 @@ namespace mitk
 /**
   \brief Holds one (compressed) mitk::Image
 
-  Uses zlib to compress the data of an mitk::Image.
+  Uses zlib to compress the data of an mitk::Image. The data is compressed in
+  independent chunks of one slice each, so that a single slice can be restored
+  (see GetSliceData()) without decompressing the rest of the volume. Chunks are
+  compressed and decompressed in parallel.
 
   $Author$
 */
@@ -45,6 +49,19 @@ class MITKDATATYPESEXT_EXPORT CompressedImageContainer : public itk::Object
     itkFactorylessNewMacro(Self)
     itkCloneMacro(Self)
 
+    /**
+     * \brief zlib compression level (1 = fastest ... 9 = smallest), used by subsequent calls of SetImage().
+     * Defaults to the fastest level.
+     */
+    itkSetClampMacro(CompressionLevel, int, 1, 9);
+    itkGetConstMacro(CompressionLevel, int);
+
+    /**
+     * \brief Number of threads used to compress and decompress chunks. Defaults to the ITK global default.
+     */
+    itkSetMacro(NumberOfThreads, unsigned int);
+    itkGetConstMacro(NumberOfThreads, unsigned int);
+
     /**
      * \brief Creates a compressed version of the image.
      *
@@ -62,11 +79,42 @@ class MITKDATATYPESEXT_EXPORT CompressedImageContainer : public itk::Object
      */
     Image::Pointer GetImage();
 
+    /**
+     * \brief Decompresses a single slice into \a buffer, which has to hold GetSliceSizeInBytes() bytes.
+     *
+     * Only the chunk of the requested slice is decompressed.
+     * \return false if there is no such slice or the data could not be decompressed.
+     */
+    bool GetSliceData( unsigned int slice, unsigned int timeStep, void* buffer ) const;
+
+    /**
+     * \brief Size of one uncompressed slice in bytes.
+     */
+    unsigned long GetSliceSizeInBytes() const;
+
+    /**
+     * \brief Memory used by the compressed data of all chunks in bytes.
+     */
+    unsigned long GetCompressedSizeInBytes() const;
+
   protected:
 
     CompressedImageContainer(); // purposely hidden
     virtual ~CompressedImageContainer();
 
+    /// compressed chunk: first = pointer to compressed data; second = size of buffer in bytes
+    typedef std::pair<unsigned char*, unsigned long> ByteBufferType;
+
+    /// Compresses all chunks from (or decompresses them to) the given volumes, one per timestep, in parallel
+    bool ProcessChunks( const std::vector<unsigned char*>& volumes, bool compress );
+
+    static ITK_THREAD_RETURN_TYPE ProcessChunksCallback( void* arg );
+
+    bool CompressChunk( const unsigned char* source, ByteBufferType& chunk ) const;
+    bool UncompressChunk( const ByteBufferType& chunk, unsigned char* dest ) const;
+
+    void ClearByteBuffers();
+
     PixelType *m_PixelType;
 
     unsigned int m_ImageDimension;
@@ -76,10 +124,18 @@ class MITKDATATYPESEXT_EXPORT CompressedImageContainer : public itk::Object
 
     unsigned int m_NumberOfTimeSteps;
 
-    /// one for each timestep. first = pointer to compressed data; second = size of buffer in bytes
-    std::vector< std::pair<unsigned char*, unsigned long> > m_ByteBuffers;
+    unsigned int m_NumberOfSlices;
+
+    unsigned long m_SliceSizeInBytes;
+
+    /// one for each slice of each timestep (index = timestep * m_NumberOfSlices + slice)
+    std::vector< ByteBufferType > m_ByteBuffers;
 
     BaseGeometry::Pointer m_ImageGeometry;
+
+    int m_CompressionLevel;
+
+    unsigned int m_NumberOfThreads;
 };
 
 } // namespace
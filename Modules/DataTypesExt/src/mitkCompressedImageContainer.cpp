@@ -16,30 +16,45 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkCompressedImageContainer.h"
 #include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 
 #include "itk_zlib.h"
 
+#include <algorithm>
 #include <stdlib.h>
 
+namespace
+{
+  struct ChunkProcessingData
+  {
+    mitk::CompressedImageContainer* m_Container;
+    std::vector<unsigned char*> m_Volumes;
+    bool m_Compress;
+    std::vector<char> m_Success; // one for each thread
+  };
+}
+
 mitk::CompressedImageContainer::CompressedImageContainer()
   : m_PixelType(nullptr),
-    m_ImageGeometry (nullptr)
+    m_ImageDimension(0),
+    m_OneTimeStepImageSizeInBytes(0),
+    m_NumberOfTimeSteps(0),
+    m_NumberOfSlices(0),
+    m_SliceSizeInBytes(0),
+    m_ImageGeometry (nullptr),
+    m_CompressionLevel(Z_BEST_SPEED),
+    m_NumberOfThreads(itk::MultiThreader::GetGlobalDefaultNumberOfThreads())
 {
 }
 
 mitk::CompressedImageContainer::~CompressedImageContainer()
 {
-  for (auto iter = m_ByteBuffers.begin();
-       iter != m_ByteBuffers.end();
-       ++iter)
-  {
-    free( iter->first );
-  }
+  this->ClearByteBuffers();
 
   delete m_PixelType;
 }
 
-void mitk::CompressedImageContainer::SetImage( Image* image )
+void mitk::CompressedImageContainer::ClearByteBuffers()
 {
   for (auto iter = m_ByteBuffers.begin();
        iter != m_ByteBuffers.end();
@@ -49,15 +64,22 @@ void mitk::CompressedImageContainer::SetImage( Image* image )
   }
 
   m_ByteBuffers.clear();
+}
+
+void mitk::CompressedImageContainer::SetImage( Image* image )
+{
+  this->ClearByteBuffers();
 
   // Compress diff image using zlib (will be restored on demand)
   // determine memory size occupied by voxel data
   m_ImageDimension = image->GetDimension();
   m_ImageDimensions.clear();
 
+  delete m_PixelType;
   m_PixelType = new mitk::PixelType( image->GetPixelType());
 
   m_OneTimeStepImageSizeInBytes = m_PixelType->GetSize(); // bits per element divided by 8
+  m_SliceSizeInBytes = m_PixelType->GetSize();
   for (unsigned int i = 0; i < m_ImageDimension; ++i)
   {
     unsigned int currentImageDimension = image->GetDimension(i);
@@ -66,64 +88,56 @@ void mitk::CompressedImageContainer::SetImage( Image* image )
     {
       m_OneTimeStepImageSizeInBytes *= currentImageDimension; // only the 3D memory size
     }
+    if (i < 2)
+    {
+      m_SliceSizeInBytes *= currentImageDimension;
+    }
   }
 
   m_ImageGeometry = image->GetGeometry();
 
+  m_NumberOfSlices = m_ImageDimension > 2 ? image->GetDimension(2) : 1;
+
   m_NumberOfTimeSteps = 1;
   if (m_ImageDimension > 3)
   {
     m_NumberOfTimeSteps = image->GetDimension(3);
   }
 
-  for (unsigned int timestep = 0; timestep < m_NumberOfTimeSteps; ++timestep)
+  if (itk::Object::GetDebug())
   {
-    // allocate a buffer as specified by zlib
-    unsigned long bufferSize = m_OneTimeStepImageSizeInBytes + static_cast<unsigned long>(m_OneTimeStepImageSizeInBytes * 0.2) + 12;
-    unsigned char* byteBuffer = (unsigned char*) malloc(bufferSize);
+    MITK_INFO << "Using ZLib version: '" << zlibVersion() << "'" << std::endl
+              << "Attempting to compress " << m_NumberOfTimeSteps << " x " << m_OneTimeStepImageSizeInBytes
+              << " image bytes in chunks of " << m_SliceSizeInBytes << " bytes" << std::endl;
+  }
 
-    if (itk::Object::GetDebug())
-    {
-    // compress image here into a buffer
-      MITK_INFO << "Using ZLib version: '" << zlibVersion() << "'" << std::endl
-               << "Attempting to compress " << m_OneTimeStepImageSizeInBytes << " image bytes into a buffer of size " << bufferSize << std::endl;
-    }
+  // keep read access to all volumes while the chunks are compressed in parallel
+  std::vector<ImageReadAccessor*> accessors;
+  std::vector<unsigned char*> volumes;
+  for (unsigned int timestep = 0; timestep < m_NumberOfTimeSteps; ++timestep)
+  {
+    auto imgAcc = new ImageReadAccessor(image, image->GetVolumeData(timestep));
+    accessors.push_back( imgAcc );
+    volumes.push_back( const_cast<unsigned char*>(static_cast<const unsigned char*>(imgAcc->GetData())) );
+  }
 
-    ImageReadAccessor imgAcc(image, image->GetVolumeData(timestep));
-    ::Bytef* dest(byteBuffer);
-    ::uLongf destLen(bufferSize);
-    ::Bytef* source( (unsigned char*) imgAcc.GetData() );
-    ::uLongf sourceLen( m_OneTimeStepImageSizeInBytes );
-    int zlibRetVal = ::compress(dest, &destLen, source, sourceLen);
-    if (itk::Object::GetDebug())
-    {
-      if (zlibRetVal == Z_OK)
-      {
-        MITK_INFO << "Success, using " << destLen << " bytes of the buffer (ratio " << ((double)destLen / (double)sourceLen) << ")" << std::endl;
-      }
-      else
-      {
-        switch ( zlibRetVal )
-        {
-          case Z_MEM_ERROR:
-            MITK_ERROR << "not enough memory" << std::endl;
-            break;
-          case Z_BUF_ERROR:
-            MITK_ERROR << "output buffer too small" << std::endl;
-            break;
-          default:
-            MITK_ERROR << "other, unspecified error" << std::endl;
-            break;
-        }
-      }
-    }
+  m_ByteBuffers.resize( m_NumberOfTimeSteps * m_NumberOfSlices, ByteBufferType(nullptr, 0) );
+  bool success = this->ProcessChunks( volumes, true );
 
-    // only use the neccessary amount of memory, realloc the buffer!
-    byteBuffer = (unsigned char*) realloc( byteBuffer, destLen );
-    bufferSize = destLen;
-    //MITK_INFO << "Using " << bufferSize << " bytes to store compressed image (" << destLen << " needed)" << std::endl;
+  for (auto iter = accessors.begin(); iter != accessors.end(); ++iter)
+  {
+    delete *iter;
+  }
 
-    m_ByteBuffers.push_back( std::pair<unsigned char*, unsigned long>( byteBuffer, bufferSize ) );
+  if (!success)
+  {
+    MITK_ERROR << "Could not compress image" << std::endl;
+    this->ClearByteBuffers();
+  }
+  else if (itk::Object::GetDebug())
+  {
+    MITK_INFO << "Success, using " << this->GetCompressedSizeInBytes() << " bytes (ratio "
+              << ((double)this->GetCompressedSizeInBytes() / (double)(m_OneTimeStepImageSizeInBytes * m_NumberOfTimeSteps)) << ")" << std::endl;
   }
 }
 
@@ -139,41 +153,18 @@ mitk::Image::Pointer mitk::CompressedImageContainer::GetImage()
 
   image->Initialize( *m_PixelType, m_ImageDimension, dims ); // this IS needed, right ?? But it does allocate memory -> does create one big lump of memory (also in windows)
 
-  unsigned int timeStep(0);
-  for (auto iter = m_ByteBuffers.begin();
-       iter != m_ByteBuffers.end();
-       ++iter, ++timeStep)
-  {
-    ImageReadAccessor imgAcc(image, image->GetVolumeData(timeStep));
-    ::Bytef* dest( (unsigned char*) imgAcc.GetData() );
-    ::uLongf destLen(m_OneTimeStepImageSizeInBytes);
-    ::Bytef* source( iter->first );
-    ::uLongf sourceLen( iter->second );
-    int zlibRetVal = ::uncompress(dest, &destLen, source, sourceLen);
-    if (itk::Object::GetDebug())
+  {
+    ImageWriteAccessor imgAcc(image);
+    std::vector<unsigned char*> volumes;
+    for (unsigned int timeStep = 0; timeStep < m_NumberOfTimeSteps; ++timeStep)
+    {
+      volumes.push_back( static_cast<unsigned char*>(imgAcc.GetData()) + timeStep * m_OneTimeStepImageSizeInBytes );
+    }
+
+    if (!this->ProcessChunks( volumes, false ))
     {
-      if (zlibRetVal == Z_OK)
-      {
-        MITK_INFO << "Success, destLen now " << destLen << " bytes" << std::endl;
-      }
-      else
-      {
-        switch ( zlibRetVal )
-        {
-          case Z_DATA_ERROR:
-            MITK_ERROR << "compressed data corrupted" << std::endl;
-            break;
-          case Z_MEM_ERROR:
-            MITK_ERROR << "not enough memory" << std::endl;
-            break;
-          case Z_BUF_ERROR:
-            MITK_ERROR << "output buffer too small" << std::endl;
-            break;
-          default:
-            MITK_ERROR << "other, unspecified error" << std::endl;
-            break;
-        }
-      }
+      MITK_ERROR << "Could not uncompress image" << std::endl;
+      return nullptr;
     }
   }
 
@@ -182,3 +173,135 @@ mitk::Image::Pointer mitk::CompressedImageContainer::GetImage()
 
   return image;
 }
+
+bool mitk::CompressedImageContainer::GetSliceData( unsigned int slice, unsigned int timeStep, void* buffer ) const
+{
+  if (slice >= m_NumberOfSlices || timeStep >= m_NumberOfTimeSteps || m_ByteBuffers.empty())
+    return false;
+
+  return this->UncompressChunk( m_ByteBuffers[timeStep * m_NumberOfSlices + slice], static_cast<unsigned char*>(buffer) );
+}
+
+unsigned long mitk::CompressedImageContainer::GetSliceSizeInBytes() const
+{
+  return m_SliceSizeInBytes;
+}
+
+unsigned long mitk::CompressedImageContainer::GetCompressedSizeInBytes() const
+{
+  unsigned long size = 0;
+  for (auto iter = m_ByteBuffers.begin(); iter != m_ByteBuffers.end(); ++iter)
+  {
+    size += iter->second;
+  }
+  return size;
+}
+
+bool mitk::CompressedImageContainer::ProcessChunks( const std::vector<unsigned char*>& volumes, bool compress )
+{
+  ChunkProcessingData data;
+  data.m_Container = this;
+  data.m_Volumes = volumes;
+  data.m_Compress = compress;
+
+  unsigned int numberOfThreads = std::max(1u, std::min<unsigned int>(m_NumberOfThreads, m_ByteBuffers.size()));
+  data.m_Success.resize(numberOfThreads, 1);
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ProcessChunksCallback, &data);
+  threader->SingleMethodExecute();
+
+  for (auto iter = data.m_Success.begin(); iter != data.m_Success.end(); ++iter)
+  {
+    if (!*iter)
+      return false;
+  }
+  return true;
+}
+
+ITK_THREAD_RETURN_TYPE mitk::CompressedImageContainer::ProcessChunksCallback( void* arg )
+{
+  typedef itk::MultiThreader::ThreadInfoStruct  ThreadInfoType;
+  ThreadInfoType * infoStruct = static_cast< ThreadInfoType * >( arg );
+  ChunkProcessingData* data = static_cast< ChunkProcessingData* >( infoStruct->UserData );
+  CompressedImageContainer* self = data->m_Container;
+
+  // chunks are interleaved between threads, every thread writes distinct chunks only
+  const unsigned int numberOfChunks = self->m_ByteBuffers.size();
+  for (unsigned int chunk = infoStruct->ThreadID; chunk < numberOfChunks; chunk += infoStruct->NumberOfThreads)
+  {
+    unsigned char* sliceData = data->m_Volumes[chunk / self->m_NumberOfSlices] + (chunk % self->m_NumberOfSlices) * self->m_SliceSizeInBytes;
+    bool success = data->m_Compress
+      ? self->CompressChunk( sliceData, self->m_ByteBuffers[chunk] )
+      : self->UncompressChunk( self->m_ByteBuffers[chunk], sliceData );
+    if (!success)
+    {
+      data->m_Success[infoStruct->ThreadID] = 0;
+    }
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool mitk::CompressedImageContainer::CompressChunk( const unsigned char* source, ByteBufferType& chunk ) const
+{
+  // allocate a buffer as specified by zlib
+  ::uLongf destLen( ::compressBound( m_SliceSizeInBytes ) );
+  unsigned char* byteBuffer = (unsigned char*) malloc(destLen);
+  if (byteBuffer == nullptr)
+  {
+    MITK_ERROR << "not enough memory" << std::endl;
+    return false;
+  }
+
+  int zlibRetVal = ::compress2(byteBuffer, &destLen, source, m_SliceSizeInBytes, m_CompressionLevel);
+  if (zlibRetVal != Z_OK)
+  {
+    switch ( zlibRetVal )
+    {
+      case Z_MEM_ERROR:
+        MITK_ERROR << "not enough memory" << std::endl;
+        break;
+      case Z_BUF_ERROR:
+        MITK_ERROR << "output buffer too small" << std::endl;
+        break;
+      default:
+        MITK_ERROR << "other, unspecified error" << std::endl;
+        break;
+    }
+    free( byteBuffer );
+    return false;
+  }
+
+  // only use the neccessary amount of memory, realloc the buffer!
+  chunk.first = (unsigned char*) realloc( byteBuffer, destLen );
+  chunk.second = destLen;
+  return true;
+}
+
+bool mitk::CompressedImageContainer::UncompressChunk( const ByteBufferType& chunk, unsigned char* dest ) const
+{
+  ::uLongf destLen(m_SliceSizeInBytes);
+  int zlibRetVal = ::uncompress(dest, &destLen, chunk.first, chunk.second);
+  if (zlibRetVal != Z_OK)
+  {
+    switch ( zlibRetVal )
+    {
+      case Z_DATA_ERROR:
+        MITK_ERROR << "compressed data corrupted" << std::endl;
+        break;
+      case Z_MEM_ERROR:
+        MITK_ERROR << "not enough memory" << std::endl;
+        break;
+      case Z_BUF_ERROR:
+        MITK_ERROR << "output buffer too small" << std::endl;
+        break;
+      default:
+        MITK_ERROR << "other, unspecified error" << std::endl;
+        break;
+    }
+    return false;
+  }
+  return destLen == m_SliceSizeInBytes;
+}
@@ -20,6 +20,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageReadAccessor.h"
 #include "mitkIOUtil.h"
 
+#include <algorithm>
+#include <vector>
+
 class mitkCompressedImageContainerTestClass
 {
   public:
@@ -108,6 +111,42 @@ static void Test( mitk::CompressedImageContainer* container, mitk::Image* image,
     }
   }
 
+  // check random access to single slices
+  unsigned int numberOfSlices = image->GetDimension() > 2 ? image->GetDimension(2) : 1;
+  unsigned long sliceSizeInBytes = container->GetSliceSizeInBytes();
+  if (sliceSizeInBytes * numberOfSlices != oneTimeStepSizeInBytes)
+  {
+    ++numberFailed;
+    std::cerr << "  (EE) Slice size " << sliceSizeInBytes << " does not match image size." << std::endl;
+    return;
+  }
+
+  std::vector<unsigned char> sliceBuffer(sliceSizeInBytes);
+  unsigned int lastTimeStep = numberOfTimeSteps - 1;
+  unsigned int slices[] = { 0, numberOfSlices / 2, numberOfSlices - 1 };
+  mitk::ImageReadAccessor origImgAcc(image, image->GetVolumeData(lastTimeStep));
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (!container->GetSliceData(slices[i], lastTimeStep, &sliceBuffer[0]))
+    {
+      ++numberFailed;
+      std::cerr << "  (EE) Could not uncompress slice " << slices[i] << " of timestep " << lastTimeStep << std::endl;
+      continue;
+    }
+
+    const unsigned char* originalSlice = static_cast<const unsigned char*>(origImgAcc.GetData()) + slices[i] * sliceSizeInBytes;
+    if (!std::equal(sliceBuffer.begin(), sliceBuffer.end(), originalSlice))
+    {
+      ++numberFailed;
+      std::cerr << "  (EE) Slice " << slices[i] << " of timestep " << lastTimeStep << " not identical after uncompression." << std::endl;
+    }
+  }
+
+  if (container->GetSliceData(numberOfSlices, lastTimeStep, &sliceBuffer[0]))
+  {
+    ++numberFailed;
+    std::cerr << "  (EE) Invalid slice index was accepted." << std::endl;
+  }
 }
 
 };
@@ -98,7 +98,7 @@ void mitk::FiberBundleMapper2D::Update(mitk::BaseRenderer * renderer)
             fiberBundle->RequestUpdate2D();
         }
 
-        if ( localStorage->m_LastUpdateTime<renderer->GetCurrentWorldPlaneGeometryUpdateTime() || localStorage->m_LastUpdateTime<fiberBundle->GetUpdateTime2D() )
+        if ( localStorage->m_LastUpdateTime<renderer->GetCurrentWorldPlaneGeometryUpdateTime() || localStorage->m_LastUpdateTime<fiberBundle->GetUpdateTime2D() || localStorage->m_SliceThickness!=thickness )
         {
             this->UpdateShaderParameter(renderer);
             this->GenerateDataForRenderer( renderer );
@@ -141,11 +141,21 @@ void mitk::FiberBundleMapper2D::GenerateDataForRenderer(mitk::BaseRenderer *rend
     if ( node == NULL )
         return;
 
-    vtkSmartPointer<vtkPolyData> fiberPolyData = fiberBundle->GetFiberPolyData();
-    if (fiberPolyData == NULL)
+    if (fiberBundle->GetFiberPolyData() == NULL)
         return;
 
-    fiberPolyData->GetPointData()->AddArray(fiberBundle->GetFiberColors());
+    float thickness = 2.0;
+    node->GetPropertyValue("Fiber2DSliceThickness",thickness);
+
+    // only the fiber segments near the slice are uploaded, the shader still clips them exactly and fades them.
+    // the slab uses the same (not normalized) plane equation as the shader, see UpdateShaderParameter
+    mitk::PlaneGeometry::ConstPointer planeGeo = renderer->GetSliceNavigationController()->GetCurrentPlaneGeometry();
+    double normal[3] = {planeGeo->GetNormal()[0], planeGeo->GetNormal()[1], planeGeo->GetNormal()[2]};
+    double offset = planeGeo->GetOrigin()[0]*normal[0] + planeGeo->GetOrigin()[1]*normal[1] + planeGeo->GetOrigin()[2]*normal[2];
+    localStorage->m_SlicedResult = fiberBundle->GeneratePolyDataInSlab(normal, offset, 1.01*thickness + mitk::eps);
+    localStorage->m_SliceThickness = thickness;
+    vtkSmartPointer<vtkPolyData> fiberPolyData = localStorage->m_SlicedResult;
+
     localStorage->m_FiberMapper->ScalarVisibilityOn();
     localStorage->m_FiberMapper->SetScalarModeToUsePointFieldData();
     localStorage->m_FiberMapper->SetLookupTable(m_lut);  //apply the properties after the slice was set
@@ -195,4 +205,5 @@ mitk::FiberBundleMapper2D::FBXLocalStorage::FBXLocalStorage()
 {
     m_PointActor = vtkSmartPointer<vtkActor>::New();
     m_FiberMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    m_SliceThickness = -1;
 }
@@ -71,10 +71,13 @@ public:
         /** \brief Point Mapper of a 2D render window. */
         vtkSmartPointer<vtkPolyDataMapper> m_FiberMapper;
         vtkSmartPointer<vtkPlane> m_SlicingPlane;  //needed later when optimized 2D mapper
-        vtkSmartPointer<vtkPolyData> m_SlicedResult; //might be depricated in optimized 2D mapper
+        /** \brief Fiber segments in the slab around the current slice, the shader clips them exactly. */
+        vtkSmartPointer<vtkPolyData> m_SlicedResult;
 
         /** \brief Timestamp of last update of stored data. */
         itk::TimeStamp m_LastUpdateTime;
+        /** \brief Slice thickness m_SlicedResult was generated for. */
+        float m_SliceThickness;
         /** \brief Constructor of the local storage. Do as much actions as possible in here to avoid double executions. */
         FBXLocalStorage(); //if u copy&paste from this 2Dmapper, be aware that the implementation of this constructor is in the cpp file
 
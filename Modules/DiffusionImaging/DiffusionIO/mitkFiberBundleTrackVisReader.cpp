@@ -37,6 +37,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 mitk::FiberBundleTrackVisReader::FiberBundleTrackVisReader()
     : mitk::AbstractFileReader( mitk::DiffusionIOMimeTypes::FIBERBUNDLE_TRK_MIMETYPE_NAME(), "TrackVis Fiber Bundle Reader" )
 {
+    Options defaultOptions;
+    defaultOptions["Read every k-th fiber"] = 1;
+    defaultOptions["Minimum fiber length (mm)"] = 0.0f;
+    defaultOptions["Maximum fiber length (mm, 0: no limit)"] = 0.0f;
+    this->SetDefaultOptions(defaultOptions);
     m_ServiceReg = this->RegisterService();
 }
 
@@ -67,11 +72,21 @@ std::vector<itk::SmartPointer<mitk::BaseData> > mitk::FiberBundleTrackVisReader:
 
         if (ext==".trk")
         {
-            FiberBundle::Pointer image = FiberBundle::New();
+            Options options = this->GetOptions();
+            int everyKthFiber = us::any_cast<int>(options["Read every k-th fiber"]);
+            float minFiberLength = us::any_cast<float>(options["Minimum fiber length (mm)"]);
+            float maxFiberLength = us::any_cast<float>(options["Maximum fiber length (mm, 0: no limit)"]);
+
             TrackVisFiberReader reader;
             reader.open(this->GetInputLocation().c_str());
-            reader.read(image.GetPointer());
+            FiberBundle::Pointer image = reader.read(everyKthFiber, minFiberLength, maxFiberLength);
+            if (image.IsNull())
+            {
+                setlocale(LC_ALL, currLocale.c_str());
+                mitkThrow() << "Invalid TrackVis file: " << filename;
+            }
             result.push_back(image.GetPointer());
+            setlocale(LC_ALL, currLocale.c_str());
             return result;
         }
 
@@ -93,6 +93,7 @@ void mitk::FiberBundleTrackVisWriter::Write()
         trk.create(filename, input.GetPointer());
         trk.writeHdr();
         trk.append(input.GetPointer());
+        trk.updateTotal(input->GetNumFibers());
 
         setlocale(LC_ALL, currLocale.c_str());
         MITK_INFO << "Fiber bundle written";
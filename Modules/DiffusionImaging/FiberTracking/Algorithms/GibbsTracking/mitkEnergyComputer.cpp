@@ -17,6 +17,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkEnergyComputer.h"
 #include <vnl/vnl_copy.h>
 #include <itkNumericTraits.h>
+#include <algorithm>
 
 using namespace mitk;
 
@@ -64,11 +65,14 @@ EnergyComputer::EnergyComputer(ItkFloatImageType* mask, ParticleGrid* particleGr
     int totsz = m_Size[0]*m_Size[1]*m_Size[2];
     m_CumulatedSpatialProbability.resize(totsz + 1, 0.0);
     m_ActiveIndices.resize(totsz, 0);
+    m_SliceOffsets.resize(m_Size[0]+1, 0);
 
     // calculate active voxels and cumulate probabilities
     m_NumActiveVoxels = 0;
     m_CumulatedSpatialProbability[0] = 0;
     for (int x = 0; x < m_Size[0];x++)
+    {
+        m_SliceOffsets[x] = m_NumActiveVoxels;
         for (int y = 0; y < m_Size[1];y++)
             for (int z = 0; z < m_Size[2];z++)
             {
@@ -82,7 +86,9 @@ EnergyComputer::EnergyComputer(ItkFloatImageType* mask, ParticleGrid* particleGr
                     m_NumActiveVoxels++;
                 }
             }
-    for (int k = 0; k < m_NumActiveVoxels; k++)
+    }
+    m_SliceOffsets[m_Size[0]] = m_NumActiveVoxels;
+    for (int k = 0; k <= m_NumActiveVoxels; k++)
         m_CumulatedSpatialProbability[k] /= m_CumulatedSpatialProbability[m_NumActiveVoxels];
 
     std::cout << "EnergyComputer: " << m_NumActiveVoxels << " active voxels found" << std::endl;
@@ -132,6 +138,46 @@ void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
     R[2] = m_Spacing[2]*((float)(m_ActiveIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
 }
 
+// draw random position from the active voxels of the image slices overlapping [xMin,xMax)
+bool EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R, float xMin, float xMax)
+{
+    int firstSlice = std::max(0, (int)floor(xMin/m_Spacing[0]));
+    int endSlice = std::min((int)m_Size[0], (int)ceil(xMax/m_Spacing[0]));
+    if (firstSlice >= endSlice || m_SliceOffsets[firstSlice] == m_SliceOffsets[endSlice])
+        return false;
+
+    float* cumulated = &m_CumulatedSpatialProbability[0];
+    int first = m_SliceOffsets[firstSlice];
+    int end = m_SliceOffsets[endSlice];
+    for (int i = 0; i < 1000; i++)    // reject positions in the parts of the border slices outside of [xMin,xMax)
+    {
+        float r = cumulated[first] + m_RandGen->GetVariate()*(cumulated[end]-cumulated[first]);
+        int k = std::upper_bound(cumulated+first+1, cumulated+end+1, r) - (cumulated+1);
+        if (k >= end)
+            k = end-1;
+        R[0] = m_Spacing[0]*((float)(m_ActiveIndices[k] % m_Size[0])  + m_RandGen->GetVariate());
+        R[1] = m_Spacing[1]*((float)((m_ActiveIndices[k]/m_Size[0]) % m_Size[1])  + m_RandGen->GetVariate());
+        R[2] = m_Spacing[2]*((float)(m_ActiveIndices[k]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
+        if (R[0] >= xMin && R[0] < xMax)
+            return true;
+    }
+    return false;
+}
+
+float EnergyComputer::GetSpatialProbability(float xMin, float xMax)
+{
+    int firstSlice = std::max(0, (int)floor(xMin/m_Spacing[0]));
+    int endSlice = std::min((int)m_Size[0], (int)ceil(xMax/m_Spacing[0]));
+
+    float probability = 0;
+    for (int x = firstSlice; x < endSlice; x++)
+    {
+        float overlap = std::min(xMax, (x+1)*m_Spacing[0]) - std::max(xMin, x*m_Spacing[0]);
+        probability += (m_CumulatedSpatialProbability[m_SliceOffsets[x+1]]-m_CumulatedSpatialProbability[m_SliceOffsets[x]])*overlap/m_Spacing[0];
+    }
+    return probability;
+}
+
 // return spatial probability of position
 float EnergyComputer::SpatProb(vnl_vector_fixed<float, 3> pos)
 {
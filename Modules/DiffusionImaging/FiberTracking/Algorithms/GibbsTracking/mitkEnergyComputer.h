@@ -44,6 +44,12 @@ public:
     // get random position inside mask
     void DrawRandomPosition(vnl_vector_fixed<float, 3>& R);
 
+    // get random position inside mask with xMin <= R[0] < xMax, false if there is none
+    bool DrawRandomPosition(vnl_vector_fixed<float, 3>& R, float xMin, float xMax);
+
+    // share of the spatial probability with xMin <= x < xMax
+    float GetSpatialProbability(float xMin, float xMax);
+
     // external energy calculation
     virtual float ComputeExternalEnergy(vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<float, 3>& N, Particle* dp) =0;
 
@@ -65,6 +71,8 @@ protected:
     vnl_vector_fixed<float, 3>      m_Spacing;
     std::vector< float >            m_CumulatedSpatialProbability;
     std::vector< int >              m_ActiveIndices;    // indices inside mask
+    std::vector< int >              m_SliceOffsets;     // active voxels of image slice x are m_ActiveIndices[m_SliceOffsets[x]] to m_ActiveIndices[m_SliceOffsets[x+1]-1]
+    ParticleGrid::NeighborTracker   m_NeighborTracker;
 
     bool    m_UseTrilinearInterpolation;    // is deactivated if less than 3 image slices are available
     int     m_NumActiveVoxels;              // voxels inside mask
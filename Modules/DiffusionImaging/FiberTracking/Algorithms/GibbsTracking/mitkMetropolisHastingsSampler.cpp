@@ -29,7 +29,13 @@ MetropolisHastingsSampler::MetropolisHastingsSampler(ParticleGrid* grid, EnergyC
     , m_DelProb(0.1)
     , m_ChempotParticle(0.0)
     , m_AcceptedProposals(0)
+    , m_UseSlab(false)
 {
+    for (int i = 0; i < NUM_PROPOSAL_TYPES; i++)
+    {
+        m_NumProposals[i] = 0;
+        m_NumAcceptedProposals[i] = 0;
+    }
     m_RandGen = randGen;
     m_ParticleGrid = grid;
     m_EnergyComputer = enComp;
@@ -87,6 +93,49 @@ void MetropolisHastingsSampler::SetTemperature(float val)
     m_Density = exp(-m_ChempotParticle/m_InTemp);
 }
 
+// restrict proposals to a slab of grid cells along x
+void MetropolisHastingsSampler::SetSlab(int firstCellX, int endCellX, float spatialProbability, int firstSlot, int endSlot)
+{
+    m_UseSlab = true;
+    m_SlabFirstCellX = firstCellX;
+    m_SlabEndCellX = endCellX;
+    m_SlabMinX = firstCellX*m_ParticleGrid->GetCellSize();
+    m_SlabMaxX = endCellX*m_ParticleGrid->GetCellSize();
+    m_SlabProbability = spatialProbability;
+    m_NextSlot = firstSlot;
+    m_EndSlot = endSlot;
+    m_ParticleGrid->GetParticlesInSlab(firstCellX, endCellX, m_SlabParticles);
+}
+
+void MetropolisHastingsSampler::ClearSlab()
+{
+    m_UseSlab = false;
+    m_SlabParticles.clear();
+}
+
+int MetropolisHastingsSampler::GetNumParticles()
+{
+    if (m_UseSlab)
+        return m_SlabParticles.size();
+    return m_ParticleGrid->m_NumParticles;
+}
+
+bool MetropolisHastingsSampler::IsInSlab(Particle* p)
+{
+    if (!m_UseSlab)
+        return true;
+    int x = m_ParticleGrid->GetCellX(p);
+    return x >= m_SlabFirstCellX && x < m_SlabEndCellX;
+}
+
+bool MetropolisHastingsSampler::IsInSlab(vnl_vector_fixed<float, 3>& R)
+{
+    if (!m_UseSlab)
+        return true;
+    int x = m_ParticleGrid->GetCellX(R);
+    return x >= m_SlabFirstCellX && x < m_SlabEndCellX;
+}
+
 // add small random number drawn from gaussian to each vector element
 void MetropolisHastingsSampler::DistortVector(float sigma, vnl_vector_fixed<float, 3>& vec)
 {
@@ -115,27 +164,50 @@ void MetropolisHastingsSampler::MakeProposal()
     if (randnum < m_BirthProb)
     {
         m_BirthTime.Start();
+        m_NumProposals[BIRTH_PROPOSAL]++;
         vnl_vector_fixed<float, 3> R;
-        m_EnergyComputer->DrawRandomPosition(R);
-        vnl_vector_fixed<float, 3> N = GetRandomDirection();
-        Particle prop;
-        prop.GetPos() = R;
-        prop.GetDir() = N;
+        bool inside = true;
+        if (m_UseSlab)
+            inside = m_EnergyComputer->DrawRandomPosition(R, m_SlabMinX, m_SlabMaxX) && IsInSlab(R) && m_NextSlot < m_EndSlot;
+        else
+            m_EnergyComputer->DrawRandomPosition(R);
 
-        float prob =  m_Density * m_DeathProb /((m_BirthProb)*(m_ParticleGrid->m_NumParticles+1));
+        if (inside)
+        {
+            vnl_vector_fixed<float, 3> N = GetRandomDirection();
+            Particle prop;
+            prop.GetPos() = R;
+            prop.GetDir() = N;
 
-        float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,nullptr);
-        float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
-        prob *= exp((in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
+            float prob =  m_Density * m_DeathProb /((m_BirthProb)*(GetNumParticles()+1));
+            if (m_UseSlab)
+                prob *= m_SlabProbability;  // the position was drawn from the slab only
 
-        if (prob > 1 || m_RandGen->GetVariate() < prob)
-        {
-            Particle *p = m_ParticleGrid->NewParticle(R);
-            if (p!=nullptr)
+            float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,nullptr);
+            float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
+            prob *= exp((in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
+
+            if (prob > 1 || m_RandGen->GetVariate() < prob)
             {
-                p->GetPos() = R;
-                p->GetDir() = N;
-                m_AcceptedProposals++;
+                Particle *p = nullptr;
+                if (m_UseSlab)
+                {
+                    p = m_ParticleGrid->NewParticle(R, m_NextSlot);
+                    if (p!=nullptr)
+                    {
+                        m_NextSlot++;
+                        m_SlabParticles.push_back(p->ID);
+                    }
+                }
+                else
+                    p = m_ParticleGrid->NewParticle(R);
+                if (p!=nullptr)
+                {
+                    p->GetPos() = R;
+                    p->GetDir() = N;
+                    m_AcceptedProposals++;
+                    m_NumAcceptedProposals[BIRTH_PROPOSAL]++;
+                }
             }
         }
         m_BirthTime.Stop();
@@ -144,21 +216,34 @@ void MetropolisHastingsSampler::MakeProposal()
     else if (randnum < m_BirthProb+m_DeathProb)
     {
         m_DeathTime.Start();
-        if (m_ParticleGrid->m_NumParticles > 0)
+        m_NumProposals[DEATH_PROPOSAL]++;
+        int numParticles = GetNumParticles();
+        if (numParticles > 0)
         {
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
-            Particle *dp = m_ParticleGrid->GetParticle(pnum);
+            int pnum = m_RandGen->GetIntegerVariate()%numParticles;
+            int id = m_UseSlab ? m_SlabParticles[pnum] : pnum;
+            Particle *dp = m_ParticleGrid->GetParticle(id);
             if (dp->pID == -1 && dp->mID == -1)
             {
                 float ex_energy = m_EnergyComputer->ComputeExternalEnergy(dp->GetPos(),dp->GetDir(),dp);
                 float in_energy = m_EnergyComputer->ComputeInternalEnergy(dp);
 
-                float prob = m_ParticleGrid->m_NumParticles * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                float prob = numParticles * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                if (m_UseSlab)
+                    prob /= m_SlabProbability;
                 prob *= exp(-(in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
                 if (prob > 1 || m_RandGen->GetVariate() < prob)
                 {
-                    m_ParticleGrid->RemoveParticle(pnum);
+                    if (m_UseSlab)
+                    {
+                        m_ParticleGrid->RemoveParticleFromGrid(id);
+                        m_SlabParticles[pnum] = m_SlabParticles.back();
+                        m_SlabParticles.pop_back();
+                    }
+                    else
+                        m_ParticleGrid->RemoveParticle(pnum);
                     m_AcceptedProposals++;
+                    m_NumAcceptedProposals[DEATH_PROPOSAL]++;
                 }
             }
         }
@@ -167,10 +252,14 @@ void MetropolisHastingsSampler::MakeProposal()
     // Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        m_NumProposals[SHIFT_PROPOSAL]++;
+        int numParticles = GetNumParticles();
+        if (numParticles > 0)
         {
             m_ShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = m_RandGen->GetIntegerVariate()%numParticles;
+            if (m_UseSlab)
+                pnum = m_SlabParticles[pnum];
             Particle *p =  m_ParticleGrid->GetParticle(pnum);
             Particle prop_p = *p;
 
@@ -178,24 +267,27 @@ void MetropolisHastingsSampler::MakeProposal()
             DistortVector(m_Sigma/(2*m_ParticleLength), prop_p.GetDir());
             prop_p.GetDir().normalize();
 
-
-            float ex_energy = m_EnergyComputer->ComputeExternalEnergy(prop_p.GetPos(),prop_p.GetDir(),p)
-                    - m_EnergyComputer->ComputeExternalEnergy(p->GetPos(),p->GetDir(),p);
-            float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop_p) - m_EnergyComputer->ComputeInternalEnergy(p);
-
-            float prob = exp(ex_energy/m_ExTemp+in_energy/m_InTemp);
-            if (m_RandGen->GetVariate() < prob)
+            if (IsInSlab(prop_p.GetPos()))
             {
-                vnl_vector_fixed<float, 3> Rtmp = p->GetPos();
-                vnl_vector_fixed<float, 3> Ntmp = p->GetDir();
-                p->GetPos() = prop_p.GetPos();
-                p->GetDir() = prop_p.GetDir();
-                if (!m_ParticleGrid->TryUpdateGrid(pnum))
+                float ex_energy = m_EnergyComputer->ComputeExternalEnergy(prop_p.GetPos(),prop_p.GetDir(),p)
+                        - m_EnergyComputer->ComputeExternalEnergy(p->GetPos(),p->GetDir(),p);
+                float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop_p) - m_EnergyComputer->ComputeInternalEnergy(p);
+
+                float prob = exp(ex_energy/m_ExTemp+in_energy/m_InTemp);
+                if (m_RandGen->GetVariate() < prob)
                 {
-                    p->GetPos() = Rtmp;
-                    p->GetDir() = Ntmp;
+                    vnl_vector_fixed<float, 3> Rtmp = p->GetPos();
+                    vnl_vector_fixed<float, 3> Ntmp = p->GetDir();
+                    p->GetPos() = prop_p.GetPos();
+                    p->GetDir() = prop_p.GetDir();
+                    if (!m_ParticleGrid->TryUpdateGrid(pnum, !m_UseSlab))
+                    {
+                        p->GetPos() = Rtmp;
+                        p->GetDir() = Ntmp;
+                    }
+                    m_AcceptedProposals++;
+                    m_NumAcceptedProposals[SHIFT_PROPOSAL]++;
                 }
-                m_AcceptedProposals++;
             }
             m_ShiftTime.Stop();
         }
@@ -203,10 +295,14 @@ void MetropolisHastingsSampler::MakeProposal()
     // Optimal Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb+m_OptShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        m_NumProposals[OPTIMAL_SHIFT_PROPOSAL]++;
+        int numParticles = GetNumParticles();
+        if (numParticles > 0)
         {
             m_OptShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = m_RandGen->GetIntegerVariate()%numParticles;
+            if (m_UseSlab)
+                pnum = m_SlabParticles[pnum];
             Particle *p =  m_ParticleGrid->GetParticle(pnum);
 
             bool no_proposal = false;
@@ -239,7 +335,7 @@ void MetropolisHastingsSampler::MakeProposal()
             else
                 no_proposal = true;
 
-            if (!no_proposal)
+            if (!no_proposal && IsInSlab(prop_p.GetPos()))
             {
                 float cos = dot_product(prop_p.GetDir(), p->GetDir());
                 float p_rev = exp(-((prop_p.GetPos()-p->GetPos()).squared_magnitude() + (1-cos*cos))*m_Gamma)/m_Z;
@@ -256,12 +352,13 @@ void MetropolisHastingsSampler::MakeProposal()
                     vnl_vector_fixed<float, 3> Ntmp = p->GetDir();
                     p->GetPos() = prop_p.GetPos();
                     p->GetDir() = prop_p.GetDir();
-                    if (!m_ParticleGrid->TryUpdateGrid(pnum))
+                    if (!m_ParticleGrid->TryUpdateGrid(pnum, !m_UseSlab))
                     {
                         p->GetPos() = Rtmp;
                         p->GetDir() = Ntmp;
                     }
                     m_AcceptedProposals++;
+                    m_NumAcceptedProposals[OPTIMAL_SHIFT_PROPOSAL]++;
                 }
             }
             m_OptShiftTime.Stop();
@@ -270,10 +367,14 @@ void MetropolisHastingsSampler::MakeProposal()
     // Connection Proposal
     else
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        m_NumProposals[CONNECTION_PROPOSAL]++;
+        int numParticles = GetNumParticles();
+        if (numParticles > 0)
         {
             m_ConnectionTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
+            int pnum = m_RandGen->GetIntegerVariate()%numParticles;
+            if (m_UseSlab)
+                pnum = m_SlabParticles[pnum];
             Particle *p = m_ParticleGrid->GetParticle(pnum);
 
             EndPoint P;
@@ -293,6 +394,7 @@ void MetropolisHastingsSampler::MakeProposal()
                 {
                     ImplementTrack(m_ProposalTrack);    // accept proposed tract
                     m_AcceptedProposals++;
+                    m_NumAcceptedProposals[CONNECTION_PROPOSAL]++;
                 }
                 else
                 {
@@ -331,7 +433,13 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
             if (Current.p->pID != -1)
             {
                 Next.p = m_ParticleGrid->GetParticle(Current.p->pID);
+                if (!IsInSlab(Next.p))
+                {
+                    AccumProb = 0;  // track leaves the slab, restore and reject
+                    break;
+                }
                 Current.p->pID = -1;
+#pragma omp atomic
                 m_ParticleGrid->m_NumConnections--;
             }
         }
@@ -340,7 +448,13 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
             if (Current.p->mID != -1)
             {
                 Next.p = m_ParticleGrid->GetParticle(Current.p->mID);
+                if (!IsInSlab(Next.p))
+                {
+                    AccumProb = 0;  // track leaves the slab, restore and reject
+                    break;
+                }
                 Current.p->mID = -1;
+#pragma omp atomic
                 m_ParticleGrid->m_NumConnections--;
             }
         }
@@ -449,16 +563,16 @@ void MetropolisHastingsSampler::ComputeEndPointProposalDistribution(EndPoint P)
 
     float dist,dot;
     vnl_vector_fixed<float, 3> R = p->GetPos() + (p->GetDir() * (ep*m_ParticleLength) );
-    m_ParticleGrid->ComputeNeighbors(R);
+    m_ParticleGrid->ComputeNeighbors(R, m_NeighborTracker);
     m_SimpSamp.clear();
 
     m_SimpSamp.add(m_StopProb,EndPoint(nullptr,0));
 
     for (;;)
     {
-        Particle *p2 =  m_ParticleGrid->GetNextNeighbor();
+        Particle *p2 =  m_ParticleGrid->GetNextNeighbor(m_NeighborTracker);
         if (p2 == nullptr) break;
-        if (p!=p2 && p2->label == 0)
+        if (p!=p2 && p2->label == 0 && IsInSlab(p2))
         {
             if (p2->mID == -1)
             {
@@ -496,4 +610,24 @@ int MetropolisHastingsSampler::GetNumAcceptedProposals()
     return m_AcceptedProposals;
 }
 
+unsigned long MetropolisHastingsSampler::GetNumProposals(ProposalType type)
+{
+    return m_NumProposals[type];
+}
+
+unsigned long MetropolisHastingsSampler::GetNumAcceptedProposals(ProposalType type)
+{
+    return m_NumAcceptedProposals[type];
+}
+
+EnergyComputer* MetropolisHastingsSampler::GetEnergyComputer()
+{
+    return m_EnergyComputer;
+}
+
+MetropolisHastingsSampler::ItkRandGenType* MetropolisHastingsSampler::GetRandGen()
+{
+    return m_RandGen;
+}
+
 
@@ -35,7 +35,13 @@ namespace mitk
 {
 
 /**
-* \brief Generates ne proposals of particle configurations.   */
+* \brief Generates ne proposals of particle configurations.
+*
+* SetSlab() restricts the proposals to the particles in a slab of grid cells along x. Samplers working on slabs
+* that are at least three cells apart do not interfere and can run concurrently (see ParallelMetropolisHastingsSampler).
+* Within a slab the birth and death proposals account for the spatial probability of the slab, shifts leaving the slab
+* and connection proposals involving particles outside of the slab are rejected, so every slab update keeps the
+* detailed balance of the whole configuration.  */
 
 class MITKFIBERTRACKING_EXPORT MetropolisHastingsSampler
 {
@@ -44,16 +50,40 @@ public:
     typedef itk::Image< float, 3 >  ItkFloatImageType;
     typedef itk::Statistics::MersenneTwisterRandomVariateGenerator ItkRandGenType;
 
+    enum ProposalType
+    {
+        BIRTH_PROPOSAL,
+        DEATH_PROPOSAL,
+        SHIFT_PROPOSAL,
+        OPTIMAL_SHIFT_PROPOSAL,
+        CONNECTION_PROPOSAL,
+        NUM_PROPOSAL_TYPES
+    };
+
     MetropolisHastingsSampler(ParticleGrid* grid, EnergyComputer* enComp, ItkRandGenType* randGen, float curvThres);
     void SetTemperature(float val);
 
     void MakeProposal();    ///< make proposal for birth/death/shift/connection of particles
     int GetNumAcceptedProposals();
+    unsigned long GetNumProposals(ProposalType type);           ///< number of proposals of the given type
+    unsigned long GetNumAcceptedProposals(ProposalType type);   ///< number of accepted proposals of the given type
+
+    /** restrict the proposals to the particles in the grid cells firstCellX to endCellX-1 along x, new particles are stored in the unused container slots firstSlot to endSlot-1 */
+    void SetSlab(int firstCellX, int endCellX, float spatialProbability, int firstSlot, int endSlot);
+    void ClearSlab();
+
+    EnergyComputer* GetEnergyComputer();
+    ItkRandGenType* GetRandGen();
     void SetProbabilities(float birth, float death, float shift, float optShift, float connect);    ///< update the probabilities of the single proposals
     void PrintProposalTimes();  ///< print the state of the proposal time probes
 
 protected:
 
+    /** particles of the current slab (all particles if no slab is set) */
+    int GetNumParticles();
+    bool IsInSlab(Particle* p);
+    bool IsInSlab(vnl_vector_fixed<float, 3>& R);
+
     /** connection proposal related methods */
     void ImplementTrack(Track& T);
     void RemoveAndSaveTrack(EndPoint P);
@@ -94,6 +124,20 @@ protected:
     ParticleGrid*   m_ParticleGrid;         ///< storest all particles
     EnergyComputer* m_EnergyComputer;       ///< computes internal and external energy of particles
     unsigned int    m_AcceptedProposals;    ///< counts accepted proposals
+    unsigned long   m_NumProposals[NUM_PROPOSAL_TYPES];
+    unsigned long   m_NumAcceptedProposals[NUM_PROPOSAL_TYPES];
+
+    ParticleGrid::NeighborTracker   m_NeighborTracker;
+
+    bool                m_UseSlab;
+    int                 m_SlabFirstCellX;
+    int                 m_SlabEndCellX;
+    float               m_SlabMinX;             ///< slab border in mm
+    float               m_SlabMaxX;
+    float               m_SlabProbability;      ///< share of the spatial probability inside the slab
+    int                 m_NextSlot;             ///< next unused container slot for particle births
+    int                 m_EndSlot;
+    std::vector< int >  m_SlabParticles;        ///< IDs of the particles inside the slab
 
     /** Time probes for the single proposals */
     itk::TimeProbe  m_BirthTime;
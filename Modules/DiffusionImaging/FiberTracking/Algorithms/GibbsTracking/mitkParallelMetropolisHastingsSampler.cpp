@@ -0,0 +1,189 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkParallelMetropolisHastingsSampler.h"
+
+#include <algorithm>
+#include <omp.h>
+
+using namespace mitk;
+
+ParallelMetropolisHastingsSampler::ParallelMetropolisHastingsSampler(ParticleGrid* grid, const std::vector< MetropolisHastingsSampler* >& samplers, ItkRandGenType* randGen)
+    : m_ParticleGrid(grid)
+    , m_Samplers(samplers)
+    , m_RandGen(randGen)
+    , m_Seconds(samplers.size(), 0)
+{
+}
+
+bool ParallelMetropolisHastingsSampler::CanRunInParallel()
+{
+    return m_Samplers.size()>1 && m_ParticleGrid->GetNumCellsX() >= 4*GetMinSlabWidth();
+}
+
+void ParallelMetropolisHastingsSampler::SetTemperature(float val)
+{
+    for (std::size_t t = 0; t < m_Samplers.size(); t++)
+        m_Samplers[t]->SetTemperature(val);
+}
+
+void ParallelMetropolisHastingsSampler::MakeProposals(unsigned long numProposals)
+{
+    int numCells = m_ParticleGrid->GetNumCellsX();
+
+    // as many slabs as possible, so threads finishing sparse slabs early can take over dense ones.
+    // the slabs do not depend on the number of threads.
+    int width = GetMinSlabWidth();
+    int offset = m_RandGen->GetIntegerVariate()%width;
+    std::vector< int > slabBorders(1, 0);
+    for (int x = offset; x < numCells; x += width)
+        if (x > 0)
+            slabBorders.push_back(x);
+    slabBorders.push_back(numCells);
+    int numSlabs = slabBorders.size()-1;
+
+    // distribute the proposals according to the spatial probability of the slabs
+    EnergyComputer* encomp = m_Samplers[0]->GetEnergyComputer();
+    float cellSize = m_ParticleGrid->GetCellSize();
+    std::vector< float > slabProbabilities(numSlabs);
+    double sum = 0;
+    for (int s = 0; s < numSlabs; s++)
+    {
+        slabProbabilities[s] = encomp->GetSpatialProbability(slabBorders[s]*cellSize, slabBorders[s+1]*cellSize);
+        sum += slabProbabilities[s];
+    }
+    if (sum <= 0)
+        return;
+
+    std::vector< unsigned long > slabProposals(numSlabs, 0);
+    double cumulated = 0;
+    unsigned long distributed = 0;
+    for (int s = 0; s < numSlabs; s++)
+    {
+        cumulated += slabProbabilities[s];
+        unsigned long end = (s == numSlabs-1) ? numProposals : std::min(numProposals, (unsigned long)(numProposals*cumulated/sum + 0.5));
+        slabProposals[s] = end - distributed;
+        distributed = end;
+    }
+
+    int firstColor = m_RandGen->GetIntegerVariate()%2;
+    MakeProposals(slabBorders, slabProbabilities, slabProposals, firstColor);
+    MakeProposals(slabBorders, slabProbabilities, slabProposals, 1-firstColor);
+
+    // remove the slots of dead particles and unused slots, IDs are consecutive again
+    m_ParticleGrid->SortParticlesByCell(0);
+}
+
+void ParallelMetropolisHastingsSampler::MakeProposals(const std::vector< int >& slabBorders, const std::vector< float >& slabProbabilities, const std::vector< unsigned long >& slabProposals, int color)
+{
+    std::vector< int > slabs;
+    int numSlots = 0;
+    for (int s = color; s < (int)slabProposals.size(); s += 2)
+        if (slabProposals[s] > 0)
+        {
+            slabs.push_back(s);
+            numSlots += slabProposals[s];
+        }
+    int numSlabs = slabs.size();
+    if (numSlabs == 0)
+        return;
+
+    // every proposal of a slab may give birth to a particle, each slab gets its own range of unused container slots
+    m_ParticleGrid->SortParticlesByCell(numSlots);
+    std::vector< int > firstSlots(numSlabs+1, m_ParticleGrid->m_NumParticles);
+    std::vector< ItkRandGenType::IntegerType > seeds(numSlabs);
+    for (int i = 0; i < numSlabs; i++)
+    {
+        firstSlots[i+1] = firstSlots[i] + slabProposals[slabs[i]];
+        seeds[i] = m_RandGen->GetIntegerVariate();
+    }
+    int numOverflows = m_ParticleGrid->m_NumCellOverflows;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(m_Samplers.size())
+    for (int i = 0; i < numSlabs; i++)
+    {
+        int thread = omp_get_thread_num();
+        MetropolisHastingsSampler* sampler = m_Samplers[thread];
+        int s = slabs[i];
+
+        double start = omp_get_wtime();
+        sampler->GetRandGen()->SetSeed(seeds[i]);
+        sampler->SetSlab(slabBorders[s], slabBorders[s+1], slabProbabilities[s], firstSlots[i], firstSlots[i+1]);
+        for (unsigned long j = 0; j < slabProposals[s]; j++)
+            sampler->MakeProposal();
+        sampler->ClearSlab();
+        m_Seconds[thread] += omp_get_wtime()-start;
+    }
+
+    // particles were rejected because of full cells
+    if (m_ParticleGrid->m_NumCellOverflows > numOverflows)
+        m_ParticleGrid->GrowCells();
+}
+
+unsigned long ParallelMetropolisHastingsSampler::GetNumAcceptedProposals()
+{
+    unsigned long accepted = 0;
+    for (std::size_t t = 0; t < m_Samplers.size(); t++)
+        accepted += m_Samplers[t]->GetNumAcceptedProposals();
+    return accepted;
+}
+
+int ParallelMetropolisHastingsSampler::GetNumberOfThreads()
+{
+    return m_Samplers.size();
+}
+
+ParallelMetropolisHastingsSampler::ThreadStatistics ParallelMetropolisHastingsSampler::GetThreadStatistics(int thread)
+{
+    ThreadStatistics statistics;
+    statistics.m_Proposals = 0;
+    statistics.m_AcceptedProposals = 0;
+    for (int i = 0; i < MetropolisHastingsSampler::NUM_PROPOSAL_TYPES; i++)
+    {
+        MetropolisHastingsSampler::ProposalType type = static_cast<MetropolisHastingsSampler::ProposalType>(i);
+        statistics.m_Proposals += m_Samplers[thread]->GetNumProposals(type);
+        statistics.m_AcceptedProposals += m_Samplers[thread]->GetNumAcceptedProposals(type);
+    }
+    statistics.m_Seconds = m_Seconds[thread];
+    return statistics;
+}
+
+void ParallelMetropolisHastingsSampler::PrintStatistics()
+{
+    const char* names[MetropolisHastingsSampler::NUM_PROPOSAL_TYPES] = { "Birth", "Death", "Shift", "Optimal shift", "Connection" };
+    std::cout << "Proposal acceptance (accepted/proposed)" << std::endl;
+    for (int i = 0; i < MetropolisHastingsSampler::NUM_PROPOSAL_TYPES; i++)
+    {
+        MetropolisHastingsSampler::ProposalType type = static_cast<MetropolisHastingsSampler::ProposalType>(i);
+        unsigned long proposals = 0;
+        unsigned long accepted = 0;
+        for (std::size_t t = 0; t < m_Samplers.size(); t++)
+        {
+            proposals += m_Samplers[t]->GetNumProposals(type);
+            accepted += m_Samplers[t]->GetNumAcceptedProposals(type);
+        }
+        std::cout << names[i] << ": " << accepted << "/" << proposals << std::endl;
+    }
+
+    std::cout << "Proposals per thread (proposals/accepted %/proposals per second)" << std::endl;
+    for (int t = 0; t < GetNumberOfThreads(); t++)
+    {
+        ThreadStatistics statistics = GetThreadStatistics(t);
+        std::cout << "Thread " << t << ": " << statistics.m_Proposals
+                  << "/" << (statistics.m_Proposals>0 ? 100.0*statistics.m_AcceptedProposals/statistics.m_Proposals : 0)
+                  << "/" << (statistics.m_Seconds>0 ? statistics.m_Proposals/statistics.m_Seconds : 0) << std::endl;
+    }
+}
@@ -0,0 +1,80 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _PARALLELSAMPLER
+#define _PARALLELSAMPLER
+
+// MITK
+#include <MitkFiberTrackingExports.h>
+#include <mitkMetropolisHastingsSampler.h>
+
+namespace mitk
+{
+
+/**
+* \brief Generates proposals of particle configurations in several slabs of the particle grid concurrently.
+*
+* The grid is split along x into slabs of at least three cells. The slabs are colored alternately and all slabs
+* of one color are updated in parallel, each by one MetropolisHastingsSampler restricted to the slab. Slabs of
+* the same color are separated by a slab of the other color, so no proposal reads particles another thread
+* changes. The slab borders are shifted randomly for every call of MakeProposals() and the proposals are
+* distributed according to the spatial probability of the slabs.
+*
+* Every sampler needs its own energy computer (and sphere interpolator) and random generator. The random
+* generator of a sampler is reseeded from the given random generator for every slab, so the result does not
+* depend on the number of threads.   */
+
+class MITKFIBERTRACKING_EXPORT ParallelMetropolisHastingsSampler
+{
+public:
+
+    typedef MetropolisHastingsSampler::ItkRandGenType ItkRandGenType;
+
+    struct ThreadStatistics
+    {
+        unsigned long   m_Proposals;
+        unsigned long   m_AcceptedProposals;
+        double          m_Seconds;      ///< time spent making proposals
+    };
+
+    /** samplers[t] is used by thread t only */
+    ParallelMetropolisHastingsSampler(ParticleGrid* grid, const std::vector< MetropolisHastingsSampler* >& samplers, ItkRandGenType* randGen);
+
+    static int GetMinSlabWidth() { return 3; }  ///< in grid cells
+    bool CanRunInParallel();                    ///< false if the grid is too small for two slabs of each color
+
+    void SetTemperature(float val);
+    void MakeProposals(unsigned long numProposals);     ///< distributes the proposals over the slabs, the particle container is sorted by cell afterwards
+    unsigned long GetNumAcceptedProposals();
+
+    int GetNumberOfThreads();
+    ThreadStatistics GetThreadStatistics(int thread);
+    void PrintStatistics();     ///< acceptance rates per proposal type and proposals per second of every thread
+
+protected:
+
+    /** proposals of all slabs of one color */
+    void MakeProposals(const std::vector< int >& slabBorders, const std::vector< float >& slabProbabilities, const std::vector< unsigned long >& slabProposals, int color);
+
+    ParticleGrid*                               m_ParticleGrid;
+    std::vector< MetropolisHastingsSampler* >   m_Samplers;
+    ItkRandGenType*                             m_RandGen;
+    std::vector< double >                       m_Seconds;      ///< per thread
+};
+
+}
+
+#endif
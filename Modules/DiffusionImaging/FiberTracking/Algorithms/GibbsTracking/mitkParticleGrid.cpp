@@ -48,8 +48,6 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
     m_Particles.resize(m_ContainerCapacity);        // allocate and initialize particles
     m_Grid.resize(gridSize, nullptr);   // allocate and initialize particle grid
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
-    m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
-    m_NeighbourTracker.cellidx_c.resize(8, 0);
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
@@ -72,16 +70,12 @@ void ParticleGrid::ResetGrid()
     m_Particles.clear();
     m_Grid.clear();
     m_OccupationCount.clear();
-    m_NeighbourTracker.cellidx.clear();
-    m_NeighbourTracker.cellidx_c.clear();
 
     int numCells = m_GridSize[0]*m_GridSize[1]*m_GridSize[2];   // number of grid cells
 
     m_Particles.resize(m_ContainerCapacity);        // allocate and initialize particles
     m_Grid.resize(numCells*m_CellCapacity, nullptr);   // allocate and initialize particle grid
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
-    m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
-    m_NeighbourTracker.cellidx_c.resize(8, 0);
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
@@ -119,99 +113,142 @@ Particle* ParticleGrid::GetParticle(int ID)
 }
 
 
-Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
+bool ParticleGrid::GrowCells()
 {
-    if (m_NumParticles >= m_ContainerCapacity)
+    int newCapacity = 2*m_CellCapacity;
+    unsigned long numCells = m_OccupationCount.size();
+    if ( (unsigned long)itk::NumericTraits<int>::max()<numCells*newCapacity )
+        return false;
+    try
     {
-        if (!ReallocateGrid())
-            return nullptr;
+        std::vector< Particle* > grid(numCells*newCapacity, nullptr);
+        for (unsigned long c = 0; c < numCells; c++)
+            for (int j = 0; j < m_OccupationCount[c]; j++)
+            {
+                Particle* p = m_Grid[c*m_CellCapacity+j];
+                p->gridindex = c*newCapacity+j;
+                grid[p->gridindex] = p;
+            }
+        m_Grid.swap(grid);
+        m_CellCapacity = newCapacity;
+    }
+    catch(...)
+    {
+        std::cout << "ParticleGrid: allocation of " << sizeof(Particle*)*numCells*newCapacity/1048576 << "mb for " << newCapacity << " particles per cell failed!" << std::endl;
+        return false;
     }
+    return true;
+}
 
+int ParticleGrid::GetCellIndex(vnl_vector_fixed<float, 3>& R)
+{
     int xint = int(R[0]*m_GridScale[0]);
     if (xint < 0)
-        return nullptr;
+        return -1;
     if (xint >= m_GridSize[0])
-        return nullptr;
+        return -1;
     int yint = int(R[1]*m_GridScale[1]);
     if (yint < 0)
-        return nullptr;
+        return -1;
     if (yint >= m_GridSize[1])
-        return nullptr;
+        return -1;
     int zint = int(R[2]*m_GridScale[2]);
     if (zint < 0)
-        return nullptr;
+        return -1;
     if (zint >= m_GridSize[2])
+        return -1;
+
+    return xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
+}
+
+Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
+{
+    if (m_NumParticles >= m_ContainerCapacity)
+    {
+        if (!ReallocateGrid())
+            return nullptr;
+    }
+
+    int idx = GetCellIndex(R);
+    if (idx < 0)
         return nullptr;
 
-    int idx = xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
-    if (m_OccupationCount[idx] < m_CellCapacity)
+    if (m_OccupationCount[idx] >= m_CellCapacity && !GrowCells())
     {
-        Particle *p = &(m_Particles[m_NumParticles]);
-        p->GetPos() = R;
-        p->mID = -1;
-        p->pID = -1;
-        m_NumParticles++;
-        p->gridindex = m_CellCapacity*idx + m_OccupationCount[idx];
-        m_Grid[p->gridindex] = p;
-        m_OccupationCount[idx]++;
-        return p;
+        m_NumCellOverflows++;
+        return nullptr;
     }
-    else
+
+    Particle *p = &(m_Particles[m_NumParticles]);
+    p->GetPos() = R;
+    p->mID = -1;
+    p->pID = -1;
+    m_NumParticles++;
+    p->gridindex = m_CellCapacity*idx + m_OccupationCount[idx];
+    m_Grid[p->gridindex] = p;
+    m_OccupationCount[idx]++;
+    return p;
+}
+
+Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R, int slot)
+{
+    int idx = GetCellIndex(R);
+    if (idx < 0)
+        return nullptr;
+
+    if (m_OccupationCount[idx] >= m_CellCapacity)
     {
+#pragma omp atomic
         m_NumCellOverflows++;
         return nullptr;
     }
+
+    Particle *p = &(m_Particles[slot]);
+    p->GetPos() = R;
+    p->ID = slot;
+    p->mID = -1;
+    p->pID = -1;
+    p->label = 0;
+    p->gridindex = m_CellCapacity*idx + m_OccupationCount[idx];
+    m_Grid[p->gridindex] = p;
+    m_OccupationCount[idx]++;
+    return p;
 }
 
-bool ParticleGrid::TryUpdateGrid(int k)
+bool ParticleGrid::TryUpdateGrid(int k, bool growCells)
 {
     Particle* p = &(m_Particles[k]);
 
-    int xint = int(p->GetPos()[0]*m_GridScale[0]);
-    if (xint < 0)
-        return false;
-    if (xint >= m_GridSize[0])
-        return false;
-    int yint = int(p->GetPos()[1]*m_GridScale[1]);
-    if (yint < 0)
-        return false;
-    if (yint >= m_GridSize[1])
-        return false;
-    int zint = int(p->GetPos()[2]*m_GridScale[2]);
-    if (zint < 0)
-        return false;
-    if (zint >= m_GridSize[2])
+    int idx = GetCellIndex(p->GetPos());
+    if (idx < 0)
         return false;
 
-    int idx = xint + m_GridSize[0]*(yint+ zint*m_GridSize[1]);
     int cellidx = p->gridindex/m_CellCapacity;
     if (idx != cellidx) // cell has changed
     {
-
-        if (m_OccupationCount[idx] < m_CellCapacity)
-        {
-            // remove from old position in grid;
-            int grdindex = p->gridindex;
-            m_Grid[grdindex] = m_Grid[cellidx*m_CellCapacity + m_OccupationCount[cellidx]-1];
-            m_Grid[grdindex]->gridindex = grdindex;
-            m_OccupationCount[cellidx]--;
-
-            // insert at new position in grid
-            p->gridindex = idx*m_CellCapacity + m_OccupationCount[idx];
-            m_Grid[p->gridindex] = p;
-            m_OccupationCount[idx]++;
-            return true;
-        }
-        else
+        if (m_OccupationCount[idx] >= m_CellCapacity && !(growCells && GrowCells()))
         {
+#pragma omp atomic
             m_NumCellOverflows++;
             return false;
         }
+        cellidx = p->gridindex/m_CellCapacity;  // capacity might have changed
+
+        // remove from old position in grid;
+        int grdindex = p->gridindex;
+        m_Grid[grdindex] = m_Grid[cellidx*m_CellCapacity + m_OccupationCount[cellidx]-1];
+        m_Grid[grdindex]->gridindex = grdindex;
+        m_OccupationCount[cellidx]--;
+
+        // insert at new position in grid
+        p->gridindex = idx*m_CellCapacity + m_OccupationCount[idx];
+        m_Grid[p->gridindex] = p;
+        m_OccupationCount[idx]++;
     }
     return true;
 }
 
-void ParticleGrid::RemoveParticle(int k)
+void ParticleGrid::RemoveParticleFromGrid(int k)
 {
     Particle* p = &(m_Particles[k]);
     int gridIndex = p->gridindex;
@@ -232,6 +269,11 @@ void ParticleGrid::RemoveParticle(int k)
         m_Grid[gridIndex]->gridindex = gridIndex;
     }
     m_OccupationCount[cellIdx]--;
+}
+
+void ParticleGrid::RemoveParticle(int k)
+{
+    RemoveParticleFromGrid(k);
 
     // remove from container
     if (k < m_NumParticles-1)
@@ -263,6 +305,16 @@ void ParticleGrid::RemoveParticle(int k)
 }
 
 void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
+{
+    ComputeNeighbors(R, m_NeighbourTracker);
+}
+
+Particle* ParticleGrid::GetNextNeighbor()
+{
+    return GetNextNeighbor(m_NeighbourTracker);
+}
+
+void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R, NeighborTracker& tracker)
 {
     float xfrac = R[0]*m_GridScale[0];
     float yfrac = R[1]*m_GridScale[1];
@@ -290,47 +342,47 @@ void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
     if (m_GridSize[2] <= 1) { dz = 0; } // Necessary with 2d images (bug 15416)
 
 
-    m_NeighbourTracker.cellidx[0] = xint + m_GridSize[0]*(yint+zint*m_GridSize[1]);
-    m_NeighbourTracker.cellidx[1] = m_NeighbourTracker.cellidx[0] + dx;
-    m_NeighbourTracker.cellidx[2] = m_NeighbourTracker.cellidx[1] + dy*m_GridSize[0];
-    m_NeighbourTracker.cellidx[3] = m_NeighbourTracker.cellidx[2] - dx;
-    m_NeighbourTracker.cellidx[4] = m_NeighbourTracker.cellidx[0] + dz*m_GridSize[0]*m_GridSize[1];
-    m_NeighbourTracker.cellidx[5] = m_NeighbourTracker.cellidx[4] + dx;
-    m_NeighbourTracker.cellidx[6] = m_NeighbourTracker.cellidx[5] + dy*m_GridSize[0];
-    m_NeighbourTracker.cellidx[7] = m_NeighbourTracker.cellidx[6] - dx;
+    tracker.cellidx[0] = xint + m_GridSize[0]*(yint+zint*m_GridSize[1]);
+    tracker.cellidx[1] = tracker.cellidx[0] + dx;
+    tracker.cellidx[2] = tracker.cellidx[1] + dy*m_GridSize[0];
+    tracker.cellidx[3] = tracker.cellidx[2] - dx;
+    tracker.cellidx[4] = tracker.cellidx[0] + dz*m_GridSize[0]*m_GridSize[1];
+    tracker.cellidx[5] = tracker.cellidx[4] + dx;
+    tracker.cellidx[6] = tracker.cellidx[5] + dy*m_GridSize[0];
+    tracker.cellidx[7] = tracker.cellidx[6] - dx;
 
 
-    m_NeighbourTracker.cellidx_c[0] = m_CellCapacity*m_NeighbourTracker.cellidx[0];
-    m_NeighbourTracker.cellidx_c[1] = m_CellCapacity*m_NeighbourTracker.cellidx[1];
-    m_NeighbourTracker.cellidx_c[2] = m_CellCapacity*m_NeighbourTracker.cellidx[2];
-    m_NeighbourTracker.cellidx_c[3] = m_CellCapacity*m_NeighbourTracker.cellidx[3];
-    m_NeighbourTracker.cellidx_c[4] = m_CellCapacity*m_NeighbourTracker.cellidx[4];
-    m_NeighbourTracker.cellidx_c[5] = m_CellCapacity*m_NeighbourTracker.cellidx[5];
-    m_NeighbourTracker.cellidx_c[6] = m_CellCapacity*m_NeighbourTracker.cellidx[6];
-    m_NeighbourTracker.cellidx_c[7] = m_CellCapacity*m_NeighbourTracker.cellidx[7];
+    tracker.cellidx_c[0] = m_CellCapacity*tracker.cellidx[0];
+    tracker.cellidx_c[1] = m_CellCapacity*tracker.cellidx[1];
+    tracker.cellidx_c[2] = m_CellCapacity*tracker.cellidx[2];
+    tracker.cellidx_c[3] = m_CellCapacity*tracker.cellidx[3];
+    tracker.cellidx_c[4] = m_CellCapacity*tracker.cellidx[4];
+    tracker.cellidx_c[5] = m_CellCapacity*tracker.cellidx[5];
+    tracker.cellidx_c[6] = m_CellCapacity*tracker.cellidx[6];
+    tracker.cellidx_c[7] = m_CellCapacity*tracker.cellidx[7];
 
-    m_NeighbourTracker.cellcnt = 0;
-    m_NeighbourTracker.pcnt = 0;
+    tracker.cellcnt = 0;
+    tracker.pcnt = 0;
 }
 
-Particle* ParticleGrid::GetNextNeighbor()
+Particle* ParticleGrid::GetNextNeighbor(NeighborTracker& tracker)
 {
-    if (m_NeighbourTracker.pcnt < m_OccupationCount[m_NeighbourTracker.cellidx[m_NeighbourTracker.cellcnt]])
+    if (tracker.pcnt < m_OccupationCount[tracker.cellidx[tracker.cellcnt]])
     {
-        return m_Grid[m_NeighbourTracker.cellidx_c[m_NeighbourTracker.cellcnt] + (m_NeighbourTracker.pcnt++)];
+        return m_Grid[tracker.cellidx_c[tracker.cellcnt] + (tracker.pcnt++)];
     }
     else
     {
         for(;;)
         {
-            m_NeighbourTracker.cellcnt++;
-            if (m_NeighbourTracker.cellcnt >= 8)
+            tracker.cellcnt++;
+            if (tracker.cellcnt >= 8)
                 return nullptr;
-            if (m_OccupationCount[m_NeighbourTracker.cellidx[m_NeighbourTracker.cellcnt]] > 0)
+            if (m_OccupationCount[tracker.cellidx[tracker.cellcnt]] > 0)
                 break;
         }
-        m_NeighbourTracker.pcnt = 1;
-        return m_Grid[m_NeighbourTracker.cellidx_c[m_NeighbourTracker.cellcnt]];
+        tracker.pcnt = 1;
+        return m_Grid[tracker.cellidx_c[tracker.cellcnt]];
     }
 }
 
@@ -346,6 +398,7 @@ void ParticleGrid::CreateConnection(Particle *P1,int ep1, Particle *P2, int ep2)
     else
         P2->pID = P1->ID;
 
+#pragma omp atomic
     m_NumConnections++;
 }
 
@@ -360,6 +413,7 @@ void ParticleGrid::DestroyConnection(Particle *P1,int ep1, Particle *P2, int ep2
         P2->mID = -1;
     else
         P2->pID = -1;
+#pragma omp atomic
     m_NumConnections--;
 }
 
@@ -383,9 +437,59 @@ void ParticleGrid::DestroyConnection(Particle *P1,int ep1)
     else
         P2->pID = -1;
 
+#pragma omp atomic
     m_NumConnections--;
 }
 
+void ParticleGrid::GetParticlesInSlab(int firstCellX, int endCellX, std::vector< int >& ids)
+{
+    ids.clear();
+    for (int z = 0; z < m_GridSize[2]; z++)
+        for (int y = 0; y < m_GridSize[1]; y++)
+            for (int x = firstCellX; x < endCellX; x++)
+            {
+                int idx = x + m_GridSize[0]*(y + m_GridSize[1]*z);
+                for (int j = 0; j < m_OccupationCount[idx]; j++)
+                    ids.push_back(m_Grid[idx*m_CellCapacity+j]->ID);
+            }
+}
+
+void ParticleGrid::SortParticlesByCell(int numFreeSlots)
+{
+    int numCells = m_OccupationCount.size();
+    int numParticles = 0;
+    for (int c = 0; c < numCells; c++)
+        numParticles += m_OccupationCount[c];
+
+    std::vector< Particle > particles(numParticles+numFreeSlots);
+    std::vector< int > newIds(m_Particles.size(), -1);
+    int id = 0;
+    for (int c = 0; c < numCells; c++)
+        for (int j = 0; j < m_OccupationCount[c]; j++)
+        {
+            Particle* p = m_Grid[c*m_CellCapacity+j];
+            newIds[p->ID] = id;
+            particles[id] = *p;
+            particles[id].ID = id;
+            m_Grid[c*m_CellCapacity+j] = &particles[id];    // stays valid after the swap below
+            id++;
+        }
+
+    for (int i = 0; i < numParticles; i++)  // update the connections to the new IDs
+    {
+        if (particles[i].mID != -1)
+            particles[i].mID = newIds[particles[i].mID];
+        if (particles[i].pID != -1)
+            particles[i].pID = newIds[particles[i].pID];
+    }
+    for (int i = numParticles; i < numParticles+numFreeSlots; i++)
+        particles[i].ID = i;
+
+    m_Particles.swap(particles);
+    m_NumParticles = numParticles;
+    m_ContainerCapacity = m_Particles.size();
+}
+
 bool ParticleGrid::CheckConsistency()
 {
     for (int i=0; i<m_NumParticles; i++)
@@ -28,7 +28,15 @@ namespace mitk
 {
 
 /**
-* \brief Contains and manages particles.   */
+* \brief Contains and manages particles.
+*
+* The particles of one grid cell are referenced by consecutive entries of the grid. SortParticlesByCell() also
+* arranges the particles themselves cell by cell in the particle container. The capacity of the cells grows if
+* a cell overflows.
+*
+* For parallel sampling the grid is split into slabs of cells along x. Particles of a slab are only created,
+* moved and removed by the thread owning the slab (see NewParticle(R, slot), TryUpdateGrid(k, false) and
+* RemoveParticleFromGrid()), the neighbor queries use a NeighborTracker per thread. */
 
 class MITKFIBERTRACKING_EXPORT ParticleGrid
 {
@@ -37,6 +45,14 @@ public:
 
     typedef itk::Image< float, 3 >  ItkFloatImageType;
 
+    struct NeighborTracker  // to run over the neighbors
+    {
+        int cellidx[8];
+        int cellidx_c[8];
+        int cellcnt;
+        int pcnt;
+    };
+
     int m_NumParticles;         // number of particles
     int m_NumConnections;       // number of connections
     int m_NumCellOverflows;     // number of cell overflows
@@ -48,11 +64,27 @@ public:
     Particle* GetParticle(int ID);
 
     Particle* NewParticle(vnl_vector_fixed<float, 3> R);
-    bool TryUpdateGrid(int k);
+    Particle* NewParticle(vnl_vector_fixed<float, 3> R, int slot);    ///< uses the unused container slot, does not grow the cells and does not count the particle in m_NumParticles
+    bool TryUpdateGrid(int k, bool growCells=true);
     void RemoveParticle(int k);
+    void RemoveParticleFromGrid(int k);     ///< the container slot of the particle stays unused until SortParticlesByCell() is called
 
     void ComputeNeighbors(vnl_vector_fixed<float, 3> &R);
     Particle* GetNextNeighbor();
+    void ComputeNeighbors(vnl_vector_fixed<float, 3> &R, NeighborTracker& tracker);
+    Particle* GetNextNeighbor(NeighborTracker& tracker);
+
+    /** Rebuilds the particle container with the particles of the grid, cell by cell, followed by numFreeSlots unused slots.
+     *  The particle IDs change, unused slots of removed particles are dropped. */
+    void SortParticlesByCell(int numFreeSlots);
+    bool GrowCells();   ///< doubles the particle capacity of all cells
+
+    int GetNumCellsX() { return m_GridSize[0]; }
+    float GetCellSize() { return 1/m_GridScale[0]; }
+    int GetCellX(Particle* p) { return (p->gridindex/m_CellCapacity)%m_GridSize[0]; }
+    int GetCellX(vnl_vector_fixed<float, 3>& R) { return R[0]<0 ? -1 : int(R[0]*m_GridScale[0]); }
+    void GetParticlesInSlab(int firstCellX, int endCellX, std::vector< int >& ids);    ///< IDs of the particles in the cells firstCellX to endCellX-1 along x
+    int GetContainerCapacity() { return m_ContainerCapacity; }
 
     void CreateConnection(Particle *P1,int ep1, Particle *P2, int ep2);
     void DestroyConnection(Particle *P1,int ep1, Particle *P2, int ep2);
@@ -64,6 +96,7 @@ public:
 protected:
 
     bool ReallocateGrid();
+    int GetCellIndex(vnl_vector_fixed<float, 3>& R);  ///< -1 if outside of the grid
 
     std::vector< Particle* >    m_Grid;             // the grid
     std::vector< Particle >     m_Particles;        // particle container
@@ -76,13 +109,7 @@ protected:
 
     int m_CellCapacity;      // particle capacity of single cell in grid
 
-    struct NeighborTracker  // to run over the neighbors
-    {
-        std::vector< int > cellidx;
-        std::vector< int > cellidx_c;
-        int cellcnt;
-        int pcnt;
-    } m_NeighbourTracker;
+    NeighborTracker m_NeighbourTracker;
 
 };
 
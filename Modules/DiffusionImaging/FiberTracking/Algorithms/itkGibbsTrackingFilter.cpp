@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkStandardFileLocations.h>
 #include <mitkFiberBuilder.h>
 #include <mitkMetropolisHastingsSampler.h>
+#include <mitkParallelMetropolisHastingsSampler.h>
 //#include <mitkEnergyComputer.h>
 #include <itkTensorImageToQBallImageFilter.h>
 #include <mitkGibbsEnergyComputer.h>
@@ -31,6 +32,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkTimeProbe.h>
 
 // MISC
+#include <algorithm>
 #include <fstream>
 // #include <QFile>
 #include <tinyxml.h>
@@ -66,7 +68,8 @@ GibbsTrackingFilter< ItkQBallImageType >::GibbsTrackingFilter():
     m_RandomSeed(-1),
     m_LoadParameterFile(""),
     m_LutPath(""),
-    m_IsInValidState(true)
+    m_IsInValidState(true),
+    m_NumSamplerThreads(1)
 {
 
 }
@@ -256,11 +259,37 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     ParticleGrid* particleGrid;
     GibbsEnergyComputer* encomp;
     MetropolisHastingsSampler* sampler;
+
+    // components of the threads sampling slabs of the particle grid concurrently
+    std::vector< SphereInterpolator* > threadInterpolators;
+    std::vector< Statistics::MersenneTwisterRandomVariateGenerator::Pointer > threadRandGens;
+    std::vector< GibbsEnergyComputer* > threadEncomps;
+    std::vector< MetropolisHastingsSampler* > threadSamplers;
+    ParallelMetropolisHastingsSampler* parallelSampler = nullptr;
     try{
         particleGrid = new ParticleGrid(m_MaskImage, m_ParticleLength, m_ParticleGridCellCapacity);
         encomp = new GibbsEnergyComputer(m_QBallImage, m_MaskImage, particleGrid, interpolator, randGen);
         encomp->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
         sampler = new MetropolisHastingsSampler(particleGrid, encomp, randGen, m_CurvatureThreshold);
+
+        for (int t=0; m_NumSamplerThreads>1 && t<m_NumSamplerThreads; t++)
+        {
+            threadInterpolators.push_back(new SphereInterpolator(*interpolator));
+            threadRandGens.push_back(Statistics::MersenneTwisterRandomVariateGenerator::New());
+            threadEncomps.push_back(new GibbsEnergyComputer(m_QBallImage, m_MaskImage, particleGrid, threadInterpolators.back(), threadRandGens.back()));
+            threadEncomps.back()->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
+            threadSamplers.push_back(new MetropolisHastingsSampler(particleGrid, threadEncomps.back(), threadRandGens.back(), m_CurvatureThreshold));
+        }
+        if (m_NumSamplerThreads>1)
+        {
+            parallelSampler = new ParallelMetropolisHastingsSampler(particleGrid, threadSamplers, randGen);
+            if (!parallelSampler->CanRunInParallel())
+            {
+                MITK_INFO << "GibbsTrackingFilter: particle grid too small for parallel sampling, using a single thread";
+                delete parallelSampler;
+                parallelSampler = nullptr;
+            }
+        }
     }
     catch(...)
     {
@@ -283,6 +312,7 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     MITK_INFO << "Min. fiber length: " << m_MinFiberLength;
     MITK_INFO << "Curvature threshold: " << m_CurvatureThreshold;
     MITK_INFO << "Random seed: " << m_RandomSeed;
+    MITK_INFO << "Sampler threads: " << (parallelSampler!=nullptr ? m_NumSamplerThreads : 1);
     MITK_INFO << "----------------------------------------";
 
     // main loop
@@ -299,6 +329,36 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
         float temperature = m_StartTemperature * exp(alpha*(((1.0)*m_CurrentStep)/((1.0)*m_Steps)));
         sampler->SetTemperature(temperature);
 
+        // the proposals are distributed over the slabs of the particle grid in batches,
+        // so requests to abort or to build the fibers are handled during the step
+        if (parallelSampler!=nullptr)
+        {
+            parallelSampler->SetTemperature(temperature);
+            const unsigned long batchSize = 10000;
+            for (unsigned long i=0; i<singleIts; i+=batchSize)
+            {
+                if (m_AbortTracking)
+                    break;
+
+                unsigned long batch = std::min(batchSize, singleIts-i);
+                parallelSampler->MakeProposals(batch);
+                disp += batch;
+                counter += batch;
+
+                if (m_BuildFibers || (i+batch==singleIts && m_CurrentStep==m_Steps))
+                {
+                    m_ProposalAcceptance = (float)parallelSampler->GetNumAcceptedProposals()/counter;
+                    m_NumParticles = particleGrid->m_NumParticles;
+                    m_NumConnections = particleGrid->m_NumConnections;
+
+                    FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+                    m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+                    m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+                    m_BuildFibers = false;
+                }
+            }
+        }
+        else
         for (unsigned long i=0; i<singleIts; i++)
         {
             ++disp;
@@ -321,7 +381,10 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
             counter++;
         }
 
-        m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
+        if (parallelSampler!=nullptr)
+            m_ProposalAcceptance = (float)parallelSampler->GetNumAcceptedProposals()/counter;
+        else
+            m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
         m_NumParticles = particleGrid->m_NumParticles;
         m_NumConnections = particleGrid->m_NumConnections;
 
@@ -336,6 +399,16 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     }
     clock.Stop();
 
+    if (parallelSampler!=nullptr)
+        parallelSampler->PrintStatistics();
+    delete parallelSampler;
+    for (std::size_t t=0; t<threadSamplers.size(); t++)
+    {
+        delete threadSamplers[t];
+        delete threadEncomps[t];
+        delete threadInterpolators[t];
+    }
+
     delete sampler;
     delete encomp;
     delete interpolator;
@@ -73,6 +73,7 @@ public:
     itkSetMacro( LoadParameterFile, std::string )   ///< Parameter file.
     itkSetMacro( SaveParameterFile, std::string )
     itkSetMacro( LutPath, std::string )             ///< Path to lookuptables. Default is binary directory.
+    itkSetMacro( NumSamplerThreads, int )           ///< Number of threads sampling slabs of the particle grid concurrently. Default is 1 (single Markov chain).
 
     /** Getter. */
     itkGetMacro( ParticleWeight, float )
@@ -85,6 +86,7 @@ public:
     itkGetMacro( ProposalAcceptance, float )
     itkGetMacro( Steps, unsigned int)
     itkGetMacro( IsInValidState, bool)
+    itkGetMacro( NumSamplerThreads, int )
     FiberPolyDataType GetFiberBundle();             ///< Output fibers
 
     /** Input images. */
@@ -138,11 +140,12 @@ protected:
     std::string     m_SaveParameterFile;    ///< filename of parameter file (writer)
     std::string     m_LutPath;              ///< path to lookuptables used by the sphere interpolator
     bool            m_IsInValidState;       ///< Whether the filter is in a valid state, false if error occured
+    int             m_NumSamplerThreads;    ///< number of threads running the Metropolis Hastings sampler
 
     FiberPolyDataType m_FiberPolyData;      ///< container for reconstructed fibers
 
     //Constant values
-    static const int m_ParticleGridCellCapacity = 1024;
+    static const int m_ParticleGridCellCapacity = 32;  ///< initial capacity, grows if cells overflow
 };
 }
 
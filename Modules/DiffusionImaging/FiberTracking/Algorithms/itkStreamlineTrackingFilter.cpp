@@ -20,11 +20,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 
 #include "itkStreamlineTrackingFilter.h"
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIterator.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -36,9 +39,9 @@ StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
 ::StreamlineTrackingFilter()
     : m_FiberPolyData(NULL)
-    , m_Points(NULL)
-    , m_Cells(NULL)
     , m_FaImage(NULL)
+    , m_FaBuffer(NULL)
+    , m_MaskBuffer(NULL)
     , m_NumberOfInputs(1)
     , m_FaThreshold(0.2)
     , m_MinCurvatureRadius(0)
@@ -53,6 +56,7 @@ TPDPixelType>
     , m_ResampleFibers(false)
     , m_SeedImage(NULL)
     , m_MaskImage(NULL)
+    , m_NextSeed(0)
 {
     // At least 1 inputs is necessary for a vector image.
     // For images added one at a time we need at least six
@@ -75,8 +79,6 @@ TPDPixelType>
 ::BeforeThreadedGenerateData()
 {
     m_FiberPolyData = FiberPolyDataType::New();
-    m_Points = vtkSmartPointer< vtkPoints >::New();
-    m_Cells = vtkSmartPointer< vtkCellArray >::New();
 
     InputImageType* inputImage = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
     m_ImageSize.resize(3);
@@ -105,13 +107,6 @@ TPDPixelType>
     if (m_ResampleFibers)
         m_PointPistance = 0.5*minSpacing;
 
-    m_PolyDataContainer = itk::VectorContainer< int, FiberPolyDataType >::New();
-    for (unsigned int i=0; i<this->GetNumberOfThreads(); i++)
-    {
-        FiberPolyDataType poly = FiberPolyDataType::New();
-        m_PolyDataContainer->InsertElement(i, poly);
-    }
-
     if (m_SeedImage.IsNull())
     {
         // initialize mask image
@@ -149,6 +144,15 @@ TPDPixelType>
         useUserFaImage = false;
     }
 
+    // the tracking reads the voxels of all images through the same buffer offsets
+    if (m_SeedImage->GetBufferedRegion()!=inputImage->GetLargestPossibleRegion()
+            || m_MaskImage->GetBufferedRegion()!=inputImage->GetLargestPossibleRegion()
+            || m_FaImage->GetBufferedRegion()!=inputImage->GetLargestPossibleRegion())
+        itkExceptionMacro(<< "Seed, mask and FA image need to cover the same region as the tensor image.");
+
+    m_PdImage.clear();
+    m_EmaxImage.clear();
+    m_InputImage.clear();
     m_NumberOfInputs = 0;
     for (unsigned int i=0; i<this->GetNumberOfIndexedInputs(); i++)
     {
@@ -179,34 +183,97 @@ TPDPixelType>
     }
     MITK_INFO << "Processing " << m_NumberOfInputs << " tensor files";
 
+    m_TensorBuffer.clear();
+    m_PdBuffer.clear();
+    m_EmaxBuffer.clear();
+    for (int i=0; i<m_NumberOfInputs; i++)
+    {
+        if (m_InputImage.at(i)->GetBufferedRegion()!=inputImage->GetLargestPossibleRegion())
+            itkExceptionMacro(<< "All tensor images need to cover the same region.");
+        m_TensorBuffer.push_back(m_InputImage.at(i)->GetBufferPointer());
+        m_PdBuffer.push_back(m_PdImage.at(i)->GetBufferPointer());
+        m_EmaxBuffer.push_back(m_EmaxImage.at(i)->GetBufferPointer());
+    }
+    m_FaBuffer = m_FaImage->GetBufferPointer();
+    m_MaskBuffer = m_MaskImage->GetBufferPointer();
+
     typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
-    typename TensorType::EigenValuesArrayType eigenvalues;
-    typename TensorType::EigenVectorsMatrixType eigenvectors;
+    float* faBuffer = m_FaImage->GetBufferPointer();
+    long numVoxels = static_cast<long>(m_ImageSize[0])*m_ImageSize[1]*m_ImageSize[2];
 
+#pragma omp parallel for
+    for (long v=0; v<numVoxels; v++)
+    {
+        typename TensorType::EigenValuesArrayType eigenvalues;
+        typename TensorType::EigenVectorsMatrixType eigenvectors;
+        float fa = 0;
+        for (int i=0; i<m_NumberOfInputs; i++)
+        {
+            const typename InputImageType::PixelType& tensor = m_TensorBuffer.at(i)[v];
+            vnl_vector_fixed<double,3> dir;
+            tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
+            dir[0] = eigenvectors(2, 0);
+            dir[1] = eigenvectors(2, 1);
+            dir[2] = eigenvectors(2, 2);
+            dir.normalize();
+            m_PdImage.at(i)->GetBufferPointer()[v] = dir;
+            fa = fa + tensor.GetFractionalAnisotropy();
+            m_EmaxImage.at(i)->GetBufferPointer()[v] = 2/eigenvalues[2];
+        }
+        if (!useUserFaImage)
+            faBuffer[v] = fa/m_NumberOfInputs;
+    }
 
-    for (int x=0; x<m_ImageSize[0]; x++)
-        for (int y=0; y<m_ImageSize[1]; y++)
-            for (int z=0; z<m_ImageSize[2]; z++)
+    m_InverseDirection = m_InputImage.at(0)->GetDirection().GetTranspose();
+
+    // lower corner first, same order as the interpolation weights in IsValidPosition()
+    std::size_t dx = 1;
+    std::size_t dy = m_ImageSize[0];
+    std::size_t dz = static_cast<std::size_t>(m_ImageSize[0])*m_ImageSize[1];
+    m_CornerOffsets[0] = 0;
+    m_CornerOffsets[1] = dx;
+    m_CornerOffsets[2] = dy;
+    m_CornerOffsets[3] = dz;
+    m_CornerOffsets[4] = dx+dy;
+    m_CornerOffsets[5] = dy+dz;
+    m_CornerOffsets[6] = dz+dx;
+    m_CornerOffsets[7] = dx+dy+dz;
+
+    // seeds in the order of the former region iteration: image, voxel, seed in the voxel
+    m_Seeds.clear();
+    for (int img=0; img<m_NumberOfInputs; img++)
+    {
+        ImageRegionConstIteratorWithIndex< ItkUcharImgType > sit(m_SeedImage, m_SeedImage->GetLargestPossibleRegion());
+        for (sit.GoToBegin(); !sit.IsAtEnd(); ++sit)
+        {
+            typename InputImageType::IndexType index = sit.GetIndex();
+            std::size_t offset = this->GetOffset(index);
+            if (sit.Value()==0 || m_FaBuffer[offset]<m_FaThreshold || m_MaskBuffer[offset]==0)
+                continue;
+
+            for (int s=0; s<m_SeedsPerVoxel; s++)
             {
-                typename InputImageType::IndexType index;
-                index[0] = x; index[1] = y; index[2] = z;
-                for (int i=0; i<m_NumberOfInputs; i++)
+                Seed seed;
+                seed.m_ImageIdx = img;
+                if (m_SeedsPerVoxel>1)
                 {
-                    typename InputImageType::PixelType tensor = m_InputImage.at(i)->GetPixel(index);
-                    vnl_vector_fixed<double,3> dir;
-                    tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
-                    dir[0] = eigenvectors(2, 0);
-                    dir[1] = eigenvectors(2, 1);
-                    dir[2] = eigenvectors(2, 2);
-                    dir.normalize();
-                    m_PdImage.at(i)->SetPixel(index, dir);
-                    if (!useUserFaImage)
-                        m_FaImage->SetPixel(index, m_FaImage->GetPixel(index)+tensor.GetFractionalAnisotropy());
-                    m_EmaxImage.at(i)->SetPixel(index, 2/eigenvalues[2]);
+                    seed.m_Position[0] = index[0]+(double)(rand()%99-49)/100;
+                    seed.m_Position[1] = index[1]+(double)(rand()%99-49)/100;
+                    seed.m_Position[2] = index[2]+(double)(rand()%99-49)/100;
                 }
-                if (!useUserFaImage)
-                    m_FaImage->SetPixel(index, m_FaImage->GetPixel(index)/m_NumberOfInputs);
+                else
+                {
+                    seed.m_Position[0] = index[0];
+                    seed.m_Position[1] = index[1];
+                    seed.m_Position[2] = index[2];
+                }
+                m_Seeds.push_back(seed);
             }
+        }
+    }
+    m_NextSeed = 0;
+    m_FiberBuffers.clear();
+    m_FiberBuffers.resize(this->GetNumberOfThreads());
 
     if (m_Interpolate)
         std::cout << "StreamlineTrackingFilter: using trilinear interpolation" << std::endl;
@@ -226,15 +293,14 @@ TPDPixelType>
     std::cout << "StreamlineTrackingFilter: stepsize: " << m_StepSize << " mm" << std::endl;
     std::cout << "StreamlineTrackingFilter: f: " << m_F << std::endl;
     std::cout << "StreamlineTrackingFilter: g: " << m_G << std::endl;
-    std::cout << "StreamlineTrackingFilter: starting streamline tracking using " << this->GetNumberOfThreads() << " threads." << std::endl;
+    std::cout << "StreamlineTrackingFilter: starting streamline tracking from " << m_Seeds.size() << " seeds using " << this->GetNumberOfThreads() << " threads." << std::endl;
 }
 
 template< class TTensorPixelType, class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 ::CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index)
 {
-    vnl_matrix_fixed< double, 3, 3 > rot = m_InputImage.at(0)->GetDirection().GetTranspose();
-    dir = rot*dir;
+    dir = m_InverseDirection*dir;
     if (true)
     {
         dir *= m_StepSize;
@@ -390,7 +456,9 @@ template< class TTensorPixelType, class TPDPixelType>
 bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 ::IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType &index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx)
 {
-    if (!m_InputImage.at(imageIdx)->GetLargestPossibleRegion().IsInside(index) || m_MaskImage->GetPixel(index)==0)
+    if (index[0]<0 || index[1]<0 || index[2]<0 || index[0]>=m_ImageSize[0] || index[1]>=m_ImageSize[1] || index[2]>=m_ImageSize[2])
+        return false;
+    if (m_MaskBuffer[this->GetOffset(index)]==0)
         return false;
 
     if (m_Interpolate)
@@ -436,27 +504,15 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
         interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
 
-        typename InputImageType::IndexType tmpIdx;
-        double FA = m_FaImage->GetPixel(index) * interpWeights[0];
-        tmpIdx = index; tmpIdx[0]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[1];
-        tmpIdx = index; tmpIdx[1]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[2];
-        tmpIdx = index; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[3];
-        tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[4];
-        tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[5];
-        tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[6];
-        tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[7];
+        const float* fa = m_FaBuffer + this->GetOffset(index);
+        double FA = fa[0] * interpWeights[0];
+        for (int c=1; c<8; c++)
+            FA += fa[m_CornerOffsets[c]] * interpWeights[c];
 
         if (FA<m_FaThreshold)
             return false;
     }
-    else if (m_FaImage->GetPixel(index)<m_FaThreshold)
+    else if (m_FaBuffer[this->GetOffset(index)]<m_FaThreshold)
         return false;
 
     return true;
@@ -464,7 +520,7 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 
 template< class TTensorPixelType, class TPDPixelType>
 double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
-::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids, int imageIdx)
+::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< float >& points, int imageIdx)
 {
     double tractLength = 0;
     typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
@@ -483,7 +539,7 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
     index[1] = RoundToNearest(pos[1]);
     index[2] = RoundToNearest(pos[2]);
 
-    vnl_vector_fixed<double,3> dir = m_PdImage.at(imageIdx)->GetPixel(index);
+    vnl_vector_fixed<double,3> dir = m_PdBuffer.at(imageIdx)[this->GetOffset(index)];
     dir *= dirSign;                     // reverse direction
     vnl_vector_fixed<double,3> dirOld = dir;
     if (dir.magnitude()<mitk::eps)
@@ -498,8 +554,6 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         // is new position valid (inside image, above FA threshold etc.)
         if (!IsValidPosition(pos, index, interpWeights, imageIdx))   // if not end streamline
         {
-//            m_SeedImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-//            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
             return tractLength;
         }
         else if (distance>=m_PointPistance)
@@ -507,7 +561,9 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
             tractLength +=  m_StepSize;
             distanceInVoxel += m_StepSize;
             m_SeedImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+            points.push_back(worldPos[0]);
+            points.push_back(worldPos[1]);
+            points.push_back(worldPos[2]);
             distance = 0;
         }
 
@@ -515,15 +571,16 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         {
             if (indexOld!=index)                    // did we enter a new voxel? if yes, calculate new direction
             {
+                std::size_t offset = this->GetOffset(index);
                 double minAngle = 0;
                 for (int img=0; img<m_NumberOfInputs; img++)
                 {
-                    vnl_vector_fixed<double,3> newDir = m_PdImage.at(img)->GetPixel(index);   // get principal direction
+                    vnl_vector_fixed<double,3> newDir = m_PdBuffer[img][offset];   // get principal direction
                     if (newDir.magnitude()<mitk::eps)
                         continue;
 
-                    typename InputImageType::PixelType tensor = m_InputImage.at(img)->GetPixel(index);
-                    double scale = m_EmaxImage.at(img)->GetPixel(index);
+                    const typename InputImageType::PixelType& tensor = m_TensorBuffer[img][offset];
+                    double scale = m_EmaxBuffer[img][offset];
                     newDir[0] = m_F*newDir[0] + (1-m_F)*( (1-m_G)*dirOld[0] + scale*m_G*(tensor[0]*dirOld[0] + tensor[1]*dirOld[1] + tensor[2]*dirOld[2]));
                     newDir[1] = m_F*newDir[1] + (1-m_F)*( (1-m_G)*dirOld[1] + scale*m_G*(tensor[1]*dirOld[0] + tensor[3]*dirOld[1] + tensor[4]*dirOld[2]));
                     newDir[2] = m_F*newDir[2] + (1-m_F)*( (1-m_G)*dirOld[2] + scale*m_G*(tensor[2]*dirOld[0] + tensor[4]*dirOld[1] + tensor[5]*dirOld[2]));
@@ -564,132 +621,37 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         else // use trilinear interpolation (weights calculated in IsValidPosition())
         {
             typename InputImageType::PixelType tensor;
-
-            typename InputImageType::IndexType tmpIdx = index;
-            typename InputImageType::PixelType tmpTensor;
+            std::size_t offset = this->GetOffset(index);
 
             if (m_NumberOfInputs>1)
             {
-                double minAngle = 0;
-                for (int img=0; img<m_NumberOfInputs; img++)
+                // in each corner, use the tensor whose principal direction fits best to the current direction
+                typename InputImageType::PixelType tmpTensor;
+                for (int c=0; c<8; c++)
                 {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
+                    std::size_t cornerOffset = offset + m_CornerOffsets[c];
+                    double minAngle = 0;
+                    for (int img=0; img<m_NumberOfInputs; img++)
                     {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
+                        double angle = dot_product(dirOld, m_PdBuffer[img][cornerOffset]);
+                        if (fabs(angle)>minAngle)
+                        {
+                            minAngle = angle;
+                            tmpTensor = m_TensorBuffer[img][cornerOffset];
+                        }
                     }
+                    if (c==0)
+                        tensor = tmpTensor * interpWeights[0];
+                    else
+                        tensor += tmpTensor * interpWeights[c];
                 }
-                tensor = tmpTensor * interpWeights[0];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[0]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[1];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[1]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[2];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[2]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[3];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[4];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[5];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[6];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[7];
             }
             else
             {
-                tensor = m_InputImage.at(0)->GetPixel(index) * interpWeights[0];
-                typename InputImageType::IndexType tmpIdx = index; tmpIdx[0]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[1];
-                tmpIdx = index; tmpIdx[1]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[2];
-                tmpIdx = index; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[3];
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[4];
-                tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[5];
-                tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[6];
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[7];
+                const typename InputImageType::PixelType* tensors = m_TensorBuffer[0] + offset;
+                tensor = tensors[0] * interpWeights[0];
+                for (int c=1; c<8; c++)
+                    tensor += tensors[m_CornerOffsets[c]] * interpWeights[c];
             }
 
             tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
@@ -733,148 +695,113 @@ template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
+::ThreadedGenerateData(const OutputImageRegionType&,
                        ThreadIdType threadId)
 {
-    FiberPolyDataType poly = m_PolyDataContainer->GetElement(threadId);
-    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> Cells = vtkSmartPointer<vtkCellArray>::New();
-
-    typedef itk::DiffusionTensor3D<TTensorPixelType>        TensorType;
-    typedef ImageRegionConstIterator< InputImageType >      InputIteratorType;
-    typedef ImageRegionConstIterator< ItkUcharImgType >     MaskIteratorType;
-    typedef ImageRegionConstIterator< ItkFloatImgType >     doubleIteratorType;
-    typedef typename InputImageType::PixelType              InputTensorType;
+    // the fibers differ a lot in length, small chunks of seeds keep all threads busy until the end
+    const std::size_t chunkSize = 16;
 
-    MaskIteratorType    sit(m_SeedImage, outputRegionForThread );
-    doubleIteratorType   fit(m_FaImage, outputRegionForThread );
-    MaskIteratorType    mit(m_MaskImage, outputRegionForThread );
-
-    for (int img=0; img<m_NumberOfInputs; img++)
+    FiberBuffer& buffer = m_FiberBuffers.at(threadId);
+    itk::Point<double> worldPos;
+    while (true)
     {
-        sit.GoToBegin();
-        mit.GoToBegin();
-        fit.GoToBegin();
-        itk::Point<double> worldPos;
-        while( !sit.IsAtEnd() )
-        {
-            if (sit.Value()==0 || fit.Value()<m_FaThreshold || mit.Value()==0)
-            {
-                ++sit;
-                ++mit;
-                ++fit;
-                continue;
-            }
-
-            for (int s=0; s<m_SeedsPerVoxel; s++)
-            {
-                vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
-                std::vector< vtkIdType > pointIDs;
-                typename InputImageType::IndexType index = sit.GetIndex();
-                itk::ContinuousIndex<double, 3> start;
-                unsigned int counter = 0;
-
-                if (m_SeedsPerVoxel>1)
-                {
-                    start[0] = index[0]+(double)(rand()%99-49)/100;
-                    start[1] = index[1]+(double)(rand()%99-49)/100;
-                    start[2] = index[2]+(double)(rand()%99-49)/100;
-                }
-                else
-                {
-                    start[0] = index[0];
-                    start[1] = index[1];
-                    start[2] = index[2];
-                }
-
-                // forward tracking
-                double tractLength = FollowStreamline(start, 1, points, pointIDs, img);
-
-                // add ids to line
-                counter += pointIDs.size();
-                while (!pointIDs.empty())
-                {
-                    line->GetPointIds()->InsertNextId(pointIDs.back());
-                    pointIDs.pop_back();
-                }
-
-                // insert start point
-                m_SeedImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
-                line->GetPointIds()->InsertNextId(points->InsertNextPoint(worldPos.GetDataPointer()));
-
-                // backward tracking
-                tractLength += FollowStreamline(start, -1, points, pointIDs, img);
-
-                counter += pointIDs.size();
+        std::size_t firstSeed = m_NextSeed.fetch_add(chunkSize);
+        if (firstSeed>=m_Seeds.size())
+            break;
+        std::size_t endSeed = std::min(firstSeed+chunkSize, m_Seeds.size());
 
-                //MITK_INFO << "Tract length " << tractLength;
+        for (std::size_t s=firstSeed; s<endSeed; s++)
+        {
+            const Seed& seed = m_Seeds[s];
+            buffer.m_ForwardPoints.clear();
+            buffer.m_BackwardPoints.clear();
 
-                if (tractLength<m_MinTractLength || counter<2)
-                    continue;
+            double tractLength = FollowStreamline(seed.m_Position, 1, buffer.m_ForwardPoints, seed.m_ImageIdx);
+            tractLength += FollowStreamline(seed.m_Position, -1, buffer.m_BackwardPoints, seed.m_ImageIdx);
 
-                // add ids to line
-                for (unsigned int i=0; i<pointIDs.size(); i++)
-                    line->GetPointIds()->InsertNextId(pointIDs.at(i));
+            std::size_t counter = (buffer.m_ForwardPoints.size()+buffer.m_BackwardPoints.size())/3;
+            if (tractLength<m_MinTractLength || counter<2)
+                continue;
 
-                Cells->InsertNextCell(line);
-            }
-            ++sit;
-            ++mit;
-            ++fit;
+            typename FiberBuffer::Fiber fiber;
+            fiber.m_Seed = s;
+            fiber.m_FirstPoint = buffer.m_Points.size()/3;
+            fiber.m_NumberOfPoints = counter+1;
+            buffer.m_Fibers.push_back(fiber);
+
+            // forward points in reverse order, start point, backward points
+            for (std::size_t i=buffer.m_ForwardPoints.size(); i>0; i-=3)
+                buffer.m_Points.insert(buffer.m_Points.end(), buffer.m_ForwardPoints.begin()+i-3, buffer.m_ForwardPoints.begin()+i);
+            m_SeedImage->TransformContinuousIndexToPhysicalPoint( seed.m_Position, worldPos );
+            buffer.m_Points.push_back(worldPos[0]);
+            buffer.m_Points.push_back(worldPos[1]);
+            buffer.m_Points.push_back(worldPos[2]);
+            buffer.m_Points.insert(buffer.m_Points.end(), buffer.m_BackwardPoints.begin(), buffer.m_BackwardPoints.end());
         }
     }
-    poly->SetPoints(points);
-    poly->SetLines(Cells);
 
     std::cout << "Thread " << threadId << " finished tracking" << std::endl;
 }
 
 template< class TTensorPixelType,
           class TPDPixelType>
-vtkSmartPointer< vtkPolyData > StreamlineTrackingFilter< TTensorPixelType,
+void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2)
+::AfterThreadedGenerateData()
 {
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = poly1->GetLines();
-    vtkSmartPointer<vtkPoints> vNewPoints = poly1->GetPoints();
-
-    for( int i=0; i<poly2->GetNumberOfLines(); i++ )
-    {
-        vtkCell* cell = poly2->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+    MITK_INFO << "Generating polydata ";
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
+    // the fibers of all threads in seed order
+    std::vector< const typename FiberBuffer::Fiber* > seedFibers(m_Seeds.size(), NULL);
+    std::vector< const FiberBuffer* > seedBuffers(m_Seeds.size(), NULL);
+    vtkIdType numFibers = 0;
+    vtkIdType numPoints = 0;
+    for (std::size_t t=0; t<m_FiberBuffers.size(); t++)
+        for (std::size_t f=0; f<m_FiberBuffers[t].m_Fibers.size(); f++)
         {
-            double p[3];
-            points->GetPoint(j, p);
-
-            vtkIdType id = vNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
+            const typename FiberBuffer::Fiber& fiber = m_FiberBuffers[t].m_Fibers[f];
+            seedFibers[fiber.m_Seed] = &fiber;
+            seedBuffers[fiber.m_Seed] = &m_FiberBuffers[t];
+            numFibers++;
+            numPoints += fiber.m_NumberOfPoints;
         }
-        vNewLines->InsertNextCell(container);
-    }
 
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
+    // the point coordinates and the cell array are filled directly
+    vtkSmartPointer<vtkFloatArray> pointData = vtkSmartPointer<vtkFloatArray>::New();
+    pointData->SetNumberOfComponents(3);
+    pointData->SetNumberOfTuples(numPoints);
+    float* pointPtr = pointData->GetPointer(0);
 
-    return vNewPolyData;
-}
-template< class TTensorPixelType,
-          class TPDPixelType>
-void StreamlineTrackingFilter< TTensorPixelType,
-TPDPixelType>
-::AfterThreadedGenerateData()
-{
-    MITK_INFO << "Generating polydata ";
-    m_FiberPolyData = m_PolyDataContainer->GetElement(0);
-    for (unsigned int i=1; i<this->GetNumberOfThreads(); i++)
+    vtkSmartPointer<vtkIdTypeArray> cellData = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellData->SetNumberOfValues(numFibers+numPoints);
+    vtkIdType* cellPtr = cellData->GetPointer(0);
+
+    vtkIdType pointId = 0;
+    for (std::size_t s=0; s<seedFibers.size(); s++)
     {
-        m_FiberPolyData = AddPolyData(m_FiberPolyData, m_PolyDataContainer->GetElement(i));
+        if (seedFibers[s]==NULL)
+            continue;
+
+        const typename FiberBuffer::Fiber& fiber = *seedFibers[s];
+        const float* fiberPoints = &seedBuffers[s]->m_Points[3*fiber.m_FirstPoint];
+        std::copy(fiberPoints, fiberPoints+3*fiber.m_NumberOfPoints, pointPtr+3*pointId);
+
+        *cellPtr++ = fiber.m_NumberOfPoints;
+        for (std::size_t j=0; j<fiber.m_NumberOfPoints; j++)
+            *cellPtr++ = pointId++;
     }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(pointData);
+    vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+    cells->SetCells(numFibers, cellData);
+
+    m_FiberPolyData = FiberPolyDataType::New();
+    m_FiberPolyData->SetPoints(points);
+    m_FiberPolyData->SetLines(cells);
+
+    m_FiberBuffers.clear();
+    m_Seeds.clear();
     MITK_INFO << "done";
 }
 
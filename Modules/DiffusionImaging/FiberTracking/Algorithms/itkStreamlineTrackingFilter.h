@@ -24,7 +24,6 @@ This file is based heavily on a corresponding ITK filter.
 
 #include <MitkFiberTrackingExports.h>
 #include <itkImageToImageFilter.h>
-#include <itkVectorContainer.h>
 #include <itkVectorImage.h>
 #include <itkDiffusionTensor3D.h>
 #include <vtkSmartPointer.h>
@@ -33,10 +32,18 @@ This file is based heavily on a corresponding ITK filter.
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
 
+#include <atomic>
+#include <vector>
+
 namespace itk{
 
 /**
-* \brief Performes deterministic streamline tracking on the input tensor image.   */
+* \brief Performes deterministic streamline tracking on the input tensor image.
+*
+* All seeds are collected before tracking. The threads take small chunks of seeds from a shared queue, so
+* threads with many short fibers do not wait for threads with few long ones. Every thread writes its fibers
+* into its own point buffer, the buffers are merged in seed order into the output polydata afterwards, so the
+* result does not depend on the number of threads.   */
 
   template< class TTensorPixelType, class TPDPixelType=double>
   class StreamlineTrackingFilter :
@@ -90,26 +97,60 @@ namespace itk{
     ~StreamlineTrackingFilter() {}
     void PrintSelf(std::ostream& os, Indent indent) const;
 
+    /** \brief Streamline seed, the seeds are processed in chunks from a queue shared by all threads. */
+    struct Seed
+    {
+        itk::ContinuousIndex<double, 3> m_Position;
+        int                             m_ImageIdx;
+    };
+
+    /** \brief Fibers tracked by one thread. */
+    struct FiberBuffer
+    {
+        struct Fiber
+        {
+            std::size_t m_Seed;
+            std::size_t m_FirstPoint;
+            std::size_t m_NumberOfPoints;
+        };
+
+        std::vector< float >    m_Points;           ///< x, y and z of all fiber points
+        std::vector< Fiber >    m_Fibers;
+        std::vector< float >    m_ForwardPoints;    ///< reused for every seed
+        std::vector< float >    m_BackwardPoints;   ///< reused for every seed
+    };
+
     void CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index);    ///< Calculate next integration step.
-    double FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids, int imageIdx);       ///< Start streamline in one direction.
+    double FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< float >& points, int imageIdx);       ///< Start streamline in one direction. Appends the world coordinates of the new points.
     bool IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType& index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx);   ///< Are we outside of the mask image? Is the FA too low?
 
+    /** \brief Offset of the voxel in the buffers of all images, they share the same region. */
+    std::size_t GetOffset(const typename InputImageType::IndexType& index) const
+    {
+        return index[0] + m_ImageSize[0]*(index[1] + static_cast<std::size_t>(m_ImageSize[1])*index[2]);
+    }
+
     double RoundToNearest(double num);
     void BeforeThreadedGenerateData();
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
     void AfterThreadedGenerateData();
 
-    FiberPolyDataType AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2);    ///< Combine tracking results generated by the individual threads.
-
     FiberPolyDataType               m_FiberPolyData;
-    vtkSmartPointer<vtkPoints>      m_Points;
-    vtkSmartPointer<vtkCellArray>   m_Cells;
 
     std::vector< ItkDoubleImgType::Pointer >         m_EmaxImage;    ///< Stores largest eigenvalues per voxel (one for each tensor)
     ItkFloatImgType::Pointer                        m_FaImage;      ///< FA image used to determine streamline termination.
     std::vector< ItkPDImgType::Pointer >            m_PdImage;      ///< Stores principal direction of each tensor in each voxel.
     std::vector< typename InputImageType::Pointer > m_InputImage;   ///< Input tensor images. For multi tensor tracking provide multiple tensor images.
 
+    // buffers of the images above, accessed with GetOffset() during tracking
+    std::vector< const typename InputImageType::PixelType* >    m_TensorBuffer;
+    std::vector< const vnl_vector_fixed<double,3>* >            m_PdBuffer;
+    std::vector< const double* >                                m_EmaxBuffer;
+    const float*                                                m_FaBuffer;
+    const unsigned char*                                        m_MaskBuffer;
+    std::size_t                                                 m_CornerOffsets[8];    ///< offsets of the voxels used for trilinear interpolation
+    vnl_matrix_fixed< double, 3, 3 >                            m_InverseDirection;
+
     int     m_NumberOfInputs;
     double   m_FaThreshold;
     double   m_MinCurvatureRadius;
@@ -127,7 +168,9 @@ namespace itk{
     ItkUcharImgType::Pointer    m_SeedImage;
     ItkUcharImgType::Pointer    m_MaskImage;
 
-    itk::VectorContainer< int, FiberPolyDataType >::Pointer m_PolyDataContainer;
+    std::vector< Seed >         m_Seeds;
+    std::atomic< std::size_t >  m_NextSeed;
+    std::vector< FiberBuffer >  m_FiberBuffers;     ///< one per thread
 
   private:
 
@@ -20,6 +20,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
 #include <vtkCell.h>
+#include <vtkFloatArray.h>
+
+#include "mitkFiberSlabBinning.h"
 
 // misc
 #include <math.h>
@@ -38,6 +41,7 @@ TractDensityImageFilter< OutputImageType >::TractDensityImageFilter()
     , m_OutputAbsoluteValues(false)
     , m_UseTrilinearInterpolation(false)
     , m_DoFiberResampling(true)
+    , m_UseFiberWeights(true)
 {
 
 }
@@ -137,91 +141,123 @@ void TractDensityImageFilter< OutputImageType >::GenerateData()
     MITK_INFO << "TractDensityImageFilter: starting image generation";
 
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    vtkSmartPointer<vtkFloatArray> fiberWeights = m_FiberBundle->GetFiberWeights();
+    const ImageRegion<3>& region = outImage->GetLargestPossibleRegion();
+
+    // voxel index of the fiber point and, for trilinear interpolation, of the lower corner of its 2x2x2 neighbourhood
+    auto locatePoint = [&](vtkIdType pointId, itk::Index<3>& index, float& frac_x, float& frac_y, float& frac_z) -> bool
     {
-        ++disp;
-        vtkIdType   numPoints(0);
-        vtkIdType*  points(NULL);
-        vLines->GetNextCell ( numPoints, points );
-        float weight = m_FiberBundle->GetFiberWeight(i);
+        double point[3];
+        fiberPolyData->GetPoint(pointId, point);
+        itk::Point<float, 3> vertex = GetItkPoint(point);
+        outImage->TransformPhysicalPointToIndex(vertex, index);
+        if (!m_UseTrilinearInterpolation)
+            return region.IsInside(index);
 
-        // fill output image
-        for( int j=0; j<numPoints; j++)
-        {
-            itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-            itk::Index<3> index;
-            itk::ContinuousIndex<float, 3> contIndex;
-            outImage->TransformPhysicalPointToIndex(vertex, index);
-            outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+        itk::ContinuousIndex<float, 3> contIndex;
+        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
 
-            if (!m_UseTrilinearInterpolation && outImage->GetLargestPossibleRegion().IsInside(index))
-            {
-                if (m_BinaryOutput)
-                    outImage->SetPixel(index, 1);
-                else
-                    outImage->SetPixel(index, outImage->GetPixel(index)+0.01*weight);
-                continue;
-            }
+        frac_x = contIndex[0] - index[0];
+        frac_y = contIndex[1] - index[1];
+        frac_z = contIndex[2] - index[2];
 
-            float frac_x = contIndex[0] - index[0];
-            float frac_y = contIndex[1] - index[1];
-            float frac_z = contIndex[2] - index[2];
+        if (frac_x<0)
+        {
+            index[0] -= 1;
+            frac_x += 1;
+        }
+        if (frac_y<0)
+        {
+            index[1] -= 1;
+            frac_y += 1;
+        }
+        if (frac_z<0)
+        {
+            index[2] -= 1;
+            frac_z += 1;
+        }
 
-            if (frac_x<0)
-            {
-                index[0] -= 1;
-                frac_x += 1;
-            }
-            if (frac_y<0)
-            {
-                index[1] -= 1;
-                frac_y += 1;
-            }
-            if (frac_z<0)
-            {
-                index[2] -= 1;
-                frac_z += 1;
-            }
+        frac_x = 1-frac_x;
+        frac_y = 1-frac_y;
+        frac_z = 1-frac_z;
 
-            frac_x = 1-frac_x;
-            frac_y = 1-frac_y;
-            frac_z = 1-frac_z;
+        // int coordinates inside image?
+        if (index[0] < 0 || index[0] >= w-1)
+            return false;
+        if (index[1] < 0 || index[1] >= h-1)
+            return false;
+        if (index[2] < 0 || index[2] >= d-1)
+            return false;
+        return true;
+    };
 
-            // int coordinates inside image?
-            if (index[0] < 0 || index[0] >= w-1)
-                continue;
-            if (index[1] < 0 || index[1] >= h-1)
-                continue;
-            if (index[2] < 0 || index[2] >= d-1)
-                continue;
+    // the slabs of z-slices are filled in parallel, each in the order of a serial loop over the fibers
+    mitk::FiberSlabBinning binning;
+    binning.Build(fiberPolyData, d, [&](int, vtkIdType pointId, int& zMin, int& zMax) -> bool
+    {
+        itk::Index<3> index;
+        float frac_x, frac_y, frac_z;
+        if (!locatePoint(pointId, index, frac_x, frac_y, frac_z))
+            return false;
+        zMin = index[2];
+        zMax = m_UseTrilinearInterpolation ? index[2]+1 : index[2];
+        return true;
+    });
 
-            if (m_BinaryOutput)
-            {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] = 1;
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] = 1;
-            }
-            else
+    int numSlabs = binning.GetNumberOfSlabs();
+    boost::progress_display disp(numSlabs);
+#pragma omp parallel for schedule(dynamic)
+    for (int s=0; s<numSlabs; s++)
+    {
+        int zBegin = binning.GetSlabBegin(s);
+        int zEnd = binning.GetSlabEnd(s);
+        for (std::size_t r=0; r<binning.GetNumberOfRuns(s); r++)
+        {
+            const mitk::FiberSlabBinning::Run& run = binning.GetRun(s, r);
+            const vtkIdType* points = binning.GetFiberPointIds(run.m_Fiber);
+            float weight = m_UseFiberWeights ? fiberWeights->GetValue(run.m_Fiber) : 1;
+
+            for (int j=run.m_FirstPoint; j<run.m_FirstPoint+run.m_NumberOfPoints; j++)
             {
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]  ))] += (  frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]  ))] += (  frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]  + h*index[2]+h))] += (  frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]   + w*(index[1]+1+ h*index[2]+h))] += (  frac_x)*(1-frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]  ))] += (1-frac_x)*(  frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]  + h*index[2]+h))] += (1-frac_x)*(  frac_y)*(1-frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]  ))] += (1-frac_x)*(1-frac_y)*(  frac_z);
-                outImageBufferPointer[( index[0]+1 + w*(index[1]+1+ h*index[2]+h))] += (1-frac_x)*(1-frac_y)*(1-frac_z);
+                itk::Index<3> index;
+                float frac_x, frac_y, frac_z;
+                locatePoint(points[j], index, frac_x, frac_y, frac_z);
+
+                if (!m_UseTrilinearInterpolation)
+                {
+                    OutPixelType& pixel = outImageBufferPointer[index[0] + w*(index[1] + h*index[2])];
+                    if (m_BinaryOutput)
+                        pixel = 1;
+                    else
+                        pixel = pixel+0.01*weight;
+                    continue;
+                }
+
+                // only the corners inside of this slab
+                for (int dz=0; dz<2; dz++)
+                {
+                    int z = index[2]+dz;
+                    if (z<zBegin || z>=zEnd)
+                        continue;
+                    float weight_z = dz ? 1-frac_z : frac_z;
+                    for (int dy=0; dy<2; dy++)
+                    {
+                        float weight_y = dy ? 1-frac_y : frac_y;
+                        for (int dx=0; dx<2; dx++)
+                        {
+                            float weight_x = dx ? 1-frac_x : frac_x;
+                            OutPixelType& pixel = outImageBufferPointer[index[0]+dx + w*(index[1]+dy + h*z)];
+                            if (m_BinaryOutput)
+                                pixel = 1;
+                            else
+                                pixel += weight_x*weight_y*weight_z*weight;
+                        }
+                    }
+                }
             }
         }
+#pragma omp critical
+        ++disp;
     }
 
     if (!m_OutputAbsoluteValues && !m_BinaryOutput)
@@ -25,7 +25,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace itk{
 
 /**
-* \brief Generates tract density images from input fiberbundles (Calamante 2010).   */
+* \brief Generates tract density images from input fiberbundles (Calamante 2010).
+*
+* The fiber points are splatted into slabs of z-slices in parallel (mitk::FiberSlabBinning). Each voxel
+* accumulates its contributions in fiber order, so the image does not depend on the number of threads.   */
 
 template< class OutputImageType >
 class TractDensityImageFilter : public ImageSource< OutputImageType >
@@ -57,6 +60,8 @@ public:
   itkSetMacro( InputImage, typename OutputImageType::Pointer)   ///< use input image geometry to initialize output image
   itkSetMacro( UseTrilinearInterpolation, bool )
   itkSetMacro( DoFiberResampling, bool )
+  itkSetMacro( UseFiberWeights, bool )                          ///< scale the contribution of each fiber with its weight (FiberBundle::GetFiberWeights())
+  itkGetMacro( UseFiberWeights, bool )
 
   void GenerateData();
 
@@ -76,6 +81,7 @@ protected:
   bool                              m_OutputAbsoluteValues; ///< do not normalize image values to 0-1
   bool                              m_UseTrilinearInterpolation;
   bool                              m_DoFiberResampling;
+  bool                              m_UseFiberWeights;
 };
 
 }
@@ -19,6 +19,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPolyLine.h>
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
+#include <vtkFloatArray.h>
+
+#include "mitkFiberSlabBinning.h"
 
 // misc
 #include <math.h>
@@ -31,6 +34,7 @@ namespace itk{
     : m_UpsamplingFactor(1)
     , m_InputImage(NULL)
     , m_UseImageGeometry(false)
+    , m_UseFiberWeights(false)
   {
 
   }
@@ -108,9 +112,7 @@ namespace itk{
 
     // set/initialize output
     unsigned char* outImageBufferPointer = (unsigned char*)outImage->GetBufferPointer();
-    float* buffer = new float[w*h*d*4];
-    for (int i=0; i<w*h*d*4; i++)
-      buffer[i] = 0;
+    std::vector< float > buffer(static_cast<std::size_t>(w)*h*d*4, 0);
 
     // resample fiber bundle
     float minSpacing = 1;
@@ -125,135 +127,127 @@ namespace itk{
     m_FiberBundle->ResampleSpline(minSpacing);
 
     vtkSmartPointer<vtkPolyData> fiberPolyData = m_FiberBundle->GetFiberPolyData();
-    vtkSmartPointer<vtkCellArray> vLines = fiberPolyData->GetLines();
-    vLines->InitTraversal();
+    vtkSmartPointer<vtkFloatArray> fiberWeights = m_FiberBundle->GetFiberWeights();
 
-    int numFibers = m_FiberBundle->GetNumFibers();
-    boost::progress_display disp(numFibers);
-    for( int i=0; i<numFibers; i++ )
+    // lower corner of the 2x2x2 neighbourhood of the fiber point
+    auto locatePoint = [&](vtkIdType pointId, int& px, int& py, int& pz, float& frac_x, float& frac_y, float& frac_z) -> bool
     {
-      ++disp;
-      vtkIdType   numPoints(0);
-      vtkIdType*  points(NULL);
-      vLines->GetNextCell ( numPoints, points );
-
-      // calc directions (which are used as weights)
-      std::list< itk::Point<float, 3> > rgbweights;
-      std::list<float> intensities;
-
-      for( int j=0; j<numPoints-1; j++)
+      double point[3];
+      fiberPolyData->GetPoint(pointId, point);
+      itk::Point<float, 3> vertex = GetItkPoint(point);
+      itk::Index<3> index;
+      itk::ContinuousIndex<float, 3> contIndex;
+      outImage->TransformPhysicalPointToIndex(vertex, index);
+      outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
+
+      frac_x = contIndex[0] - index[0];
+      frac_y = contIndex[1] - index[1];
+      frac_z = contIndex[2] - index[2];
+
+      px = index[0];
+      if (frac_x<0)
       {
+        px -= 1;
+        frac_x += 1;
+      }
 
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-        itk::Point<float, 3> vertexPost = GetItkPoint(fiberPolyData->GetPoint(points[j+1]));
-
-        itk::Point<float, 3> dir;
-        dir[0] = fabs((vertexPost[0] - vertex[0]) * outImage->GetSpacing()[0]);
-        dir[1] = fabs((vertexPost[1] - vertex[1]) * outImage->GetSpacing()[1]);
-        dir[2] = fabs((vertexPost[2] - vertex[2]) * outImage->GetSpacing()[2]);
-
-        rgbweights.push_back(dir);
-
-        float intensity = sqrt(dir[0]*dir[0]+dir[1]*dir[1]+dir[2]*dir[2]);
-        intensities.push_back(intensity);
-
-        // last point gets same as previous one
-        if(j==numPoints-2)
-        {
-          rgbweights.push_back(dir);
-          intensities.push_back(intensity);
-        }
+      py = index[1];
+      if (frac_y<0)
+      {
+        py -= 1;
+        frac_y += 1;
       }
 
-      // fill output image
-      for( int j=0; j<numPoints; j++)
+      pz = index[2];
+      if (frac_z<0)
       {
-        itk::Point<float, 3> vertex = GetItkPoint(fiberPolyData->GetPoint(points[j]));
-        itk::Index<3> index;
-        itk::ContinuousIndex<float, 3> contIndex;
-        outImage->TransformPhysicalPointToIndex(vertex, index);
-        outImage->TransformPhysicalPointToContinuousIndex(vertex, contIndex);
-
-        float frac_x = contIndex[0] - index[0];
-        float frac_y = contIndex[1] - index[1];
-        float frac_z = contIndex[2] - index[2];
-
-        int px = index[0];
-        if (frac_x<0)
-        {
-          px -= 1;
-          frac_x += 1;
-        }
+        pz -= 1;
+        frac_z += 1;
+      }
 
-        int py = index[1];
-        if (frac_y<0)
-        {
-          py -= 1;
-          frac_y += 1;
-        }
+      // int coordinates inside image?
+      if (px < 0 || px >= w-1)
+        return false;
+      if (py < 0 || py >= h-1)
+        return false;
+      if (pz < 0 || pz >= d-1)
+        return false;
+      return true;
+    };
+
+    // the slabs of z-slices are filled in parallel, each in the order of a serial loop over the fibers
+    mitk::FiberSlabBinning binning;
+    binning.Build(fiberPolyData, d, [&](int fiber, vtkIdType pointId, int& zMin, int& zMax) -> bool
+    {
+      int px, py, pz;
+      float frac_x, frac_y, frac_z;
+      if (binning.GetNumberOfFiberPoints(fiber)<2 || !locatePoint(pointId, px, py, pz, frac_x, frac_y, frac_z))
+        return false;
+      zMin = pz;
+      zMax = pz+1;
+      return true;
+    });
+
+    const float scale = 100 * pow((float)m_UpsamplingFactor,3);
+    int numSlabs = binning.GetNumberOfSlabs();
+    boost::progress_display disp(numSlabs);
+#pragma omp parallel for schedule(dynamic)
+    for (int s=0; s<numSlabs; s++)
+    {
+      int zBegin = binning.GetSlabBegin(s);
+      int zEnd = binning.GetSlabEnd(s);
+      for (std::size_t r=0; r<binning.GetNumberOfRuns(s); r++)
+      {
+        const mitk::FiberSlabBinning::Run& run = binning.GetRun(s, r);
+        const vtkIdType* points = binning.GetFiberPointIds(run.m_Fiber);
+        int numPoints = binning.GetNumberOfFiberPoints(run.m_Fiber);
+        float fiberWeight = m_UseFiberWeights ? fiberWeights->GetValue(run.m_Fiber) : 1;
 
-        int pz = index[2];
-        if (frac_z<0)
+        for (int j=run.m_FirstPoint; j<run.m_FirstPoint+run.m_NumberOfPoints; j++)
         {
-          pz -= 1;
-          frac_z += 1;
+          int px, py, pz;
+          float frac_x, frac_y, frac_z;
+          locatePoint(points[j], px, py, pz, frac_x, frac_y, frac_z);
+
+          // direction of the following segment (used as weights), the last point gets the same as the previous one
+          int segment = std::min(j, numPoints-2);
+          double p1[3], p2[3];
+          fiberPolyData->GetPoint(points[segment], p1);
+          fiberPolyData->GetPoint(points[segment+1], p2);
+          itk::Point<float, 3> vertex = GetItkPoint(p1);
+          itk::Point<float, 3> vertexPost = GetItkPoint(p2);
+
+          float rgbweight[4];
+          rgbweight[0] = fabs((vertexPost[0] - vertex[0]) * outImage->GetSpacing()[0]);
+          rgbweight[1] = fabs((vertexPost[1] - vertex[1]) * outImage->GetSpacing()[1]);
+          rgbweight[2] = fabs((vertexPost[2] - vertex[2]) * outImage->GetSpacing()[2]);
+          rgbweight[3] = sqrt(rgbweight[0]*rgbweight[0]+rgbweight[1]*rgbweight[1]+rgbweight[2]*rgbweight[2]);
+
+          // add to r-, g-, b- and a-channel of the corners inside of this slab
+          for (int dz=0; dz<2; dz++)
+          {
+            int z = pz+dz;
+            if (z<zBegin || z>=zEnd)
+              continue;
+            float weight_z = dz ? frac_z : 1-frac_z;
+            for (int dy=0; dy<2; dy++)
+            {
+              float weight_y = dy ? frac_y : 1-frac_y;
+              for (int dx=0; dx<2; dx++)
+              {
+                float weight_x = dx ? frac_x : 1-frac_x;
+                float* voxel = &buffer[4*( px+dx + w*(py+dy + static_cast<std::size_t>(h)*z))];
+                for (int c=0; c<4; c++)
+                  voxel[c] += weight_x*weight_y*weight_z * rgbweight[c] * scale * fiberWeight;
+              }
+            }
+          }
         }
-
-        // int coordinates inside image?
-        if (px < 0 || px >= w-1)
-          continue;
-        if (py < 0 || py >= h-1)
-          continue;
-        if (pz < 0 || pz >= d-1)
-          continue;
-
-        float scale = 100 * pow((float)m_UpsamplingFactor,3);
-        itk::Point<float, 3> rgbweight = rgbweights.front();
-        rgbweights.pop_front();
-        float intweight = intensities.front();
-        intensities.pop_front();
-
-        // add to r-channel in output image
-        buffer[0+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[0] * scale;
-        buffer[0+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[0] * scale;
-
-        // add to g-channel in output image
-        buffer[1+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[1] * scale;
-        buffer[1+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[1] * scale;
-
-        // add to b-channel in output image
-        buffer[2+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * rgbweight[2] * scale;
-        buffer[2+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * rgbweight[2] * scale;
-
-        // add to a-channel in output image
-        buffer[3+4*( px   + w*(py  + h*pz  ))] += (1-frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz  ))] += (1-frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py  + h*pz+h))] += (1-frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px   + w*(py+1+ h*pz+h))] += (1-frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz  ))] += (  frac_x)*(1-frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py  + h*pz+h))] += (  frac_x)*(1-frac_y)*(  frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz  ))] += (  frac_x)*(  frac_y)*(1-frac_z) * intweight * scale;
-        buffer[3+4*( px+1 + w*(py+1+ h*pz+h))] += (  frac_x)*(  frac_y)*(  frac_z) * intweight * scale;
       }
+#pragma omp critical
+      ++disp;
     }
+
     float maxRgb = 0.000000001;
     float maxInt = 0.000000001;
     int numPix;
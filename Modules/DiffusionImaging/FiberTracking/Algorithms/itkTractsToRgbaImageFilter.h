@@ -25,7 +25,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace itk{
 
 /**
-* \brief Generates RGBA image from the input fibers where color values are set according to the local fiber directions.   */
+* \brief Generates RGBA image from the input fibers where color values are set according to the local fiber directions.
+*
+* As in TractDensityImageFilter, the fiber points are splatted into slabs of z-slices in parallel, the
+* result does not depend on the number of threads.   */
 
 template< class OutputImageType >
 class TractsToRgbaImageFilter : public ImageSource< OutputImageType >
@@ -55,6 +58,9 @@ public:
   itkSetMacro( UseImageGeometry, bool)
   itkGetMacro( UseImageGeometry, bool)
 
+  /** Scale the contribution of each fiber with its weight (FiberBundle::GetFiberWeights()) **/
+  itkSetMacro( UseFiberWeights, bool)
+  itkGetMacro( UseFiberWeights, bool)
 
   void GenerateData();
 
@@ -69,6 +75,7 @@ protected:
   float                             m_UpsamplingFactor; ///< use higher resolution for ouput image
   bool                              m_UseImageGeometry; ///< output image is given other geometry than fiberbundle (input image geometry)
   typename InputImageType::Pointer  m_InputImage;
+  bool                              m_UseFiberWeights;  ///< scale the contributions with the fiber weights
 };
 
 }
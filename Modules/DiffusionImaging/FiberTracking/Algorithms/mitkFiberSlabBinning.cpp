@@ -0,0 +1,58 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberSlabBinning.h"
+
+mitk::FiberSlabBinning::FiberSlabBinning()
+    : m_Connectivity(nullptr)
+{
+}
+
+void mitk::FiberSlabBinning::Initialize(vtkPolyData* fiberPolyData, int numSlices)
+{
+    m_PolyData = fiberPolyData;
+    m_Connectivity = nullptr;
+    m_FiberLocations.clear();
+    m_SlabSlices.assign(1, 0);
+    m_SlabOffsets.assign(1, 0);
+    m_Runs.clear();
+
+    if (fiberPolyData==nullptr || fiberPolyData->GetLines()==nullptr || numSlices<=0)
+        return;
+
+    vtkCellArray* lines = fiberPolyData->GetLines();
+    vtkIdType numFibers = lines->GetNumberOfCells();
+    m_Connectivity = lines->GetPointer();
+    m_FiberLocations.resize(numFibers);
+    vtkIdType location = 0;
+    for (vtkIdType i=0; i<numFibers; i++)
+    {
+        m_FiberLocations[i] = location;
+        location += m_Connectivity[location]+1;
+    }
+
+    // a few slabs per thread, so threads finishing sparse slabs early can take over dense ones
+    int numSlabs = std::min(numSlices, 4*omp_get_max_threads());
+    m_SlabSlices.resize(numSlabs+1);
+    for (int s=0; s<=numSlabs; s++)
+        m_SlabSlices[s] = static_cast<int>(static_cast<long long>(s)*numSlices/numSlabs);
+    m_SlabOffsets.assign(numSlabs+1, 0);
+}
+
+int mitk::FiberSlabBinning::GetSlab(int slice) const
+{
+    return static_cast<int>(std::upper_bound(m_SlabSlices.begin()+1, m_SlabSlices.end()-1, slice) - (m_SlabSlices.begin()+1));
+}
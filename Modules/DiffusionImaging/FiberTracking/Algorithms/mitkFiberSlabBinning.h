@@ -0,0 +1,177 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberSlabBinning_H
+#define _MITK_FiberSlabBinning_H
+
+#include <MitkFiberTrackingExports.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkCellArray.h>
+
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+namespace mitk {
+
+/**
+   * \brief Sorts the points of all fibers into slabs of consecutive z-slices of an output image.
+   *
+   * Filters splatting fiber points into an image can process the slabs in parallel without locking,
+   * every thread only writes the slices of its own slab. Within a slab the points are stored as runs of
+   * consecutive points of one fiber, in the order of the fibers and of the points along the fibers.
+   * Every voxel therefore receives its contributions in the same order as in a serial loop over all
+   * fibers, so the result does not depend on the number of threads.
+   */
+class MITKFIBERTRACKING_EXPORT FiberSlabBinning
+{
+public:
+
+    /** \brief Points m_FirstPoint to m_FirstPoint+m_NumberOfPoints-1 of the fiber. */
+    struct Run
+    {
+        int m_Fiber;
+        int m_FirstPoint;
+        int m_NumberOfPoints;
+    };
+
+    FiberSlabBinning();
+
+    /**
+     * \brief Distributes the fiber points into slabs of the given number of slices.
+     *
+     * zRange(fiber, pointId, zMin, zMax) returns the range of slices a point contributes to,
+     * or false if the point does not contribute to the image at all.
+     */
+    template< class ZRange >
+    void Build(vtkPolyData* fiberPolyData, int numSlices, ZRange zRange);
+
+    int GetNumberOfFibers() const { return static_cast<int>(m_FiberLocations.size()); }
+    vtkIdType GetNumberOfFiberPoints(int fiber) const { return m_Connectivity[m_FiberLocations[fiber]]; }
+    const vtkIdType* GetFiberPointIds(int fiber) const { return m_Connectivity+m_FiberLocations[fiber]+1; }
+
+    int GetNumberOfSlabs() const { return static_cast<int>(m_SlabSlices.size())-1; }
+    int GetSlabBegin(int slab) const { return m_SlabSlices[slab]; }     ///< first slice of the slab
+    int GetSlabEnd(int slab) const { return m_SlabSlices[slab+1]; }     ///< first slice after the slab
+
+    std::size_t GetNumberOfRuns(int slab) const { return m_SlabOffsets[slab+1]-m_SlabOffsets[slab]; }
+    const Run& GetRun(int slab, std::size_t run) const { return m_Runs[m_SlabOffsets[slab]+run]; }
+
+private:
+
+    void Initialize(vtkPolyData* fiberPolyData, int numSlices);
+    int GetSlab(int slice) const;
+
+    /** \brief Runs of the chunk of fibers are counted (runs==nullptr) or written to runs[position[slab]++]. */
+    template< class ZRange >
+    void CollectRuns(int firstFiber, int endFiber, ZRange& zRange, std::size_t* positions, Run* runs);
+
+    vtkSmartPointer<vtkPolyData>    m_PolyData;
+    const vtkIdType*                m_Connectivity;
+    std::vector< vtkIdType >        m_FiberLocations;   ///< position of each fiber in the connectivity array
+
+    std::vector< int >              m_SlabSlices;
+    std::vector< std::size_t >      m_SlabOffsets;      ///< runs of slab s are m_Runs[m_SlabOffsets[s]] to m_Runs[m_SlabOffsets[s+1]-1]
+    std::vector< Run >              m_Runs;
+};
+
+template< class ZRange >
+void FiberSlabBinning::CollectRuns(int firstFiber, int endFiber, ZRange& zRange, std::size_t* positions, Run* runs)
+{
+    int numSlabs = this->GetNumberOfSlabs();
+    std::vector< int > lastFiber(numSlabs, -1);
+    std::vector< int > lastPoint(numSlabs, -1);
+    for (int i=firstFiber; i<endFiber; i++)
+    {
+        const vtkIdType* pointIds = this->GetFiberPointIds(i);
+        int numPoints = static_cast<int>(this->GetNumberOfFiberPoints(i));
+        for (int j=0; j<numPoints; j++)
+        {
+            int zMin, zMax;
+            if (!zRange(i, pointIds[j], zMin, zMax))
+                continue;
+
+            for (int s=this->GetSlab(zMin); s<=this->GetSlab(zMax); s++)
+            {
+                bool extendsRun = lastFiber[s]==i && lastPoint[s]==j-1;
+                lastFiber[s] = i;
+                lastPoint[s] = j;
+                if (runs==nullptr)
+                {
+                    if (!extendsRun)
+                        positions[s]++;
+                }
+                else if (extendsRun)
+                    runs[positions[s]-1].m_NumberOfPoints++;
+                else
+                {
+                    Run& run = runs[positions[s]++];
+                    run.m_Fiber = i;
+                    run.m_FirstPoint = j;
+                    run.m_NumberOfPoints = 1;
+                }
+            }
+        }
+    }
+}
+
+template< class ZRange >
+void FiberSlabBinning::Build(vtkPolyData* fiberPolyData, int numSlices, ZRange zRange)
+{
+    this->Initialize(fiberPolyData, numSlices);
+    int numFibers = this->GetNumberOfFibers();
+    int numSlabs = this->GetNumberOfSlabs();
+    if (numFibers==0 || numSlabs==0)
+        return;
+
+    // chunks of fibers are binned in parallel, two passes to count and to write the runs
+    int numChunks = std::min(numFibers, 16*omp_get_max_threads());
+    std::vector< std::size_t > positions(static_cast<std::size_t>(numChunks)*numSlabs, 0);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<numChunks; c++)
+        this->CollectRuns(static_cast<int>(static_cast<long long>(c)*numFibers/numChunks),
+                          static_cast<int>(static_cast<long long>(c+1)*numFibers/numChunks),
+                          zRange, &positions[static_cast<std::size_t>(c)*numSlabs], nullptr);
+
+    // the runs of a slab are ordered by chunk
+    std::size_t numRuns = 0;
+    for (int s=0; s<numSlabs; s++)
+    {
+        m_SlabOffsets[s] = numRuns;
+        for (int c=0; c<numChunks; c++)
+        {
+            std::size_t count = positions[static_cast<std::size_t>(c)*numSlabs+s];
+            positions[static_cast<std::size_t>(c)*numSlabs+s] = numRuns;
+            numRuns += count;
+        }
+    }
+    m_SlabOffsets[numSlabs] = numRuns;
+    m_Runs.resize(numRuns);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<numChunks; c++)
+        this->CollectRuns(static_cast<int>(static_cast<long long>(c)*numFibers/numChunks),
+                          static_cast<int>(static_cast<long long>(c+1)*numFibers/numChunks),
+                          zRange, &positions[static_cast<std::size_t>(c)*numSlabs], m_Runs.data());
+}
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberSlabBinning_H */
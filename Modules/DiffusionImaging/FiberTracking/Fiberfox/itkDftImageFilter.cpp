@@ -42,7 +42,41 @@ template< class TPixelType >
 void DftImageFilter< TPixelType >
 ::BeforeThreadedGenerateData()
 {
+    typename InputImageType::Pointer inputImage  = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
+    typename OutputImageType::Pointer outputImage = static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
+
+    int szx = outputImage->GetLargestPossibleRegion().GetSize(0);
+    int szy = outputImage->GetLargestPossibleRegion().GetSize(1);
 
+    // shift for DFT: (0 -- N) --> (-N/2 -- N/2), the same for image and k-space indices
+    int shiftX = (szx - szx%2)/2;
+    int shiftY = (szy - szy%2)/2;
+
+    std::vector< vcl_complex<double> > xTable(szx*szx);
+    for (int x=0; x<szx; x++)
+        for (int kx=0; kx<szx; kx++)
+            xTable[x*szx+kx] = std::polar(1.0, -2 * M_PI * (double)(x-shiftX)*(kx-shiftX)/szx);
+
+    m_YTable.resize(szy*szy);
+    for (int y=0; y<szy; y++)
+        for (int ky=0; ky<szy; ky++)
+            m_YTable[y*szy+ky] = std::polar(1.0, -2 * M_PI * (double)(y-shiftY)*(ky-shiftY)/szy);
+
+    // transform every k-space line along x
+    m_Rows.assign(szy*szx, vcl_complex<double>(0,0));
+    ImageRegionConstIteratorWithIndex< InputImageType > it(inputImage, inputImage->GetLargestPossibleRegion() );
+    while( !it.IsAtEnd() )
+    {
+        vcl_complex<double> f(it.Get().real(), it.Get().imag());
+        if (f.real()!=0 || f.imag()!=0)
+        {
+            int kx = it.GetIndex()[0];
+            vcl_complex<double>* row = &m_Rows[it.GetIndex()[1]*szx];
+            for (int x=0; x<szx; x++)
+                row[x] += f * xTable[x*szx+kx];
+        }
+        ++it;
+    }
 }
 
 template< class TPixelType >
@@ -53,62 +87,18 @@ void DftImageFilter< TPixelType >
 
     ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
 
-    typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
-    typename InputImageType::Pointer inputImage  = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
-
     int szx = outputImage->GetLargestPossibleRegion().GetSize(0);
     int szy = outputImage->GetLargestPossibleRegion().GetSize(1);
 
+    // transform along y
     while( !oit.IsAtEnd() )
     {
-        double kx = oit.GetIndex()[0];
-        double ky = oit.GetIndex()[1];
-//        kx -= (double)szx/2;
-//        ky -= (double)szy/2;
-
-        if ((int)szx%2==1)
-            kx -= (szx-1)/2;
-        else
-            kx -= szx/2;
-        if ((int)szy%2==1)
-            ky -= (szy-1)/2;
-        else
-            ky -= szy/2;
-
-//        if( kx <  szx/2 )
-//            kx = kx + szx/2;
-//        else
-//            kx = kx - szx/2;
-
-//        if( ky <  szy/2 )
-//            ky = ky + szy/2;
-//        else
-//            ky = ky - szy/2;
+        int x = oit.GetIndex()[0];
+        const vcl_complex<double>* phase = &m_YTable[oit.GetIndex()[1]*szy];
 
         vcl_complex<double> s(0,0);
-        InputIteratorType it(inputImage, inputImage->GetLargestPossibleRegion() );
-        while( !it.IsAtEnd() )
-        {
-            int x = it.GetIndex()[0];
-            int y = it.GetIndex()[1];
-//            x -= (double)szx/2;
-//            y -= (double)szy/2;
-
-            if ((int)szx%2==1)
-                x -= (szx-1)/2;
-            else
-                x -= szx/2;
-            if ((int)szy%2==1)
-                y -= (szy-1)/2;
-            else
-                y -= szy/2;
-
-            vcl_complex<double> f(it.Get().real(), it.Get().imag());
-
-            s += f * exp( std::complex<double>(0, -2 * M_PI * (kx*(double)x/szx + ky*(double)y/szy) ) );
-
-            ++it;
-        }
+        for (int ky=0; ky<szy; ky++)
+            s += m_Rows[ky*szx+x] * phase[ky];
 
         oit.Set(s);
         ++oit;
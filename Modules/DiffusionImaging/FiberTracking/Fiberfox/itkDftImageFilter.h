@@ -31,7 +31,11 @@ This file is based heavily on a corresponding ITK filter.
 namespace itk{
 
 /**
-* \brief 2D Discrete Fourier Transform Filter (complex to real). Special issue for Fiberfox -> rearranges slice. */
+* \brief 2D Discrete Fourier Transform Filter (complex to real). Special issue for Fiberfox -> rearranges slice.
+*
+* The transform is separated into a transform along x, which is calculated for all k-space lines in
+* BeforeThreadedGenerateData(), and a transform along y, which is calculated by the threads. Both use
+* precomputed tables of the complex exponentials. */
 
 template< class TPixelType >
 class DftImageFilter :
@@ -69,6 +73,8 @@ protected:
 private:
 
     FiberfoxParameters<double>          m_Parameters;
+    std::vector< vcl_complex<double> >  m_Rows;     ///< input transformed along x, indexed [ky*szx + x]
+    std::vector< vcl_complex<double> >  m_YTable;   ///< exp(-i*2pi*y*ky/szy), indexed [y*szy + ky]
 };
 
 }
@@ -41,6 +41,9 @@ KspaceImageFilter< TPixelType >
     , m_UseConstantRandSeed(false)
     , m_SpikesPerSlice(0)
     , m_IsBaseline(true)
+    , m_UseSeparableDft(true)
+    , m_SimulateOffResonance(false)
+    , m_NumberOfSignalComponents(0)
 {
     m_DiffusionGradientDirection.Fill(0.0);
 
@@ -120,6 +123,219 @@ void KspaceImageFilter< TPixelType >
     }
 
     m_ReadoutScheme->AdjustEchoTime();
+
+    m_SimulateOffResonance = m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull()
+            || ( m_Parameters->m_SignalGen.m_EddyStrength>0 && m_Parameters->m_Misc.m_CheckAddEddyCurrentsBox && !m_IsBaseline );
+
+    PrecomputePixels();
+
+    m_SeparableKspace.clear();
+    if (m_UseSeparableDft && !m_SimulateOffResonance)
+        ComputeSeparableKspace();
+}
+
+template< class TPixelType >
+void KspaceImageFilter< TPixelType >::PrecomputePixels()
+{
+    double xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
+    double yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
+    double yMaxFov = yMax*m_Parameters->m_SignalGen.m_CroppingFactor;               // actual FOV in y-direction (in x-direction FOV=xMax)
+
+    bool simulateEddyCurrents = m_Parameters->m_SignalGen.m_EddyStrength>0 && m_Parameters->m_Misc.m_CheckAddEddyCurrentsBox && !m_IsBaseline;
+
+    // without relaxation all compartments contribute with the same weight and are summed up front
+    m_NumberOfSignalComponents = m_Parameters->m_SignalGen.m_DoSimulateRelaxation ? m_CompartmentImages.size() : 1;
+
+    m_PixelX.clear();
+    m_PixelY.clear();
+    m_PixelPhaseX.clear();
+    m_PixelPhaseY.clear();
+    m_PixelOffResonance.clear();
+    m_PixelEddy.clear();
+    m_PixelSignal.assign(m_NumberOfSignalComponents, vector< double >());
+
+    vector< double > signal(m_NumberOfSignalComponents);
+    ImageRegionConstIteratorWithIndex< InputImageType > it(m_CompartmentImages.at(0), m_CompartmentImages.at(0)->GetLargestPossibleRegion() );
+    while( !it.IsAtEnd() )
+    {
+        // pixels without signal do not contribute to any k-space sample
+        bool hasSignal = false;
+        std::fill(signal.begin(), signal.end(), 0.0);
+        for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
+        {
+            double value = m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * m_Parameters->m_SignalGen.m_SignalScale;
+            signal[m_NumberOfSignalComponents==1 ? 0 : i] += value;
+            hasSignal |= value!=0;
+        }
+        if (!hasSignal)
+        {
+            ++it;
+            continue;
+        }
+
+        double x = it.GetIndex()[0];
+        double y = it.GetIndex()[1];
+        if ((int)xMax%2==1)
+            x -= (xMax-1)/2;
+        else
+            x -= xMax/2;
+        if ((int)yMax%2==1)
+            y -= (yMax-1)/2;
+        else
+            y -= yMax/2;
+
+        DoubleVectorType pos; pos[0] = x; pos[1] = y; pos[2] = m_Z;
+        pos = m_Transform*pos/1000;   // vector from image center to current position (in meter)
+
+        if (m_Parameters->m_SignalGen.m_CoilSensitivityProfile!=SignalGenerationParameters::COIL_CONSTANT)
+        {
+            double sensitivity = CoilSensitivity(pos);
+            for (unsigned int c=0; c<m_NumberOfSignalComponents; c++)
+                signal[c] *= sensitivity;
+        }
+
+        // simulate eddy currents and other distortions
+        double omegaEddy = 0;
+        if (simulateEddyCurrents)
+            omegaEddy = m_DiffusionGradientDirection[0]*pos[0]+m_DiffusionGradientDirection[1]*pos[1]+m_DiffusionGradientDirection[2]*pos[2];
+
+        double omega = 0;   // frequency offset
+        if (m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull()) // simulate distortions
+        {
+            itk::Point<double, 3> point3D;
+            ItkDoubleImgType::IndexType index; index[0] = it.GetIndex()[0]; index[1] = it.GetIndex()[1]; index[2] = m_Zidx;
+            if (m_Parameters->m_SignalGen.m_DoAddMotion)    // we have to account for the head motion since this also moves our frequency map
+            {
+                m_Parameters->m_SignalGen.m_FrequencyMap->TransformIndexToPhysicalPoint(index, point3D);
+                point3D = m_FiberBundle->TransformPoint(point3D.GetVnlVector(), -m_Rotation[0],-m_Rotation[1],-m_Rotation[2],-m_Translation[0],-m_Translation[1],-m_Translation[2]);
+                omega += InterpolateFmapValue(point3D);
+            }
+            else
+            {
+                omega += m_Parameters->m_SignalGen.m_FrequencyMap->GetPixel(index);
+            }
+        }
+
+        // if signal comes from outside FOV, mirror it back (wrap-around artifact - aliasing)
+        if (y<-yMaxFov/2)
+            y += yMaxFov;
+        else if (y>=yMaxFov/2)
+            y -= yMaxFov;
+
+        m_PixelX.push_back(it.GetIndex()[0]);
+        m_PixelY.push_back(it.GetIndex()[1]);
+        m_PixelPhaseX.push_back(2 * M_PI * x/xMax);
+        m_PixelPhaseY.push_back(2 * M_PI * y/yMaxFov);
+        m_PixelOffResonance.push_back(2 * M_PI * omega/1000);
+        m_PixelEddy.push_back(2 * M_PI * omegaEddy/1000);
+        for (unsigned int c=0; c<m_NumberOfSignalComponents; c++)
+            m_PixelSignal[c].push_back(signal[c]);
+
+        ++it;
+    }
+}
+
+template< class TPixelType >
+void KspaceImageFilter< TPixelType >::ComputeSeparableKspace()
+{
+    int kxMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(0);
+    int kyMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(1);
+    int xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0);
+    int yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1);
+
+    // phase table along y: exp(i*ky*phaseY), the wrapped y of a row is the same for all its pixels
+    vector< double > rowPhase(yMax, 0.0);
+    for (unsigned int p=0; p<m_PixelY.size(); p++)
+        rowPhase[m_PixelY[p]] = m_PixelPhaseY[p];
+
+    vector< vcl_complex<double> > yTable(kyMax*yMax);
+    for (int kyIdx=0; kyIdx<kyMax; kyIdx++)
+    {
+        double ky = kyIdx - (kyMax-kyMax%2)/2;
+        for (int y=0; y<yMax; y++)
+            yTable[kyIdx*yMax+y] = std::polar(1.0, ky*rowPhase[y]);
+    }
+
+    // odd and even lines are shifted in opposite directions by the gradient delay (N/2 ghosts)
+    int numDirections = m_Parameters->m_SignalGen.m_KspaceLineOffset!=0 ? 2 : 1;
+    m_SeparableKspace.assign(numDirections, vector< vector< vcl_complex<double> > >(m_NumberOfSignalComponents));
+
+    vector< vcl_complex<double> > xTable(kxMax*xMax);
+    vector< vcl_complex<double> > rows(yMax*kxMax);
+    for (int direction=0; direction<numDirections; direction++)
+    {
+        double offset = direction==0 ? m_Parameters->m_SignalGen.m_KspaceLineOffset : -m_Parameters->m_SignalGen.m_KspaceLineOffset;
+        for (int kxIdx=0; kxIdx<kxMax; kxIdx++)
+        {
+            double kx = kxIdx - (kxMax-kxMax%2)/2 + offset;
+            for (int x=0; x<xMax; x++)
+            {
+                double phaseX = 2 * M_PI * (x - (xMax-xMax%2)/2)/(double)xMax;
+                xTable[kxIdx*xMax+x] = std::polar(1.0, kx*phaseX);
+            }
+        }
+
+        for (unsigned int c=0; c<m_NumberOfSignalComponents; c++)
+        {
+            const vector< double >& signal = m_PixelSignal[c];
+
+            // transform along x: rows[y][kx]
+            std::fill(rows.begin(), rows.end(), vcl_complex<double>(0,0));
+            for (unsigned int p=0; p<signal.size(); p++)
+            {
+                vcl_complex<double>* row = &rows[m_PixelY[p]*kxMax];
+                const vcl_complex<double>* phase = &xTable[m_PixelX[p]];
+                for (int kxIdx=0; kxIdx<kxMax; kxIdx++)
+                    row[kxIdx] += signal[p] * phase[kxIdx*xMax];
+            }
+
+            // transform along y
+            vector< vcl_complex<double> >& kspace = m_SeparableKspace[direction][c];
+            kspace.assign(kyMax*kxMax, vcl_complex<double>(0,0));
+            for (int kyIdx=0; kyIdx<kyMax; kyIdx++)
+            {
+                vcl_complex<double>* line = &kspace[kyIdx*kxMax];
+                for (int y=0; y<yMax; y++)
+                {
+                    const vcl_complex<double> phase = yTable[kyIdx*yMax+y];
+                    const vcl_complex<double>* row = &rows[y*kxMax];
+                    for (int kxIdx=0; kxIdx<kxMax; kxIdx++)
+                        line[kxIdx] += row[kxIdx] * phase;
+                }
+            }
+        }
+    }
+}
+
+template< class TPixelType >
+vcl_complex<double> KspaceImageFilter< TPixelType >::ComputeSample(double kx, double ky, double t, double eddyDecay, const std::vector< double >& relaxFactor) const
+{
+    const unsigned int numPixels = m_PixelPhaseX.size();
+    const double* phaseX = numPixels>0 ? &m_PixelPhaseX[0] : NULL;
+    const double* phaseY = numPixels>0 ? &m_PixelPhaseY[0] : NULL;
+    const double* offResonance = numPixels>0 ? &m_PixelOffResonance[0] : NULL;
+    const double* eddy = numPixels>0 ? &m_PixelEddy[0] : NULL;
+    const double eddyTime = eddyDecay*t;
+
+    // plain loops over contiguous arrays, one sine and cosine per pixel
+    double real = 0;
+    double imag = 0;
+    for (unsigned int c=0; c<m_NumberOfSignalComponents; c++)
+    {
+        const double* signal = numPixels>0 ? &m_PixelSignal[c][0] : NULL;
+        const double weight = relaxFactor.empty() ? 1.0 : relaxFactor[c];
+        double componentReal = 0;
+        double componentImag = 0;
+        for (unsigned int p=0; p<numPixels; p++)
+        {
+            double phase = kx*phaseX[p] + ky*phaseY[p] + t*offResonance[p] + eddyTime*eddy[p];
+            componentReal += signal[p]*cos(phase);
+            componentImag += signal[p]*sin(phase);
+        }
+        real += weight*componentReal;
+        imag += weight*componentImag;
+    }
+    return vcl_complex<double>(real, imag);
 }
 
 template< class TPixelType >
@@ -168,13 +384,8 @@ void KspaceImageFilter< TPixelType >
 
     ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
 
-    typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
-
     double kxMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(0);
     double kyMax = m_Parameters->m_SignalGen.m_CroppedRegion.GetSize(1);
-    double xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
-    double yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
-    double yMaxFov = yMax*m_Parameters->m_SignalGen.m_CroppingFactor;               // actual FOV in y-direction (in x-direction FOV=xMax)
 
     double numPix = kxMax*kyMax;
     double noiseVar = m_Parameters->m_SignalGen.m_PartialFourier*m_Parameters->m_SignalGen.m_NoiseVariance/(kyMax*kxMax); // adjust noise variance since it is the intended variance in physical space and not in k-space
@@ -211,86 +422,36 @@ void KspaceImageFilter< TPixelType >
 
         if (!pf)
         {
-            // shift k for DFT: (0 -- N) --> (-N/2 -- N/2)
-            double kx = kIdx[0];
-            double ky = kIdx[1];
-            if ((int)kxMax%2==1)
-                kx -= (kxMax-1)/2;
-            else
-                kx -= kxMax/2;
-            if ((int)kyMax%2==1)
-                ky -= (kyMax-1)/2;
-            else
-                ky -= kyMax/2;
-
-            // add ghosting
-            if (oit.GetIndex()[1]%2 == 1)
-                kx -= m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
-            else
-                kx += m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
-
             vcl_complex<double> s(0,0);
-            InputIteratorType it(m_CompartmentImages.at(0), m_CompartmentImages.at(0)->GetLargestPossibleRegion() );
-            while( !it.IsAtEnd() )
+            if (!m_SeparableKspace.empty())
+            {
+                // ghosting: the k-space of the readout direction of this line
+                const vector< vector< vcl_complex<double> > >& kspace = m_SeparableKspace[oit.GetIndex()[1]%2 == 1 && m_SeparableKspace.size()>1 ? 1 : 0];
+                unsigned int kspaceIndex = kIdx[1]*(unsigned int)kxMax + kIdx[0];
+                for (unsigned int c=0; c<kspace.size(); c++)
+                    s += relaxFactor.empty() ? kspace[c][kspaceIndex] : relaxFactor[c]*kspace[c][kspaceIndex];
+            }
+            else
             {
-                double x = it.GetIndex()[0];
-                double y = it.GetIndex()[1];
-                if ((int)xMax%2==1)
-                    x -= (xMax-1)/2;
+                // shift k for DFT: (0 -- N) --> (-N/2 -- N/2)
+                double kx = kIdx[0];
+                double ky = kIdx[1];
+                if ((int)kxMax%2==1)
+                    kx -= (kxMax-1)/2;
                 else
-                    x -= xMax/2;
-                if ((int)yMax%2==1)
-                    y -= (yMax-1)/2;
+                    kx -= kxMax/2;
+                if ((int)kyMax%2==1)
+                    ky -= (kyMax-1)/2;
                 else
-                    y -= yMax/2;
+                    ky -= kyMax/2;
 
-                DoubleVectorType pos; pos[0] = x; pos[1] = y; pos[2] = m_Z;
-                pos = m_Transform*pos/1000;   // vector from image center to current position (in meter)
-
-                vcl_complex<double> f(0, 0);
-
-                // sum compartment signals and simulate relaxation
-                for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
-                    if ( m_Parameters->m_SignalGen.m_DoSimulateRelaxation)
-                        f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * relaxFactor.at(i) *  m_Parameters->m_SignalGen.m_SignalScale, 0);
-                    else
-                        f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) *  m_Parameters->m_SignalGen.m_SignalScale );
-
-                if (m_Parameters->m_SignalGen.m_CoilSensitivityProfile!=SignalGenerationParameters::COIL_CONSTANT)
-                    f *= CoilSensitivity(pos);
-
-                // simulate eddy currents and other distortions
-                double omega = 0;   // frequency offset
-                if (  m_Parameters->m_SignalGen.m_EddyStrength>0 && m_Parameters->m_Misc.m_CheckAddEddyCurrentsBox && !m_IsBaseline)
-                {
-                    omega += (m_DiffusionGradientDirection[0]*pos[0]+m_DiffusionGradientDirection[1]*pos[1]+m_DiffusionGradientDirection[2]*pos[2]) * eddyDecay;
-                }
-                if (m_Parameters->m_SignalGen.m_FrequencyMap.IsNotNull()) // simulate distortions
-                {
-                    itk::Point<double, 3> point3D;
-                    ItkDoubleImgType::IndexType index; index[0] = it.GetIndex()[0]; index[1] = it.GetIndex()[1]; index[2] = m_Zidx;
-                    if (m_Parameters->m_SignalGen.m_DoAddMotion)    // we have to account for the head motion since this also moves our frequency map
-                    {
-                        m_Parameters->m_SignalGen.m_FrequencyMap->TransformIndexToPhysicalPoint(index, point3D);
-                        point3D = m_FiberBundle->TransformPoint(point3D.GetVnlVector(), -m_Rotation[0],-m_Rotation[1],-m_Rotation[2],-m_Translation[0],-m_Translation[1],-m_Translation[2]);
-                        omega += InterpolateFmapValue(point3D);
-                    }
-                    else
-                    {
-                        omega += m_Parameters->m_SignalGen.m_FrequencyMap->GetPixel(index);
-                    }
-                }
-
-                // if signal comes from outside FOV, mirror it back (wrap-around artifact - aliasing)
-                if (y<-yMaxFov/2)
-                    y += yMaxFov;
-                else if (y>=yMaxFov/2)
-                    y -= yMaxFov;
-
-                // actual DFT term
-                s += f * exp( std::complex<double>(0, 2 * M_PI * (kx*x/xMax + ky*y/yMaxFov + omega*t/1000 )) );
+                // add ghosting
+                if (oit.GetIndex()[1]%2 == 1)
+                    kx -= m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
+                else
+                    kx += m_Parameters->m_SignalGen.m_KspaceLineOffset;    // add gradient delay induced offset
 
-                ++it;
+                s = ComputeSample(kx, ky, t, eddyDecay, relaxFactor);
             }
             s /= numPix;
 
@@ -45,6 +45,12 @@ namespace itk{
 * - Gibbs ringing
 * - Eddy current effects
 * Based on a discrete fourier transformation.
+*
+* The signal and the phase factors of all pixels are collected once per slice. If no off-resonance effects
+* (eddy currents, frequency map) are simulated, the phase of a pixel does not depend on the time of the
+* k-space sample and the DFT is separated into transforms along x and y with precomputed phase tables.
+* Relaxation, ghosts, aliasing and partial fourier are applied per k-space sample on top of this.
+* With off-resonance effects the DFT is evaluated for every k-space sample on the precomputed pixel arrays.
 * See "Fiberfox: Facilitating the creation of realistic white matter software phantoms" (DOI: 10.1002/mrm.25045) for details.
 */
 
@@ -86,6 +92,8 @@ namespace itk{
     itkSetMacro( CoilPosition, DoubleVectorType )
     itkGetMacro( KSpaceImage, typename InputImageType::Pointer )    ///< k-space magnitude image
     itkGetMacro( SpikeLog, std::string )
+    itkSetMacro( UseSeparableDft, bool )            ///< Use the separable DFT if possible (default). If false, the DFT is evaluated for every k-space sample, which is much slower and only meant for validation.
+    itkGetMacro( UseSeparableDft, bool )
 
     void SetParameters( FiberfoxParameters<double>* param ){ m_Parameters = param; }
 
@@ -105,6 +113,13 @@ namespace itk{
     void AfterThreadedGenerateData();
     double InterpolateFmapValue(itk::Point<float, 3> itkP);
 
+    /** Collects signal, position dependent phase factors and off-resonance frequency of all pixels with signal. */
+    void PrecomputePixels();
+    /** Computes the k-space of each signal component by DFTs along x and y (one per readout direction if ghosts are simulated). */
+    void ComputeSeparableKspace();
+    /** Evaluates the DFT for a single k-space sample acquired at time t. */
+    vcl_complex<double> ComputeSample(double kx, double ky, double t, double eddyDecay, const std::vector< double >& relaxFactor) const;
+
     DoubleVectorType                        m_CoilPosition;
     FiberfoxParameters<double>*             m_Parameters;
     vector< double >                        m_T2;
@@ -131,6 +146,22 @@ namespace itk{
     typename InputImageType::Pointer        m_ReadoutTimeImage;
     AcquisitionType*                        m_ReadoutScheme;
 
+    bool                                    m_UseSeparableDft;
+    bool                                    m_SimulateOffResonance;     ///< eddy currents or frequency map, the phase depends on the sample time
+    unsigned int                            m_NumberOfSignalComponents; ///< one per compartment if relaxation is simulated, else the sum of all compartments
+
+    // pixels with signal, as structure of arrays
+    vector< unsigned int >                  m_PixelX;
+    vector< unsigned int >                  m_PixelY;
+    vector< double >                        m_PixelPhaseX;          ///< 2*pi*x/xMax
+    vector< double >                        m_PixelPhaseY;          ///< 2*pi*y/yMaxFov, y wrapped into the FOV
+    vector< double >                        m_PixelOffResonance;    ///< 2*pi*omega/1000 of the frequency map
+    vector< double >                        m_PixelEddy;            ///< 2*pi*omega/1000 of the eddy currents before decay
+    vector< vector< double > >              m_PixelSignal;          ///< signal of each component
+
+    /** k-space of each signal component for both readout directions (line offset +/-), index ky*kxMax+kx */
+    vector< vector< vector< vcl_complex<double> > > > m_SeparableKspace;
+
   private:
 
   };
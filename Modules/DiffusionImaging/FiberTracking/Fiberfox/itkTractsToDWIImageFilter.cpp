@@ -32,6 +32,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkResampleDwiImageFilter.h>
 #include <itkKspaceImageFilter.h>
 #include <itkDftImageFilter.h>
+#include <mitkSingleShotEpi.h>
+#include <mitkCartesianReadout.h>
 #include <itkAddImageFilter.h>
 #include <itkConstantPadImageFilter.h>
 #include <itkCropImageFilter.h>
@@ -53,6 +55,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkExtractImageFilter.h>
 #include <itkResampleDwiImageFilter.h>
 #include <boost/algorithm/string/replace.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace itk
 {
@@ -62,6 +67,7 @@ namespace itk
     : m_FiberBundle(NULL)
     , m_StatusText("")
     , m_UseConstantRandSeed(false)
+    , m_SlicesPerSecond(0)
     , m_RandGen(itk::Statistics::MersenneTwisterRandomVariateGenerator::New())
   {
     m_RandGen->SetSeed();
@@ -153,177 +159,228 @@ namespace itk
       pos.SetVnlVector(rotZ*pos.GetVnlVector());
     }
 
-    PrintToLog("0%   10   20   30   40   50   60   70   80   90   100%", false, true, false);
-    PrintToLog("|----|----|----|----|----|----|----|----|----|----|\n*", false, false, false);
-    unsigned long lastTick = 0;
+    unsigned int numVolumes = images.at(0)->GetVectorLength();
+    unsigned int numSlices = images.at(0)->GetLargestPossibleRegion().GetSize(2);
 
-    boost::progress_display disp(images.at(0)->GetVectorLength()*images.at(0)->GetLargestPossibleRegion().GetSize(2));
-    for (unsigned int g=0; g<images.at(0)->GetVectorLength(); g++)
+    // draw all random numbers in the same order as a sequential simulation would, so the result
+    // does not depend on the order in which the slices are simulated
+    std::vector< SliceWorkItem > workItems(numVolumes*numSlices);
+    for (unsigned int g=0; g<numVolumes; g++)
     {
       std::vector< unsigned int > spikeSlice;
       while (!spikeVolume.empty() && spikeVolume.back()==g)
       {
-        spikeSlice.push_back(m_RandGen->GetIntegerVariate()%images.at(0)->GetLargestPossibleRegion().GetSize(2));
+        spikeSlice.push_back(m_RandGen->GetIntegerVariate()%numSlices);
         spikeVolume.pop_back();
       }
       std::sort (spikeSlice.begin(), spikeSlice.end());
       std::reverse (spikeSlice.begin(), spikeSlice.end());
 
-      for (unsigned int z=0; z<images.at(0)->GetLargestPossibleRegion().GetSize(2); z++)
+      for (unsigned int z=0; z<numSlices; z++)
       {
-        std::vector< SliceType::Pointer > compartmentSlices;
-        std::vector< double > t2Vector;
-        std::vector< double > t1Vector;
-
-        for (unsigned int i=0; i<images.size(); i++)
-        {
-          DiffusionSignalModel<double>* signalModel;
-          if (i<numFiberCompartments)
-            signalModel = m_Parameters.m_FiberModelList.at(i);
-          else
-            signalModel = m_Parameters.m_NonFiberModelList.at(i-numFiberCompartments);
-
-          auto slice = SliceType::New();
-          slice->SetLargestPossibleRegion( sliceRegion );
-          slice->SetBufferedRegion( sliceRegion );
-          slice->SetRequestedRegion( sliceRegion );
-          slice->SetSpacing(sliceSpacing);
-          slice->Allocate();
-          slice->FillBuffer(0.0);
-
-          // extract slice from channel g
-          for (unsigned int y=0; y<images.at(0)->GetLargestPossibleRegion().GetSize(1); y++)
-            for (unsigned int x=0; x<images.at(0)->GetLargestPossibleRegion().GetSize(0); x++)
-            {
-              SliceType::IndexType index2D; index2D[0]=x; index2D[1]=y;
-              DoubleDwiType::IndexType index3D; index3D[0]=x; index3D[1]=y; index3D[2]=z;
-
-              slice->SetPixel(index2D, images.at(i)->GetPixel(index3D)[g]);
-            }
-
-          compartmentSlices.push_back(slice);
-          t2Vector.push_back(signalModel->GetT2());
-          t1Vector.push_back(signalModel->GetT1());
-        }
-
         int numSpikes = 0;
         while (!spikeSlice.empty() && spikeSlice.back()==z)
         {
           numSpikes++;
           spikeSlice.pop_back();
         }
-        int spikeCoil = m_RandGen->GetIntegerVariate()%m_Parameters.m_SignalGen.m_NumberOfCoils;
 
-        if (this->GetAbortGenerateData())
-          return NULL;
+        // slice-major order: all volumes of a slice read neighbouring memory of the compartment images
+        SliceWorkItem& item = workItems[z*numVolumes + g];
+        item.m_Volume = g;
+        item.m_Slice = z;
+        item.m_NumSpikes = numSpikes;
+        item.m_SpikeCoil = m_RandGen->GetIntegerVariate()%m_Parameters.m_SignalGen.m_NumberOfCoils;
+      }
+    }
 
-#pragma omp parallel for
-        for (int c=0; c<m_Parameters.m_SignalGen.m_NumberOfCoils; c++)
-        {
-          // create k-sapce (inverse fourier transform slices)
-          auto idft = itk::KspaceImageFilter< SliceType::PixelType >::New();
-          idft->SetCompartmentImages(compartmentSlices);
-          idft->SetT2(t2Vector);
-          idft->SetT1(t1Vector);
-          idft->SetUseConstantRandSeed(m_UseConstantRandSeed);
-          idft->SetParameters(&m_Parameters);
-          idft->SetZ((double)z-(double)(images.at(0)->GetLargestPossibleRegion().GetSize(2)-images.at(0)->GetLargestPossibleRegion().GetSize(2)%2)/2.0);
-          idft->SetZidx(z);
-          idft->SetCoilPosition(coilPositions.at(c));
-          idft->SetFiberBundle(m_FiberBundleWorkingCopy);
-          idft->SetTranslation(m_Translations.at(g));
-          idft->SetRotation(m_Rotations.at(g));
-          idft->SetDiffusionGradientDirection(m_Parameters.m_SignalGen.GetGradientDirection(g));
-          if (c==spikeCoil)
-            idft->SetSpikesPerSlice(numSpikes);
-          idft->Update();
-
-#pragma omp critical
-          if (c==spikeCoil && numSpikes>0)
-          {
-            m_SpikeLog += "Volume " + boost::lexical_cast<std::string>(g) + " Coil " + boost::lexical_cast<std::string>(c) + "\n";
-            m_SpikeLog += idft->GetSpikeLog();
-          }
+    std::vector< double > t2Vector;
+    std::vector< double > t1Vector;
+    for (unsigned int i=0; i<images.size(); i++)
+    {
+      DiffusionSignalModel<double>* signalModel;
+      if (i<numFiberCompartments)
+        signalModel = m_Parameters.m_FiberModelList.at(i);
+      else
+        signalModel = m_Parameters.m_NonFiberModelList.at(i-numFiberCompartments);
+      t2Vector.push_back(signalModel->GetT2());
+      t1Vector.push_back(signalModel->GetT1());
+    }
 
-          ComplexSliceType::Pointer fSlice;
-          fSlice = idft->GetOutput();
+    int numThreads = 1;
+#ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+#endif
+    // the slices are the unit of parallelization, the filters of a slice only use several threads if there are fewer slices than threads
+    int numFilterThreads = (int)workItems.size()>=numThreads ? 1 : numThreads;
 
-          // fourier transform slice
-          ComplexSliceType::Pointer newSlice;
-          auto dft = itk::DftImageFilter< SliceType::PixelType >::New();
-          dft->SetInput(fSlice);
-          dft->SetParameters(m_Parameters);
-          dft->Update();
-          newSlice = dft->GetOutput();
+    // slice buffers are allocated once per thread and reused for all slices simulated by that thread
+    std::vector< std::vector< SliceType::Pointer > > threadSlices(numThreads);
+    for (int t=0; t<numThreads; t++)
+      for (unsigned int i=0; i<images.size(); i++)
+      {
+        auto slice = SliceType::New();
+        slice->SetLargestPossibleRegion( sliceRegion );
+        slice->SetBufferedRegion( sliceRegion );
+        slice->SetRequestedRegion( sliceRegion );
+        slice->SetSpacing(sliceSpacing);
+        slice->Allocate();
+        slice->FillBuffer(0.0);
+        threadSlices[t].push_back(slice);
+      }
 
-          // put slice back into channel g
-          for (unsigned int y=0; y<fSlice->GetLargestPossibleRegion().GetSize(1); y++)
-            for (unsigned int x=0; x<fSlice->GetLargestPossibleRegion().GetSize(0); x++)
-            {
-              DoubleDwiType::IndexType index3D; index3D[0]=x; index3D[1]=y; index3D[2]=z;
-              ComplexSliceType::IndexType index2D; index2D[0]=x; index2D[1]=y;
+    unsigned int croppedPixels = m_Parameters.m_SignalGen.m_CroppedRegion.GetSize(0)*m_Parameters.m_SignalGen.m_CroppedRegion.GetSize(1);
+    std::vector< std::vector< double > > threadMagnitude(numThreads, std::vector< double >(croppedPixels));
+    std::vector< std::vector< double > > threadPhase(numThreads, std::vector< double >(croppedPixels));
 
-              ComplexSliceType::PixelType cPix = newSlice->GetPixel(index2D);
-              double magn = sqrt(cPix.real()*cPix.real()+cPix.imag()*cPix.imag());
-              double phase = 0;
-              if (cPix.real()!=0)
-                phase = atan( cPix.imag()/cPix.real() );
+    std::vector< std::string > spikeLogs(workItems.size());
 
+    // the echo time is adjusted by the first k-space filter, do this before the filters run concurrently on the same parameters
+    mitk::AcquisitionType* readoutScheme;
+    switch (m_Parameters.m_SignalGen.m_AcquisitionType)
+    {
+    case SignalGenerationParameters::SpinEcho:
+      readoutScheme = new mitk::CartesianReadout(&m_Parameters);
+      break;
+    default:
+      readoutScheme = new mitk::SingleShotEpi(&m_Parameters);
+    }
+    readoutScheme->AdjustEchoTime();
+    delete readoutScheme;
 
-              DoubleDwiType::PixelType dwiPix = magnitudeDwiImage->GetPixel(index3D);
-              DoubleDwiType::PixelType phasePix = m_PhaseImage->GetPixel(index3D);
+    // the work items write to disjoint pixels and channels, so they are written to the buffers directly
+    double* magnitudeBuffer = magnitudeDwiImage->GetBufferPointer();
+    double* phaseBuffer = m_PhaseImage->GetBufferPointer();
+    double* kspaceBuffer = m_KspaceImage->GetBufferPointer();
+    unsigned int numCoils = m_Parameters.m_SignalGen.m_NumberOfCoils;
+    unsigned int slicePixels = sliceRegion.GetNumberOfPixels();
 
-              if (m_Parameters.m_SignalGen.m_NumberOfCoils>1)
-              {
-                dwiPix[g] += magn*magn;
-                phasePix[g] += phase*phase;
-              }
-              else
-              {
-                dwiPix[g] = magn;
-                phasePix[g] = phase;
-              }
+    PrintToLog("0%   10   20   30   40   50   60   70   80   90   100%", false, true, false);
+    PrintToLog("|----|----|----|----|----|----|----|----|----|----|\n*", false, false, false);
+    unsigned long lastTick = 0;
 
-#pragma omp critical
-              {
-                magnitudeDwiImage->SetPixel(index3D, dwiPix);
-                m_PhaseImage->SetPixel(index3D, phasePix);
-
-                // k-space image
-                if (g==0)
-                {
-                  DoubleDwiType::PixelType kspacePix = m_KspaceImage->GetPixel(index3D);
-                  kspacePix[c] = idft->GetKSpaceImage()->GetPixel(index2D);
-                  m_KspaceImage->SetPixel(index3D, kspacePix);
-                }
-              }
-            }
+    boost::progress_display disp(workItems.size());
+    itk::TimeProbe clock;
+    clock.Start();
+    bool aborted = false;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int w=0; w<(int)workItems.size(); w++)
+    {
+      if (aborted)
+        continue;
+
+      int threadIdx = 0;
+#ifdef _OPENMP
+      threadIdx = omp_get_thread_num();
+#endif
+      const SliceWorkItem& item = workItems[w];
+      unsigned int g = item.m_Volume;
+      unsigned int z = item.m_Slice;
+
+      // extract slice from channel g
+      std::vector< SliceType::Pointer >& compartmentSlices = threadSlices[threadIdx];
+      for (unsigned int i=0; i<images.size(); i++)
+      {
+        const double* in = images.at(i)->GetBufferPointer() + (std::size_t)z*slicePixels*numVolumes + g;
+        double* out = compartmentSlices.at(i)->GetBufferPointer();
+        for (unsigned int p=0; p<slicePixels; p++)
+          out[p] = in[(std::size_t)p*numVolumes];
+        compartmentSlices.at(i)->Modified();
+      }
+
+      std::vector< double >& sumMagnitude = threadMagnitude[threadIdx];
+      std::vector< double >& sumPhase = threadPhase[threadIdx];
+      std::fill(sumMagnitude.begin(), sumMagnitude.end(), 0.0);
+      std::fill(sumPhase.begin(), sumPhase.end(), 0.0);
+
+      for (unsigned int c=0; c<numCoils; c++)
+      {
+        // create k-sapce (inverse fourier transform slices)
+        auto idft = itk::KspaceImageFilter< SliceType::PixelType >::New();
+        idft->SetCompartmentImages(compartmentSlices);
+        idft->SetT2(t2Vector);
+        idft->SetT1(t1Vector);
+        idft->SetUseConstantRandSeed(m_UseConstantRandSeed);
+        idft->SetParameters(&m_Parameters);
+        idft->SetZ((double)z-(double)(numSlices-numSlices%2)/2.0);
+        idft->SetZidx(z);
+        idft->SetCoilPosition(coilPositions.at(c));
+        idft->SetFiberBundle(m_FiberBundleWorkingCopy);
+        idft->SetTranslation(m_Translations.at(g));
+        idft->SetRotation(m_Rotations.at(g));
+        idft->SetDiffusionGradientDirection(m_Parameters.m_SignalGen.GetGradientDirection(g));
+        idft->SetNumberOfThreads(numFilterThreads);
+        if ((int)c==item.m_SpikeCoil)
+          idft->SetSpikesPerSlice(item.m_NumSpikes);
+        idft->Update();
+
+        if ((int)c==item.m_SpikeCoil && item.m_NumSpikes>0)
+        {
+          spikeLogs[w] += "Volume " + boost::lexical_cast<std::string>(g) + " Coil " + boost::lexical_cast<std::string>(c) + "\n";
+          spikeLogs[w] += idft->GetSpikeLog();
         }
 
-        if (m_Parameters.m_SignalGen.m_NumberOfCoils>1)
+        ComplexSliceType::Pointer fSlice;
+        fSlice = idft->GetOutput();
+
+        // fourier transform slice
+        ComplexSliceType::Pointer newSlice;
+        auto dft = itk::DftImageFilter< SliceType::PixelType >::New();
+        dft->SetInput(fSlice);
+        dft->SetParameters(m_Parameters);
+        dft->SetNumberOfThreads(numFilterThreads);
+        dft->Update();
+        newSlice = dft->GetOutput();
+
+        // accumulate the coils of this slice
+        const ComplexSliceType::PixelType* cPixels = newSlice->GetBufferPointer();
+        const double* kspacePixels = idft->GetKSpaceImage()->GetBufferPointer();
+        for (unsigned int p=0; p<croppedPixels; p++)
         {
-#ifdef WIN32
-#pragma omp parallel for
-#else
-#pragma omp parallel for collapse(2)
-#endif
-          for (int y=0; y<magnitudeDwiImage->GetLargestPossibleRegion().GetSize(1); y++)
-            for (int x=0; x<magnitudeDwiImage->GetLargestPossibleRegion().GetSize(0); x++)
-            {
-              DoubleDwiType::IndexType index3D; index3D[0]=x; index3D[1]=y; index3D[2]=z;
-              DoubleDwiType::PixelType magPix = magnitudeDwiImage->GetPixel(index3D);
-              magPix[g] = sqrt(magPix[g]/m_Parameters.m_SignalGen.m_NumberOfCoils);
+          ComplexSliceType::PixelType cPix = cPixels[p];
+          double magn = sqrt(cPix.real()*cPix.real()+cPix.imag()*cPix.imag());
+          double phase = 0;
+          if (cPix.real()!=0)
+            phase = atan( cPix.imag()/cPix.real() );
+
+          if (numCoils>1)
+          {
+            sumMagnitude[p] += magn*magn;
+            sumPhase[p] += phase*phase;
+          }
+          else
+          {
+            sumMagnitude[p] = magn;
+            sumPhase[p] = phase;
+          }
 
-              DoubleDwiType::PixelType phasePix = m_PhaseImage->GetPixel(index3D);
-              phasePix[g] = sqrt(phasePix[g]/m_Parameters.m_SignalGen.m_NumberOfCoils);
+          // k-space image
+          if (g==0)
+            kspaceBuffer[((std::size_t)z*croppedPixels + p)*numCoils + c] = kspacePixels[p];
+        }
+      }
 
-#pragma omp critical
-              {
-                magnitudeDwiImage->SetPixel(index3D, magPix);
-                m_PhaseImage->SetPixel(index3D, phasePix);
-              }
-            }
+      // put slice back into channel g
+      for (unsigned int p=0; p<croppedPixels; p++)
+      {
+        std::size_t offset = ((std::size_t)z*croppedPixels + p)*numVolumes + g;
+        if (numCoils>1)
+        {
+          magnitudeBuffer[offset] = sqrt(sumMagnitude[p]/numCoils);
+          phaseBuffer[offset] = sqrt(sumPhase[p]/numCoils);
         }
+        else
+        {
+          magnitudeBuffer[offset] = sumMagnitude[p];
+          phaseBuffer[offset] = sumPhase[p];
+        }
+      }
+
+#pragma omp critical (TractsToDWIImageFilterProgress)
+      {
+        if (this->GetAbortGenerateData())
+          aborted = true;
 
         ++disp;
         unsigned long newTick = 50*disp.count()/disp.expected_count();
@@ -332,7 +389,19 @@ namespace itk
         lastTick = newTick;
       }
     }
+    clock.Stop();
+
+    if (aborted)
+      return NULL;
+
+    for (unsigned int g=0; g<numVolumes; g++)
+      for (unsigned int z=0; z<numSlices; z++)
+        m_SpikeLog += spikeLogs[z*numVolumes + g];
+
+    m_SlicesPerSecond = clock.GetTotal()>0 ? workItems.size()/clock.GetTotal() : 0;
     PrintToLog("\n", false);
+    PrintToLog("Simulated " + boost::lexical_cast<std::string>(workItems.size()) + " slices with " + boost::lexical_cast<std::string>(numThreads)
+               + " threads (" + boost::lexical_cast<std::string>(m_SlicesPerSecond) + " slices per second)");
     return magnitudeDwiImage;
   }
 
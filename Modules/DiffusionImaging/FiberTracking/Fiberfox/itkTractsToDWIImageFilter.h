@@ -79,6 +79,7 @@ public:
     itkGetMacro( PhaseImage, DoubleDwiType::Pointer )
     itkGetMacro( KspaceImage, DoubleDwiType::Pointer )
     itkGetMacro( CoilPointset, mitk::PointSet::Pointer )
+    itkGetMacro( SlicesPerSecond, double )                  ///< Throughput of the last k-space simulation.
 
     void GenerateData();
 
@@ -95,7 +96,18 @@ protected:
     bool PrepareLogFile();  /** Prepares the log file and returns true if successful or false if failed. */
     void PrintToLog(string m, bool addTime=true, bool linebreak=true, bool stdOut=true);
 
-    /** Transform generated image compartment by compartment, channel by channel and slice by slice using DFT and add k-space artifacts/effects. */
+    /** One slice of one volume of the k-space simulation. */
+    struct SliceWorkItem
+    {
+      unsigned int  m_Volume;
+      unsigned int  m_Slice;
+      int           m_NumSpikes;
+      int           m_SpikeCoil;
+    };
+
+    /** Transform generated image compartment by compartment, channel by channel and slice by slice using DFT and add k-space artifacts/effects.
+     * The slices of all volumes are simulated in parallel (dynamically scheduled), each thread reuses its own slice buffers
+     * and sums up the coils of its slice, so the results are written without synchronization. */
     DoubleDwiType::Pointer SimulateKspaceAcquisition(std::vector< DoubleDwiType::Pointer >& images);
 
     /** Generate signal of non-fiber compartments. */
@@ -126,6 +138,7 @@ protected:
     // MISC
     itk::TimeProbe                              m_TimeProbe;
     bool                                        m_UseConstantRandSeed;
+    double                                      m_SlicesPerSecond;
     bool                                        m_MaskImageSet;
     ofstream                                    m_Logfile;
     std::string                                 m_MotionLog;
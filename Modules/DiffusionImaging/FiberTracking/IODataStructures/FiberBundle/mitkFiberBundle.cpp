@@ -27,7 +27,6 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPointData.h>
 #include <vtkDataArray.h>
 #include <vtkUnsignedCharArray.h>
-#include <vtkPolyLine.h>
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
 #include <vtkIdFilter.h>
@@ -38,34 +37,46 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkParametricFunctionSource.h>
 #include <vtkParametricSpline.h>
 #include <vtkPolygon.h>
-#include <vtkCleanPolyData.h>
 #include <cmath>
+#include <map>
 #include <boost/progress.hpp>
 #include <vtkTransformPolyDataFilter.h>
 #include <mitkTransferFunction.h>
 #include <vtkLookupTable.h>
 #include <mitkLookupTable.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <omp.h>
 
 const char* mitk::FiberBundle::FIBER_ID_ARRAY = "Fiber_IDs";
 
 using namespace std;
 
 mitk::FiberBundle::FiberBundle( vtkPolyData* fiberPolyData )
-    : m_NumFibers(0)
+    : m_Fibers(fiberPolyData)
+    , m_NumFibers(0)
     , m_FiberSampling(0)
+    , m_SpatialIndexMTime(0)
 {
     m_FiberWeights = vtkSmartPointer<vtkFloatArray>::New();
     m_FiberWeights->SetName("FIBER_WEIGHTS");
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
     if (fiberPolyData != nullptr)
-    {
-        m_FiberPolyData = fiberPolyData;
         this->ColorFibersByOrientation();
-    }
 
     this->UpdateFiberGeometry();
-    this->GenerateFiberIds();
+}
+
+mitk::FiberBundle::FiberBundle( FiberBundleCompactData& fibers )
+    : m_NumFibers(0)
+    , m_FiberSampling(0)
+    , m_SpatialIndexMTime(0)
+{
+    m_FiberWeights = vtkSmartPointer<vtkFloatArray>::New();
+    m_FiberWeights->SetName("FIBER_WEIGHTS");
+
+    m_Fibers.Swap(fibers);
+    this->ColorFibersByOrientation();
+    this->UpdateFiberGeometry();
 }
 
 mitk::FiberBundle::~FiberBundle()
@@ -75,7 +86,8 @@ mitk::FiberBundle::~FiberBundle()
 
 mitk::FiberBundle::Pointer mitk::FiberBundle::GetDeepCopy()
 {
-    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(m_FiberPolyData);
+    FiberBundleCompactData fibers(m_Fibers);
+    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(fibers);
     newFib->SetFiberColors(this->m_FiberColors);
     newFib->SetFiberWeights(this->m_FiberWeights);
     return newFib;
@@ -83,35 +95,68 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::GetDeepCopy()
 
 vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GeneratePolyDataByIds(std::vector<long> fiberIds)
 {
-    vtkSmartPointer<vtkPolyData> newFiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> newLineSet = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPoints> newPointSet = vtkSmartPointer<vtkPoints>::New();
-
-    auto finIt = fiberIds.begin();
-    while ( finIt != fiberIds.end() )
+    for (std::size_t i=0; i<fiberIds.size(); i++)
     {
-        if (*finIt < 0 || *finIt>GetNumFibers()){
-            MITK_INFO << "FiberID can not be negative or >NumFibers!!! check id Extraction!" << *finIt;
+        if (fiberIds[i]<0 || fiberIds[i]>=GetNumFibers())
+        {
+            MITK_INFO << "FiberID can not be negative or >NumFibers!!! check id Extraction!" << fiberIds[i];
+            fiberIds.resize(i);
             break;
         }
+    }
+    return FiberBundleCompactData(m_Fibers, fiberIds).GeneratePolyData();
+}
 
-        vtkSmartPointer<vtkCell> fiber = m_FiberIdDataSet->GetCell(*finIt);//->DeepCopy(fiber);
-        vtkSmartPointer<vtkPoints> fibPoints = fiber->GetPoints();
-        vtkSmartPointer<vtkPolyLine> newFiber = vtkSmartPointer<vtkPolyLine>::New();
-        newFiber->GetPointIds()->SetNumberOfIds( fibPoints->GetNumberOfPoints() );
+// parts of the fibers touching the slab |normal*x - offset| <= halfThickness, including the fiber colors
+vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GeneratePolyDataInSlab(const double normal[3], double offset, double halfThickness)
+{
+    const FiberBundleSpatialIndex& index = this->GetSpatialIndex();
+    std::vector<FiberBundleSpatialIndex::SegmentId> segments;
+    index.FindSegmentsInSlab(normal, offset, halfThickness, segments);
 
-        for(int i=0; i<fibPoints->GetNumberOfPoints(); i++)
+    vtkSmartPointer<vtkPoints> newPointSet = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> newLineSet = vtkSmartPointer<vtkCellArray>::New();
+    vtkSmartPointer<vtkUnsignedCharArray> newColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    bool copyColors = m_FiberColors!=nullptr && m_FiberColors->GetNumberOfTuples()==static_cast<vtkIdType>(m_Fibers.GetNumberOfPoints());
+    if (copyColors)
+    {
+        newColors->SetNumberOfComponents(m_FiberColors->GetNumberOfComponents());
+        newColors->SetName(m_FiberColors->GetName());
+    }
+
+    // consecutive segments of a fiber are joined to one polyline
+    std::size_t first = 0;
+    while (first<segments.size())
+    {
+        std::size_t last = first;
+        while (last+1<segments.size() && segments[last+1]==segments[last]+1 && index.GetFiber(segments[last+1])==index.GetFiber(segments[first]))
+            last++;
+
+        // start point of the first segment, then the end points of all segments
+        newLineSet->InsertNextCell(static_cast<int>(last-first+2));
+        vtkIdType start, end;
+        index.GetSegmentPointIds(segments[first], start, end);
+        for (std::size_t s=first; s<=last+1; s++)
         {
-            newFiber->GetPointIds()->SetId(i, newPointSet->GetNumberOfPoints());
-            newPointSet->InsertNextPoint(fibPoints->GetPoint(i)[0], fibPoints->GetPoint(i)[1], fibPoints->GetPoint(i)[2]);
+            vtkIdType pointId = start;
+            if (s>first)
+            {
+                index.GetSegmentPointIds(segments[s-1], start, end);
+                pointId = end;
+            }
+            const float* p = m_Fibers.GetPoints()+3*pointId;
+            newLineSet->InsertCellPoint(newPointSet->InsertNextPoint(p[0], p[1], p[2]));
+            if (copyColors)
+                newColors->InsertNextTuple(pointId, m_FiberColors);
         }
-
-        newLineSet->InsertNextCell(newFiber);
-        ++finIt;
+        first = last+1;
     }
 
+    vtkSmartPointer<vtkPolyData> newFiberPolyData = vtkSmartPointer<vtkPolyData>::New();
     newFiberPolyData->SetPoints(newPointSet);
     newFiberPolyData->SetLines(newLineSet);
+    if (copyColors)
+        newFiberPolyData->GetPointData()->AddArray(newColors);
     return newFiberPolyData;
 }
 
@@ -125,62 +170,22 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::AddBundle(mitk::FiberBundle* fib)
     }
     MITK_INFO << "Adding fibers";
 
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
+    std::vector< const FiberBundleCompactData* > parts;
+    parts.push_back(&m_Fibers);
+    parts.push_back(&fib->m_Fibers);
+    FiberBundleCompactData fibers(parts);
 
-    // add current fiber bundle
+    int numFibers = this->GetNumFibers();
+    int numFibers2 = fib->GetNumFibers();
     vtkSmartPointer<vtkFloatArray> weights = vtkSmartPointer<vtkFloatArray>::New();
-    weights->SetNumberOfValues(this->GetNumFibers()+fib->GetNumFibers());
-
-    unsigned int counter = 0;
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-    {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double p[3];
-            points->GetPoint(j, p);
-
-            vtkIdType id = vNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        weights->InsertValue(counter, this->GetFiberWeight(i));
-        vNewLines->InsertNextCell(container);
-        counter++;
-    }
-
-    // add new fiber bundle
-    for (int i=0; i<fib->GetFiberPolyData()->GetNumberOfCells(); i++)
-    {
-        vtkCell* cell = fib->GetFiberPolyData()->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double p[3];
-            points->GetPoint(j, p);
-
-            vtkIdType id = vNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        weights->InsertValue(counter, fib->GetFiberWeight(i));
-        vNewLines->InsertNextCell(container);
-        counter++;
-    }
-
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
+    weights->SetNumberOfValues(numFibers+numFibers2);
+    for (int i=0; i<numFibers; i++)
+        weights->SetValue(i, this->GetFiberWeight(i));
+    for (int i=0; i<numFibers2; i++)
+        weights->SetValue(numFibers+i, fib->GetFiberWeight(i));
 
     // initialize fiber bundle
-    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(vNewPolyData);
+    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(fibers);
     newFib->SetFiberWeights(weights);
     return newFib;
 }
@@ -190,71 +195,57 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::SubtractBundle(mitk::FiberBundle*
 {
     MITK_INFO << "Subtracting fibers";
 
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
+    const FiberBundleCompactData& fibers = m_Fibers;
+    const FiberBundleCompactData& fibers2 = fib->m_Fibers;
 
-    // iterate over current fibers
-    boost::progress_display disp(m_NumFibers);
-    for( int i=0; i<m_NumFibers; i++ )
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+    // only fibers with the same number of points are compared
+    std::map< std::size_t, std::vector<long> > fibersBySize;
+    for (std::size_t i2=0; i2<fibers2.GetNumberOfFibers(); i2++)
+        fibersBySize[fibers2.GetNumberOfFiberPoints(i2)].push_back(static_cast<long>(i2));
 
-        if (points==nullptr || numPoints<=0)
+    long numFibers = static_cast<long>(fibers.GetNumberOfFibers());
+    std::vector< char > contained(numFibers, 0);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long i=0; i<numFibers; i++)
+    {
+        std::size_t numPoints = fibers.GetNumberOfFiberPoints(i);
+        auto candidates = fibersBySize.find(numPoints);
+        if (numPoints==0)
+            contained[i] = 1;
+        if (numPoints==0 || candidates==fibersBySize.end())
             continue;
 
-        int numFibers2 = fib->GetNumFibers();
-        bool contained = false;
-        for( int i2=0; i2<numFibers2; i2++ )
+        // check endpoints
+        const float* points = fibers.GetFiberPoints(i);
+        itk::Point<float, 3> point_start(points);
+        itk::Point<float, 3> point_end(points+3*(numPoints-1));
+        for (long i2 : candidates->second)
         {
-            vtkCell* cell2 = fib->GetFiberPolyData()->GetCell(i2);
-            int numPoints2 = cell2->GetNumberOfPoints();
-            vtkPoints* points2 = cell2->GetPoints();
-
-            if (points2==nullptr)// || numPoints2<=0)
-                continue;
-
-            // check endpoints
-            if (numPoints2==numPoints)
-            {
-                itk::Point<float, 3> point_start = GetItkPoint(points->GetPoint(0));
-                itk::Point<float, 3> point_end = GetItkPoint(points->GetPoint(numPoints-1));
-                itk::Point<float, 3> point2_start = GetItkPoint(points2->GetPoint(0));
-                itk::Point<float, 3> point2_end = GetItkPoint(points2->GetPoint(numPoints2-1));
+            const float* points2 = fibers2.GetFiberPoints(i2);
+            itk::Point<float, 3> point2_start(points2);
+            itk::Point<float, 3> point2_end(points2+3*(numPoints-1));
 
-                if ((point_start.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps) ||
-                        (point_start.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps))
-                {
-                    // further checking ???
-                    contained = true;
-                    break;
-                }
-            }
-        }
-
-        // add to result because fiber is not subtracted
-        if (!contained)
-        {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for( int j=0; j<numPoints; j++)
+            if ((point_start.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps) ||
+                    (point_start.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps))
             {
-                vtkIdType id = vNewPoints->InsertNextPoint(points->GetPoint(j));
-                container->GetPointIds()->InsertNextId(id);
+                // further checking ???
+                contained[i] = 1;
+                break;
             }
-            vNewLines->InsertNextCell(container);
         }
     }
-    if(vNewLines->GetNumberOfCells()==0)
+
+    // add to result because fiber is not subtracted
+    std::vector< long > fiberIds;
+    for (long i=0; i<numFibers; i++)
+        if (!contained[i])
+            fiberIds.push_back(i);
+    if (fiberIds.empty())
         return nullptr;
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
 
     // initialize fiber bundle
-    return mitk::FiberBundle::New(vNewPolyData);
+    FiberBundleCompactData newFibers(m_Fibers, fiberIds);
+    return mitk::FiberBundle::New(newFibers);
 }
 
 itk::Point<float, 3> mitk::FiberBundle::GetItkPoint(double point[3])
@@ -271,19 +262,33 @@ itk::Point<float, 3> mitk::FiberBundle::GetItkPoint(double point[3])
  */
 void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, bool updateGeometry)
 {
-    if (fiberPD == nullptr)
-        this->m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    else
-    {
-        m_FiberPolyData->DeepCopy(fiberPD);
-        ColorFibersByOrientation();
-    }
+    // the polydata is copied, it may be the one returned by GetFiberPolyData()
+    FiberBundleCompactData fibers(fiberPD);
+    this->SetFibers(fibers, updateGeometry);
+}
 
-    m_NumFibers = m_FiberPolyData->GetNumberOfLines();
+void mitk::FiberBundle::SetFibers(FiberBundleCompactData& fibers, bool updateGeometry)
+{
+    m_Fibers.Swap(fibers);
+    this->FibersModified(updateGeometry);
+}
+
+void mitk::FiberBundle::FibersModified(bool updateGeometry)
+{
+    this->InvalidateFiberPolyData();
+    m_NumFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
+    this->ColorFibersByOrientation();
 
     if (updateGeometry)
-        UpdateFiberGeometry();
-    GenerateFiberIds();
+        this->UpdateFiberGeometry();
+}
+
+void mitk::FiberBundle::InvalidateFiberPolyData()
+{
+    // these hold references to the points of m_Fibers
+    m_FiberPolyData = nullptr;
+    m_FiberIdDataSet = nullptr;
+    m_SpatialIndex.Clear();
 }
 
 /*
@@ -291,9 +296,28 @@ void mitk::FiberBundle::SetFiberPolyData(vtkSmartPointer<vtkPolyData> fiberPD, b
  */
 vtkSmartPointer<vtkPolyData> mitk::FiberBundle::GetFiberPolyData() const
 {
+    if (m_FiberPolyData == nullptr)
+        m_FiberPolyData = m_Fibers.GeneratePolyData();
     return m_FiberPolyData;
 }
 
+const mitk::FiberBundleSpatialIndex& mitk::FiberBundle::GetSpatialIndex()
+{
+    vtkSmartPointer<vtkPolyData> fiberPolyData = this->GetFiberPolyData();
+
+    // only the points and lines matter, changes of the point data (e.g. colors) keep the index
+    unsigned long mTime = fiberPolyData->GetLines()->GetMTime();
+    if (fiberPolyData->GetPoints()!=nullptr)
+        mTime = std::max(mTime, fiberPolyData->GetPoints()->GetMTime());
+
+    if (m_SpatialIndex.GetPolyData()!=fiberPolyData || m_SpatialIndexMTime!=mTime)
+    {
+        m_SpatialIndex.Build(fiberPolyData);
+        m_SpatialIndexMTime = mTime;
+    }
+    return m_SpatialIndex;
+}
+
 void mitk::FiberBundle::ColorFibersByOrientation()
 {
     //===== FOR WRITING A TEST ========================
@@ -304,11 +328,7 @@ void mitk::FiberBundle::ColorFibersByOrientation()
     //  + one fiber with 0 points
     //=================================================
 
-    vtkPoints* extrPoints = nullptr;
-    extrPoints = m_FiberPolyData->GetPoints();
-    int numOfPoints = 0;
-    if (extrPoints!=nullptr)
-        numOfPoints = extrPoints->GetNumberOfPoints();
+    int numOfPoints = static_cast<int>(m_Fibers.GetNumberOfPoints());
 
     //colors and alpha value for each single point, RGBA = 4 components
     unsigned char rgba[4] = {0,0,0,0};
@@ -318,18 +338,16 @@ void mitk::FiberBundle::ColorFibersByOrientation()
     m_FiberColors->SetNumberOfComponents(componentSize);
     m_FiberColors->SetName("FIBER_COLORS");
 
-    int numOfFibers = m_FiberPolyData->GetNumberOfLines();
+    int numOfFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
     if (numOfFibers < 1)
         return;
 
     /* extract single fibers of fiberBundle */
-    vtkCellArray* fiberList = m_FiberPolyData->GetLines();
-    fiberList->InitTraversal();
     for (int fi=0; fi<numOfFibers; ++fi) {
 
-        vtkIdType* idList; // contains the point id's of the line
-        vtkIdType pointsPerFiber; // number of points for current line
-        fiberList->GetNextCell(pointsPerFiber, idList);
+        const float* fiberPoints = m_Fibers.GetFiberPoints(fi); // x, y and z of the points of the line
+        vtkIdType firstPoint = static_cast<vtkIdType>(m_Fibers.GetFiberOffset(fi));
+        vtkIdType pointsPerFiber = static_cast<vtkIdType>(m_Fibers.GetNumberOfFiberPoints(fi)); // number of points for current line
 
         /* single fiber checkpoints: is number of points valid */
         if (pointsPerFiber > 1)
@@ -337,13 +355,15 @@ void mitk::FiberBundle::ColorFibersByOrientation()
             /* operate on points of single fiber */
             for (int i=0; i <pointsPerFiber; ++i)
             {
+                const float* p = fiberPoints + 3*i;
+
                 /* process all points except starting and endpoint for calculating color value take current point, previous point and next point */
                 if (i<pointsPerFiber-1 && i > 0)
                 {
                     /* The color value of the current point is influenced by the previous point and next point. */
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > nextPntvtk(extrPoints->GetPoint(idList[i+1])[0], extrPoints->GetPoint(idList[i+1])[1], extrPoints->GetPoint(idList[i+1])[2]);
-                    vnl_vector_fixed< double, 3 > prevPntvtk(extrPoints->GetPoint(idList[i-1])[0], extrPoints->GetPoint(idList[i-1])[1], extrPoints->GetPoint(idList[i-1])[2]);
+                    vnl_vector_fixed< double, 3 > currentPntvtk(p[0], p[1], p[2]);
+                    vnl_vector_fixed< double, 3 > nextPntvtk(p[3], p[4], p[5]);
+                    vnl_vector_fixed< double, 3 > prevPntvtk(p[-3], p[-2], p[-1]);
 
                     vnl_vector_fixed< double, 3 > diff1;
                     diff1 = currentPntvtk - nextPntvtk;
@@ -364,8 +384,8 @@ void mitk::FiberBundle::ColorFibersByOrientation()
                 {
                     /* First point has no previous point, therefore only diff1 is taken */
 
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > nextPntvtk(extrPoints->GetPoint(idList[i+1])[0], extrPoints->GetPoint(idList[i+1])[1], extrPoints->GetPoint(idList[i+1])[2]);
+                    vnl_vector_fixed< double, 3 > currentPntvtk(p[0], p[1], p[2]);
+                    vnl_vector_fixed< double, 3 > nextPntvtk(p[3], p[4], p[5]);
 
                     vnl_vector_fixed< double, 3 > diff1;
                     diff1 = currentPntvtk - nextPntvtk;
@@ -379,8 +399,8 @@ void mitk::FiberBundle::ColorFibersByOrientation()
                 else if (i==pointsPerFiber-1)
                 {
                     /* Last point has no next point, therefore only diff2 is taken */
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > prevPntvtk(extrPoints->GetPoint(idList[i-1])[0], extrPoints->GetPoint(idList[i-1])[1], extrPoints->GetPoint(idList[i-1])[2]);
+                    vnl_vector_fixed< double, 3 > currentPntvtk(p[0], p[1], p[2]);
+                    vnl_vector_fixed< double, 3 > prevPntvtk(p[-3], p[-2], p[-1]);
 
                     vnl_vector_fixed< double, 3 > diff2;
                     diff2 = currentPntvtk - prevPntvtk;
@@ -391,7 +411,7 @@ void mitk::FiberBundle::ColorFibersByOrientation()
                     rgba[2] = (unsigned char) (255.0 * std::fabs(diff2[2]));
                     rgba[3] = (unsigned char) (255.0);
                 }
-                m_FiberColors->InsertTupleValue(idList[i], rgba);
+                m_FiberColors->InsertTupleValue(firstPoint+i, rgba);
             }
         }
         else if (pointsPerFiber == 1)
@@ -417,7 +437,7 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
     unsigned char rgba[4] = {0,0,0,0};
     int componentSize = 4;
     m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * componentSize);
+    m_FiberColors->Allocate(m_Fibers.GetNumberOfPoints() * componentSize);
     m_FiberColors->SetNumberOfComponents(componentSize);
     m_FiberColors->SetName("FIBER_COLORS");
 
@@ -432,13 +452,13 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
     double min = 1;
     double max = 0;
     MITK_INFO << "Coloring fibers by curvature";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    int numFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
+    boost::progress_display disp(numFibers);
+    for (int i=0; i<numFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        int numPoints = static_cast<int>(m_Fibers.GetNumberOfFiberPoints(i));
+        const float* points = m_Fibers.GetFiberPoints(i);
 
         // calculate curvatures
         for (int j=0; j<numPoints; j++)
@@ -449,10 +469,8 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
             vnl_vector_fixed< float, 3 > meanV; meanV.fill(0.0);
             while(dist<window/2 && c>1)
             {
-                double p1[3];
-                points->GetPoint(c-1, p1);
-                double p2[3];
-                points->GetPoint(c, p2);
+                const float* p1 = points+3*(c-1);
+                const float* p2 = points+3*c;
 
                 vnl_vector_fixed< float, 3 > v;
                 v[0] = p2[0]-p1[0];
@@ -469,10 +487,8 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
             dist = 0;
             while(dist<window/2 && c<numPoints-1)
             {
-                double p1[3];
-                points->GetPoint(c, p1);
-                double p2[3];
-                points->GetPoint(c+1, p2);
+                const float* p1 = points+3*c;
+                const float* p2 = points+3*(c+1);
 
                 vnl_vector_fixed< float, 3 > v;
                 v[0] = p2[0]-p1[0];
@@ -509,10 +525,10 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
         }
     }
     unsigned int count = 0;
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    for (int i=0; i<numFibers; i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
+        int numPoints = static_cast<int>(m_Fibers.GetNumberOfFiberPoints(i));
+        vtkIdType firstPoint = static_cast<vtkIdType>(m_Fibers.GetFiberOffset(i));
         for (int j=0; j<numPoints; j++)
         {
             double color[3];
@@ -526,7 +542,7 @@ void mitk::FiberBundle::ColorFibersByCurvature(bool minMaxNorm)
             rgba[1] = (unsigned char) (255.0 * color[1]);
             rgba[2] = (unsigned char) (255.0 * color[2]);
             rgba[3] = (unsigned char) (255.0);
-            m_FiberColors->InsertTupleValue(cell->GetPointId(j), rgba);
+            m_FiberColors->InsertTupleValue(firstPoint+j, rgba);
             count++;
         }
     }
@@ -565,14 +581,14 @@ template <typename TPixel>
 void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Image::Pointer image, bool opacity)
 {
     m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
+    m_FiberColors->Allocate(m_Fibers.GetNumberOfPoints() * 4);
     m_FiberColors->SetNumberOfComponents(4);
     m_FiberColors->SetName("FIBER_COLORS");
 
     mitk::ImagePixelReadAccessor<TPixel,3> readimage(image, image->GetVolumeData(0));
 
     unsigned char rgba[4] = {0,0,0,0};
-    vtkPoints* pointSet = m_FiberPolyData->GetPoints();
+    const float* pointSet = m_Fibers.GetPoints();
 
     mitk::LookupTable::Pointer mitkLookup = mitk::LookupTable::New();
     vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
@@ -581,12 +597,13 @@ void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Imag
     mitkLookup->SetVtkLookupTable(lookupTable);
     mitkLookup->SetType(mitk::LookupTable::JET);
 
-    for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+    long numPoints = static_cast<long>(m_Fibers.GetNumberOfPoints());
+    for(long i=0; i<numPoints; ++i)
     {
         Point3D px;
-        px[0] = pointSet->GetPoint(i)[0];
-        px[1] = pointSet->GetPoint(i)[1];
-        px[2] = pointSet->GetPoint(i)[2];
+        px[0] = pointSet[3*i];
+        px[1] = pointSet[3*i+1];
+        px[2] = pointSet[3*i+2];
         double pixelValue = readimage.GetPixelByWorldCoordinates(px);
 
         double color[3];
@@ -608,12 +625,13 @@ void mitk::FiberBundle::ColorFibersByScalarMap(const mitk::PixelType, mitk::Imag
 void mitk::FiberBundle::SetFiberColors(float r, float g, float b, float alpha)
 {
     m_FiberColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
-    m_FiberColors->Allocate(m_FiberPolyData->GetNumberOfPoints() * 4);
+    m_FiberColors->Allocate(m_Fibers.GetNumberOfPoints() * 4);
     m_FiberColors->SetNumberOfComponents(4);
     m_FiberColors->SetName("FIBER_COLORS");
 
+    long numPoints = static_cast<long>(m_Fibers.GetNumberOfPoints());
     unsigned char rgba[4] = {0,0,0,0};
-    for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+    for(long i=0; i<numPoints; ++i)
     {
         rgba[0] = (unsigned char) r;
         rgba[1] = (unsigned char) g;
@@ -627,11 +645,8 @@ void mitk::FiberBundle::SetFiberColors(float r, float g, float b, float alpha)
 
 void mitk::FiberBundle::GenerateFiberIds()
 {
-    if (m_FiberPolyData == nullptr)
-        return;
-
     vtkSmartPointer<vtkIdFilter> idFiberFilter = vtkSmartPointer<vtkIdFilter>::New();
-    idFiberFilter->SetInputData(m_FiberPolyData);
+    idFiberFilter->SetInputData(this->GetFiberPolyData());
     idFiberFilter->CellIdsOn();
     //  idFiberFilter->PointIdsOn(); // point id's are not needed
     idFiberFilter->SetIdsArrayName(FIBER_ID_ARRAY);
@@ -642,250 +657,213 @@ void mitk::FiberBundle::GenerateFiberIds()
 
 }
 
-mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint, bool invert, bool bothEnds)
+// true if the point lies in a nonzero voxel of the mask
+static bool IsInMask(const mitk::FiberBundle::ItkUcharImgType* mask, const double* p)
 {
-    vtkSmartPointer<vtkPolyData> polyData = m_FiberPolyData;
-    if (anyPoint)
-    {
-        float minSpacing = 1;
-        if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
-            minSpacing = mask->GetSpacing()[0];
-        else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
-            minSpacing = mask->GetSpacing()[1];
-        else
-            minSpacing = mask->GetSpacing()[2];
+    itk::Point<float, 3> itkP;
+    itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
+    itk::Index<3> idx;
+    mask->TransformPhysicalPointToIndex(itkP, idx);
+    return mask->GetLargestPossibleRegion().IsInside(idx) && mask->GetPixel(idx)>0;
+}
 
-        mitk::FiberBundle::Pointer fibCopy = this->GetDeepCopy();
-        fibCopy->ResampleSpline(minSpacing/5);
-        polyData = fibCopy->GetFiberPolyData();
-    }
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+// fibers with a segment closer than margin to the bounding box of the nonzero mask voxels
+static std::vector<long> FindFibersNearMask(const mitk::FiberBundleSpatialIndex& index, const mitk::FiberBundle::ItkUcharImgType* mask, double margin)
+{
+    typedef mitk::FiberBundle::ItkUcharImgType ItkUcharImgType;
 
-    MITK_INFO << "Extracting fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
+    itk::Index<3> minIndex, maxIndex;
+    bool empty = true;
+    itk::ImageRegionConstIteratorWithIndex< ItkUcharImgType > it(mask, mask->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
     {
-        ++disp;
-
-        vtkCell* cell = polyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkCell* cellOriginal = m_FiberPolyData->GetCell(i);
-        int numPointsOriginal = cellOriginal->GetNumberOfPoints();
-        vtkPoints* pointsOriginal = cellOriginal->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+        if (it.Get()<=0)
+            continue;
+        itk::Index<3> idx = it.GetIndex();
+        for (int i=0; i<3; i++)
+        {
+            minIndex[i] = empty ? idx[i] : std::min(minIndex[i], idx[i]);
+            maxIndex[i] = empty ? idx[i] : std::max(maxIndex[i], idx[i]);
+        }
+        empty = false;
+    }
+    if (empty)
+        return std::vector<long>();
 
-        if (numPoints>1 && numPointsOriginal)
+    double bounds[6] = { itk::NumericTraits<double>::max(), -itk::NumericTraits<double>::max(),
+                         itk::NumericTraits<double>::max(), -itk::NumericTraits<double>::max(),
+                         itk::NumericTraits<double>::max(), -itk::NumericTraits<double>::max() };
+    for (int c=0; c<8; c++)
+    {
+        itk::ContinuousIndex<double, 3> corner;
+        corner[0] = (c&1) ? maxIndex[0]+0.5 : minIndex[0]-0.5;
+        corner[1] = (c&2) ? maxIndex[1]+0.5 : minIndex[1]-0.5;
+        corner[2] = (c&4) ? maxIndex[2]+0.5 : minIndex[2]-0.5;
+        itk::Point<double, 3> p;
+        mask->TransformContinuousIndexToPhysicalPoint(corner, p);
+        for (int i=0; i<3; i++)
         {
-            if (anyPoint)
-            {
-                if (!invert)
-                {
-                    for (int j=0; j<numPoints; j++)
-                    {
-                        double* p = points->GetPoint(j);
+            bounds[2*i] = std::min(bounds[2*i], p[i]-margin);
+            bounds[2*i+1] = std::max(bounds[2*i+1], p[i]+margin);
+        }
+    }
+    return index.FindFibers(bounds);
+}
 
-                        itk::Point<float, 3> itkP;
-                        itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-                        itk::Index<3> idx;
-                        mask->TransformPhysicalPointToIndex(itkP, idx);
+static float GetMinSpacing(const mitk::FiberBundle::ItkUcharImgType* mask)
+{
+    float minSpacing = 1;
+    if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
+        minSpacing = mask->GetSpacing()[0];
+    else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
+        minSpacing = mask->GetSpacing()[1];
+    else
+        minSpacing = mask->GetSpacing()[2];
+    return minSpacing;
+}
 
-                        if ( mask->GetPixel(idx)>0 && mask->GetLargestPossibleRegion().IsInside(idx) )
-                        {
-                            for (int k=0; k<numPointsOriginal; k++)
-                            {
-                                double* p = pointsOriginal->GetPoint(k);
-                                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                                container->GetPointIds()->InsertNextId(id);
-                            }
-                            break;
-                        }
-                    }
-                }
-                else
-                {
-                    bool includeFiber = true;
-                    for (int j=0; j<numPoints; j++)
-                    {
-                        double* p = points->GetPoint(j);
+mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint, bool invert, bool bothEnds)
+{
+    int numFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
 
-                        itk::Point<float, 3> itkP;
-                        itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-                        itk::Index<3> idx;
-                        mask->TransformPhysicalPointToIndex(itkP, idx);
+    MITK_INFO << "Extracting fibers";
+    std::vector< unsigned char > extract(numFibers, 0);
+    if (anyPoint)
+    {
+        const FiberBundleSpatialIndex& index = this->GetSpatialIndex();
+        float minSpacing = GetMinSpacing(mask);
 
-                        if ( mask->GetPixel(idx)>0 && mask->GetLargestPossibleRegion().IsInside(idx) )
-                        {
-                            includeFiber = false;
-                            break;
-                        }
-                    }
-                    if (includeFiber)
-                    {
+        // A spline segment stays closer than one segment length to the original segment, so only the fibers
+        // near the mask have to be resampled and tested. All others are kept if the selection is inverted.
+        std::vector<long> candidates = FindFibersNearMask(index, mask, index.GetMaxSegmentLength()+minSpacing);
+        if (invert)
+            for (int i=0; i<numFibers; i++)
+                extract[i] = index.GetNumberOfFiberPoints(i)>1;
 
-                        for (int k=0; k<numPointsOriginal; k++)
-                        {
-                            double* p = pointsOriginal->GetPoint(k);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                            container->GetPointIds()->InsertNextId(id);
-                        }
-                    }
-                }
-            }
-            else
+        if (!candidates.empty())
+        {
+            FiberBundleCompactData candidateData(m_Fibers, candidates);
+            mitk::FiberBundle::Pointer candidateFibers = mitk::FiberBundle::New(candidateData);
+            candidateFibers->ResampleSpline(minSpacing/5);
+            const FiberBundleCompactData& resampled = candidateFibers->m_Fibers;
+
+#pragma omp parallel for schedule(dynamic, 16)
+            for (int k=0; k<(int)candidates.size(); k++)
             {
-                double* start = pointsOriginal->GetPoint(0);
-                itk::Point<float, 3> itkStart;
-                itkStart[0] = start[0]; itkStart[1] = start[1]; itkStart[2] = start[2];
-                itk::Index<3> idxStart;
-                mask->TransformPhysicalPointToIndex(itkStart, idxStart);
-
-                double* end = pointsOriginal->GetPoint(numPointsOriginal-1);
-                itk::Point<float, 3> itkEnd;
-                itkEnd[0] = end[0]; itkEnd[1] = end[1]; itkEnd[2] = end[2];
-                itk::Index<3> idxEnd;
-                mask->TransformPhysicalPointToIndex(itkEnd, idxEnd);
-
-                if (invert)
-                {
-                    if (bothEnds)
-                    {
-                        if ( !mask->GetPixel(idxStart)>0 && !mask->GetPixel(idxEnd)>0 )
-                        {
-                            for (int j=0; j<numPointsOriginal; j++)
-                            {
-                                double* p = pointsOriginal->GetPoint(j);
-                                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                                container->GetPointIds()->InsertNextId(id);
-                            }
-                        }
-                    }
-                    else if ( !mask->GetPixel(idxStart)>0 || !mask->GetPixel(idxEnd)>0 )
-                    {
-                        for (int j=0; j<numPointsOriginal; j++)
-                        {
-                            double* p = pointsOriginal->GetPoint(j);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                            container->GetPointIds()->InsertNextId(id);
-                        }
-                    }
-                }
-                else
+                vtkIdType numPoints = static_cast<vtkIdType>(resampled.GetNumberOfFiberPoints(k));
+                const float* points = resampled.GetFiberPoints(k);
+
+                bool inMask = false;
+                for (vtkIdType j=0; j<numPoints && !inMask; j++)
                 {
-                    if (bothEnds)
-                    {
-                        if ( mask->GetPixel(idxStart)>0 && mask->GetPixel(idxEnd)>0 && mask->GetLargestPossibleRegion().IsInside(idxStart) && mask->GetLargestPossibleRegion().IsInside(idxEnd) )
-                        {
-                            for (int j=0; j<numPointsOriginal; j++)
-                            {
-                                double* p = pointsOriginal->GetPoint(j);
-                                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                                container->GetPointIds()->InsertNextId(id);
-                            }
-                        }
-                    }
-                    else if ( (mask->GetPixel(idxStart)>0 && mask->GetLargestPossibleRegion().IsInside(idxStart)) || (mask->GetPixel(idxEnd)>0 && mask->GetLargestPossibleRegion().IsInside(idxEnd)) )
-                    {
-                        for (int j=0; j<numPointsOriginal; j++)
-                        {
-                            double* p = pointsOriginal->GetPoint(j);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                            container->GetPointIds()->InsertNextId(id);
-                        }
-                    }
+                    double p[3] = { points[3*j], points[3*j+1], points[3*j+2] };
+                    inMask = IsInMask(mask, p);
                 }
+                extract[candidates[k]] = numPoints>1 && inMask!=invert;
             }
         }
+    }
+    else
+    {
+#pragma omp parallel for
+        for (int i=0; i<numFibers; i++)
+        {
+            vtkIdType numPoints = static_cast<vtkIdType>(m_Fibers.GetNumberOfFiberPoints(i));
+            if (numPoints<=1)
+                continue;
+            const float* points = m_Fibers.GetFiberPoints(i);
 
-        vtkNewCells->InsertNextCell(container);
+            double start[3] = { points[0], points[1], points[2] };
+            double end[3] = { points[3*numPoints-3], points[3*numPoints-2], points[3*numPoints-1] };
+            bool startInMask = IsInMask(mask, start);
+            bool endInMask = IsInMask(mask, end);
+
+            if (invert)
+                extract[i] = bothEnds ? (!startInMask && !endInMask) : (!startInMask || !endInMask);
+            else
+                extract[i] = bothEnds ? (startInMask && endInMask) : (startInMask || endInMask);
+        }
     }
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    // copy the selected fibers, the others are inserted as empty fibers
+    if (numFibers<=0)
         return nullptr;
 
-    vtkSmartPointer<vtkPolyData> newPolyData = vtkSmartPointer<vtkPolyData>::New();
-    newPolyData->SetPoints(vtkNewPoints);
-    newPolyData->SetLines(vtkNewCells);
-    return mitk::FiberBundle::New(newPolyData);
+    std::vector< std::vector<float> > newFibers(numFibers);
+    for (int i=0; i<numFibers; i++)
+    {
+        if (!extract[i])
+            continue;
+        const float* points = m_Fibers.GetFiberPoints(i);
+        newFibers[i].assign(points, points+3*m_Fibers.GetNumberOfFiberPoints(i));
+    }
+    FiberBundleCompactData fibers(newFibers);
+    return mitk::FiberBundle::New(fibers);
 }
 
 mitk::FiberBundle::Pointer mitk::FiberBundle::RemoveFibersOutside(ItkUcharImgType* mask, bool invert)
 {
-    float minSpacing = 1;
-    if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
-        minSpacing = mask->GetSpacing()[0];
-    else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
-        minSpacing = mask->GetSpacing()[1];
-    else
-        minSpacing = mask->GetSpacing()[2];
+    float minSpacing = GetMinSpacing(mask);
+    const FiberBundleSpatialIndex& index = this->GetSpatialIndex();
 
-    mitk::FiberBundle::Pointer fibCopy = this->GetDeepCopy();
+    // without inversion only the fibers near the mask keep any points, see ExtractFiberSubset
+    mitk::FiberBundle::Pointer fibCopy;
+    if (invert)
+        fibCopy = this->GetDeepCopy();
+    else
+    {
+        std::vector<long> candidates = FindFibersNearMask(index, mask, index.GetMaxSegmentLength()+minSpacing);
+        if (candidates.empty())
+            return nullptr;
+        FiberBundleCompactData candidateData(m_Fibers, candidates);
+        fibCopy = mitk::FiberBundle::New(candidateData);
+    }
     fibCopy->ResampleSpline(minSpacing/10);
-    vtkSmartPointer<vtkPolyData> polyData =fibCopy->GetFiberPolyData();
-
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    const FiberBundleCompactData& fibers = fibCopy->m_Fibers;
+    int numFibers = static_cast<int>(fibers.GetNumberOfFibers());
 
     MITK_INFO << "Cutting fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
+    std::vector< unsigned char > keepPoint(fibers.GetNumberOfPoints(), 0);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i=0; i<numFibers; i++)
     {
-        ++disp;
-
-        vtkCell* cell = polyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        vtkIdType numPoints = static_cast<vtkIdType>(fibers.GetNumberOfFiberPoints(i));
+        if (numPoints<=1)
+            continue;
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        if (numPoints>1)
+        const float* points = fibers.GetFiberPoints(i);
+        std::size_t firstPoint = fibers.GetFiberOffset(i);
+        for (vtkIdType j=0; j<numPoints; j++)
         {
-            int newNumPoints = 0;
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-
-                itk::Point<float, 3> itkP;
-                itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-                itk::Index<3> idx;
-                mask->TransformPhysicalPointToIndex(itkP, idx);
-
-                if ( mask->GetPixel(idx)>0 && mask->GetLargestPossibleRegion().IsInside(idx) && !invert )
-                {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                    container->GetPointIds()->InsertNextId(id);
-                    newNumPoints++;
-                }
-                else if ( (mask->GetPixel(idx)<=0 || !mask->GetLargestPossibleRegion().IsInside(idx)) && invert )
-                {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                    container->GetPointIds()->InsertNextId(id);
-                    newNumPoints++;
-                }
-                else if (newNumPoints>0)
-                {
-                    vtkNewCells->InsertNextCell(container);
+            double p[3] = { points[3*j], points[3*j+1], points[3*j+2] };
+            keepPoint[firstPoint+j] = IsInMask(mask, p)!=invert;
+        }
+    }
 
-                    newNumPoints = 0;
-                    container = vtkSmartPointer<vtkPolyLine>::New();
-                }
-            }
+    // every run of kept points becomes a new fiber
+    std::vector< std::vector<float> > newFibers;
+    for (int i=0; i<numFibers; i++)
+    {
+        vtkIdType numPoints = static_cast<vtkIdType>(fibers.GetNumberOfFiberPoints(i));
+        const float* points = fibers.GetFiberPoints(i);
+        std::size_t firstPoint = fibers.GetFiberOffset(i);
 
-            if (newNumPoints>0)
-                vtkNewCells->InsertNextCell(container);
+        vtkIdType runStart = 0;
+        for (vtkIdType j=0; j<=numPoints; j++)
+        {
+            if (j<numPoints && keepPoint[firstPoint+j])
+                continue;
+            if (j>runStart)
+                newFibers.push_back(std::vector<float>(points+3*runStart, points+3*j));
+            runStart = j+1;
         }
-
     }
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (newFibers.empty())
         return nullptr;
 
-    vtkSmartPointer<vtkPolyData> newPolyData = vtkSmartPointer<vtkPolyData>::New();
-    newPolyData->SetPoints(vtkNewPoints);
-    newPolyData->SetLines(vtkNewCells);
-    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(newPolyData);
+    FiberBundleCompactData cutFibers(newFibers);
+    mitk::FiberBundle::Pointer newFib = mitk::FiberBundle::New(cutFibers);
     newFib->Compress(0.1);
     return newFib;
 }
@@ -899,8 +877,8 @@ mitk::FiberBundle::Pointer mitk::FiberBundle::ExtractFiberSubset(DataNode* roi,
 
     if (tmp.size()<=0)
         return mitk::FiberBundle::New();
-    vtkSmartPointer<vtkPolyData> pTmp = GeneratePolyDataByIds(tmp);
-    return mitk::FiberBundle::New(pTmp);
+    FiberBundleCompactData fibers(m_Fibers, tmp);
+    return mitk::FiberBundle::New(fibers);
 }
 
 std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataStorage* storage)
@@ -987,37 +965,52 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
                 polygonVtk->GetPointIds()->InsertNextId(id);
             }
 
+            // only segments near the polygon can intersect it
+            double tolerance = 0.001;
+            double bounds[6];
+            polygonVtk->GetPoints()->GetBounds(bounds);
+            for (int i=0; i<3; i++)
+            {
+                bounds[2*i] -= 2*tolerance;
+                bounds[2*i+1] += 2*tolerance;
+            }
+            const FiberBundleSpatialIndex& index = this->GetSpatialIndex();
+            std::vector<FiberBundleSpatialIndex::SegmentId> segments;
+            index.FindSegments(bounds, segments);
+
+            // vtkPolygon::IntersectWithLine is not thread safe, every thread needs its own polygon
+            std::vector< vtkSmartPointer<vtkPolygon> > polygons(omp_get_max_threads());
+            for (unsigned int t=0; t<polygons.size(); t++)
+            {
+                polygons[t] = vtkSmartPointer<vtkPolygon>::New();
+                polygons[t]->DeepCopy(polygonVtk);
+            }
+
             MITK_INFO << "Extracting with polygon";
-            boost::progress_display disp(m_NumFibers);
-            for (int i=0; i<m_NumFibers; i++)
+            std::vector< unsigned char > intersects(segments.size(), 0);
+#pragma omp parallel for schedule(dynamic, 64)
+            for (int s=0; s<(int)segments.size(); s++)
             {
-                ++disp ;
-                vtkCell* cell = m_FiberPolyData->GetCell(i);
-                int numPoints = cell->GetNumberOfPoints();
-                vtkPoints* points = cell->GetPoints();
+                // Inputs
+                double p1[3] = {0,0,0};
+                double p2[3] = {0,0,0};
+                index.GetSegmentPoints(segments[s], p1, p2);
+
+                // Outputs
+                double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
+                double x[3] = {0,0,0}; // The coordinate of the intersection
+                double pcoords[3] = {0,0,0};
+                int subId = 0;
+
+                intersects[s] = polygons[omp_get_thread_num()]->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId)!=0;
+            }
 
-                for (int j=0; j<numPoints-1; j++)
-                {
-                    // Inputs
-                    double p1[3] = {0,0,0};
-                    points->GetPoint(j, p1);
-                    double p2[3] = {0,0,0};
-                    points->GetPoint(j+1, p2);
-                    double tolerance = 0.001;
-
-                    // Outputs
-                    double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
-                    double x[3] = {0,0,0}; // The coordinate of the intersection
-                    double pcoords[3] = {0,0,0};
-                    int subId = 0;
-
-                    int iD = polygonVtk->IntersectWithLine(p1, p2, tolerance, t, x, pcoords, subId);
-                    if (iD!=0)
-                    {
-                        result.push_back(i);
-                        break;
-                    }
-                }
+            // the segments are sorted by fiber
+            for (unsigned int s=0; s<segments.size(); s++)
+            {
+                long fiber = index.GetFiber(segments[s]);
+                if (intersects[s] && (result.empty() || result.back()!=fiber))
+                    result.push_back(fiber);
             }
         }
         else if ( dynamic_cast<mitk::PlanarCircle*>(roi->GetData()) )
@@ -1033,40 +1026,47 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
             double radius = V1w.EuclideanDistanceTo(V2w);
             radius *= radius;
 
-            MITK_INFO << "Extracting with circle";
-            boost::progress_display disp(m_NumFibers);
-            for (int i=0; i<m_NumFibers; i++)
+            // only segments in the bounding box of the circle can intersect it
+            double bounds[6];
+            for (int i=0; i<3; i++)
             {
-                ++disp ;
-                vtkCell* cell = m_FiberPolyData->GetCell(i);
-                int numPoints = cell->GetNumberOfPoints();
-                vtkPoints* points = cell->GetPoints();
+                bounds[2*i] = V1w[i]-std::sqrt(radius)-mitk::eps;
+                bounds[2*i+1] = V1w[i]+std::sqrt(radius)+mitk::eps;
+            }
+            const FiberBundleSpatialIndex& index = this->GetSpatialIndex();
+            std::vector<FiberBundleSpatialIndex::SegmentId> segments;
+            index.FindSegments(bounds, segments);
 
-                for (int j=0; j<numPoints-1; j++)
-                {
-                    // Inputs
-                    double p1[3] = {0,0,0};
-                    points->GetPoint(j, p1);
-                    double p2[3] = {0,0,0};
-                    points->GetPoint(j+1, p2);
+            MITK_INFO << "Extracting with circle";
+            std::vector< unsigned char > intersects(segments.size(), 0);
+#pragma omp parallel for schedule(dynamic, 64)
+            for (int s=0; s<(int)segments.size(); s++)
+            {
+                // Inputs
+                double p1[3] = {0,0,0};
+                double p2[3] = {0,0,0};
+                index.GetSegmentPoints(segments[s], p1, p2);
 
-                    // Outputs
-                    double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
-                    double x[3] = {0,0,0}; // The coordinate of the intersection
+                // Outputs
+                double t = 0; // Parametric coordinate of intersection (0 (corresponding to p1) to 1 (corresponding to p2))
+                double x[3] = {0,0,0}; // The coordinate of the intersection
 
-                    int iD = vtkPlane::IntersectWithLine(p1,p2,planeNormal.GetDataPointer(),V1w.GetDataPointer(),t,x);
+                int iD = vtkPlane::IntersectWithLine(p1,p2,planeNormal.GetDataPointer(),V1w.GetDataPointer(),t,x);
 
-                    if (iD!=0)
-                    {
-                        double dist = (x[0]-V1w[0])*(x[0]-V1w[0])+(x[1]-V1w[1])*(x[1]-V1w[1])+(x[2]-V1w[2])*(x[2]-V1w[2]);
-                        if( dist <= radius)
-                        {
-                            result.push_back(i);
-                            break;
-                        }
-                    }
+                if (iD!=0)
+                {
+                    double dist = (x[0]-V1w[0])*(x[0]-V1w[0])+(x[1]-V1w[1])*(x[1]-V1w[1])+(x[2]-V1w[2])*(x[2]-V1w[2]);
+                    intersects[s] = dist <= radius;
                 }
             }
+
+            // the segments are sorted by fiber
+            for (unsigned int s=0; s<segments.size(); s++)
+            {
+                long fiber = index.GetFiber(segments[s]);
+                if (intersects[s] && (result.empty() || result.back()!=fiber))
+                    result.push_back(fiber);
+            }
         }
         return result;
     }
@@ -1076,19 +1076,14 @@ std::vector<long> mitk::FiberBundle::ExtractFiberIdSubset(DataNode *roi, DataSto
 
 void mitk::FiberBundle::UpdateFiberGeometry()
 {
-    vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
-    cleaner->SetInputData(m_FiberPolyData);
-    cleaner->PointMergingOff();
-    cleaner->Update();
-    m_FiberPolyData = cleaner->GetOutput();
-
+    // the compact fibers contain no unused points, so nothing has to be cleaned
     m_FiberLengths.clear();
     m_MeanFiberLength = 0;
     m_MedianFiberLength = 0;
     m_LengthStDev = 0;
-    m_NumFibers = m_FiberPolyData->GetNumberOfCells();
+    m_NumFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
 
-    if (m_FiberColors==nullptr || m_FiberColors->GetNumberOfTuples()!=m_FiberPolyData->GetNumberOfPoints())
+    if (m_FiberColors==nullptr || m_FiberColors->GetNumberOfTuples()!=static_cast<vtkIdType>(m_Fibers.GetNumberOfPoints()))
         this->ColorFibersByOrientation();
 
     if (m_FiberWeights->GetSize()!=m_NumFibers)
@@ -1110,40 +1105,51 @@ void mitk::FiberBundle::UpdateFiberGeometry()
         SetGeometry(geometry);
         return;
     }
-    double b[6];
-    m_FiberPolyData->GetBounds(b);
+    // uninitialized bounds if there are no points, like vtkPolyData::GetBounds()
+    double b[6] = {1, -1, 1, -1, 1, -1};
+    const float* points = m_Fibers.GetPoints();
+    std::size_t numPoints = m_Fibers.GetNumberOfPoints();
+    for (std::size_t i=0; i<numPoints; i++)
+    {
+        for (int d=0; d<3; d++)
+        {
+            if (i==0 || points[3*i+d]<b[2*d])
+                b[2*d] = points[3*i+d];
+            if (i==0 || points[3*i+d]>b[2*d+1])
+                b[2*d+1] = points[3*i+d];
+        }
+    }
 
     // calculate statistics
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    m_FiberLengths.resize(m_NumFibers);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (int i=0; i<m_NumFibers; i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int p = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        int p = static_cast<int>(m_Fibers.GetNumberOfFiberPoints(i));
+        const float* fiberPoints = m_Fibers.GetFiberPoints(i);
         float length = 0;
         for (int j=0; j<p-1; j++)
         {
-            double p1[3];
-            points->GetPoint(j, p1);
-            double p2[3];
-            points->GetPoint(j+1, p2);
+            const float* p1 = fiberPoints+3*j;
+            const float* p2 = fiberPoints+3*(j+1);
 
-            float dist = std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
+            double d[3] = { static_cast<double>(p1[0])-p2[0], static_cast<double>(p1[1])-p2[1], static_cast<double>(p1[2])-p2[2] };
+            float dist = std::sqrt(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]);
             length += dist;
         }
-        m_FiberLengths.push_back(length);
+        m_FiberLengths[i] = length;
+    }
+
+    m_MinFiberLength = m_FiberLengths[0];
+    m_MaxFiberLength = m_FiberLengths[0];
+    for (int i=0; i<m_NumFibers; i++)
+    {
+        float length = m_FiberLengths[i];
         m_MeanFiberLength += length;
-        if (i==0)
-        {
+        if (length<m_MinFiberLength)
             m_MinFiberLength = length;
+        if (length>m_MaxFiberLength)
             m_MaxFiberLength = length;
-        }
-        else
-        {
-            if (length<m_MinFiberLength)
-                m_MinFiberLength = length;
-            if (length>m_MaxFiberLength)
-                m_MaxFiberLength = length;
-        }
     }
     m_MeanFiberLength /= m_NumFibers;
 
@@ -1198,7 +1204,8 @@ void mitk::FiberBundle::SetFiberWeight(unsigned int fiber, float weight)
 
 void mitk::FiberBundle::SetFiberColors(vtkSmartPointer<vtkUnsignedCharArray> fiberColors)
 {
-    for(long i=0; i<m_FiberPolyData->GetNumberOfPoints(); ++i)
+    long numPoints = static_cast<long>(m_Fibers.GetNumberOfPoints());
+    for(long i=0; i<numPoints; ++i)
     {
         unsigned char source[4] = {0,0,0,0};
         fiberColors->GetTupleValue(i, source);
@@ -1285,6 +1292,24 @@ itk::Point<float, 3> mitk::FiberBundle::TransformPoint(vnl_vector_fixed< double,
     return out;
 }
 
+// applies the transform to all fiber points in place and in parallel
+template< class PointTransform >
+static void TransformFiberPoints(mitk::FiberBundleCompactData& fibers, PointTransform transform)
+{
+    fibers.MakePointsWritable();
+    float* points = fibers.GetPoints();
+    long numPoints = static_cast<long>(fibers.GetNumberOfPoints());
+#pragma omp parallel for
+    for (long i=0; i<numPoints; i++)
+    {
+        double p[3] = { points[3*i], points[3*i+1], points[3*i+2] };
+        transform(p);
+        points[3*i] = p[0];
+        points[3*i+1] = p[1];
+        points[3*i+2] = p[2];
+    }
+}
+
 void mitk::FiberBundle::TransformFibers(double rx, double ry, double rz, double tx, double ty, double tz)
 {
     rx = rx*M_PI/180;
@@ -1314,37 +1339,19 @@ void mitk::FiberBundle::TransformFibers(double rx, double ry, double rz, double
     mitk::BaseGeometry::Pointer geom = this->GetGeometry();
     mitk::Point3D center = geom->GetCenter();
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
+    this->InvalidateFiberPolyData();
+    TransformFiberPoints(m_Fibers, [&](double* p)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            vnl_vector_fixed< double, 3 > dir;
-            dir[0] = p[0]-center[0];
-            dir[1] = p[1]-center[1];
-            dir[2] = p[2]-center[2];
-            dir = rot*dir;
-            dir[0] += center[0]+tx;
-            dir[1] += center[1]+ty;
-            dir[2] += center[2]+tz;
-            vtkIdType id = vtkNewPoints->InsertNextPoint(dir.data_block());
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+        vnl_vector_fixed< double, 3 > dir;
+        dir[0] = p[0]-center[0];
+        dir[1] = p[1]-center[1];
+        dir[2] = p[2]-center[2];
+        dir = rot*dir;
+        p[0] = dir[0] + (center[0]+tx);
+        p[1] = dir[1] + (center[1]+ty);
+        p[2] = dir[2] + (center[2]+tz);
+    });
+    this->FibersModified();
 }
 
 void mitk::FiberBundle::RotateAroundAxis(double x, double y, double z)
@@ -1374,112 +1381,57 @@ void mitk::FiberBundle::RotateAroundAxis(double x, double y, double z)
     mitk::BaseGeometry::Pointer geom = this->GetGeometry();
     mitk::Point3D center = geom->GetCenter();
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
+    vnl_matrix_fixed< double, 3, 3 > rot = rotZ*rotY*rotX;
+    this->InvalidateFiberPolyData();
+    TransformFiberPoints(m_Fibers, [&](double* p)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            vnl_vector_fixed< double, 3 > dir;
-            dir[0] = p[0]-center[0];
-            dir[1] = p[1]-center[1];
-            dir[2] = p[2]-center[2];
-            dir = rotZ*rotY*rotX*dir;
-            dir[0] += center[0];
-            dir[1] += center[1];
-            dir[2] += center[2];
-            vtkIdType id = vtkNewPoints->InsertNextPoint(dir.data_block());
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+        vnl_vector_fixed< double, 3 > dir;
+        dir[0] = p[0]-center[0];
+        dir[1] = p[1]-center[1];
+        dir[2] = p[2]-center[2];
+        dir = rot*dir;
+        p[0] = dir[0]+center[0];
+        p[1] = dir[1]+center[1];
+        p[2] = dir[2]+center[2];
+    });
+    this->FibersModified();
 }
 
 void mitk::FiberBundle::ScaleFibers(double x, double y, double z, bool subtractCenter)
 {
     MITK_INFO << "Scaling fibers";
-    boost::progress_display disp(m_NumFibers);
 
     mitk::BaseGeometry* geom = this->GetGeometry();
     mitk::Point3D c = geom->GetCenter();
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
+    this->InvalidateFiberPolyData();
+    TransformFiberPoints(m_Fibers, [&](double* p)
     {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
+        if (subtractCenter)
         {
-            double* p = points->GetPoint(j);
-            if (subtractCenter)
-            {
-                p[0] -= c[0]; p[1] -= c[1]; p[2] -= c[2];
-            }
-            p[0] *= x;
-            p[1] *= y;
-            p[2] *= z;
-            if (subtractCenter)
-            {
-                p[0] += c[0]; p[1] += c[1]; p[2] += c[2];
-            }
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
+            p[0] -= c[0]; p[1] -= c[1]; p[2] -= c[2];
         }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+        p[0] *= x;
+        p[1] *= y;
+        p[2] *= z;
+        if (subtractCenter)
+        {
+            p[0] += c[0]; p[1] += c[1]; p[2] += c[2];
+        }
+    });
+    this->FibersModified();
 }
 
 void mitk::FiberBundle::TranslateFibers(double x, double y, double z)
 {
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
-    for (int i=0; i<m_NumFibers; i++)
+    this->InvalidateFiberPolyData();
+    TransformFiberPoints(m_Fibers, [&](double* p)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            p[0] += x;
-            p[1] += y;
-            p[2] += z;
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+        p[0] += x;
+        p[1] += y;
+        p[2] += z;
+    });
+    this->FibersModified();
 }
 
 void mitk::FiberBundle::MirrorFibers(unsigned int axis)
@@ -1488,58 +1440,34 @@ void mitk::FiberBundle::MirrorFibers(unsigned int axis)
         return;
 
     MITK_INFO << "Mirroring fibers";
-    boost::progress_display disp(m_NumFibers);
-
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
 
-    for (int i=0; i<m_NumFibers; i++)
+    this->InvalidateFiberPolyData();
+    TransformFiberPoints(m_Fibers, [&](double* p)
     {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
-        {
-            double* p = points->GetPoint(j);
-            p[axis] = -p[axis];
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
-        }
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+        p[axis] = -p[axis];
+    });
+    this->FibersModified();
 }
 
 void mitk::FiberBundle::RemoveDir(vnl_vector_fixed<double,3> dir, double threshold)
 {
     dir.normalize();
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    std::vector< long > fiberIds;
 
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    int numFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
+    boost::progress_display disp(numFibers);
+    for (int i=0; i<numFibers; i++)
     {
         ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        int numPoints = static_cast<int>(m_Fibers.GetNumberOfFiberPoints(i));
+        const float* points = m_Fibers.GetFiberPoints(i);
 
         // calculate curvatures
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
         bool discard = false;
         for (int j=0; j<numPoints-1; j++)
         {
-            double p1[3];
-            points->GetPoint(j, p1);
-            double p2[3];
-            points->GetPoint(j+1, p2);
+            const float* p1 = points+3*j;
+            const float* p2 = points+3*(j+1);
 
             vnl_vector_fixed< double, 3 > v1;
             v1[0] = p2[0]-p1[0];
@@ -1557,24 +1485,11 @@ void mitk::FiberBundle::RemoveDir(vnl_vector_fixed<double,3> dir, double thresho
             }
         }
         if (!discard)
-        {
-            for (int j=0; j<numPoints; j++)
-            {
-                double p1[3];
-                points->GetPoint(j, p1);
-
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p1);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
-        }
+            fiberIds.push_back(i);
     }
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    FiberBundleCompactData fibers(m_Fibers, fiberIds);
+    this->SetFibers(fibers, true);
 
     //    UpdateColorCoding();
     //    UpdateFiberGeometry();
@@ -1585,28 +1500,24 @@ bool mitk::FiberBundle::ApplyCurvatureThreshold(float minRadius, bool deleteFibe
     if (minRadius<0)
         return true;
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    std::vector< std::vector<float> > newFibers;
 
     MITK_INFO << "Applying curvature threshold";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+    int numFibers = static_cast<int>(m_Fibers.GetNumberOfFibers());
+    boost::progress_display disp(numFibers);
+    for (int i=0; i<numFibers; i++)
     {
         ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        int numPoints = static_cast<int>(m_Fibers.GetNumberOfFiberPoints(i));
+        const float* points = m_Fibers.GetFiberPoints(i);
 
         // calculate curvatures
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+        std::vector<float> container;
         for (int j=0; j<numPoints-2; j++)
         {
-            double p1[3];
-            points->GetPoint(j, p1);
-            double p2[3];
-            points->GetPoint(j+1, p2);
-            double p3[3];
-            points->GetPoint(j+2, p3);
+            const float* p1 = points+3*j;
+            const float* p2 = points+3*(j+1);
+            const float* p3 = points+3*(j+2);
 
             vnl_vector_fixed< float, 3 > v1, v2, v3;
 
@@ -1627,8 +1538,7 @@ bool mitk::FiberBundle::ApplyCurvatureThreshold(float minRadius, bool deleteFibe
             float c = v3.magnitude();
             float r = a*b*c/std::sqrt((a+b+c)*(a+b-c)*(b+c-a)*(a-b+c)); // radius of triangle via Heron's formula (area of triangle)
 
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p1);
-            container->GetPointIds()->InsertNextId(id);
+            container.insert(container.end(), p1, p1+3);
 
             if (deleteFibers && r<minRadius)
                 break;
@@ -1636,27 +1546,23 @@ bool mitk::FiberBundle::ApplyCurvatureThreshold(float minRadius, bool deleteFibe
             if (r<minRadius)
             {
                 j += 2;
-                vtkNewCells->InsertNextCell(container);
-                container = vtkSmartPointer<vtkPolyLine>::New();
+                newFibers.push_back(container);
+                container.clear();
             }
             else if (j==numPoints-3)
             {
-                id = vtkNewPoints->InsertNextPoint(p2);
-                container->GetPointIds()->InsertNextId(id);
-                id = vtkNewPoints->InsertNextPoint(p3);
-                container->GetPointIds()->InsertNextId(id);
-                vtkNewCells->InsertNextCell(container);
+                container.insert(container.end(), p2, p2+3);
+                container.insert(container.end(), p3, p3+3);
+                newFibers.push_back(container);
             }
         }
     }
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (newFibers.empty())
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    FiberBundleCompactData fibers(newFibers);
+    this->SetFibers(fibers, true);
     return true;
 }
 
@@ -1675,40 +1581,26 @@ bool mitk::FiberBundle::RemoveShortFibers(float lengthInMM)
         return false;
     }
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    std::vector< long > fiberIds;
     float min = m_MaxFiberLength;
 
     boost::progress_display disp(m_NumFibers);
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
         if (m_FiberLengths.at(i)>=lengthInMM)
         {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
+            fiberIds.push_back(i);
             if (m_FiberLengths.at(i)<min)
                 min = m_FiberLengths.at(i);
         }
     }
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (fiberIds.empty())
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    FiberBundleCompactData fibers(m_Fibers, fiberIds);
+    this->SetFibers(fibers, true);
     return true;
 }
 
@@ -1720,38 +1612,22 @@ bool mitk::FiberBundle::RemoveLongFibers(float lengthInMM)
     if (lengthInMM<m_MinFiberLength)    // can't remove all fibers
         return false;
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    std::vector< long > fiberIds;
 
     MITK_INFO << "Removing long fibers";
     boost::progress_display disp(m_NumFibers);
     for (int i=0; i<m_NumFibers; i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
         if (m_FiberLengths.at(i)<=lengthInMM)
-        {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
-        }
+            fiberIds.push_back(i);
     }
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (fiberIds.empty())
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    FiberBundleCompactData fibers(m_Fibers, fiberIds);
+    this->SetFibers(fibers, true);
     return true;
 }
 
@@ -1760,67 +1636,72 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance, double tension, doub
     if (pointDistance<=0)
         return;
 
-    vtkSmartPointer<vtkPoints> vtkSmoothPoints = vtkSmartPointer<vtkPoints>::New(); //in smoothpoints the interpolated points representing a fiber are stored.
-
-    //in vtkcells all polylines are stored, actually all id's of them are stored
-    vtkSmartPointer<vtkCellArray> vtkSmoothCells = vtkSmartPointer<vtkCellArray>::New(); //cellcontainer for smoothed lines
-    vtkIdType pointHelperCnt = 0;
-
     MITK_INFO << "Smoothing fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
+    const FiberBundleCompactData& fibers = m_Fibers;
+    long numFibers = static_cast<long>(fibers.GetNumberOfFibers());
+    std::vector< std::vector<float> > smoothFibers(numFibers);
+
+#pragma omp parallel
     {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        // VTK object creation is not thread-safe, every thread reuses its own spline
+        vtkSmartPointer<vtkPoints> newPoints;
+        vtkSmartPointer<vtkParametricSpline> spline;
+#pragma omp critical
+        {
+            newPoints = vtkSmartPointer<vtkPoints>::New();
+            vtkSmartPointer<vtkKochanekSpline> xSpline = vtkSmartPointer<vtkKochanekSpline>::New();
+            vtkSmartPointer<vtkKochanekSpline> ySpline = vtkSmartPointer<vtkKochanekSpline>::New();
+            vtkSmartPointer<vtkKochanekSpline> zSpline = vtkSmartPointer<vtkKochanekSpline>::New();
+            xSpline->SetDefaultBias(bias); xSpline->SetDefaultTension(tension); xSpline->SetDefaultContinuity(continuity);
+            ySpline->SetDefaultBias(bias); ySpline->SetDefaultTension(tension); ySpline->SetDefaultContinuity(continuity);
+            zSpline->SetDefaultBias(bias); zSpline->SetDefaultTension(tension); zSpline->SetDefaultContinuity(continuity);
+
+            spline = vtkSmartPointer<vtkParametricSpline>::New();
+            spline->SetXSpline(xSpline);
+            spline->SetYSpline(ySpline);
+            spline->SetZSpline(zSpline);
+        }
 
-        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
-        for (int j=0; j<numPoints; j++)
-            newPoints->InsertNextPoint(points->GetPoint(j));
-
-        float length = m_FiberLengths.at(i);
-        int sampling = std::ceil(length/pointDistance);
-
-        vtkSmartPointer<vtkKochanekSpline> xSpline = vtkSmartPointer<vtkKochanekSpline>::New();
-        vtkSmartPointer<vtkKochanekSpline> ySpline = vtkSmartPointer<vtkKochanekSpline>::New();
-        vtkSmartPointer<vtkKochanekSpline> zSpline = vtkSmartPointer<vtkKochanekSpline>::New();
-        xSpline->SetDefaultBias(bias); xSpline->SetDefaultTension(tension); xSpline->SetDefaultContinuity(continuity);
-        ySpline->SetDefaultBias(bias); ySpline->SetDefaultTension(tension); ySpline->SetDefaultContinuity(continuity);
-        zSpline->SetDefaultBias(bias); zSpline->SetDefaultTension(tension); zSpline->SetDefaultContinuity(continuity);
-
-        vtkSmartPointer<vtkParametricSpline> spline = vtkSmartPointer<vtkParametricSpline>::New();
-        spline->SetXSpline(xSpline);
-        spline->SetYSpline(ySpline);
-        spline->SetZSpline(zSpline);
-        spline->SetPoints(newPoints);
-
-        vtkSmartPointer<vtkParametricFunctionSource> functionSource = vtkSmartPointer<vtkParametricFunctionSource>::New();
-        functionSource->SetParametricFunction(spline);
-        functionSource->SetUResolution(sampling);
-        functionSource->SetVResolution(sampling);
-        functionSource->SetWResolution(sampling);
-        functionSource->Update();
-
-        vtkPolyData* outputFunction = functionSource->GetOutput();
-        vtkPoints* tmpSmoothPnts = outputFunction->GetPoints(); //smoothPoints of current fiber
-
-        vtkSmartPointer<vtkPolyLine> smoothLine = vtkSmartPointer<vtkPolyLine>::New();
-        smoothLine->GetPointIds()->SetNumberOfIds(tmpSmoothPnts->GetNumberOfPoints());
-
-        for (int j=0; j<smoothLine->GetNumberOfPoints(); j++)
+#pragma omp for schedule(dynamic, 16)
+        for (long i=0; i<numFibers; i++)
         {
-            smoothLine->GetPointIds()->SetId(j, j+pointHelperCnt);
-            vtkSmoothPoints->InsertNextPoint(tmpSmoothPnts->GetPoint(j));
+            int numPoints = static_cast<int>(fibers.GetNumberOfFiberPoints(i));
+            const float* points = fibers.GetFiberPoints(i);
+            if (numPoints<2)
+            {
+                smoothFibers[i].assign(points, points+3*numPoints);
+                continue;
+            }
+            newPoints->SetNumberOfPoints(numPoints);
+            for (int j=0; j<numPoints; j++)
+                newPoints->SetPoint(j, points[3*j], points[3*j+1], points[3*j+2]);
+            newPoints->Modified();
+            spline->SetPoints(newPoints);
+            spline->Modified();
+
+            float length = m_FiberLengths.at(i);
+            int sampling = std::ceil(length/pointDistance);
+            if (sampling<1)
+                sampling = 1;
+
+            // same sampling as vtkParametricFunctionSource with a resolution of sampling
+            std::vector<float>& smoothPoints = smoothFibers[i];
+            smoothPoints.resize(3*(sampling+1));
+            for (int j=0; j<=sampling; j++)
+            {
+                double u[3] = { static_cast<double>(j)/sampling, 0, 0 };
+                double pt[3];
+                double du[9];
+                spline->Evaluate(u, pt, du);
+                smoothPoints[3*j] = pt[0];
+                smoothPoints[3*j+1] = pt[1];
+                smoothPoints[3*j+2] = pt[2];
+            }
         }
-        vtkSmoothCells->InsertNextCell(smoothLine);
-        pointHelperCnt += tmpSmoothPnts->GetNumberOfPoints();
     }
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkSmoothPoints);
-    m_FiberPolyData->SetLines(vtkSmoothCells);
-    this->SetFiberPolyData(m_FiberPolyData, true);
+    FiberBundleCompactData newFibers(smoothFibers);
+    this->SetFibers(newFibers, true);
     m_FiberSampling = 10/pointDistance;
 }
 
@@ -1831,37 +1712,29 @@ void mitk::FiberBundle::ResampleSpline(float pointDistance)
 
 unsigned long mitk::FiberBundle::GetNumberOfPoints()
 {
-    unsigned long points = 0;
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-    {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        points += cell->GetNumberOfPoints();
-    }
-    return points;
+    return static_cast<unsigned long>(m_Fibers.GetNumberOfPoints());
 }
 
 void mitk::FiberBundle::Compress(float error)
 {
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Compressing fibers";
-    unsigned long numRemovedPoints = 0;
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
+    const FiberBundleCompactData& fibers = m_Fibers;
+    long numFibers = static_cast<long>(fibers.GetNumberOfFibers());
+    std::vector< std::vector<float> > newFibers(numFibers);
+    long numRemovedPoints = 0;
 
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
+#pragma omp parallel for schedule(dynamic, 16) reduction(+:numRemovedPoints)
+    for (long i=0; i<numFibers; i++)
     {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        int numPoints = static_cast<int>(fibers.GetNumberOfFiberPoints(i));
+        const float* points = fibers.GetFiberPoints(i);
+        if (numPoints==0)
+            continue;
 
         // calculate curvatures
         std::vector< int > removedPoints; removedPoints.resize(numPoints, 0);
         removedPoints[0]=-1; removedPoints[numPoints-1]=-1;
 
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-
         bool pointFound = true;
         while (pointFound)
         {
@@ -1873,19 +1746,15 @@ void mitk::FiberBundle::Compress(float error)
             {
                 if (removedPoints[j]==0)
                 {
-                    double cand[3];
-                    points->GetPoint(j, cand);
                     vnl_vector_fixed< double, 3 > candV;
-                    candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
+                    candV[0]=points[3*j]; candV[1]=points[3*j+1]; candV[2]=points[3*j+2];
 
                     int validP = -1;
                     vnl_vector_fixed< double, 3 > pred;
                     for (int k=j-1; k>=0; k--)
                         if (removedPoints[k]<=0)
                         {
-                            double ref[3];
-                            points->GetPoint(k, ref);
-                            pred[0]=ref[0]; pred[1]=ref[1]; pred[2]=ref[2];
+                            pred[0]=points[3*k]; pred[1]=points[3*k+1]; pred[2]=points[3*k+2];
                             validP = k;
                             break;
                         }
@@ -1894,9 +1763,7 @@ void mitk::FiberBundle::Compress(float error)
                     for (int k=j+1; k<numPoints; k++)
                         if (removedPoints[k]<=0)
                         {
-                            double ref[3];
-                            points->GetPoint(k, ref);
-                            succ[0]=ref[0]; succ[1]=ref[1]; succ[2]=ref[2];
+                            succ[0]=points[3*k]; succ[1]=points[3*k+1]; succ[2]=points[3*k+2];
                             validS = k;
                             break;
                         }
@@ -1926,27 +1793,23 @@ void mitk::FiberBundle::Compress(float error)
             }
         }
 
+        std::vector<float>& newPoints = newFibers[i];
         for (int j=0; j<numPoints; j++)
         {
             if (removedPoints[j]<=0)
             {
-                double cand[3];
-                points->GetPoint(j, cand);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(cand);
-                container->GetPointIds()->InsertNextId(id);
+                newPoints.push_back(points[3*j]);
+                newPoints.push_back(points[3*j+1]);
+                newPoints.push_back(points[3*j+2]);
             }
         }
-
-        vtkNewCells->InsertNextCell(container);
     }
 
-    if (vtkNewCells->GetNumberOfCells()>0)
+    if (numFibers>0)
     {
         MITK_INFO << "Removed points: " << numRemovedPoints;
-        m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-        m_FiberPolyData->SetPoints(vtkNewPoints);
-        m_FiberPolyData->SetLines(vtkNewCells);
-        this->SetFiberPolyData(m_FiberPolyData, true);
+        FiberBundleCompactData compressedFibers(newFibers);
+        this->SetFibers(compressedFibers, true);
     }
 }
 
@@ -1968,13 +1831,11 @@ bool mitk::FiberBundle::Equals(mitk::FiberBundle* fib, double eps)
 
     for (int i=0; i<m_NumFibers; i++)
     {
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        int numPoints = static_cast<int>(m_Fibers.GetNumberOfFiberPoints(i));
+        const float* points = m_Fibers.GetFiberPoints(i);
 
-        vtkCell* cell2 = fib->GetFiberPolyData()->GetCell(i);
-        int numPoints2 = cell2->GetNumberOfPoints();
-        vtkPoints* points2 = cell2->GetPoints();
+        int numPoints2 = static_cast<int>(fib->m_Fibers.GetNumberOfFiberPoints(i));
+        const float* points2 = fib->m_Fibers.GetFiberPoints(i);
 
         if (numPoints2!=numPoints)
         {
@@ -1985,8 +1846,8 @@ bool mitk::FiberBundle::Equals(mitk::FiberBundle* fib, double eps)
 
         for (int j=0; j<numPoints; j++)
         {
-            double* p1 = points->GetPoint(j);
-            double* p2 = points2->GetPoint(j);
+            const float* p1 = points+3*j;
+            const float* p2 = points2+3*j;
             if (fabs(p1[0]-p2[0])>eps || fabs(p1[1]-p2[1])>eps || fabs(p1[2]-p2[2])>eps)
             {
                 MITK_INFO << "Unequal points in fiber " << i << " at position " << j << "!";
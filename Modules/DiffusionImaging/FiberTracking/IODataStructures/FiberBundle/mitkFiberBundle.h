@@ -26,6 +26,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkPlanarFigure.h>
 #include <mitkPixelTypeTraits.h>
 #include <mitkPlanarFigureComposite.h>
+#include "mitkFiberBundleSpatialIndex.h"
+#include "mitkFiberBundleCompactData.h"
 
 
 //includes storing fiberdata
@@ -60,6 +62,7 @@ public:
     itkFactorylessNewMacro(Self)
     itkCloneMacro(Self)
     mitkNewMacro1Param(Self, vtkSmartPointer<vtkPolyData>) // custom constructor
+    mitkNewMacro1Param(Self, FiberBundleCompactData&) // takes over the fibers, the argument is left empty
 
     // colorcoding related methods
     void ColorFibersByCurvature(bool minMaxNorm=true);
@@ -103,6 +106,7 @@ public:
     FiberBundle::Pointer           RemoveFibersOutside(ItkUcharImgType* mask, bool invert=false);
 
     vtkSmartPointer<vtkPolyData>    GeneratePolyDataByIds( std::vector<long> ); // TODO: make protected
+    vtkSmartPointer<vtkPolyData>    GeneratePolyDataInSlab(const double normal[3], double offset, double halfThickness);
     void                            GenerateFiberIds(); // TODO: make protected
 
     // get/set data
@@ -112,7 +116,14 @@ public:
     void SetFiberWeight(unsigned int fiber, float weight);
     void SetFiberWeights(vtkSmartPointer<vtkFloatArray> weights);
     void SetFiberPolyData(vtkSmartPointer<vtkPolyData>, bool updateGeometry = true);
+    /**
+     * \brief Polydata view of the fibers. Generated on first use and kept until the fibers are modified.
+     *
+     * The points share their memory with the fibers. Use SetFiberPolyData() to apply other changes.
+     */
     vtkSmartPointer<vtkPolyData> GetFiberPolyData() const;
+    /** \brief Spatial index of the fiber segments. Built on first use and rebuilt after the fibers were modified. */
+    const FiberBundleSpatialIndex& GetSpatialIndex();
     itkGetMacro( NumFibers, int)
     //itkGetMacro( FiberSampling, int)
     int GetNumFibers() const {return m_NumFibers;}
@@ -141,6 +152,7 @@ public:
 protected:
 
     FiberBundle( vtkPolyData* fiberPolyData = nullptr );
+    FiberBundle( FiberBundleCompactData& fibers );
     virtual ~FiberBundle();
 
     itk::Point<float, 3> GetItkPoint(double point[3]);
@@ -150,8 +162,20 @@ protected:
 
 private:
 
+    // replaces the fibers, the argument is left empty
+    void SetFibers(FiberBundleCompactData& fibers, bool updateGeometry = true);
+
+    // recolors the fibers and updates the geometry after m_Fibers changed
+    void FibersModified(bool updateGeometry = true);
+
+    // drops the polydata and everything built from it, call before modifying m_Fibers
+    void InvalidateFiberPolyData();
+
     // actual fiber container
-    vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
+    FiberBundleCompactData        m_Fibers;
+
+    // generated from m_Fibers on demand, see GetFiberPolyData()
+    mutable vtkSmartPointer<vtkPolyData>  m_FiberPolyData;
 
     // contains fiber ids
     vtkSmartPointer<vtkDataSet>   m_FiberIdDataSet;
@@ -170,6 +194,8 @@ private:
     itk::TimeStamp m_UpdateTime2D;
     itk::TimeStamp m_UpdateTime3D;
     mitk::BaseGeometry::Pointer m_ReferenceGeometry;
+    FiberBundleSpatialIndex m_SpatialIndex;
+    unsigned long m_SpatialIndexMTime;
 };
 
 } // namespace mitk
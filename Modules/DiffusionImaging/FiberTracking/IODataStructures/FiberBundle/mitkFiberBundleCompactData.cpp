@@ -0,0 +1,229 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberBundleCompactData.h"
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+
+mitk::FiberBundleCompactData::FiberBundleCompactData()
+    : m_FiberOffsets(1, 0)
+{
+    this->AllocatePoints(0);
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(vtkPolyData* fiberPolyData)
+    : m_FiberOffsets(1, 0)
+{
+    this->AllocatePoints(0);
+    if (fiberPolyData==nullptr || fiberPolyData->GetPoints()==nullptr)
+        return;
+
+    std::vector<long> fiberIds(fiberPolyData->GetNumberOfCells());
+    for (std::size_t i=0; i<fiberIds.size(); i++)
+        fiberIds[i] = static_cast<long>(i);
+    FiberBundleCompactData fibers(fiberPolyData, fiberIds);
+    this->Swap(fibers);
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(vtkPolyData* fiberPolyData, const std::vector<long>& fiberIds)
+    : m_FiberOffsets(1, 0)
+{
+    this->AllocatePoints(0);
+    if (fiberPolyData==nullptr || fiberPolyData->GetPoints()==nullptr || fiberIds.empty())
+        return;
+
+    // the first call builds the cell links, afterwards GetCellPoints() may be called concurrently
+    std::vector<std::size_t> numPoints(fiberIds.size());
+    for (std::size_t i=0; i<fiberIds.size(); i++)
+    {
+        vtkIdType n;
+        vtkIdType* ids;
+        fiberPolyData->GetCellPoints(fiberIds[i], n, ids);
+        numPoints[i] = n;
+    }
+    this->Allocate(numPoints);
+
+    vtkPoints* points = fiberPolyData->GetPoints();
+    long numFibers = static_cast<long>(fiberIds.size());
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long i=0; i<numFibers; i++)
+    {
+        vtkIdType n;
+        vtkIdType* ids;
+        fiberPolyData->GetCellPoints(fiberIds[i], n, ids);
+        float* fiberPoints = this->GetFiberPoints(i);
+        for (vtkIdType j=0; j<n; j++)
+        {
+            double p[3];
+            points->GetPoint(ids[j], p);
+            fiberPoints[3*j] = p[0];
+            fiberPoints[3*j+1] = p[1];
+            fiberPoints[3*j+2] = p[2];
+        }
+    }
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(const FiberBundleCompactData& fibers, const std::vector<long>& fiberIds)
+    : m_FiberOffsets(1, 0)
+{
+    std::vector<std::size_t> numPoints(fiberIds.size());
+    for (std::size_t i=0; i<fiberIds.size(); i++)
+        numPoints[i] = fibers.GetNumberOfFiberPoints(fiberIds[i]);
+    this->Allocate(numPoints);
+
+    long numFibers = static_cast<long>(fiberIds.size());
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long i=0; i<numFibers; i++)
+    {
+        const float* points = fibers.GetFiberPoints(fiberIds[i]);
+        std::copy(points, points+3*numPoints[i], this->GetFiberPoints(i));
+    }
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(const std::vector<const FiberBundleCompactData*>& parts)
+    : m_FiberOffsets(1, 0)
+{
+    std::size_t numPoints = 0;
+    std::size_t numFibers = 0;
+    for (std::size_t p=0; p<parts.size(); p++)
+    {
+        numPoints += parts[p]->GetNumberOfPoints();
+        numFibers += parts[p]->GetNumberOfFibers();
+    }
+    this->AllocatePoints(numPoints);
+    m_FiberOffsets.reserve(numFibers+1);
+
+    for (std::size_t p=0; p<parts.size(); p++)
+    {
+        std::size_t pointOffset = this->GetNumberOfPoints();
+        for (std::size_t i=1; i<parts[p]->m_FiberOffsets.size(); i++)
+            m_FiberOffsets.push_back(pointOffset + parts[p]->m_FiberOffsets[i]);
+        std::copy(parts[p]->GetPoints(), parts[p]->GetPoints()+3*parts[p]->GetNumberOfPoints(), this->GetPoints()+3*pointOffset);
+    }
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(std::vector< std::vector<float> >& fibers)
+    : m_FiberOffsets(1, 0)
+{
+    std::vector<std::size_t> numPoints(fibers.size());
+    for (std::size_t i=0; i<fibers.size(); i++)
+        numPoints[i] = fibers[i].size()/3;
+    this->Allocate(numPoints);
+
+    long numFibers = static_cast<long>(fibers.size());
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long i=0; i<numFibers; i++)
+    {
+        std::copy(fibers[i].begin(), fibers[i].end(), this->GetFiberPoints(i));
+        std::vector<float>().swap(fibers[i]);
+    }
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(vtkFloatArray* points, std::vector<std::size_t>& fiberOffsets)
+    : m_Points(points)
+{
+    m_FiberOffsets.swap(fiberOffsets);
+    if (m_FiberOffsets.empty())
+        m_FiberOffsets.push_back(0);
+    if (m_Points==nullptr || m_Points->GetNumberOfComponents()!=3 || static_cast<std::size_t>(m_Points->GetNumberOfTuples())!=m_FiberOffsets.back())
+    {
+        // inconsistent input, keep the result valid
+        m_FiberOffsets.assign(1, 0);
+        this->AllocatePoints(0);
+    }
+}
+
+mitk::FiberBundleCompactData::FiberBundleCompactData(const FiberBundleCompactData& other)
+    : m_FiberOffsets(other.m_FiberOffsets)
+{
+    this->AllocatePoints(other.GetNumberOfPoints());
+    std::copy(other.GetPoints(), other.GetPoints()+3*other.GetNumberOfPoints(), this->GetPoints());
+}
+
+mitk::FiberBundleCompactData& mitk::FiberBundleCompactData::operator=(const FiberBundleCompactData& other)
+{
+    FiberBundleCompactData copy(other);
+    this->Swap(copy);
+    return *this;
+}
+
+void mitk::FiberBundleCompactData::Swap(FiberBundleCompactData& other)
+{
+    std::swap(m_Points, other.m_Points);
+    m_FiberOffsets.swap(other.m_FiberOffsets);
+}
+
+void mitk::FiberBundleCompactData::Allocate(const std::vector<std::size_t>& numPoints)
+{
+    m_FiberOffsets.resize(numPoints.size()+1);
+    m_FiberOffsets[0] = 0;
+    for (std::size_t i=0; i<numPoints.size(); i++)
+        m_FiberOffsets[i+1] = m_FiberOffsets[i] + numPoints[i];
+    this->AllocatePoints(m_FiberOffsets.back());
+}
+
+void mitk::FiberBundleCompactData::AllocatePoints(std::size_t numPoints)
+{
+    m_Points = vtkSmartPointer<vtkFloatArray>::New();
+    m_Points->SetNumberOfComponents(3);
+    m_Points->SetNumberOfTuples(static_cast<vtkIdType>(numPoints));
+}
+
+void mitk::FiberBundleCompactData::MakePointsWritable()
+{
+    // every vtkPoints generated by GeneratePolyData() holds a reference to the array
+    if (m_Points->GetReferenceCount()<=1)
+        return;
+
+    vtkSmartPointer<vtkFloatArray> points = m_Points;
+    this->AllocatePoints(this->GetNumberOfPoints());
+    std::copy(points->GetPointer(0), points->GetPointer(0)+3*this->GetNumberOfPoints(), this->GetPoints());
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberBundleCompactData::GeneratePolyData() const
+{
+    long numFibers = static_cast<long>(this->GetNumberOfFibers());
+    vtkIdType numPoints = static_cast<vtkIdType>(this->GetNumberOfPoints());
+
+    // every fiber is stored as its number of points followed by its point ids
+    vtkSmartPointer<vtkIdTypeArray> cellData = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellData->SetNumberOfValues(numFibers+numPoints);
+    vtkIdType* cells = cellData->GetPointer(0);
+#pragma omp parallel for schedule(dynamic, 256)
+    for (long i=0; i<numFibers; i++)
+    {
+        vtkIdType* cell = cells + i + m_FiberOffsets[i];
+        *cell++ = static_cast<vtkIdType>(this->GetNumberOfFiberPoints(i));
+        for (std::size_t j=m_FiberOffsets[i]; j<m_FiberOffsets[i+1]; j++)
+            *cell++ = static_cast<vtkIdType>(j);
+    }
+
+    // the points refer to the same array, see MakePointsWritable()
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(m_Points);
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(numFibers, cellData);
+
+    vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
+    fiberPolyData->SetPoints(points);
+    fiberPolyData->SetLines(lines);
+    return fiberPolyData;
+}
@@ -0,0 +1,112 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberBundleCompactData_H
+#define _MITK_FiberBundleCompactData_H
+
+#include <MitkFiberTrackingExports.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkFloatArray.h>
+
+#include <vector>
+
+
+namespace mitk {
+
+/**
+   * \brief Columnar storage of the fibers of a fiber bundle: the coordinates of all points as one float array
+   * and the offset of the first point of every fiber.
+   *
+   * Compared to a vtkPolyData there are no point ids, no per-cell objects and no double precision
+   * coordinates, so converting from and to vtkPolyData and processing the fibers touches a few large
+   * arrays only. The fibers are independent of each other and can be processed in parallel.
+   *
+   * Polydata generated by GeneratePolyData() shares the point array instead of copying it.
+   * Call MakePointsWritable() before modifying the points of fibers that may have been handed out.
+   */
+class MITKFIBERTRACKING_EXPORT FiberBundleCompactData
+{
+public:
+
+    FiberBundleCompactData();
+
+    /** \brief Copies all lines of the polydata. */
+    explicit FiberBundleCompactData(vtkPolyData* fiberPolyData);
+
+    /** \brief Copies the lines with the given ids, in the given order. */
+    FiberBundleCompactData(vtkPolyData* fiberPolyData, const std::vector<long>& fiberIds);
+
+    /** \brief Copies the fibers with the given ids, in the given order. */
+    FiberBundleCompactData(const FiberBundleCompactData& fibers, const std::vector<long>& fiberIds);
+
+    /** \brief Concatenates the fibers of several fiber sets, in the given order. */
+    explicit FiberBundleCompactData(const std::vector<const FiberBundleCompactData*>& parts);
+
+    /** \brief Takes the fibers, each given as x, y and z of all points. The vectors are emptied. */
+    explicit FiberBundleCompactData(std::vector< std::vector<float> >& fibers);
+
+    /**
+     * \brief Takes the points (x, y and z of all points of all fibers) without copying them and the offset of
+     * the first point of every fiber followed by the total number of points. The offsets are emptied.
+     */
+    FiberBundleCompactData(vtkFloatArray* points, std::vector<std::size_t>& fiberOffsets);
+
+    /** \brief Copies the points, the copy shares no memory with polydata generated from @a other. */
+    FiberBundleCompactData(const FiberBundleCompactData& other);
+    FiberBundleCompactData& operator=(const FiberBundleCompactData& other);
+
+    /** \brief Exchanges the fibers without copying them. */
+    void Swap(FiberBundleCompactData& other);
+
+    std::size_t GetNumberOfFibers() const { return m_FiberOffsets.size()-1; }
+    std::size_t GetNumberOfPoints() const { return m_FiberOffsets.back(); }
+    std::size_t GetNumberOfFiberPoints(std::size_t fiber) const { return m_FiberOffsets[fiber+1]-m_FiberOffsets[fiber]; }
+
+    /** \brief Index of the first point of the fiber, i.e. its point id in the generated polydata. */
+    std::size_t GetFiberOffset(std::size_t fiber) const { return m_FiberOffsets[fiber]; }
+
+    /** \brief x, y and z of all points of the fiber. */
+    const float* GetFiberPoints(std::size_t fiber) const { return this->GetPoints()+3*m_FiberOffsets[fiber]; }
+    float* GetFiberPoints(std::size_t fiber) { return this->GetPoints()+3*m_FiberOffsets[fiber]; }
+
+    /** \brief x, y and z of all points of all fibers. */
+    const float* GetPoints() const { return m_Points->GetPointer(0); }
+    float* GetPoints() { return m_Points->GetPointer(0); }
+
+    /** \brief Polydata with single precision points and one polyline per fiber. The points are not copied. */
+    vtkSmartPointer<vtkPolyData> GeneratePolyData() const;
+
+    /** \brief Gives the points their own memory if they are still shared with generated polydata. */
+    void MakePointsWritable();
+
+private:
+
+    /** \brief Sets the offsets from the number of points per fiber and allocates the points. */
+    void Allocate(const std::vector<std::size_t>& numPoints);
+
+    /** \brief Allocates a new point array, the old one stays valid for the polydata sharing it. */
+    void AllocatePoints(std::size_t numPoints);
+
+    vtkSmartPointer<vtkFloatArray> m_Points;            ///< three components per point
+    std::vector< std::size_t >  m_FiberOffsets;     ///< points of fiber i are m_FiberOffsets[i] to m_FiberOffsets[i+1]-1
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberBundleCompactData_H */
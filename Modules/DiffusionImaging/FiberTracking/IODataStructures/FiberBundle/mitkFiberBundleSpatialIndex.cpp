@@ -0,0 +1,295 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberBundleSpatialIndex.h"
+
+#include <vtkCellArray.h>
+#include <vtkMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+// upper limit of the grid resolution per axis, keeps the cell offsets small for degenerate bundles
+static const int MaxGridSize = 256;
+
+mitk::FiberBundleSpatialIndex::FiberBundleSpatialIndex()
+    : m_MaxSegmentLength(0)
+{
+    this->Clear();
+}
+
+void mitk::FiberBundleSpatialIndex::Clear()
+{
+    m_PolyData = nullptr;
+    m_FiberFirstSegment.clear();
+    m_FiberFirstPoint.clear();
+    m_PointIds.clear();
+    m_SegmentFibers.clear();
+    m_CellOffsets.clear();
+    m_CellEntries.clear();
+    m_MaxSegmentLength = 0;
+    for (int i=0; i<3; i++)
+    {
+        m_Origin[i] = 0;
+        m_CellSize[i] = 1;
+        m_Size[i] = 1;
+    }
+}
+
+void mitk::FiberBundleSpatialIndex::Build(vtkPolyData* fiberPolyData)
+{
+    this->Clear();
+    if (fiberPolyData==nullptr || fiberPolyData->GetLines()==nullptr)
+        return;
+    m_PolyData = fiberPolyData;
+
+    // copy the point ids of all fibers and enumerate their segments
+    vtkCellArray* lines = fiberPolyData->GetLines();
+    vtkIdType numFibers = lines->GetNumberOfCells();
+    m_FiberFirstSegment.reserve(numFibers+1);
+    m_FiberFirstPoint.reserve(numFibers+1);
+    m_PointIds.reserve(lines->GetNumberOfConnectivityEntries()-numFibers);
+
+    SegmentId numSegments = 0;
+    vtkIdType numPoints = 0;
+    vtkIdType* pointIds = nullptr;
+    lines->InitTraversal();
+    for (vtkIdType i=0; i<numFibers; i++)
+    {
+        lines->GetNextCell(numPoints, pointIds);
+        m_FiberFirstSegment.push_back(numSegments);
+        m_FiberFirstPoint.push_back(m_PointIds.size());
+        m_PointIds.insert(m_PointIds.end(), pointIds, pointIds+numPoints);
+        if (numPoints>1)
+        {
+            numSegments += numPoints-1;
+            m_SegmentFibers.insert(m_SegmentFibers.end(), numPoints-1, i);
+        }
+    }
+    m_FiberFirstSegment.push_back(numSegments);
+    m_FiberFirstPoint.push_back(m_PointIds.size());
+
+    if (numSegments==0)
+        return;
+
+    double totalLength = 0;
+    for (SegmentId s=0; s<numSegments; s++)
+    {
+        double p1[3], p2[3];
+        this->GetSegmentPoints(s, p1, p2);
+        double length = std::sqrt(vtkMath::Distance2BetweenPoints(p1, p2));
+        totalLength += length;
+        m_MaxSegmentLength = std::max(m_MaxSegmentLength, length);
+    }
+    double meanSegmentLength = totalLength/numSegments;
+
+    // about four segments per cell, but cells much smaller than the segments would only replicate them
+    double bounds[6];
+    fiberPolyData->GetBounds(bounds);
+    double minExtent = meanSegmentLength>0 ? meanSegmentLength : 1.0;
+    double volume = 1;
+    for (int i=0; i<3; i++)
+        volume *= std::max(bounds[2*i+1]-bounds[2*i], minExtent);
+    double cellSize = std::max(meanSegmentLength, std::cbrt(volume/std::max(1.0, numSegments/4.0)));
+    if (cellSize<=0)
+        cellSize = 1.0;
+
+    for (int i=0; i<3; i++)
+    {
+        double extent = bounds[2*i+1]-bounds[2*i];
+        m_Origin[i] = bounds[2*i];
+        m_Size[i] = std::min(MaxGridSize, std::max(1, static_cast<int>(std::ceil(extent/cellSize))));
+        m_CellSize[i] = extent>0 ? extent/m_Size[i] : cellSize;
+    }
+
+    // counting sort of the segments into the cells
+    std::size_t numCells = static_cast<std::size_t>(m_Size[0])*m_Size[1]*m_Size[2];
+    m_CellOffsets.assign(numCells+1, 0);
+    for (SegmentId s=0; s<numSegments; s++)
+    {
+        double segmentBounds[6];
+        this->GetSegmentBounds(s, segmentBounds);
+        int cellMin[3], cellMax[3];
+        for (int i=0; i<3; i++)
+        {
+            cellMin[i] = this->GetCellCoordinate(segmentBounds[2*i], i);
+            cellMax[i] = this->GetCellCoordinate(segmentBounds[2*i+1], i);
+        }
+        for (int z=cellMin[2]; z<=cellMax[2]; z++)
+            for (int y=cellMin[1]; y<=cellMax[1]; y++)
+                for (int x=cellMin[0]; x<=cellMax[0]; x++)
+                    m_CellOffsets[x + m_Size[0]*(y + static_cast<std::size_t>(m_Size[1])*z) + 1]++;
+    }
+    for (std::size_t c=0; c<numCells; c++)
+        m_CellOffsets[c+1] += m_CellOffsets[c];
+
+    m_CellEntries.resize(m_CellOffsets.back());
+    std::vector< std::size_t > fill(m_CellOffsets.begin(), m_CellOffsets.end()-1);
+    for (SegmentId s=0; s<numSegments; s++)
+    {
+        double segmentBounds[6];
+        this->GetSegmentBounds(s, segmentBounds);
+        int cellMin[3], cellMax[3];
+        for (int i=0; i<3; i++)
+        {
+            cellMin[i] = this->GetCellCoordinate(segmentBounds[2*i], i);
+            cellMax[i] = this->GetCellCoordinate(segmentBounds[2*i+1], i);
+        }
+        for (int z=cellMin[2]; z<=cellMax[2]; z++)
+            for (int y=cellMin[1]; y<=cellMax[1]; y++)
+                for (int x=cellMin[0]; x<=cellMax[0]; x++)
+                    m_CellEntries[fill[x + m_Size[0]*(y + static_cast<std::size_t>(m_Size[1])*z)]++] = s;
+    }
+}
+
+int mitk::FiberBundleSpatialIndex::GetCellCoordinate(double x, int axis) const
+{
+    double c = std::floor((x-m_Origin[axis])/m_CellSize[axis]);
+    if (c<0)
+        return 0;
+    if (c>=m_Size[axis])
+        return m_Size[axis]-1;
+    return static_cast<int>(c);
+}
+
+void mitk::FiberBundleSpatialIndex::GetSegmentPointIds(SegmentId segment, vtkIdType& start, vtkIdType& end) const
+{
+    unsigned int fiber = m_SegmentFibers[segment];
+    vtkIdType position = m_FiberFirstPoint[fiber] + (segment-m_FiberFirstSegment[fiber]);
+    start = m_PointIds[position];
+    end = m_PointIds[position+1];
+}
+
+void mitk::FiberBundleSpatialIndex::GetSegmentPoints(SegmentId segment, double start[3], double end[3]) const
+{
+    vtkIdType startId, endId;
+    this->GetSegmentPointIds(segment, startId, endId);
+    m_PolyData->GetPoint(startId, start);
+    m_PolyData->GetPoint(endId, end);
+}
+
+void mitk::FiberBundleSpatialIndex::GetSegmentBounds(SegmentId segment, double bounds[6]) const
+{
+    double p1[3], p2[3];
+    this->GetSegmentPoints(segment, p1, p2);
+    for (int i=0; i<3; i++)
+    {
+        bounds[2*i] = std::min(p1[i], p2[i]);
+        bounds[2*i+1] = std::max(p1[i], p2[i]);
+    }
+}
+
+template< class CellTest, class SegmentTest >
+void mitk::FiberBundleSpatialIndex::CollectSegments(const int cellMin[3], const int cellMax[3], CellTest cellTest, SegmentTest segmentTest, std::vector<SegmentId>& segments) const
+{
+    std::vector< std::vector<SegmentId> > threadSegments(omp_get_max_threads());
+
+#pragma omp parallel for schedule(dynamic)
+    for (int z=cellMin[2]; z<=cellMax[2]; z++)
+    {
+        std::vector<SegmentId>& localSegments = threadSegments[omp_get_thread_num()];
+        for (int y=cellMin[1]; y<=cellMax[1]; y++)
+            for (int x=cellMin[0]; x<=cellMax[0]; x++)
+            {
+                if (!cellTest(x, y, z))
+                    continue;
+                std::size_t c = x + m_Size[0]*(y + static_cast<std::size_t>(m_Size[1])*z);
+                for (std::size_t e=m_CellOffsets[c]; e<m_CellOffsets[c+1]; e++)
+                    if (segmentTest(m_CellEntries[e]))
+                        localSegments.push_back(m_CellEntries[e]);
+            }
+    }
+
+    // segments overlapping several cells were found several times
+    std::size_t first = segments.size();
+    for (std::size_t t=0; t<threadSegments.size(); t++)
+        segments.insert(segments.end(), threadSegments[t].begin(), threadSegments[t].end());
+    std::sort(segments.begin()+first, segments.end());
+    segments.erase(std::unique(segments.begin()+first, segments.end()), segments.end());
+}
+
+void mitk::FiberBundleSpatialIndex::FindSegments(const double bounds[6], std::vector<SegmentId>& segments) const
+{
+    if (m_CellEntries.empty())
+        return;
+
+    int cellMin[3], cellMax[3];
+    for (int i=0; i<3; i++)
+    {
+        if (bounds[2*i+1]<m_Origin[i] || bounds[2*i]>m_Origin[i]+m_Size[i]*m_CellSize[i])
+            return;
+        cellMin[i] = this->GetCellCoordinate(bounds[2*i], i);
+        cellMax[i] = this->GetCellCoordinate(bounds[2*i+1], i);
+    }
+
+    this->CollectSegments(cellMin, cellMax,
+                          [](int, int, int) { return true; },
+                          [this, bounds](SegmentId s)
+    {
+        double segmentBounds[6];
+        this->GetSegmentBounds(s, segmentBounds);
+        for (int i=0; i<3; i++)
+            if (segmentBounds[2*i+1]<bounds[2*i] || segmentBounds[2*i]>bounds[2*i+1])
+                return false;
+        return true;
+    }, segments);
+}
+
+void mitk::FiberBundleSpatialIndex::FindSegmentsInSlab(const double normal[3], double offset, double halfThickness, std::vector<SegmentId>& segments) const
+{
+    if (m_CellEntries.empty())
+        return;
+
+    int cellMin[3] = {0, 0, 0};
+    int cellMax[3] = {m_Size[0]-1, m_Size[1]-1, m_Size[2]-1};
+    double cellRadius = 0;
+    for (int i=0; i<3; i++)
+        cellRadius += 0.5*std::fabs(normal[i])*m_CellSize[i];
+
+    this->CollectSegments(cellMin, cellMax,
+                          [this, normal, offset, halfThickness, cellRadius](int x, int y, int z)
+    {
+        double distance = normal[0]*(m_Origin[0]+(x+0.5)*m_CellSize[0])
+                        + normal[1]*(m_Origin[1]+(y+0.5)*m_CellSize[1])
+                        + normal[2]*(m_Origin[2]+(z+0.5)*m_CellSize[2]) - offset;
+        return std::fabs(distance) <= halfThickness+cellRadius;
+    },
+    [this, normal, offset, halfThickness](SegmentId s)
+    {
+        double p1[3], p2[3];
+        this->GetSegmentPoints(s, p1, p2);
+        double d1 = vtkMath::Dot(normal, p1) - offset;
+        double d2 = vtkMath::Dot(normal, p2) - offset;
+        return std::min(d1, d2)<=halfThickness && std::max(d1, d2)>=-halfThickness;
+    }, segments);
+}
+
+std::vector<long> mitk::FiberBundleSpatialIndex::FindFibers(const double bounds[6]) const
+{
+    std::vector<SegmentId> segments;
+    this->FindSegments(bounds, segments);
+
+    // segments are sorted by fiber
+    std::vector<long> fibers;
+    for (std::size_t i=0; i<segments.size(); i++)
+    {
+        long fiber = m_SegmentFibers[segments[i]];
+        if (fibers.empty() || fibers.back()!=fiber)
+            fibers.push_back(fiber);
+    }
+    return fibers;
+}
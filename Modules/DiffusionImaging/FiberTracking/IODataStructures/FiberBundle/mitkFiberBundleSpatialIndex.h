@@ -0,0 +1,111 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberBundleSpatialIndex_H
+#define _MITK_FiberBundleSpatialIndex_H
+
+#include <MitkFiberTrackingExports.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+#include <vector>
+
+
+namespace mitk {
+
+/**
+   * \brief Uniform grid over the line segments of the fibers of a fiber bundle.
+   *
+   * Every segment between two consecutive fiber points is registered in all grid cells that are
+   * overlapped by its bounding box. The cells are stored compressed (one offset per cell into a single
+   * array of segment ids), so the index needs a handful of allocations, independent of the number of fibers.
+   *
+   * Segment ids are assigned fiber by fiber along the fibers, so the results of all queries, which are
+   * sorted by segment id, are also sorted by fiber id. The queries only compare bounding boxes,
+   * exact intersection tests are left to the caller. Queries are const and may run concurrently.
+   *
+   * The index refers to the point ids of the polydata it was built from and has to be rebuilt
+   * if the fibers are modified.
+   */
+class MITKFIBERTRACKING_EXPORT FiberBundleSpatialIndex
+{
+public:
+
+    typedef unsigned int SegmentId;
+
+    FiberBundleSpatialIndex();
+
+    /** \brief Builds the index for all lines of the polydata. */
+    void Build(vtkPolyData* fiberPolyData);
+    void Clear();
+
+    /** \brief Polydata the index was built from, nullptr if the index is empty. */
+    vtkPolyData* GetPolyData() const { return m_PolyData; }
+    long GetNumberOfFibers() const { return m_FiberFirstSegment.empty() ? 0 : static_cast<long>(m_FiberFirstSegment.size())-1; }
+    unsigned int GetNumberOfSegments() const { return static_cast<unsigned int>(m_SegmentFibers.size()); }
+    double GetMaxSegmentLength() const { return m_MaxSegmentLength; }
+
+    /** \brief Point ids of the fiber in the polydata. */
+    vtkIdType GetNumberOfFiberPoints(long fiber) const { return m_FiberFirstPoint[fiber+1]-m_FiberFirstPoint[fiber]; }
+    const vtkIdType* GetFiberPointIds(long fiber) const { return m_PointIds.data()+m_FiberFirstPoint[fiber]; }
+
+    /** \brief Fiber (cell id of the polydata) the segment belongs to. */
+    long GetFiber(SegmentId segment) const { return m_SegmentFibers[segment]; }
+
+    /** \brief Point ids of the start and end point of the segment in the polydata. */
+    void GetSegmentPointIds(SegmentId segment, vtkIdType& start, vtkIdType& end) const;
+    void GetSegmentPoints(SegmentId segment, double start[3], double end[3]) const;
+
+    /** \brief Segments whose bounding box overlaps the box {xmin,xmax,ymin,ymax,zmin,zmax}. */
+    void FindSegments(const double bounds[6], std::vector<SegmentId>& segments) const;
+
+    /** \brief Segments touching the slab of all points x with |normal*x - offset| <= halfThickness. */
+    void FindSegmentsInSlab(const double normal[3], double offset, double halfThickness, std::vector<SegmentId>& segments) const;
+
+    /** \brief Sorted ids of all fibers with at least one segment whose bounding box overlaps the box. */
+    std::vector<long> FindFibers(const double bounds[6]) const;
+
+private:
+
+    int GetCellCoordinate(double x, int axis) const;
+    void GetSegmentBounds(SegmentId segment, double bounds[6]) const;
+
+    /** \brief Collects the segments of all cells in the range accepted by cellTest that pass segmentTest. */
+    template< class CellTest, class SegmentTest >
+    void CollectSegments(const int cellMin[3], const int cellMax[3], CellTest cellTest, SegmentTest segmentTest, std::vector<SegmentId>& segments) const;
+
+    vtkSmartPointer<vtkPolyData>    m_PolyData;
+
+    // per fiber: first segment and position of its first point id in m_PointIds
+    std::vector< SegmentId >        m_FiberFirstSegment;
+    std::vector< vtkIdType >        m_FiberFirstPoint;
+    std::vector< vtkIdType >        m_PointIds;
+    std::vector< unsigned int >     m_SegmentFibers;
+    double                          m_MaxSegmentLength;
+
+    // grid
+    double                          m_Origin[3];
+    double                          m_CellSize[3];
+    int                             m_Size[3];
+    std::vector< std::size_t >      m_CellOffsets;  ///< segments of cell c are m_CellEntries[m_CellOffsets[c]] to m_CellEntries[m_CellOffsets[c+1]-1]
+    std::vector< SegmentId >        m_CellEntries;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberBundleSpatialIndex_H */
@@ -1,5 +1,196 @@
 #include <mitkTrackvis.h>
-#include <vtkTransformPolyDataFilter.h>
+#include <vtkFloatArray.h>
+#include <itksys/SystemTools.hxx>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+const std::size_t TrackVisChunkSize = 4*1024*1024;
+const std::size_t TrackVisMaxQueuedChunks = 4;
+
+// Read a file in chunks on a background thread while the caller parses the previous chunks.
+// ------------------------------------------------------------------------------------------
+class TrackVisChunkReader
+{
+public:
+
+    TrackVisChunkReader(FILE* file) : m_File(file), m_Done(false), m_Stop(false), m_Position(0)
+    {
+        m_Thread = std::thread(&TrackVisChunkReader::ReadChunks, this);
+    }
+
+    ~TrackVisChunkReader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Condition.notify_all();
+        m_Thread.join();
+    }
+
+    // copy the next n bytes to dst (dst==nullptr: skip them), false at the end of the file
+    bool Read(void* dst, std::size_t n)
+    {
+        char* out = static_cast<char*>(dst);
+        while (n>0)
+        {
+            if (m_Position==m_Chunk.size() && !this->NextChunk())
+                return false;
+
+            std::size_t count = std::min(n, m_Chunk.size()-m_Position);
+            if (out!=nullptr)
+            {
+                memcpy(out, &m_Chunk[m_Position], count);
+                out += count;
+            }
+            m_Position += count;
+            n -= count;
+        }
+        return true;
+    }
+
+private:
+
+    bool NextChunk()
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this]{ return !m_Chunks.empty() || m_Done; });
+        if (m_Chunks.empty())
+            return false;
+        m_Chunk.swap(m_Chunks.front());
+        m_Chunks.pop_front();
+        m_Position = 0;
+        lock.unlock();
+        m_Condition.notify_all();
+        return true;
+    }
+
+    void ReadChunks()
+    {
+        while (true)
+        {
+            std::vector<char> chunk(TrackVisChunkSize);
+            chunk.resize(fread(chunk.data(), 1, TrackVisChunkSize, m_File));
+
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]{ return m_Chunks.size()<TrackVisMaxQueuedChunks || m_Stop; });
+            if (chunk.empty() || m_Stop)
+                break;
+            m_Chunks.push_back(std::move(chunk));
+            lock.unlock();
+            m_Condition.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Done = true;
+        }
+        m_Condition.notify_all();
+    }
+
+    FILE*                           m_File;
+    std::thread                     m_Thread;
+    std::mutex                      m_Mutex;
+    std::condition_variable         m_Condition;
+    std::deque< std::vector<char> > m_Chunks;
+    bool                            m_Done;
+    bool                            m_Stop;
+    std::vector<char>               m_Chunk;
+    std::size_t                     m_Position;
+};
+
+// Collect the data in chunks and write them to a file on a background thread.
+// ---------------------------------------------------------------------------
+class TrackVisChunkWriter
+{
+public:
+
+    TrackVisChunkWriter(FILE* file) : m_File(file), m_Stop(false), m_Failed(false)
+    {
+        m_Chunk.reserve(TrackVisChunkSize);
+        m_Thread = std::thread(&TrackVisChunkWriter::WriteChunks, this);
+    }
+
+    ~TrackVisChunkWriter() { this->Close(); }
+
+    void Write(const void* src, std::size_t n)
+    {
+        const char* in = static_cast<const char*>(src);
+        m_Chunk.insert(m_Chunk.end(), in, in+n);
+        if (m_Chunk.size()>=TrackVisChunkSize)
+            this->Flush();
+    }
+
+    // write the remaining data and wait for the background thread, false if writing failed
+    bool Close()
+    {
+        if (m_Thread.joinable())
+        {
+            this->Flush();
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stop = true;
+            }
+            m_Condition.notify_all();
+            m_Thread.join();
+        }
+        return !m_Failed;
+    }
+
+private:
+
+    void Flush()
+    {
+        if (m_Chunk.empty())
+            return;
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this]{ return m_Chunks.size()<TrackVisMaxQueuedChunks; });
+        m_Chunks.push_back(std::move(m_Chunk));
+        lock.unlock();
+        m_Condition.notify_all();
+
+        m_Chunk = std::vector<char>();
+        m_Chunk.reserve(TrackVisChunkSize);
+    }
+
+    void WriteChunks()
+    {
+        while (true)
+        {
+            std::vector<char> chunk;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this]{ return !m_Chunks.empty() || m_Stop; });
+                if (m_Chunks.empty())
+                    break;
+                chunk.swap(m_Chunks.front());
+                m_Chunks.pop_front();
+            }
+            m_Condition.notify_all();
+
+            if (fwrite(chunk.data(), 1, chunk.size(), m_File) != chunk.size())
+                m_Failed = true;
+        }
+    }
+
+    FILE*                           m_File;
+    std::thread                     m_Thread;
+    std::mutex                      m_Mutex;
+    std::condition_variable         m_Condition;
+    std::deque< std::vector<char> > m_Chunks;
+    bool                            m_Stop;
+    bool                            m_Failed;     ///< only accessed by the background thread until it is joined
+    std::vector<char>               m_Chunk;
+};
+
+}
 
 TrackVisFiberReader::TrackVisFiberReader()  { m_Filename = ""; m_FilePointer = nullptr; }
 
@@ -84,102 +275,143 @@ short TrackVisFiberReader::open( string filename )
 
 
 
-// Append a fiber to the file
-// --------------------------
+// Append the fibers to the file
+// -----------------------------
 short TrackVisFiberReader::append(const mitk::FiberBundle *fib)
 {
     vtkPolyData* poly = fib->GetFiberPolyData();
+    vtkPoints* points = poly->GetPoints();
+    TrackVisChunkWriter chunks(m_FilePointer);
+    std::vector< float > tmp;
     for (int i=0; i<fib->GetNumFibers(); i++)
     {
-        vtkCell* cell = poly->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        vtkIdType numPoints;
+        vtkIdType* ids;
+        poly->GetCellPoints(i, numPoints, ids);
 
-        unsigned int     numSaved, pos = 0;
-        //float* tmp = new float[3*maxSteps];
-        std::vector< float > tmp;
-        tmp.reserve(3*numPoints);
-
-        numSaved = numPoints;
-        for(unsigned int i=0; i<numSaved ;i++)
+        tmp.resize(3*numPoints);
+        for (vtkIdType j=0; j<numPoints; j++)
         {
-            double* p = points->GetPoint(i);
-
-            tmp[pos++] = p[0];
-            tmp[pos++] = p[1];
-            tmp[pos++] = p[2];
+            double p[3];
+            points->GetPoint(ids[j], p);
+            tmp[3*j] = p[0];
+            tmp[3*j+1] = p[1];
+            tmp[3*j+2] = p[2];
         }
 
         // write the coordinates to the file
-        if ( fwrite((char*)&numSaved, 1, 4, m_FilePointer) != 4 )
-        {
-            printf( "[ERROR] Problems saving the fiber!\n" );
-            return 1;
-        }
-        if ( fwrite((char*)&(tmp.front()), 1, 4*pos, m_FilePointer) != 4*pos )
-        {
-            printf( "[ERROR] Problems saving the fiber!\n" );
-            return 1;
-        }
+        unsigned int numSaved = numPoints;
+        chunks.Write(&numSaved, 4);
+        chunks.Write(tmp.data(), 4*tmp.size());
     }
 
+    if (!chunks.Close())
+    {
+        printf( "[ERROR] Problems saving the fiber!\n" );
+        return 1;
+    }
     return 0;
 }
 
-//// Read one fiber from the file
-//// ----------------------------
-short TrackVisFiberReader::read( mitk::FiberBundle* fib )
+// Read the fibers from the file. Only every k-th fiber is kept, and only fibers between
+// the given lengths in mm (maxFiberLength<=0: no upper limit). The file is read in chunks
+// on a background thread while the fibers are parsed directly into the compact fiber
+// representation of the returned bundle. Returns nullptr if the file is invalid.
+// ---------------------------------------------------------------------------------------
+mitk::FiberBundle::Pointer TrackVisFiberReader::read( int everyKthFiber, float minFiberLength, float maxFiberLength )
 {
-    int numPoints;
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    if (everyKthFiber<1)
+        everyKthFiber = 1;
 
-    while (fread((char*)&numPoints, 1, 4, m_FilePointer)==4)
-    {
-        if ( numPoints <= 0 )
-        {
-            printf( "[ERROR] Trying to read a fiber with %d points!\n", numPoints );
-            return -1;
-        }
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+    MITK_INFO << "Coordinate convention: " << m_Header.voxel_order;
 
-        float tmp[3];
-        for(int i=0; i<numPoints; i++)
+    // the coordinates are converted to LPS
+    float flip[3];
+    flip[0] = m_Header.voxel_order[0]=='R' ? -1 : 1;
+    flip[1] = m_Header.voxel_order[1]=='A' ? -1 : 1;
+    flip[2] = m_Header.voxel_order[2]=='I' ? -1 : 1;
+
+    // every point may carry scalars, every fiber may carry properties
+    int stride = 3 + std::max<int>(m_Header.n_scalars, 0);
+    std::size_t propertiesSize = 4*std::max<int>(m_Header.n_properties, 0);
+
+    // reserve for the expected number of points to avoid growing the arrays
+    unsigned long long fileSize = itksys::SystemTools::FileLength(m_Filename.c_str());
+    vtkIdType expectedPoints = fileSize>1000 ? (fileSize-1000)/(4*stride)/everyKthFiber : 0;
+    std::size_t expectedFibers = m_Header.n_count>0 ? m_Header.n_count/everyKthFiber+1 : 0;
+
+    vtkSmartPointer<vtkFloatArray> pointData = vtkSmartPointer<vtkFloatArray>::New();
+    pointData->SetNumberOfComponents(3);
+    pointData->Allocate(3*expectedPoints);
+    std::vector< std::size_t > fiberOffsets;
+    fiberOffsets.reserve(expectedFibers+1);
+    fiberOffsets.push_back(0);
+
+    vtkIdType numPoints = 0;
+    long fiberIndex = 0;
+    {
+        TrackVisChunkReader chunks(m_FilePointer);
+        std::vector< float > tmp;
+        int fiberPoints;
+        while (chunks.Read(&fiberPoints, 4))
         {
-            if (fread((char*)tmp, 1, 12, m_FilePointer) == 0)
+            if ( fiberPoints <= 0 )
+            {
+                printf( "[ERROR] Trying to read a fiber with %d points!\n", fiberPoints );
+                return nullptr;
+            }
+
+            bool keep = fiberIndex++ % everyKthFiber == 0;
+            tmp.resize(stride*fiberPoints);
+            if (!chunks.Read(keep ? tmp.data() : nullptr, 4*tmp.size()) || !chunks.Read(nullptr, propertiesSize))
+            {
                 MITK_ERROR << "TrackVis::read: Error during read.";
-
-            vtkIdType id = vtkNewPoints->InsertNextPoint(tmp);
-            container->GetPointIds()->InsertNextId(id);
+                break;
+            }
+            if (!keep)
+                continue;
+
+            if (minFiberLength>0 || maxFiberLength>0)
+            {
+                float length = 0;
+                for (int j=1; j<fiberPoints; j++)
+                {
+                    const float* p1 = &tmp[(j-1)*stride];
+                    const float* p2 = &tmp[j*stride];
+                    length += std::sqrt((p1[0]-p2[0])*(p1[0]-p2[0])+(p1[1]-p2[1])*(p1[1]-p2[1])+(p1[2]-p2[2])*(p1[2]-p2[2]));
+                }
+                if (length<minFiberLength || (maxFiberLength>0 && length>maxFiberLength))
+                    continue;
+            }
+
+            float* points = pointData->WritePointer(3*numPoints, 3*fiberPoints);
+            for (int j=0; j<fiberPoints; j++)
+            {
+                points[3*j] = flip[0]*tmp[j*stride];
+                points[3*j+1] = flip[1]*tmp[j*stride+1];
+                points[3*j+2] = flip[2]*tmp[j*stride+2];
+            }
+            numPoints += fiberPoints;
+            fiberOffsets.push_back(numPoints);
         }
-        vtkNewCells->InsertNextCell(container);
     }
+    std::size_t numFibers = fiberOffsets.size()-1;
+    if (static_cast<long>(numFibers)<fiberIndex)
+        MITK_INFO << "Kept " << numFibers << " of " << fiberIndex << " fibers";
 
-    vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    fiberPolyData->SetPoints(vtkNewPoints);
-    fiberPolyData->SetLines(vtkNewCells);
-
-    MITK_INFO << "Coordinate convention: " << m_Header.voxel_order;
+    // the bundle takes over the points, they are not copied
+    pointData->Squeeze();
+    mitk::FiberBundleCompactData fibers(pointData, fiberOffsets);
+    pointData = nullptr;
+    mitk::FiberBundle::Pointer fib = mitk::FiberBundle::New(fibers);
 
     mitk::Geometry3D::Pointer geometry = mitk::Geometry3D::New();
     vtkSmartPointer< vtkMatrix4x4 > matrix = vtkSmartPointer< vtkMatrix4x4 >::New();
     matrix->Identity();
-
-    if (m_Header.voxel_order[0]=='R')
-        matrix->SetElement(0,0,-matrix->GetElement(0,0));
-    if (m_Header.voxel_order[1]=='A')
-        matrix->SetElement(1,1,-matrix->GetElement(1,1));
-    if (m_Header.voxel_order[2]=='I')
-        matrix->SetElement(2,2,-matrix->GetElement(2,2));
-
+    for (int i=0; i<3; i++)
+        matrix->SetElement(i,i,flip[i]);
     geometry->SetIndexToWorldTransformByVtkMatrix(matrix);
 
-    vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-    transformFilter->SetInputData(fiberPolyData);
-    transformFilter->SetTransform(geometry->GetVtkTransform());
-    transformFilter->Update();
-    fib->SetFiberPolyData(transformFilter->GetOutput());
-
     mitk::Point3D origin;
     origin[0]=m_Header.origin[0];
     origin[1]=m_Header.origin[1];
@@ -198,7 +430,7 @@ short TrackVisFiberReader::read( mitk::FiberBundle* fib )
 
     fib->SetReferenceGeometry(dynamic_cast<mitk::BaseGeometry*>(geometry.GetPointer()));
 
-    return numPoints;
+    return fib;
 }
 
 
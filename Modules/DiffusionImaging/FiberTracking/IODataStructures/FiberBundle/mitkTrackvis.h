@@ -68,7 +68,7 @@ public:
 
     short   create(string m_Filename, const mitk::FiberBundle* fib);
     short   open( string m_Filename );
-    short   read( mitk::FiberBundle* fib );
+    mitk::FiberBundle::Pointer read( int everyKthFiber=1, float minFiberLength=0, float maxFiberLength=0 );
     short   append(const mitk::FiberBundle* fib );
     void    writeHdr();
     void    updateTotal( int totFibers );
@@ -8,8 +8,12 @@ SET(MODULE_CUSTOM_TESTS
   mitkFiberExtractionTest.cpp
   mitkFiberGenerationTest.cpp
   mitkFiberfoxSignalGenerationTest.cpp
+  mitkFiberfoxKspacePerformanceTest.cpp
   mitkMachineLearningTrackingTest.cpp
   mitkFiberProcessingTest.cpp
+  mitkParallelMetropolisHastingsSamplerTest.cpp
+  mitkTractsToImageFiltersTest.cpp
+  mitkFiberBundleSpatialIndexTest.cpp
 )
 
 
@@ -20,6 +20,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <mitkTestingConfig.h>
 #include <mitkIOUtil.h>
+#include <mitkTrackvis.h>
+#include <vtkPolyData.h>
+#include <algorithm>
+#include <cmath>
 
 #include "mitkTestFixture.h"
 
@@ -28,6 +32,9 @@ class mitkFiberBundleReaderWriterTestSuite : public mitk::TestFixture
 
   CPPUNIT_TEST_SUITE(mitkFiberBundleReaderWriterTestSuite);
   MITK_TEST(Equal_SaveLoad_ReturnsTrue);
+  MITK_TEST(Equal_SaveLoadTrk_ReturnsTrue);
+  MITK_TEST(LoadTrk_EveryKthFiber_KeepsEveryKthFiber);
+  MITK_TEST(LoadTrk_MinMaxLength_KeepsFibersInRange);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -36,6 +43,62 @@ private:
   mitk::FiberBundle::Pointer fib1;
   mitk::FiberBundle::Pointer fib2;
 
+  std::string TrkFileName()
+  {
+    return std::string(MITK_TEST_OUTPUT_DIR)+"/writerTest.trk";
+  }
+
+  mitk::FiberBundle::Pointer LoadTrk(int everyKthFiber, float minFiberLength, float maxFiberLength)
+  {
+    mitk::IFileReader::Options options;
+    options["Read every k-th fiber"] = everyKthFiber;
+    options["Minimum fiber length (mm)"] = minFiberLength;
+    options["Maximum fiber length (mm, 0: no limit)"] = maxFiberLength;
+    std::vector<mitk::BaseData::Pointer> baseData = mitk::IOUtil::Load(TrkFileName(), options);
+    return dynamic_cast<mitk::FiberBundle*>(baseData.at(0).GetPointer());
+  }
+
+  /** Lengths of the fibers computed like the TrackVis reader does. */
+  std::vector<float> FiberLengths(mitk::FiberBundle* fib)
+  {
+    vtkSmartPointer<vtkPolyData> polyData = fib->GetFiberPolyData();
+    std::vector<float> lengths;
+    for (int i=0; i<fib->GetNumFibers(); i++)
+    {
+      vtkIdType numPoints;
+      vtkIdType* ids;
+      polyData->GetCellPoints(i, numPoints, ids);
+      float length = 0;
+      for (vtkIdType j=1; j<numPoints; j++)
+      {
+        double p1[3], p2[3];
+        polyData->GetPoint(ids[j-1], p1);
+        polyData->GetPoint(ids[j], p2);
+        float d[3] = { static_cast<float>(p1[0])-static_cast<float>(p2[0]),
+                       static_cast<float>(p1[1])-static_cast<float>(p2[1]),
+                       static_cast<float>(p1[2])-static_cast<float>(p2[2]) };
+        length += std::sqrt(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]);
+      }
+      lengths.push_back(length);
+    }
+    return lengths;
+  }
+
+  /** A length between two fiber lengths, so that no fiber is exactly at the limit. */
+  float LengthBetweenFibers(std::vector<float> lengths, std::size_t index)
+  {
+    std::sort(lengths.begin(), lengths.end());
+    while (index+1<lengths.size() && lengths[index]==lengths[index+1])
+      index++;
+    CPPUNIT_ASSERT_MESSAGE("Fibers of different length", index+1<lengths.size());
+    return (lengths[index]+lengths[index+1])/2;
+  }
+
+  mitk::FiberBundle::Pointer Subset(mitk::FiberBundle* fib, const std::vector<long>& ids)
+  {
+    return mitk::FiberBundle::New(fib->GeneratePolyDataByIds(ids));
+  }
+
 public:
 
   void setUp() override
@@ -66,6 +129,54 @@ public:
     //MITK_ASSERT_EQUAL(fib1, fib2, "A saved and re-loaded file should be equal");
   }
 
+  void Equal_SaveLoadTrk_ReturnsTrue()
+  {
+    mitk::IOUtil::Save(fib1.GetPointer(), TrkFileName());
+    fib2 = LoadTrk(1, 0, 0);
+    CPPUNIT_ASSERT_MESSAGE("Should be equal", fib1->Equals(fib2));
+
+    TrackVisFiberReader reader;
+    CPPUNIT_ASSERT_EQUAL(1000, static_cast<int>(reader.open(TrkFileName())));
+    CPPUNIT_ASSERT_EQUAL(fib1->GetNumFibers(), reader.m_Header.n_count);
+    reader.close();
+  }
+
+  void LoadTrk_EveryKthFiber_KeepsEveryKthFiber()
+  {
+    mitk::IOUtil::Save(fib1.GetPointer(), TrkFileName());
+    fib2 = LoadTrk(3, 0, 0);
+
+    std::vector<long> ids;
+    for (long i=0; i<fib1->GetNumFibers(); i+=3)
+      ids.push_back(i);
+    mitk::FiberBundle::Pointer expected = Subset(fib1, ids);
+    CPPUNIT_ASSERT_MESSAGE("Every third fiber", fib2->GetNumFibers()>0 && expected->Equals(fib2));
+  }
+
+  void LoadTrk_MinMaxLength_KeepsFibersInRange()
+  {
+    mitk::IOUtil::Save(fib1.GetPointer(), TrkFileName());
+    mitk::FiberBundle::Pointer all = LoadTrk(1, 0, 0);
+    std::vector<float> lengths = FiberLengths(all);
+    float minLength = LengthBetweenFibers(lengths, lengths.size()/4);
+    float maxLength = LengthBetweenFibers(lengths, lengths.size()*3/4);
+
+    std::vector<long> longIds, rangeIds;
+    for (std::size_t i=0; i<lengths.size(); i++)
+    {
+      if (lengths[i]>=minLength)
+        longIds.push_back(i);
+      if (lengths[i]>=minLength && lengths[i]<=maxLength)
+        rangeIds.push_back(i);
+    }
+
+    fib2 = LoadTrk(1, minLength, 0);
+    CPPUNIT_ASSERT_MESSAGE("Fibers longer than the minimum", Subset(all, longIds)->Equals(fib2));
+
+    fib2 = LoadTrk(1, minLength, maxLength);
+    CPPUNIT_ASSERT_MESSAGE("Fibers between minimum and maximum", !rangeIds.empty() && Subset(all, rangeIds)->Equals(fib2));
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkFiberBundleReaderWriter)
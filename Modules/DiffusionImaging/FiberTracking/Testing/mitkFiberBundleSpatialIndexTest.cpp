@@ -0,0 +1,273 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <mitkFiberBundleSpatialIndex.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <vtkPolyLine.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkMath.h>
+#include <algorithm>
+#include <utility>
+
+#include "mitkTestFixture.h"
+
+/**
+ * Compares the queries of the FiberBundleSpatialIndex with a brute force scan over all fiber segments of a random bundle.
+ */
+class mitkFiberBundleSpatialIndexTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkFiberBundleSpatialIndexTestSuite);
+    MITK_TEST(FindSegments_RandomBoxes_SameAsBruteForce);
+    MITK_TEST(FindFibers_RandomBoxes_SameAsBruteForce);
+    MITK_TEST(FindSegmentsInSlab_RandomSlabs_SameAsBruteForce);
+    MITK_TEST(Queries_AfterTransformFibers_SameAsBruteForce);
+    MITK_TEST(ResampleSpline_MaxSegmentLengthMargin_ContainsSpline);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandGenType;
+    typedef std::pair< vtkIdType, vtkIdType > Segment;
+
+private:
+
+    mitk::FiberBundle::Pointer  m_FiberBundle;
+    RandGenType::Pointer        m_RandGen;
+
+    /** start and end point ids of all segments, fiber by fiber */
+    std::vector< std::pair< long, Segment > > GetAllSegments(vtkPolyData* polyData)
+    {
+        std::vector< std::pair< long, Segment > > segments;
+        vtkCellArray* lines = polyData->GetLines();
+        lines->InitTraversal();
+        vtkIdType numPoints;
+        vtkIdType* points;
+        for (long fiber=0; lines->GetNextCell(numPoints, points); fiber++)
+            for (vtkIdType j=0; j+1<numPoints; j++)
+                segments.push_back(std::make_pair(fiber, Segment(points[j], points[j+1])));
+        return segments;
+    }
+
+    std::vector< Segment > ToPointIds(const mitk::FiberBundleSpatialIndex& index, const std::vector< mitk::FiberBundleSpatialIndex::SegmentId >& segments)
+    {
+        std::vector< Segment > pointIds;
+        for (std::size_t i=0; i<segments.size(); i++)
+        {
+            Segment s;
+            index.GetSegmentPointIds(segments[i], s.first, s.second);
+            pointIds.push_back(s);
+        }
+        return pointIds;
+    }
+
+    bool OverlapsBox(vtkPolyData* polyData, const Segment& segment, const double bounds[6])
+    {
+        double p1[3], p2[3];
+        polyData->GetPoint(segment.first, p1);
+        polyData->GetPoint(segment.second, p2);
+        for (int i=0; i<3; i++)
+            if (std::max(p1[i], p2[i])<bounds[2*i] || std::min(p1[i], p2[i])>bounds[2*i+1])
+                return false;
+        return true;
+    }
+
+    void GetRandomBox(double bounds[6])
+    {
+        for (int i=0; i<3; i++)
+        {
+            bounds[2*i] = m_RandGen->GetUniformVariate(-5, 30);
+            bounds[2*i+1] = bounds[2*i] + m_RandGen->GetUniformVariate(0, 8);
+        }
+    }
+
+    void CheckFindSegments(mitk::FiberBundle* fib)
+    {
+        const mitk::FiberBundleSpatialIndex& index = fib->GetSpatialIndex();
+        vtkPolyData* polyData = fib->GetFiberPolyData();
+        CPPUNIT_ASSERT_MESSAGE("Index is built from the current fibers", index.GetPolyData()==polyData);
+        std::vector< std::pair< long, Segment > > allSegments = GetAllSegments(polyData);
+        CPPUNIT_ASSERT_EQUAL(allSegments.size(), static_cast<std::size_t>(index.GetNumberOfSegments()));
+
+        for (int q=0; q<100; q++)
+        {
+            double bounds[6];
+            GetRandomBox(bounds);
+
+            std::vector< Segment > expected;
+            for (std::size_t i=0; i<allSegments.size(); i++)
+                if (OverlapsBox(polyData, allSegments[i].second, bounds))
+                    expected.push_back(allSegments[i].second);
+
+            std::vector< mitk::FiberBundleSpatialIndex::SegmentId > segments;
+            index.FindSegments(bounds, segments);
+            CPPUNIT_ASSERT_MESSAGE("FindSegments returns the segments overlapping the box", ToPointIds(index, segments)==expected);
+        }
+    }
+
+    void CheckFindFibers(mitk::FiberBundle* fib)
+    {
+        const mitk::FiberBundleSpatialIndex& index = fib->GetSpatialIndex();
+        vtkPolyData* polyData = fib->GetFiberPolyData();
+        std::vector< std::pair< long, Segment > > allSegments = GetAllSegments(polyData);
+
+        for (int q=0; q<100; q++)
+        {
+            double bounds[6];
+            GetRandomBox(bounds);
+
+            std::vector< long > expected;
+            for (std::size_t i=0; i<allSegments.size(); i++)
+                if (OverlapsBox(polyData, allSegments[i].second, bounds) && (expected.empty() || expected.back()!=allSegments[i].first))
+                    expected.push_back(allSegments[i].first);
+
+            CPPUNIT_ASSERT_MESSAGE("FindFibers returns the fibers overlapping the box", index.FindFibers(bounds)==expected);
+        }
+    }
+
+    void CheckFindSegmentsInSlab(mitk::FiberBundle* fib)
+    {
+        const mitk::FiberBundleSpatialIndex& index = fib->GetSpatialIndex();
+        vtkPolyData* polyData = fib->GetFiberPolyData();
+        std::vector< std::pair< long, Segment > > allSegments = GetAllSegments(polyData);
+
+        for (int q=0; q<100; q++)
+        {
+            double normal[3];
+            for (int i=0; i<3; i++)
+                normal[i] = m_RandGen->GetUniformVariate(-1, 1);
+            if (vtkMath::Normalize(normal)==0)
+                continue;
+            double offset = m_RandGen->GetUniformVariate(-10, 40);
+            double halfThickness = m_RandGen->GetUniformVariate(0, 3);
+
+            std::vector< Segment > expected;
+            for (std::size_t i=0; i<allSegments.size(); i++)
+            {
+                double p1[3], p2[3];
+                polyData->GetPoint(allSegments[i].second.first, p1);
+                polyData->GetPoint(allSegments[i].second.second, p2);
+                double d1 = vtkMath::Dot(normal, p1) - offset;
+                double d2 = vtkMath::Dot(normal, p2) - offset;
+                if (std::min(d1, d2)<=halfThickness && std::max(d1, d2)>=-halfThickness)
+                    expected.push_back(allSegments[i].second);
+            }
+
+            std::vector< mitk::FiberBundleSpatialIndex::SegmentId > segments;
+            index.FindSegmentsInSlab(normal, offset, halfThickness, segments);
+            CPPUNIT_ASSERT_MESSAGE("FindSegmentsInSlab returns the segments touching the slab", ToPointIds(index, segments)==expected);
+        }
+    }
+
+public:
+
+    void setUp() override
+    {
+        m_RandGen = RandGenType::New();
+        m_RandGen->SetSeed(42);
+
+        // random walks of different lengths, including a single point fiber
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+        for (int i=0; i<500; i++)
+        {
+            vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
+            double p[3];
+            for (int c=0; c<3; c++)
+                p[c] = m_RandGen->GetUniformVariate(0, 25);
+            int numPoints = i==0 ? 1 : 2+m_RandGen->GetIntegerVariate(30);
+            for (int j=0; j<numPoints; j++)
+            {
+                line->GetPointIds()->InsertNextId(points->InsertNextPoint(p));
+                for (int c=0; c<3; c++)
+                    p[c] += m_RandGen->GetUniformVariate(-2, 2);
+            }
+            lines->InsertNextCell(line);
+        }
+        vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+        polyData->SetPoints(points);
+        polyData->SetLines(lines);
+        m_FiberBundle = mitk::FiberBundle::New(polyData);
+    }
+
+    void tearDown() override
+    {
+        m_FiberBundle = nullptr;
+        m_RandGen = nullptr;
+    }
+
+    void FindSegments_RandomBoxes_SameAsBruteForce()
+    {
+        CheckFindSegments(m_FiberBundle);
+    }
+
+    void FindFibers_RandomBoxes_SameAsBruteForce()
+    {
+        CheckFindFibers(m_FiberBundle);
+    }
+
+    void FindSegmentsInSlab_RandomSlabs_SameAsBruteForce()
+    {
+        CheckFindSegmentsInSlab(m_FiberBundle);
+    }
+
+    void Queries_AfterTransformFibers_SameAsBruteForce()
+    {
+        // build the index before the transformation, it has to be rebuilt afterwards
+        m_FiberBundle->GetSpatialIndex();
+        m_FiberBundle->TransformFibers(20, -35, 50, 3, -2, 4);
+        CheckFindSegments(m_FiberBundle);
+        CheckFindFibers(m_FiberBundle);
+        CheckFindSegmentsInSlab(m_FiberBundle);
+    }
+
+    void ResampleSpline_MaxSegmentLengthMargin_ContainsSpline()
+    {
+        // the mask queries expect every point of the resampled fiber within GetMaxSegmentLength()+minSpacing of one of its segments
+        const float minSpacing = 1;
+        const mitk::FiberBundleSpatialIndex& index = m_FiberBundle->GetSpatialIndex();
+        const double margin = index.GetMaxSegmentLength()+minSpacing;
+
+        mitk::FiberBundle::Pointer resampled = m_FiberBundle->GetDeepCopy();
+        resampled->ResampleSpline(minSpacing/5);
+        CPPUNIT_ASSERT_EQUAL(m_FiberBundle->GetNumFibers(), resampled->GetNumFibers());
+
+        vtkPolyData* polyData = resampled->GetFiberPolyData();
+        vtkCellArray* lines = polyData->GetLines();
+        lines->InitTraversal();
+        vtkIdType numPoints;
+        vtkIdType* points;
+        bool contained = true;
+        for (long fiber=0; lines->GetNextCell(numPoints, points); fiber++)
+        {
+            if (index.GetNumberOfFiberPoints(fiber)<2)
+                continue;
+            for (vtkIdType j=0; j<numPoints && contained; j++)
+            {
+                double p[3];
+                polyData->GetPoint(points[j], p);
+                double bounds[6] = { p[0]-margin, p[0]+margin, p[1]-margin, p[1]+margin, p[2]-margin, p[2]+margin };
+                std::vector< long > fibers = index.FindFibers(bounds);
+                contained = std::binary_search(fibers.begin(), fibers.end(), fiber);
+            }
+        }
+        CPPUNIT_ASSERT_MESSAGE("Resampled fibers stay within the margin of their segments", contained);
+    }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFiberBundleSpatialIndex)
@@ -0,0 +1,198 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkFiberfoxParameters.h>
+#include <itkKspaceImageFilter.h>
+#include <itkDftImageFilter.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkTimeProbe.h>
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+typedef itk::KspaceImageFilter< double > KspaceFilterType;
+typedef itk::DftImageFilter< double > DftFilterType;
+typedef KspaceFilterType::InputImageType SliceType;
+typedef KspaceFilterType::OutputImageType ComplexSliceType;
+
+/**Documentation
+ * Compares the separable k-space simulation and image reconstruction of Fiberfox to the direct
+ * evaluation of the DFT and logs the runtime of both.
+ */
+std::vector< SliceType::Pointer > CreateCompartmentSlices(unsigned int size)
+{
+    std::vector< SliceType::Pointer > slices;
+    SliceType::RegionType region;
+    region.SetSize(0, size);
+    region.SetSize(1, size);
+    for (int c=0; c<2; c++)
+    {
+        SliceType::Pointer slice = SliceType::New();
+        slice->SetRegions(region);
+        slice->Allocate();
+        slice->FillBuffer(0.0);
+
+        // two overlapping discs with different signal
+        itk::ImageRegionIterator< SliceType > it(slice, region);
+        while (!it.IsAtEnd())
+        {
+            double dx = it.GetIndex()[0] - (c==0 ? 0.4 : 0.6)*size;
+            double dy = it.GetIndex()[1] - 0.5*size;
+            if (dx*dx+dy*dy < 0.1*size*size)
+                it.Set(c==0 ? 0.7 : 0.3 + 0.01*it.GetIndex()[0]);
+            ++it;
+        }
+        slices.push_back(slice);
+    }
+    return slices;
+}
+
+ComplexSliceType::Pointer SimulateKspace(mitk::FiberfoxParameters<double>* parameters, std::vector< SliceType::Pointer > slices, bool useSeparableDft, std::string message)
+{
+    std::vector< double > t1; t1.push_back(800); t1.push_back(4000);
+    std::vector< double > t2; t2.push_back(90); t2.push_back(2000);
+    itk::Vector< double, 3 > gradient; gradient[0] = 0.3; gradient[1] = 0.8; gradient[2] = 0.5;
+    itk::Vector< double, 3 > coilPosition; coilPosition.Fill(0.0); coilPosition[0] = 100;
+
+    KspaceFilterType::Pointer filter = KspaceFilterType::New();
+    filter->SetCompartmentImages(slices);
+    filter->SetT1(t1);
+    filter->SetT2(t2);
+    filter->SetParameters(parameters);
+    filter->SetUseConstantRandSeed(true);
+    filter->SetZ(0);
+    filter->SetZidx(0);
+    filter->SetCoilPosition(coilPosition);
+    filter->SetDiffusionGradientDirection(gradient);
+    filter->SetUseSeparableDft(useSeparableDft);
+
+    itk::TimeProbe clock;
+    clock.Start();
+    filter->Update();
+    clock.Stop();
+    MITK_INFO << message << ": " << clock.GetTotal() << "s";
+
+    return filter->GetOutput();
+}
+
+ComplexSliceType::Pointer ReconstructSlice(ComplexSliceType::Pointer kspace, mitk::FiberfoxParameters<double>* parameters, std::string message)
+{
+    DftFilterType::Pointer dft = DftFilterType::New();
+    dft->SetInput(kspace);
+    dft->SetParameters(*parameters);
+
+    itk::TimeProbe clock;
+    clock.Start();
+    dft->Update();
+    clock.Stop();
+    MITK_INFO << message << ": " << clock.GetTotal() << "s";
+
+    return dft->GetOutput();
+}
+
+/** Straightforward DFT as it was calculated by the DftImageFilter before. */
+ComplexSliceType::Pointer ReferenceDft(ComplexSliceType::Pointer kspace)
+{
+    ComplexSliceType::Pointer image = ComplexSliceType::New();
+    image->SetRegions(kspace->GetLargestPossibleRegion());
+    image->Allocate();
+
+    int szx = kspace->GetLargestPossibleRegion().GetSize(0);
+    int szy = kspace->GetLargestPossibleRegion().GetSize(1);
+
+    itk::ImageRegionIterator< ComplexSliceType > oit(image, image->GetLargestPossibleRegion());
+    while (!oit.IsAtEnd())
+    {
+        double x = oit.GetIndex()[0] - (szx-szx%2)/2;
+        double y = oit.GetIndex()[1] - (szy-szy%2)/2;
+
+        vcl_complex<double> s(0,0);
+        itk::ImageRegionConstIteratorWithIndex< ComplexSliceType > it(kspace, kspace->GetLargestPossibleRegion());
+        while (!it.IsAtEnd())
+        {
+            double kx = it.GetIndex()[0] - (szx-szx%2)/2;
+            double ky = it.GetIndex()[1] - (szy-szy%2)/2;
+            s += it.Get() * exp( std::complex<double>(0, -2 * M_PI * (x*kx/szx + y*ky/szy) ) );
+            ++it;
+        }
+        oit.Set(s);
+        ++oit;
+    }
+    return image;
+}
+
+/** Largest difference of two complex slices relative to the largest magnitude of the first one. */
+double RelativeDifference(ComplexSliceType::Pointer expected, ComplexSliceType::Pointer actual)
+{
+    double maxMagnitude = 0;
+    double maxDifference = 0;
+    itk::ImageRegionIterator< ComplexSliceType > it1(expected, expected->GetLargestPossibleRegion());
+    itk::ImageRegionIterator< ComplexSliceType > it2(actual, actual->GetLargestPossibleRegion());
+    while (!it1.IsAtEnd())
+    {
+        maxMagnitude = std::max(maxMagnitude, std::abs(it1.Get()));
+        maxDifference = std::max(maxDifference, std::abs(it1.Get()-it2.Get()));
+        ++it1;
+        ++it2;
+    }
+    return maxMagnitude>0 ? maxDifference/maxMagnitude : maxDifference;
+}
+
+int mitkFiberfoxKspacePerformanceTest(int, char*[])
+{
+    MITK_TEST_BEGIN("mitkFiberfoxKspacePerformanceTest");
+
+    const unsigned int size = 64;
+    std::vector< SliceType::Pointer > slices = CreateCompartmentSlices(size);
+
+    mitk::FiberfoxParameters<double> parameters;
+    parameters.m_SignalGen.m_ImageRegion.SetSize(0, size);
+    parameters.m_SignalGen.m_ImageRegion.SetSize(1, size);
+    parameters.m_SignalGen.m_ImageRegion.SetSize(2, 1);
+    parameters.m_SignalGen.m_CroppingFactor = 0.8;
+    parameters.m_SignalGen.m_CroppedRegion = parameters.m_SignalGen.m_ImageRegion;
+    parameters.m_SignalGen.m_CroppedRegion.SetSize(1, size*parameters.m_SignalGen.m_CroppingFactor);
+    parameters.m_SignalGen.m_KspaceLineOffset = 0.1;
+    parameters.m_SignalGen.m_PartialFourier = 0.8;
+    parameters.m_SignalGen.m_NoiseVariance = 0;
+    parameters.m_SignalGen.m_CoilSensitivityProfile = mitk::SignalGenerationParameters::COIL_LINEAR;
+
+    // relaxation, ghosts, aliasing, partial fourier and coil sensitivity
+    ComplexSliceType::Pointer separable = SimulateKspace(&parameters, slices, true, "k-space, separable DFT");
+    ComplexSliceType::Pointer direct = SimulateKspace(&parameters, slices, false, "k-space, direct DFT");
+    MITK_TEST_CONDITION(RelativeDifference(direct, separable)<1e-9, "Separable k-space simulation equals direct DFT");
+    ComplexSliceType::Pointer relaxation = separable;
+
+    // without relaxation all compartments are summed up front
+    parameters.m_SignalGen.m_DoSimulateRelaxation = false;
+    separable = SimulateKspace(&parameters, slices, true, "k-space without relaxation, separable DFT");
+    direct = SimulateKspace(&parameters, slices, false, "k-space without relaxation, direct DFT");
+    MITK_TEST_CONDITION(RelativeDifference(direct, separable)<1e-9, "Separable k-space simulation without relaxation equals direct DFT");
+
+    // eddy currents are not separable and always use the direct DFT
+    parameters.m_SignalGen.m_DoSimulateRelaxation = true;
+    parameters.m_Misc.m_CheckAddEddyCurrentsBox = true;
+    ComplexSliceType::Pointer eddy = SimulateKspace(&parameters, slices, true, "k-space with eddy currents");
+    MITK_TEST_CONDITION(RelativeDifference(relaxation, eddy)>1e-6, "Eddy currents change the k-space");
+
+    ComplexSliceType::Pointer image = ReconstructSlice(separable, &parameters, "image reconstruction, separable DFT");
+    ComplexSliceType::Pointer reference = ReferenceDft(separable);
+    MITK_TEST_CONDITION(RelativeDifference(reference, image)<1e-9, "Separable image reconstruction equals direct DFT");
+
+    MITK_TEST_END();
+}
@@ -0,0 +1,164 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkParallelMetropolisHastingsSampler.h>
+#include <mitkGibbsEnergyComputer.h>
+#include <mitkSphereInterpolator.h>
+#include <mitkQBallImage.h>
+#include <itkImageRegionIterator.h>
+#include <cmath>
+
+#include "mitkTestFixture.h"
+
+/**
+ * Runs the parallel Gibbs tracking sampler on a small synthetic ODF image. The result has to be the same for any
+ * number of threads and the particle grid has to stay consistent.
+ */
+class mitkParallelMetropolisHastingsSamplerTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkParallelMetropolisHastingsSamplerTestSuite);
+    MITK_TEST(MakeProposals_TwoAndFourThreads_SameResult);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef GibbsEnergyComputer::ItkQBallImgType        ItkQBallImgType;
+    typedef GibbsEnergyComputer::ItkFloatImageType      ItkFloatImageType;
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandGenType;
+
+private:
+
+    ItkQBallImgType::Pointer    m_QBallImage;
+    ItkFloatImageType::Pointer  m_MaskImage;
+
+    /** the components of one tracking run, as set up by the GibbsTrackingFilter */
+    struct Tracking
+    {
+        ParticleGrid*                                   m_Grid;
+        RandGenType::Pointer                            m_RandGen;
+        std::vector< SphereInterpolator* >              m_Interpolators;
+        std::vector< RandGenType::Pointer >             m_ThreadRandGens;
+        std::vector< GibbsEnergyComputer* >             m_Encomps;
+        std::vector< MetropolisHastingsSampler* >       m_Samplers;
+        ParallelMetropolisHastingsSampler*              m_ParallelSampler;
+
+        Tracking(ItkQBallImgType* qballImage, ItkFloatImageType* mask, int numThreads)
+        {
+            const float particleLength = 1.5;
+            const float curvatureThreshold = 0.7;
+            m_Grid = new ParticleGrid(mask, particleLength, 32);
+            m_RandGen = RandGenType::New();
+            m_RandGen->SetSeed(42);
+            SphereInterpolator interpolator("");
+            for (int t=0; t<numThreads; t++)
+            {
+                m_Interpolators.push_back(new SphereInterpolator(interpolator));
+                m_ThreadRandGens.push_back(RandGenType::New());
+                m_Encomps.push_back(new GibbsEnergyComputer(qballImage, mask, m_Grid, m_Interpolators.back(), m_ThreadRandGens.back()));
+                m_Encomps.back()->SetParameters(0.01, 0.5, 10*particleLength*particleLength, curvatureThreshold, 0, 0.2);
+                m_Samplers.push_back(new MetropolisHastingsSampler(m_Grid, m_Encomps.back(), m_ThreadRandGens.back(), curvatureThreshold));
+            }
+            m_ParallelSampler = new ParallelMetropolisHastingsSampler(m_Grid, m_Samplers, m_RandGen);
+        }
+
+        ~Tracking()
+        {
+            delete m_ParallelSampler;
+            for (std::size_t t=0; t<m_Samplers.size(); t++)
+            {
+                delete m_Samplers[t];
+                delete m_Encomps[t];
+                delete m_Interpolators[t];
+            }
+            delete m_Grid;
+        }
+    };
+
+    /** positions, directions and connections of all particles */
+    std::vector< float > GetState(ParticleGrid* grid)
+    {
+        std::vector< float > state;
+        for (int i=0; i<grid->m_NumParticles; i++)
+        {
+            Particle* p = grid->GetParticle(i);
+            state.insert(state.end(), p->GetPos().begin(), p->GetPos().end());
+            state.insert(state.end(), p->GetDir().begin(), p->GetDir().end());
+            state.push_back(p->pID);
+            state.push_back(p->mID);
+        }
+        state.push_back(grid->m_NumConnections);
+        return state;
+    }
+
+    std::vector< float > RunTracking(int numThreads)
+    {
+        Tracking tracking(m_QBallImage, m_MaskImage, numThreads);
+        CPPUNIT_ASSERT_MESSAGE("Grid is large enough for parallel sampling", tracking.m_ParallelSampler->CanRunInParallel());
+
+        for (int step=0; step<10; step++)
+        {
+            tracking.m_ParallelSampler->SetTemperature(0.1*std::pow(0.7, step));
+            tracking.m_ParallelSampler->MakeProposals(20000);
+            CPPUNIT_ASSERT_MESSAGE("Particle grid is consistent", tracking.m_Grid->CheckConsistency());
+        }
+        CPPUNIT_ASSERT_MESSAGE("Particles were created", tracking.m_Grid->m_NumParticles>0);
+        return GetState(tracking.m_Grid);
+    }
+
+public:
+
+    void setUp() override
+    {
+        ItkFloatImageType::SizeType size;
+        size[0] = 40; size[1] = 10; size[2] = 10;
+        ItkFloatImageType::RegionType region(size);
+
+        m_MaskImage = ItkFloatImageType::New();
+        m_MaskImage->SetRegions(region);
+        m_MaskImage->Allocate();
+        m_MaskImage->FillBuffer(1);
+
+        // mean free ODFs that vary over the image
+        m_QBallImage = ItkQBallImgType::New();
+        m_QBallImage->SetRegions(region);
+        m_QBallImage->Allocate();
+        itk::ImageRegionIterator< ItkQBallImgType > it(m_QBallImage, region);
+        for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+        {
+            ItkQBallImgType::PixelType odf;
+            for (int i=0; i<QBALL_ODFSIZE; i++)
+                odf[i] = ((7*i + it.GetIndex()[0] + 3*it.GetIndex()[1]) % 11)/10.0 - 0.5;
+            it.Set(odf);
+        }
+    }
+
+    void tearDown() override
+    {
+        m_QBallImage = nullptr;
+        m_MaskImage = nullptr;
+    }
+
+    void MakeProposals_TwoAndFourThreads_SameResult()
+    {
+        std::vector< float > twoThreads = RunTracking(2);
+        std::vector< float > fourThreads = RunTracking(4);
+        CPPUNIT_ASSERT_EQUAL(twoThreads.size(), fourThreads.size());
+        CPPUNIT_ASSERT_MESSAGE("Same particles for 2 and 4 threads", twoThreads == fourThreads);
+    }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkParallelMetropolisHastingsSampler)
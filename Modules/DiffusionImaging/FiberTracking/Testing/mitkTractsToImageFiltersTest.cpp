@@ -0,0 +1,226 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTestingMacros.h"
+#include <mitkFiberBundle.h>
+#include <itkTractDensityImageFilter.h>
+#include <itkTractsToRgbaImageFilter.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkImageRegionConstIterator.h>
+#include <vtkPolyLine.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <algorithm>
+#include <cstring>
+#include <omp.h>
+
+#include "mitkTestFixture.h"
+
+/**
+ * Renders fiber bundles with the TractDensityImageFilter and the TractsToRgbaImageFilter. The images have to be
+ * bitwise identical for any number of threads and the RGBA image has to encode the local fiber direction.
+ */
+class mitkTractsToImageFiltersTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkTractsToImageFiltersTestSuite);
+    MITK_TEST(TractDensity_OneAndFourThreads_SameImage);
+    MITK_TEST(TractsToRgba_OneAndFourThreads_SameImage);
+    MITK_TEST(TractsToRgba_FiberEnteringImage_ColorMatchesDirection);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef itk::Image<float, 3>                        ItkFloatImgType;
+    typedef itk::Image<unsigned char, 3>                ItkUcharImgType;
+    typedef itk::Image<itk::RGBAPixel<unsigned char>, 3> ItkRgbaImgType;
+
+private:
+
+    mitk::FiberBundle::Pointer  m_FiberBundle;
+    ItkFloatImgType::Pointer    m_FloatReference;
+    ItkUcharImgType::Pointer    m_UcharReference;
+    int                         m_NumThreads;
+
+    mitk::FiberBundle::Pointer CreateFiberBundle(const std::vector< std::vector< mitk::Point3D > >& fibers)
+    {
+        vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+        vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+        for (std::size_t i=0; i<fibers.size(); i++)
+        {
+            vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
+            for (std::size_t j=0; j<fibers[i].size(); j++)
+                line->GetPointIds()->InsertNextId(points->InsertNextPoint(fibers[i][j].GetDataPointer()));
+            lines->InsertNextCell(line);
+        }
+        vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+        polyData->SetPoints(points);
+        polyData->SetLines(lines);
+        return mitk::FiberBundle::New(polyData);
+    }
+
+    template< class ImageType >
+    typename ImageType::Pointer CreateReferenceImage()
+    {
+        typename ImageType::SizeType size;
+        size.Fill(24);
+        typename ImageType::Pointer image = ImageType::New();
+        image->SetRegions(typename ImageType::RegionType(size));
+        image->Allocate();
+        return image;
+    }
+
+    template< class ImageType >
+    bool ImagesAreEqual(ImageType* image1, ImageType* image2)
+    {
+        if (image1->GetLargestPossibleRegion()!=image2->GetLargestPossibleRegion())
+            return false;
+        std::size_t size = image1->GetLargestPossibleRegion().GetNumberOfPixels()*sizeof(typename ImageType::PixelType);
+        return std::memcmp(image1->GetBufferPointer(), image2->GetBufferPointer(), size)==0;
+    }
+
+    float GetMaximum(ItkFloatImgType* image)
+    {
+        float maximum = 0;
+        itk::ImageRegionConstIterator< ItkFloatImgType > it(image, image->GetLargestPossibleRegion());
+        for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+            maximum = std::max(maximum, it.Get());
+        return maximum;
+    }
+
+    ItkFloatImgType::Pointer RenderTractDensity(int numThreads, bool useFiberWeights, bool trilinear)
+    {
+        omp_set_num_threads(numThreads);
+        itk::TractDensityImageFilter< ItkFloatImgType >::Pointer filter = itk::TractDensityImageFilter< ItkFloatImgType >::New();
+        filter->SetFiberBundle(m_FiberBundle);
+        filter->SetInputImage(m_FloatReference);
+        filter->SetUseImageGeometry(true);
+        filter->SetUpsamplingFactor(2);
+        filter->SetUseFiberWeights(useFiberWeights);
+        filter->SetUseTrilinearInterpolation(trilinear);
+        filter->Update();
+        return filter->GetOutput();
+    }
+
+    ItkRgbaImgType::Pointer RenderRgba(mitk::FiberBundle* fib, int numThreads, bool useFiberWeights)
+    {
+        omp_set_num_threads(numThreads);
+        itk::TractsToRgbaImageFilter< ItkRgbaImgType >::Pointer filter = itk::TractsToRgbaImageFilter< ItkRgbaImgType >::New();
+        filter->SetFiberBundle(fib);
+        filter->SetInputImage(m_UcharReference);
+        filter->SetUseImageGeometry(true);
+        filter->SetUpsamplingFactor(2);
+        filter->SetUseFiberWeights(useFiberWeights);
+        filter->Update();
+        return filter->GetOutput();
+    }
+
+public:
+
+    void setUp() override
+    {
+        m_NumThreads = omp_get_max_threads();
+        m_FloatReference = CreateReferenceImage< ItkFloatImgType >();
+        m_UcharReference = CreateReferenceImage< ItkUcharImgType >();
+
+        // random walks through the image, some of them leave it
+        typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandGenType;
+        RandGenType::Pointer randGen = RandGenType::New();
+        randGen->SetSeed(42);
+        std::vector< std::vector< mitk::Point3D > > fibers;
+        for (int i=0; i<300; i++)
+        {
+            std::vector< mitk::Point3D > fiber;
+            mitk::Point3D p;
+            for (int c=0; c<3; c++)
+                p[c] = randGen->GetUniformVariate(0, 23);
+            for (int j=0; j<15; j++)
+            {
+                fiber.push_back(p);
+                for (int c=0; c<3; c++)
+                    p[c] += randGen->GetUniformVariate(-2, 2);
+            }
+            fibers.push_back(fiber);
+        }
+        m_FiberBundle = CreateFiberBundle(fibers);
+        for (int i=0; i<300; i++)
+            m_FiberBundle->SetFiberWeight(i, randGen->GetUniformVariate(0.1, 2));
+    }
+
+    void tearDown() override
+    {
+        omp_set_num_threads(m_NumThreads);
+        m_FiberBundle = nullptr;
+        m_FloatReference = nullptr;
+        m_UcharReference = nullptr;
+    }
+
+    void TractDensity_OneAndFourThreads_SameImage()
+    {
+        for (int weights=0; weights<2; weights++)
+            for (int trilinear=0; trilinear<2; trilinear++)
+            {
+                ItkFloatImgType::Pointer oneThread = RenderTractDensity(1, weights, trilinear);
+                ItkFloatImgType::Pointer fourThreads = RenderTractDensity(4, weights, trilinear);
+                CPPUNIT_ASSERT_MESSAGE("Tract density is not empty", GetMaximum(oneThread)>0);
+                CPPUNIT_ASSERT_MESSAGE("Same tract density for 1 and 4 threads", ImagesAreEqual< ItkFloatImgType >(oneThread, fourThreads));
+            }
+    }
+
+    void TractsToRgba_OneAndFourThreads_SameImage()
+    {
+        for (int weights=0; weights<2; weights++)
+        {
+            ItkRgbaImgType::Pointer oneThread = RenderRgba(m_FiberBundle, 1, weights);
+            ItkRgbaImgType::Pointer fourThreads = RenderRgba(m_FiberBundle, 4, weights);
+            CPPUNIT_ASSERT_MESSAGE("Same RGBA image for 1 and 4 threads", ImagesAreEqual< ItkRgbaImgType >(oneThread, fourThreads));
+        }
+    }
+
+    void TractsToRgba_FiberEnteringImage_ColorMatchesDirection()
+    {
+        // runs along y outside of the image and then along x through it
+        std::vector< mitk::Point3D > fiber;
+        mitk::Point3D p;
+        p[0] = -10; p[2] = 12;
+        for (int y=0; y<12; y++)
+        {
+            p[1] = y;
+            fiber.push_back(p);
+        }
+        p[1] = 12;
+        for (int x=-10; x<=20; x++)
+        {
+            p[0] = x;
+            fiber.push_back(p);
+        }
+        std::vector< std::vector< mitk::Point3D > > fibers;
+        fibers.push_back(fiber);
+        mitk::FiberBundle::Pointer fib = CreateFiberBundle(fibers);
+
+        ItkRgbaImgType::Pointer rgba = RenderRgba(fib, 1, false);
+        ItkRgbaImgType::IndexType index;
+        index[0] = 20; index[1] = 24; index[2] = 24;
+        CPPUNIT_ASSERT_MESSAGE("Fiber is rendered", rgba->GetPixel(index).GetRed()>0);
+
+        itk::ImageRegionConstIterator< ItkRgbaImgType > it(rgba, rgba->GetLargestPossibleRegion());
+        bool onlyRed = true;
+        for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+            onlyRed = onlyRed && it.Get().GetGreen()<3 && it.Get().GetBlue()<3;
+        CPPUNIT_ASSERT_MESSAGE("Fiber along x is red inside the image", onlyRed);
+    }
+
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkTractsToImageFilters)
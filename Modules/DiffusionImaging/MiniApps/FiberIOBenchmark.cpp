@@ -0,0 +1,235 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkCommandLineParser.h"
+
+#include <mitkFiberBundle.h>
+#include <mitkIOUtil.h>
+#include <itksys/SystemTools.hxx>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+/*!
+\brief Benchmark of the fiber bundle readers and writers.
+
+A synthetic bundle of random walk fibers is written to and read from TrackVis (.trk) and VTK (.fib) files
+several times. The throughput is reported in fibers and megabytes per second.
+*/
+
+static mitk::FiberBundle::Pointer CreateRandomFibers(int numFibers, int numPoints)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> start(0, 100);
+    std::normal_distribution<double> step(0, 0.3);
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    for (int i=0; i<numFibers; i++)
+    {
+        double p[3] = { start(rng), start(rng), start(rng) };
+        double dir[3] = { 1, 0, 0 };
+        lines->InsertNextCell(numPoints);
+        for (int j=0; j<numPoints; j++)
+        {
+            lines->InsertCellPoint(points->InsertNextPoint(p));
+
+            // unit steps with slowly changing direction
+            double norm = 0;
+            for (int k=0; k<3; k++)
+            {
+                dir[k] += step(rng);
+                norm += dir[k]*dir[k];
+            }
+            norm = std::sqrt(norm);
+            for (int k=0; k<3; k++)
+            {
+                dir[k] /= norm;
+                p[k] += dir[k];
+            }
+        }
+    }
+
+    vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
+    fiberPolyData->SetPoints(points);
+    fiberPolyData->SetLines(lines);
+    return mitk::FiberBundle::New(fiberPolyData);
+}
+
+struct Timing
+{
+    std::vector<double> m_WriteSeconds;
+    std::vector<double> m_ReadSeconds;
+    unsigned long       m_FileSize;
+    int                 m_FibersRead;
+};
+
+static double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size()/2];
+}
+
+int main(int argc, char* argv[])
+{
+    mitkCommandLineParser parser;
+    parser.setArgumentPrefix("--", "-");
+
+    parser.setTitle("Fiber IO Benchmark");
+    parser.setCategory("Benchmarks");
+    parser.setContributor("MBI");
+    parser.setDescription("Measures the throughput of the TrackVis and VTK fiber bundle readers and writers on a synthetic bundle.");
+
+    parser.addArgument("help", "h", mitkCommandLineParser::Bool, "Show this help text");
+    parser.addArgument("out", "o", mitkCommandLineParser::OutputFile, "Output:", "Base name of the temporary fiber files (default: fiber_io_benchmark)", us::Any());
+    parser.addArgument("fibers", "f", mitkCommandLineParser::Int, "Fibers:", "Number of fibers (default: 100000)", us::Any());
+    parser.addArgument("points", "p", mitkCommandLineParser::Int, "Points:", "Number of points per fiber (default: 100)", us::Any());
+    parser.addArgument("every", "k", mitkCommandLineParser::Int, "Every k-th fiber:", "Only read every k-th fiber of the TrackVis file (default: 1)", us::Any());
+    parser.addArgument("minLength", "l", mitkCommandLineParser::Float, "Minimum length:", "Only read TrackVis fibers longer than this (in mm, default: 0)", us::Any());
+    parser.addArgument("repetitions", "r", mitkCommandLineParser::Int, "Repetitions:", "Number of timed runs (default: 3)", us::Any());
+    parser.addArgument("csv", "c", mitkCommandLineParser::OutputFile, "CSV:", "Append the results as lines to this file", us::Any());
+
+    std::map<std::string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
+    if (parsedArgs.count("help") || parsedArgs.count("h"))
+    {
+        std::cout << parser.helpText();
+        return EXIT_SUCCESS;
+    }
+
+    std::string outName = "fiber_io_benchmark";
+    if (parsedArgs.count("out"))
+        outName = us::any_cast<std::string>(parsedArgs["out"]);
+    int numFibers = 100000;
+    if (parsedArgs.count("fibers"))
+        numFibers = us::any_cast<int>(parsedArgs["fibers"]);
+    int numPoints = 100;
+    if (parsedArgs.count("points"))
+        numPoints = us::any_cast<int>(parsedArgs["points"]);
+    int everyKthFiber = 1;
+    if (parsedArgs.count("every"))
+        everyKthFiber = us::any_cast<int>(parsedArgs["every"]);
+    float minLength = 0;
+    if (parsedArgs.count("minLength"))
+        minLength = us::any_cast<float>(parsedArgs["minLength"]);
+    int repetitions = 3;
+    if (parsedArgs.count("repetitions"))
+        repetitions = us::any_cast<int>(parsedArgs["repetitions"]);
+
+    if (numFibers<1 || numPoints<2 || everyKthFiber<1 || repetitions<1)
+    {
+        std::cout << "Invalid parameters, see --help." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::cout << "Creating " << numFibers << " fibers with " << numPoints << " points ..." << std::endl;
+        mitk::FiberBundle::Pointer fib = CreateRandomFibers(numFibers, numPoints);
+
+        std::vector<std::string> extensions;
+        extensions.push_back(".trk");
+        extensions.push_back(".fib");
+
+        std::map<std::string, Timing> timings;
+        for (std::size_t e=0; e<extensions.size(); e++)
+        {
+            const std::string& ext = extensions[e];
+            std::string fileName = outName + ext;
+
+            mitk::IFileReader::Options options;
+            if (ext==".trk")
+            {
+                options["Read every k-th fiber"] = everyKthFiber;
+                options["Minimum fiber length (mm)"] = minLength;
+            }
+
+            Timing& timing = timings[ext];
+            for (int r=0; r<repetitions; r++)
+            {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                mitk::IOUtil::Save(fib.GetPointer(), fileName);
+                std::chrono::steady_clock::time_point written = std::chrono::steady_clock::now();
+                std::vector<mitk::BaseData::Pointer> data = mitk::IOUtil::Load(fileName, options);
+                std::chrono::steady_clock::time_point read = std::chrono::steady_clock::now();
+
+                mitk::FiberBundle* loaded = data.empty() ? nullptr : dynamic_cast<mitk::FiberBundle*>(data[0].GetPointer());
+                if (loaded==nullptr)
+                {
+                    std::cout << "Could not read " << fileName << std::endl;
+                    return EXIT_FAILURE;
+                }
+                timing.m_WriteSeconds.push_back(std::chrono::duration<double>(written-start).count());
+                timing.m_ReadSeconds.push_back(std::chrono::duration<double>(read-written).count());
+                timing.m_FibersRead = loaded->GetNumFibers();
+            }
+            timing.m_FileSize = itksys::SystemTools::FileLength(fileName.c_str());
+            itksys::SystemTools::RemoveFile(fileName.c_str());
+        }
+
+        std::cout << std::fixed << std::setprecision(3);
+        for (std::size_t e=0; e<extensions.size(); e++)
+        {
+            const Timing& timing = timings[extensions[e]];
+            double megabytes = timing.m_FileSize/(1024.0*1024.0);
+            double writeSeconds = Median(timing.m_WriteSeconds);
+            double readSeconds = Median(timing.m_ReadSeconds);
+            std::cout << extensions[e] << " (" << megabytes << " MB)" << std::endl;
+            std::cout << "  Write (median): " << writeSeconds << " s, " << numFibers/writeSeconds << " fibers/s, " << megabytes/writeSeconds << " MB/s" << std::endl;
+            std::cout << "  Read (median):  " << readSeconds << " s, " << timing.m_FibersRead/readSeconds << " fibers/s, " << megabytes/readSeconds << " MB/s"
+                      << " (" << timing.m_FibersRead << " fibers kept)" << std::endl;
+        }
+
+        if (parsedArgs.count("csv"))
+        {
+            std::string csvFileName = us::any_cast<std::string>(parsedArgs["csv"]);
+            bool writeHeader = !std::ifstream(csvFileName.c_str()).good();
+            std::ofstream csv(csvFileName.c_str(), std::ios::app);
+            if (writeHeader)
+                csv << "format;fibers;points;every;minLength;MB;write seconds;write fibers/s;write MB/s;fibers read;read seconds;read fibers/s;read MB/s" << std::endl;
+            for (std::size_t e=0; e<extensions.size(); e++)
+            {
+                const Timing& timing = timings[extensions[e]];
+                double megabytes = timing.m_FileSize/(1024.0*1024.0);
+                double writeSeconds = Median(timing.m_WriteSeconds);
+                double readSeconds = Median(timing.m_ReadSeconds);
+                csv << extensions[e] << ";" << numFibers << ";" << numPoints << ";" << everyKthFiber << ";" << minLength << ";" << megabytes
+                    << ";" << writeSeconds << ";" << numFibers/writeSeconds << ";" << megabytes/writeSeconds
+                    << ";" << timing.m_FibersRead << ";" << readSeconds << ";" << timing.m_FibersRead/readSeconds << ";" << megabytes/readSeconds << std::endl;
+            }
+        }
+    }
+    catch (itk::ExceptionObject& e)
+    {
+        std::cout << e;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception& e)
+    {
+        std::cout << e.what();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -100,6 +100,7 @@ int main(int argc, char* argv[])
     parser.addArgument("shConvention", "s", mitkCommandLineParser::String, "SH coefficient:", "sh coefficient convention (FSL, MRtrix)", string("FSL"), true);
     parser.addArgument("outFile", "o", mitkCommandLineParser::OutputFile, "Output:", "output fiber bundle (.fib)", us::Any(), false);
     parser.addArgument("noFlip", "f", mitkCommandLineParser::Bool, "No flip:", "do not flip input image to match MITK coordinate convention");
+    parser.addArgument("threads", "t", mitkCommandLineParser::Int, "Threads:", "number of threads sampling the particle grid concurrently (default: 1)");
 
     map<string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -213,6 +214,8 @@ int main(int argc, char* argv[])
 
         gibbsTracker->SetDuplicateImage(false);
         gibbsTracker->SetLoadParameterFile( paramFileName );
+        if (parsedArgs.count("threads"))
+            gibbsTracker->SetNumSamplerThreads(us::any_cast<int>(parsedArgs["threads"]));
 //        gibbsTracker->SetLutPath( "" );
         gibbsTracker->Update();
 
@@ -0,0 +1,205 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkCommandLineParser.h"
+
+#include <itkStreamlineTrackingFilter.h>
+#include <itkDiffusionTensor3D.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+/*!
+\brief Benchmark of itk::StreamlineTrackingFilter on a synthetic tensor phantom.
+
+The phantom is a stack of rings in the xy-plane: inside the rings the tensors are prolate and tangent to the
+ring, outside they are isotropic, so the streamlines follow the rings and stop at their boundary. The filter
+is run several times and the throughput is reported in fibers and points per second.
+*/
+
+typedef itk::StreamlineTrackingFilter< float >              FilterType;
+typedef itk::Image< itk::DiffusionTensor3D<float>, 3 >      ItkTensorImage;
+
+static ItkTensorImage::Pointer CreateRingPhantom(int size)
+{
+    ItkTensorImage::SizeType imageSize;
+    imageSize.Fill(size);
+    ItkTensorImage::SpacingType spacing;
+    spacing.Fill(1.0);
+
+    ItkTensorImage::Pointer image = ItkTensorImage::New();
+    image->SetRegions(imageSize);
+    image->SetSpacing(spacing);
+    image->Allocate();
+
+    const double center = 0.5*(size-1);
+    const double innerRadius = size/8.0;
+    const double outerRadius = 3*size/8.0;
+    const double axial = 1.7e-3;
+    const double radial = 0.3e-3;
+    const double isotropic = 0.7e-3;
+
+    itk::ImageRegionIteratorWithIndex< ItkTensorImage > it(image, image->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+        double x = it.GetIndex()[0]-center;
+        double y = it.GetIndex()[1]-center;
+        double r = std::sqrt(x*x + y*y);
+
+        itk::DiffusionTensor3D<float> tensor;
+        tensor.Fill(0.0);
+        if (r>=innerRadius && r<=outerRadius)
+        {
+            // D = radial*I + (axial-radial)*t*t^T with the ring tangent t
+            double t[3] = { -y/r, x/r, 0 };
+            int c = 0;
+            for (int i=0; i<3; i++)
+                for (int j=i; j<3; j++)
+                    tensor[c++] = (axial-radial)*t[i]*t[j] + (i==j ? radial : 0);
+        }
+        else
+        {
+            tensor[0] = isotropic;
+            tensor[3] = isotropic;
+            tensor[5] = isotropic;
+        }
+        it.Set(tensor);
+    }
+    return image;
+}
+
+int main(int argc, char* argv[])
+{
+    mitkCommandLineParser parser;
+    parser.setArgumentPrefix("--", "-");
+
+    parser.setTitle("Streamline Tracking Benchmark");
+    parser.setCategory("Benchmarks");
+    parser.setContributor("MBI");
+    parser.setDescription("Measures the throughput of the deterministic streamline tractography on a synthetic tensor phantom.");
+
+    parser.addArgument("help", "h", mitkCommandLineParser::Bool, "Show this help text");
+    parser.addArgument("size", "s", mitkCommandLineParser::Int, "Size:", "Edge length of the phantom in voxels (default: 64)", us::Any());
+    parser.addArgument("seeds", "n", mitkCommandLineParser::Int, "Seeds per voxel:", "Number of seeds per voxel (default: 1)", us::Any());
+    parser.addArgument("threads", "t", mitkCommandLineParser::Int, "Threads:", "Number of tracking threads (default: ITK default)", us::Any());
+    parser.addArgument("interpolate", "ip", mitkCommandLineParser::Bool, "Interpolate:", "Use trilinear interpolation", us::Any());
+    parser.addArgument("repetitions", "r", mitkCommandLineParser::Int, "Repetitions:", "Number of timed tracking runs (default: 3)", us::Any());
+    parser.addArgument("csv", "c", mitkCommandLineParser::OutputFile, "CSV:", "Append the results as a line to this file", us::Any());
+
+    std::map<std::string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
+    if (parsedArgs.count("help") || parsedArgs.count("h"))
+    {
+        std::cout << parser.helpText();
+        return EXIT_SUCCESS;
+    }
+
+    int size = 64;
+    if (parsedArgs.count("size"))
+        size = us::any_cast<int>(parsedArgs["size"]);
+    int seedsPerVoxel = 1;
+    if (parsedArgs.count("seeds"))
+        seedsPerVoxel = us::any_cast<int>(parsedArgs["seeds"]);
+    int threads = 0;
+    if (parsedArgs.count("threads"))
+        threads = us::any_cast<int>(parsedArgs["threads"]);
+    bool interpolate = false;
+    if (parsedArgs.count("interpolate"))
+        interpolate = us::any_cast<bool>(parsedArgs["interpolate"]);
+    int repetitions = 3;
+    if (parsedArgs.count("repetitions"))
+        repetitions = us::any_cast<int>(parsedArgs["repetitions"]);
+
+    if (size<8 || seedsPerVoxel<1 || repetitions<1 || threads<0)
+    {
+        std::cout << "Invalid parameters, see --help." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::cout << "Creating phantom with " << size << "^3 voxels ..." << std::endl;
+        ItkTensorImage::Pointer phantom = CreateRingPhantom(size);
+
+        std::vector<double> seconds;
+        vtkIdType numFibers = 0;
+        vtkIdType numPoints = 0;
+        int numThreads = 0;
+        for (int r=0; r<repetitions; r++)
+        {
+            FilterType::Pointer filter = FilterType::New();
+            filter->SetInput(phantom);
+            filter->SetSeedsPerVoxel(seedsPerVoxel);
+            filter->SetFaThreshold(0.2);
+            filter->SetMinCurvatureRadius(-1);
+            filter->SetStepSize(-1);
+            filter->SetInterpolate(interpolate);
+            filter->SetMinTractLength(0);
+            if (threads>0)
+                filter->SetNumberOfThreads(threads);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            filter->Update();
+            std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+            seconds.push_back(std::chrono::duration<double>(stop-start).count());
+
+            numFibers = filter->GetFiberPolyData()->GetNumberOfLines();
+            numPoints = filter->GetFiberPolyData()->GetNumberOfPoints();
+            numThreads = filter->GetNumberOfThreads();
+        }
+
+        std::sort(seconds.begin(), seconds.end());
+        double median = seconds[seconds.size()/2];
+        double fibersPerSecond = numFibers/median;
+        double pointsPerSecond = numPoints/median;
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Threads:        " << numThreads << std::endl;
+        std::cout << "Fibers:         " << numFibers << std::endl;
+        std::cout << "Points:         " << numPoints << std::endl;
+        std::cout << "Time (median):  " << median << " s (min " << seconds.front() << " s, max " << seconds.back() << " s)" << std::endl;
+        std::cout << "Fibers/s:       " << fibersPerSecond << std::endl;
+        std::cout << "Points/s:       " << pointsPerSecond << std::endl;
+
+        if (parsedArgs.count("csv"))
+        {
+            std::string csvFileName = us::any_cast<std::string>(parsedArgs["csv"]);
+            bool writeHeader = !std::ifstream(csvFileName.c_str()).good();
+            std::ofstream csv(csvFileName.c_str(), std::ios::app);
+            if (writeHeader)
+                csv << "size;seeds;threads;interpolate;fibers;points;seconds;fibers/s;points/s" << std::endl;
+            csv << size << ";" << seedsPerVoxel << ";" << numThreads << ";" << interpolate << ";" << numFibers << ";" << numPoints
+                << ";" << median << ";" << fibersPerSecond << ";" << pointsPerSecond << std::endl;
+        }
+    }
+    catch (itk::ExceptionObject& e)
+    {
+        std::cout << e;
+        return EXIT_FAILURE;
+    }
+    catch (std::exception& e)
+    {
+        std::cout << e.what();
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -55,6 +55,17 @@ void mitk::NavigationDataDisplacementFilter::GenerateData()
 }
 
 
+void mitk::NavigationDataDisplacementFilter::ProcessPoseBatch(unsigned int /*toolIndex*/, PoseBatch& batch)
+{
+  const mitk::Vector3D offset = m_Offset;
+  for (std::size_t i = 0; i < batch.Size(); ++i)
+  {
+    if (batch.m_DataValid[i])
+      batch.m_Positions[i] = batch.m_Positions[i] + offset;
+  }
+}
+
+
 void mitk::NavigationDataDisplacementFilter::SetParameters( const mitk::PropertyList* p )
 {
   if (p == NULL)
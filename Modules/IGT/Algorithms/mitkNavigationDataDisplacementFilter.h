@@ -59,6 +59,11 @@ namespace mitk
     */
     mitk::PropertyList::ConstPointer GetParameters() const override;
 
+    /**
+    *\brief Adds the offset to all valid positions of the batch, see NavigationDataToNavigationDataFilter::ProcessPoseBatch()
+    */
+    virtual void ProcessPoseBatch(unsigned int toolIndex, PoseBatch& batch) override;
+
   protected:
     NavigationDataDisplacementFilter();
     virtual ~NavigationDataDisplacementFilter();
@@ -186,7 +186,8 @@ void mitk::NavigationDataLandmarkTransformFilter::GenerateData()
 {
   this->CreateOutputsForAllInputs(); // make sure that we have the same number of outputs as inputs
 
-  TransformInitializerType::LandmarkPointType lPointIn, lPointOut;
+  const LandmarkTransformType::MatrixType matrix = m_LandmarkTransform->GetMatrix();
+  const LandmarkTransformType::OutputVectorType offset = m_LandmarkTransform->GetOffset();
 
   /* update outputs with tracking data from tools */
   for (unsigned int i = 0; i < this->GetNumberOfOutputs() ; ++i)
@@ -206,36 +207,60 @@ void mitk::NavigationDataLandmarkTransformFilter::GenerateData()
     if (this->IsInitialized() == false) // as long as there is no valid transformation matrix, only graft the outputs
       continue;
 
-    mitk::NavigationData::PositionType tempCoordinate;
-    tempCoordinate = input->GetPosition();
-    lPointIn[0] = tempCoordinate[0]; // convert navigation data position to transform point
-    lPointIn[1] = tempCoordinate[1];
-    lPointIn[2] = tempCoordinate[2];
+    NavigationData::PositionType position = input->GetPosition();
+    NavigationData::OrientationType orientation = input->GetOrientation();
+    this->TransformPose(matrix, offset, position, orientation);
 
-    /* transform position */
-    lPointOut = m_LandmarkTransform->TransformPoint(lPointIn); // transform position
-    tempCoordinate[0] = lPointOut[0];  // convert back into navigation data position
-    tempCoordinate[1] = lPointOut[1];
-    tempCoordinate[2] = lPointOut[2];
-    output->SetPosition(tempCoordinate); // update output navigation data with new position
+    output->SetPosition(position); // update output navigation data with new position
+    output->SetOrientation(orientation); // update output navigation data with new orientation
+    output->SetDataValid(true); // operation was successful, therefore data of output is valid.
+  }
+}
 
-    /* transform orientation */
-    NavigationData::OrientationType  quatIn = input->GetOrientation();
-    vnl_quaternion<double> const vnlQuatIn(quatIn.x(), quatIn.y(), quatIn.z(), quatIn.r());  // convert orientation into vnl quaternion
-    m_QuatTransform->SetRotation(vnlQuatIn);  // convert orientation into transform
 
-    m_QuatLandmarkTransform->SetMatrix(m_LandmarkTransform->GetMatrix());
+void mitk::NavigationDataLandmarkTransformFilter::ProcessPoseBatch(unsigned int /*toolIndex*/, PoseBatch& batch)
+{
+  if (this->IsInitialized() == false)
+    return;
 
-    m_QuatLandmarkTransform->Compose(m_QuatTransform, true); // compose navigation data transform and landmark transform
+  const LandmarkTransformType::MatrixType matrix = m_LandmarkTransform->GetMatrix();
+  const LandmarkTransformType::OutputVectorType offset = m_LandmarkTransform->GetOffset();
 
-    vnl_quaternion<double> vnlQuatOut = m_QuatLandmarkTransform->GetRotation();  // convert composed transform back into a quaternion
-    NavigationData::OrientationType quatOut(vnlQuatOut[0], vnlQuatOut[1], vnlQuatOut[2], vnlQuatOut[3]); // convert back into navigation data orientation
-    output->SetOrientation(quatOut); // update output navigation data with new orientation
-    output->SetDataValid(true); // operation was successful, therefore data of output is valid.
+  for (std::size_t i = 0; i < batch.Size(); ++i)
+  {
+    if (batch.m_DataValid[i])
+      this->TransformPose(matrix, offset, batch.m_Positions[i], batch.m_Orientations[i]);
   }
 }
 
 
+void mitk::NavigationDataLandmarkTransformFilter::TransformPose(const LandmarkTransformType::MatrixType& matrix,
+  const LandmarkTransformType::OutputVectorType& offset, NavigationData::PositionType& position, NavigationData::OrientationType& orientation)
+{
+  TransformInitializerType::LandmarkPointType lPointIn, lPointOut;
+  lPointIn[0] = position[0]; // convert navigation data position to transform point
+  lPointIn[1] = position[1];
+  lPointIn[2] = position[2];
+
+  /* transform position, the same as m_LandmarkTransform->TransformPoint() without the virtual call */
+  lPointOut = matrix * lPointIn + offset;
+  position[0] = lPointOut[0];  // convert back into navigation data position
+  position[1] = lPointOut[1];
+  position[2] = lPointOut[2];
+
+  /* transform orientation */
+  vnl_quaternion<double> const vnlQuatIn(orientation.x(), orientation.y(), orientation.z(), orientation.r());  // convert orientation into vnl quaternion
+  m_QuatTransform->SetRotation(vnlQuatIn);  // convert orientation into transform
+
+  m_QuatLandmarkTransform->SetMatrix(matrix);
+
+  m_QuatLandmarkTransform->Compose(m_QuatTransform, true); // compose navigation data transform and landmark transform
+
+  vnl_quaternion<double> vnlQuatOut = m_QuatLandmarkTransform->GetRotation();  // convert composed transform back into a quaternion
+  orientation = NavigationData::OrientationType(vnlQuatOut[0], vnlQuatOut[1], vnlQuatOut[2], vnlQuatOut[3]); // convert back into navigation data orientation
+}
+
+
 bool mitk::NavigationDataLandmarkTransformFilter::IsInitialized() const
 {
   return (m_SourcePoints.size() >= 3) && (m_TargetPoints.size() >= 3);
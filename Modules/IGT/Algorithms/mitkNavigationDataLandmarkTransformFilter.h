@@ -115,6 +115,13 @@ namespace mitk {
 
     itkGetConstObjectMacro(LandmarkTransform, LandmarkTransformType);  ///< returns the current landmark transform
 
+    /**
+    *\brief Transforms all valid poses of the batch, see NavigationDataToNavigationDataFilter::ProcessPoseBatch()
+    *
+    * As long as the filter is not initialized, the poses stay unchanged.
+    */
+    virtual void ProcessPoseBatch(unsigned int toolIndex, PoseBatch& batch) override;
+
   protected:
     typedef itk::Image< signed short, 3>  ImageType;       // only because itk::LandmarkBasedTransformInitializer must be templated over two imagetypes
 
@@ -128,6 +135,14 @@ namespace mitk {
     NavigationDataLandmarkTransformFilter();
     virtual ~NavigationDataLandmarkTransformFilter();
 
+    /**
+    * \brief Applies the landmark transform, given by its matrix and offset, to one pose
+    *
+    * Used by GenerateData() and ProcessPoseBatch(), so that both give the same results.
+    */
+    void TransformPose(const LandmarkTransformType::MatrixType& matrix, const LandmarkTransformType::OutputVectorType& offset,
+      NavigationData::PositionType& position, NavigationData::OrientationType& orientation);
+
     /**
     * \brief transforms input NDs according to the calculated LandmarkTransform
     *
@@ -63,42 +63,59 @@ void mitk::NavigationDataSmoothingFilter::GenerateData()
   }
 }
 
-void mitk::NavigationDataSmoothingFilter::InitializeLastValuesList()
+void mitk::NavigationDataSmoothingFilter::ProcessPoseBatch(unsigned int toolIndex, PoseBatch& batch)
 {
-  m_LastValuesList = std::map< int, std::map< int , mitk::Point3D> >();
+  // the history of inputs which were not updated yet starts with zeros, as in InitializeLastValuesList()
+  if ( m_LastValuesList.size() <= toolIndex )
+  {
+    mitk::Point3D emptyPoint;
+    emptyPoint.Fill(0);
+    m_LastValuesList.resize(toolIndex + 1, std::vector<mitk::Point3D>(m_NumerOfValues, emptyPoint));
+  }
 
-  for ( unsigned int i = 0; i < this->GetNumberOfOutputs(); ++i )
+  // like GenerateData(), the positions of invalid navigation datas are smoothed as well
+  for (std::size_t i = 0; i < batch.Size(); ++i)
   {
-    std::map<int,mitk::Point3D> currentList;
-    for ( int j = 0; j < m_NumerOfValues; ++j )
-    {
-      mitk::Point3D emptyPoint;
-      emptyPoint.Fill(0);
-      currentList.insert(std::pair<int, mitk::Point3D>(j, emptyPoint));
-    }
-    m_LastValuesList.insert(std::pair<int, std::map<int,mitk::Point3D> > (i,currentList));
+    this->AddValue(toolIndex, batch.m_Positions[i]);
+    batch.m_Positions[i] = this->GetMean(toolIndex);
   }
 }
 
+void mitk::NavigationDataSmoothingFilter::InitializeLastValuesList()
+{
+  mitk::Point3D emptyPoint;
+  emptyPoint.Fill(0);
+  m_LastValuesList.assign(this->GetNumberOfOutputs(), std::vector<mitk::Point3D>(m_NumerOfValues, emptyPoint));
+}
+
 void mitk::NavigationDataSmoothingFilter::AddValue(int outputID, mitk::Point3D value)
 {
-  for (int i = 1; i < m_NumerOfValues; ++i)
+  std::vector<mitk::Point3D>& lastValues = m_LastValuesList[outputID];
+  if ( static_cast<int>(lastValues.size()) != m_NumerOfValues )
   {
-    m_LastValuesList[outputID][i-1] = m_LastValuesList[outputID][i];
+    // the number of values was changed, start again
+    mitk::Point3D emptyPoint;
+    emptyPoint.Fill(0);
+    lastValues.assign(m_NumerOfValues, emptyPoint);
   }
 
-  m_LastValuesList[outputID][m_NumerOfValues-1] = value;
+  for (int i = 1; i < m_NumerOfValues; ++i)
+  {
+    lastValues[i-1] = lastValues[i];
+  }
+  lastValues[m_NumerOfValues-1] = value;
 }
 
 mitk::Point3D mitk::NavigationDataSmoothingFilter::GetMean(int outputID)
 {
+  const std::vector<mitk::Point3D>& lastValues = m_LastValuesList[outputID];
   mitk::Point3D mean;
   mean.Fill(0);
   for (int i=0; i<m_NumerOfValues; i++)
   {
-    mean[0] += m_LastValuesList[outputID][i][0];
-    mean[1] += m_LastValuesList[outputID][i][1];
-    mean[2] += m_LastValuesList[outputID][i][2];
+    mean[0] += lastValues[i][0];
+    mean[1] += lastValues[i][1];
+    mean[2] += lastValues[i][2];
   }
   mean[0] /= m_NumerOfValues;
   mean[1] /= m_NumerOfValues;
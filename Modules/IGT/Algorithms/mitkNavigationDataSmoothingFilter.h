@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkNavigationDataToNavigationDataFilter.h>
 #include "MitkIGTExports.h"
 
+#include <vector>
+
 
 namespace mitk {
 
@@ -42,13 +44,20 @@ namespace mitk {
      */
     itkSetMacro(NumerOfValues,int);
 
+    /**
+    * @brief Smoothes the batch as if its positions were the input with index toolIndex at
+    *        consecutive updates, see NavigationDataToNavigationDataFilter::ProcessPoseBatch()
+    */
+    virtual void ProcessPoseBatch(unsigned int toolIndex, PoseBatch& batch) override;
+
   protected:
     NavigationDataSmoothingFilter();
     virtual ~NavigationDataSmoothingFilter();
 
     virtual void GenerateData() override;
 
-    std::map< int, std::map< int , mitk::Point3D> > m_LastValuesList;
+    /** @brief The last m_NumerOfValues positions of each input, the oldest first */
+    std::vector< std::vector<mitk::Point3D> > m_LastValuesList;
 
     int m_NumerOfValues;
 
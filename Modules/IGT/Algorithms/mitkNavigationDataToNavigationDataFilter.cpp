@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkNavigationDataToNavigationDataFilter.h"
+#include "mitkIGTException.h"
 
 
 mitk::NavigationDataToNavigationDataFilter::NavigationDataToNavigationDataFilter()
@@ -109,3 +110,56 @@ void mitk::NavigationDataToNavigationDataFilter::CreateOutputsForAllInputs()
   if(isModified)
     this->Modified();
 }
+
+
+void mitk::NavigationDataToNavigationDataFilter::ProcessPoseBatch(unsigned int /*toolIndex*/, PoseBatch& /*batch*/)
+{
+  mitkThrowException(mitk::IGTException) << this->GetNameOfClass() << " does not support batch processing.";
+}
+
+
+mitk::NavigationDataSet::Pointer mitk::NavigationDataToNavigationDataFilter::ProcessNavigationDataSet(const mitk::NavigationDataSet* navigationDataSet)
+{
+  if (navigationDataSet == NULL)
+  {
+    mitkThrowException(mitk::IGTException) << "Cannot process a null navigation data set.";
+  }
+
+  const unsigned int numberOfTools = navigationDataSet->GetNumberOfTools();
+  const unsigned int numberOfTimeSteps = navigationDataSet->Size();
+
+  // one navigation data per tool is reused for all time steps
+  std::vector<mitk::NavigationData::Pointer> navigationDatas;
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; ++toolIndex)
+    navigationDatas.push_back(mitk::NavigationData::New());
+
+  std::vector<PoseBatch> batches(numberOfTools);
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; ++toolIndex)
+  {
+    PoseBatch& batch = batches[toolIndex];
+    batch.Resize(numberOfTimeSteps);
+    for (unsigned int index = 0; index < numberOfTimeSteps; ++index)
+    {
+      navigationDataSet->CopyNavigationDataForIndex(index, toolIndex, navigationDatas[toolIndex]);
+      batch.m_Positions[index] = navigationDatas[toolIndex]->GetPosition();
+      batch.m_Orientations[index] = navigationDatas[toolIndex]->GetOrientation();
+      batch.m_DataValid[index] = navigationDatas[toolIndex]->IsDataValid();
+    }
+    this->ProcessPoseBatch(toolIndex, batch);
+  }
+
+  mitk::NavigationDataSet::Pointer result = mitk::NavigationDataSet::New(numberOfTools);
+  result->Reserve(numberOfTimeSteps);
+  for (unsigned int index = 0; index < numberOfTimeSteps; ++index)
+  {
+    for (unsigned int toolIndex = 0; toolIndex < numberOfTools; ++toolIndex)
+    {
+      navigationDataSet->CopyNavigationDataForIndex(index, toolIndex, navigationDatas[toolIndex]);
+      navigationDatas[toolIndex]->SetPosition(batches[toolIndex].m_Positions[index]);
+      navigationDatas[toolIndex]->SetOrientation(batches[toolIndex].m_Orientations[index]);
+      navigationDatas[toolIndex]->SetDataValid(batches[toolIndex].m_DataValid[index] != 0);
+    }
+    result->AddNavigationDatas(navigationDatas);
+  }
+  return result;
+}
@@ -19,6 +19,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define MITKNNAVIGATIONDATATONAVIGATIONDATAFILTER_H_HEADER_INCLUDED_
 
 #include <mitkNavigationDataSource.h>
+#include <mitkNavigationDataSet.h>
+
+#include <vector>
 
 namespace mitk
 {
@@ -31,6 +34,11 @@ namespace mitk
   * and produce NavigationData objects as output.
   * This class defines the input-interface for NavigationDataFilters.
   *
+  * Besides the pipeline, filters may support batch processing: ProcessPoseBatch() applies the
+  * filter to the poses of one input at many time steps, stored in contiguous arrays, and
+  * ProcessNavigationDataSet() applies it to a whole recording. Each pose of a batch gets
+  * exactly the same result as from Update() with that pose as input.
+  *
   * \ingroup IGT
   */
   class MITKIGT_EXPORT NavigationDataToNavigationDataFilter : public NavigationDataSource
@@ -93,6 +101,48 @@ namespace mitk
   */
   virtual void ConnectTo(mitk::NavigationDataSource * UpstreamFilter);
 
+    /**
+    * \brief Poses of one tool at a sequence of time steps, stored column by column.
+    */
+    struct PoseBatch
+    {
+      std::vector<NavigationData::PositionType> m_Positions;
+      std::vector<NavigationData::OrientationType> m_Orientations;
+      std::vector<unsigned char> m_DataValid; ///< 0 if the pose of the time step is not valid
+
+      std::size_t Size() const { return m_Positions.size(); }
+
+      void Resize(std::size_t size)
+      {
+        m_Positions.resize(size);
+        m_Orientations.resize(size);
+        m_DataValid.resize(size);
+      }
+    };
+
+    /**
+    * \brief Filters the poses of a batch in place, as if they were the inputs with index toolIndex at consecutive Update() calls.
+    *
+    * The result of each pose is bit-identical to the output of Update(). Filters that keep
+    * state from one time step to the next, like mitk::NavigationDataSmoothingFilter, continue
+    * with the state of the given input and leave it as Update() would. Poses which Update()
+    * does not compute, like invalid poses in the transform filters, stay unchanged. The inputs
+    * of the filter do not have to be set.
+    *
+    * \throw mitk::IGTException if the filter does not support batch processing, which is the default.
+    */
+    virtual void ProcessPoseBatch(unsigned int toolIndex, PoseBatch& batch);
+
+    /**
+    * \brief Applies the filter to all time steps of the set, tool i is treated as input i.
+    *
+    * The returned set contains the filtered poses and validity, all other values are
+    * copied from the given set.
+    *
+    * \throw mitk::IGTException if the filter does not support batch processing.
+    */
+    mitk::NavigationDataSet::Pointer ProcessNavigationDataSet(const mitk::NavigationDataSet* navigationDataSet);
+
   protected:
     NavigationDataToNavigationDataFilter();
     virtual ~NavigationDataToNavigationDataFilter();
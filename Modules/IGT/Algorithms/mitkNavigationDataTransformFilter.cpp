@@ -30,6 +30,51 @@ mitk::NavigationDataTransformFilter::~NavigationDataTransformFilter()
   m_Rigid3DTransform = NULL;
 }
 
+namespace
+{
+  typedef mitk::NavigationDataTransformFilter::TransformType TransformType;
+
+  /**
+  * Composes the pose with the transform given by matrix and offset. This is what
+  * TransformType::Compose() does, but without creating a transform for every pose.
+  * Used for single navigation datas and batches, so that both give the same results.
+  */
+  inline void ComposePose(const TransformType::MatrixType& matrix, const TransformType::OutputVectorType& offset, bool precompose,
+    mitk::NavigationData::PositionType& position, mitk::NavigationData::OrientationType& orientation)
+  {
+    // Cast the input NavigationData to double precision
+    TransformType::OutputVectorType pInD;
+    mitk::FillVector3D(pInD, position[0], position[1], position[2]);
+    TransformType::VersorType oInD;
+    oInD.Set(orientation.x(), orientation.y(), orientation.z(), orientation.r());
+
+    // The rotation and the position define the Tip-to-World coordinate frame
+    // transformation ("World" is used in the generic sense)
+    const TransformType::MatrixType mInD = oInD.GetMatrix();
+
+    TransformType::OutputVectorType pOutD;
+    TransformType::MatrixType mOutD;
+    if (precompose)
+    {
+      // The resulting transform is UserTip-to-World
+      pOutD = mInD * offset + pInD;
+      mOutD = mInD * matrix;
+    }
+    else
+    {
+      // The resulting transform is Tip-to-UserWorld
+      pOutD = matrix * pInD + offset;
+      mOutD = matrix * mInD;
+    }
+    TransformType::VersorType oOutD;
+    oOutD.Set(mOutD);
+
+    // Cast to transformed NavigationData back to mitk::ScalarType
+    orientation = mitk::NavigationData::OrientationType(oOutD.GetX(), oOutD.GetY(), oOutD.GetZ(), oOutD.GetW());
+    mitk::FillVector3D(position, pOutD[0], pOutD[1], pOutD[2]);
+  }
+}
+
 void mitk::NavigationDataTransformFilter::GenerateData()
 {
 
@@ -43,6 +88,9 @@ void mitk::NavigationDataTransformFilter::GenerateData()
   {
     this->CreateOutputsForAllInputs(); // make sure that we have the same number of outputs as inputs
 
+    const TransformType::MatrixType matrix = m_Rigid3DTransform->GetMatrix();
+    const TransformType::OutputVectorType offset = m_Rigid3DTransform->GetOffset();
+
     /* update outputs with tracking data from tools */
     for (unsigned int i = 0; i < this->GetNumberOfIndexedOutputs() ; ++i)
     {
@@ -57,37 +105,30 @@ void mitk::NavigationDataTransformFilter::GenerateData()
         continue;
       }
 
-      // Get input position/orientation as float numbers
-      const NavigationData::PositionType    pInF = input->GetPosition();
-      const NavigationData::OrientationType oInF = input->GetOrientation();
-
-      // Cast the input NavigationData to double precision
-      TransformType::OutputVectorType pInD;
-      FillVector3D(pInD, pInF[0], pInF[1], pInF[2]);
-      TransformType::VersorType oInD;
-      oInD.Set(oInF.x(), oInF.y(), oInF.z(), oInF.r());
-
-      TransformType::Pointer composedTransform = TransformType::New();
-      // SetRotation+SetOffset defines the Tip-to-World coordinate frame
-      // transformation ("World" is used in the generic sense)
-      composedTransform->SetRotation(oInD);
-      composedTransform->SetOffset(pInD);
-      // If !m_Precompose: The resulting transform is Tip-to-UserWorld
-      // If m_Precompose:  The resulting transform is UserTip-to-World
-      composedTransform->Compose(m_Rigid3DTransform, m_Precompose);
-
-      // Transformed position/orientation as double numbers
-      const TransformType::OutputVectorType  pOutD = composedTransform->GetOffset();
-      const TransformType::VersorType        oOutD = composedTransform->GetVersor();
-
-      // Cast to transformed NavigationData back to float precision
-      NavigationData::OrientationType oOutF(oOutD.GetX(), oOutD.GetY(), oOutD.GetZ(), oOutD.GetW());
-      NavigationData::PositionType pOutF;
-      FillVector3D(pOutF, pOutD[0], pOutD[1], pOutD[2]);
-
-      output->SetOrientation(oOutF);
-      output->SetPosition(pOutF);
+      NavigationData::PositionType position = input->GetPosition();
+      NavigationData::OrientationType orientation = input->GetOrientation();
+      ComposePose(matrix, offset, m_Precompose, position, orientation);
+
+      output->SetOrientation(orientation);
+      output->SetPosition(position);
       output->SetDataValid(true); // operation was successful, therefore data of output is valid.
     }
   }
 }
+
+void mitk::NavigationDataTransformFilter::ProcessPoseBatch(unsigned int /*toolIndex*/, PoseBatch& batch)
+{
+  if(m_Rigid3DTransform.IsNull())
+  {
+    itkExceptionMacro("Invalid parameter: Transform was not set!  Use SetRigid3DTransform() before processing a batch.");
+  }
+
+  const TransformType::MatrixType matrix = m_Rigid3DTransform->GetMatrix();
+  const TransformType::OutputVectorType offset = m_Rigid3DTransform->GetOffset();
+
+  for (std::size_t i = 0; i < batch.Size(); ++i)
+  {
+    if (batch.m_DataValid[i])
+      ComposePose(matrix, offset, m_Precompose, batch.m_Positions[i], batch.m_Orientations[i]);
+  }
+}
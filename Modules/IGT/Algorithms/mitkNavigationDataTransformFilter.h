@@ -69,6 +69,11 @@ namespace mitk {
     itkGetMacro(Precompose, bool);
     itkBooleanMacro(Precompose);
 
+    /**Documentation
+    * \brief Transforms all valid poses of the batch, see NavigationDataToNavigationDataFilter::ProcessPoseBatch()
+    */
+    virtual void ProcessPoseBatch(unsigned int toolIndex, PoseBatch& batch) override;
+
   protected:
 
     NavigationDataTransformFilter();
@@ -0,0 +1,341 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkCommandLineParser.h"
+
+#include <mitkVirtualTrackingDevice.h>
+#include <mitkTrackingDeviceSource.h>
+#include <mitkNavigationDataLandmarkTransformFilter.h>
+#include <mitkNavigationDataTransformFilter.h>
+#include <mitkNavigationDataSmoothingFilter.h>
+#include <mitkNavigationDataObjectVisualizationFilter.h>
+#include <mitkNavigationDataRecorder.h>
+#include <mitkIGTTimeStamp.h>
+#include <mitkIGTException.h>
+#include <mitkPointSet.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/**
+* Benchmark of the IGT pipeline: a mitk::VirtualTrackingDevice generates poses of several tools at a
+* high rate, which pass through mitk::TrackingDeviceSource, a landmark registration, a tool calibration,
+* smoothing, mitk::NavigationDataObjectVisualizationFilter and mitk::NavigationDataRecorder. The
+* pipeline is updated for every new sample of the device and the latencies are reported as percentiles.
+*/
+
+namespace
+{
+  /** Summary of a series of measurements, all values in ms */
+  struct Statistics
+  {
+    Statistics() : m_Count(0), m_Min(0), m_P50(0), m_P90(0), m_P99(0), m_P999(0), m_Max(0) {}
+
+    std::size_t m_Count;
+    double m_Min;
+    double m_P50;
+    double m_P90;
+    double m_P99;
+    double m_P999;
+    double m_Max;
+  };
+
+  /** Nearest rank percentile of sorted values */
+  double Percentile(const std::vector<double>& sortedValues, double percent)
+  {
+    std::size_t rank = static_cast<std::size_t>(std::ceil(percent / 100.0 * sortedValues.size()));
+    return sortedValues[std::max<std::size_t>(rank, 1) - 1];
+  }
+
+  Statistics ComputeStatistics(std::vector<double>& values)
+  {
+    Statistics statistics;
+    if (values.empty())
+      return statistics;
+
+    std::sort(values.begin(), values.end());
+    statistics.m_Count = values.size();
+    statistics.m_Min = values.front();
+    statistics.m_P50 = Percentile(values, 50.0);
+    statistics.m_P90 = Percentile(values, 90.0);
+    statistics.m_P99 = Percentile(values, 99.0);
+    statistics.m_P999 = Percentile(values, 99.9);
+    statistics.m_Max = values.back();
+    return statistics;
+  }
+
+  void PrintStatistics(const std::string& name, const Statistics& statistics)
+  {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+      << std::setw(10) << statistics.m_Count
+      << std::setw(10) << statistics.m_Min
+      << std::setw(10) << statistics.m_P50
+      << std::setw(10) << statistics.m_P90
+      << std::setw(10) << statistics.m_P99
+      << std::setw(10) << statistics.m_P999
+      << std::setw(10) << statistics.m_Max << std::endl;
+  }
+
+  void WriteStatistics(std::ostream& stream, const Statistics& statistics)
+  {
+    stream << ";" << statistics.m_P50 << ";" << statistics.m_P90 << ";" << statistics.m_P99
+      << ";" << statistics.m_P999 << ";" << statistics.m_Max;
+  }
+
+  mitk::PointSet::Pointer CreatePointSet(double offset)
+  {
+    mitk::PointSet::Pointer pointSet = mitk::PointSet::New();
+    mitk::Point3D point;
+    mitk::FillVector3D(point, 10.0 + offset, 0.0, 0.0);
+    pointSet->SetPoint(0, point);
+    mitk::FillVector3D(point, 0.0, 20.0 + offset, 0.0);
+    pointSet->SetPoint(1, point);
+    mitk::FillVector3D(point, 0.0, 0.0, 30.0 + offset);
+    pointSet->SetPoint(2, point);
+    mitk::FillVector3D(point, 5.0, 5.0 + offset, 5.0);
+    pointSet->SetPoint(3, point);
+    return pointSet;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  mitkCommandLineParser parser;
+  parser.setArgumentPrefix("--", "-");
+
+  parser.setTitle("IGT Pipeline Benchmark");
+  parser.setCategory("Benchmarks");
+  parser.setContributor("MBI");
+  parser.setDescription("Measures latency and throughput of the IGT pipeline with a simulated high-rate tracking device.");
+
+  parser.addArgument("help", "h", mitkCommandLineParser::Bool, "Show this help text");
+  parser.addArgument("tools", "n", mitkCommandLineParser::Int, "Tools:", "Number of simulated tools (default: 4)", us::Any());
+  parser.addArgument("rate", "r", mitkCommandLineParser::Float, "Rate:", "Updates of the tracking device per second (default: 1000)", us::Any());
+  parser.addArgument("duration", "d", mitkCommandLineParser::Float, "Duration:", "Duration of the measurement in s (default: 10)", us::Any());
+  parser.addArgument("jitter", "j", mitkCommandLineParser::Float, "Jitter:", "Maximum random delay of a device update in ms (default: 0)", us::Any());
+  parser.addArgument("dropout", "p", mitkCommandLineParser::Float, "Dropout:", "Probability that a tool is invalid at an update (default: 0)", us::Any());
+  parser.addArgument("record", "o", mitkCommandLineParser::OutputFile, "Recording:", "Stream the recording to this file instead of keeping it in memory", us::Any());
+  parser.addArgument("csv", "c", mitkCommandLineParser::OutputFile, "CSV:", "Append the results as a line to this file", us::Any());
+  parser.addArgument("max-p99", "m", mitkCommandLineParser::Float, "Maximum p99 latency:", "Fail if the 99th percentile of the end-to-end latency in ms is higher", us::Any());
+
+  std::map<std::string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
+  if (parsedArgs.count("help") || parsedArgs.count("h"))
+  {
+    std::cout << parser.helpText();
+    return EXIT_SUCCESS;
+  }
+
+  int numberOfTools = 4;
+  if (parsedArgs.count("tools"))
+    numberOfTools = us::any_cast<int>(parsedArgs["tools"]);
+  float rate = 1000;
+  if (parsedArgs.count("rate"))
+    rate = us::any_cast<float>(parsedArgs["rate"]);
+  float duration = 10;
+  if (parsedArgs.count("duration"))
+    duration = us::any_cast<float>(parsedArgs["duration"]);
+  float jitter = 0;
+  if (parsedArgs.count("jitter"))
+    jitter = us::any_cast<float>(parsedArgs["jitter"]);
+  float dropout = 0;
+  if (parsedArgs.count("dropout"))
+    dropout = us::any_cast<float>(parsedArgs["dropout"]);
+
+  if (numberOfTools < 1 || rate <= 0 || duration <= 0)
+  {
+    MITK_ERROR << "The number of tools, the rate and the duration have to be positive.";
+    return EXIT_FAILURE;
+  }
+
+  try
+  {
+    /* tracking device */
+    mitk::VirtualTrackingDevice::Pointer device = mitk::VirtualTrackingDevice::New();
+    for (int i = 0; i < numberOfTools; ++i)
+    {
+      std::stringstream name;
+      name << "Tool" << i;
+      device->AddTool(name.str().c_str());
+    }
+    device->SetUpdateFrequency(rate);
+    device->SetJitter(jitter);
+    device->SetDropoutProbability(dropout);
+
+    /* pipeline */
+    mitk::TrackingDeviceSource::Pointer source = mitk::TrackingDeviceSource::New();
+    source->SetTrackingDevice(device);
+
+    mitk::NavigationDataLandmarkTransformFilter::Pointer registration = mitk::NavigationDataLandmarkTransformFilter::New();
+    registration->SetSourceLandmarks(CreatePointSet(0.0));
+    registration->SetTargetLandmarks(CreatePointSet(2.5));
+    registration->ConnectTo(source);
+
+    mitk::NavigationDataTransformFilter::TransformType::Pointer toolTip = mitk::NavigationDataTransformFilter::TransformType::New();
+    mitk::NavigationDataTransformFilter::TransformType::OutputVectorType tipOffset;
+    tipOffset[0] = 0.0; tipOffset[1] = 0.0; tipOffset[2] = 150.0;
+    toolTip->SetTranslation(tipOffset);
+    mitk::NavigationDataTransformFilter::Pointer calibration = mitk::NavigationDataTransformFilter::New();
+    calibration->SetRigid3DTransform(toolTip);
+    calibration->PrecomposeOn();
+    calibration->ConnectTo(registration);
+
+    mitk::NavigationDataSmoothingFilter::Pointer smoothing = mitk::NavigationDataSmoothingFilter::New();
+    smoothing->ConnectTo(calibration);
+
+    mitk::NavigationDataObjectVisualizationFilter::Pointer visualization = mitk::NavigationDataObjectVisualizationFilter::New();
+    visualization->ConnectTo(smoothing);
+    for (int i = 0; i < numberOfTools; ++i)
+      visualization->SetRepresentationObject(i, mitk::PointSet::New());
+
+    mitk::NavigationDataRecorder::Pointer recorder = mitk::NavigationDataRecorder::New();
+    if (parsedArgs.count("record"))
+      recorder->SetStreamingFileName(us::any_cast<std::string>(parsedArgs["record"]));
+    recorder->ConnectTo(visualization);
+
+    /* measurement */
+    const std::size_t expectedUpdates = static_cast<std::size_t>(rate * duration * 1.1);
+    std::vector<double> endToEndLatencies, sourceLatencies, updateDurations;
+    endToEndLatencies.reserve(expectedUpdates * numberOfTools);
+    sourceLatencies.reserve(expectedUpdates * numberOfTools);
+    updateDurations.reserve(expectedUpdates);
+    unsigned long long skippedSamples = 0;
+    unsigned long long invalidOutputs = 0;
+
+    source->Connect();
+    source->StartTracking();
+    recorder->StartRecording();
+
+    const mitk::TrackingSampleBuffer* sampleBuffer = device->GetTool(0)->GetSampleBuffer();
+    const unsigned long long firstSample = sampleBuffer->GetNumberOfPublishedSamples();
+    unsigned long long lastSample = firstSample;
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+    while (Clock::now() < end)
+    {
+      // update the pipeline once for every sample of the device
+      const unsigned long long publishedSamples = sampleBuffer->GetNumberOfPublishedSamples();
+      if (publishedSamples == lastSample)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      if (lastSample != firstSample)
+        skippedSamples += publishedSamples - lastSample - 1;
+      lastSample = publishedSamples;
+
+      const Clock::time_point updateStart = Clock::now();
+      recorder->Update();
+      const Clock::time_point updateEnd = Clock::now();
+      updateDurations.push_back(std::chrono::duration<double, std::milli>(updateEnd - updateStart).count());
+
+      const double now = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+      for (int i = 0; i < numberOfTools; ++i)
+      {
+        const mitk::NavigationData* output = recorder->GetOutput(i);
+        if (!output->IsDataValid())
+        {
+          ++invalidOutputs;
+          continue;
+        }
+        endToEndLatencies.push_back(now - output->GetIGTTimeStamp());
+        sourceLatencies.push_back(source->GetLatency(i));
+      }
+    }
+    const double measuredDuration = std::chrono::duration<double>(Clock::now() - start).count();
+    const unsigned long long deviceSamples = sampleBuffer->GetNumberOfPublishedSamples() - firstSample;
+
+    recorder->StopRecording();
+    source->StopTracking();
+    source->Disconnect();
+
+    /* report */
+    const std::size_t numberOfUpdates = updateDurations.size();
+    Statistics endToEnd = ComputeStatistics(endToEndLatencies);
+    Statistics sourceLatency = ComputeStatistics(sourceLatencies);
+    Statistics update = ComputeStatistics(updateDurations);
+
+    std::cout << numberOfTools << " tools at " << rate << " Hz for " << measuredDuration << " s, jitter "
+      << jitter << " ms, dropout probability " << dropout << std::endl << std::endl;
+    std::cout << std::left << std::setw(28) << "[ms]" << std::right
+      << std::setw(10) << "count" << std::setw(10) << "min" << std::setw(10) << "p50" << std::setw(10) << "p90"
+      << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+    PrintStatistics("acquisition to source", sourceLatency);
+    PrintStatistics("pipeline update", update);
+    PrintStatistics("end-to-end latency", endToEnd);
+    std::cout << std::endl;
+    std::cout << "device samples per second:   " << deviceSamples / measuredDuration << std::endl;
+    std::cout << "pipeline updates per second: " << numberOfUpdates / measuredDuration << std::endl;
+    std::cout << "skipped device samples:      " << skippedSamples << std::endl;
+    std::cout << "invalid outputs:             " << invalidOutputs << std::endl;
+    std::cout << "recorded time steps:         " << recorder->GetNumberOfRecordedSteps() << std::endl;
+    std::cout << "dropped recorded time steps: " << recorder->GetNumberOfDroppedSteps() << std::endl;
+
+    if (parsedArgs.count("csv"))
+    {
+      const std::string csvFileName = us::any_cast<std::string>(parsedArgs["csv"]);
+      std::ifstream existingFile(csvFileName.c_str());
+      const bool writeHeader = !existingFile.good();
+      existingFile.close();
+
+      std::ofstream csv(csvFileName.c_str(), std::ios::app);
+      if (writeHeader)
+      {
+        csv << "tools;rate;jitter;dropout;device samples/s;updates/s;skipped;invalid"
+          << ";source p50;source p90;source p99;source p99.9;source max"
+          << ";update p50;update p90;update p99;update p99.9;update max"
+          << ";latency p50;latency p90;latency p99;latency p99.9;latency max" << std::endl;
+      }
+      csv << numberOfTools << ";" << rate << ";" << jitter << ";" << dropout << ";" << deviceSamples / measuredDuration
+        << ";" << numberOfUpdates / measuredDuration << ";" << skippedSamples << ";" << invalidOutputs;
+      WriteStatistics(csv, sourceLatency);
+      WriteStatistics(csv, update);
+      WriteStatistics(csv, endToEnd);
+      csv << std::endl;
+    }
+
+    if (parsedArgs.count("max-p99"))
+    {
+      const float maxP99 = us::any_cast<float>(parsedArgs["max-p99"]);
+      if (endToEnd.m_Count == 0 || endToEnd.m_P99 > maxP99)
+      {
+        MITK_ERROR << "The 99th percentile of the end-to-end latency (" << endToEnd.m_P99 << " ms) exceeds " << maxP99 << " ms.";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  catch (const mitk::Exception& e)
+  {
+    MITK_ERROR << e.GetDescription();
+    return EXIT_FAILURE;
+  }
+  catch (const std::exception& e)
+  {
+    MITK_ERROR << e.what();
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
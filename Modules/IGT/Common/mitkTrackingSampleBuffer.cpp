@@ -0,0 +1,115 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTrackingSampleBuffer.h"
+#include "mitkIGTException.h"
+
+
+mitk::TrackingSampleBuffer::TrackingSampleBuffer(unsigned int capacity)
+  : itk::Object(), m_Slots(capacity), m_Head(0)
+{
+  if (capacity == 0)
+  {
+    mitkThrowException(mitk::IGTException) << "The capacity of a TrackingSampleBuffer must not be 0.";
+  }
+}
+
+
+mitk::TrackingSampleBuffer::~TrackingSampleBuffer()
+{
+}
+
+
+void mitk::TrackingSampleBuffer::Push(const Sample& sample)
+{
+  // only the producer writes m_Head, so a relaxed load is sufficient
+  unsigned long long n = m_Head.load(std::memory_order_relaxed);
+  Slot& slot = m_Slots[n % m_Slots.size()];
+
+  slot.m_Sequence.store(2 * n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release); // mark the slot as being written before touching the data
+  slot.m_Sample = sample;
+  slot.m_Sample.m_SequenceNumber = n;
+  slot.m_Sequence.store(2 * n + 2, std::memory_order_release);
+
+  m_Head.store(n + 1, std::memory_order_release);
+}
+
+
+bool mitk::TrackingSampleBuffer::Read(unsigned long long n, Sample& sample) const
+{
+  const Slot& slot = m_Slots[n % m_Slots.size()];
+
+  unsigned long long before = slot.m_Sequence.load(std::memory_order_acquire);
+  if (before != 2 * n + 2) // being written or already overwritten by a newer sample
+    return false;
+
+  sample = slot.m_Sample;
+
+  std::atomic_thread_fence(std::memory_order_acquire); // the copy has to be complete before the sequence is checked again
+  return slot.m_Sequence.load(std::memory_order_relaxed) == before;
+}
+
+
+bool mitk::TrackingSampleBuffer::GetLatest(Sample& sample) const
+{
+  while (true)
+  {
+    unsigned long long head = m_Head.load(std::memory_order_acquire);
+    if (head == 0)
+      return false;
+    // can only fail if the producer went once around the whole buffer while copying, then try the new latest sample
+    if (this->Read(head - 1, sample))
+      return true;
+  }
+}
+
+
+unsigned long long mitk::TrackingSampleBuffer::GetPending(unsigned long long& cursor, SampleContainer& samples) const
+{
+  unsigned long long head = m_Head.load(std::memory_order_acquire);
+  unsigned long long dropped = 0;
+
+  if (cursor > head) // cursor of a different buffer or of a buffer that was replaced
+    cursor = head;
+  if (head - cursor > m_Slots.size())
+  {
+    dropped = head - m_Slots.size() - cursor;
+    cursor = head - m_Slots.size();
+  }
+
+  Sample sample;
+  for (; cursor < head; ++cursor)
+  {
+    if (this->Read(cursor, sample))
+      samples.push_back(sample);
+    else
+      ++dropped; // overwritten while reading the older samples
+  }
+  return dropped;
+}
+
+
+unsigned long long mitk::TrackingSampleBuffer::GetNumberOfPublishedSamples() const
+{
+  return m_Head.load(std::memory_order_acquire);
+}
+
+
+unsigned int mitk::TrackingSampleBuffer::GetCapacity() const
+{
+  return static_cast<unsigned int>(m_Slots.size());
+}
@@ -0,0 +1,107 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKTRACKINGSAMPLEBUFFER_H_HEADER_INCLUDED_
+#define MITKTRACKINGSAMPLEBUFFER_H_HEADER_INCLUDED_
+
+#include <MitkIGTExports.h>
+#include <mitkCommon.h>
+#include <mitkNumericTypes.h>
+#include <itkObject.h>
+
+#include <atomic>
+#include <vector>
+
+namespace mitk {
+
+  /**Documentation
+  * \brief Lock-free ring buffer that passes the poses of a tool from the tracking thread to the pipeline
+  *
+  * The tracking thread of a mitk::TrackingDevice is the only producer and calls Push() for every
+  * new pose of a tool. Any number of consumers (e.g. mitk::TrackingDeviceSource or filters that
+  * need every sample) read the latest sample with GetLatest() or all samples since their last call
+  * with GetPending(). Neither side ever blocks: each slot carries a sequence number that the
+  * producer makes odd while writing, a consumer copies the slot and discards the copy if the
+  * sequence number changed meanwhile. If a consumer is slower than the producer for more than
+  * GetCapacity() samples, the oldest samples are lost and reported as dropped.
+  *
+  * Each sample carries two time stamps of mitk::IGTTimeStamp (which is driven by
+  * mitk::RealTimeClock): the time of acquisition as set by the device and the time at which it
+  * was published. Consumers compare them to mitk::IGTTimeStamp::GetElapsed() to get the
+  * latency of the pipeline.
+  *
+  * \ingroup IGT
+  */
+  class MITKIGT_EXPORT TrackingSampleBuffer : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(TrackingSampleBuffer, itk::Object);
+    itkFactorylessNewMacro(Self)
+    mitkNewMacro1Param(Self, unsigned int)
+
+    /** \brief Pose of one tool at one point in time */
+    struct Sample
+    {
+      unsigned long long m_SequenceNumber;  ///< number of samples published before this one
+      Point3D m_Position;
+      Quaternion m_Orientation;
+      float m_TrackingError;
+      bool m_DataValid;
+      double m_IGTTimeStamp;                ///< time of acquisition in ms, as set by the tracking device
+      double m_PublishTimeStamp;            ///< time in ms at which the tracking thread published the sample
+    };
+    typedef std::vector<Sample> SampleContainer;
+
+    /** \brief Publishes a sample, may only be called by one thread (the tracking thread). */
+    void Push(const Sample& sample);
+
+    /** \brief Copies the most recent sample, returns false if no sample was published yet. */
+    bool GetLatest(Sample& sample) const;
+
+    /**
+    * \brief Appends all samples published since the given cursor to samples and advances the cursor.
+    *
+    * Start with a cursor of 0 to get all samples still in the buffer. Each consumer keeps its own cursor.
+    * \return the number of samples that were overwritten before they could be read
+    */
+    unsigned long long GetPending(unsigned long long& cursor, SampleContainer& samples) const;
+
+    /** \brief Returns the number of samples published so far, which is the cursor of the next sample. */
+    unsigned long long GetNumberOfPublishedSamples() const;
+
+    /** \brief Returns the number of samples that can be kept. */
+    unsigned int GetCapacity() const;
+
+  protected:
+    TrackingSampleBuffer(unsigned int capacity = 256);
+    virtual ~TrackingSampleBuffer();
+
+    /** \brief Copies sample number n if it is still in the buffer and was not modified while copying. */
+    bool Read(unsigned long long n, Sample& sample) const;
+
+    struct Slot
+    {
+      Slot() : m_Sequence(0) {}
+      std::atomic<unsigned long long> m_Sequence; ///< 2n+1 while sample n is written, 2n+2 when it is complete
+      Sample m_Sample;
+    };
+
+    std::vector<Slot> m_Slots;
+    std::atomic<unsigned long long> m_Head; ///< number of published samples
+  };
+} // namespace mitk
+
+#endif /* MITKTRACKINGSAMPLEBUFFER_H_HEADER_INCLUDED_ */
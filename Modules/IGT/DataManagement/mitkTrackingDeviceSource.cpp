@@ -65,6 +65,7 @@ void mitk::TrackingDeviceSource::GenerateData()
   }
   /* update outputs with tracking data from tools */
   unsigned int toolCount = m_TrackingDevice->GetToolCount();
+  m_Latencies.resize(toolCount, 0.0);
   for (unsigned int i = 0; i < toolCount; ++i)
   {
     mitk::NavigationData* nd = this->GetOutput(i);
@@ -72,6 +73,23 @@ void mitk::TrackingDeviceSource::GenerateData()
     mitk::TrackingTool* t = m_TrackingDevice->GetTool(i);
     assert(t);
 
+    /* use the latest sample published by the tracking thread, this does not lock the tool */
+    mitk::TrackingSampleBuffer::Sample sample;
+    if (t->GetSampleBuffer()->GetLatest(sample))
+    {
+      nd->SetDataValid(sample.m_DataValid);
+      if (!sample.m_DataValid)
+        continue;
+      nd->SetPosition(sample.m_Position);
+      nd->SetOrientation(sample.m_Orientation);
+      nd->SetOrientationAccuracy(sample.m_TrackingError);
+      nd->SetPositionAccuracy(sample.m_TrackingError);
+      nd->SetIGTTimeStamp(sample.m_IGTTimeStamp);
+      m_Latencies[i] = mitk::IGTTimeStamp::GetInstance()->GetElapsed() - sample.m_IGTTimeStamp;
+      continue;
+    }
+
+    /* devices that do not publish samples are polled */
     if ((t->IsEnabled() == false) || (t->IsDataValid() == false))
     {
       nd->SetDataValid(false);
@@ -94,12 +112,33 @@ void mitk::TrackingDeviceSource::GenerateData()
   }
 }
 
+double mitk::TrackingDeviceSource::GetLatency(unsigned int toolIndex) const
+{
+  if (toolIndex >= m_Latencies.size())
+    return 0.0;
+  return m_Latencies[toolIndex];
+}
+
+unsigned long long mitk::TrackingDeviceSource::GetPendingSamples(unsigned int toolIndex, mitk::TrackingSampleBuffer::SampleContainer& samples)
+{
+  if (m_TrackingDevice.IsNull())
+    throw std::invalid_argument("mitk::TrackingDeviceSource: No tracking device set");
+  if (toolIndex >= m_TrackingDevice->GetToolCount())
+    throw std::out_of_range("mitk::TrackingDeviceSource: tool index out of range");
+
+  if (m_SampleCursors.size() < m_TrackingDevice->GetToolCount())
+    m_SampleCursors.resize(m_TrackingDevice->GetToolCount(), 0);
+  return m_TrackingDevice->GetTool(toolIndex)->GetSampleBuffer()->GetPending(m_SampleCursors[toolIndex], samples);
+}
+
 void mitk::TrackingDeviceSource::SetTrackingDevice( mitk::TrackingDevice* td )
 {
   MITK_DEBUG << "Setting TrackingDevice to " << td;
   if (this->m_TrackingDevice.GetPointer() != td)
   {
     this->m_TrackingDevice = td;
+    m_SampleCursors.clear();
+    m_Latencies.clear();
     this->CreateOutputs();
     std::stringstream name; // create a human readable name for the source
     name << td->GetData().Model << " Tracking Source";
@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkNavigationDataSource.h>
 #include "mitkTrackingDevice.h"
+#include "mitkTrackingSampleBuffer.h"
 
 namespace mitk {
   /**Documentation
@@ -37,6 +38,11 @@ namespace mitk {
   * \warning If a tool is removed from the tracking device, there will be a mismatch between
   * the outputs and the tool number!
   *
+  * The outputs are updated from the latest sample that the tracking thread published to the
+  * mitk::TrackingSampleBuffer of each tool, so an update does not wait for the tracking thread.
+  * Filters that need every sample instead of the latest one can get them with GetPendingSamples().
+  * Tracking devices that do not publish samples are polled as before.
+  *
   * \ingroup IGT
   */
   class MITKIGT_EXPORT TrackingDeviceSource : public NavigationDataSource
@@ -108,6 +114,20 @@ namespace mitk {
     */
     virtual void UpdateOutputInformation() override;
 
+    /**
+    * \brief Returns the time in ms between the acquisition of the data of the given output and its last update.
+    */
+    double GetLatency(unsigned int toolIndex) const;
+
+    /**
+    * \brief Appends all samples of a tool that were published since the last call to samples, without locking.
+    *
+    * \return the number of samples that were dropped because they were overwritten before this call
+    * \warning Will throw a std::invalid_argument exception if no tracking device is set and a
+    * std::out_of_range exception if the tool does not exist.
+    */
+    unsigned long long GetPendingSamples(unsigned int toolIndex, mitk::TrackingSampleBuffer::SampleContainer& samples);
+
   protected:
     TrackingDeviceSource();
     virtual ~TrackingDeviceSource();
@@ -130,6 +150,8 @@ namespace mitk {
     void CreateOutputs();
 
     mitk::TrackingDevice::Pointer m_TrackingDevice;  ///< the tracking device that is used as a source for this filter object
+    std::vector<double> m_Latencies;                  ///< latency of each output at its last update
+    std::vector<unsigned long long> m_SampleCursors;  ///< position of GetPendingSamples() in the sample buffer of each tool
   };
 } // namespace mitk
 #endif /* MITKTrackingDeviceSource_H_HEADER_INCLUDED_ */
\ No newline at end of file
@@ -58,7 +58,7 @@ void mitk::NavigationDataPlayer::GenerateData()
   // imediatly with the first navigation data (not to wait till the first time
   // stamp is reached)
   TimeStampType timeStampSinceStartWithOffset = m_TimeStampSinceStart
-      + m_NavigationDataSet->Begin()->at(0)->GetIGTTimeStamp();
+      + m_NavigationDataSet->GetIGTTimeStampForIndex(0, 0);
 
   // iterate through all NavigationData objects of the given tool index
   // till the timestamp of the NavigationData is greater then the given timestamp
@@ -66,7 +66,7 @@ void mitk::NavigationDataPlayer::GenerateData()
   {
     // test if the timestamp of the successor is greater than the time stamp
     if ( m_NavigationDataSetIterator+1 == m_NavigationDataSet->End() ||
-        (m_NavigationDataSetIterator+1)->at(0)->GetIGTTimeStamp() > timeStampSinceStartWithOffset )
+        m_NavigationDataSet->GetIGTTimeStampForIndex(m_NavigationDataSetIterator.GetIndex()+1, 0) > timeStampSinceStartWithOffset )
     {
       break;
     }
@@ -77,7 +77,7 @@ void mitk::NavigationDataPlayer::GenerateData()
     mitk::NavigationData* output = this->GetOutput(index);
     if( !output ) { mitkThrowException(mitk::IGTException) << "Output of index "<<index<<" is null."; }
 
-    output->Graft(m_NavigationDataSetIterator->at(index));
+    m_NavigationDataSet->CopyNavigationDataForIndex(m_NavigationDataSetIterator.GetIndex(), index, output);
   }
 
   // stop playing if the last NavigationData objects were grafted
@@ -16,8 +16,18 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkNavigationDataRecorder.h"
 #include <mitkIGTTimeStamp.h>
+#include "mitkIGTIOException.h"
 
 mitk::NavigationDataRecorder::NavigationDataRecorder()
+  : m_StreamingChunkSize(250),
+  m_MaxNumberOfPendingChunks(16),
+  m_MultiThreader(itk::MultiThreader::New()),
+  m_ThreadID(-1),
+  m_ChunkAvailable(itk::ConditionVariable::New()),
+  m_ChunkWritten(itk::ConditionVariable::New()),
+  m_StopWriterThread(false),
+  m_NumberOfStreamedSteps(0),
+  m_NumberOfDroppedSteps(0)
 {
   //set default values
   m_NumberOfInputs = 0;
@@ -28,6 +38,7 @@ mitk::NavigationDataRecorder::NavigationDataRecorder()
 
 mitk::NavigationDataRecorder::~NavigationDataRecorder()
 {
+  this->StopStreaming();
   mitk::IGTTimeStamp::GetInstance()->Stop(this);
 }
 
@@ -36,8 +47,14 @@ void mitk::NavigationDataRecorder::GenerateData()
   // get each input, lookup the associated BaseData and transfer the data
   DataObjectPointerArray inputs = this->GetIndexedInputs(); //get all inputs
 
-  //This vector will hold the NavigationDatas that are copied from the inputs
-  std::vector< mitk::NavigationData::Pointer > clonedDatas;
+  //This vector holds the NavigationDatas that are copied from the inputs. They are reused for every
+  //time step, as the set copies their values.
+  if (m_RecordedNavigationDatas.size() != inputs.size())
+  {
+    m_RecordedNavigationDatas.clear();
+    for (unsigned int index=0; index < inputs.size(); index++)
+      m_RecordedNavigationDatas.push_back(mitk::NavigationData::New());
+  }
 
   // For each input
   for (unsigned int index=0; index < inputs.size(); index++)
@@ -48,26 +65,32 @@ void mitk::NavigationDataRecorder::GenerateData()
     // if we are not recording, that's all there is to do
     if (! m_Recording) continue;
 
-    // Clone a Navigation Data
-    mitk::NavigationData::Pointer clone = mitk::NavigationData::New();
-    clone->Graft(this->GetInput(index));
-    clonedDatas.push_back(clone);
+    // Copy the Navigation Data
+    m_RecordedNavigationDatas[index]->Graft(this->GetInput(index));
 
     if (m_StandardizeTime)
     {
       mitk::NavigationData::TimeStampType igtTimestamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed(this);
-      clonedDatas[index]->SetIGTTimeStamp(igtTimestamp);
+      m_RecordedNavigationDatas[index]->SetIGTTimeStamp(igtTimestamp);
     }
   }
 
   // if limitation is set and has been reached, stop recording
-  if ((m_RecordCountLimit > 0) && (m_NavigationDataSet->Size() >= m_RecordCountLimit)) m_Recording = false;
+  if ((m_RecordCountLimit > 0) && (this->GetNumberOfRecordedSteps() >= m_RecordCountLimit) && m_Recording)
+  {
+    m_Recording = false;
+    if (this->IsStreaming())
+      this->HandOverChunk();
+  }
   // We can skip the rest of the method, if recording is deactivated
   if  (!m_Recording) return;
 
 
   // Add data to set
-  m_NavigationDataSet->AddNavigationDatas(clonedDatas);
+  m_NavigationDataSet->AddNavigationDatas(m_RecordedNavigationDatas);
+
+  if (this->IsStreaming() && m_NavigationDataSet->Size() >= m_StreamingChunkSize)
+    this->HandOverChunk();
 }
 
 void mitk::NavigationDataRecorder::StartRecording()
@@ -77,6 +100,10 @@ void mitk::NavigationDataRecorder::StartRecording()
     MITK_WARN << "Already recording please stop before start new recording session";
     return;
   }
+
+  if (!m_StreamingFileName.empty() && !this->IsStreaming())
+    this->StartStreaming();
+
   m_Recording = true;
 
   // The first time this StartRecording is called, we initialize the standardized time.
@@ -96,20 +123,185 @@ void mitk::NavigationDataRecorder::StopRecording()
     return;
   }
   m_Recording = false;
+
+  if (this->IsStreaming())
+    this->FlushStreaming();
 }
 
 void mitk::NavigationDataRecorder::ResetRecording()
 {
+  this->StopStreaming();
+  m_NumberOfStreamedSteps = 0;
+  m_NumberOfDroppedSteps = 0;
+
   m_NavigationDataSet = mitk::NavigationDataSet::New(GetNumberOfIndexedInputs());
 
   if (m_Recording)
   {
     mitk::IGTTimeStamp::GetInstance()->Stop(this);
     mitk::IGTTimeStamp::GetInstance()->Start(this);
+
+    if (!m_StreamingFileName.empty())
+      this->StartStreaming();
   }
 }
 
 int mitk::NavigationDataRecorder::GetNumberOfRecordedSteps()
 {
-  return m_NavigationDataSet->Size();
-}
\ No newline at end of file
+  if (m_NavigationDataSet.IsNull())
+    return m_NumberOfStreamedSteps;
+
+  return m_NumberOfStreamedSteps + m_NavigationDataSet->Size();
+}
+
+unsigned long mitk::NavigationDataRecorder::GetNumberOfDroppedSteps()
+{
+  m_ChunkMutex.Lock();
+  unsigned long numberOfDroppedSteps = m_NumberOfDroppedSteps;
+  m_ChunkMutex.Unlock();
+  return numberOfDroppedSteps;
+}
+
+bool mitk::NavigationDataRecorder::IsStreaming() const
+{
+  return m_ThreadID >= 0;
+}
+
+void mitk::NavigationDataRecorder::StartStreaming()
+{
+  std::vector<std::string> toolNames;
+  for (unsigned int index = 0; index < this->GetNumberOfIndexedInputs(); index++)
+    toolNames.push_back(this->GetInput(index)->GetName());
+
+  m_StreamWriter = mitk::NavigationDataBinaryStreamWriter::New();
+  m_StreamWriter->Open(m_StreamingFileName, this->GetNumberOfIndexedInputs(), toolNames);
+
+  m_StopWriterThread = false;
+  m_NumberOfStreamedSteps = 0;
+  m_NumberOfDroppedSteps = 0;
+
+  // the time steps recorded so far are the first chunk
+  if (m_NavigationDataSet.IsNull())
+    m_NavigationDataSet = mitk::NavigationDataSet::New(this->GetNumberOfIndexedInputs());
+
+  m_ThreadID = m_MultiThreader->SpawnThread(this->ThreadStartWriting, this);
+}
+
+void mitk::NavigationDataRecorder::HandOverChunk()
+{
+  if (m_NavigationDataSet->Size() == 0)
+    return;
+
+  bool dropped = false;
+  m_ChunkMutex.Lock();
+  if (m_PendingChunks.size() >= m_MaxNumberOfPendingChunks)
+  {
+    m_NumberOfDroppedSteps += m_NavigationDataSet->Size();
+    dropped = true;
+  }
+  else
+  {
+    m_PendingChunks.push_back(m_NavigationDataSet);
+    m_NumberOfStreamedSteps += m_NavigationDataSet->Size();
+  }
+  m_ChunkMutex.Unlock();
+  m_ChunkAvailable->Signal();
+
+  if (dropped)
+    MITK_WARN << "Writing the recording cannot keep up, dropped " << m_NavigationDataSet->Size() << " time steps.";
+
+  m_NavigationDataSet = mitk::NavigationDataSet::New(this->GetNumberOfIndexedInputs());
+  m_NavigationDataSet->Reserve(m_StreamingChunkSize);
+}
+
+void mitk::NavigationDataRecorder::FlushStreaming()
+{
+  this->HandOverChunk();
+
+  m_ChunkMutex.Lock();
+  while (!m_PendingChunks.empty())
+    m_ChunkWritten->Wait(&m_ChunkMutex);
+  m_ChunkMutex.Unlock();
+}
+
+void mitk::NavigationDataRecorder::StopStreaming()
+{
+  if (!this->IsStreaming())
+    return;
+
+  this->HandOverChunk();
+
+  m_ChunkMutex.Lock();
+  m_StopWriterThread = true;
+  m_ChunkMutex.Unlock();
+  m_ChunkAvailable->Broadcast();
+
+  // waits until the thread wrote the remaining chunks
+  m_MultiThreader->TerminateThread(m_ThreadID);
+  m_ThreadID = -1;
+
+  try
+  {
+    m_StreamWriter->Close();
+  }
+  catch (const mitk::IGTIOException& e)
+  {
+    MITK_ERROR << "Closing the recording file failed: " << e.GetDescription();
+  }
+  m_StreamWriter = nullptr;
+}
+
+ITK_THREAD_RETURN_TYPE mitk::NavigationDataRecorder::ThreadStartWriting(void* pInfoStruct)
+{
+  /* extract this pointer from Thread Info structure */
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+  if (pInfo == nullptr)
+  {
+    return ITK_THREAD_RETURN_VALUE;
+  }
+  NavigationDataRecorder* recorder = static_cast<NavigationDataRecorder*>(pInfo->UserData);
+  if (recorder != nullptr)
+  {
+    recorder->WriteChunks();
+  }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::NavigationDataRecorder::WriteChunks()
+{
+  bool failed = false;
+
+  m_ChunkMutex.Lock();
+  while (true)
+  {
+    while (m_PendingChunks.empty() && !m_StopWriterThread)
+      m_ChunkAvailable->Wait(&m_ChunkMutex);
+
+    // only stop after all chunks are written
+    if (m_PendingChunks.empty())
+      break;
+
+    mitk::NavigationDataSet::Pointer chunk = m_PendingChunks.front();
+    m_ChunkMutex.Unlock();
+
+    if (!failed)
+    {
+      try
+      {
+        m_StreamWriter->AddNavigationDataSet(chunk);
+        m_StreamWriter->Flush();
+      }
+      catch (const mitk::IGTIOException& e)
+      {
+        // the recording goes on, but nothing more is written
+        MITK_ERROR << "Writing the recording to " << m_StreamingFileName << " failed: " << e.GetDescription();
+        failed = true;
+      }
+    }
+
+    m_ChunkMutex.Lock();
+    m_PendingChunks.pop_front();
+    m_ChunkWritten->Broadcast();
+  }
+  m_ChunkMutex.Unlock();
+}
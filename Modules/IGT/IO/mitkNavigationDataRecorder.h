@@ -20,6 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNavigationDataToNavigationDataFilter.h"
 #include "mitkNavigationData.h"
 #include "mitkNavigationDataSet.h"
+#include "mitkNavigationDataBinaryStreamWriter.h"
+
+#include <itkMultiThreader.h>
+#include <itkConditionVariable.h>
+#include <itkMutexLock.h>
+
+#include <deque>
 
 namespace mitk
 {
@@ -31,6 +38,13 @@ namespace mitk
   * With StopRecording() the stream is stopped, but can be resumed anytime.
   * To start recording to a new NavigationDataSet, call ResetRecording();
   *
+  * For long recordings, set a streaming file name before starting. The recorder then only keeps
+  * the current chunk of StreamingChunkSize time steps in its NavigationDataSet. Full chunks are
+  * handed to a writer thread which appends them to the file in the binary format of
+  * mitk::NavigationDataBinaryStreamWriter, so memory use stays constant and Update() never waits
+  * for the disk. If the writer falls behind by more than MaxNumberOfPendingChunks chunks, further
+  * chunks are dropped and counted by GetNumberOfDroppedSteps().
+  *
   * \warning Do not add inputs while the recorder ist recording. The recorder can't handle that and will cause a nullpointer exception.
   * \ingroup IGT
   */
@@ -51,6 +65,9 @@ namespace mitk
 
     /**
     * \brief Returns the set that contains all of the recorded data.
+    *
+    * When streaming to a file, the set only contains the time steps that were not yet handed
+    * to the writer thread. Load the file to get the whole recording.
     */
     itkGetMacro(NavigationDataSet, mitk::NavigationDataSet::Pointer);
 
@@ -70,8 +87,35 @@ namespace mitk
     */
     itkSetMacro(StandardizeTime, bool);
 
+    /**
+    * \brief Sets the file to which the recording is streamed, an empty name (default) disables streaming.
+    *
+    * The file is created by the next call of StartRecording() after construction or ResetRecording().
+    */
+    itkSetStringMacro(StreamingFileName);
+    itkGetStringMacro(StreamingFileName);
+
+    /**
+    * \brief Sets the number of time steps that are handed to the writer thread at once. Default is 250.
+    */
+    itkSetMacro(StreamingChunkSize, unsigned int);
+    itkGetMacro(StreamingChunkSize, unsigned int);
+
+    /**
+    * \brief Sets the number of chunks that may wait for the writer thread before chunks are dropped. Default is 16.
+    */
+    itkSetMacro(MaxNumberOfPendingChunks, unsigned int);
+    itkGetMacro(MaxNumberOfPendingChunks, unsigned int);
+
+    /**
+    * \brief Returns the number of time steps that were dropped because the writer thread could not keep up.
+    */
+    unsigned long GetNumberOfDroppedSteps();
+
     /**
     * \brief Starts recording NavigationData into the NAvigationDataSet
+    *
+    * \throws mitk::IGTIOException if the streaming file cannot be created.
     */
     virtual void StartRecording();
 
@@ -80,6 +124,9 @@ namespace mitk
     *
     * Recording can be resumed to the same Dataset by just calling StartRecording() again.
     * Call ResetRecording() to start recording to a new Dataset;
+    *
+    * When streaming, this waits until all recorded time steps are written, so the file
+    * can be read afterwards.
     */
     virtual void StopRecording();
 
@@ -87,11 +134,12 @@ namespace mitk
     * \brief Resets the Datasets and the timestamp, so a new recording can happen.
     *
     * Do not forget to save the old Dataset, it will be lost after calling this function.
+    * When streaming, the file is completed and closed.
     */
     virtual void ResetRecording();
 
     /**
-    * \brief Returns the number of time steps that were recorded in the current set.
+    * \brief Returns the number of time steps that were recorded in the current set, or in the file when streaming.
     * Warning: This Method does NOT Stop Recording!
     */
     virtual int GetNumberOfRecordedSteps();
@@ -115,6 +163,53 @@ namespace mitk
     bool m_StandardizedTimeInitialized; //< set to true the first time start recording is called.
 
     int m_RecordCountLimit; ///< limits the number of frames, recording will be stopped if the limit is reached. -1 disables the limit
+
+    std::vector<mitk::NavigationData::Pointer> m_RecordedNavigationDatas; ///< reused for every time step, the set copies their values
+
+    /**
+    * \brief Opens the streaming file and starts the writer thread.
+    */
+    void StartStreaming();
+
+    /**
+    * \brief Hands the current chunk over to the writer thread and starts a new one, never waits for the writer.
+    */
+    void HandOverChunk();
+
+    /**
+    * \brief Hands over the current chunk and waits until the writer thread wrote all chunks.
+    */
+    void FlushStreaming();
+
+    /**
+    * \brief Writes all pending chunks, stops the writer thread and closes the streaming file.
+    */
+    void StopStreaming();
+
+    bool IsStreaming() const;
+
+    static ITK_THREAD_RETURN_TYPE ThreadStartWriting(void* data);
+
+    /**
+    * \brief Body of the writer thread, writes chunks until StopStreaming() is called.
+    */
+    void WriteChunks();
+
+    std::string m_StreamingFileName;
+    unsigned int m_StreamingChunkSize;
+    unsigned int m_MaxNumberOfPendingChunks;
+
+    mitk::NavigationDataBinaryStreamWriter::Pointer m_StreamWriter;
+    itk::MultiThreader::Pointer m_MultiThreader;
+    int m_ThreadID;
+
+    itk::SimpleMutexLock m_ChunkMutex;          ///< guards all members below
+    itk::ConditionVariable::Pointer m_ChunkAvailable;
+    itk::ConditionVariable::Pointer m_ChunkWritten;
+    std::deque<mitk::NavigationDataSet::Pointer> m_PendingChunks; ///< the front chunk is removed after it was written
+    bool m_StopWriterThread;
+    unsigned long m_NumberOfStreamedSteps;      ///< time steps handed over to the writer thread
+    unsigned long m_NumberOfDroppedSteps;
   };
 }
 #endif // #define _MITK_POINT_SET_SOURCE_H
@@ -0,0 +1,286 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataTransformFilter.h"
+#include "mitkNavigationDataLandmarkTransformFilter.h"
+#include "mitkNavigationDataDisplacementFilter.h"
+#include "mitkNavigationDataSmoothingFilter.h"
+#include "mitkNavigationDataDelayFilter.h"
+#include "mitkIGTException.h"
+
+#include "mitkTestingMacros.h"
+
+#include <cmath>
+
+/**Documentation
+*  test for the batch processing of NavigationDataToNavigationDataFilter and its subclasses.
+*  The results of a batch have to be exactly the same as the results of Update().
+*/
+class mitkNavigationDataBatchProcessingTestClass
+{
+public:
+
+  static const unsigned int NumberOfTimeSteps = 50;
+
+  /** Creates a reproducible sequence of poses, every seventh pose is invalid */
+  static mitk::NavigationDataToNavigationDataFilter::PoseBatch CreatePoses(double seed)
+  {
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch batch;
+    batch.Resize(NumberOfTimeSteps);
+    for (unsigned int i = 0; i < NumberOfTimeSteps; ++i)
+    {
+      double t = seed + 0.1 * i;
+      mitk::FillVector3D(batch.m_Positions[i], 100 * std::sin(t), 50 * std::cos(1.3 * t), 10.0 * t);
+
+      vnl_vector_fixed<double, 3> axis(std::sin(t), std::cos(t), 0.5);
+      axis.normalize();
+      batch.m_Orientations[i] = mitk::NavigationData::OrientationType(axis, 0.3 * t);
+
+      batch.m_DataValid[i] = (i % 7 != 3);
+    }
+    return batch;
+  }
+
+  /** Runs the poses through Update() of the filter, one pose per update */
+  static mitk::NavigationDataToNavigationDataFilter::PoseBatch UpdatePoses(mitk::NavigationDataToNavigationDataFilter* filter,
+    const mitk::NavigationDataToNavigationDataFilter::PoseBatch& poses)
+  {
+    mitk::NavigationData::Pointer input = mitk::NavigationData::New();
+    filter->SetInput(input);
+
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch result = poses;
+    for (unsigned int i = 0; i < poses.Size(); ++i)
+    {
+      input->SetPosition(poses.m_Positions[i]);
+      input->SetOrientation(poses.m_Orientations[i]);
+      input->SetDataValid(poses.m_DataValid[i] != 0);
+      filter->Update();
+
+      const mitk::NavigationData* output = filter->GetOutput();
+      result.m_DataValid[i] = output->IsDataValid();
+      if (output->IsDataValid())
+      {
+        result.m_Positions[i] = output->GetPosition();
+        result.m_Orientations[i] = output->GetOrientation();
+      }
+    }
+    return result;
+  }
+
+  /** Checks that the valid poses are exactly the same, invalid poses are not compared */
+  static bool AreEqual(const mitk::NavigationDataToNavigationDataFilter::PoseBatch& a,
+    const mitk::NavigationDataToNavigationDataFilter::PoseBatch& b)
+  {
+    if (a.Size() != b.Size())
+      return false;
+    for (unsigned int i = 0; i < a.Size(); ++i)
+    {
+      if (a.m_DataValid[i] != b.m_DataValid[i])
+        return false;
+      if (a.m_DataValid[i] && (a.m_Positions[i] != b.m_Positions[i] || a.m_Orientations[i] != b.m_Orientations[i]))
+        return false;
+    }
+    return true;
+  }
+
+  static void TestBatch(mitk::NavigationDataToNavigationDataFilter* updateFilter, mitk::NavigationDataToNavigationDataFilter* batchFilter,
+    const std::string& name)
+  {
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch poses = CreatePoses(0.5);
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch expected = UpdatePoses(updateFilter, poses);
+
+    // two batches, so that stateful filters have to continue their state
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch first, second;
+    first.Resize(20);
+    second.Resize(NumberOfTimeSteps - 20);
+    for (unsigned int i = 0; i < NumberOfTimeSteps; ++i)
+    {
+      mitk::NavigationDataToNavigationDataFilter::PoseBatch& batch = i < 20 ? first : second;
+      unsigned int j = i < 20 ? i : i - 20;
+      batch.m_Positions[j] = poses.m_Positions[i];
+      batch.m_Orientations[j] = poses.m_Orientations[i];
+      batch.m_DataValid[j] = poses.m_DataValid[i];
+    }
+    batchFilter->ProcessPoseBatch(0, first);
+    batchFilter->ProcessPoseBatch(0, second);
+
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch result = poses;
+    for (unsigned int i = 0; i < NumberOfTimeSteps; ++i)
+    {
+      const mitk::NavigationDataToNavigationDataFilter::PoseBatch& batch = i < 20 ? first : second;
+      unsigned int j = i < 20 ? i : i - 20;
+      result.m_Positions[i] = batch.m_Positions[j];
+      result.m_Orientations[i] = batch.m_Orientations[j];
+      result.m_DataValid[i] = batch.m_DataValid[j];
+    }
+    MITK_TEST_CONDITION(AreEqual(expected, result), "Testing that the batch of the " << name << " gives the same poses as Update()");
+  }
+
+  static void TestTransformFilter(bool precompose)
+  {
+    mitk::NavigationDataTransformFilter::TransformType::Pointer transform = mitk::NavigationDataTransformFilter::TransformType::New();
+    mitk::NavigationDataTransformFilter::TransformType::VersorType rotation;
+    mitk::NavigationDataTransformFilter::TransformType::VersorType::VectorType axis;
+    axis[0] = 0.2; axis[1] = 1.0; axis[2] = -0.4;
+    rotation.Set(axis, 0.8);
+    transform->SetRotation(rotation);
+    mitk::NavigationDataTransformFilter::TransformType::OutputVectorType translation;
+    translation[0] = 5.5; translation[1] = -3.0; translation[2] = 12.25;
+    transform->SetTranslation(translation);
+
+    mitk::NavigationDataTransformFilter::Pointer updateFilter = mitk::NavigationDataTransformFilter::New();
+    updateFilter->SetRigid3DTransform(transform);
+    updateFilter->SetPrecompose(precompose);
+    mitk::NavigationDataTransformFilter::Pointer batchFilter = mitk::NavigationDataTransformFilter::New();
+    batchFilter->SetRigid3DTransform(transform);
+    batchFilter->SetPrecompose(precompose);
+
+    TestBatch(updateFilter, batchFilter, precompose ? "precomposing NavigationDataTransformFilter" : "NavigationDataTransformFilter");
+
+    mitk::NavigationDataTransformFilter::Pointer filterWithoutTransform = mitk::NavigationDataTransformFilter::New();
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch poses = CreatePoses(0.0);
+    MITK_TEST_FOR_EXCEPTION_BEGIN(itk::ExceptionObject)
+      filterWithoutTransform->ProcessPoseBatch(0, poses);
+    MITK_TEST_FOR_EXCEPTION_END(itk::ExceptionObject)
+  }
+
+  static void TestLandmarkTransformFilter()
+  {
+    mitk::PointSet::Pointer sourcePoints = mitk::PointSet::New();
+    mitk::PointSet::Pointer targetPoints = mitk::PointSet::New();
+    mitk::Point3D point;
+    mitk::FillVector3D(point, 1.1, 1.1, 1.1); sourcePoints->SetPoint(0, point);
+    mitk::FillVector3D(point, 2.2, 4.2, 1.2); sourcePoints->SetPoint(1, point);
+    mitk::FillVector3D(point, 3.3, 0.3, 5.3); sourcePoints->SetPoint(2, point);
+    mitk::FillVector3D(point, 2.1, -1.1, 1.5); targetPoints->SetPoint(0, point);
+    mitk::FillVector3D(point, 4.9, 0.4, 3.1); targetPoints->SetPoint(1, point);
+    mitk::FillVector3D(point, 0.9, 1.8, 6.6); targetPoints->SetPoint(2, point);
+
+    mitk::NavigationDataLandmarkTransformFilter::Pointer updateFilter = mitk::NavigationDataLandmarkTransformFilter::New();
+    updateFilter->SetSourceLandmarks(sourcePoints);
+    updateFilter->SetTargetLandmarks(targetPoints);
+    mitk::NavigationDataLandmarkTransformFilter::Pointer batchFilter = mitk::NavigationDataLandmarkTransformFilter::New();
+    batchFilter->SetSourceLandmarks(sourcePoints);
+    batchFilter->SetTargetLandmarks(targetPoints);
+
+    TestBatch(updateFilter, batchFilter, "NavigationDataLandmarkTransformFilter");
+
+    // without landmarks, the filter does not change anything
+    mitk::NavigationDataLandmarkTransformFilter::Pointer uninitializedFilter = mitk::NavigationDataLandmarkTransformFilter::New();
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch poses = CreatePoses(0.0);
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch batch = poses;
+    uninitializedFilter->ProcessPoseBatch(0, batch);
+    MITK_TEST_CONDITION(AreEqual(poses, batch), "Testing that an uninitialized NavigationDataLandmarkTransformFilter does not change the batch");
+  }
+
+  static void TestDisplacementFilter()
+  {
+    mitk::Vector3D offset;
+    mitk::FillVector3D(offset, 1.5, -2.25, 300.0);
+
+    mitk::NavigationDataDisplacementFilter::Pointer updateFilter = mitk::NavigationDataDisplacementFilter::New();
+    updateFilter->SetOffset(offset);
+    mitk::NavigationDataDisplacementFilter::Pointer batchFilter = mitk::NavigationDataDisplacementFilter::New();
+    batchFilter->SetOffset(offset);
+
+    TestBatch(updateFilter, batchFilter, "NavigationDataDisplacementFilter");
+  }
+
+  static void TestSmoothingFilter()
+  {
+    mitk::NavigationDataSmoothingFilter::Pointer updateFilter = mitk::NavigationDataSmoothingFilter::New();
+    updateFilter->SetNumerOfValues(4);
+    mitk::NavigationDataSmoothingFilter::Pointer batchFilter = mitk::NavigationDataSmoothingFilter::New();
+    batchFilter->SetNumerOfValues(4);
+
+    TestBatch(updateFilter, batchFilter, "NavigationDataSmoothingFilter");
+  }
+
+  static void TestNavigationDataSet()
+  {
+    const unsigned int numberOfTools = 2;
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch poses[numberOfTools] = { CreatePoses(0.0), CreatePoses(1.7) };
+
+    mitk::NavigationDataSet::Pointer navigationDataSet = mitk::NavigationDataSet::New(numberOfTools);
+    for (unsigned int i = 0; i < NumberOfTimeSteps; ++i)
+    {
+      std::vector<mitk::NavigationData::Pointer> navigationDatas;
+      for (unsigned int tool = 0; tool < numberOfTools; ++tool)
+      {
+        mitk::NavigationData::Pointer navigationData = mitk::NavigationData::New();
+        navigationData->SetPosition(poses[tool].m_Positions[i]);
+        navigationData->SetOrientation(poses[tool].m_Orientations[i]);
+        navigationData->SetDataValid(poses[tool].m_DataValid[i] != 0);
+        navigationData->SetIGTTimeStamp(10.0 * i + tool);
+        navigationDatas.push_back(navigationData);
+      }
+      navigationDataSet->AddNavigationDatas(navigationDatas);
+    }
+
+    mitk::Vector3D offset;
+    mitk::FillVector3D(offset, 3.0, 2.0, 1.0);
+    mitk::NavigationDataDisplacementFilter::Pointer filter = mitk::NavigationDataDisplacementFilter::New();
+    filter->SetOffset(offset);
+
+    mitk::NavigationDataSet::Pointer result = filter->ProcessNavigationDataSet(navigationDataSet);
+    MITK_TEST_CONDITION_REQUIRED(result.IsNotNull() && result->Size() == NumberOfTimeSteps && result->GetNumberOfTools() == numberOfTools,
+      "Testing size of the processed navigation data set");
+
+    bool equal = true;
+    for (unsigned int tool = 0; tool < numberOfTools; ++tool)
+    {
+      mitk::NavigationDataDisplacementFilter::Pointer updateFilter = mitk::NavigationDataDisplacementFilter::New();
+      updateFilter->SetOffset(offset);
+      mitk::NavigationDataToNavigationDataFilter::PoseBatch expected = UpdatePoses(updateFilter, poses[tool]);
+
+      for (unsigned int i = 0; i < NumberOfTimeSteps; ++i)
+      {
+        mitk::NavigationData::Pointer navigationData = result->GetNavigationDataForIndex(i, tool);
+        equal = equal && navigationData->IsDataValid() == (expected.m_DataValid[i] != 0);
+        equal = equal && navigationData->GetIGTTimeStamp() == 10.0 * i + tool;
+        if (expected.m_DataValid[i])
+          equal = equal && navigationData->GetPosition() == expected.m_Positions[i] && navigationData->GetOrientation() == expected.m_Orientations[i];
+        else
+          equal = equal && navigationData->GetPosition() == poses[tool].m_Positions[i];
+      }
+    }
+    MITK_TEST_CONDITION(equal, "Testing that the processed navigation data set contains the same poses as given by Update()");
+
+    MITK_TEST_FOR_EXCEPTION(mitk::IGTException, filter->ProcessNavigationDataSet(NULL));
+  }
+
+  static void TestUnsupportedFilter()
+  {
+    mitk::NavigationDataDelayFilter::Pointer filter = mitk::NavigationDataDelayFilter::New(10);
+    mitk::NavigationDataToNavigationDataFilter::PoseBatch poses = CreatePoses(0.0);
+    MITK_TEST_FOR_EXCEPTION(mitk::IGTException, filter->ProcessPoseBatch(0, poses));
+  }
+};
+
+int mitkNavigationDataBatchProcessingTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("NavigationDataBatchProcessing")
+
+  mitkNavigationDataBatchProcessingTestClass::TestTransformFilter(false);
+  mitkNavigationDataBatchProcessingTestClass::TestTransformFilter(true);
+  mitkNavigationDataBatchProcessingTestClass::TestLandmarkTransformFilter();
+  mitkNavigationDataBatchProcessingTestClass::TestDisplacementFilter();
+  mitkNavigationDataBatchProcessingTestClass::TestSmoothingFilter();
+  mitkNavigationDataBatchProcessingTestClass::TestNavigationDataSet();
+  mitkNavigationDataBatchProcessingTestClass::TestUnsupportedFilter();
+
+  MITK_TEST_END()
+}
@@ -22,6 +22,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkTestFixture.h>
 #include <mitkIOUtil.h>
 
+#include <cstdio>
+
 //for exceptions
 #include "mitkIGTException.h"
 #include "mitkIGTIOException.h"
@@ -32,6 +34,7 @@ class mitkNavigationDataRecorderTestSuite : public mitk::TestFixture
   MITK_TEST(TestRecording);
   MITK_TEST(TestStopRecording);
   MITK_TEST(TestLimiting);
+  MITK_TEST(TestStreaming);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -117,6 +120,33 @@ public:
     MITK_TEST_CONDITION_REQUIRED(m_Recorder->GetNavigationDataSet()->Size() == 30, "Test if SetRecordCountLimit works as intended.");
   }
 
+  void TestStreaming()
+  {
+    std::string fileName = mitk::IOUtil::CreateTemporaryFile("NavigationDataRecorderXXXXXX.ndb");
+    m_Recorder->SetStreamingFileName(fileName);
+    m_Recorder->SetStreamingChunkSize(7);
+    m_Recorder->StartRecording();
+    while (!m_Player->IsAtEnd())
+    {
+      m_Recorder->Update();
+      m_Player->GoToNextSnapshot();
+    }
+    m_Recorder->StopRecording();
+
+    MITK_TEST_CONDITION_REQUIRED(m_Recorder->GetNumberOfRecordedSteps() == static_cast<int>(m_NavigationDataSet->Size()), "Test if all time steps were recorded");
+    MITK_TEST_CONDITION_REQUIRED(m_Recorder->GetNavigationDataSet()->Size() < 7, "Test if only the current chunk is kept in memory");
+    MITK_TEST_CONDITION_REQUIRED(m_Recorder->GetNumberOfDroppedSteps() == 0, "Test if no time steps were dropped");
+
+    // closes the file
+    m_Recorder->ResetRecording();
+
+    mitk::NavigationDataSet::Pointer streamedData = dynamic_cast<mitk::NavigationDataSet*>(mitk::IOUtil::Load(fileName).at(0).GetPointer());
+    MITK_TEST_CONDITION_REQUIRED(streamedData.IsNotNull() && streamedData->Size() == m_NavigationDataSet->Size(), "Test if streamed file is of equal size as original");
+    MITK_TEST_CONDITION_REQUIRED(compareDataSet(streamedData), "Test streamed file for equality with reference");
+
+    std::remove(fileName.c_str());
+  }
+
 private:
 
   /*
@@ -0,0 +1,175 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkNavigationDataSet.h>
+#include <mitkNavigationDataBinaryStreamWriter.h>
+#include <mitkNavigationDataBinaryFormat.h>
+#include <mitkNavigationDataSequentialPlayer.h>
+#include <mitkIOUtil.h>
+
+#include <cstdio>
+#include <fstream>
+
+/**
+ * \brief Writes navigation data sets in the binary format and compares them after reading.
+ */
+class mitkNavigationDataSetReaderWriterBinaryTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkNavigationDataSetReaderWriterBinaryTestSuite);
+  MITK_TEST(TestReadWrite);
+  MITK_TEST(TestStreamWriterInterruptedRecording);
+  MITK_TEST(TestSequentialPlayer);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  static const unsigned int m_NumberOfTools = 3;
+  static const unsigned int m_NumberOfTimeSteps = 100;
+
+  mitk::NavigationDataSet::Pointer m_Set;
+  std::string m_FileName;
+
+  static std::vector<mitk::NavigationData::Pointer> CreateTimeStep(unsigned int index)
+  {
+    std::vector<mitk::NavigationData::Pointer> timeStep;
+    for (unsigned int tool = 0; tool < m_NumberOfTools; ++tool)
+    {
+      mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+      mitk::NavigationData::PositionType position;
+      position[0] = index + 0.1 * tool;
+      position[1] = -0.5 * index;
+      position[2] = 1000.0 / (index + 1);
+      nd->SetPosition(position);
+      nd->SetOrientation(mitk::Quaternion(0.1 * tool, 0.2, 0.01 * index, 0.9));
+      nd->SetIGTTimeStamp(1000.0 + index * 4.0 + tool * 0.25);
+      nd->SetDataValid(index % 7 != tool);
+      nd->SetHasOrientation(tool != 2);
+      nd->SetName(tool == 0 ? "Pointer" : tool == 1 ? "Reference" : "");
+
+      // the covariance of the first tool changes every ten time steps
+      if (tool == 0)
+      {
+        nd->SetPositionAccuracy(0.1 * (index / 10 + 1));
+      }
+      timeStep.push_back(nd);
+    }
+    return timeStep;
+  }
+
+  void CompareToOriginal(mitk::NavigationDataSet* set, unsigned int numberOfTimeSteps)
+  {
+    CPPUNIT_ASSERT_EQUAL(m_NumberOfTools, set->GetNumberOfTools());
+    CPPUNIT_ASSERT_EQUAL(numberOfTimeSteps, set->Size());
+    for (unsigned int index = 0; index < numberOfTimeSteps; ++index)
+    {
+      for (unsigned int tool = 0; tool < m_NumberOfTools; ++tool)
+      {
+        mitk::NavigationData::Pointer expected = m_Set->GetNavigationDataForIndex(index, tool);
+        mitk::NavigationData::Pointer actual = set->GetNavigationDataForIndex(index, tool);
+        CPPUNIT_ASSERT_MESSAGE("Navigation datas are equal", mitk::Equal(*expected, *actual, mitk::eps, true));
+        CPPUNIT_ASSERT_EQUAL(expected->IsDataValid(), actual->IsDataValid());
+        CPPUNIT_ASSERT_EQUAL(expected->GetHasPosition(), actual->GetHasPosition());
+        CPPUNIT_ASSERT_EQUAL(expected->GetHasOrientation(), actual->GetHasOrientation());
+      }
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Set = mitk::NavigationDataSet::New(m_NumberOfTools);
+    for (unsigned int index = 0; index < m_NumberOfTimeSteps; ++index)
+      m_Set->AddNavigationDatas(CreateTimeStep(index));
+
+    m_FileName = mitk::IOUtil::CreateTemporaryFile("NavigationDataSetXXXXXX.ndb");
+  }
+
+  void tearDown() override
+  {
+    std::remove(m_FileName.c_str());
+    m_Set = nullptr;
+  }
+
+  void TestReadWrite()
+  {
+    mitk::IOUtil::Save(m_Set, m_FileName);
+
+    std::vector<mitk::BaseData::Pointer> data = mitk::IOUtil::Load(m_FileName);
+    CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(1), data.size());
+    mitk::NavigationDataSet::Pointer readSet = dynamic_cast<mitk::NavigationDataSet*>(data[0].GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Testing whether a navigation data set was read", readSet.IsNotNull());
+
+    this->CompareToOriginal(readSet, m_NumberOfTimeSteps);
+  }
+
+  void TestStreamWriterInterruptedRecording()
+  {
+    std::vector<std::string> toolNames;
+    toolNames.push_back("Pointer");
+    toolNames.push_back("Reference");
+
+    mitk::NavigationDataBinaryStreamWriter::Pointer writer = mitk::NavigationDataBinaryStreamWriter::New();
+    writer->Open(m_FileName, m_NumberOfTools, toolNames);
+    for (unsigned int index = 0; index < 40; ++index)
+      writer->AddNavigationDatas(CreateTimeStep(index));
+    CPPUNIT_ASSERT_EQUAL(40ul, writer->GetNumberOfTimeSteps());
+    writer->Close();
+
+    // simulate a recording that was interrupted while writing a time step
+    {
+      std::ofstream file(m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+      mitk::NavigationDataBinaryFormat::BlockHeader blockHeader;
+      blockHeader.m_Type = mitk::NavigationDataBinaryFormat::TimeStepBlock;
+      blockHeader.m_ToolIndex = 0;
+      mitk::NavigationDataBinaryFormat::Sample sample = mitk::NavigationDataBinaryFormat::Sample();
+      file.write(reinterpret_cast<const char*>(&blockHeader), sizeof(blockHeader));
+      file.write(reinterpret_cast<const char*>(&sample), sizeof(sample));
+    }
+
+    std::vector<mitk::BaseData::Pointer> data = mitk::IOUtil::Load(m_FileName);
+    mitk::NavigationDataSet::Pointer readSet = dynamic_cast<mitk::NavigationDataSet*>(data.at(0).GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Testing whether a navigation data set was read", readSet.IsNotNull());
+    this->CompareToOriginal(readSet, 40);
+  }
+
+  void TestSequentialPlayer()
+  {
+    mitk::IOUtil::Save(m_Set, m_FileName);
+    mitk::NavigationDataSet::Pointer readSet = dynamic_cast<mitk::NavigationDataSet*>(mitk::IOUtil::Load(m_FileName).at(0).GetPointer());
+
+    mitk::NavigationDataSequentialPlayer::Pointer player = mitk::NavigationDataSequentialPlayer::New();
+    player->SetNavigationDataSet(readSet);
+    CPPUNIT_ASSERT_EQUAL(m_NumberOfTimeSteps, player->GetNumberOfSnapshots());
+
+    player->GoToSnapshot(42);
+    player->Update();
+    for (unsigned int tool = 0; tool < m_NumberOfTools; ++tool)
+    {
+      CPPUNIT_ASSERT_MESSAGE("Player output equals recorded navigation data",
+        mitk::Equal(*m_Set->GetNavigationDataForIndex(42, tool), *player->GetOutput(tool), mitk::eps, true));
+    }
+  }
+};
+
+const unsigned int mitkNavigationDataSetReaderWriterBinaryTestSuite::m_NumberOfTools;
+const unsigned int mitkNavigationDataSetReaderWriterBinaryTestSuite::m_NumberOfTimeSteps;
+
+MITK_TEST_SUITE_REGISTRATION(mitkNavigationDataSetReaderWriterBinary)
@@ -0,0 +1,138 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTrackingSampleBuffer.h"
+#include "mitkIGTException.h"
+#include "mitkTestingMacros.h"
+
+#include <atomic>
+#include <thread>
+
+static mitk::TrackingSampleBuffer::Sample CreateSample(double value)
+{
+  mitk::TrackingSampleBuffer::Sample sample;
+  sample.m_Position.Fill(value);
+  sample.m_Orientation = mitk::Quaternion(value, value, value, value);
+  sample.m_TrackingError = static_cast<float>(value);
+  sample.m_DataValid = true;
+  sample.m_IGTTimeStamp = value;
+  sample.m_PublishTimeStamp = value;
+  return sample;
+}
+
+/** a sample is consistent if it was not mixed up from two pushes */
+static bool IsConsistent(const mitk::TrackingSampleBuffer::Sample& sample)
+{
+  double value = static_cast<double>(sample.m_SequenceNumber);
+  return sample.m_Position[0] == value && sample.m_Position[2] == value && sample.m_Orientation.r() == value
+    && sample.m_IGTTimeStamp == value && sample.m_PublishTimeStamp == value;
+}
+
+static void TestSingleThreaded()
+{
+  mitk::TrackingSampleBuffer::Pointer buffer = mitk::TrackingSampleBuffer::New(4);
+  MITK_TEST_CONDITION(buffer->GetCapacity() == 4, "Testing capacity");
+
+  mitk::TrackingSampleBuffer::Sample sample;
+  MITK_TEST_CONDITION(!buffer->GetLatest(sample), "Testing GetLatest() of empty buffer");
+
+  for (unsigned int i = 0; i < 3; ++i)
+    buffer->Push(CreateSample(i));
+  MITK_TEST_CONDITION(buffer->GetLatest(sample) && sample.m_SequenceNumber == 2 && sample.m_Position[0] == 2, "Testing GetLatest()");
+  MITK_TEST_CONDITION(buffer->GetNumberOfPublishedSamples() == 3, "Testing GetNumberOfPublishedSamples()");
+
+  unsigned long long cursor = 0;
+  mitk::TrackingSampleBuffer::SampleContainer samples;
+  unsigned long long dropped = buffer->GetPending(cursor, samples);
+  MITK_TEST_CONDITION(dropped == 0 && samples.size() == 3 && cursor == 3, "Testing GetPending() reads all samples");
+  MITK_TEST_CONDITION(samples[0].m_SequenceNumber == 0 && samples[2].m_SequenceNumber == 2, "Testing order of pending samples");
+
+  samples.clear();
+  buffer->GetPending(cursor, samples);
+  MITK_TEST_CONDITION(samples.empty(), "Testing GetPending() without new samples");
+
+  // overflow: 6 new samples in a buffer of 4
+  for (unsigned int i = 3; i < 9; ++i)
+    buffer->Push(CreateSample(i));
+  dropped = buffer->GetPending(cursor, samples);
+  MITK_TEST_CONDITION(dropped == 2 && samples.size() == 4 && cursor == 9, "Testing dropped samples on overflow");
+  MITK_TEST_CONDITION(samples.front().m_SequenceNumber == 5 && samples.back().m_SequenceNumber == 8, "Testing oldest samples are dropped");
+
+  MITK_TEST_FOR_EXCEPTION(mitk::IGTException, mitk::TrackingSampleBuffer::New(0));
+}
+
+static void TestConcurrentConsumers()
+{
+  mitk::TrackingSampleBuffer::Pointer buffer = mitk::TrackingSampleBuffer::New(64);
+  const unsigned int numberOfSamples = 200000;
+  std::atomic<bool> finished(false);
+  std::atomic<unsigned int> inconsistentSamples(0);
+  std::atomic<unsigned int> outOfOrderSamples(0);
+  std::atomic<unsigned long long> readSamples(0);
+
+  auto consumer = [&]()
+  {
+    unsigned long long cursor = 0;
+    unsigned long long lastSequence = 0;
+    bool first = true;
+    mitk::TrackingSampleBuffer::SampleContainer samples;
+    while (!finished.load() || cursor < numberOfSamples)
+    {
+      samples.clear();
+      buffer->GetPending(cursor, samples);
+      for (std::size_t i = 0; i < samples.size(); ++i)
+      {
+        if (!IsConsistent(samples[i]))
+          ++inconsistentSamples;
+        if (!first && samples[i].m_SequenceNumber <= lastSequence)
+          ++outOfOrderSamples;
+        lastSequence = samples[i].m_SequenceNumber;
+        first = false;
+      }
+      readSamples += samples.size();
+
+      mitk::TrackingSampleBuffer::Sample latest;
+      if (buffer->GetLatest(latest) && !IsConsistent(latest))
+        ++inconsistentSamples;
+    }
+  };
+
+  std::thread consumer1(consumer);
+  std::thread consumer2(consumer);
+  for (unsigned int i = 0; i < numberOfSamples; ++i)
+    buffer->Push(CreateSample(i));
+  finished = true;
+  consumer1.join();
+  consumer2.join();
+
+  MITK_TEST_CONDITION(inconsistentSamples == 0, "Testing that concurrently read samples are never torn");
+  MITK_TEST_CONDITION(outOfOrderSamples == 0, "Testing that each consumer gets the samples in order");
+  MITK_TEST_CONDITION(readSamples > 0, "Testing that the consumers read samples");
+  MITK_TEST_OUTPUT(<< "Read " << readSamples << " of " << 2 * numberOfSamples << " samples, the others were dropped");
+}
+
+/**Documentation
+ *  test for the class "TrackingSampleBuffer".
+ */
+int mitkTrackingSampleBufferTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("TrackingSampleBuffer");
+
+  TestSingleThreaded();
+  TestConcurrentConsumers();
+
+  MITK_TEST_END();
+}
@@ -25,6 +25,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkVirtualTrackingDevice.h"
 #include "mitkVirtualTrackingDevice.h"
 #include "mitkTrackingTool.h"
+#include "mitkTrackingSampleBuffer.h"
 
 //ITK includes
 #include "itksys/SystemTools.hxx"
@@ -48,6 +49,9 @@ class mitkVirtualTrackingDeviceTestSuite : public mitk::TestFixture
   MITK_TEST(GetSplineCordLength_InvaldiToolIndex_Error);
   MITK_TEST(StartTracking_NewPositionsProduced);
   MITK_TEST(SetParamsForGaussianNoise_GetCorrrectParams);
+  MITK_TEST(SetDropoutProbability_OutOfRange_Clamped);
+  MITK_TEST(StartTracking_UpdateFrequencySet_SamplesPublishedAtHighRate);
+  MITK_TEST(StartTracking_AllDropouts_DataInvalid);
 
 
   CPPUNIT_TEST_SUITE_END();
@@ -186,6 +190,49 @@ public:
     CPPUNIT_ASSERT_EQUAL(deviationDistribution, m_TestTracker->GetDeviationDistribution());
   }
 
+  void SetDropoutProbability_OutOfRange_Clamped()
+  {
+    m_TestTracker->SetDropoutProbability(1.5);
+    CPPUNIT_ASSERT_EQUAL(1.0, m_TestTracker->GetDropoutProbability());
+    m_TestTracker->SetDropoutProbability(-0.5);
+    CPPUNIT_ASSERT_EQUAL(0.0, m_TestTracker->GetDropoutProbability());
+  }
+
+  void StartTracking_UpdateFrequencySet_SamplesPublishedAtHighRate()
+  {
+    m_TestTracker->AddTool("Tool1");
+    m_TestTracker->AddTool("Tool2");
+    m_TestTracker->SetUpdateFrequency(1000.0);
+    m_TestTracker->SetJitter(0.2);
+    m_TestTracker->OpenConnection();
+    m_TestTracker->StartTracking();
+    itksys::SystemTools::Delay(500);
+    m_TestTracker->StopTracking();
+
+    // the default refresh rate of 100 ms would give about 5 samples, be generous for loaded machines
+    mitk::TrackingSampleBuffer::Sample sample;
+    CPPUNIT_ASSERT(m_TestTracker->GetTool(1)->GetSampleBuffer()->GetNumberOfPublishedSamples() > 50);
+    CPPUNIT_ASSERT(m_TestTracker->GetTool(1)->GetSampleBuffer()->GetLatest(sample));
+    CPPUNIT_ASSERT(sample.m_DataValid);
+    CPPUNIT_ASSERT(sample.m_IGTTimeStamp <= sample.m_PublishTimeStamp);
+  }
+
+  void StartTracking_AllDropouts_DataInvalid()
+  {
+    m_TestTracker->AddTool("Tool1");
+    m_TestTracker->SetUpdateFrequency(200.0);
+    m_TestTracker->SetDropoutProbability(1.0);
+    m_TestTracker->OpenConnection();
+    m_TestTracker->StartTracking();
+    itksys::SystemTools::Delay(200);
+    m_TestTracker->StopTracking();
+
+    mitk::TrackingSampleBuffer::Sample sample;
+    CPPUNIT_ASSERT(m_TestTracker->GetTool(0)->GetSampleBuffer()->GetLatest(sample));
+    CPPUNIT_ASSERT(!sample.m_DataValid);
+    CPPUNIT_ASSERT(!m_TestTracker->GetTool(0)->IsDataValid());
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkVirtualTrackingDevice)
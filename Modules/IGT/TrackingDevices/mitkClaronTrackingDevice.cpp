@@ -294,6 +294,7 @@ void mitk::ClaronTrackingDevice::TrackTools()
           currentTool->SetDataValid(false);
         }
       }
+      this->PublishToolData();
       /* Update the local copy of m_StopTracking */
       this->m_StopTrackingMutex->Lock();
       localStopTracking = m_StopTracking;
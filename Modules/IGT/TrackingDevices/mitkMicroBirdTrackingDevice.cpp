@@ -396,6 +396,7 @@ void mitk::MicroBirdTrackingDevice::TrackTools()
 
     /// @todo : is there any synchronisation?
     // Average timestamp: timeStamp/nOfAttachedSensors
+    this->PublishToolData();
 
     // Compute sleep time
     double sleepTime = updateRate - measurementDuration;
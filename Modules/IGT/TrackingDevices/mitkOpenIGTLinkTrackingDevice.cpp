@@ -294,6 +294,7 @@ void mitk::OpenIGTLinkTrackingDevice::UpdateTools()
 
     //MITK_INFO << "Updated Tool " << i << " Pos: " << pos;
   }
+  this->PublishToolData();
 }
 
 bool mitk::OpenIGTLinkTrackingDevice::StartTracking()
@@ -475,6 +475,7 @@ void mitk::OptitrackTrackingDevice::TrackTools()
           mitkThrowException(mitk::IGTException) << "Get data from tool number " << i << " failed";
         }
       }
+      this->PublishToolData();
 
       /* Update the local copy of m_StopTracking */
       this->m_StopTrackingMutex->Lock();
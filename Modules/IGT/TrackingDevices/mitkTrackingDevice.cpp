@@ -58,8 +58,7 @@ return true;
 
 mitk::TrackingDevice::TrackingDeviceState mitk::TrackingDevice::GetState() const
 {
-  MutexLockHolder lock(*m_StateMutex);
-  return m_State;
+  return m_State.load();
 }
 
 
@@ -136,3 +135,10 @@ mitk::TrackingTool* mitk::TrackingDevice::GetToolByName( std::string name ) cons
   return nullptr;
 }
 
+
+void mitk::TrackingDevice::PublishToolData()
+{
+  unsigned int toolCount = this->GetToolCount();
+  for (unsigned int i = 0; i < toolCount; ++i)
+    this->GetTool(i)->PublishSample();
+}
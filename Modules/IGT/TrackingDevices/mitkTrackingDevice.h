@@ -24,6 +24,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkTrackingTypes.h"
 #include "itkFastMutexLock.h"
 
+#include <atomic>
+
 
 namespace mitk {
     class TrackingTool; // interface for a tool that can be tracked by the TrackingDevice
@@ -170,16 +172,24 @@ namespace mitk {
       */
       void SetState(TrackingDeviceState state);
 
+      /**
+      * \brief Publishes the current data of all tools to their sample buffers.
+      *
+      * Has to be called by the tracking thread after each update of the tools. Consumers like
+      * mitk::TrackingDeviceSource read the samples without locking the tools (see mitk::TrackingSampleBuffer).
+      */
+      void PublishToolData();
+
 
       TrackingDevice();
       virtual ~TrackingDevice();
 
     TrackingDeviceData m_Data; ///< current device Data
-      TrackingDeviceState m_State; ///< current object state (Setup, Ready or Tracking)
+      std::atomic<TrackingDeviceState> m_State; ///< current object state (Setup, Ready or Tracking), can be read without locking
       bool m_StopTracking;       ///< signal stop to tracking thread
       itk::FastMutexLock::Pointer m_StopTrackingMutex; ///< mutex to control access to m_StopTracking
       itk::FastMutexLock::Pointer m_TrackingFinishedMutex; ///< mutex to manage control flow of StopTracking()
-      itk::FastMutexLock::Pointer m_StateMutex; ///< mutex to control access to m_State
+      itk::FastMutexLock::Pointer m_StateMutex; ///< mutex to serialize changes of m_State
       RotationMode m_RotationMode; ///< defines the rotation mode Standard or Transposed, Standard is default
     };
 } // namespace mitk
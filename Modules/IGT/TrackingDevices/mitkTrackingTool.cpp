@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkTrackingTool.h"
+#include "mitkIGTTimeStamp.h"
 #include <itkMutexLockHolder.h>
 
 typedef itk::MutexLockHolder<itk::FastMutexLock> MutexLockHolder;
@@ -24,6 +25,7 @@ mitk::TrackingTool::TrackingTool()
 : itk::Object(), m_ToolName(""), m_ErrorMessage(""), m_IGTTimeStamp(0)
 {
   m_MyMutex = itk::FastMutexLock::New();
+  m_SampleBuffer = mitk::TrackingSampleBuffer::New();
 }
 
 
@@ -52,3 +54,25 @@ const char* mitk::TrackingTool::GetErrorMessage() const
  MutexLockHolder lock(*m_MyMutex); // lock and unlock the mutex
  return this->m_ErrorMessage.c_str();
 }
+
+
+void mitk::TrackingTool::PublishSample()
+{
+  mitk::TrackingSampleBuffer::Sample sample;
+  this->GetPosition(sample.m_Position);
+  this->GetOrientation(sample.m_Orientation);
+  sample.m_TrackingError = this->GetTrackingError();
+  sample.m_DataValid = this->IsEnabled() && this->IsDataValid();
+  sample.m_IGTTimeStamp = this->GetIGTTimeStamp();
+  sample.m_PublishTimeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+  // for backward compatibility: devices that do not set the timestamp acquire the data right before publishing it
+  if (sample.m_IGTTimeStamp == 0)
+    sample.m_IGTTimeStamp = sample.m_PublishTimeStamp;
+  m_SampleBuffer->Push(sample);
+}
+
+
+mitk::TrackingSampleBuffer* mitk::TrackingTool::GetSampleBuffer() const
+{
+  return m_SampleBuffer.GetPointer();
+}
@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkCommon.h>
 #include <mitkNumericTypes.h>
 #include <itkFastMutexLock.h>
+#include "mitkTrackingSampleBuffer.h"
 
 namespace mitk
 {
@@ -53,6 +54,11 @@ namespace mitk
     itkSetMacro(IGTTimeStamp, double);               ///< Sets the IGT timestamp of the tracking tool object (time in milliseconds)
     itkGetConstMacro(IGTTimeStamp, double);          ///< Gets the IGT timestamp of the tracking tool object (time in milliseconds). Returns 0 if the timestamp was not set.
 
+    /** \brief Copies the current data of the tool to its sample buffer. Called by the tracking thread of the device after the tool was updated. */
+    virtual void PublishSample();
+    /** \brief Returns the buffer with the samples published by the tracking thread, which can be read without locking. */
+    TrackingSampleBuffer* GetSampleBuffer() const;
+
   protected:
     TrackingTool();
     virtual ~TrackingTool();
@@ -60,6 +66,7 @@ namespace mitk
     std::string m_ErrorMessage;                      ///< if a tool is invalid, this member should contain a human readable explanation of why it is invalid
     double m_IGTTimeStamp;                           ///< contains the time at which the tracking data was recorded
     itk::FastMutexLock::Pointer m_MyMutex;           ///< mutex to control concurrent access to the tool
+    TrackingSampleBuffer::Pointer m_SampleBuffer;    ///< samples published by the tracking thread
   };
 } // namespace mitk
 #endif /* MITKTRACKINGTOOL_H_HEADER_INCLUDED_ */
@@ -23,7 +23,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <time.h>
 #include <itksys/SystemTools.hxx>
 #include <itkMutexLockHolder.h>
+#include <chrono>
 #include <random>
+#include <thread>
 
 #include <mitkVirtualTrackerTypeInformation.h>
 
@@ -32,7 +34,8 @@ typedef itk::MutexLockHolder<itk::FastMutexLock> MutexLockHolder;
 
 mitk::VirtualTrackingDevice::VirtualTrackingDevice() : mitk::TrackingDevice(),
 m_AllTools(), m_ToolsMutex(NULL), m_MultiThreader(NULL), m_ThreadID(-1), m_RefreshRate(100), m_NumberOfControlPoints(20), m_GaussianNoiseEnabled(false),
-m_MeanDistributionParam(0.0), m_DeviationDistributionParam(1.0)
+m_MeanDistributionParam(0.0), m_DeviationDistributionParam(1.0), m_UpdateFrequency(0.0), m_Jitter(0.0), m_DropoutProbability(0.0),
+m_RandomGenerator(std::random_device()())
 {
   m_Data = mitk::VirtualTrackerTypeInformation::GetDeviceDataVirtualTracker();
   m_Bounds[0] = m_Bounds[2] = m_Bounds[4] = -400.0;  // initialize bounds to -400 ... +400 (mm) cube
@@ -239,34 +242,58 @@ void mitk::VirtualTrackingDevice::TrackTools()
     }
     this->m_StopTrackingMutex->Unlock();
 
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration interval = (m_UpdateFrequency > 0.0)
+      ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_UpdateFrequency))
+      : std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(m_RefreshRate));
+    const double jitter = m_Jitter;
+    const double dropoutProbability = m_DropoutProbability;
+    std::uniform_real_distribution<double> jitterDistribution(0.0, jitter);
+    std::bernoulli_distribution dropoutDistribution(dropoutProbability);
+
+    ToolContainer tools; // copy of the tool container, so that the mutex is locked only once per update
+    Clock::time_point nextUpdate = Clock::now();
     mitk::ScalarType t = 0.0;
     while ((this->GetState() == Tracking) && (localStopTracking == false))
     {
-      //for (ToolContainer::iterator itAllTools = m_AllTools.begin(); itAllTools != m_AllTools.end(); itAllTools++)
-      for (unsigned int i = 0; i < this->GetToolCount(); ++i)  // use mutexed methods to access tool container
       {
-        mitk::VirtualTrackingTool::Pointer currentTool = this->GetInternalTool(i);
+        MutexLockHolder lock(*m_ToolsMutex); // lock and unlock the mutex
+        tools.assign(m_AllTools.begin(), m_AllTools.end());
+      }
+      const double timeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+
+      for (ToolContainer::iterator itAllTools = tools.begin(); itAllTools != tools.end(); ++itAllTools)
+      {
+        mitk::VirtualTrackingTool* currentTool = *itAllTools;
+        currentTool->SetIGTTimeStamp(timeStamp);
+
+        // Currently, a constant speed is used. TODO: use tool velocity setting
+        t += 0.001;
+        if (t >= 1.0)
+          t = 0.0;
+
+        if (dropoutProbability > 0.0 && dropoutDistribution(m_RandomGenerator))
+        {
+          currentTool->SetDataValid(false);
+          currentTool->Modified();
+          continue;
+        }
+
         mitk::VirtualTrackingTool::SplineType::PointType pos;
         /* calculate tool position with spline interpolation */
         pos = currentTool->GetSpline()->EvaluateSpline(t);
         mitk::Point3D mp;
         mitk::itk2vtk(pos, mp); // convert from SplineType::PointType to mitk::Point3D
 
-    //Add Gaussian Noise to Tracking Coordinates if enabled
-    if (this->m_GaussianNoiseEnabled)
-    {
-      std::random_device rd;
-      std::mt19937 generator(rd());
-      std::normal_distribution<double> dist(this->m_MeanDistributionParam, this->m_DeviationDistributionParam);
-      double noise = dist(generator);
-      mp = mp + noise;
-    }
+        //Add Gaussian Noise to Tracking Coordinates if enabled
+        if (this->m_GaussianNoiseEnabled)
+        {
+          std::normal_distribution<double> dist(this->m_MeanDistributionParam, this->m_DeviationDistributionParam);
+          double noise = dist(m_RandomGenerator);
+          mp = mp + noise;
+        }
 
         currentTool->SetPosition(mp);
-        // Currently, a constant speed is used. TODO: use tool velocity setting
-        t += 0.001;
-        if (t >= 1.0)
-          t = 0.0;
 
         mitk::Quaternion quat;
         /* fix quaternion rotation */
@@ -282,7 +309,18 @@ void mitk::VirtualTrackingDevice::TrackTools()
         currentTool->SetDataValid(true);
         currentTool->Modified();
       }
-      itksys::SystemTools::Delay(m_RefreshRate);
+      this->PublishToolData();
+
+      /* wait for the next update, which is scheduled independently of the time needed for this one */
+      nextUpdate += interval;
+      Clock::time_point wakeUp = nextUpdate;
+      if (jitter > 0.0)
+        wakeUp += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(jitterDistribution(m_RandomGenerator)));
+      std::this_thread::sleep_until(wakeUp);
+      const Clock::time_point now = Clock::now();
+      if (now - wakeUp > interval) // the thread fell behind, e.g. because it was not scheduled
+        nextUpdate = now;
+
       /* Update the local copy of m_StopTracking */
       this->m_StopTrackingMutex->Lock();
       localStopTracking = m_StopTracking;
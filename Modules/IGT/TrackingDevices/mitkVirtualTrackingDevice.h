@@ -23,6 +23,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkMultiThreader.h>
 
 #include "itkFastMutexLock.h"
+#include <limits>
+#include <random>
 #include <vector>
 
 namespace mitk
@@ -34,6 +36,12 @@ namespace mitk
   * This TrackingDevice class does not interface with a physical tracking device. It simulates
   * a tracking device by moving the tools on a randomly generated spline path.
   *
+  * The device can also be used as a load generator for the IGT pipeline: with SetUpdateFrequency()
+  * it updates any number of tools at rates of several kHz, SetJitter() delays the updates randomly
+  * and SetDropoutProbability() lets tools disappear at random updates like tools that are hidden
+  * from the camera of an optical tracking system. Each update is stamped with the IGT time stamp
+  * of its acquisition, so the latency of the pipeline can be measured.
+  *
   * \ingroup IGT
   */
   class MITKIGT_EXPORT VirtualTrackingDevice : public TrackingDevice
@@ -59,6 +67,36 @@ namespace mitk
     */
     itkGetConstMacro(RefreshRate, unsigned int)
 
+    /**
+    * \brief Sets the number of updates per second, e.g. 2000 to simulate a 2 kHz tracking system.
+    *
+    * The default of 0 uses the refresh rate set by SetRefreshRate() instead. The updates are scheduled
+    * at fixed points in time, so the time needed for an update does not lower the rate. If the tracking
+    * thread falls behind by more than one update, it continues with the next update instead of catching up.
+    * Changes take effect with the next call of StartTracking().
+    */
+    itkSetMacro(UpdateFrequency, double)
+    itkGetConstMacro(UpdateFrequency, double)
+
+    /**
+    * \brief Sets the maximum random delay of an update in ms, 0 by default.
+    *
+    * Each update is delayed by a uniformly distributed time between 0 and the jitter, measured from
+    * its regular point in time, so the delays do not accumulate.
+    * Changes take effect with the next call of StartTracking().
+    */
+    itkSetClampMacro(Jitter, double, 0.0, std::numeric_limits<double>::max())
+    itkGetConstMacro(Jitter, double)
+
+    /**
+    * \brief Sets the probability that a tool is not visible at an update, 0 by default.
+    *
+    * At a dropout the tool keeps its last position and its data is invalid.
+    * Changes take effect with the next call of StartTracking().
+    */
+    itkSetClampMacro(DropoutProbability, double, 0.0, 1.0)
+    itkGetConstMacro(DropoutProbability, double)
+
     /**
     * \brief Starts the tracking.
     *
@@ -215,6 +253,11 @@ namespace mitk
   bool m_GaussianNoiseEnabled;    ///< adding Gaussian Noise to tracking coordinates or not, false by default
   double m_MeanDistributionParam;    /// mean distribution for Gaussion Noise, 0.0 by default
   double m_DeviationDistributionParam;  ///< deviation distribution for Gaussian Noise, 1.0 by default
+
+  double m_UpdateFrequency;        ///< updates per second, 0 to use m_RefreshRate
+  double m_Jitter;                 ///< maximum random delay of an update in ms
+  double m_DropoutProbability;     ///< probability that a tool is invalid at an update
+  std::mt19937 m_RandomGenerator;  ///< used by the tracking thread for noise, jitter and dropouts
   };
 }//mitk
 #endif /* MITKVIRTUALTRACKINGDEVICE_H_HEADER_INCLUDED_ */
@@ -17,6 +17,7 @@ set(CPP_FILES
 
   Common/mitkIGTTimeStamp.cpp
   Common/mitkSerialCommunication.cpp
+  Common/mitkTrackingSampleBuffer.cpp
 
   DataManagement/mitkNavigationDataSource.cpp
   DataManagement/mitkNavigationTool.cpp
@@ -0,0 +1,192 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+// MITK
+#include "mitkNavigationDataReaderBinary.h"
+#include <mitkIGTMimeTypes.h>
+#include <mitkIGTIOException.h>
+#include <mitkNavigationDataBinaryFormat.h>
+#include <mitkMemoryMappedFile.h>
+
+// STL
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+mitk::NavigationDataReaderBinary::NavigationDataReaderBinary() : AbstractFileReader(
+  mitk::IGTMimeTypes::NAVIGATIONDATASETBINARY_MIMETYPE(),
+  "MITK NavigationData Reader (binary)")
+{
+  RegisterService();
+}
+
+mitk::NavigationDataReaderBinary::NavigationDataReaderBinary(const mitk::NavigationDataReaderBinary& other) : AbstractFileReader(other)
+{
+}
+
+mitk::NavigationDataReaderBinary::~NavigationDataReaderBinary()
+{
+}
+
+mitk::NavigationDataReaderBinary* mitk::NavigationDataReaderBinary::Clone() const
+{
+  return new NavigationDataReaderBinary(*this);
+}
+
+std::vector<itk::SmartPointer<mitk::BaseData>> mitk::NavigationDataReaderBinary::Read()
+{
+  mitk::NavigationDataSet::Pointer dataset;
+  std::istream* in = GetInputStream();
+  if (in == nullptr)
+  {
+    mitk::MemoryMappedFile::Pointer file = mitk::MemoryMappedFile::New();
+    try
+    {
+      file->Open(GetInputLocation(), 0, 0, mitk::MemoryMappedFile::ReadOnly);
+    }
+    catch (const mitk::Exception& e)
+    {
+      mitkThrowException(mitk::IGTIOException) << "File '" << GetInputLocation() << "' could not be loaded: " << e.GetDescription();
+    }
+    dataset = this->ReadNavigationDataSet(static_cast<const char*>(file->GetData()), file->GetLength());
+  }
+  else
+  {
+    std::vector<char> content((std::istreambuf_iterator<char>(*in)), std::istreambuf_iterator<char>());
+    dataset = this->ReadNavigationDataSet(content.data(), content.size());
+  }
+
+  std::vector<mitk::BaseData::Pointer> result;
+  result.push_back(dataset.GetPointer());
+  return result;
+}
+
+mitk::NavigationDataSet::Pointer mitk::NavigationDataReaderBinary::ReadNavigationDataSet(const char* data, std::size_t length)
+{
+  NavigationDataBinaryFormat::FileHeader header;
+  if (length < sizeof(header))
+  {
+    mitkThrowException(mitk::IGTIOException) << "File is too short for a navigation data file.";
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.m_Magic, NavigationDataBinaryFormat::Magic, sizeof(header.m_Magic)) != 0)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File is no binary navigation data file.";
+  }
+  if (header.m_ByteOrderMark != NavigationDataBinaryFormat::ByteOrderMark)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File was written on a machine with a different byte order.";
+  }
+  if (header.m_Version != NavigationDataBinaryFormat::Version)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File format version " << header.m_Version << " is not supported.";
+  }
+  if (length - sizeof(header) < header.m_ToolNamesLength)
+  {
+    mitkThrowException(mitk::IGTIOException) << "File ends within the tool names.";
+  }
+
+  const unsigned int numberOfTools = header.m_NumberOfTools;
+  std::size_t position = sizeof(header);
+
+  // every navigation data is reused for all time steps, the set copies the values
+  std::vector<mitk::NavigationData::Pointer> navigationDatas;
+  const char* name = data + position;
+  const char* namesEnd = name + header.m_ToolNamesLength;
+  for (unsigned int toolIndex = 0; toolIndex < numberOfTools; ++toolIndex)
+  {
+    mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+    const char* nameEnd = name < namesEnd ? std::find(name, namesEnd, '\0') : name;
+    nd->SetName(std::string(name, nameEnd));
+    name = nameEnd + 1;
+    navigationDatas.push_back(nd);
+  }
+  position += header.m_ToolNamesLength;
+
+  const std::size_t timeStepSize = sizeof(NavigationDataBinaryFormat::BlockHeader)
+    + numberOfTools * sizeof(NavigationDataBinaryFormat::Sample);
+  const std::size_t covErrorMatrixSize = sizeof(NavigationDataBinaryFormat::BlockHeader)
+    + NavigationDataBinaryFormat::CovErrorMatrixSize * sizeof(double);
+
+  mitk::NavigationDataSet::Pointer navigationDataSet = mitk::NavigationDataSet::New(numberOfTools);
+  navigationDataSet->Reserve(static_cast<unsigned int>((length - position) / timeStepSize));
+
+  while (position + sizeof(NavigationDataBinaryFormat::BlockHeader) <= length)
+  {
+    NavigationDataBinaryFormat::BlockHeader blockHeader;
+    std::memcpy(&blockHeader, data + position, sizeof(blockHeader));
+
+    if (blockHeader.m_Type == NavigationDataBinaryFormat::CovErrorMatrixBlock)
+    {
+      if (length - position < covErrorMatrixSize)
+        break;
+      if (blockHeader.m_ToolIndex >= numberOfTools)
+      {
+        mitkThrowException(mitk::IGTIOException) << "Covariance matrix of unknown tool " << blockHeader.m_ToolIndex << " found.";
+      }
+
+      double values[NavigationDataBinaryFormat::CovErrorMatrixSize];
+      std::memcpy(values, data + position + sizeof(blockHeader), sizeof(values));
+      mitk::NavigationData::CovarianceMatrixType matrix;
+      for (unsigned int row = 0; row < 6; ++row)
+        for (unsigned int column = 0; column < 6; ++column)
+          matrix[row][column] = values[row * 6 + column];
+      navigationDatas[blockHeader.m_ToolIndex]->SetCovErrorMatrix(matrix);
+
+      position += covErrorMatrixSize;
+    }
+    else if (blockHeader.m_Type == NavigationDataBinaryFormat::TimeStepBlock)
+    {
+      if (length - position < timeStepSize)
+      {
+        MITK_WARN("NavigationDataReaderBinary") << "Ignoring incomplete last time step.";
+        break;
+      }
+
+      const char* samples = data + position + sizeof(blockHeader);
+      for (unsigned int toolIndex = 0; toolIndex < numberOfTools; ++toolIndex)
+      {
+        NavigationDataBinaryFormat::Sample sample;
+        std::memcpy(&sample, samples + toolIndex * sizeof(sample), sizeof(sample));
+
+        mitk::NavigationData* nd = navigationDatas[toolIndex];
+        mitk::NavigationData::PositionType ndPosition;
+        for (unsigned int i = 0; i < 3; ++i)
+          ndPosition[i] = sample.m_Position[i];
+        mitk::NavigationData::OrientationType orientation(sample.m_Orientation[0], sample.m_Orientation[1],
+          sample.m_Orientation[2], sample.m_Orientation[3]);
+
+        nd->SetIGTTimeStamp(sample.m_IGTTimeStamp);
+        nd->SetPosition(ndPosition);
+        nd->SetOrientation(orientation);
+        nd->SetDataValid((sample.m_Flags & NavigationDataBinaryFormat::DataValidFlag) != 0);
+        nd->SetHasPosition((sample.m_Flags & NavigationDataBinaryFormat::HasPositionFlag) != 0);
+        nd->SetHasOrientation((sample.m_Flags & NavigationDataBinaryFormat::HasOrientationFlag) != 0);
+      }
+      navigationDataSet->AddNavigationDatas(navigationDatas);
+
+      position += timeStepSize;
+    }
+    else
+    {
+      mitkThrowException(mitk::IGTIOException) << "Unknown block type " << blockHeader.m_Type << " found.";
+    }
+  }
+
+  return navigationDataSet;
+}
@@ -0,0 +1,52 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef MITKNavigationDataReaderBinary_H_HEADER_INCLUDED_
+#define MITKNavigationDataReaderBinary_H_HEADER_INCLUDED_
+
+#include <mitkAbstractFileReader.h>
+#include <mitkNavigationDataSet.h>
+
+namespace mitk {
+  /** This class reads navigation data sets that were written by
+   *  mitk::NavigationDataBinaryStreamWriter.
+   *
+   *  Files are mapped into memory and the samples are copied into the columns of the
+   *  mitk::NavigationDataSet directly, without parsing any text.
+   */
+  class NavigationDataReaderBinary : public AbstractFileReader
+  {
+  public:
+    NavigationDataReaderBinary();
+    virtual ~NavigationDataReaderBinary();
+
+    using AbstractFileReader::Read;
+    virtual std::vector<itk::SmartPointer<BaseData>> Read() override;
+
+  protected:
+
+    /**
+     * /brief Reads the set from the content of a file, throws mitk::IGTIOException if it is no valid file.
+     */
+    mitk::NavigationDataSet::Pointer ReadNavigationDataSet(const char* data, std::size_t length);
+
+    NavigationDataReaderBinary(const NavigationDataReaderBinary& other);
+    virtual mitk::NavigationDataReaderBinary* Clone() const override;
+  };
+}
+
+#endif // MITKNavigationDataReaderBinary_H_HEADER_INCLUDED_
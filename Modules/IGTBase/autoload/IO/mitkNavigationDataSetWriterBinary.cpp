@@ -0,0 +1,64 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#include "mitkNavigationDataSetWriterBinary.h"
+#include <mitkNavigationDataBinaryStreamWriter.h>
+#include <mitkIGTMimeTypes.h>
+
+mitk::NavigationDataSetWriterBinary::NavigationDataSetWriterBinary() : AbstractFileWriter(NavigationDataSet::GetStaticNameOfClass(),
+  mitk::IGTMimeTypes::NAVIGATIONDATASETBINARY_MIMETYPE(),
+  "MITK NavigationDataSet Writer (binary)")
+{
+  RegisterService();
+}
+
+mitk::NavigationDataSetWriterBinary::~NavigationDataSetWriterBinary()
+{}
+
+mitk::NavigationDataSetWriterBinary::NavigationDataSetWriterBinary(const mitk::NavigationDataSetWriterBinary& other) : AbstractFileWriter(other)
+{
+}
+
+mitk::NavigationDataSetWriterBinary* mitk::NavigationDataSetWriterBinary::Clone() const
+{
+  return new NavigationDataSetWriterBinary(*this);
+}
+
+void mitk::NavigationDataSetWriterBinary::Write()
+{
+  mitk::NavigationDataSet::ConstPointer data = dynamic_cast<const NavigationDataSet*> (this->GetInput());
+
+  std::vector<std::string> toolNames;
+  for (unsigned int toolIndex = 0; data->Size() > 0 && toolIndex < data->GetNumberOfTools(); toolIndex++)
+  {
+    toolNames.push_back(data->GetNavigationDataForIndex(0, toolIndex)->GetName());
+  }
+
+  mitk::NavigationDataBinaryStreamWriter::Pointer writer = mitk::NavigationDataBinaryStreamWriter::New();
+  std::ostream* out = GetOutputStream();
+  if (out == nullptr)
+  {
+    writer->Open(GetOutputLocation(), data->GetNumberOfTools(), toolNames);
+  }
+  else
+  {
+    writer->Open(out, data->GetNumberOfTools(), toolNames);
+  }
+
+  writer->AddNavigationDataSet(data);
+  writer->Close();
+}
@@ -71,12 +71,12 @@ void mitk::NavigationDataSetWriterCSV::Write()
 
   //write data
   MITK_INFO << "Number of timesteps: " << data->Size();
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
   for (unsigned int i=0; i<data->Size(); i++)
   {
-    std::vector< mitk::NavigationData::Pointer > NavigationDatasOfCurrentStep = data->GetTimeStep(i);
     for (unsigned int toolIndex = 0; toolIndex < numberOfTools; toolIndex++)
     {
-      mitk::NavigationData::Pointer nd = NavigationDatasOfCurrentStep.at(toolIndex);
+      data->CopyNavigationDataForIndex(i, toolIndex, nd);
       *out             << nd->GetTimeStamp() << ";"
                        << nd->IsDataValid() << ";"
                        << nd->GetPosition()[0] << ";"
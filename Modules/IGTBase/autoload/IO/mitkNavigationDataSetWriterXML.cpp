@@ -86,12 +86,14 @@ void mitk::NavigationDataSetWriterXML::StreamHeader (std::ostream* stream, mitk:
 
 void mitk::NavigationDataSetWriterXML::StreamData (std::ostream* stream, mitk::NavigationDataSet::ConstPointer data)
 {
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+
   // For each time step in the Dataset
   for (auto it = data->Begin(); it != data->End(); it++)
   {
-    for (std::size_t toolIndex = 0; toolIndex < it->size(); toolIndex++)
+    for (unsigned int toolIndex = 0; toolIndex < data->GetNumberOfTools(); toolIndex++)
     {
-      mitk::NavigationData::Pointer nd = it->at(toolIndex);
+      data->CopyNavigationDataForIndex(it.GetIndex(), toolIndex, nd);
       auto  elem = new TiXmlElement("ND");
 
       elem->SetDoubleAttribute("Time", nd->GetIGTTimeStamp());
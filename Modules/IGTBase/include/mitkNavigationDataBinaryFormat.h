@@ -0,0 +1,88 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef MITKNAVIGATIONDATABINARYFORMAT_H_HEADER_INCLUDED_
+#define MITKNAVIGATIONDATABINARYFORMAT_H_HEADER_INCLUDED_
+
+#include <cstdint>
+
+namespace mitk {
+  /**
+  * \brief Layout of the binary file format for recordings of mitk::NavigationData.
+  *
+  * The format is written by mitk::NavigationDataBinaryStreamWriter while recording and can be
+  * read by mapping the file into memory, no text has to be parsed. All values are stored in the
+  * byte order of the writing machine, which is detected by m_ByteOrderMark, and every double
+  * starts at a multiple of 8 bytes.
+  *
+  * A file consists of
+  * - a FileHeader,
+  * - m_ToolNamesLength bytes with the zero terminated names of all tools, padded to a multiple of 8 bytes,
+  * - a sequence of blocks, each starting with a BlockHeader:
+  *   - CovErrorMatrixBlock: 36 doubles (row by row), the covariance matrix of tool m_ToolIndex from the next time step on,
+  *   - TimeStepBlock: one Sample for each tool.
+  *
+  * The last time step may be incomplete if a recording was interrupted, readers ignore it.
+  */
+  namespace NavigationDataBinaryFormat
+  {
+    const char Magic[8] = { 'M', 'I', 'T', 'K', 'N', 'D', 'B', '\0' };
+    const std::uint32_t ByteOrderMark = 0x01020304;
+    const std::uint32_t Version = 1;
+
+    enum BlockType
+    {
+      TimeStepBlock = 1,
+      CovErrorMatrixBlock = 2
+    };
+
+    enum SampleFlags
+    {
+      DataValidFlag = 1,
+      HasPositionFlag = 2,
+      HasOrientationFlag = 4
+    };
+
+    struct FileHeader
+    {
+      char m_Magic[8];
+      std::uint32_t m_ByteOrderMark;
+      std::uint32_t m_Version;
+      std::uint32_t m_NumberOfTools;
+      std::uint32_t m_ToolNamesLength;
+    };
+
+    struct BlockHeader
+    {
+      std::uint32_t m_Type;
+      std::uint32_t m_ToolIndex;   ///< tool of a CovErrorMatrixBlock, 0 for a TimeStepBlock
+    };
+
+    struct Sample
+    {
+      double m_IGTTimeStamp;
+      double m_Position[3];
+      double m_Orientation[4];     ///< x, y, z, r as in mitk::Quaternion
+      std::uint32_t m_Flags;       ///< combination of SampleFlags
+      std::uint32_t m_Reserved;
+    };
+
+    const unsigned int CovErrorMatrixSize = 36;
+  }
+}
+
+#endif // MITKNAVIGATIONDATABINARYFORMAT_H_HEADER_INCLUDED_
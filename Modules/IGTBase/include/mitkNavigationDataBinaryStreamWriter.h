@@ -0,0 +1,98 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef MITKNAVIGATIONDATABINARYSTREAMWRITER_H_HEADER_INCLUDED_
+#define MITKNAVIGATIONDATABINARYSTREAMWRITER_H_HEADER_INCLUDED_
+
+#include <MitkIGTBaseExports.h>
+#include "mitkNavigationData.h"
+#include "mitkNavigationDataSet.h"
+#include <itkObject.h>
+
+#include <fstream>
+
+namespace mitk {
+  /**
+  * \brief Writes mitk::NavigationData time step by time step into the binary format described in mitk::NavigationDataBinaryFormat.
+  *
+  * In contrast to the file writers, nothing has to be kept in memory: each time step is appended
+  * to the stream as soon as it is added, so this writer can be used while recording. Files written
+  * by this class are read with mitk::IOUtil like all other mitk::NavigationDataSet files.
+  *
+  * All methods throw mitk::IGTIOException if the stream cannot be written.
+  *
+  * \ingroup IGT
+  */
+  class MITKIGTBASE_EXPORT NavigationDataBinaryStreamWriter : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(NavigationDataBinaryStreamWriter, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /**
+    * \brief Creates the file and writes the header. A previously opened file is closed first.
+    *
+    * @param toolNames names of the tools, may be empty or shorter than numberOfTools
+    */
+    void Open(const std::string& fileName, unsigned int numberOfTools, const std::vector<std::string>& toolNames = std::vector<std::string>());
+
+    /**
+    * \brief Writes into the given stream, which has to be opened in binary mode and stays owned by the caller.
+    */
+    void Open(std::ostream* stream, unsigned int numberOfTools, const std::vector<std::string>& toolNames = std::vector<std::string>());
+
+    /**
+    * \brief Appends one time step, the vector must contain GetNumberOfTools() navigation datas.
+    */
+    void AddNavigationDatas(const std::vector<mitk::NavigationData::Pointer>& navigationDatas);
+
+    /**
+    * \brief Appends all time steps of the given set.
+    */
+    void AddNavigationDataSet(const mitk::NavigationDataSet* navigationDataSet);
+
+    /** \brief Writes buffered data to the file. */
+    void Flush();
+
+    /** \brief Flushes and closes the file. Does nothing if no file is open. */
+    void Close();
+
+    bool IsOpen() const;
+
+    unsigned int GetNumberOfTools() const;
+
+    /** \brief Returns the number of time steps written since the file was opened. */
+    unsigned long GetNumberOfTimeSteps() const;
+
+  protected:
+    NavigationDataBinaryStreamWriter();
+    virtual ~NavigationDataBinaryStreamWriter();
+
+    void WriteHeader(const std::vector<std::string>& toolNames);
+    void WriteBytes(const void* data, std::size_t length);
+
+    std::ofstream m_FileStream;
+    std::ostream* m_Stream;
+    unsigned int m_NumberOfTools;
+    unsigned long m_NumberOfTimeSteps;
+
+    /** \brief Covariance matrices last written for each tool, a new block is only written if it changes. */
+    std::vector<mitk::NavigationData::CovarianceMatrixType> m_CovErrorMatrices;
+  };
+} // namespace mitk
+
+#endif // MITKNAVIGATIONDATABINARYSTREAMWRITER_H_HEADER_INCLUDED_
@@ -21,6 +21,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBaseData.h"
 #include "mitkNavigationData.h"
 
+#include <iterator>
+#include <vector>
+
 namespace mitk {
   /**
   * \brief Data structure which stores streams of mitk::NavigationData for
@@ -35,20 +38,70 @@ namespace mitk {
   public:
 
     /**
-    * \brief This iterator iterates over the distinct time steps in this set.
+    * \brief This iterator iterates over the distinct time steps in this set. And is const.
     *
     * It returns an array of the length equal to GetNumberOfTools(), containing a
-    * mitk::NavigationData for each tool..
+    * mitk::NavigationData for each tool. As the set stores its data in columns, the
+    * mitk::NavigationData objects are created on dereferencing. Use GetIndex() together with
+    * CopyNavigationDataForIndex() or GetIGTTimeStampForIndex() to avoid these allocations.
     */
-    typedef std::vector< std::vector<mitk::NavigationData::Pointer> >::iterator NavigationDataSetIterator;
+    class NavigationDataSetConstIterator
+    {
+    public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef std::vector<mitk::NavigationData::Pointer> value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const value_type* pointer;
+      typedef value_type reference;
+
+      /** \brief Holds the time step returned by operator->() */
+      class TimeStepProxy
+      {
+      public:
+        TimeStepProxy(const value_type& timeStep) : m_TimeStep(timeStep) {}
+        const value_type* operator->() const { return &m_TimeStep; }
+      private:
+        value_type m_TimeStep;
+      };
+
+      NavigationDataSetConstIterator() : m_Set(nullptr), m_Index(0) {}
+      NavigationDataSetConstIterator(const NavigationDataSet* set, difference_type index) : m_Set(set), m_Index(index) {}
+
+      /** \brief Returns the index of the time step this iterator points to. */
+      unsigned int GetIndex() const { return static_cast<unsigned int>(m_Index); }
+
+      value_type operator*() const { return m_Set->GetTimeStep(this->GetIndex()); }
+      TimeStepProxy operator->() const { return TimeStepProxy(**this); }
+      value_type operator[](difference_type n) const { return *(*this + n); }
+
+      NavigationDataSetConstIterator& operator++() { ++m_Index; return *this; }
+      NavigationDataSetConstIterator operator++(int) { NavigationDataSetConstIterator it(*this); ++m_Index; return it; }
+      NavigationDataSetConstIterator& operator--() { --m_Index; return *this; }
+      NavigationDataSetConstIterator operator--(int) { NavigationDataSetConstIterator it(*this); --m_Index; return it; }
+      NavigationDataSetConstIterator& operator+=(difference_type n) { m_Index += n; return *this; }
+      NavigationDataSetConstIterator& operator-=(difference_type n) { m_Index -= n; return *this; }
+      NavigationDataSetConstIterator operator+(difference_type n) const { return NavigationDataSetConstIterator(m_Set, m_Index + n); }
+      NavigationDataSetConstIterator operator-(difference_type n) const { return NavigationDataSetConstIterator(m_Set, m_Index - n); }
+      difference_type operator-(const NavigationDataSetConstIterator& other) const { return m_Index - other.m_Index; }
+
+      bool operator==(const NavigationDataSetConstIterator& other) const { return m_Set == other.m_Set && m_Index == other.m_Index; }
+      bool operator!=(const NavigationDataSetConstIterator& other) const { return !(*this == other); }
+      bool operator<(const NavigationDataSetConstIterator& other) const { return m_Index < other.m_Index; }
+      bool operator>(const NavigationDataSetConstIterator& other) const { return m_Index > other.m_Index; }
+      bool operator<=(const NavigationDataSetConstIterator& other) const { return m_Index <= other.m_Index; }
+      bool operator>=(const NavigationDataSetConstIterator& other) const { return m_Index >= other.m_Index; }
+
+    private:
+      const NavigationDataSet* m_Set;
+      difference_type m_Index;
+    };
 
     /**
-    * \brief This iterator iterates over the distinct time steps in this set. And is const.
+    * \brief This iterator iterates over the distinct time steps in this set.
     *
-    * It returns an array of the length equal to GetNumberOfTools(), containing a
-    * mitk::NavigationData for each tool..
+    * The data of the set cannot be modified through an iterator, so this is the same as NavigationDataSetConstIterator.
     */
-    typedef std::vector< std::vector<mitk::NavigationData::Pointer> >::const_iterator NavigationDataSetConstIterator;
+    typedef NavigationDataSetConstIterator NavigationDataSetIterator;
 
     mitkClassMacro(NavigationDataSet, BaseData);
 
@@ -60,8 +113,16 @@ namespace mitk {
     * @param navigationDatas vector of mitk::NavigationData objects to be added. Make sure that the size of the
     * vector equals the number of tools given in the constructor
     * @return true if object was be added to the set successfully, false otherwise
+    *
+    * The values of the objects are copied into the set, so the objects can be reused for the next time step.
+    * The name of each tool is taken from the first time step.
+    */
+    bool AddNavigationDatas( const std::vector<mitk::NavigationData::Pointer>& navigationDatas );
+
+    /**
+    * \brief Reserves memory for the given number of time steps, e.g. before reading a recording of known size.
     */
-    bool AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas );
+    void Reserve( unsigned int numberOfTimeSteps );
 
     /**
     * \brief Get mitk::NavigationData from the given tool at given index.
@@ -72,6 +133,21 @@ namespace mitk {
     */
     NavigationData::Pointer GetNavigationDataForIndex( unsigned int index, unsigned int toolIndex ) const;
 
+    /**
+    * \brief Copies the data of the given tool at given index into an existing mitk::NavigationData.
+    *
+    * Does the same as output->Graft(GetNavigationDataForIndex(index, toolIndex)) without creating
+    * a new object, which is what players and writers should use for every time step.
+    *
+    * @return false if there is no data at the specified indices, output is not changed then.
+    */
+    bool CopyNavigationDataForIndex( unsigned int index, unsigned int toolIndex, mitk::NavigationData* output ) const;
+
+    /**
+    * \brief Returns the IGT time stamp of the given tool at given index, 0 if there is no data at the indices.
+    */
+    NavigationData::TimeStampType GetIGTTimeStampForIndex( unsigned int index, unsigned int toolIndex ) const;
+
     ///**
     //* \brief Get last mitk::Navigation object for given tool whose timestamp is less than the given timestamp.
     //* @param toolIndex Index of the tool from which mitk::NavigationData should be returned.
@@ -84,7 +160,8 @@ namespace mitk {
     /**
     * \brief Returns a vector that contains all tracking data for a given tool.
     *
-    * This is a relatively expensive operation, as it requires the construction of a new vector.
+    * This is a relatively expensive operation, as it requires the construction of a new vector
+    * and of a mitk::NavigationData object for each time step.
     *
     * @param toolIndex Index of the tool for which the stream should be returned.
     * @return Returns a vector that contains all tracking data for a given tool.
@@ -94,7 +171,8 @@ namespace mitk {
     /**
     * \brief Returns a vector that contains NavigationDatas for each tool for a given timestep.
     *
-    * If GetNumberOFTools() equals four, then 4 NavigationDatas will be returned.
+    * If GetNumberOFTools() equals four, then 4 NavigationDatas will be returned. The objects
+    * are created from the stored values, changing them does not change the set.
     *
     * @param index Index of the timeStep for which the datas should be returned. cannot be larger than mitk::NavigationDataSet::Size()
     * @return Returns a vector that contains all tracking data for a given tool.
@@ -153,18 +231,43 @@ namespace mitk {
     NavigationDataSet( unsigned int numTools );
     virtual ~NavigationDataSet( );
 
+    /** \brief Bits of m_Flags */
+    enum Flags
+    {
+      DataValidFlag = 1,
+      HasPositionFlag = 2,
+      HasOrientationFlag = 4
+    };
+
     /**
-    * \brief Holds all the mitk::NavigationData objects managed by this class.
+    * \brief The values of all navigation datas managed by this class, stored column by column.
     *
-    * The first dimension is the index of the navigation data, the second is the
-    * tool to which this data belongs. i.e. the first dimension is usually the longer one.
+    * The element of a tool in a time step is at index * m_NumberOfTools + toolIndex in each of
+    * the columns. Covariance matrices rarely change during a recording, so each element only
+    * holds the index of its matrix in m_CovErrorMatrices, which gets a new entry whenever the
+    * matrix of a tool changes.
+    */
+    std::vector<NavigationData::TimeStampType> m_TimeStamps;
+    std::vector<NavigationData::PositionType> m_Positions;
+    std::vector<NavigationData::OrientationType> m_Orientations;
+    std::vector<unsigned char> m_Flags;
+    std::vector<unsigned int> m_CovErrorMatrixIndices;
+    std::vector<NavigationData::CovarianceMatrixType> m_CovErrorMatrices;
+
+    /**
+    * \brief The names of the tools, as set in the first time step.
     */
-    std::vector<std::vector<NavigationData::Pointer> > m_NavigationDataVectors;
+    std::vector<std::string> m_ToolNames;
 
     /**
     * \brief The Number of Tools that this class is going to support.
     */
     unsigned int m_NumberOfTools;
+
+    /**
+    * \brief The number of time steps stored in the columns.
+    */
+    unsigned int m_NumberOfTimeSteps;
   };
 }
 
@@ -0,0 +1,222 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#include "mitkNavigationDataBinaryStreamWriter.h"
+#include "mitkNavigationDataBinaryFormat.h"
+#include "mitkIGTIOException.h"
+
+#include <cstring>
+
+mitk::NavigationDataBinaryStreamWriter::NavigationDataBinaryStreamWriter()
+  : itk::Object(), m_Stream(nullptr), m_NumberOfTools(0), m_NumberOfTimeSteps(0)
+{
+}
+
+mitk::NavigationDataBinaryStreamWriter::~NavigationDataBinaryStreamWriter()
+{
+  try
+  {
+    this->Close();
+  }
+  catch (const mitk::IGTIOException& e)
+  {
+    MITK_ERROR("NavigationDataBinaryStreamWriter") << e.GetDescription();
+  }
+}
+
+void mitk::NavigationDataBinaryStreamWriter::Open(const std::string& fileName, unsigned int numberOfTools, const std::vector<std::string>& toolNames)
+{
+  this->Close();
+
+  m_FileStream.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_FileStream.good())
+  {
+    m_FileStream.close();
+    mitkThrowException(mitk::IGTIOException) << "File '" << fileName << "' could not be opened for writing.";
+  }
+
+  this->Open(&m_FileStream, numberOfTools, toolNames);
+}
+
+void mitk::NavigationDataBinaryStreamWriter::Open(std::ostream* stream, unsigned int numberOfTools, const std::vector<std::string>& toolNames)
+{
+  if (stream != &m_FileStream)
+    this->Close();
+
+  if (stream == nullptr)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Cannot write navigation data to a null stream.";
+  }
+
+  m_Stream = stream;
+  m_NumberOfTools = numberOfTools;
+  m_NumberOfTimeSteps = 0;
+  m_CovErrorMatrices.assign(numberOfTools, mitk::NavigationData::CovarianceMatrixType());
+
+  this->WriteHeader(toolNames);
+}
+
+void mitk::NavigationDataBinaryStreamWriter::WriteHeader(const std::vector<std::string>& toolNames)
+{
+  std::string names;
+  for (unsigned int i = 0; i < m_NumberOfTools; ++i)
+  {
+    if (i < toolNames.size())
+      names += toolNames[i];
+    names.push_back('\0');
+  }
+  names.resize((names.size() + 7) / 8 * 8, '\0');
+
+  NavigationDataBinaryFormat::FileHeader header;
+  std::memcpy(header.m_Magic, NavigationDataBinaryFormat::Magic, sizeof(header.m_Magic));
+  header.m_ByteOrderMark = NavigationDataBinaryFormat::ByteOrderMark;
+  header.m_Version = NavigationDataBinaryFormat::Version;
+  header.m_NumberOfTools = m_NumberOfTools;
+  header.m_ToolNamesLength = static_cast<std::uint32_t>(names.size());
+
+  this->WriteBytes(&header, sizeof(header));
+  this->WriteBytes(names.data(), names.size());
+}
+
+void mitk::NavigationDataBinaryStreamWriter::AddNavigationDatas(const std::vector<mitk::NavigationData::Pointer>& navigationDatas)
+{
+  if (!this->IsOpen())
+  {
+    mitkThrowException(mitk::IGTIOException) << "Cannot write navigation data, no file is open.";
+  }
+  if (navigationDatas.size() != m_NumberOfTools)
+  {
+    mitkThrowException(mitk::IGTIOException) << "Tried to write " << navigationDatas.size() << " navigation datas to a file for "
+      << m_NumberOfTools << " tools.";
+  }
+
+  // covariance matrices rarely change, so they are only written if they differ from the last one of the tool
+  for (unsigned int toolIndex = 0; toolIndex < m_NumberOfTools; ++toolIndex)
+  {
+    const mitk::NavigationData::CovarianceMatrixType& matrix = navigationDatas[toolIndex]->GetCovErrorMatrix();
+    if (m_NumberOfTimeSteps > 0 && matrix == m_CovErrorMatrices[toolIndex])
+      continue;
+
+    NavigationDataBinaryFormat::BlockHeader blockHeader;
+    blockHeader.m_Type = NavigationDataBinaryFormat::CovErrorMatrixBlock;
+    blockHeader.m_ToolIndex = toolIndex;
+    double values[NavigationDataBinaryFormat::CovErrorMatrixSize];
+    for (unsigned int row = 0; row < 6; ++row)
+      for (unsigned int column = 0; column < 6; ++column)
+        values[row * 6 + column] = matrix[row][column];
+
+    this->WriteBytes(&blockHeader, sizeof(blockHeader));
+    this->WriteBytes(values, sizeof(values));
+    m_CovErrorMatrices[toolIndex] = matrix;
+  }
+
+  NavigationDataBinaryFormat::BlockHeader blockHeader;
+  blockHeader.m_Type = NavigationDataBinaryFormat::TimeStepBlock;
+  blockHeader.m_ToolIndex = 0;
+  this->WriteBytes(&blockHeader, sizeof(blockHeader));
+
+  for (unsigned int toolIndex = 0; toolIndex < m_NumberOfTools; ++toolIndex)
+  {
+    const mitk::NavigationData* nd = navigationDatas[toolIndex];
+
+    NavigationDataBinaryFormat::Sample sample;
+    sample.m_IGTTimeStamp = nd->GetIGTTimeStamp();
+    for (unsigned int i = 0; i < 3; ++i)
+      sample.m_Position[i] = nd->GetPosition()[i];
+    for (unsigned int i = 0; i < 4; ++i)
+      sample.m_Orientation[i] = nd->GetOrientation()[i];
+    sample.m_Flags = 0;
+    if (nd->IsDataValid())
+      sample.m_Flags |= NavigationDataBinaryFormat::DataValidFlag;
+    if (nd->GetHasPosition())
+      sample.m_Flags |= NavigationDataBinaryFormat::HasPositionFlag;
+    if (nd->GetHasOrientation())
+      sample.m_Flags |= NavigationDataBinaryFormat::HasOrientationFlag;
+    sample.m_Reserved = 0;
+
+    this->WriteBytes(&sample, sizeof(sample));
+  }
+
+  ++m_NumberOfTimeSteps;
+}
+
+void mitk::NavigationDataBinaryStreamWriter::AddNavigationDataSet(const mitk::NavigationDataSet* navigationDataSet)
+{
+  if (navigationDataSet == nullptr)
+    return;
+
+  // the navigation datas are reused for all time steps
+  std::vector<mitk::NavigationData::Pointer> navigationDatas;
+  for (unsigned int toolIndex = 0; toolIndex < navigationDataSet->GetNumberOfTools(); ++toolIndex)
+    navigationDatas.push_back(mitk::NavigationData::New());
+
+  for (unsigned int index = 0; index < navigationDataSet->Size(); ++index)
+  {
+    for (unsigned int toolIndex = 0; toolIndex < navigationDataSet->GetNumberOfTools(); ++toolIndex)
+      navigationDataSet->CopyNavigationDataForIndex(index, toolIndex, navigationDatas[toolIndex]);
+    this->AddNavigationDatas(navigationDatas);
+  }
+}
+
+void mitk::NavigationDataBinaryStreamWriter::WriteBytes(const void* data, std::size_t length)
+{
+  m_Stream->write(static_cast<const char*>(data), length);
+  if (!m_Stream->good())
+  {
+    mitkThrowException(mitk::IGTIOException) << "Writing navigation data failed.";
+  }
+}
+
+void mitk::NavigationDataBinaryStreamWriter::Flush()
+{
+  if (m_Stream != nullptr)
+    m_Stream->flush();
+}
+
+void mitk::NavigationDataBinaryStreamWriter::Close()
+{
+  if (m_Stream == nullptr)
+    return;
+
+  this->Flush();
+  m_Stream = nullptr;
+
+  if (m_FileStream.is_open())
+  {
+    m_FileStream.close();
+    if (m_FileStream.fail())
+    {
+      m_FileStream.clear();
+      mitkThrowException(mitk::IGTIOException) << "Closing the navigation data file failed.";
+    }
+  }
+}
+
+bool mitk::NavigationDataBinaryStreamWriter::IsOpen() const
+{
+  return m_Stream != nullptr;
+}
+
+unsigned int mitk::NavigationDataBinaryStreamWriter::GetNumberOfTools() const
+{
+  return m_NumberOfTools;
+}
+
+unsigned long mitk::NavigationDataBinaryStreamWriter::GetNumberOfTimeSteps() const
+{
+  return m_NumberOfTimeSteps;
+}
@@ -17,7 +17,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNavigationDataSet.h"
 
 mitk::NavigationDataSet::NavigationDataSet( unsigned int numberOfTools )
-  : m_NavigationDataVectors(std::vector<std::vector<mitk::NavigationData::Pointer> >()), m_NumberOfTools(numberOfTools)
+  : m_ToolNames(numberOfTools), m_NumberOfTools(numberOfTools), m_NumberOfTimeSteps(0)
 {
 }
 
@@ -25,7 +25,7 @@ mitk::NavigationDataSet::~NavigationDataSet( )
 {
 }
 
-bool mitk::NavigationDataSet::AddNavigationDatas( std::vector<mitk::NavigationData::Pointer> navigationDatas )
+bool mitk::NavigationDataSet::AddNavigationDatas( const std::vector<mitk::NavigationData::Pointer>& navigationDatas )
 {
   // test if tool with given index exist
   if ( navigationDatas.size() != m_NumberOfTools )
@@ -35,35 +35,106 @@ bool mitk::NavigationDataSet::AddNavigationDatas( std::vector<mitk::NavigationDa
   }
 
   // test for consistent timestamp
-  if ( m_NavigationDataVectors.size() > 0)
+  if ( m_NumberOfTimeSteps > 0)
   {
+    const std::size_t last = (m_NumberOfTimeSteps - 1) * m_NumberOfTools;
     for (std::vector<mitk::NavigationData::Pointer>::size_type i = 0; i < navigationDatas.size(); i++)
-      if (navigationDatas[i]->GetIGTTimeStamp() <= m_NavigationDataVectors.back()[i]->GetIGTTimeStamp())
+      if (navigationDatas[i]->GetIGTTimeStamp() <= m_TimeStamps[last + i])
       {
         MITK_WARN("NavigationDataSet") << "IGTTimeStamp of new NavigationData should be newer than timestamp of last NavigationData.";
         return false;
       }
   }
 
-  m_NavigationDataVectors.push_back(navigationDatas);
+  for (std::vector<mitk::NavigationData::Pointer>::size_type i = 0; i < navigationDatas.size(); i++)
+  {
+    const mitk::NavigationData* nd = navigationDatas[i];
+
+    m_TimeStamps.push_back(nd->GetIGTTimeStamp());
+    m_Positions.push_back(nd->GetPosition());
+    m_Orientations.push_back(nd->GetOrientation());
+
+    unsigned char flags = 0;
+    if (nd->IsDataValid())
+      flags |= DataValidFlag;
+    if (nd->GetHasPosition())
+      flags |= HasPositionFlag;
+    if (nd->GetHasOrientation())
+      flags |= HasOrientationFlag;
+    m_Flags.push_back(flags);
+
+    // only store the covariance matrix if it differs from the one of the last time step of this tool
+    if (m_NumberOfTimeSteps > 0
+      && m_CovErrorMatrices[m_CovErrorMatrixIndices[(m_NumberOfTimeSteps - 1) * m_NumberOfTools + i]] == nd->GetCovErrorMatrix())
+    {
+      m_CovErrorMatrixIndices.push_back(m_CovErrorMatrixIndices[(m_NumberOfTimeSteps - 1) * m_NumberOfTools + i]);
+    }
+    else
+    {
+      m_CovErrorMatrixIndices.push_back(static_cast<unsigned int>(m_CovErrorMatrices.size()));
+      m_CovErrorMatrices.push_back(nd->GetCovErrorMatrix());
+    }
+
+    if (m_NumberOfTimeSteps == 0)
+      m_ToolNames[i] = nd->GetName();
+  }
+
+  ++m_NumberOfTimeSteps;
   return true;
 }
 
+void mitk::NavigationDataSet::Reserve( unsigned int numberOfTimeSteps )
+{
+  const std::size_t size = static_cast<std::size_t>(numberOfTimeSteps) * m_NumberOfTools;
+  m_TimeStamps.reserve(size);
+  m_Positions.reserve(size);
+  m_Orientations.reserve(size);
+  m_Flags.reserve(size);
+  m_CovErrorMatrixIndices.reserve(size);
+}
+
 mitk::NavigationData::Pointer mitk::NavigationDataSet::GetNavigationDataForIndex( unsigned int index, unsigned int toolIndex ) const
 {
-  if ( index >= m_NavigationDataVectors.size() )
+  if ( index >= m_NumberOfTimeSteps )
   {
     MITK_WARN("NavigationDataSet") << "There is no NavigationData available at index " << index << ".";
     return nullptr;
   }
 
-  if ( toolIndex >= m_NavigationDataVectors.at(index).size() )
+  if ( toolIndex >= m_NumberOfTools )
   {
     MITK_WARN("NavigationDataSet") << "There is NavigatitionData available at index " << index << " for tool " << toolIndex << ".";
     return nullptr;
   }
 
-  return m_NavigationDataVectors.at(index).at(toolIndex);
+  mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+  this->CopyNavigationDataForIndex(index, toolIndex, nd);
+  return nd;
+}
+
+bool mitk::NavigationDataSet::CopyNavigationDataForIndex( unsigned int index, unsigned int toolIndex, mitk::NavigationData* output ) const
+{
+  if ( index >= m_NumberOfTimeSteps || toolIndex >= m_NumberOfTools || output == nullptr )
+    return false;
+
+  const std::size_t i = static_cast<std::size_t>(index) * m_NumberOfTools + toolIndex;
+  output->SetPosition(m_Positions[i]);
+  output->SetOrientation(m_Orientations[i]);
+  output->SetDataValid((m_Flags[i] & DataValidFlag) != 0);
+  output->SetIGTTimeStamp(m_TimeStamps[i]);
+  output->SetHasPosition((m_Flags[i] & HasPositionFlag) != 0);
+  output->SetHasOrientation((m_Flags[i] & HasOrientationFlag) != 0);
+  output->SetCovErrorMatrix(m_CovErrorMatrices[m_CovErrorMatrixIndices[i]]);
+  output->SetName(m_ToolNames[toolIndex].c_str());
+  return true;
+}
+
+mitk::NavigationData::TimeStampType mitk::NavigationDataSet::GetIGTTimeStampForIndex( unsigned int index, unsigned int toolIndex ) const
+{
+  if ( index >= m_NumberOfTimeSteps || toolIndex >= m_NumberOfTools )
+    return 0;
+
+  return m_TimeStamps[static_cast<std::size_t>(index) * m_NumberOfTools + toolIndex];
 }
 
 // Method not yet supported, code below compiles but delivers wrong results
@@ -106,16 +177,23 @@ std::vector< mitk::NavigationData::Pointer > mitk::NavigationDataSet::GetDataStr
   }
 
   std::vector< mitk::NavigationData::Pointer > result;
+  result.reserve(m_NumberOfTimeSteps);
 
-  for(std::vector<std::vector<NavigationData::Pointer> >::size_type i = 0; i < m_NavigationDataVectors.size(); i++)
-    result.push_back(m_NavigationDataVectors[i][toolIndex]);
+  for(unsigned int i = 0; i < m_NumberOfTimeSteps; i++)
+    result.push_back(this->GetNavigationDataForIndex(i, toolIndex));
 
   return result;
 }
 
 std::vector< mitk::NavigationData::Pointer > mitk::NavigationDataSet::GetTimeStep(unsigned int index) const
 {
-  return m_NavigationDataVectors[index];
+  std::vector< mitk::NavigationData::Pointer > result;
+  result.reserve(m_NumberOfTools);
+
+  for(unsigned int toolIndex = 0; toolIndex < m_NumberOfTools; toolIndex++)
+    result.push_back(this->GetNavigationDataForIndex(index, toolIndex));
+
+  return result;
 }
 
 unsigned int mitk::NavigationDataSet::GetNumberOfTools() const
@@ -125,7 +203,7 @@ unsigned int mitk::NavigationDataSet::GetNumberOfTools() const
 
 unsigned int mitk::NavigationDataSet::Size() const
 {
-  return m_NavigationDataVectors.size();
+  return m_NumberOfTimeSteps;
 }
 
 // ---> methods necessary for BaseData
@@ -158,10 +236,10 @@ bool mitk::NavigationDataSet::IsEmpty() const
 
 mitk::NavigationDataSet::NavigationDataSetConstIterator mitk::NavigationDataSet::Begin() const
 {
-  return m_NavigationDataVectors.cbegin();
+  return NavigationDataSetConstIterator(this, 0);
 }
 
 mitk::NavigationDataSet::NavigationDataSetConstIterator mitk::NavigationDataSet::End() const
 {
-  return m_NavigationDataVectors.cend();
+  return NavigationDataSetConstIterator(this, m_NumberOfTimeSteps);
 }
@@ -1,5 +1,7 @@
 set(MODULE_TESTS
   mitkImageStatisticsCalculatorTest.cpp
+  mitkIncrementalImageStatisticsCalculatorTest.cpp
+  mitkMultiLabelStatisticsImageFilterTest.cpp
   mitkPointSetStatisticsCalculatorTest.cpp
   mitkPointSetDifferenceStatisticsCalculatorTest.cpp
   mitkImageStatisticsTextureAnalysisTest.cpp
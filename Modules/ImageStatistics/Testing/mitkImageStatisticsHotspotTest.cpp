@@ -447,8 +447,9 @@ struct mitkImageStatisticsHotspotTestClass
     \brief Calculates hotspot statistics for given test image and ROI parameters.
 
     Uses ImageStatisticsCalculator to find a hotspot in a defined ROI within the given image.
+    The image is convolved with the hotspot sphere as specified by convolutionMode.
   */
-  static mitk::ImageStatisticsCalculator::Statistics CalculateStatistics(mitk::Image* image, const Parameters& testParameters,  unsigned int label)
+  static mitk::ImageStatisticsCalculator::Statistics CalculateStatistics(mitk::Image* image, const Parameters& testParameters,  unsigned int label, unsigned int convolutionMode)
   {
     mitk::ImageStatisticsCalculator::Statistics result;
     const unsigned int Dimension = 3;
@@ -522,6 +523,7 @@ struct mitkImageStatisticsHotspotTestClass
 
     statisticsCalculator->SetHotspotRadiusInMM(testParameters.m_HotspotRadiusInMM);
     statisticsCalculator->SetCalculateHotspot(true);
+    statisticsCalculator->SetHotspotConvolutionMode(convolutionMode);
 
     if(testParameters.m_EntireHotspotInImage == 1)
     {
@@ -607,12 +609,19 @@ int mitkImageStatisticsHotspotTest(int argc, char* argv[])
       mitk::Image::Pointer image = mitkImageStatisticsHotspotTestClass::BuildTestImage(parameters);
       MITK_TEST_CONDITION_REQUIRED( image.IsNotNull(), "Generate test image" );
 
-      for(unsigned int label = 0; label < parameters.m_NumberOfLabels; ++label)
+      // spatial and FFT convolution have to find the same hotspot
+      const unsigned int convolutionModes[2] = { mitk::ImageStatisticsCalculator::HOTSPOT_CONVOLUTION_SPATIAL,
+                                                 mitk::ImageStatisticsCalculator::HOTSPOT_CONVOLUTION_FFT };
+      for(unsigned int mode = 0; mode < 2; ++mode)
       {
-        mitk::ImageStatisticsCalculator::Statistics statistics = mitkImageStatisticsHotspotTestClass::CalculateStatistics(image, parameters, label);
+        MITK_INFO << "Hotspot search with " << (mode == 0 ? "spatial" : "FFT") << " convolution";
+        for(unsigned int label = 0; label < parameters.m_NumberOfLabels; ++label)
+        {
+          mitk::ImageStatisticsCalculator::Statistics statistics = mitkImageStatisticsHotspotTestClass::CalculateStatistics(image, parameters, label, convolutionModes[mode]);
 
-        mitkImageStatisticsHotspotTestClass::ValidateStatistics(statistics, parameters, label);
-        std::cout << std::endl;
+          mitkImageStatisticsHotspotTestClass::ValidateStatistics(statistics, parameters, label);
+          std::cout << std::endl;
+        }
       }
 
 
@@ -0,0 +1,317 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkIncrementalImageStatisticsCalculator.h>
+#include <mitkImageStatisticsCalculator.h>
+#include <mitkImageSliceModifiedEvent.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkPlaneGeometry.h>
+
+/**
+ * \brief Test class for mitkIncrementalImageStatisticsCalculator
+ *
+ * Edits a mask like a segmentation tool would do and compares the incrementally updated
+ * statistics to the statistics that are computed from scratch.
+ */
+class mitkIncrementalImageStatisticsCalculatorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkIncrementalImageStatisticsCalculatorTestSuite);
+  MITK_TEST(Initialize_MatchesImageStatisticsCalculator);
+  MITK_TEST(UpdateRegion_PaintAndErase_MatchesRecomputation);
+  MITK_TEST(UpdateSlice_OnlyChangedSliceIsCompared);
+  MITK_TEST(UpdateRegion_ExtremumErased_ExtremumIsSearchedAgain);
+  MITK_TEST(Update_LabelRemovedCompletely_LabelIsGone);
+  MITK_TEST(SliceEvent_EditedSliceIsApplied);
+  MITK_TEST(SliceEvent_NotInitialized_IsInitializedOnFirstEdit);
+  MITK_TEST(ModifiedWithoutSliceEvent_NextSliceEventComparesWholeMask);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  mitk::Image::Pointer m_Image;
+  mitk::Image::Pointer m_Mask;
+  mitk::IncrementalImageStatisticsCalculator::Pointer m_Calculator;
+
+  static const unsigned int m_Size[3];
+
+  unsigned char* MaskData()
+  {
+    mitk::ImageWriteAccessor writeAccess(m_Mask);
+    return static_cast<unsigned char*>(writeAccess.GetData());
+  }
+
+  short* ImageData()
+  {
+    mitk::ImageWriteAccessor writeAccess(m_Image);
+    return static_cast<short*>(writeAccess.GetData());
+  }
+
+  void SetMaskPixel(unsigned int x, unsigned int y, unsigned int z, unsigned char label)
+  {
+    this->MaskData()[(z * m_Size[1] + y) * m_Size[0] + x] = label;
+  }
+
+  /** Paints a box with the given label, like a brush stroke on several slices. */
+  void PaintBox(const unsigned int from[3], const unsigned int to[3], unsigned char label)
+  {
+    for (unsigned int z = from[2]; z <= to[2]; ++z)
+      for (unsigned int y = from[1]; y <= to[1]; ++y)
+        for (unsigned int x = from[0]; x <= to[0]; ++x)
+          this->SetMaskPixel(x, y, z, label);
+    m_Mask->Modified();
+  }
+
+  /** Writes a rectangle of an axial slice and notifies the observers like a segmentation tool does. */
+  void WriteSlice(unsigned int slice, const unsigned int from[2], const unsigned int to[2], unsigned char label)
+  {
+    for (unsigned int y = from[1]; y <= to[1]; ++y)
+      for (unsigned int x = from[0]; x <= to[0]; ++x)
+        this->SetMaskPixel(x, y, slice, label);
+
+    mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+    plane->InitializeStandardPlane(m_Mask->GetGeometry(), mitk::PlaneGeometry::Axial, slice);
+    m_Mask->InvokeEvent(mitk::ImageSliceModifiedEvent(plane, 0));
+    m_Mask->Modified();
+  }
+
+  static mitk::IncrementalImageStatisticsCalculator::RegionType Region(const unsigned int from[3], const unsigned int to[3])
+  {
+    mitk::IncrementalImageStatisticsCalculator::RegionType region;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      region.SetIndex(i, from[i]);
+      region.SetSize(i, to[i] - from[i] + 1);
+    }
+    return region;
+  }
+
+  /** Compares the statistics of the calculator under test to a newly initialized one. */
+  void CompareToRecomputation()
+  {
+    mitk::IncrementalImageStatisticsCalculator::Pointer reference = mitk::IncrementalImageStatisticsCalculator::New();
+    reference->SetImage(m_Image);
+    reference->SetImageMask(m_Mask);
+    reference->Initialize();
+
+    mitk::IncrementalImageStatisticsCalculator::StatisticsContainer expected = reference->GetStatistics();
+    mitk::IncrementalImageStatisticsCalculator::StatisticsContainer actual = m_Calculator->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetLabel(), actual[i].GetLabel());
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetN(), actual[i].GetN());
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetMean(), actual[i].GetMean(), 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetSigma(), actual[i].GetSigma(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetSkewness(), actual[i].GetSkewness(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetKurtosis(), actual[i].GetKurtosis(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetMPP(), actual[i].GetMPP(), 1e-9);
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetMin(), actual[i].GetMin());
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetMax(), actual[i].GetMax());
+      CPPUNIT_ASSERT(expected[i].GetMinIndex() == actual[i].GetMinIndex());
+      CPPUNIT_ASSERT(expected[i].GetMaxIndex() == actual[i].GetMaxIndex());
+    }
+  }
+
+public:
+
+  void setUp() override
+  {
+    m_Image = mitk::Image::New();
+    m_Image->Initialize(mitk::MakeScalarPixelType<short>(), 3, m_Size);
+    m_Mask = mitk::Image::New();
+    m_Mask->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 3, m_Size);
+
+    const unsigned int numberOfPixels = m_Size[0] * m_Size[1] * m_Size[2];
+    short* image = this->ImageData();
+    unsigned char* mask = this->MaskData();
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      image[i] = static_cast<short>(1000 + (i * 7919) % 2003) - 1500;
+      mask[i] = 0;
+    }
+
+    const unsigned int from1[3] = { 2, 2, 2 };
+    const unsigned int to1[3] = { 20, 15, 10 };
+    this->PaintBox(from1, to1, 1);
+    const unsigned int from2[3] = { 15, 10, 5 };
+    const unsigned int to2[3] = { 30, 25, 12 };
+    this->PaintBox(from2, to2, 2);
+
+    m_Calculator = mitk::IncrementalImageStatisticsCalculator::New();
+    m_Calculator->SetImage(m_Image);
+    m_Calculator->SetImageMask(m_Mask);
+    m_Calculator->Initialize();
+  }
+
+  void tearDown() override
+  {
+    m_Calculator = nullptr;
+    m_Mask = nullptr;
+    m_Image = nullptr;
+  }
+
+  void Initialize_MatchesImageStatisticsCalculator()
+  {
+    mitk::ImageStatisticsCalculator::Pointer calculator = mitk::ImageStatisticsCalculator::New();
+    calculator->SetImage(m_Image);
+    calculator->SetImageMask(m_Mask);
+    calculator->SetMaskingModeToImage();
+    calculator->ComputeStatistics();
+    const mitk::ImageStatisticsCalculator::StatisticsContainer& expected = calculator->GetStatisticsVector();
+
+    mitk::IncrementalImageStatisticsCalculator::StatisticsContainer actual = m_Calculator->GetStatistics();
+    CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetLabel(), actual[i].GetLabel());
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetN(), actual[i].GetN());
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetMean(), actual[i].GetMean(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetSigma(), actual[i].GetSigma(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetRMS(), actual[i].GetRMS(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetSkewness(), actual[i].GetSkewness(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetKurtosis(), actual[i].GetKurtosis(), 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].GetMPP(), actual[i].GetMPP(), 1e-6);
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetMin(), actual[i].GetMin());
+      CPPUNIT_ASSERT_EQUAL(expected[i].GetMax(), actual[i].GetMax());
+    }
+  }
+
+  void UpdateRegion_PaintAndErase_MatchesRecomputation()
+  {
+    // paint over both labels with label 2
+    const unsigned int from1[3] = { 5, 5, 3 };
+    const unsigned int to1[3] = { 18, 12, 8 };
+    this->PaintBox(from1, to1, 2);
+    m_Calculator->UpdateRegion(Region(from1, to1));
+    // 4 * 3 * 4 pixels of the box already belonged to label 2
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(14 * 8 * 6 - 4 * 3 * 4), m_Calculator->GetNumberOfChangedPixels());
+    this->CompareToRecomputation();
+
+    // erase parts of label 2 and paint a new label 3
+    const unsigned int from2[3] = { 10, 10, 4 };
+    const unsigned int to2[3] = { 25, 20, 6 };
+    this->PaintBox(from2, to2, 0);
+    const unsigned int from3[3] = { 30, 0, 0 };
+    const unsigned int to3[3] = { 39, 5, 15 };
+    this->PaintBox(from3, to3, 3);
+    m_Calculator->UpdateRegion(Region(from2, to2));
+    m_Calculator->UpdateRegion(Region(from3, to3));
+    this->CompareToRecomputation();
+  }
+
+  void UpdateSlice_OnlyChangedSliceIsCompared()
+  {
+    const unsigned int slice = 7;
+    const unsigned int from[3] = { 0, 0, slice };
+    const unsigned int to[3] = { 39, 29, slice };
+    this->PaintBox(from, to, 1);
+
+    mitk::PlaneGeometry::Pointer plane = mitk::PlaneGeometry::New();
+    plane->InitializeStandardPlane(m_Mask->GetGeometry(), mitk::PlaneGeometry::Axial, slice);
+    m_Calculator->UpdateSlice(plane);
+
+    this->CompareToRecomputation();
+  }
+
+  void UpdateRegion_ExtremumErased_ExtremumIsSearchedAgain()
+  {
+    const mitk::IncrementalImageStatisticsCalculator::Statistics before = m_Calculator->GetStatistics(1);
+    const vnl_vector<int> maxIndex = before.GetMaxIndex();
+    this->SetMaskPixel(maxIndex[0], maxIndex[1], maxIndex[2], 0);
+    m_Mask->Modified();
+
+    const unsigned int index[3] = { static_cast<unsigned int>(maxIndex[0]), static_cast<unsigned int>(maxIndex[1]), static_cast<unsigned int>(maxIndex[2]) };
+    m_Calculator->UpdateRegion(Region(index, index));
+
+    CPPUNIT_ASSERT_EQUAL(before.GetN() - 1, m_Calculator->GetStatistics(1).GetN());
+    this->CompareToRecomputation();
+  }
+
+  void Update_LabelRemovedCompletely_LabelIsGone()
+  {
+    const unsigned int numberOfPixels = m_Size[0] * m_Size[1] * m_Size[2];
+    unsigned char* mask = this->MaskData();
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      if (mask[i] == 1)
+        mask[i] = 0;
+    }
+    m_Mask->Modified();
+
+    m_Calculator->Update();
+
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), m_Calculator->GetStatistics().size());
+    CPPUNIT_ASSERT_EQUAL(0u, m_Calculator->GetStatistics(1).GetN());
+    this->CompareToRecomputation();
+  }
+
+  void SliceEvent_EditedSliceIsApplied()
+  {
+    const unsigned int from[2] = { 0, 0 };
+    const unsigned int to[2] = { 9, 4 };
+    this->WriteSlice(14, from, to, 3);
+
+    CPPUNIT_ASSERT(m_Calculator->IsUpToDate());
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(10 * 5), m_Calculator->GetNumberOfChangedPixels());
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(10 * 5), static_cast<unsigned long>(m_Calculator->GetStatistics(3).GetN()));
+    this->CompareToRecomputation();
+
+    // undo
+    this->WriteSlice(14, from, to, 0);
+    CPPUNIT_ASSERT(m_Calculator->IsUpToDate());
+    CPPUNIT_ASSERT_EQUAL(0u, m_Calculator->GetStatistics(3).GetN());
+    this->CompareToRecomputation();
+  }
+
+  void SliceEvent_NotInitialized_IsInitializedOnFirstEdit()
+  {
+    m_Calculator = mitk::IncrementalImageStatisticsCalculator::New();
+    m_Calculator->SetImage(m_Image);
+    m_Calculator->SetImageMask(m_Mask);
+    CPPUNIT_ASSERT(!m_Calculator->IsInitialized());
+
+    const unsigned int from[2] = { 5, 5 };
+    const unsigned int to[2] = { 25, 20 };
+    this->WriteSlice(3, from, to, 1);
+
+    CPPUNIT_ASSERT(m_Calculator->IsUpToDate());
+    this->CompareToRecomputation();
+  }
+
+  void ModifiedWithoutSliceEvent_NextSliceEventComparesWholeMask()
+  {
+    // e.g. a 3D tool
+    const unsigned int from1[3] = { 0, 20, 0 };
+    const unsigned int to1[3] = { 39, 29, 3 };
+    this->PaintBox(from1, to1, 2);
+    CPPUNIT_ASSERT(!m_Calculator->IsUpToDate());
+
+    const unsigned int from2[2] = { 0, 0 };
+    const unsigned int to2[2] = { 4, 4 };
+    this->WriteSlice(12, from2, to2, 1);
+
+    CPPUNIT_ASSERT(m_Calculator->IsUpToDate());
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(40 * 10 * 4 + 5 * 5), m_Calculator->GetNumberOfChangedPixels());
+    this->CompareToRecomputation();
+  }
+};
+
+const unsigned int mitkIncrementalImageStatisticsCalculatorTestSuite::m_Size[3] = { 40, 30, 16 };
+
+MITK_TEST_SUITE_REGISTRATION(mitkIncrementalImageStatisticsCalculator)
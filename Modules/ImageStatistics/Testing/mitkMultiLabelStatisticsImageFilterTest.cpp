@@ -0,0 +1,301 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkMultiLabelStatisticsImageFilter.h>
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkLabelStatisticsImageFilter.h>
+
+#include <cmath>
+#include <map>
+
+/**
+ * \brief Test class for itk::MultiLabelStatisticsImageFilter
+ *
+ * Compares the statistics of an image with several hundred labels to a straightforward
+ * single-threaded computation and to itk::LabelStatisticsImageFilter.
+ */
+class mitkMultiLabelStatisticsImageFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkMultiLabelStatisticsImageFilterTestSuite);
+  MITK_TEST(Update_ManyLabels_MatchesReference);
+  MITK_TEST(Update_DifferentNumberOfThreads_SameResult);
+  MITK_TEST(Update_ManyLabels_HistogramsMatchLabelStatisticsImageFilter);
+  MITK_TEST(Update_EmptyLabelImage_NoLabels);
+  MITK_TEST(Update_NegativeLabels_MatchesShiftedLabels);
+  MITK_TEST(Update_WideValueRange_DefaultBinsAreLimited);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  typedef itk::Image< short, 3 > ImageType;
+  typedef itk::Image< unsigned short, 3 > LabelImageType;
+  typedef itk::MultiLabelStatisticsImageFilter< ImageType, LabelImageType > FilterType;
+
+  struct Reference
+  {
+    Reference() : count(0), sum(0.0), minimum(0.0), maximum(0.0) {}
+
+    unsigned long count;
+    double sum;
+    double minimum;
+    double maximum;
+    ImageType::IndexType minimumIndex;
+    ImageType::IndexType maximumIndex;
+    std::vector<double> values;
+  };
+
+  ImageType::Pointer m_Image;
+  LabelImageType::Pointer m_LabelImage;
+  static const unsigned short numberOfLabels = 300;
+
+  FilterType::Pointer Compute(unsigned int numberOfThreads)
+  {
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(m_Image);
+    filter->SetLabelInput(m_LabelImage);
+    filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+    return filter;
+  }
+
+  std::map<unsigned short, Reference> ComputeReference()
+  {
+    std::map<unsigned short, Reference> references;
+    itk::ImageRegionConstIteratorWithIndex<ImageType> imageIt(m_Image, m_Image->GetLargestPossibleRegion());
+    itk::ImageRegionConstIteratorWithIndex<LabelImageType> labelIt(m_LabelImage, m_LabelImage->GetLargestPossibleRegion());
+    for (; !imageIt.IsAtEnd(); ++imageIt, ++labelIt)
+    {
+      if (labelIt.Get() == 0)
+        continue;
+
+      Reference& reference = references[labelIt.Get()];
+      const double value = imageIt.Get();
+      if (reference.count == 0 || value < reference.minimum)
+      {
+        reference.minimum = value;
+        reference.minimumIndex = imageIt.GetIndex();
+      }
+      if (reference.count == 0 || value > reference.maximum)
+      {
+        reference.maximum = value;
+        reference.maximumIndex = imageIt.GetIndex();
+      }
+      ++reference.count;
+      reference.sum += value;
+      reference.values.push_back(value);
+    }
+    return references;
+  }
+
+public:
+
+  void setUp() override
+  {
+    ImageType::SizeType size = {{ 47, 31, 23 }};
+    ImageType::RegionType region;
+    region.SetSize(size);
+
+    m_Image = ImageType::New();
+    m_Image->SetRegions(region);
+    m_Image->Allocate();
+    m_LabelImage = LabelImageType::New();
+    m_LabelImage->SetRegions(region);
+    m_LabelImage->Allocate();
+
+    itk::ImageRegionIterator<ImageType> imageIt(m_Image, region);
+    itk::ImageRegionIterator<LabelImageType> labelIt(m_LabelImage, region);
+    unsigned int i = 0;
+    for (; !imageIt.IsAtEnd(); ++imageIt, ++labelIt, ++i)
+    {
+      // large offset to make a naive sum of squares lose precision
+      imageIt.Set(static_cast<short>(20000 + (i * 7919) % 1013));
+      labelIt.Set(static_cast<unsigned short>((i / 3) % (numberOfLabels + 1)));
+    }
+  }
+
+  void tearDown() override
+  {
+    m_Image = nullptr;
+    m_LabelImage = nullptr;
+  }
+
+  void Update_ManyLabels_MatchesReference()
+  {
+    FilterType::Pointer filter = this->Compute(8);
+    std::map<unsigned short, Reference> references = this->ComputeReference();
+
+    CPPUNIT_ASSERT_EQUAL(references.size(), filter->GetLabelStatistics().size());
+
+    for (std::map<unsigned short, Reference>::iterator it = references.begin(); it != references.end(); ++it)
+    {
+      const Reference& reference = it->second;
+      const FilterType::LabelStatistics& statistics = filter->GetStatistics(it->first);
+
+      const double mean = reference.sum / reference.count;
+      double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+      for (size_t v = 0; v < reference.values.size(); ++v)
+      {
+        const double d = reference.values[v] - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+      }
+      const double sigma = std::sqrt(m2 / (reference.count - 1));
+
+      CPPUNIT_ASSERT_EQUAL(reference.count, static_cast<unsigned long>(statistics.m_Count));
+      CPPUNIT_ASSERT_EQUAL(reference.minimum, statistics.m_Minimum);
+      CPPUNIT_ASSERT_EQUAL(reference.maximum, statistics.m_Maximum);
+      CPPUNIT_ASSERT_EQUAL(reference.minimumIndex, statistics.m_MinimumIndex);
+      CPPUNIT_ASSERT_EQUAL(reference.maximumIndex, statistics.m_MaximumIndex);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(mean, statistics.m_Mean, 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(sigma, statistics.m_Sigma, 1e-7);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(m3 / (reference.count * sigma * sigma * sigma), statistics.m_Skewness, 1e-7);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(m4 / (reference.count * sigma * sigma * sigma * sigma), statistics.m_Kurtosis, 1e-7);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(mean, statistics.m_MPP, 1e-9);
+      CPPUNIT_ASSERT_EQUAL(static_cast<double>(reference.count), statistics.m_Histogram->GetTotalFrequency());
+    }
+  }
+
+  void Update_DifferentNumberOfThreads_SameResult()
+  {
+    FilterType::Pointer singleThreaded = this->Compute(1);
+    FilterType::Pointer multiThreaded = this->Compute(7);
+
+    const FilterType::LabelStatisticsContainer& expected = singleThreaded->GetLabelStatistics();
+    const FilterType::LabelStatisticsContainer& actual = multiThreaded->GetLabelStatistics();
+    CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      CPPUNIT_ASSERT_EQUAL(expected[i].m_Label, actual[i].m_Label);
+      CPPUNIT_ASSERT_EQUAL(expected[i].m_MinimumIndex, actual[i].m_MinimumIndex);
+      CPPUNIT_ASSERT_EQUAL(expected[i].m_MaximumIndex, actual[i].m_MaximumIndex);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].m_Variance, actual[i].m_Variance, 1e-6);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].m_Median, actual[i].m_Median, mitk::eps);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].m_Entropy, actual[i].m_Entropy, 1e-9);
+    }
+  }
+
+  void Update_ManyLabels_HistogramsMatchLabelStatisticsImageFilter()
+  {
+    FilterType::Pointer filter = this->Compute(4);
+
+    const unsigned int numberOfBins = static_cast<unsigned int>(filter->GetMaximum() - filter->GetMinimum());
+    typedef itk::LabelStatisticsImageFilter<ImageType, LabelImageType> ITKFilterType;
+    ITKFilterType::Pointer itkFilter = ITKFilterType::New();
+    itkFilter->SetInput(m_Image);
+    itkFilter->SetLabelInput(m_LabelImage);
+    itkFilter->UseHistogramsOn();
+    itkFilter->SetHistogramParameters(numberOfBins, std::floor(filter->GetMinimum()), std::ceil(filter->GetMaximum()));
+    itkFilter->Update();
+
+    const FilterType::LabelStatisticsContainer& labelStatistics = filter->GetLabelStatistics();
+    for (size_t i = 0; i < labelStatistics.size(); ++i)
+    {
+      const unsigned short label = labelStatistics[i].m_Label;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(itkFilter->GetMedian(label), labelStatistics[i].m_Median, mitk::eps);
+
+      ITKFilterType::HistogramPointer itkHistogram = itkFilter->GetHistogram(label);
+      CPPUNIT_ASSERT_EQUAL(itkHistogram->Size(), labelStatistics[i].m_Histogram->Size());
+      for (unsigned int bin = 0; bin < itkHistogram->Size(); ++bin)
+      {
+        CPPUNIT_ASSERT_EQUAL(itkHistogram->GetFrequency(bin), labelStatistics[i].m_Histogram->GetFrequency(bin));
+      }
+    }
+  }
+
+  void Update_EmptyLabelImage_NoLabels()
+  {
+    m_LabelImage->FillBuffer(0);
+    FilterType::Pointer filter = this->Compute(4);
+
+    CPPUNIT_ASSERT(filter->GetLabelStatistics().empty());
+    CPPUNIT_ASSERT(!filter->HasLabel(1));
+  }
+
+  void Update_NegativeLabels_MatchesShiftedLabels()
+  {
+    // the same labelling, with labels 1..150 mapped to -150..-1
+    typedef itk::Image< short, 3 > SignedLabelImageType;
+    typedef itk::MultiLabelStatisticsImageFilter< ImageType, SignedLabelImageType > SignedFilterType;
+
+    SignedLabelImageType::Pointer signedLabelImage = SignedLabelImageType::New();
+    signedLabelImage->SetRegions(m_LabelImage->GetLargestPossibleRegion());
+    signedLabelImage->Allocate();
+    itk::ImageRegionConstIterator<LabelImageType> labelIt(m_LabelImage, m_LabelImage->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<SignedLabelImageType> signedLabelIt(signedLabelImage, signedLabelImage->GetLargestPossibleRegion());
+    for (; !labelIt.IsAtEnd(); ++labelIt, ++signedLabelIt)
+    {
+      const short label = static_cast<short>(labelIt.Get());
+      signedLabelIt.Set(label > 0 && label <= 150 ? static_cast<short>(label - 151) : label);
+    }
+
+    SignedFilterType::Pointer signedFilter = SignedFilterType::New();
+    signedFilter->SetInput(m_Image);
+    signedFilter->SetLabelInput(signedLabelImage);
+    signedFilter->SetNumberOfThreads(4);
+    signedFilter->Update();
+    FilterType::Pointer filter = this->Compute(4);
+
+    CPPUNIT_ASSERT_EQUAL(filter->GetLabelStatistics().size(), signedFilter->GetLabelStatistics().size());
+    CPPUNIT_ASSERT_EQUAL(short(-150), signedFilter->GetLabelStatistics().front().m_Label);
+    CPPUNIT_ASSERT(!signedFilter->HasLabel(-151));
+    CPPUNIT_ASSERT(!signedFilter->HasLabel(0));
+    for (unsigned short label = 1; label <= numberOfLabels; ++label)
+    {
+      const short signedLabel = label <= 150 ? static_cast<short>(label - 151) : static_cast<short>(label);
+      const FilterType::LabelStatistics& expected = filter->GetStatistics(label);
+      const SignedFilterType::LabelStatistics& actual = signedFilter->GetStatistics(signedLabel);
+      CPPUNIT_ASSERT_EQUAL(signedLabel, actual.m_Label);
+      CPPUNIT_ASSERT_EQUAL(expected.m_Count, actual.m_Count);
+      CPPUNIT_ASSERT_EQUAL(expected.m_MinimumIndex, actual.m_MinimumIndex);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.m_Mean, actual.m_Mean, 1e-9);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(expected.m_Median, actual.m_Median, mitk::eps);
+    }
+  }
+
+  void Update_WideValueRange_DefaultBinsAreLimited()
+  {
+    typedef itk::Image< int, 3 > WideImageType;
+    typedef itk::MultiLabelStatisticsImageFilter< WideImageType, LabelImageType > WideFilterType;
+
+    WideImageType::Pointer wideImage = WideImageType::New();
+    wideImage->SetRegions(m_Image->GetLargestPossibleRegion());
+    wideImage->Allocate();
+    itk::ImageRegionIterator<WideImageType> wideIt(wideImage, wideImage->GetLargestPossibleRegion());
+    for (int i = 0; !wideIt.IsAtEnd(); ++wideIt, ++i)
+    {
+      wideIt.Set((i % 2) ? 100000000 : -100000000);
+    }
+
+    WideFilterType::Pointer filter = WideFilterType::New();
+    filter->SetInput(wideImage);
+    filter->SetLabelInput(m_LabelImage);
+    filter->SetNumberOfThreads(4);
+    filter->Update();
+
+    const WideFilterType::LabelStatistics& statistics = filter->GetStatistics(1);
+    CPPUNIT_ASSERT_EQUAL(static_cast<itk::SizeValueType>(WideFilterType::MaximumNumberOfDefaultBins), statistics.m_Histogram->GetSize(0));
+    CPPUNIT_ASSERT_EQUAL(static_cast<double>(statistics.m_Count), statistics.m_Histogram->GetTotalFrequency());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkMultiLabelStatisticsImageFilter)
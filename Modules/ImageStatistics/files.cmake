@@ -1,5 +1,6 @@
 set(CPP_FILES
   mitkImageStatisticsCalculator.cpp
+  mitkIncrementalImageStatisticsCalculator.cpp
   mitkPointSetStatisticsCalculator.cpp
   mitkPointSetDifferenceStatisticsCalculator.cpp
   mitkIntensityProfile.cpp
@@ -7,8 +8,10 @@ set(CPP_FILES
 
 set(H_FILES
   mitkImageStatisticsCalculator.h
+  mitkIncrementalImageStatisticsCalculator.h
   mitkPointSetDifferenceStatisticsCalculator.h
   mitkPointSetStatisticsCalculator.h
   mitkExtendedStatisticsImageFilter.h
   mitkExtendedLabelStatisticsImageFilter.h
+  mitkMultiLabelStatisticsImageFilter.h
 )
@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkExtendedStatisticsImageFilter.h>
 #include <mitkExtendedLabelStatisticsImageFilter.h>
+#include <mitkMultiLabelStatisticsImageFilter.h>
 
 #include <itkScalarImageToHistogramGenerator.h>
 
@@ -53,6 +54,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkLassoStencilSource.h>
 
 #include <itkFFTConvolutionImageFilter.h>
+#include <itkConvolutionImageFilter.h>
 #include <itkConstantBoundaryCondition.h>
 #include <itkImageDuplicator.h>
 
@@ -91,7 +93,10 @@ namespace mitk
     m_HotspotRadiusInMM(6.2035049089940),   // radius of a 1cm3 sphere in mm
     m_CalculateHotspot(false),
     m_HotspotRadiusInMMChanged(false),
-    m_HotspotMustBeCompletelyInsideImage(true)
+    m_HotspotMustBeCompletelyInsideImage(true),
+    m_HotspotConvolutionMode(HOTSPOT_CONVOLUTION_AUTOMATIC),
+    m_HotspotFFTKernelSizeThreshold(125), // 5x5x5, below that spatial convolution is faster
+    m_HotspotConvolutionInputMTime(0)
   {
     m_EmptyHistogram = HistogramType::New();
     m_EmptyHistogram->SetMeasurementVectorSize(1);
@@ -520,73 +525,22 @@ namespace mitk
     return m_HotspotMustBeCompletelyInsideImage;
   }
 
-
-  /* Implementation of the min max values for setting the range of the histogram */
-  template < typename TPixel, unsigned int VImageDimension >
-  void  ImageStatisticsCalculator::GetMinAndMaxValue( double &min,
-    double &max, int &counter, double &sigma,
-    const itk::Image< TPixel, VImageDimension > *InputImage,
-    itk::Image< unsigned short, VImageDimension > *MaskedImage )
+  void ImageStatisticsCalculator::SetHotspotConvolutionMode( unsigned int mode )
   {
-    typedef itk::Image< unsigned short, VImageDimension > MaskImageType;
-    typedef itk::Image< TPixel, VImageDimension > ImageType;
-
-    typedef itk::ImageRegionConstIteratorWithIndex<ImageType> Imageie;
-    typedef itk::ImageRegionConstIteratorWithIndex<MaskImageType> Imageie2;
-
-    Imageie2 labelIterator2( MaskedImage, MaskedImage->GetRequestedRegion() );
-    Imageie labelIterator3( InputImage, InputImage->GetRequestedRegion() );
-
-    max = 0;
-    min = 0;
-    counter = 0;
-    sigma = 0;
-    double SumOfSquares = 0;
-    double sumSquared = 0;
-
-    double actualPielValue = 0;
-    int counterOfPixelsInROI = 0;
-
-
-    for( labelIterator2.GoToBegin(); !labelIterator2.IsAtEnd(); ++labelIterator2, ++labelIterator3)
+    if ( mode > HOTSPOT_CONVOLUTION_FFT )
     {
-      if( labelIterator2.Value()== 1.0)
-      {
-        counter++;
-
-        counterOfPixelsInROI++;
-        actualPielValue = labelIterator3.Value();
-
-        sumSquared = sumSquared + actualPielValue;
-        SumOfSquares = SumOfSquares + std::pow(actualPielValue,2);
-
-        if(counterOfPixelsInROI == 1)
-        {
-          max = actualPielValue;
-          min = actualPielValue;
-        }
-
-        if(actualPielValue >= max)
-        {
-          max = actualPielValue;
-        }
-        else if(actualPielValue <= min)
-        {
-          min = actualPielValue;
-        }
-
-      }
+      mitkThrow() << "Unknown hotspot convolution mode " << mode;
     }
 
-    if (counter > 1)
-    {
-      sigma = ( SumOfSquares - std::pow( sumSquared, 2) / counter ) / ( counter-1 );
-    }
-    else
+    if ( m_HotspotConvolutionMode != mode )
     {
-      sigma = 0;
+      m_HotspotConvolutionMode = mode;
+      // the cached convolution image was computed with the previous mode
+      m_HotspotRadiusInMMChanged = true;
+      m_HotspotConvolutionImage = nullptr;
+      m_HotspotConvolutionInput = nullptr;
+      this->Modified();
     }
-
   }
 
 
@@ -752,6 +706,8 @@ namespace mitk
     m_InternalImage = mitk::Image::ConstPointer();
     m_InternalImageMask3D = MaskImage3DType::Pointer();
     m_InternalImageMask2D = MaskImage2DType::Pointer();
+    m_HotspotConvolutionImage = nullptr;
+    m_HotspotConvolutionInput = nullptr;
 
 
 
@@ -1284,7 +1240,7 @@ namespace mitk
     typedef typename ImageType::PointType PointType;
     typedef typename ImageType::SpacingType SpacingType;
     typedef typename ImageType::Pointer ImagePointer;
-    typedef itk::ExtendedLabelStatisticsImageFilter< ImageType, MaskImageType > LabelStatisticsFilterType;
+    typedef itk::MultiLabelStatisticsImageFilter< ImageType, MaskImageType > MultiLabelStatisticsFilterType;
     typedef itk::ChangeInformationImageFilter< MaskImageType > ChangeInformationFilterType;
     typedef itk::ExtractImageFilter< ImageType, ImageType > ExtractImageFilterType;
 
@@ -1412,65 +1368,46 @@ namespace mitk
       adaptedImage = image;
     }
 
-    // Initialize Filter
-    typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
-    typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
-    statisticsFilter->SetInput( adaptedImage );
-
-    try
-    {
-      statisticsFilter->Update();
-    }
-    catch( const itk::ExceptionObject& e)
-    {
-      mitkThrow() << "Image statistics initialization computation failed with ITK Exception: \n " << e.what();
-    }
-    catch( const std::exception& e )
-    {
-      //mitkThrow() << "Image statistics calculation failed due to following ITK Exception: \n " << e.what();
-    }
-
-    // Calculate bin size or number of bins
-    unsigned int numberOfBins = 200; // default number of bins
-    double maximum = 0.0;
-    double minimum = 0.0;
+    // By default the histogram range is derived from the labelled pixels by the statistics filter itself,
+    // optionally it is derived from the whole (adapted) image
+    typename MultiLabelStatisticsFilterType::Pointer labelStatisticsFilter = MultiLabelStatisticsFilterType::New();
 
     if (m_UseBinSizeBasedOnVOIRegion)
     {
-      maximum = statisticsFilter->GetMaximum();
-      minimum = statisticsFilter->GetMinimum();
+      typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
+      typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
+      statisticsFilter->SetInput( adaptedImage );
 
-      if (m_UseDefaultBinSize)
+      try
       {
-        m_HistogramBinSize = std::ceil( static_cast<double>((statisticsFilter->GetMaximum() - statisticsFilter->GetMinimum() + 1)/numberOfBins) );
+        statisticsFilter->Update();
       }
-      else
+      catch( const itk::ExceptionObject& e)
       {
-        numberOfBins = calcNumberOfBins(statisticsFilter->GetMinimum(), statisticsFilter->GetMaximum());
+        mitkThrow() << "Image statistics initialization computation failed with ITK Exception: \n " << e.what();
       }
-    }
-    else
-    {
-      double sig = 0.0;
-      int counter = 0;
 
-      //Find the min and max values for the Roi to set the range for the histogram
-      GetMinAndMaxValue( minimum, maximum, counter, sig, image, maskImage);
-      numberOfBins = maximum - minimum;
-      if(maximum - minimum <= 10)
+      // Calculate bin size or number of bins
+      unsigned int numberOfBins = 200; // default number of bins
+      double maximum = statisticsFilter->GetMaximum();
+      double minimum = statisticsFilter->GetMinimum();
+
+      if (m_UseDefaultBinSize)
       {
-        numberOfBins = 100;
+        m_HistogramBinSize = std::ceil( static_cast<double>((maximum - minimum + 1)/numberOfBins) );
       }
+      else
+      {
+        numberOfBins = calcNumberOfBins(minimum, maximum);
+      }
+      labelStatisticsFilter->SetHistogramParameters( numberOfBins, floor(minimum), ceil(maximum) );
     }
 
-
-    typename LabelStatisticsFilterType::Pointer labelStatisticsFilter = LabelStatisticsFilterType::New();
     labelStatisticsFilter->SetInput( adaptedImage );
     labelStatisticsFilter->SetLabelInput( adaptedMaskImage );
     labelStatisticsFilter->SetCoordinateTolerance( 0.001 );
     labelStatisticsFilter->SetDirectionTolerance( 0.001 );
     labelStatisticsFilter->UseHistogramsOn();
-    labelStatisticsFilter->SetHistogramParameters( numberOfBins, floor(minimum), ceil(maximum) );   //statisticsFilter->GetMinimum() statisticsFilter->GetMaximum()
 
     // Add progress listening
     typedef itk::SimpleMemberCommand< ImageStatisticsCalculator > ITKCommandType;
@@ -1484,11 +1421,7 @@ namespace mitk
     // Execute filter
     this->InvokeEvent( itk::StartEvent() );
 
-    // Make sure that only the mask region is considered (otherwise, if the mask region is smaller
-    // than the image region, the Update() would result in an exception).
-    labelStatisticsFilter->GetOutput()->SetRequestedRegion( adaptedMaskImage->GetLargestPossibleRegion() );
-
-    // Execute the filter
+    // Execute the filter: all labels are processed at once, including the indices of minimum and maximum
     try
     {
       labelStatisticsFilter->Update();
@@ -1497,74 +1430,41 @@ namespace mitk
     {
       mitkThrow() << "Image statistics calculation failed due to following ITK Exception: \n " << e.what();
     }
-    catch( const std::exception& e )
-    {
-      //mitkThrow() << "Image statistics calculation failed due to following ITK Exception: \n " << e.what();
-    }
 
     this->InvokeEvent( itk::EndEvent() );
 
     if( observerTag )
       labelStatisticsFilter->RemoveObserver( observerTag );
 
-    // Find all relevant labels of mask (other than 0)
-    std::list< int > relevantLabels = labelStatisticsFilter->GetRelevantLabels();
-    unsigned int i;
+    const typename MultiLabelStatisticsFilterType::LabelStatisticsContainer &labelStatistics = labelStatisticsFilter->GetLabelStatistics();
 
-    if ( labelStatisticsFilter->GetMaskingNonEmpty() )
+    if ( !labelStatistics.empty() )
     {
-      std::list< int >::iterator it;
-      for ( it = relevantLabels.begin(), i = 0;
-        it != relevantLabels.end();
-        ++it, ++i )
+      typename MultiLabelStatisticsFilterType::LabelStatisticsContainer::const_iterator it;
+      for ( it = labelStatistics.begin(); it != labelStatistics.end(); ++it )
       {
-        Statistics statistics; // restore previous code
-        labelStatisticsFilter->GetHistogram(*it) ;
-        histogramContainer->push_back( HistogramType::ConstPointer( labelStatisticsFilter->GetHistogram( (*it) ) ) );
-
-        statistics.SetLabel (*it);
-        statistics.SetN(labelStatisticsFilter->GetCount( *it ));
-        statistics.SetMin(labelStatisticsFilter->GetMinimum( *it ));
-        statistics.SetMax(labelStatisticsFilter->GetMaximum( *it ));
-        statistics.SetMean(labelStatisticsFilter->GetMean( *it ));
-        statistics.SetMedian(labelStatisticsFilter->GetMedian( *it));
-        statistics.SetMedian(labelStatisticsFilter->GetMedian( *it ));
-        statistics.SetVariance(labelStatisticsFilter->GetVariance( *it ));
-        statistics.SetSigma(labelStatisticsFilter->GetSigma( *it ));
-        statistics.SetSkewness(labelStatisticsFilter->GetSkewness( *it ));
-        statistics.SetKurtosis(labelStatisticsFilter->GetKurtosis( *it ));
-        statistics.SetUniformity( labelStatisticsFilter->GetUniformity( *it ));
-        statistics.SetEntropy( labelStatisticsFilter->GetEntropy( *it ));
-        statistics.SetUPP( labelStatisticsFilter->GetUPP( *it));
-        statistics.SetMPP( labelStatisticsFilter->GetMPP( *it));
+        Statistics statistics;
+        histogramContainer->push_back( HistogramType::ConstPointer( it->m_Histogram.GetPointer() ) );
+
+        statistics.SetLabel( it->m_Label );
+        statistics.SetN( it->m_Count );
+        statistics.SetMin( it->m_Minimum );
+        statistics.SetMax( it->m_Maximum );
+        statistics.SetMean( it->m_Mean );
+        statistics.SetMedian( it->m_Median );
+        statistics.SetVariance( it->m_Variance );
+        statistics.SetSigma( it->m_Sigma );
+        statistics.SetSkewness( it->m_Skewness );
+        statistics.SetKurtosis( it->m_Kurtosis );
+        statistics.SetUniformity( it->m_Uniformity );
+        statistics.SetEntropy( it->m_Entropy );
+        statistics.SetUPP( it->m_UPP );
+        statistics.SetMPP( it->m_MPP );
         statistics.SetRMS(sqrt( statistics.GetMean() * statistics.GetMean()
           + statistics.GetSigma() * statistics.GetSigma() ));
 
-        // restrict image to mask area for min/max index calculation
-        typedef itk::MaskImageFilter< ImageType, MaskImageType, ImageType > MaskImageFilterType;
-        typename MaskImageFilterType::Pointer masker = MaskImageFilterType::New();
-        bool isMinAndMaxSameValue = (statistics.GetMin() == statistics.GetMax());
-        // bug 17962: following is a workaround for the case when min and max are the same, we can probably find a nicer way here
-        double outsideValue = (isMinAndMaxSameValue ? (statistics.GetMax()/2) : (statistics.GetMin()+statistics.GetMax())/2);
-        masker->SetOutsideValue( outsideValue );
-        masker->SetInput1(adaptedImage);
-        masker->SetInput2(adaptedMaskImage);
-        masker->SetCoordinateTolerance( 0.001 );
-        masker->SetDirectionTolerance( 0.001 );
-        masker->Update();
-        // get index of minimum and maximum
-        typedef itk::MinimumMaximumImageCalculator< ImageType > MinMaxFilterType;
-        typename MinMaxFilterType::Pointer minMaxFilter = MinMaxFilterType::New();
-        minMaxFilter->SetImage( masker->GetOutput() );
-        unsigned long observerTag2 = minMaxFilter->AddObserver( itk::ProgressEvent(), progressListener );
-        minMaxFilter->Compute();
-        minMaxFilter->RemoveObserver( observerTag2 );
-        this->InvokeEvent( itk::EndEvent() );
-
-        typename MinMaxFilterType::IndexType tempMaxIndex = minMaxFilter->GetIndexOfMaximum();
-        // bug 17962: following is a workaround for the case when min and max are the same, we can probably find a nicer way here
-        typename MinMaxFilterType::IndexType tempMinIndex =
-          (isMinAndMaxSameValue ? minMaxFilter->GetIndexOfMaximum() : minMaxFilter->GetIndexOfMinimum());
+        const IndexType &tempMaxIndex = it->m_MaximumIndex;
+        const IndexType &tempMinIndex = it->m_MinimumIndex;
 
         // FIX BUG 14644
         //If a PlanarFigure is used for segmentation the
@@ -1601,7 +1501,7 @@ namespace mitk
         if(IsHotspotCalculated() && VImageDimension == 3)
         {
           bool isDefined(false);
-          Statistics hotspotStatistics = CalculateHotspotStatistics(adaptedImage.GetPointer(), adaptedMaskImage.GetPointer(),GetHotspotRadiusInMM(), isDefined, *it);
+          Statistics hotspotStatistics = CalculateHotspotStatistics(adaptedImage.GetPointer(), adaptedMaskImage.GetPointer(),GetHotspotRadiusInMM(), isDefined, it->m_Label);
           statistics.GetHotspotStatistics() = hotspotStatistics;
           if(statistics.GetHotspotStatistics().HasHotspotStatistics())
           {
@@ -1877,6 +1777,21 @@ namespace mitk
   itk::SmartPointer<itk::Image<TPixel, VImageDimension> >
     ImageStatisticsCalculator::GenerateConvolutionImage( const itk::Image<TPixel, VImageDimension>* inputImage )
   {
+    typedef itk::Image< TPixel, VImageDimension > InputImageType;
+    typedef itk::Image< TPixel, VImageDimension > ConvolutionImageType;
+
+    // the convolution does not depend on the label, so all labels share it
+    if ( !m_HotspotRadiusInMMChanged
+      && m_HotspotConvolutionInput.GetPointer() == inputImage
+      && m_HotspotConvolutionInputMTime == inputImage->GetMTime() )
+    {
+      ConvolutionImageType* convolutionImage = dynamic_cast<ConvolutionImageType*>(m_HotspotConvolutionImage.GetPointer());
+      if (convolutionImage != nullptr)
+      {
+        return convolutionImage;
+      }
+    }
+
     double mmPerPixel[VImageDimension];
     for (unsigned int dimension = 0; dimension < VImageDimension; ++dimension)
     {
@@ -1888,13 +1803,33 @@ namespace mitk
     typename KernelImageType::Pointer convolutionKernel = this->GenerateHotspotSearchConvolutionKernel<VImageDimension>(mmPerPixel, m_HotspotRadiusInMM);
 
     // update convolution image
-    typedef itk::Image< TPixel, VImageDimension > InputImageType;
-    typedef itk::Image< TPixel, VImageDimension > ConvolutionImageType;
+    typedef itk::ConvolutionImageFilterBase<InputImageType,
+      KernelImageType,
+      ConvolutionImageType> ConvolutionFilterBaseType;
     typedef itk::FFTConvolutionImageFilter<InputImageType,
       KernelImageType,
-      ConvolutionImageType> ConvolutionFilterType;
+      ConvolutionImageType> FFTConvolutionFilterType;
+    typedef itk::ConvolutionImageFilter<InputImageType,
+      KernelImageType,
+      ConvolutionImageType> SpatialConvolutionFilterType;
+
+    // the FFT pays off for large kernels only, small kernels are convolved directly
+    bool useFFT = m_HotspotConvolutionMode == HOTSPOT_CONVOLUTION_FFT;
+    if (m_HotspotConvolutionMode == HOTSPOT_CONVOLUTION_AUTOMATIC)
+    {
+      useFFT = convolutionKernel->GetLargestPossibleRegion().GetNumberOfPixels() >= m_HotspotFFTKernelSizeThreshold;
+    }
+
+    typename ConvolutionFilterBaseType::Pointer convolutionFilter;
+    if (useFFT)
+    {
+      convolutionFilter = FFTConvolutionFilterType::New().GetPointer();
+    }
+    else
+    {
+      convolutionFilter = SpatialConvolutionFilterType::New().GetPointer();
+    }
 
-    typename ConvolutionFilterType::Pointer convolutionFilter = ConvolutionFilterType::New();
     typedef itk::ConstantBoundaryCondition<InputImageType, InputImageType> BoundaryConditionType;
     BoundaryConditionType boundaryCondition;
     boundaryCondition.SetConstant(0.0);
@@ -1908,12 +1843,17 @@ namespace mitk
     convolutionFilter->SetInput(inputImage);
     convolutionFilter->SetKernelImage(convolutionKernel);
     convolutionFilter->SetNormalize(true);
-    MITK_DEBUG << "Update Convolution image for hotspot search";
+    MITK_DEBUG << "Update Convolution image for hotspot search (" << (useFFT ? "FFT" : "spatial") << " convolution, kernel size "
+               << convolutionKernel->GetLargestPossibleRegion().GetSize() << ")";
     convolutionFilter->UpdateLargestPossibleRegion();
 
     typename ConvolutionImageType::Pointer convolutionImage = convolutionFilter->GetOutput();
     convolutionImage->SetSpacing( inputImage->GetSpacing() ); // only workaround because convolution filter seems to ignore spacing of input image
 
+    m_HotspotConvolutionImage = convolutionImage.GetPointer();
+    m_HotspotConvolutionInput = inputImage;
+    m_HotspotConvolutionInputMTime = inputImage->GetMTime();
+
     m_HotspotRadiusInMMChanged = false;
     return convolutionImage;
   }
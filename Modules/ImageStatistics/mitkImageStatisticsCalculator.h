@@ -62,6 +62,11 @@ namespace mitk
   * of the image (axial, sagittal, coronal). Planar figures on arbitrary
   * rotated planes are not supported.
   *
+  * Label images may contain many labels (e.g. parcellations). The statistics and
+  * histograms of all labels are calculated together in two multi-threaded passes
+  * over the image (see itk::MultiLabelStatisticsImageFilter); all histograms of
+  * a time step share the same bins.
+  *
   * For each operating mode (no masking, masking by image, masking by planar
   * figure), the calculated statistics and histogram are cached so that, when
   * switching back and forth between operation modes without modifying mask or
@@ -133,7 +138,10 @@ namespace mitk
   *
   * \image html convolutionkernelsupersampling.jpg
   *
-  * Convolution itself is done by means of the itkFFTConvolutionImageFilter.
+  * Convolution itself is done by means of the itkFFTConvolutionImageFilter for large
+  * kernels and by the spatial itkConvolutionImageFilter for small kernels, where the
+  * padding and transforms of the FFT cost more than they save (see SetHotspotConvolutionMode()).
+  * The convolution image is calculated once per time step and shared by all labels.
   * To find the hotspot location, we simply iterate the averaged image and find a
   * maximum location (see CalculateExtremaWorld()). In case of images with multiple
   * maxima the method returns value and corresponding index of the extrema that is
@@ -168,6 +176,14 @@ namespace mitk
       MASKING_MODE_PLANARFIGURE = 2
     };
 
+    /** \brief Enum for the convolution used to find the hotspot. */
+    enum
+    {
+      HOTSPOT_CONVOLUTION_AUTOMATIC = 0,
+      HOTSPOT_CONVOLUTION_SPATIAL = 1,
+      HOTSPOT_CONVOLUTION_FFT = 2
+    };
+
     typedef itk::Statistics::Histogram<double> HistogramType;
     typedef HistogramType::ConstIterator HistogramConstIteratorType;
 
@@ -339,6 +355,22 @@ namespace mitk
     /** \brief Returns true if hotspot has to be completly inside the image. */
     bool GetHotspotMustBeCompletlyInsideImage() const;
 
+    /** \brief Sets how the image is convolved with the hotspot sphere.
+    *
+    * HOTSPOT_CONVOLUTION_AUTOMATIC (default) uses FFT convolution for kernels with at least
+    * GetHotspotFFTKernelSizeThreshold() pixels and spatial convolution for smaller kernels.
+    * Both modes yield the same hotspot within rounding. */
+    void SetHotspotConvolutionMode( unsigned int mode );
+
+    /** \brief Returns how the image is convolved with the hotspot sphere. */
+    itkGetConstMacro( HotspotConvolutionMode, unsigned int );
+
+    /** \brief Sets the number of kernel pixels from which on FFT convolution is used in automatic mode. */
+    itkSetMacro( HotspotFFTKernelSizeThreshold, unsigned int );
+
+    /** \brief Returns the number of kernel pixels from which on FFT convolution is used in automatic mode. */
+    itkGetConstMacro( HotspotFFTKernelSizeThreshold, unsigned int );
+
     /** \brief Compute statistics (together with histogram) for the current
     * masking mode.
     *
@@ -398,11 +430,6 @@ namespace mitk
     * through. */
     void ExtractImageAndMask( unsigned int timeStep = 0 );
 
-    /*calculate the min and max value, this is done because we need the min and max value before execution the statistics filter to have the wright range for the histogramm*/
-    template < typename TPixel, unsigned int VImageDimension >
-    void  GetMinAndMaxValue(double &minimum, double &maximum, int &counter, double &sigma, const itk::Image< TPixel, VImageDimension > *InputImage,
-      itk::Image< unsigned short, VImageDimension > *MaskImageType);
-
     /** \brief If the passed vector matches any of the three principal axes
     * of the passed geometry, the ínteger value corresponding to the axis
     * is set and true is returned. */
@@ -528,7 +555,9 @@ namespace mitk
     itk::SmartPointer< itk::Image<float, VImageDimension> >
       GenerateHotspotSearchConvolutionKernel(double spacing[VImageDimension], double radiusInMM);
 
-    /** \brief Convolves image with spherical kernel image. Used for hotspot calculation.   */
+    /** \brief Convolves image with spherical kernel image. Used for hotspot calculation.
+    *
+    * The result is reused for further calls with the same image during one ComputeStatistics(). */
     template <typename TPixel, unsigned int VImageDimension>
     itk::SmartPointer< itk::Image<TPixel, VImageDimension> >
       GenerateConvolutionImage( const itk::Image<TPixel, VImageDimension>* inputImage );
@@ -595,6 +624,13 @@ namespace mitk
     bool m_CalculateHotspot;
     bool m_HotspotRadiusInMMChanged;
     bool m_HotspotMustBeCompletelyInsideImage;
+    unsigned int m_HotspotConvolutionMode;
+    unsigned int m_HotspotFFTKernelSizeThreshold;
+
+    // convolution image of the last hotspot search, shared by all labels of a time step
+    itk::DataObject::Pointer m_HotspotConvolutionImage;
+    itk::DataObject::ConstPointer m_HotspotConvolutionInput;
+    unsigned long m_HotspotConvolutionInputMTime;
 
 
   private:
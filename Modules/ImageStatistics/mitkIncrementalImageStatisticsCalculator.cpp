@@ -0,0 +1,570 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIncrementalImageStatisticsCalculator.h"
+#include "mitkImageAccessByItk.h"
+#include "mitkImageCast.h"
+#include "mitkImageSliceModifiedEvent.h"
+#include "mitkImageTimeSelector.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkImageRegionIterator.h>
+#include <itkCommand.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mitk
+{
+  namespace
+  {
+    /** Returns true if index a comes before index b in memory order. */
+    bool PrecedesInMemory( const itk::Index<3> &a, const itk::Index<3> &b )
+    {
+      for ( int dimension = 2; dimension >= 0; --dimension )
+      {
+        if ( a[dimension] != b[dimension] )
+        {
+          return a[dimension] < b[dimension];
+        }
+      }
+      return false;
+    }
+  }
+
+  IncrementalImageStatisticsCalculator::Accumulator::Accumulator()
+    : m_Count( 0 ),
+    m_Shift( 0.0 ),
+    m_PositiveSum( 0.0 ),
+    m_Minimum( std::numeric_limits<double>::max() ),
+    m_Maximum( -std::numeric_limits<double>::max() )
+  {
+    std::fill( m_Sums, m_Sums + 4, 0.0 );
+    m_MinimumIndex.Fill( 0 );
+    m_MaximumIndex.Fill( 0 );
+  }
+
+  void IncrementalImageStatisticsCalculator::Accumulator::Add( double value, const IndexType &index )
+  {
+    if ( m_Count == 0 )
+    {
+      m_Shift = value;
+    }
+
+    const double d = value - m_Shift;
+    const double d2 = d * d;
+    m_Sums[0] += d;
+    m_Sums[1] += d2;
+    m_Sums[2] += d2 * d;
+    m_Sums[3] += d2 * d2;
+    if ( value > 0.0 )
+    {
+      m_PositiveSum += value;
+    }
+    ++m_Count;
+
+    this->AddExtremum( value, index );
+  }
+
+  bool IncrementalImageStatisticsCalculator::Accumulator::Remove( double value, const IndexType &index )
+  {
+    const double d = value - m_Shift;
+    const double d2 = d * d;
+    m_Sums[0] -= d;
+    m_Sums[1] -= d2;
+    m_Sums[2] -= d2 * d;
+    m_Sums[3] -= d2 * d2;
+    if ( value > 0.0 )
+    {
+      m_PositiveSum -= value;
+    }
+    --m_Count;
+
+    return index != m_MinimumIndex && index != m_MaximumIndex;
+  }
+
+  void IncrementalImageStatisticsCalculator::Accumulator::AddExtremum( double value, const IndexType &index )
+  {
+    // ties are resolved like a traversal of the image would do: the first pixel in memory wins
+    if ( value < m_Minimum || ( value == m_Minimum && PrecedesInMemory( index, m_MinimumIndex ) ) )
+    {
+      m_Minimum = value;
+      m_MinimumIndex = index;
+    }
+    if ( value > m_Maximum || ( value == m_Maximum && PrecedesInMemory( index, m_MaximumIndex ) ) )
+    {
+      m_Maximum = value;
+      m_MaximumIndex = index;
+    }
+  }
+
+  IncrementalImageStatisticsCalculator::Statistics
+    IncrementalImageStatisticsCalculator::Accumulator::GetStatistics( unsigned int label ) const
+  {
+    Statistics statistics;
+    statistics.Reset( 3 );
+    statistics.SetHasHotspotStatistics( false );
+    statistics.SetLabel( label );
+    if ( m_Count == 0 )
+    {
+      return statistics;
+    }
+
+    // central moments from the sums of the shifted values
+    const double count = static_cast<double>( m_Count );
+    const double a = m_Sums[0] / count;
+    const double a2 = a * a;
+    const double m2 = std::max( 0.0, m_Sums[1] - count * a2 );
+    const double m3 = m_Sums[2] - 3.0 * a * m_Sums[1] + 2.0 * count * a2 * a;
+    const double m4 = m_Sums[3] - 4.0 * a * m_Sums[2] + 6.0 * a2 * m_Sums[1] - 3.0 * count * a2 * a2;
+
+    statistics.SetN( m_Count );
+    statistics.SetMin( m_Minimum );
+    statistics.SetMax( m_Maximum );
+    statistics.SetMean( m_Shift + a );
+    statistics.SetVariance( m_Count > 1 ? m2 / ( count - 1.0 ) : 0.0 );
+    statistics.SetSigma( std::sqrt( statistics.GetVariance() ) );
+    const double sigma = statistics.GetSigma();
+    if ( sigma >= mitk::eps )
+    {
+      statistics.SetSkewness( m3 / ( count * sigma * sigma * sigma ) );
+      statistics.SetKurtosis( m4 / ( count * sigma * sigma * sigma * sigma ) );
+    }
+    statistics.SetMPP( m_PositiveSum / count );
+    statistics.SetRMS( std::sqrt( statistics.GetMean() * statistics.GetMean() + sigma * sigma ) );
+
+    vnl_vector<int> minIndex( 3 );
+    vnl_vector<int> maxIndex( 3 );
+    for ( unsigned int i = 0; i < 3; ++i )
+    {
+      minIndex[i] = m_MinimumIndex[i];
+      maxIndex[i] = m_MaximumIndex[i];
+    }
+    statistics.SetMinIndex( minIndex );
+    statistics.SetMaxIndex( maxIndex );
+
+    return statistics;
+  }
+
+
+  IncrementalImageStatisticsCalculator::IncrementalImageStatisticsCalculator()
+    : m_TimeStep( 0 ),
+    m_NumberOfChangedPixels( 0 ),
+    m_MaskSliceObserverTag( 0 ),
+    m_MaskObserverTag( 0 ),
+    m_MaskModifiedExpected( false ),
+    m_MaskModifiedInUnknownRegion( false )
+  {
+  }
+
+  IncrementalImageStatisticsCalculator::~IncrementalImageStatisticsCalculator()
+  {
+    this->RemoveMaskObservers();
+  }
+
+  void IncrementalImageStatisticsCalculator::SetImage( const mitk::Image *image )
+  {
+    if ( m_Image != image )
+    {
+      m_Image = image;
+      m_MaskCopy = nullptr;
+      this->Modified();
+    }
+  }
+
+  void IncrementalImageStatisticsCalculator::SetImageMask( const mitk::Image *imageMask )
+  {
+    if ( m_ImageMask != imageMask )
+    {
+      this->RemoveMaskObservers();
+      m_ImageMask = imageMask;
+      m_MaskCopy = nullptr;
+      m_MaskModifiedExpected = false;
+      m_MaskModifiedInUnknownRegion = false;
+
+      if ( m_ImageMask.IsNotNull() )
+      {
+        itk::ReceptorMemberCommand< Self >::Pointer sliceCommand = itk::ReceptorMemberCommand< Self >::New();
+        sliceCommand->SetCallbackFunction( this, &Self::OnMaskSliceModified );
+        m_MaskSliceObserverTag = m_ImageMask->AddObserver( ImageSliceModifiedEvent(), sliceCommand );
+
+        itk::SimpleMemberCommand< Self >::Pointer modifiedCommand = itk::SimpleMemberCommand< Self >::New();
+        modifiedCommand->SetCallbackFunction( this, &Self::OnMaskModified );
+        m_MaskObserverTag = m_ImageMask->AddObserver( itk::ModifiedEvent(), modifiedCommand );
+      }
+      this->Modified();
+    }
+  }
+
+  void IncrementalImageStatisticsCalculator::RemoveMaskObservers()
+  {
+    if ( m_ImageMask.IsNotNull() )
+    {
+      m_ImageMask->RemoveObserver( m_MaskSliceObserverTag );
+      m_ImageMask->RemoveObserver( m_MaskObserverTag );
+    }
+  }
+
+  void IncrementalImageStatisticsCalculator::OnMaskSliceModified( const itk::EventObject &event )
+  {
+    const ImageSliceModifiedEvent *sliceEvent = dynamic_cast< const ImageSliceModifiedEvent* >( &event );
+    if ( sliceEvent == nullptr || m_Image.IsNull() )
+    {
+      return;
+    }
+
+    // a slice of another time step is treated like a change in an unknown region by the following ModifiedEvent
+    const unsigned int maskTimeStep = std::min( m_TimeStep, m_ImageMask->GetTimeSteps() - 1 );
+    if ( sliceEvent->GetTimeStep() != maskTimeStep )
+    {
+      return;
+    }
+
+    // the event is invoked by the tool that edits the mask, which must not fail because of the statistics
+    try
+    {
+      if ( m_MaskModifiedInUnknownRegion )
+      {
+        this->Update();
+      }
+      else
+      {
+        this->UpdateSlice( sliceEvent->GetSlice() );
+      }
+    }
+    catch ( const itk::ExceptionObject &e )
+    {
+      MITK_WARN << "Could not update the statistics of the edited mask: " << e.GetDescription();
+      m_MaskCopy = nullptr;
+      this->Modified();
+    }
+    m_MaskModifiedExpected = true;
+  }
+
+  void IncrementalImageStatisticsCalculator::OnMaskModified()
+  {
+    if ( m_MaskModifiedExpected )
+    {
+      m_MaskModifiedExpected = false;
+      return;
+    }
+    m_MaskModifiedInUnknownRegion = true;
+    this->Modified();
+  }
+
+  void IncrementalImageStatisticsCalculator::SetTimeStep( unsigned int timeStep )
+  {
+    if ( m_TimeStep != timeStep )
+    {
+      m_TimeStep = timeStep;
+      m_MaskCopy = nullptr;
+      this->Modified();
+    }
+  }
+
+  bool IncrementalImageStatisticsCalculator::IsInitialized() const
+  {
+    return m_MaskCopy.IsNotNull();
+  }
+
+  bool IncrementalImageStatisticsCalculator::IsUpToDate() const
+  {
+    return this->IsInitialized() && !m_MaskModifiedInUnknownRegion;
+  }
+
+  mitk::Image::ConstPointer IncrementalImageStatisticsCalculator::GetTimeStepImage( const mitk::Image *image ) const
+  {
+    ImageTimeSelector::Pointer timeSelector = ImageTimeSelector::New();
+    timeSelector->SetInput( image );
+    timeSelector->SetTimeNr( std::min( m_TimeStep, image->GetTimeSteps() - 1 ) );
+    timeSelector->UpdateLargestPossibleRegion();
+
+    mitk::Image::ConstPointer timeStepImage = timeSelector->GetOutput();
+    if ( timeStepImage->GetDimension() != 3 )
+    {
+      mitkThrow() << "Incremental statistics are only supported for 3D images.";
+    }
+    return timeStepImage;
+  }
+
+  void IncrementalImageStatisticsCalculator::Initialize()
+  {
+    if ( m_Image.IsNull() || m_ImageMask.IsNull() )
+    {
+      mitkThrow() << "Image and mask have to be set.";
+    }
+    if ( m_TimeStep >= m_Image->GetTimeSteps() )
+    {
+      mitkThrow() << "Invalid time step " << m_TimeStep;
+    }
+
+    mitk::Image::ConstPointer image = this->GetTimeStepImage( m_Image );
+    mitk::Image::ConstPointer mask = this->GetTimeStepImage( m_ImageMask );
+    for ( unsigned int i = 0; i < 3; ++i )
+    {
+      if ( image->GetDimension( i ) != mask->GetDimension( i ) )
+      {
+        mitkThrow() << "Image and mask differ in size.";
+      }
+    }
+
+    // the copy must not share its memory with the mask that is edited
+    m_MaskCopy = nullptr;
+    if ( mask->GetPixelType().GetComponentType() != itk::ImageIOBase::USHORT )
+    {
+      CastToItkImage( mask, m_MaskCopy );
+    }
+    else
+    {
+      CastToItkImage( mask->Clone(), m_MaskCopy );
+    }
+
+    m_Accumulators.clear();
+    m_NumberOfChangedPixels = 0;
+    m_MaskModifiedInUnknownRegion = false;
+    AccessFixedDimensionByItk( image, InternalInitialize, 3 );
+    this->Modified();
+  }
+
+  void IncrementalImageStatisticsCalculator::UpdateRegion( const RegionType &region )
+  {
+    if ( !this->IsInitialized() )
+    {
+      this->Initialize();
+      return;
+    }
+
+    RegionType croppedRegion = region;
+    if ( !croppedRegion.Crop( m_MaskCopy->GetLargestPossibleRegion() ) )
+    {
+      m_NumberOfChangedPixels = 0;
+      return;
+    }
+
+    m_Changes.clear();
+    mitk::Image::ConstPointer mask = this->GetTimeStepImage( m_ImageMask );
+    AccessFixedDimensionByItk_1( mask, InternalCollectChanges, 3, croppedRegion );
+    m_NumberOfChangedPixels = m_Changes.size();
+
+    if ( !m_Changes.empty() )
+    {
+      mitk::Image::ConstPointer image = this->GetTimeStepImage( m_Image );
+      AccessFixedDimensionByItk( image, InternalApplyChanges, 3 );
+      this->Modified();
+    }
+    m_Changes.clear();
+  }
+
+  void IncrementalImageStatisticsCalculator::UpdateSlice( const mitk::PlaneGeometry *slice )
+  {
+    if ( slice == nullptr )
+    {
+      this->Update();
+      return;
+    }
+    if ( !this->IsInitialized() )
+    {
+      this->Initialize();
+      return;
+    }
+
+    // index bounding box of the corners of the slice, enlarged by one pixel for rounding
+    const mitk::BaseGeometry *maskGeometry = this->GetTimeStepImage( m_ImageMask )->GetGeometry();
+    itk::Index<3> minimum;
+    itk::Index<3> maximum;
+    for ( int corner = 0; corner < 8; ++corner )
+    {
+      mitk::Point3D index;
+      maskGeometry->WorldToIndex( slice->GetCornerPoint( corner ), index );
+      for ( unsigned int i = 0; i < 3; ++i )
+      {
+        const itk::IndexValueType value = static_cast<itk::IndexValueType>( std::floor( index[i] + 0.5 ) );
+        minimum[i] = corner == 0 ? value - 1 : std::min( minimum[i], value - 1 );
+        maximum[i] = corner == 0 ? value + 1 : std::max( maximum[i], value + 1 );
+      }
+    }
+
+    RegionType region;
+    region.SetIndex( minimum );
+    for ( unsigned int i = 0; i < 3; ++i )
+    {
+      region.SetSize( i, maximum[i] - minimum[i] + 1 );
+    }
+    this->UpdateRegion( region );
+  }
+
+  void IncrementalImageStatisticsCalculator::Update()
+  {
+    if ( !this->IsInitialized() )
+    {
+      this->Initialize();
+      return;
+    }
+    const bool wasOutdated = m_MaskModifiedInUnknownRegion;
+    m_MaskModifiedInUnknownRegion = false;
+    this->UpdateRegion( m_MaskCopy->GetLargestPossibleRegion() );
+    if ( wasOutdated && m_NumberOfChangedPixels == 0 )
+    {
+      // up to date again without any change of the statistics
+      this->Modified();
+    }
+  }
+
+  IncrementalImageStatisticsCalculator::StatisticsContainer IncrementalImageStatisticsCalculator::GetStatistics() const
+  {
+    StatisticsContainer statistics;
+    for ( AccumulatorMap::const_iterator it = m_Accumulators.begin(); it != m_Accumulators.end(); ++it )
+    {
+      statistics.push_back( it->second.GetStatistics( it->first ) );
+    }
+    return statistics;
+  }
+
+  IncrementalImageStatisticsCalculator::Statistics IncrementalImageStatisticsCalculator::GetStatistics( unsigned int label ) const
+  {
+    AccumulatorMap::const_iterator it = m_Accumulators.find( label );
+    if ( it == m_Accumulators.end() )
+    {
+      return Accumulator().GetStatistics( label );
+    }
+    return it->second.GetStatistics( label );
+  }
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void IncrementalImageStatisticsCalculator::InternalInitialize( const itk::Image< TPixel, VImageDimension > *image )
+  {
+    typedef itk::Image< TPixel, VImageDimension > ImageType;
+
+    itk::ImageRegionConstIteratorWithIndex< ImageType > imageIt( image, image->GetLargestPossibleRegion() );
+    itk::ImageRegionConstIterator< MaskImageType > maskIt( m_MaskCopy, m_MaskCopy->GetLargestPossibleRegion() );
+
+    // consecutive pixels mostly share the label, so the map lookup is done once per run
+    unsigned short currentLabel = 0;
+    Accumulator *accumulator = nullptr;
+    for ( ; !imageIt.IsAtEnd(); ++imageIt, ++maskIt )
+    {
+      const unsigned short label = maskIt.Get();
+      if ( label == 0 )
+      {
+        continue;
+      }
+      if ( accumulator == nullptr || label != currentLabel )
+      {
+        currentLabel = label;
+        accumulator = &m_Accumulators[label];
+      }
+      accumulator->Add( static_cast<double>( imageIt.Get() ), imageIt.GetIndex() );
+    }
+  }
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void IncrementalImageStatisticsCalculator::InternalCollectChanges( const itk::Image< TPixel, VImageDimension > *mask, RegionType region )
+  {
+    typedef itk::Image< TPixel, VImageDimension > ImageType;
+
+    itk::ImageRegionConstIteratorWithIndex< ImageType > maskIt( mask, region );
+    itk::ImageRegionIterator< MaskImageType > copyIt( m_MaskCopy, region );
+    for ( ; !maskIt.IsAtEnd(); ++maskIt, ++copyIt )
+    {
+      const unsigned short label = static_cast<unsigned short>( maskIt.Get() );
+      if ( label != copyIt.Get() )
+      {
+        Change change;
+        change.m_Index = maskIt.GetIndex();
+        change.m_OldLabel = copyIt.Get();
+        change.m_NewLabel = label;
+        m_Changes.push_back( change );
+
+        copyIt.Set( label );
+      }
+    }
+  }
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void IncrementalImageStatisticsCalculator::InternalApplyChanges( const itk::Image< TPixel, VImageDimension > *image )
+  {
+    std::vector< unsigned short > labelsWithLostExtrema;
+
+    for ( std::vector< Change >::const_iterator it = m_Changes.begin(); it != m_Changes.end(); ++it )
+    {
+      const double value = static_cast<double>( image->GetPixel( it->m_Index ) );
+
+      if ( it->m_OldLabel != 0 )
+      {
+        AccumulatorMap::iterator accumulator = m_Accumulators.find( it->m_OldLabel );
+        if ( !accumulator->second.Remove( value, it->m_Index ) )
+        {
+          labelsWithLostExtrema.push_back( it->m_OldLabel );
+        }
+        if ( accumulator->second.m_Count == 0 )
+        {
+          m_Accumulators.erase( accumulator );
+        }
+      }
+
+      if ( it->m_NewLabel != 0 )
+      {
+        m_Accumulators[it->m_NewLabel].Add( value, it->m_Index );
+      }
+    }
+
+    // labels that lost their minimum or maximum pixel and still exist
+    std::sort( labelsWithLostExtrema.begin(), labelsWithLostExtrema.end() );
+    labelsWithLostExtrema.erase( std::unique( labelsWithLostExtrema.begin(), labelsWithLostExtrema.end() ), labelsWithLostExtrema.end() );
+    std::vector< unsigned short > labels;
+    for ( size_t i = 0; i < labelsWithLostExtrema.size(); ++i )
+    {
+      if ( m_Accumulators.count( labelsWithLostExtrema[i] ) != 0 )
+      {
+        labels.push_back( labelsWithLostExtrema[i] );
+      }
+    }
+
+    if ( !labels.empty() )
+    {
+      this->InternalFindExtrema( image, labels );
+    }
+  }
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void IncrementalImageStatisticsCalculator::InternalFindExtrema( const itk::Image< TPixel, VImageDimension > *image, const std::vector< unsigned short > &labels )
+  {
+    typedef itk::Image< TPixel, VImageDimension > ImageType;
+
+    // label -> accumulator, for the labels that are searched
+    std::vector< Accumulator* > accumulators( labels.back() + 1, static_cast<Accumulator*>( nullptr ) );
+    for ( size_t i = 0; i < labels.size(); ++i )
+    {
+      Accumulator &accumulator = m_Accumulators[labels[i]];
+      accumulator.m_Minimum = std::numeric_limits<double>::max();
+      accumulator.m_Maximum = -std::numeric_limits<double>::max();
+      accumulators[labels[i]] = &accumulator;
+    }
+
+    itk::ImageRegionConstIteratorWithIndex< ImageType > imageIt( image, image->GetLargestPossibleRegion() );
+    itk::ImageRegionConstIterator< MaskImageType > maskIt( m_MaskCopy, m_MaskCopy->GetLargestPossibleRegion() );
+    for ( ; !imageIt.IsAtEnd(); ++imageIt, ++maskIt )
+    {
+      const unsigned short label = maskIt.Get();
+      if ( label < accumulators.size() && accumulators[label] != nullptr )
+      {
+        accumulators[label]->AddExtremum( static_cast<double>( imageIt.Get() ), imageIt.GetIndex() );
+      }
+    }
+  }
+}
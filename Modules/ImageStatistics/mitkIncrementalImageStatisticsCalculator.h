@@ -0,0 +1,202 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef _MITK_INCREMENTALIMAGESTATISTICSCALCULATOR_H
+#define _MITK_INCREMENTALIMAGESTATISTICSCALCULATOR_H
+
+#include <MitkImageStatisticsExports.h>
+#include "mitkImageStatisticsCalculator.h"
+#include <mitkPlaneGeometry.h>
+
+#include <itkObject.h>
+#include <itkImage.h>
+
+#include <map>
+#include <vector>
+
+namespace mitk
+{
+
+/**
+ * \brief Keeps the statistics of all labels of a mask up to date while the mask is edited.
+ *
+ * Initialize() traverses the image once and keeps running sums for every label of the mask,
+ * together with a copy of the mask. When parts of the mask have been changed, e.g. by a
+ * segmentation tool or by a DiffSliceOperation (undo/redo), UpdateRegion() or UpdateSlice()
+ * compare the given part of the mask to the copy and move only the changed pixels from their
+ * old to their new label. The cost of an update depends on the size of the changed region,
+ * not on the size of the image, so the statistics can follow the user's painting interactively.
+ *
+ * The calculator observes the mask: an ImageSliceModifiedEvent, which the segmentation tools and
+ * their undo/redo invoke for every written slice, updates the statistics for that slice (and
+ * initializes them on the first edit). If the mask is modified without such an event, e.g. by a
+ * 3D tool, the changed region is unknown: IsUpToDate() returns false until the next update,
+ * which then compares the whole mask. A ModifiedEvent is invoked whenever the statistics changed
+ * or became outdated. The image itself must not change, call Initialize() again if it does.
+ *
+ * For each label the count, mean, variance, sigma, RMS, skewness, kurtosis, MPP, minimum and
+ * maximum (and their first index in memory order) are maintained, with the same definitions as
+ * in ImageStatisticsCalculator. The values depending on a histogram (median, entropy,
+ * uniformity, UPP) and the hotspot are not calculated, use ImageStatisticsCalculator to get
+ * them once the editing is finished.
+ *
+ * The running sums are taken relative to the first value of each label to avoid the
+ * cancellation of the naive sum of squares. If the pixel holding the minimum or maximum of a
+ * label is removed from the label, the extrema of that label are searched again in the whole
+ * image, which happens rarely while painting.
+ *
+ * Only 3D images (or a time step of 3D+t images) are supported. Image and mask must have the
+ * same size. Label 0 is background and not part of the statistics.
+ */
+class MITKIMAGESTATISTICS_EXPORT IncrementalImageStatisticsCalculator : public itk::Object
+{
+public:
+
+  typedef ImageStatisticsCalculator::Statistics Statistics;
+  typedef ImageStatisticsCalculator::StatisticsContainer StatisticsContainer;
+  typedef itk::Image< unsigned short, 3 > MaskImageType;
+  typedef MaskImageType::RegionType RegionType;
+  typedef MaskImageType::IndexType IndexType;
+
+  mitkClassMacroItkParent( IncrementalImageStatisticsCalculator, itk::Object );
+  itkFactorylessNewMacro(Self)
+
+  /** \brief Set image from which to compute statistics. */
+  void SetImage( const mitk::Image *image );
+
+  /** \brief Set the label image for masking, which is edited. */
+  void SetImageMask( const mitk::Image *imageMask );
+
+  /** \brief Set the time step of image and mask, Initialize() has to be called afterwards. */
+  void SetTimeStep( unsigned int timeStep );
+  itkGetConstMacro( TimeStep, unsigned int );
+
+  /** \brief Computes the statistics of all labels and copies the mask for later comparison. */
+  void Initialize();
+
+  /** \brief Returns true if Initialize() has been called for the current image and mask. */
+  bool IsInitialized() const;
+
+  /** \brief Returns false if the mask has been modified in an unknown region since the last update. */
+  bool IsUpToDate() const;
+
+  /** \brief Updates the statistics for the changes of the mask within the given index region. */
+  void UpdateRegion( const RegionType &region );
+
+  /** \brief Updates the statistics for the changes of the mask within a slice,
+   * e.g. the world geometry of a DiffSliceOperation or of the tool that changed the slice. */
+  void UpdateSlice( const mitk::PlaneGeometry *slice );
+
+  /** \brief Updates the statistics for all changes of the mask, when the changed region is not known.
+   *
+   * This still has to compare the whole mask but is much cheaper than computing all statistics again. */
+  void Update();
+
+  /** \brief Returns the statistics of all labels (except 0) in ascending order of the labels. */
+  StatisticsContainer GetStatistics() const;
+
+  /** \brief Returns the statistics of a label, its N is 0 if the mask does not contain the label. */
+  Statistics GetStatistics( unsigned int label ) const;
+
+  /** \brief Returns the number of pixels that changed their label during the last update. */
+  itkGetConstMacro( NumberOfChangedPixels, unsigned long );
+
+protected:
+
+  /** \brief Running sums of the pixels of one label. */
+  struct Accumulator
+  {
+    Accumulator();
+
+    void Add( double value, const IndexType &index );
+
+    /** \brief Removes a value, returns false if the extrema have to be searched again. */
+    bool Remove( double value, const IndexType &index );
+
+    void AddExtremum( double value, const IndexType &index );
+
+    Statistics GetStatistics( unsigned int label ) const;
+
+    unsigned long m_Count;
+    double m_Shift;
+    double m_Sums[4]; // sums of the first to fourth power of (value - m_Shift)
+    double m_PositiveSum;
+    double m_Minimum;
+    double m_Maximum;
+    IndexType m_MinimumIndex;
+    IndexType m_MaximumIndex;
+  };
+
+  /** \brief A pixel whose label has changed. */
+  struct Change
+  {
+    IndexType m_Index;
+    unsigned short m_OldLabel;
+    unsigned short m_NewLabel;
+  };
+
+  typedef std::map< unsigned short, Accumulator > AccumulatorMap;
+
+  IncrementalImageStatisticsCalculator();
+  virtual ~IncrementalImageStatisticsCalculator();
+
+  /** \brief Returns the time step of the image, the last time step for masks with fewer time steps. */
+  mitk::Image::ConstPointer GetTimeStepImage( const mitk::Image *image ) const;
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalInitialize( const itk::Image< TPixel, VImageDimension > *image );
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalCollectChanges( const itk::Image< TPixel, VImageDimension > *mask, RegionType region );
+
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalApplyChanges( const itk::Image< TPixel, VImageDimension > *image );
+
+  /** \brief Updates the statistics for a slice that a segmentation tool or undo/redo has written. */
+  void OnMaskSliceModified( const itk::EventObject &event );
+
+  /** \brief Marks the statistics as outdated, unless the modification has been announced by a slice event. */
+  void OnMaskModified();
+
+  void RemoveMaskObservers();
+
+  /** \brief Searches minimum and maximum of the given labels in the whole image. */
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalFindExtrema( const itk::Image< TPixel, VImageDimension > *image, const std::vector< unsigned short > &labels );
+
+  mitk::Image::ConstPointer m_Image;
+  mitk::Image::ConstPointer m_ImageMask;
+  unsigned int m_TimeStep;
+
+  MaskImageType::Pointer m_MaskCopy;
+  AccumulatorMap m_Accumulators;
+  std::vector< Change > m_Changes;
+  unsigned long m_NumberOfChangedPixels;
+
+  long m_MaskSliceObserverTag;
+  long m_MaskObserverTag;
+  bool m_MaskModifiedExpected;        // the next ModifiedEvent of the mask belongs to a handled slice event
+  bool m_MaskModifiedInUnknownRegion; // the next update has to compare the whole mask
+
+private:
+
+  IncrementalImageStatisticsCalculator( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+};
+
+}
+
+#endif // #define _MITK_INCREMENTALIMAGESTATISTICSCALCULATOR_H
@@ -0,0 +1,248 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#ifndef __mitkMultiLabelStatisticsImageFilter_h
+#define __mitkMultiLabelStatisticsImageFilter_h
+
+#include <itkImageToImageFilter.h>
+#include <itkHistogram.h>
+
+#include <vector>
+
+namespace itk
+{
+  /**
+  * \class MultiLabelStatisticsImageFilter
+  * \brief Calculates statistics and histograms of an image for all labels of a label image at once.
+  *
+  * In contrast to the ExtendedLabelStatisticsImageFilter the cost does not grow with the number of
+  * labels: the image is traversed twice in total, independent of how many labels the label image
+  * contains (e.g. parcellations with hundreds of labels).
+  *
+  * The first traversal accumulates count, minimum, maximum (and their first index), mean and the
+  * central moments of order two to four for every label. The second traversal fills the histograms.
+  * All labels share the same bin layout, so the bin of a pixel is looked up only once. Both
+  * traversals are multi-threaded; every thread accumulates into its own partial results which are
+  * merged at the end, moments are merged with the pairwise formulas of Pebay (2008) so the result
+  * does not suffer from the cancellation of the naive sum of squares.
+  *
+  * Pixels with label 0 are ignored, all other labels must be integers. Labels are used as index of
+  * the partial results, offset by the smallest label if the label type is signed.
+  *
+  * If no histogram range is given by SetHistogramParameters(), the histograms cover the range
+  * [floor(min), ceil(max)] of all labelled pixels with one bin per gray value, but at most
+  * MaximumNumberOfDefaultBins bins, or 100 bins if the range spans at most 10 gray values.
+  * Every thread fills histograms of all labels, so the histogram pass uses only as many threads
+  * as fit into a memory budget of HistogramThreadMemoryBudget bytes (at least one).
+  *
+  * Skewness and kurtosis are the third and fourth standardized moments (using the sample standard
+  * deviation), Entropy, Uniformity and UPP are derived from the histogram, MPP is the mean of the
+  * positive pixel values, see ExtendedLabelStatisticsImageFilter.
+  */
+  template< class TInputImage, class TLabelImage >
+  class MultiLabelStatisticsImageFilter : public ImageToImageFilter< TInputImage, TInputImage >
+  {
+  public:
+
+    typedef MultiLabelStatisticsImageFilter                 Self;
+    typedef ImageToImageFilter< TInputImage, TInputImage >  Superclass;
+    typedef SmartPointer< Self >                            Pointer;
+    typedef SmartPointer< const Self >                      ConstPointer;
+
+    itkNewMacro( Self );
+    itkTypeMacro( MultiLabelStatisticsImageFilter, ImageToImageFilter );
+
+    itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+    /** \brief Upper limit of the number of bins if no histogram range is given. */
+    itkStaticConstMacro( MaximumNumberOfDefaultBins, unsigned int, 4096 );
+
+    /** \brief Memory (in bytes) the partial histograms of all threads may use. */
+    itkStaticConstMacro( HistogramThreadMemoryBudget, SizeValueType, 256 * 1024 * 1024 );
+
+    typedef TInputImage                                     InputImageType;
+    typedef TLabelImage                                     LabelImageType;
+    typedef typename TInputImage::PixelType                 PixelType;
+    typedef typename TLabelImage::PixelType                 LabelPixelType;
+    typedef typename TInputImage::RegionType                RegionType;
+    typedef typename TInputImage::IndexType                 IndexType;
+    typedef double                                          RealType;
+    typedef itk::Statistics::Histogram<double>              HistogramType;
+
+    /** \brief Statistics of a single label. */
+    class LabelStatistics
+    {
+    public:
+      LabelStatistics();
+
+      LabelPixelType m_Label;
+      SizeValueType m_Count;
+      RealType m_Minimum;
+      RealType m_Maximum;
+      IndexType m_MinimumIndex;
+      IndexType m_MaximumIndex;
+      RealType m_Mean;
+      RealType m_Median;
+      RealType m_Variance;
+      RealType m_Sigma;
+      RealType m_Skewness;
+      RealType m_Kurtosis;
+      RealType m_Entropy;
+      RealType m_Uniformity;
+      RealType m_UPP;
+      RealType m_MPP;
+      HistogramType::Pointer m_Histogram;
+    };
+
+    typedef std::vector< LabelStatistics > LabelStatisticsContainer;
+
+    /** \brief Set the label image, it has to cover the region of the input image. */
+    void SetLabelInput( const TLabelImage *input );
+    const TLabelImage * GetLabelInput() const;
+
+    /** \brief Calculate histograms (and the values derived from them: median, entropy, uniformity, UPP). Default on. */
+    itkSetMacro( UseHistograms, bool );
+    itkGetConstMacro( UseHistograms, bool );
+    itkBooleanMacro( UseHistograms );
+
+    /** \brief Use a fixed histogram range instead of the range of the labelled pixels. */
+    void SetHistogramParameters( unsigned int numberOfBins, RealType lowerBound, RealType upperBound );
+
+    /** \brief Statistics of all labels (except 0) found in the label image, in ascending order of the labels. */
+    const LabelStatisticsContainer & GetLabelStatistics() const;
+
+    /** \brief Labels (except 0) found in the label image, in ascending order. */
+    std::vector< LabelPixelType > GetLabels() const;
+
+    bool HasLabel( LabelPixelType label ) const;
+
+    /** \brief Statistics of a label, throws if the label does not exist. */
+    const LabelStatistics & GetStatistics( LabelPixelType label ) const;
+
+    /** \brief Minimum and maximum of the pixels with any label. */
+    itkGetConstMacro( Minimum, RealType );
+    itkGetConstMacro( Maximum, RealType );
+
+  protected:
+
+    /** \brief Accumulated values of a label within the part of the image that is processed by a single thread. */
+    struct Accumulator
+    {
+      Accumulator();
+
+      /** \brief Adds a value to count, mean and moments (extrema are updated by the caller, which knows the index). */
+      void Add( RealType value );
+      void Merge( const Accumulator &other );
+
+      SizeValueType m_Count;
+      RealType m_Minimum;
+      RealType m_Maximum;
+      IndexType m_MinimumIndex;
+      IndexType m_MaximumIndex;
+      RealType m_Mean;
+      RealType m_M2;
+      RealType m_M3;
+      RealType m_M4;
+      RealType m_PositiveSum;
+    };
+
+    typedef std::vector< Accumulator > AccumulatorContainer;
+    typedef std::vector< SizeValueType > FrequencyContainer;
+
+    enum Pass
+    {
+      MOMENTS_PASS,
+      HISTOGRAM_PASS
+    };
+
+    struct PassStruct
+    {
+      Self *Filter;
+      RegionType Region;
+    };
+
+    MultiLabelStatisticsImageFilter();
+    virtual ~MultiLabelStatisticsImageFilter() {}
+
+    /** \brief Input and label image are always processed completely. */
+    virtual void GenerateInputRequestedRegion() override;
+    virtual void EnlargeOutputRequestedRegion( DataObject *data ) override;
+
+    /** \brief The input is passed through as the output. */
+    virtual void AllocateOutputs() override;
+
+    virtual void GenerateData() override;
+
+    /** \brief Determines the smallest label of a signed label type, so that labels can be used as index. */
+    void InitializeLabelOffset( const RegionType &region );
+
+    /** \brief Index of a label in the partial results (valid after InitializeLabelOffset()). */
+    size_t GetLabelSlot( LabelPixelType label ) const
+    {
+      return static_cast< size_t >( static_cast< OffsetValueType >( label ) - m_LabelOffset );
+    }
+
+    /** \brief Splits the region into the part that is processed by the given thread, along the slowest dimension. */
+    bool SplitRegion( const RegionType &region, ThreadIdType threadId, ThreadIdType numberOfThreads, RegionType &splitRegion ) const;
+
+    void ExecutePass( Pass pass, const RegionType &region );
+
+    static ITK_THREAD_RETURN_TYPE PassCallback( void *arg );
+
+    void AccumulateMoments( const RegionType &region, ThreadIdType threadId );
+    void AccumulateHistograms( const RegionType &region, ThreadIdType threadId );
+
+    void MergeMoments();
+    void InitializeHistogramLayout();
+    void MergeHistograms();
+
+  private:
+
+    MultiLabelStatisticsImageFilter( const Self & ); // purposely not implemented
+    void operator=( const Self & ); // purposely not implemented
+
+    Pass m_Pass;
+
+    // partial results of every thread, indexed by label
+    std::vector< AccumulatorContainer > m_ThreadAccumulators;
+    // partial histograms of every thread, m_NumberOfBins entries per label slot
+    std::vector< FrequencyContainer > m_ThreadFrequencies;
+
+    // label slot (see GetLabelSlot()) -> index in m_LabelStatistics (-1 for labels that do not occur)
+    std::vector< int > m_LabelSlots;
+    // smallest label if it is negative, 0 otherwise
+    OffsetValueType m_LabelOffset;
+    LabelStatisticsContainer m_LabelStatistics;
+
+    bool m_UseHistograms;
+    bool m_UseFixedHistogramRange;
+    unsigned int m_NumberOfBins;
+    RealType m_LowerBound;
+    RealType m_UpperBound;
+    // bin layout shared by the histograms of all labels
+    HistogramType::Pointer m_HistogramLayout;
+
+    RealType m_Minimum;
+    RealType m_Maximum;
+
+  }; // end of class
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "mitkMultiLabelStatisticsImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,694 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+#ifndef _mitkMultiLabelStatisticsImageFilter_hxx
+#define _mitkMultiLabelStatisticsImageFilter_hxx
+
+#include "mitkMultiLabelStatisticsImageFilter.h"
+
+#include <itkImageRegionConstIterator.h>
+#include <itkProgressReporter.h>
+#include "mitkNumericConstants.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace itk
+{
+  template< class TInputImage, class TLabelImage >
+  MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::LabelStatistics
+    ::LabelStatistics()
+    : m_Label( 0 ),
+    m_Count( 0 ),
+    m_Minimum( 0.0 ),
+    m_Maximum( 0.0 ),
+    m_Mean( 0.0 ),
+    m_Median( 0.0 ),
+    m_Variance( 0.0 ),
+    m_Sigma( 0.0 ),
+    m_Skewness( 0.0 ),
+    m_Kurtosis( 0.0 ),
+    m_Entropy( 0.0 ),
+    m_Uniformity( 0.0 ),
+    m_UPP( 0.0 ),
+    m_MPP( 0.0 )
+  {
+    m_MinimumIndex.Fill( 0 );
+    m_MaximumIndex.Fill( 0 );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::Accumulator
+    ::Accumulator()
+    : m_Count( 0 ),
+    m_Minimum( 0.0 ),
+    m_Maximum( 0.0 ),
+    m_Mean( 0.0 ),
+    m_M2( 0.0 ),
+    m_M3( 0.0 ),
+    m_M4( 0.0 ),
+    m_PositiveSum( 0.0 )
+  {
+    m_MinimumIndex.Fill( 0 );
+    m_MaximumIndex.Fill( 0 );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::Accumulator
+    ::Add( RealType value )
+  {
+    // one-pass update of mean and central moments (Pebay 2008, eq. 1.1, 2.1 and 2.2)
+    const RealType n1 = static_cast< RealType >( m_Count );
+    ++m_Count;
+    const RealType n = static_cast< RealType >( m_Count );
+
+    const RealType delta = value - m_Mean;
+    const RealType deltaN = delta / n;
+    const RealType deltaN2 = deltaN * deltaN;
+    const RealType term1 = delta * deltaN * n1;
+
+    m_Mean += deltaN;
+    m_M4 += term1 * deltaN2 * ( n * n - 3.0 * n + 3.0 ) + 6.0 * deltaN2 * m_M2 - 4.0 * deltaN * m_M3;
+    m_M3 += term1 * deltaN * ( n - 2.0 ) - 3.0 * deltaN * m_M2;
+    m_M2 += term1;
+
+    if ( value > 0 )
+    {
+      m_PositiveSum += value;
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::Accumulator
+    ::Merge( const Accumulator &other )
+  {
+    if ( other.m_Count == 0 )
+    {
+      return;
+    }
+    if ( m_Count == 0 )
+    {
+      *this = other;
+      return;
+    }
+
+    // other always covers pixels behind the ones of this, so only a strictly smaller/larger
+    // value replaces the extremum to report the first occurrence like the single-threaded scan
+    if ( other.m_Minimum < m_Minimum )
+    {
+      m_Minimum = other.m_Minimum;
+      m_MinimumIndex = other.m_MinimumIndex;
+    }
+    if ( other.m_Maximum > m_Maximum )
+    {
+      m_Maximum = other.m_Maximum;
+      m_MaximumIndex = other.m_MaximumIndex;
+    }
+
+    // pairwise combination of central moments (Pebay 2008, eq. 3.1 and 3.2)
+    const RealType na = static_cast< RealType >( m_Count );
+    const RealType nb = static_cast< RealType >( other.m_Count );
+    const RealType n = na + nb;
+    const RealType delta = other.m_Mean - m_Mean;
+    const RealType delta2 = delta * delta;
+    const RealType delta3 = delta2 * delta;
+    const RealType delta4 = delta2 * delta2;
+
+    const RealType m4 = m_M4 + other.m_M4
+      + delta4 * na * nb * ( na * na - na * nb + nb * nb ) / ( n * n * n )
+      + 6.0 * delta2 * ( na * na * other.m_M2 + nb * nb * m_M2 ) / ( n * n )
+      + 4.0 * delta * ( na * other.m_M3 - nb * m_M3 ) / n;
+    const RealType m3 = m_M3 + other.m_M3
+      + delta3 * na * nb * ( na - nb ) / ( n * n )
+      + 3.0 * delta * ( na * other.m_M2 - nb * m_M2 ) / n;
+    const RealType m2 = m_M2 + other.m_M2 + delta2 * na * nb / n;
+
+    m_M4 = m4;
+    m_M3 = m3;
+    m_M2 = m2;
+    m_Mean += delta * nb / n;
+    m_Count += other.m_Count;
+    m_PositiveSum += other.m_PositiveSum;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::MultiLabelStatisticsImageFilter()
+    : m_Pass( MOMENTS_PASS ),
+    m_UseHistograms( true ),
+    m_UseFixedHistogramRange( false ),
+    m_NumberOfBins( 100 ),
+    m_LowerBound( 0.0 ),
+    m_UpperBound( 0.0 ),
+    m_LabelOffset( 0 ),
+    m_Minimum( 0.0 ),
+    m_Maximum( 0.0 )
+  {
+    this->SetNumberOfRequiredInputs( 2 );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::SetLabelInput( const TLabelImage *input )
+  {
+    this->SetNthInput( 1, const_cast< TLabelImage * >( input ) );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  const TLabelImage *
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::GetLabelInput() const
+  {
+    return static_cast< const TLabelImage * >( this->ProcessObject::GetInput( 1 ) );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::SetHistogramParameters( unsigned int numberOfBins, RealType lowerBound, RealType upperBound )
+  {
+    m_NumberOfBins = numberOfBins > 0 ? numberOfBins : 1;
+    m_LowerBound = lowerBound;
+    m_UpperBound = upperBound;
+    m_UseFixedHistogramRange = true;
+    m_UseHistograms = true;
+    this->Modified();
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  const typename MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::LabelStatisticsContainer &
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::GetLabelStatistics() const
+  {
+    return m_LabelStatistics;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  std::vector< typename MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::LabelPixelType >
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::GetLabels() const
+  {
+    std::vector< LabelPixelType > labels;
+    labels.reserve( m_LabelStatistics.size() );
+    for ( typename LabelStatisticsContainer::const_iterator it = m_LabelStatistics.begin(); it != m_LabelStatistics.end(); ++it )
+    {
+      labels.push_back( it->m_Label );
+    }
+    return labels;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  bool
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::HasLabel( LabelPixelType label ) const
+  {
+    if ( static_cast< OffsetValueType >( label ) < m_LabelOffset )
+    {
+      return false;
+    }
+    const size_t slot = this->GetLabelSlot( label );
+    return slot < m_LabelSlots.size() && m_LabelSlots[slot] >= 0;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  const typename MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >::LabelStatistics &
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::GetStatistics( LabelPixelType label ) const
+  {
+    if ( !this->HasLabel( label ) )
+    {
+      itkExceptionMacro( << "Label " << static_cast< OffsetValueType >( label ) << " does not exist" );
+    }
+    return m_LabelStatistics[ m_LabelSlots[ this->GetLabelSlot( label ) ] ];
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::GenerateInputRequestedRegion()
+  {
+    Superclass::GenerateInputRequestedRegion();
+
+    TInputImage *input = const_cast< TInputImage * >( this->GetInput() );
+    if ( input )
+    {
+      input->SetRequestedRegionToLargestPossibleRegion();
+    }
+    TLabelImage *labelInput = const_cast< TLabelImage * >( this->GetLabelInput() );
+    if ( labelInput )
+    {
+      labelInput->SetRequestedRegionToLargestPossibleRegion();
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::EnlargeOutputRequestedRegion( DataObject *data )
+  {
+    Superclass::EnlargeOutputRequestedRegion( data );
+    data->SetRequestedRegionToLargestPossibleRegion();
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::AllocateOutputs()
+  {
+    // Pass the input through as the output
+    TInputImage *input = const_cast< TInputImage * >( this->GetInput() );
+    this->GraftOutput( input );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::GenerateData()
+  {
+    this->AllocateOutputs();
+
+    m_LabelStatistics.clear();
+    m_LabelSlots.clear();
+    m_LabelOffset = 0;
+    m_HistogramLayout = nullptr;
+    m_Minimum = 0.0;
+    m_Maximum = 0.0;
+
+    // only the part of the input covered by the label image carries labels
+    RegionType region = this->GetInput()->GetBufferedRegion();
+    if ( !region.Crop( this->GetLabelInput()->GetBufferedRegion() ) )
+    {
+      itkExceptionMacro( << "Label image does not overlap the input image (Image region: "
+        << this->GetInput()->GetBufferedRegion() << "; Label image region: " << this->GetLabelInput()->GetBufferedRegion() << ")" );
+    }
+
+    this->InitializeLabelOffset( region );
+
+    this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+    const ThreadIdType numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+
+    m_ThreadAccumulators.assign( numberOfThreads, AccumulatorContainer() );
+    this->ExecutePass( MOMENTS_PASS, region );
+    this->MergeMoments();
+
+    if ( m_UseHistograms && !m_LabelStatistics.empty() )
+    {
+      this->InitializeHistogramLayout();
+
+      // every thread holds dense histograms of all labels
+      const SizeValueType histogramsSize = m_LabelStatistics.size() * m_HistogramLayout->GetSize( 0 ) * sizeof( SizeValueType );
+      const SizeValueType affordableThreads = std::max< SizeValueType >( 1, static_cast< SizeValueType >( HistogramThreadMemoryBudget ) / histogramsSize );
+      const ThreadIdType histogramThreads = static_cast< ThreadIdType >( std::min< SizeValueType >( numberOfThreads, affordableThreads ) );
+      this->GetMultiThreader()->SetNumberOfThreads( histogramThreads );
+
+      m_ThreadFrequencies.assign( histogramThreads, FrequencyContainer() );
+      this->ExecutePass( HISTOGRAM_PASS, region );
+      this->MergeHistograms();
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::InitializeLabelOffset( const RegionType &region )
+  {
+    m_LabelOffset = 0;
+    if ( !NumericTraits< LabelPixelType >::is_signed )
+    {
+      return;
+    }
+
+    // negative labels would wrap around when used as index
+    ImageRegionConstIterator< TLabelImage > labelIt( this->GetLabelInput(), region );
+    for ( labelIt.GoToBegin(); !labelIt.IsAtEnd(); ++labelIt )
+    {
+      const OffsetValueType label = static_cast< OffsetValueType >( labelIt.Get() );
+      if ( label < m_LabelOffset )
+      {
+        m_LabelOffset = label;
+      }
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  bool
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::SplitRegion( const RegionType &region, ThreadIdType threadId, ThreadIdType numberOfThreads, RegionType &splitRegion ) const
+  {
+    typename RegionType::IndexType splitIndex = region.GetIndex();
+    typename RegionType::SizeType splitSize = region.GetSize();
+
+    // split along the outermost dimension that has more than one pixel
+    int splitAxis = ImageDimension - 1;
+    while ( splitAxis > 0 && splitSize[splitAxis] == 1 )
+    {
+      --splitAxis;
+    }
+
+    const SizeValueType range = splitSize[splitAxis];
+    if ( range == 0 )
+    {
+      return false;
+    }
+    const SizeValueType valuesPerThread = ( range + numberOfThreads - 1 ) / numberOfThreads;
+    const SizeValueType firstValue = threadId * valuesPerThread;
+    if ( firstValue >= range )
+    {
+      return false;
+    }
+
+    splitIndex[splitAxis] += firstValue;
+    splitSize[splitAxis] = std::min( valuesPerThread, range - firstValue );
+
+    splitRegion.SetIndex( splitIndex );
+    splitRegion.SetSize( splitSize );
+    return true;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::ExecutePass( Pass pass, const RegionType &region )
+  {
+    m_Pass = pass;
+
+    PassStruct str;
+    str.Filter = this;
+    str.Region = region;
+
+    this->GetMultiThreader()->SetSingleMethod( this->PassCallback, &str );
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  ITK_THREAD_RETURN_TYPE
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::PassCallback( void *arg )
+  {
+    MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+    PassStruct *str = static_cast< PassStruct * >( info->UserData );
+
+    RegionType splitRegion;
+    if ( str->Filter->SplitRegion( str->Region, info->ThreadID, info->NumberOfThreads, splitRegion ) )
+    {
+      if ( str->Filter->m_Pass == MOMENTS_PASS )
+      {
+        str->Filter->AccumulateMoments( splitRegion, info->ThreadID );
+      }
+      else
+      {
+        str->Filter->AccumulateHistograms( splitRegion, info->ThreadID );
+      }
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::AccumulateMoments( const RegionType &region, ThreadIdType threadId )
+  {
+    ImageRegionConstIterator< TInputImage > imageIt( this->GetInput(), region );
+    ImageRegionConstIterator< TLabelImage > labelIt( this->GetLabelInput(), region );
+
+    ProgressReporter progress( this, threadId, region.GetNumberOfPixels(), 100, 0.0f, m_UseHistograms ? 0.5f : 1.0f );
+
+    AccumulatorContainer &accumulators = m_ThreadAccumulators[threadId];
+
+    for ( imageIt.GoToBegin(), labelIt.GoToBegin(); !imageIt.IsAtEnd(); ++imageIt, ++labelIt )
+    {
+      const LabelPixelType label = labelIt.Get();
+      if ( label != 0 )
+      {
+        // labels are used as index, a vector lookup is much faster than a map for hundreds of labels
+        const size_t slot = this->GetLabelSlot( label );
+        if ( slot >= accumulators.size() )
+        {
+          accumulators.resize( slot + 1 );
+        }
+
+        Accumulator &accumulator = accumulators[slot];
+        const RealType value = static_cast< RealType >( imageIt.Get() );
+        if ( accumulator.m_Count == 0 || value < accumulator.m_Minimum )
+        {
+          accumulator.m_Minimum = value;
+          accumulator.m_MinimumIndex = imageIt.GetIndex();
+        }
+        if ( accumulator.m_Count == 0 || value > accumulator.m_Maximum )
+        {
+          accumulator.m_Maximum = value;
+          accumulator.m_MaximumIndex = imageIt.GetIndex();
+        }
+        accumulator.Add( value );
+      }
+      progress.CompletedPixel();
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::MergeMoments()
+  {
+    size_t numberOfSlots = 0;
+    for ( size_t thread = 0; thread < m_ThreadAccumulators.size(); ++thread )
+    {
+      numberOfSlots = std::max( numberOfSlots, m_ThreadAccumulators[thread].size() );
+    }
+
+    // threads are merged in the order of their regions
+    AccumulatorContainer merged( numberOfSlots );
+    for ( size_t thread = 0; thread < m_ThreadAccumulators.size(); ++thread )
+    {
+      const AccumulatorContainer &accumulators = m_ThreadAccumulators[thread];
+      for ( size_t slot = 0; slot < accumulators.size(); ++slot )
+      {
+        merged[slot].Merge( accumulators[slot] );
+      }
+    }
+    m_ThreadAccumulators.clear();
+
+    m_LabelSlots.assign( numberOfSlots, -1 );
+    bool first = true;
+    for ( size_t slot = 0; slot < numberOfSlots; ++slot )
+    {
+      // also skips the slot of label 0, which is never accumulated
+      const Accumulator &accumulator = merged[slot];
+      if ( accumulator.m_Count == 0 )
+      {
+        continue;
+      }
+
+      LabelStatistics statistics;
+      statistics.m_Label = static_cast< LabelPixelType >( static_cast< OffsetValueType >( slot ) + m_LabelOffset );
+      statistics.m_Count = accumulator.m_Count;
+      statistics.m_Minimum = accumulator.m_Minimum;
+      statistics.m_Maximum = accumulator.m_Maximum;
+      statistics.m_MinimumIndex = accumulator.m_MinimumIndex;
+      statistics.m_MaximumIndex = accumulator.m_MaximumIndex;
+      statistics.m_Mean = accumulator.m_Mean;
+
+      const RealType count = static_cast< RealType >( accumulator.m_Count );
+      statistics.m_Variance = accumulator.m_Count > 1 ? accumulator.m_M2 / ( count - 1.0 ) : 0.0;
+      statistics.m_Sigma = std::sqrt( statistics.m_Variance );
+      if ( statistics.m_Sigma >= mitk::eps )
+      {
+        const RealType sigma2 = statistics.m_Sigma * statistics.m_Sigma;
+        statistics.m_Skewness = accumulator.m_M3 / ( count * sigma2 * statistics.m_Sigma );
+        statistics.m_Kurtosis = accumulator.m_M4 / ( count * sigma2 * sigma2 );
+      }
+      statistics.m_MPP = accumulator.m_PositiveSum / count;
+
+      if ( first || accumulator.m_Minimum < m_Minimum )
+      {
+        m_Minimum = accumulator.m_Minimum;
+      }
+      if ( first || accumulator.m_Maximum > m_Maximum )
+      {
+        m_Maximum = accumulator.m_Maximum;
+      }
+      first = false;
+
+      m_LabelSlots[slot] = static_cast< int >( m_LabelStatistics.size() );
+      m_LabelStatistics.push_back( statistics );
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::InitializeHistogramLayout()
+  {
+    unsigned int numberOfBins = m_NumberOfBins;
+    RealType lowerBound = m_LowerBound;
+    RealType upperBound = m_UpperBound;
+
+    if ( !m_UseFixedHistogramRange )
+    {
+      lowerBound = std::floor( m_Minimum );
+      upperBound = std::ceil( m_Maximum );
+      // one bin per gray value, but wide ranges (e.g. float or 32 bit images) would need
+      // a huge histogram for every label
+      numberOfBins = static_cast< unsigned int >( std::min( m_Maximum - m_Minimum, static_cast< RealType >( MaximumNumberOfDefaultBins ) ) );
+      if ( m_Maximum - m_Minimum <= 10 )
+      {
+        numberOfBins = 100;
+      }
+    }
+
+    HistogramType::SizeType size( 1 );
+    size.Fill( numberOfBins );
+    HistogramType::MeasurementVectorType lower( 1 );
+    lower.Fill( lowerBound );
+    HistogramType::MeasurementVectorType upper( 1 );
+    upper.Fill( upperBound );
+
+    m_HistogramLayout = HistogramType::New();
+    m_HistogramLayout->SetMeasurementVectorSize( 1 );
+    m_HistogramLayout->Initialize( size, lower, upper );
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::AccumulateHistograms( const RegionType &region, ThreadIdType threadId )
+  {
+    ImageRegionConstIterator< TInputImage > imageIt( this->GetInput(), region );
+    ImageRegionConstIterator< TLabelImage > labelIt( this->GetLabelInput(), region );
+
+    ProgressReporter progress( this, threadId, region.GetNumberOfPixels(), 100, 0.5f, 0.5f );
+
+    const size_t numberOfBins = m_HistogramLayout->GetSize( 0 );
+    FrequencyContainer &frequencies = m_ThreadFrequencies[threadId];
+    frequencies.assign( m_LabelStatistics.size() * numberOfBins, 0 );
+
+    HistogramType::MeasurementVectorType measurement( 1 );
+    HistogramType::IndexType histogramIndex( 1 );
+
+    for ( imageIt.GoToBegin(), labelIt.GoToBegin(); !imageIt.IsAtEnd(); ++imageIt, ++labelIt )
+    {
+      const LabelPixelType label = labelIt.Get();
+      if ( label != 0 )
+      {
+        // GetIndex() is const and does not modify the layout, so all threads can share it
+        measurement[0] = static_cast< RealType >( imageIt.Get() );
+        if ( m_HistogramLayout->GetIndex( measurement, histogramIndex ) )
+        {
+          const size_t slot = static_cast< size_t >( m_LabelSlots[ this->GetLabelSlot( label ) ] );
+          ++frequencies[ slot * numberOfBins + histogramIndex[0] ];
+        }
+      }
+      progress.CompletedPixel();
+    }
+  }
+
+
+  template< class TInputImage, class TLabelImage >
+  void
+    MultiLabelStatisticsImageFilter< TInputImage, TLabelImage >
+    ::MergeHistograms()
+  {
+    const size_t numberOfBins = m_HistogramLayout->GetSize( 0 );
+    const double log2 = std::log( 2.0 );
+
+    HistogramType::MeasurementVectorType lowerBound( 1 );
+    lowerBound.Fill( m_HistogramLayout->GetBinMin( 0, 0 ) );
+    HistogramType::MeasurementVectorType upperBound( 1 );
+    upperBound.Fill( m_HistogramLayout->GetBinMax( 0, numberOfBins - 1 ) );
+
+    for ( size_t slot = 0; slot < m_LabelStatistics.size(); ++slot )
+    {
+      LabelStatistics &statistics = m_LabelStatistics[slot];
+
+      statistics.m_Histogram = HistogramType::New();
+      statistics.m_Histogram->SetMeasurementVectorSize( 1 );
+      statistics.m_Histogram->Initialize( m_HistogramLayout->GetSize(), lowerBound, upperBound );
+
+      for ( size_t bin = 0; bin < numberOfBins; ++bin )
+      {
+        SizeValueType frequency = 0;
+        for ( size_t thread = 0; thread < m_ThreadFrequencies.size(); ++thread )
+        {
+          if ( !m_ThreadFrequencies[thread].empty() )
+          {
+            frequency += m_ThreadFrequencies[thread][ slot * numberOfBins + bin ];
+          }
+        }
+        statistics.m_Histogram->SetFrequency( bin, frequency );
+      }
+
+      // median: center of the bin in which the cumulated frequency exceeds half of the pixels
+      // (same as itk::LabelStatisticsImageFilter)
+      SizeValueType total = 0;
+      size_t medianBin = 0;
+      while ( total <= statistics.m_Count / 2 && medianBin < numberOfBins )
+      {
+        total += static_cast< SizeValueType >( statistics.m_Histogram->GetFrequency( medianBin ) );
+        ++medianBin;
+      }
+      statistics.m_Median = statistics.m_Histogram->GetMeasurement( medianBin > 0 ? medianBin - 1 : 0, 0 );
+
+      const double totalFrequency = statistics.m_Histogram->GetTotalFrequency();
+      if ( totalFrequency > 0 )
+      {
+        for ( size_t bin = 0; bin < numberOfBins; ++bin )
+        {
+          const double probability = statistics.m_Histogram->GetFrequency( bin ) / totalFrequency;
+          if ( probability != 0 )
+          {
+            statistics.m_Entropy -= probability * std::log( probability ) / log2;
+            statistics.m_Uniformity += probability * probability;
+            if ( statistics.m_Histogram->GetMeasurement( bin, 0 ) > 0 )
+            {
+              statistics.m_UPP += probability * probability;
+            }
+          }
+        }
+      }
+    }
+
+    m_ThreadFrequencies.clear();
+  }
+
+} // end namespace itk
+
+#endif
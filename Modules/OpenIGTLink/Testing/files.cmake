@@ -15,4 +15,7 @@ set(MODULE_TESTS
 
    ################# RUNNING TESTS #######################################################
    #mitkNavigationDataToIGTLMessageFilterTest.cpp
+   mitkIGTLMessageQueueTest.cpp
+   mitkIGTLDeviceLoopbackTest.cpp
+   mitkIGTLServerBroadcastTest.cpp
 )
@@ -0,0 +1,146 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIGTLServer.h"
+#include "mitkIGTLClient.h"
+#include "mitkTestingMacros.h"
+
+#include <igtlTrackingDataMessage.h>
+#include <itksys/SystemTools.hxx>
+
+#include <functional>
+
+static const int PORT_NUMBER = 47119;
+
+/** Polls the condition every ms, returns false if it is not fulfilled within 5 seconds. */
+static bool WaitFor(std::function<bool()> condition)
+{
+  for (int i = 0; i < 5000; ++i)
+  {
+    if (condition())
+      return true;
+    itksys::SystemTools::Delay(1);
+  }
+  return condition();
+}
+
+static igtl::MessageBase::Pointer CreateTrackingDataMessage(unsigned int index)
+{
+  igtl::TrackingDataElement::Pointer element = igtl::TrackingDataElement::New();
+  element->SetName("Tool");
+  element->SetPosition(static_cast<float>(index), 0.0f, 0.0f);
+  igtl::TrackingDataMessage::Pointer message = igtl::TrackingDataMessage::New();
+  message->AddTrackingDataElement(element);
+  return message.GetPointer();
+}
+
+static int GetIndex(igtl::MessageBase::Pointer message)
+{
+  igtl::TrackingDataMessage* tdMsg = dynamic_cast<igtl::TrackingDataMessage*>(message.GetPointer());
+  if (tdMsg == nullptr)
+    return -1;
+  igtl::TrackingDataElement::Pointer element;
+  tdMsg->GetTrackingDataElement(0, element);
+  float x, y, z;
+  element->GetPosition(&x, &y, &z);
+  return static_cast<int>(x);
+}
+
+static void TestStreaming(mitk::IGTLServer* server, mitk::IGTLClient* client)
+{
+  const unsigned int numberOfMessages = 200;
+  server->ResetStatistics();
+
+  unsigned int numberOfConsumed = 0;
+  bool inOrder = true;
+  auto consume = [&]()
+  {
+    // the message is released at the end of each iteration, so that the pool can reuse it
+    igtl::MessageBase::Pointer message = server->GetNextMessage();
+    while (message.IsNotNull())
+    {
+      inOrder = inOrder && GetIndex(message) == static_cast<int>(numberOfConsumed);
+      ++numberOfConsumed;
+      message = server->GetNextMessage();
+    }
+    return numberOfConsumed == numberOfMessages;
+  };
+
+  for (unsigned int i = 0; i < numberOfMessages; ++i)
+  {
+    client->SendMessage(CreateTrackingDataMessage(i));
+    consume();
+  }
+  MITK_TEST_CONDITION(WaitFor(consume), "Testing that all messages are received");
+  MITK_TEST_CONDITION(inOrder, "Testing that the messages are received in order");
+
+  mitk::IGTLDevice::Statistics statistics = server->GetStatistics();
+  MITK_TEST_CONDITION(statistics.m_NumberOfReceivedMessages == numberOfMessages, "Testing number of received messages");
+  MITK_TEST_CONDITION(statistics.m_NumberOfReceivedBytes > 0 && statistics.m_NumberOfReceivedBytes % numberOfMessages == 0,
+    "Testing number of received bytes");
+  MITK_TEST_CONDITION(statistics.m_MessagesPerSecond > 0 && statistics.m_BytesPerSecond > statistics.m_MessagesPerSecond, "Testing rates");
+  MITK_TEST_CONDITION(statistics.m_NumberOfDroppedMessages == 0 && statistics.m_ReceiveQueueSize == 0, "Testing that no message is dropped");
+  MITK_TEST_CONDITION(statistics.m_MaximumLatency >= statistics.m_MeanLatency && statistics.m_MeanLatency >= 0, "Testing latencies");
+  MITK_TEST_CONDITION(statistics.m_NumberOfReusedMessages > 0, "Testing that the message pool reuses messages");
+  MITK_TEST_CONDITION(server->GetMessagePool()->GetNumberOfCreatedMessages() <= server->GetMessagePool()->GetMaximumNumberOfMessagesPerType(),
+    "Testing that only the pooled messages are created");
+  MITK_TEST_OUTPUT(<< "Received " << statistics.m_MessagesPerSecond << " messages/s, " << statistics.m_BytesPerSecond
+    << " bytes/s, mean latency " << statistics.m_MeanLatency << " ms, " << statistics.m_NumberOfReusedMessages << " reused messages");
+}
+
+static void TestNoBuffering(mitk::IGTLServer* server, mitk::IGTLClient* client)
+{
+  const unsigned int numberOfMessages = 50;
+  server->EnableInfiniteBufferingMode(server->GetReceiveQueue(), false);
+  server->ResetStatistics();
+
+  for (unsigned int i = 0; i < numberOfMessages; ++i)
+    client->SendMessage(CreateTrackingDataMessage(i));
+
+  MITK_TEST_CONDITION(WaitFor([&]() { return server->GetStatistics().m_NumberOfDroppedMessages == numberOfMessages - 1; }),
+    "Testing that older messages are dropped without buffering");
+  MITK_TEST_CONDITION(server->GetStatistics().m_ReceiveQueueSize == 1, "Testing that only the latest message is queued");
+  MITK_TEST_CONDITION(GetIndex(server->GetNextMessage()) == static_cast<int>(numberOfMessages) - 1, "Testing that the latest message is kept");
+
+  server->EnableInfiniteBufferingMode(server->GetReceiveQueue(), true);
+}
+
+/**Documentation
+ *  test for the message pool, the message queue and the statistics of "IGTLDevice" with a
+ *  client that sends tracking data to a server on the local host.
+ */
+int mitkIGTLDeviceLoopbackTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("IGTLDeviceLoopback");
+
+  mitk::IGTLServer::Pointer server = mitk::IGTLServer::New(true);
+  server->SetPortNumber(PORT_NUMBER);
+  MITK_TEST_CONDITION_REQUIRED(server->OpenConnection() && server->StartCommunication(), "Testing start of the server");
+
+  mitk::IGTLClient::Pointer client = mitk::IGTLClient::New(true);
+  client->SetHostname("127.0.0.1");
+  client->SetPortNumber(PORT_NUMBER);
+  MITK_TEST_CONDITION_REQUIRED(client->OpenConnection() && client->StartCommunication(), "Testing start of the client");
+  MITK_TEST_CONDITION_REQUIRED(WaitFor([&]() { return server->GetNumberOfConnections() == 1; }), "Testing connection of the client");
+
+  TestStreaming(server, client);
+  TestNoBuffering(server, client);
+
+  client->CloseConnection();
+  server->CloseConnection();
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,137 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIGTLMessageQueue.h"
+#include "mitkTestingMacros.h"
+
+#include <igtlStatusMessage.h>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static igtl::MessageBase::Pointer CreateMessage(int code)
+{
+  igtl::StatusMessage::Pointer message = igtl::StatusMessage::New();
+  message->SetCode(code);
+  std::stringstream name;
+  name << "Message" << code;
+  message->SetDeviceName(name.str().c_str());
+  return message.GetPointer();
+}
+
+static int GetCode(igtl::MessageBase::Pointer message)
+{
+  return dynamic_cast<igtl::StatusMessage*>(message.GetPointer())->GetCode();
+}
+
+static void TestSingleThreaded()
+{
+  mitk::IGTLMessageQueue::Pointer queue = mitk::IGTLMessageQueue::New(4);
+  MITK_TEST_CONDITION(queue->GetCapacity() == 4, "Testing capacity");
+  MITK_TEST_CONDITION(queue->PullMessage().IsNull(), "Testing PullMessage() of empty queue");
+  MITK_TEST_CONDITION(queue->GetLatestMsgInformationString() == "No Msg", "Testing information of empty queue");
+
+  for (int i = 0; i < 3; ++i)
+    queue->PushMessage(CreateMessage(i));
+  MITK_TEST_CONDITION(queue->GetSize() == 3, "Testing GetSize()");
+  MITK_TEST_CONDITION(queue->GetNextMsgDeviceType() == "STATUS", "Testing GetNextMsgDeviceType()");
+  MITK_TEST_CONDITION(queue->GetNextMsgInformationString().find("Message0") != std::string::npos, "Testing GetNextMsgInformationString()");
+  MITK_TEST_CONDITION(queue->GetLatestMsgInformationString().find("Message2") != std::string::npos, "Testing GetLatestMsgInformationString()");
+
+  MITK_TEST_CONDITION(GetCode(queue->PullMessage()) == 0 && GetCode(queue->PullMessage()) == 1, "Testing order of pulled messages");
+  MITK_TEST_CONDITION(queue->GetSize() == 1 && queue->GetNumberOfPulledMessages() == 2, "Testing number of pulled messages");
+  MITK_TEST_CONDITION(queue->GetMaximumLatency() >= queue->GetMeanLatency() && queue->GetMeanLatency() >= 0, "Testing latencies");
+
+  // overflow: 6 new messages in a queue of 4 that still holds one message
+  for (int i = 3; i < 9; ++i)
+    queue->PushMessage(CreateMessage(i));
+  MITK_TEST_CONDITION(queue->GetSize() == 4 && queue->GetNumberOfDroppedMessages() == 3, "Testing dropped messages on overflow");
+  MITK_TEST_CONDITION(GetCode(queue->PullMessage()) == 5, "Testing oldest messages are dropped");
+
+  queue->EnableInfiniteBuffering(false);
+  queue->PushMessage(CreateMessage(9));
+  MITK_TEST_CONDITION(queue->GetSize() == 1 && GetCode(queue->PullMessage()) == 9, "Testing queue without buffering keeps the latest message");
+
+  queue->ResetStatistics();
+  MITK_TEST_CONDITION(queue->GetNumberOfDroppedMessages() == 0 && queue->GetNumberOfPulledMessages() == 0, "Testing ResetStatistics()");
+}
+
+static void TestConcurrentProducersAndConsumers()
+{
+  mitk::IGTLMessageQueue::Pointer queue = mitk::IGTLMessageQueue::New(64);
+  const int numberOfMessages = 20000;
+  std::vector<std::atomic<int>> received(2 * numberOfMessages);
+  for (std::size_t i = 0; i < received.size(); ++i)
+    received[i] = 0;
+  std::atomic<int> finishedProducers(0);
+
+  auto producer = [&](int offset)
+  {
+    for (int i = 0; i < numberOfMessages; ++i)
+      queue->PushMessage(CreateMessage(offset + i));
+    ++finishedProducers;
+  };
+
+  auto consumer = [&]()
+  {
+    while (true)
+    {
+      igtl::MessageBase::Pointer message = queue->PullMessage();
+      if (message.IsNotNull())
+        ++received[GetCode(message)];
+      else if (finishedProducers == 2)
+        break;
+    }
+  };
+
+  std::thread consumer1(consumer);
+  std::thread consumer2(consumer);
+  std::thread producer1(producer, 0);
+  std::thread producer2(producer, numberOfMessages);
+  producer1.join();
+  producer2.join();
+  consumer1.join();
+  consumer2.join();
+
+  unsigned long long numberOfReceived = 0;
+  bool receivedTwice = false;
+  for (std::size_t i = 0; i < received.size(); ++i)
+  {
+    numberOfReceived += received[i];
+    receivedTwice = receivedTwice || received[i] > 1;
+  }
+
+  MITK_TEST_CONDITION(!receivedTwice, "Testing that no message is pulled twice");
+  MITK_TEST_CONDITION(numberOfReceived == queue->GetNumberOfPulledMessages(), "Testing number of pulled messages");
+  MITK_TEST_CONDITION(numberOfReceived + queue->GetNumberOfDroppedMessages() == 2 * numberOfMessages, "Testing that every message is either pulled or dropped");
+  MITK_TEST_CONDITION(queue->GetSize() == 0, "Testing that the queue is empty");
+  MITK_TEST_OUTPUT(<< "Pulled " << numberOfReceived << " of " << 2 * numberOfMessages << " messages, the others were dropped");
+}
+
+/**Documentation
+ *  test for the class "IGTLMessageQueue".
+ */
+int mitkIGTLMessageQueueTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("IGTLMessageQueue");
+
+  TestSingleThreaded();
+  TestConcurrentProducersAndConsumers();
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,202 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIGTLServer.h"
+#include "mitkIGTLClient.h"
+#include "mitkTestingMacros.h"
+
+#include <igtlClientSocket.h>
+#include <igtlImageMessage.h>
+#include <igtlTrackingDataMessage.h>
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+#include <functional>
+#include <vector>
+
+static const int PORT_NUMBER = 47129;
+
+/** Polls the condition every ms, returns false if it is not fulfilled within 10 seconds. */
+static bool WaitFor(std::function<bool()> condition)
+{
+  for (int i = 0; i < 10000; ++i)
+  {
+    if (condition())
+      return true;
+    itksys::SystemTools::Delay(1);
+  }
+  return condition();
+}
+
+static igtl::MessageBase::Pointer CreateTrackingDataMessage(unsigned int index)
+{
+  igtl::TrackingDataElement::Pointer element = igtl::TrackingDataElement::New();
+  element->SetName("Tool");
+  element->SetPosition(static_cast<float>(index), 0.0f, 0.0f);
+  igtl::TrackingDataMessage::Pointer message = igtl::TrackingDataMessage::New();
+  message->AddTrackingDataElement(element);
+  return message.GetPointer();
+}
+
+static igtl::MessageBase::Pointer CreateImageMessage()
+{
+  igtl::ImageMessage::Pointer message = igtl::ImageMessage::New();
+  message->SetDimensions(256, 256, 16);
+  message->SetScalarType(igtl::ImageMessage::TYPE_UINT8);
+  message->AllocateScalars();
+  std::memset(message->GetScalarPointer(), 0, message->GetImageSize());
+  return message.GetPointer();
+}
+
+/** Returns the index of a tracking data message or -1 for other messages. */
+static int GetIndex(igtl::MessageBase::Pointer message)
+{
+  igtl::TrackingDataMessage* tdMsg = dynamic_cast<igtl::TrackingDataMessage*>(message.GetPointer());
+  if (tdMsg == nullptr)
+    return -1;
+  igtl::TrackingDataElement::Pointer element;
+  tdMsg->GetTrackingDataElement(0, element);
+  float x, y, z;
+  element->GetPosition(&x, &y, &z);
+  return static_cast<int>(x);
+}
+
+static mitk::IGTLServer::Pointer StartServer(int portNumber, unsigned int maximumNumberOfPendingMessages)
+{
+  mitk::IGTLServer::Pointer server = mitk::IGTLServer::New(true);
+  server->SetPortNumber(portNumber);
+  server->BroadcastingOn();
+  server->SetMaximumNumberOfPendingMessages(maximumNumberOfPendingMessages);
+  server->SetClientTimeout(200);
+  MITK_TEST_CONDITION_REQUIRED(server->OpenConnection() && server->StartCommunication(), "Testing start of the server");
+  return server;
+}
+
+static std::vector<mitk::IGTLClient::Pointer> StartClients(int portNumber, unsigned int numberOfClients)
+{
+  std::vector<mitk::IGTLClient::Pointer> clients;
+  for (unsigned int i = 0; i < numberOfClients; ++i)
+  {
+    mitk::IGTLClient::Pointer client = mitk::IGTLClient::New(true);
+    client->SetHostname("127.0.0.1");
+    client->SetPortNumber(portNumber);
+    MITK_TEST_CONDITION_REQUIRED(client->OpenConnection() && client->StartCommunication(), "Testing start of client " << i);
+    clients.push_back(client);
+  }
+  return clients;
+}
+
+/** Streams tracking data to several clients and reports the latencies of each client. */
+static void TestLatencies()
+{
+  const unsigned int numberOfClients = 4;
+  const unsigned int numberOfMessages = 500;
+
+  // no message is dropped if each client can buffer all messages
+  mitk::IGTLServer::Pointer server = StartServer(PORT_NUMBER, numberOfMessages);
+  std::vector<mitk::IGTLClient::Pointer> clients = StartClients(PORT_NUMBER, numberOfClients);
+  MITK_TEST_CONDITION_REQUIRED(WaitFor([&]() { return server->GetNumberOfConnections() == numberOfClients; }), "Testing connection of the clients");
+
+  for (unsigned int i = 0; i < numberOfMessages; ++i)
+  {
+    server->SendMessage(CreateTrackingDataMessage(i));
+    itksys::SystemTools::Delay(1);
+  }
+
+  for (unsigned int i = 0; i < numberOfClients; ++i)
+  {
+    MITK_TEST_CONDITION(WaitFor([&]() { return clients[i]->GetStatistics().m_NumberOfReceivedMessages == numberOfMessages; }),
+      "Testing that client " << i << " receives all messages");
+  }
+
+  mitk::IGTLServer::ClientStatisticsContainer statistics = server->GetClientStatistics();
+  MITK_TEST_CONDITION_REQUIRED(statistics.size() == numberOfClients, "Testing number of client statistics");
+  for (unsigned int i = 0; i < numberOfClients; ++i)
+  {
+    MITK_TEST_CONDITION(statistics[i].m_NumberOfSentMessages == numberOfMessages && statistics[i].m_NumberOfDroppedMessages == 0,
+      "Testing number of messages sent to client " << i);
+    MITK_TEST_CONDITION(statistics[i].m_MedianLatency <= statistics[i].m_Percentile95Latency
+      && statistics[i].m_Percentile95Latency <= statistics[i].m_Percentile99Latency
+      && statistics[i].m_Percentile99Latency <= statistics[i].m_MaximumLatency, "Testing order of the percentiles of client " << i);
+    MITK_TEST_OUTPUT(<< "Client " << i << ": median " << statistics[i].m_MedianLatency << " ms, 95% "
+      << statistics[i].m_Percentile95Latency << " ms, 99% " << statistics[i].m_Percentile99Latency << " ms, max "
+      << statistics[i].m_MaximumLatency << " ms");
+  }
+
+  for (unsigned int i = 0; i < numberOfClients; ++i)
+    clients[i]->CloseConnection();
+  server->CloseConnection();
+}
+
+/** A client that stops reading must neither stall the other clients nor the server. */
+static void TestSlowClient()
+{
+  const unsigned int numberOfClients = 2;
+  const unsigned int numberOfImages = 40;
+  const int lastIndex = 12345;
+
+  mitk::IGTLServer::Pointer server = StartServer(PORT_NUMBER + 1, 1);
+  std::vector<mitk::IGTLClient::Pointer> clients = StartClients(PORT_NUMBER + 1, numberOfClients);
+
+  // connects but never reads
+  igtl::ClientSocket::Pointer stalledClient = igtl::ClientSocket::New();
+  MITK_TEST_CONDITION_REQUIRED(stalledClient->ConnectToServer("127.0.0.1", PORT_NUMBER + 1) == 0, "Testing connection of the stalled client");
+  MITK_TEST_CONDITION_REQUIRED(WaitFor([&]() { return server->GetNumberOfConnections() == numberOfClients + 1; }), "Testing connection of the clients");
+
+  // much more data than the socket buffers of the stalled client can take
+  for (unsigned int i = 0; i < numberOfImages; ++i)
+    server->SendMessage(CreateImageMessage());
+  server->SendMessage(CreateTrackingDataMessage(lastIndex));
+
+  for (unsigned int i = 0; i < numberOfClients; ++i)
+  {
+    bool received = WaitFor([&]()
+    {
+      for (igtl::MessageBase::Pointer message = clients[i]->GetNextMessage(); message.IsNotNull(); message = clients[i]->GetNextMessage())
+      {
+        if (GetIndex(message) == lastIndex)
+          return true;
+      }
+      return false;
+    });
+    MITK_TEST_CONDITION(received, "Testing that client " << i << " gets the latest message");
+  }
+
+  // the stalled client is removed with the next message after its timeout
+  MITK_TEST_CONDITION(WaitFor([&]()
+  {
+    server->SendMessage(CreateTrackingDataMessage(lastIndex));
+    return server->GetNumberOfConnections() == numberOfClients;
+  }), "Testing that the stalled client is disconnected");
+
+  stalledClient->CloseSocket();
+  for (unsigned int i = 0; i < numberOfClients; ++i)
+    clients[i]->CloseConnection();
+  server->CloseConnection();
+}
+
+/**Documentation
+ *  test and loopback benchmark for the broadcast mode of "IGTLServer".
+ */
+int mitkIGTLServerBroadcastTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("IGTLServerBroadcast");
+
+  TestLatencies();
+  TestSlowClient();
+
+  MITK_TEST_END();
+}
@@ -35,6 +35,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 static const int SOCKET_SEND_RECEIVE_TIMEOUT_MSEC = 100;
 typedef itk::MutexLockHolder<itk::FastMutexLock> MutexLockHolder;
 
+static long long Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 mitk::IGTLDevice::IGTLDevice(bool ReadFully) :
 //  m_Data(mitk::DeviceDataUnspecified),
   m_State(mitk::IGTLDevice::Setup),
@@ -42,6 +48,9 @@ mitk::IGTLDevice::IGTLDevice(bool ReadFully) :
   m_StopCommunication(false),
   m_Hostname("127.0.0.1"),
   m_PortNumber(-1),
+  m_NumberOfReceivedMessages(0),
+  m_NumberOfReceivedBytes(0),
+  m_StatisticsStartTime(0),
   m_MultiThreader(nullptr), m_SendThreadID(0), m_ReceiveThreadID(0), m_ConnectThreadID(0)
 {
   m_ReadFully = ReadFully;
@@ -63,6 +72,8 @@ mitk::IGTLDevice::IGTLDevice(bool ReadFully) :
   m_SendQueue      = mitk::IGTLMessageQueue::New();
   m_ReceiveQueue   = mitk::IGTLMessageQueue::New();
   m_CommandQueue   = mitk::IGTLMessageQueue::New();
+  m_MessagePool    = mitk::IGTLMessagePool::New(m_MessageFactory);
+  m_ReceiveHeader  = igtl::MessageHeader::New();
 
   //setup measurements
   this->m_Measurement = mitk::IGTLMeasurements::GetInstance();
@@ -129,9 +140,8 @@ bool mitk::IGTLDevice::TestConnection()
 
 unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
 {
-  // Create a message buffer to receive header
-  igtl::MessageHeader::Pointer headerMsg;
-  headerMsg = igtl::MessageHeader::New();
+  // The header buffer is reused for all messages
+  igtl::MessageHeader::Pointer headerMsg = m_ReceiveHeader;
 
   // Initialize receive buffer
   headerMsg->InitPack();
@@ -189,14 +199,19 @@ unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
            std::strstr( curDevType, "STP_" ) != nullptr ||
            std::strstr( curDevType, "RTS_" ) != nullptr)
       {
+        // the queued header must not be overwritten by the next message
+        m_ReceiveHeader = igtl::MessageHeader::New();
+        ++m_NumberOfReceivedMessages;
+        m_NumberOfReceivedBytes += headerMsg->GetPackSize();
         this->m_CommandQueue->PushMessage(headerMsg);
         this->InvokeEvent(CommandReceivedEvent());
         return IGTL_STATUS_OK;
       }
 
-      //Create a message according to the header message
+      //Get a message according to the header message from the pool, its
+      //pack is already allocated
       igtl::MessageBase::Pointer curMessage;
-      curMessage = m_MessageFactory->CreateInstance(headerMsg);
+      curMessage = m_MessagePool->GetMessage(headerMsg);
 
       //check if the curMessage is created properly, if not the message type is
       //not supported and the message has to be skipped
@@ -208,10 +223,6 @@ unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
         return IGTL_STATUS_NOT_FOUND;
       }
 
-      //insert the header to the message and allocate the pack
-      curMessage->SetMessageHeader(headerMsg);
-      curMessage->AllocatePack();
-
       // Receive transform data from the socket
       int receiveCheck = 0;
       receiveCheck = socket->Receive(curMessage->GetPackBodyPointer(),
@@ -229,6 +240,9 @@ unsigned int mitk::IGTLDevice::ReceivePrivate(igtl::Socket* socket)
           return IGTL_STATUS_CHECKSUM_ERROR;
         }
 
+        ++m_NumberOfReceivedMessages;
+        m_NumberOfReceivedBytes += curMessage->GetPackSize();
+
         //save timestamp 6 now because we know the index
         AddTrackingMeasurements(6, curMessage, timeStamp6);
         //check the type of the received message
@@ -373,6 +387,8 @@ bool mitk::IGTLDevice::StartCommunication()
   // go to mode Running
   this->SetState(Running);
 
+  this->ResetStatistics();
+
   // set a timeout for the sending and receiving
   this->m_Socket->SetTimeout(SOCKET_SEND_RECEIVE_TIMEOUT_MSEC);
 
@@ -491,6 +507,32 @@ igtl::MessageBase::Pointer mitk::IGTLDevice::GetNextCommand()
   return msg;
 }
 
+mitk::IGTLDevice::Statistics mitk::IGTLDevice::GetStatistics() const
+{
+  Statistics statistics;
+  statistics.m_NumberOfReceivedMessages = m_NumberOfReceivedMessages.load();
+  statistics.m_NumberOfReceivedBytes = m_NumberOfReceivedBytes.load();
+
+  double seconds = (Now() - m_StatisticsStartTime.load()) / 1.0e9;
+  statistics.m_MessagesPerSecond = seconds > 0 ? statistics.m_NumberOfReceivedMessages / seconds : 0.0;
+  statistics.m_BytesPerSecond = seconds > 0 ? statistics.m_NumberOfReceivedBytes / seconds : 0.0;
+
+  statistics.m_ReceiveQueueSize = static_cast<unsigned int>(m_ReceiveQueue->GetSize());
+  statistics.m_NumberOfDroppedMessages = m_ReceiveQueue->GetNumberOfDroppedMessages();
+  statistics.m_MeanLatency = m_ReceiveQueue->GetMeanLatency();
+  statistics.m_MaximumLatency = m_ReceiveQueue->GetMaximumLatency();
+  statistics.m_NumberOfReusedMessages = m_MessagePool->GetNumberOfReusedMessages();
+  return statistics;
+}
+
+void mitk::IGTLDevice::ResetStatistics()
+{
+  m_NumberOfReceivedMessages = 0;
+  m_NumberOfReceivedBytes = 0;
+  m_StatisticsStartTime = Now();
+  m_ReceiveQueue->ResetStatistics();
+}
+
 void mitk::IGTLDevice::EnableInfiniteBufferingMode(
                                           mitk::IGTLMessageQueue::Pointer queue,
                                           bool enable)
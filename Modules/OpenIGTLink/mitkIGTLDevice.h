@@ -34,9 +34,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "MitkOpenIGTLinkExports.h"
 #include "mitkIGTLMessageFactory.h"
 #include "mitkIGTLMessageQueue.h"
+#include "mitkIGTLMessagePool.h"
 #include "mitkIGTLMessage.h"
 #include "mitkIGTLMeasurements.h"
 
+#include <atomic>
+
 
 namespace mitk {
     /**
@@ -75,6 +78,25 @@ namespace mitk {
       */
       enum IGTLDeviceState {Setup, Ready, Running};
 
+      /**
+       * \brief Throughput and latency of the received messages
+       *
+       * Rates are averaged since the last call of ResetStatistics(), which
+       * is done by StartCommunication().
+       */
+      struct Statistics
+      {
+        double m_MessagesPerSecond;                 ///< received messages and commands per second
+        double m_BytesPerSecond;                    ///< received bytes (header and body) per second
+        unsigned long long m_NumberOfReceivedMessages;
+        unsigned long long m_NumberOfReceivedBytes;
+        unsigned int m_ReceiveQueueSize;            ///< number of messages waiting to be consumed
+        unsigned long long m_NumberOfDroppedMessages; ///< messages removed from the receive queue before they were consumed
+        double m_MeanLatency;                       ///< mean time in ms between receiving and consuming a message
+        double m_MaximumLatency;                    ///< maximum time in ms between receiving and consuming a message
+        unsigned long long m_NumberOfReusedMessages; ///< messages taken from the message pool instead of being created
+      };
+
       /**
        * \brief Opens a connection to the device
        *
@@ -207,6 +229,23 @@ namespace mitk {
        */
       itkGetMacro(MessageFactory, mitk::IGTLMessageFactory::Pointer);
 
+      /**
+       * \brief Returns the pool that provides the messages for the receive thread
+       */
+      itkGetMacro(MessagePool, mitk::IGTLMessagePool::Pointer);
+
+      /**
+       * \brief Returns the throughput and latency of the received messages
+       *
+       * May be called from any thread while the device is communicating.
+       */
+      Statistics GetStatistics() const;
+
+      /**
+       * \brief Restarts the measurement of the statistics
+       */
+      void ResetStatistics();
+
       /**
       * \brief static start method for the sending thread.
       * \param data a void pointer to the IGTLDevice object.
@@ -367,9 +406,22 @@ namespace mitk {
       /** A message factory that provides the New() method for all msg types */
       mitk::IGTLMessageFactory::Pointer m_MessageFactory;
 
+      /** Reusable messages for the receive thread */
+      mitk::IGTLMessagePool::Pointer m_MessagePool;
+
+      /** Header buffer of the receive thread, replaced only if it is queued as a command */
+      igtl::MessageHeader::Pointer m_ReceiveHeader;
+
       /** Measurement class to calculate latency and frame count */
       mitk::IGTLMeasurements* m_Measurement;
 
+      /** number of messages and commands received since the last ResetStatistics() */
+      std::atomic<unsigned long long> m_NumberOfReceivedMessages;
+      /** number of bytes received since the last ResetStatistics() */
+      std::atomic<unsigned long long> m_NumberOfReceivedBytes;
+      /** time of the last ResetStatistics() in ns of std::chrono::steady_clock */
+      std::atomic<long long> m_StatisticsStartTime;
+
     private:
 
       /** creates worker thread that continuously polls interface for new
@@ -0,0 +1,105 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkIGTLMessagePool.h"
+
+mitk::IGTLMessagePool::IGTLMessagePool(mitk::IGTLMessageFactory* factory)
+  : m_MessageFactory(factory),
+    m_MaximumNumberOfMessagesPerType(64),
+    m_NumberOfCreatedMessages(0),
+    m_NumberOfReusedMessages(0)
+{
+}
+
+mitk::IGTLMessagePool::~IGTLMessagePool()
+{
+}
+
+igtl::MessageBase::Pointer mitk::IGTLMessagePool::GetFreeMessage(MessageList& list)
+{
+  const std::size_t size = list.m_Messages.size();
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    std::size_t index = (list.m_Next + i) % size;
+    // only the receive thread hands out messages of the pool, so nobody else
+    // can increase the reference count of a message that only the pool holds
+    if (list.m_Messages[index]->GetReferenceCount() == 1)
+    {
+      list.m_Next = index + 1;
+      return list.m_Messages[index];
+    }
+  }
+  return nullptr;
+}
+
+igtl::MessageBase::Pointer mitk::IGTLMessagePool::GetMessage(igtl::MessageHeader* header)
+{
+  if (header == nullptr)
+    return nullptr;
+
+  MessageList& list = m_Messages[header->GetDeviceType()];
+  igtl::MessageBase::Pointer message = this->GetFreeMessage(list);
+
+  if (message.IsNotNull())
+  {
+    ++m_NumberOfReusedMessages;
+  }
+  else
+  {
+    message = m_MessageFactory->CreateInstance(igtl::MessageHeader::Pointer(header));
+    if (message.IsNull())
+      return nullptr;
+    ++m_NumberOfCreatedMessages;
+    if (list.m_Messages.size() < m_MaximumNumberOfMessagesPerType)
+      list.m_Messages.push_back(message);
+  }
+
+  //insert the header to the message and allocate the pack
+  message->SetMessageHeader(header);
+  message->AllocatePack();
+  return message;
+}
+
+void mitk::IGTLMessagePool::Preallocate(const std::string& messageType, unsigned int numberOfMessages)
+{
+  MessageList& list = m_Messages[messageType];
+  while (list.m_Messages.size() < numberOfMessages && list.m_Messages.size() < m_MaximumNumberOfMessagesPerType)
+  {
+    igtl::MessageBase::Pointer message = m_MessageFactory->CreateInstance(messageType);
+    if (message.IsNull())
+    {
+      MITK_WARN("IGTLMessagePool") << "Cannot preallocate messages of the unknown type " << messageType;
+      return;
+    }
+    ++m_NumberOfCreatedMessages;
+    list.m_Messages.push_back(message);
+  }
+}
+
+void mitk::IGTLMessagePool::Clear()
+{
+  m_Messages.clear();
+}
+
+unsigned long long mitk::IGTLMessagePool::GetNumberOfCreatedMessages() const
+{
+  return m_NumberOfCreatedMessages.load();
+}
+
+unsigned long long mitk::IGTLMessagePool::GetNumberOfReusedMessages() const
+{
+  return m_NumberOfReusedMessages.load();
+}
@@ -0,0 +1,115 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKIGTLMESSAGEPOOL_H_HEADER_INCLUDED_
+#define MITKIGTLMESSAGEPOOL_H_HEADER_INCLUDED_
+
+#include "MitkOpenIGTLinkExports.h"
+#include "mitkCommon.h"
+#include "mitkIGTLMessageFactory.h"
+
+#include "itkObject.h"
+
+#include "igtlMessageBase.h"
+#include "igtlMessageHeader.h"
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+namespace mitk {
+  /**
+  * \brief Pool of reusable OpenIGTLink messages, one per message type
+  *
+  * The receive thread of a mitk::IGTLDevice gets the message for each incoming
+  * body from this pool instead of creating a new one. A message of the pool is
+  * handed out again as soon as the pool holds the only reference to it, i.e.
+  * when the consumer that pulled it from the receive queue released it. As a
+  * reused message keeps its pack buffer, no memory is allocated as long as the
+  * body size of the messages of one type does not change. The pool relies on
+  * Unpack() replacing the whole content of a message, as the OpenIGTLink
+  * message types do.
+  *
+  * If all messages of a type are in use and the pool already holds
+  * GetMaximumNumberOfMessagesPerType() of them, a message that is not pooled
+  * is created.
+  *
+  * \note GetMessage(), Preallocate() and Clear() may only be called by one
+  * thread (the receive thread, or any thread while the device is not
+  * communicating). The statistics may be read from any thread.
+  *
+  * \ingroup OpenIGTLink
+  */
+  class MITKOPENIGTLINK_EXPORT IGTLMessagePool : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(IGTLMessagePool, itk::Object)
+    mitkNewMacro1Param(Self, mitk::IGTLMessageFactory*)
+
+    /**
+    * \brief Returns a message for the given header that is ready to receive
+    * the body, or NULL if the type is not supported by the message factory
+    */
+    igtl::MessageBase::Pointer GetMessage(igtl::MessageHeader* header);
+
+    /**
+    * \brief Creates the given number of messages of the given type in advance
+    */
+    void Preallocate(const std::string& messageType, unsigned int numberOfMessages);
+
+    /**
+    * \brief Removes all messages from the pool
+    */
+    void Clear();
+
+    itkSetMacro(MaximumNumberOfMessagesPerType, unsigned int);
+    itkGetConstMacro(MaximumNumberOfMessagesPerType, unsigned int);
+
+    /**
+    * \brief Returns the number of messages that were created by the factory
+    */
+    unsigned long long GetNumberOfCreatedMessages() const;
+
+    /**
+    * \brief Returns the number of messages that were reused
+    */
+    unsigned long long GetNumberOfReusedMessages() const;
+
+  protected:
+    IGTLMessagePool(mitk::IGTLMessageFactory* factory);
+    virtual ~IGTLMessagePool();
+
+    struct MessageList
+    {
+      MessageList() : m_Next(0) {}
+      std::vector<igtl::MessageBase::Pointer> m_Messages;
+      /** position at which the search for a free message starts */
+      std::size_t m_Next;
+    };
+
+    /** Returns a message of the list that is not used anymore, or NULL. */
+    igtl::MessageBase::Pointer GetFreeMessage(MessageList& list);
+
+    mitk::IGTLMessageFactory::Pointer m_MessageFactory;
+    std::map<std::string, MessageList> m_Messages;
+    unsigned int m_MaximumNumberOfMessagesPerType;
+
+    std::atomic<unsigned long long> m_NumberOfCreatedMessages;
+    std::atomic<unsigned long long> m_NumberOfReusedMessages;
+  };
+} // namespace mitk
+
+#endif /* MITKIGTLMESSAGEPOOL_H_HEADER_INCLUDED_ */
@@ -15,127 +15,291 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkIGTLMessageQueue.h"
+#include "mitkExceptionMacro.h"
 #include <string>
+#include <cstring>
+#include <chrono>
+#include <sstream>
 #include "igtlMessageBase.h"
 
-void mitk::IGTLMessageQueue::PushMessage(igtl::MessageBase::Pointer message)
+static long long Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void CopyString(char* destination, const char* source, std::size_t size)
+{
+  if (source == nullptr)
+    source = "";
+  std::strncpy(destination, source, size);
+  destination[size] = '\0';
+}
+
+bool mitk::IGTLMessageQueue::TryPush(igtl::MessageBase::Pointer& message, long long pushTime)
 {
-  this->m_Mutex->Lock();
-  if (this->m_BufferingType == IGTLMessageQueue::Infinit)
+  // bounded MPMC queue: a cell is free for message pos if its sequence is pos
+  std::size_t pos = m_EnqueuePosition.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true)
   {
-    this->m_Queue.push_back(message);
+    cell = &m_Cells[pos % m_Cells.size()];
+    std::size_t sequence = cell->m_Sequence.load(std::memory_order_acquire);
+    if (sequence == pos)
+    {
+      if (m_EnqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (sequence < pos)
+    {
+      // the cell still holds the message of the previous round, the queue is full
+      return false;
+    }
+    else
+    {
+      pos = m_EnqueuePosition.load(std::memory_order_relaxed);
+    }
   }
-  else //NoBuffering
+
+  cell->m_Message = message;
+  cell->m_PushTime = pushTime;
+  CopyString(cell->m_DeviceType, message->GetDeviceType(), IGTL_HEADER_TYPE_SIZE);
+  CopyString(cell->m_DeviceName, message->GetDeviceName(), IGTL_HEADER_NAME_SIZE);
+  cell->m_Sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool mitk::IGTLMessageQueue::TryPull(igtl::MessageBase::Pointer& message, long long& pushTime)
+{
+  std::size_t pos = m_DequeuePosition.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true)
   {
-    this->m_Queue.clear();
-    this->m_Queue.push_back(message);
+    cell = &m_Cells[pos % m_Cells.size()];
+    std::size_t sequence = cell->m_Sequence.load(std::memory_order_acquire);
+    if (sequence == pos + 1)
+    {
+      if (m_DequeuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (sequence < pos + 1)
+    {
+      // the message was not pushed yet, the queue is empty
+      return false;
+    }
+    else
+    {
+      pos = m_DequeuePosition.load(std::memory_order_relaxed);
+    }
   }
 
-  this->m_Mutex->Unlock();
+  message = cell->m_Message;
+  pushTime = cell->m_PushTime;
+  // release the reference of the queue, the message pool of the device can
+  // reuse the message as soon as the consumer releases it
+  cell->m_Message = nullptr;
+  cell->m_Sequence.store(pos + m_Cells.size(), std::memory_order_release);
+  return true;
+}
+
+void mitk::IGTLMessageQueue::PushMessage(igtl::MessageBase::Pointer message)
+{
+  if (message.IsNull())
+    return;
+
+  long long pushTime = Now();
+  igtl::MessageBase::Pointer dropped;
+  long long droppedPushTime;
+
+  if (!m_InfiniteBuffering.load(std::memory_order_relaxed))
+  {
+    while (this->TryPull(dropped, droppedPushTime))
+      ++m_NumberOfDroppedMessages;
+  }
+
+  while (!this->TryPush(message, pushTime))
+  {
+    // full: the oldest message makes room for the new one
+    if (this->TryPull(dropped, droppedPushTime))
+      ++m_NumberOfDroppedMessages;
+  }
 }
 
 igtl::MessageBase::Pointer mitk::IGTLMessageQueue::PullMessage()
 {
-  this->m_Mutex->Lock();
   igtl::MessageBase::Pointer ret = nullptr;
-  if (this->m_Queue.size() > 0)
+  long long pushTime = 0;
+  if (this->TryPull(ret, pushTime))
   {
-    ret = this->m_Queue.front();
-    this->m_Queue.pop_front();
+    long long latency = Now() - pushTime;
+    ++m_NumberOfPulledMessages;
+    m_SumOfLatencies += static_cast<unsigned long long>(latency);
+    long long maximum = m_MaximumLatency.load(std::memory_order_relaxed);
+    while (latency > maximum && !m_MaximumLatency.compare_exchange_weak(maximum, latency))
+    {
+    }
   }
-  this->m_Mutex->Unlock();
-
   return ret;
 }
 
+bool mitk::IGTLMessageQueue::ReadInformation(std::size_t pos, std::string& deviceType, std::string& deviceName) const
+{
+  const Cell& cell = m_Cells[pos % m_Cells.size()];
+
+  std::size_t before = cell.m_Sequence.load(std::memory_order_acquire);
+  if (before != pos + 1) // not pushed yet or already pulled
+    return false;
+
+  char type[IGTL_HEADER_TYPE_SIZE + 1];
+  char name[IGTL_HEADER_NAME_SIZE + 1];
+  std::memcpy(type, cell.m_DeviceType, sizeof(type));
+  std::memcpy(name, cell.m_DeviceName, sizeof(name));
+
+  std::atomic_thread_fence(std::memory_order_acquire); // the copy has to be complete before the sequence is checked again
+  if (cell.m_Sequence.load(std::memory_order_relaxed) != before)
+    return false;
+
+  type[IGTL_HEADER_TYPE_SIZE] = '\0';
+  name[IGTL_HEADER_NAME_SIZE] = '\0';
+  deviceType = type;
+  deviceName = name;
+  return true;
+}
+
+bool mitk::IGTLMessageQueue::ReadInformation(bool latest, std::string& deviceType, std::string& deviceName) const
+{
+  std::size_t begin = m_DequeuePosition.load(std::memory_order_acquire);
+  std::size_t end = m_EnqueuePosition.load(std::memory_order_acquire);
+  // skip cells that are reserved but not written yet or that were pulled meanwhile
+  for (std::size_t i = 0; begin + i < end; ++i)
+  {
+    std::size_t pos = latest ? end - 1 - i : begin + i;
+    if (this->ReadInformation(pos, deviceType, deviceName))
+      return true;
+  }
+  return false;
+}
+
 std::string mitk::IGTLMessageQueue::GetNextMsgInformationString()
 {
-  this->m_Mutex->Lock();
+  std::string deviceType;
+  std::string deviceName;
   std::stringstream s;
-  if (this->m_Queue.size() > 0)
+  if (this->ReadInformation(false, deviceType, deviceName))
   {
-    s << "Device Type: " << this->m_Queue.front()->GetDeviceType() << std::endl;
-    s << "Device Name: " << this->m_Queue.front()->GetDeviceName() << std::endl;
+    s << "Device Type: " << deviceType << std::endl;
+    s << "Device Name: " << deviceName << std::endl;
   }
   else
   {
     s << "No Msg";
   }
-  this->m_Mutex->Unlock();
   return s.str();
 }
 
 std::string mitk::IGTLMessageQueue::GetNextMsgDeviceType()
 {
-  this->m_Mutex->Lock();
-  std::stringstream s;
-  if (this->m_Queue.size() > 0)
-  {
-    s << this->m_Queue.front()->GetDeviceType();
-  }
-  else
-  {
-    s << "";
-  }
-  this->m_Mutex->Unlock();
-  return s.str();
+  std::string deviceType;
+  std::string deviceName;
+  this->ReadInformation(false, deviceType, deviceName);
+  return deviceType;
 }
 
 std::string mitk::IGTLMessageQueue::GetLatestMsgInformationString()
 {
-  this->m_Mutex->Lock();
+  std::string deviceType;
+  std::string deviceName;
   std::stringstream s;
-  if (this->m_Queue.size() > 0)
+  if (this->ReadInformation(true, deviceType, deviceName))
   {
-    s << "Device Type: " << this->m_Queue.back()->GetDeviceType() << std::endl;
-    s << "Device Name: " << this->m_Queue.back()->GetDeviceName() << std::endl;
+    s << "Device Type: " << deviceType << std::endl;
+    s << "Device Name: " << deviceName << std::endl;
   }
   else
   {
     s << "No Msg";
   }
-  this->m_Mutex->Unlock();
   return s.str();
 }
 
 std::string mitk::IGTLMessageQueue::GetLatestMsgDeviceType()
 {
-  this->m_Mutex->Lock();
-  std::stringstream s;
-  if (this->m_Queue.size() > 0)
-  {
-    s << this->m_Queue.back()->GetDeviceType();
-  }
-  else
-  {
-    s << "";
-  }
-  this->m_Mutex->Unlock();
-  return s.str();
+  std::string deviceType;
+  std::string deviceName;
+  this->ReadInformation(true, deviceType, deviceName);
+  return deviceType;
 }
 
 int mitk::IGTLMessageQueue::GetSize()
 {
-  return this->m_Queue.size();
+  std::size_t begin = m_DequeuePosition.load(std::memory_order_acquire);
+  std::size_t end = m_EnqueuePosition.load(std::memory_order_acquire);
+  return end > begin ? static_cast<int>(end - begin) : 0;
+}
+
+unsigned int mitk::IGTLMessageQueue::GetCapacity() const
+{
+  return static_cast<unsigned int>(m_Cells.size());
 }
 
 void mitk::IGTLMessageQueue::EnableInfiniteBuffering(bool enable)
 {
-  this->m_Mutex->Lock();
-  if (enable)
-    this->m_BufferingType = IGTLMessageQueue::Infinit;
-  else
-    this->m_BufferingType = IGTLMessageQueue::NoBuffering;
-  this->m_Mutex->Unlock();
+  m_InfiniteBuffering = enable;
+}
+
+unsigned long long mitk::IGTLMessageQueue::GetNumberOfDroppedMessages() const
+{
+  return m_NumberOfDroppedMessages.load();
+}
+
+unsigned long long mitk::IGTLMessageQueue::GetNumberOfPulledMessages() const
+{
+  return m_NumberOfPulledMessages.load();
+}
+
+double mitk::IGTLMessageQueue::GetMeanLatency() const
+{
+  unsigned long long pulled = m_NumberOfPulledMessages.load();
+  if (pulled == 0)
+    return 0.0;
+  return static_cast<double>(m_SumOfLatencies.load()) / pulled / 1.0e6;
+}
+
+double mitk::IGTLMessageQueue::GetMaximumLatency() const
+{
+  return static_cast<double>(m_MaximumLatency.load()) / 1.0e6;
 }
 
-mitk::IGTLMessageQueue::IGTLMessageQueue()
+void mitk::IGTLMessageQueue::ResetStatistics()
 {
-  this->m_Mutex = itk::FastMutexLock::New();
-  this->m_BufferingType = IGTLMessageQueue::Infinit;
+  m_NumberOfDroppedMessages = 0;
+  m_NumberOfPulledMessages = 0;
+  m_SumOfLatencies = 0;
+  m_MaximumLatency = 0;
+}
+
+mitk::IGTLMessageQueue::IGTLMessageQueue(unsigned int capacity)
+  : m_Cells(capacity),
+    m_EnqueuePosition(0),
+    m_DequeuePosition(0),
+    m_InfiniteBuffering(true),
+    m_NumberOfDroppedMessages(0),
+    m_NumberOfPulledMessages(0),
+    m_SumOfLatencies(0),
+    m_MaximumLatency(0)
+{
+  if (capacity == 0)
+  {
+    mitkThrow() << "The capacity of an IGTLMessageQueue must not be 0.";
+  }
+  for (std::size_t i = 0; i < m_Cells.size(); ++i)
+  {
+    m_Cells[i].m_Sequence.store(i, std::memory_order_relaxed);
+    m_Cells[i].m_DeviceType[0] = '\0';
+    m_Cells[i].m_DeviceName[0] = '\0';
+  }
 }
 
 mitk::IGTLMessageQueue::~IGTLMessageQueue()
 {
-  this->m_Mutex->Unlock();
-}
\ No newline at end of file
+}
@@ -20,12 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "MitkOpenIGTLinkExports.h"
 
 #include "itkObject.h"
-#include "itkFastMutexLock.h"
 #include "mitkCommon.h"
 
-#include <deque>
+#include <atomic>
+#include <vector>
 
 #include "igtlMessageBase.h"
+#include "igtl_header.h"
 
 
 namespace mitk {
@@ -33,6 +34,15 @@ namespace mitk {
   * \class IGTLMessageQueue
   * \brief Thread safe message queue to store OpenIGTLink messages.
   *
+  * The queue is a bounded lock-free ring buffer: any number of threads may
+  * push and pull messages at the same time without blocking each other. If
+  * the queue is full, the oldest message is removed to make room for the new
+  * one and counted as dropped.
+  *
+  * The queue measures the time each message spends in it. Together with the
+  * number of dropped messages this is available via GetMeanLatency(),
+  * GetMaximumLatency() and GetNumberOfDroppedMessages().
+  *
   * \ingroup OpenIGTLink
   */
   class MITKOPENIGTLINK_EXPORT IGTLMessageQueue : public itk::Object
@@ -40,17 +50,22 @@ namespace mitk {
   public:
     mitkClassMacroItkParent(mitk::IGTLMessageQueue, itk::Object)
     itkFactorylessNewMacro(Self)
+    mitkNewMacro1Param(Self, unsigned int)
     itkCloneMacro(Self)
 
     /**
      * \brief Different buffering types
-     * Infinit buffering means that you can push as many messages as you want
+     * Infinit buffering means that you can push as many messages as you want,
+     * only limited by the capacity of the queue
      * NoBuffering means that the queue just stores a single message
     */
     enum BufferingType {Infinit, NoBuffering};
 
     /**
     * \brief Adds the message to the queue
+    *
+    * Removes the oldest message if the queue is full or if buffering is
+    * disabled.
     */
     void PushMessage( igtl::MessageBase::Pointer message );
     /**
@@ -63,6 +78,11 @@ namespace mitk {
     */
     int GetSize();
 
+    /**
+    * \brief Returns the maximum number of messages in the queue
+    */
+    unsigned int GetCapacity() const;
+
     /**
     * \brief Returns a string with information about the oldest message in the
     * queue
@@ -75,13 +95,13 @@ namespace mitk {
     std::string GetNextMsgDeviceType();
 
     /**
-    * \brief Returns a string with information about the oldest message in the
+    * \brief Returns a string with information about the newest message in the
     * queue
     */
     std::string GetLatestMsgInformationString();
 
     /**
-    * \brief Returns the device type of the oldest message in the queue
+    * \brief Returns the device type of the newest message in the queue
     */
     std::string GetLatestMsgDeviceType();
 
@@ -91,26 +111,90 @@ namespace mitk {
     */
     void EnableInfiniteBuffering(bool enable);
 
+    /**
+    * \brief Returns the number of messages that were removed from the queue
+    * before they were pulled
+    */
+    unsigned long long GetNumberOfDroppedMessages() const;
+
+    /**
+    * \brief Returns the number of messages that were pulled from the queue
+    */
+    unsigned long long GetNumberOfPulledMessages() const;
+
+    /**
+    * \brief Returns the mean time in ms between pushing and pulling a message
+    */
+    double GetMeanLatency() const;
+
+    /**
+    * \brief Returns the maximum time in ms between pushing and pulling a message
+    */
+    double GetMaximumLatency() const;
+
+    /**
+    * \brief Sets the number of dropped and pulled messages and the latencies to 0
+    */
+    void ResetStatistics();
+
   protected:
-    IGTLMessageQueue();
+    IGTLMessageQueue(unsigned int capacity = 1024);
     virtual ~IGTLMessageQueue();
 
+    /**
+    * \brief Adds the message if the queue is not full
+    */
+    bool TryPush(igtl::MessageBase::Pointer& message, long long pushTime);
 
-  protected:
     /**
-    * \brief Mutex to take car of the queue
+    * \brief Removes the oldest message if the queue is not empty
     */
-    itk::FastMutexLock::Pointer m_Mutex;
+    bool TryPull(igtl::MessageBase::Pointer& message, long long& pushTime);
 
     /**
-    * \brief the queue that stores pointer to the inserted messages
+    * \brief Copies device type and name of message number pos if it is still
+    * in the queue and was not replaced while copying
     */
-    std::deque< igtl::MessageBase::Pointer > m_Queue;
+    bool ReadInformation(std::size_t pos, std::string& deviceType, std::string& deviceName) const;
+
+    /**
+    * \brief Reads the information about the oldest or newest message
+    */
+    bool ReadInformation(bool latest, std::string& deviceType, std::string& deviceName) const;
+
+    struct Cell
+    {
+      Cell() : m_Sequence(0), m_PushTime(0) {}
+      /** pos while the cell is free for message number pos, pos+1 when the message was pushed */
+      std::atomic<std::size_t> m_Sequence;
+      igtl::MessageBase::Pointer m_Message;
+      long long m_PushTime;
+      char m_DeviceType[IGTL_HEADER_TYPE_SIZE + 1];
+      char m_DeviceName[IGTL_HEADER_NAME_SIZE + 1];
+    };
+
+  protected:
+    /**
+    * \brief the ring buffer that stores pointer to the inserted messages
+    */
+    std::vector<Cell> m_Cells;
+
+    /** number of messages that were pushed */
+    std::atomic<std::size_t> m_EnqueuePosition;
+    /** number of messages that were pulled or dropped */
+    std::atomic<std::size_t> m_DequeuePosition;
 
     /**
     * \brief defines the kind of buffering
     */
-    BufferingType m_BufferingType;
+    std::atomic<bool> m_InfiniteBuffering;
+
+    std::atomic<unsigned long long> m_NumberOfDroppedMessages;
+    std::atomic<unsigned long long> m_NumberOfPulledMessages;
+    /** sum of all latencies in ns */
+    std::atomic<unsigned long long> m_SumOfLatencies;
+    /** maximum latency in ns */
+    std::atomic<long long> m_MaximumLatency;
   };
 }
 
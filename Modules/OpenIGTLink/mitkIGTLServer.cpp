@@ -25,15 +25,33 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <igtlImageMessage.h>
 #include <igtl_status.h>
 
+#include <algorithm>
+#include <chrono>
+
+/** number of latencies per client that are used for the percentiles */
+static const std::size_t NUMBER_OF_LATENCY_SAMPLES = 1000;
+
+static long long Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 mitk::IGTLServer::IGTLServer(bool ReadFully) :
-IGTLDevice(ReadFully)
+IGTLDevice(ReadFully),
+m_Broadcasting(false),
+m_MaximumNumberOfPendingMessages(1),
+m_ClientTimeout(500)
 {
   m_ReceiveListMutex = itk::FastMutexLock::New();
   m_SentListMutex = itk::FastMutexLock::New();
+  m_BroadcastThreader = itk::MultiThreader::New();
 }
 
 mitk::IGTLServer::~IGTLServer()
 {
+  // the sending threads of the clients have to be stopped before the lists are destroyed
+  this->CloseConnection();
   m_ReceiveListMutex = nullptr;
   m_SentListMutex = nullptr;
 }
@@ -133,7 +151,7 @@ void mitk::IGTLServer::Receive()
       socketsToBeRemoved.push_back(*it);
       MITK_WARN("IGTLServer") << "Lost connection to a client socket. ";
     }
-    else if (status != 1)
+    else if (status != IGTL_STATUS_OK && status != IGTL_STATUS_TIME_OUT)
     {
       MITK_WARN("IGTLServer") << "IGTL Message with status: " << status;
     }
@@ -161,6 +179,12 @@ void mitk::IGTLServer::Send()
 
   AddTrackingMeasurements(4, curMessage, 0);
 
+  if (m_Broadcasting)
+  {
+    this->Broadcast(curMessage);
+    return;
+  }
+
   //the server can be connected with several clients, therefore it has to check
   //all registered clients
   //sending a message to all registered clients might not be the best solution,
@@ -190,6 +214,10 @@ void mitk::IGTLServer::StopCommunicationWithSocket(
 
 void mitk::IGTLServer::StopCommunicationWithSocket(igtl::Socket* client)
 {
+  // the client leaves both lists at once, otherwise a concurrent Broadcast()
+  // could start a new sending thread for it
+  igtl::Socket::Pointer socket;
+  std::unique_ptr<ClientConnection> connection;
   m_SentListMutex->Lock();
   m_ReceiveListMutex->Lock();
   auto i = m_RegisteredClients.begin();
@@ -198,9 +226,8 @@ void mitk::IGTLServer::StopCommunicationWithSocket(igtl::Socket* client)
   {
     if ((*i) == client)
     {
-      //    //close the socket
-      (*i)->CloseSocket();
-      //and remove it from the list
+      socket = *i;
+      //remove it from the list
       i = this->m_RegisteredClients.erase(i);
     }
     else
@@ -208,13 +235,199 @@ void mitk::IGTLServer::StopCommunicationWithSocket(igtl::Socket* client)
       ++i;
     }
   }
+  auto it = m_ClientConnections.find(socket);
+  if (it != m_ClientConnections.end())
+  {
+    connection = std::move(it->second);
+    m_ClientConnections.erase(it);
+  }
   m_SentListMutex->Unlock();
   m_ReceiveListMutex->Unlock();
 
+  if (socket.IsNull())
+    return;
+
+  // the socket must not be closed while its sending thread uses it
+  this->StopBroadcasting(std::move(connection));
+  socket->CloseSocket();
+
   MITK_INFO("IGTLServer") << "Removed client socket from server client list.";
 }
 
 unsigned int mitk::IGTLServer::GetNumberOfConnections()
 {
   return this->m_RegisteredClients.size();
-}
\ No newline at end of file
+}
+
+void mitk::IGTLServer::Broadcast(igtl::MessageBase::Pointer msg)
+{
+  // add the name of this device to the message
+  msg->SetDeviceName(this->GetName().c_str());
+
+  // Pack (serialize) once for all clients
+  msg->Pack();
+
+  // measure the time
+  AddTrackingMeasurements(5, msg, 0);
+
+  std::shared_ptr<PackedMessage> packedMessage = std::make_shared<PackedMessage>();
+  const char* pack = static_cast<const char*>(msg->GetPackPointer());
+  packedMessage->m_Data.assign(pack, pack + msg->GetPackSize());
+  packedMessage->m_PackTime = Now();
+
+  SocketListType failedClients;
+  m_SentListMutex->Lock();
+  for (SocketListIteratorType it = m_RegisteredClients.begin(); it != m_RegisteredClients.end(); ++it)
+  {
+    std::unique_ptr<ClientConnection>& connection = m_ClientConnections[*it];
+    if (!connection)
+    {
+      // the sending thread must not block forever on a client that stopped reading
+      (*it)->SetTimeout(m_ClientTimeout);
+
+      connection.reset(new ClientConnection);
+      connection->m_Socket = *it;
+      connection->m_MessageAvailable = itk::ConditionVariable::New();
+      connection->m_Stop = false;
+      connection->m_Failed = false;
+      connection->m_NumberOfSentMessages = 0;
+      connection->m_NumberOfDroppedMessages = 0;
+      connection->m_Latencies.reserve(NUMBER_OF_LATENCY_SAMPLES);
+      connection->m_MaximumLatency = 0;
+      connection->m_ThreadID = m_BroadcastThreader->SpawnThread(this->ThreadStartBroadcasting, connection.get());
+    }
+
+    connection->m_Mutex.Lock();
+    if (connection->m_Failed)
+    {
+      failedClients.push_back(*it);
+    }
+    else
+    {
+      // a slow client gets the latest messages only
+      while (!connection->m_PendingMessages.empty() &&
+             connection->m_PendingMessages.size() >= std::max(m_MaximumNumberOfPendingMessages, 1u))
+      {
+        connection->m_PendingMessages.pop_front();
+        ++connection->m_NumberOfDroppedMessages;
+      }
+      connection->m_PendingMessages.push_back(packedMessage);
+      connection->m_MessageAvailable->Signal();
+    }
+    connection->m_Mutex.Unlock();
+  }
+  m_SentListMutex->Unlock();
+
+  this->InvokeEvent(MessageSentEvent());
+
+  if (failedClients.size() > 0)
+  {
+    MITK_WARN("IGTLServer") << "Could not send to " << failedClients.size() << " client(s), removing them.";
+    this->StopCommunicationWithSocket(failedClients);
+    this->InvokeEvent(LostConnectionEvent());
+  }
+}
+
+void mitk::IGTLServer::RunBroadcasting(ClientConnection* connection)
+{
+  while (true)
+  {
+    connection->m_Mutex.Lock();
+    while (!connection->m_Stop && connection->m_PendingMessages.empty())
+      connection->m_MessageAvailable->Wait(&connection->m_Mutex);
+    if (connection->m_Stop)
+    {
+      connection->m_Mutex.Unlock();
+      return;
+    }
+    PackedMessagePointer message = connection->m_PendingMessages.front();
+    connection->m_PendingMessages.pop_front();
+    connection->m_Mutex.Unlock();
+
+    int sendSuccess = connection->m_Socket->Send(message->m_Data.data(), message->m_Data.size());
+    double latency = (Now() - message->m_PackTime) / 1.0e6;
+
+    connection->m_Mutex.Lock();
+    if (sendSuccess)
+    {
+      // keep the latest latencies in a ring buffer
+      if (connection->m_Latencies.size() < NUMBER_OF_LATENCY_SAMPLES)
+        connection->m_Latencies.push_back(latency);
+      else
+        connection->m_Latencies[connection->m_NumberOfSentMessages % NUMBER_OF_LATENCY_SAMPLES] = latency;
+      connection->m_MaximumLatency = std::max(connection->m_MaximumLatency, latency);
+      ++connection->m_NumberOfSentMessages;
+    }
+    else
+    {
+      // a part of the message may have been sent, the client cannot be used anymore
+      connection->m_Failed = true;
+      connection->m_PendingMessages.clear();
+    }
+    connection->m_Mutex.Unlock();
+
+    if (!sendSuccess)
+      return;
+  }
+}
+
+void mitk::IGTLServer::StopBroadcasting(std::unique_ptr<ClientConnection> connection)
+{
+  if (!connection)
+    return;
+
+  connection->m_Mutex.Lock();
+  connection->m_Stop = true;
+  connection->m_MessageAvailable->Broadcast();
+  connection->m_Mutex.Unlock();
+  // waits for the thread, it ends at the latest after the client timeout
+  m_BroadcastThreader->TerminateThread(connection->m_ThreadID);
+}
+
+mitk::IGTLServer::ClientStatisticsContainer mitk::IGTLServer::GetClientStatistics()
+{
+  ClientStatisticsContainer result;
+  m_SentListMutex->Lock();
+  for (SocketListIteratorType it = m_RegisteredClients.begin(); it != m_RegisteredClients.end(); ++it)
+  {
+    ClientStatistics statistics = { 0, 0, 0.0, 0.0, 0.0, 0.0 };
+    std::vector<double> latencies;
+
+    auto connection = m_ClientConnections.find(*it);
+    if (connection != m_ClientConnections.end())
+    {
+      connection->second->m_Mutex.Lock();
+      statistics.m_NumberOfSentMessages = connection->second->m_NumberOfSentMessages;
+      statistics.m_NumberOfDroppedMessages = connection->second->m_NumberOfDroppedMessages;
+      statistics.m_MaximumLatency = connection->second->m_MaximumLatency;
+      latencies = connection->second->m_Latencies;
+      connection->second->m_Mutex.Unlock();
+    }
+
+    if (!latencies.empty())
+    {
+      std::sort(latencies.begin(), latencies.end());
+      const std::size_t last = latencies.size() - 1;
+      statistics.m_MedianLatency = latencies[last / 2];
+      statistics.m_Percentile95Latency = latencies[last * 95 / 100];
+      statistics.m_Percentile99Latency = latencies[last * 99 / 100];
+    }
+    result.push_back(statistics);
+  }
+  m_SentListMutex->Unlock();
+  return result;
+}
+
+ITK_THREAD_RETURN_TYPE mitk::IGTLServer::ThreadStartBroadcasting(void* pInfoStruct)
+{
+  /* extract the connection from Thread Info structure */
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo =
+    (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+  if (pInfo == nullptr || pInfo->UserData == nullptr)
+  {
+    return ITK_THREAD_RETURN_VALUE;
+  }
+  ClientConnection* connection = (ClientConnection*)pInfo->UserData;
+  RunBroadcasting(connection);
+  return ITK_THREAD_RETURN_VALUE;
+}
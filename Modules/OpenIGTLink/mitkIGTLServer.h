@@ -21,6 +21,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <MitkOpenIGTLinkExports.h>
 
+#include <itkConditionVariable.h>
+#include <itkMutexLock.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
 namespace mitk
 {
   /**
@@ -32,6 +40,14 @@ namespace mitk
   * connect to several clients. Therefore, it is necessary for the server to
   * have a list with registered sockets.
   *
+  * By default, the send thread packs and sends each message to one client
+  * after the other, so a slow client delays all others. In broadcast mode
+  * (SetBroadcasting()) each message is packed once and handed to a sending
+  * thread per client. If a client cannot keep up, its oldest pending messages
+  * are dropped, with the default of one pending message per client it always
+  * gets the latest message. A client that does not accept any data for
+  * GetClientTimeout() ms is disconnected.
+  *
   * \ingroup OpenIGTLink
   */
   class MITKOPENIGTLINK_EXPORT IGTLServer : public IGTLDevice
@@ -67,7 +83,79 @@ namespace mitk
     */
     virtual unsigned int GetNumberOfConnections() override;
 
+    /**
+    * \brief Statistics of the messages sent to one client in broadcast mode
+    */
+    struct ClientStatistics
+    {
+      unsigned long long m_NumberOfSentMessages;
+      unsigned long long m_NumberOfDroppedMessages; ///< replaced by newer messages before they were sent
+      double m_MedianLatency;                       ///< time in ms from packing a message to the end of sending it
+      double m_Percentile95Latency;
+      double m_Percentile99Latency;
+      double m_MaximumLatency;
+    };
+    typedef std::vector<ClientStatistics> ClientStatisticsContainer;
+
+    /**
+    * \brief Returns the statistics of all clients in the order of their
+    * connection. The percentiles refer to the last 1000 messages of a client.
+    */
+    ClientStatisticsContainer GetClientStatistics();
+
+    /**
+    * \brief Enables broadcast mode, has to be set before StartCommunication()
+    */
+    itkSetMacro(Broadcasting, bool);
+    itkGetConstMacro(Broadcasting, bool);
+    itkBooleanMacro(Broadcasting);
+
+    /**
+    * \brief Sets the number of messages that wait for a slow client in
+    * broadcast mode, 1 (the default) sends only the latest message
+    */
+    itkSetMacro(MaximumNumberOfPendingMessages, unsigned int);
+    itkGetConstMacro(MaximumNumberOfPendingMessages, unsigned int);
+
+    /**
+    * \brief Sets the send and receive timeout in ms of the client sockets in
+    * broadcast mode
+    */
+    itkSetMacro(ClientTimeout, int);
+    itkGetConstMacro(ClientTimeout, int);
+
+    /**
+    * \brief static start method for the sending thread of a client in
+    * broadcast mode.
+    * \param data a void pointer to the ClientConnection object.
+    */
+    static ITK_THREAD_RETURN_TYPE ThreadStartBroadcasting(void* data);
+
   protected:
+    /** a message packed once for all clients and the time of packing in ns */
+    struct PackedMessage
+    {
+      std::vector<char> m_Data;
+      long long m_PackTime;
+    };
+    typedef std::shared_ptr<const PackedMessage> PackedMessagePointer;
+
+    /** the sending thread of one client in broadcast mode and its pending messages */
+    struct ClientConnection
+    {
+      igtl::Socket::Pointer m_Socket;
+      int m_ThreadID;
+      itk::SimpleMutexLock m_Mutex;               ///< guards all members below
+      itk::ConditionVariable::Pointer m_MessageAvailable;
+      std::deque<PackedMessagePointer> m_PendingMessages;
+      bool m_Stop;
+      bool m_Failed;                              ///< sending failed, the client has to be removed
+      unsigned long long m_NumberOfSentMessages;
+      unsigned long long m_NumberOfDroppedMessages;
+      std::vector<double> m_Latencies;            ///< ring buffer of the latest latencies in ms
+      double m_MaximumLatency;
+    };
+
     /** Constructor */
     IGTLServer(bool ReadFully);
     /** Destructor */
@@ -113,6 +201,23 @@ namespace mitk
       */
     virtual void StopCommunicationWithSocket(igtl::Socket* client) override;
 
+    /**
+    * \brief Hands the message to the sending threads of all clients, starts
+    * the threads of new clients and removes clients that failed
+    */
+    void Broadcast(igtl::MessageBase::Pointer msg);
+
+    /**
+    * \brief Sends the pending messages of one client until it is stopped
+    */
+    static void RunBroadcasting(ClientConnection* connection);
+
+    /**
+    * \brief Stops the sending thread of a client in broadcast mode and waits
+    * for it. The connection has to be removed from m_ClientConnections before.
+    */
+    void StopBroadcasting(std::unique_ptr<ClientConnection> connection);
+
     /**
      * \brief A list with all registered clients
      */
@@ -121,8 +226,16 @@ namespace mitk
     /** mutex to control access to m_RegisteredClients */
     itk::FastMutexLock::Pointer m_ReceiveListMutex;
 
-    /** mutex to control access to m_RegisteredClients */
+    /** mutex to control access to m_RegisteredClients and m_ClientConnections */
     itk::FastMutexLock::Pointer m_SentListMutex;
+
+    /** the sending threads of the clients in broadcast mode */
+    std::map<igtl::Socket::Pointer, std::unique_ptr<ClientConnection>> m_ClientConnections;
+    itk::MultiThreader::Pointer m_BroadcastThreader;
+
+    bool m_Broadcasting;
+    unsigned int m_MaximumNumberOfPendingMessages;
+    int m_ClientTimeout;
   };
 } // namespace mitk
 #endif /* MITKIGTLSERVER_H */
@@ -17,9 +17,34 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDiffSliceOperation.h"
 
 #include <mitkImage.h>
+#include <mitkImageReadAccessor.h>
+#include <mitkImageWriteAccessor.h>
+#include <mitkExtractSliceFilter.h>
+#include <mitkVtkImageOverwrite.h>
 
 #include <itkCommand.h>
 
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  // the longest run that can be stored in the 2 byte run length
+  const unsigned int MAX_RUN_LENGTH = 0xFFFF;
+
+  // 64 bit FNV-1a hash of the slice content
+  uint64_t SliceChecksum(const unsigned char* data, size_t size)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i)
+    {
+      hash ^= data[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+}
+
 mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
 {
   m_TimeStep = 0;
@@ -28,6 +53,9 @@ mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
   m_WorldGeometry = nullptr;
   m_SliceGeometry = nullptr;
   m_ImageIsValid = false;
+  m_SparseDifference = false;
+  m_PixelSize = 0;
+  m_ReferenceChecksum = 0;
 }
 
 
@@ -51,9 +79,47 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
 
   m_TimeStep = timestep;
 
+  m_SparseDifference = false;
+  m_PixelSize = 0;
+  m_ReferenceChecksum = 0;
+
+  m_zlibSliceContainer = CompressedImageContainer::New();
+  m_zlibSliceContainer->SetImage( slice );
+
+  this->ObserveImage(imageVolume);
+}
+
+mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
+                                             Image *slice,
+                                             Image *referenceSlice,
+                                             SlicedGeometry3D* sliceGeometry,
+                                             unsigned int timestep,
+                                             BaseGeometry* currentWorldGeometry):Operation(1)
+
+{
+  m_WorldGeometry = currentWorldGeometry->Clone();
+
+  // see bug 12338, the clone of the PlaneGeometry does not keep the reference geometry alive
+  m_GuardReferenceGeometry = dynamic_cast<mitk::PlaneGeometry*>(m_WorldGeometry.GetPointer())->GetReferenceGeometry();
+
+  m_SliceGeometry = sliceGeometry->Clone();
+
+  m_TimeStep = timestep;
+
+  m_SparseDifference = false;
+  m_PixelSize = 0;
+  m_ReferenceChecksum = 0;
+
+  // the whole slice is kept in case the volume does not match the reference slice anymore
+  this->EncodeDifference(slice, referenceSlice);
   m_zlibSliceContainer = CompressedImageContainer::New();
   m_zlibSliceContainer->SetImage( slice );
 
+  this->ObserveImage(imageVolume);
+}
+
+void mitk::DiffSliceOperation::ObserveImage(mitk::Image* imageVolume)
+{
   m_Image = imageVolume;
 
   if ( m_Image) {
@@ -68,7 +134,6 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
   }
   else
     m_ImageIsValid = false;
-
 }
 
 mitk::DiffSliceOperation::~DiffSliceOperation()
@@ -86,13 +151,190 @@ mitk::DiffSliceOperation::~DiffSliceOperation()
 
 mitk::Image::Pointer mitk::DiffSliceOperation::GetSlice()
 {
+  if (m_SparseDifference)
+    return this->DecodeDifference();
+
   Image::Pointer image = m_zlibSliceContainer->GetImage();
   return image;
 }
 
 bool mitk::DiffSliceOperation::IsValid()
 {
-  return m_ImageIsValid && m_zlibSliceContainer.IsNotNull() && (m_WorldGeometry.IsNotNull());//TODO improve
+  return m_ImageIsValid && (m_SparseDifference || m_zlibSliceContainer.IsNotNull()) && (m_WorldGeometry.IsNotNull());//TODO improve
+}
+
+size_t mitk::DiffSliceOperation::GetMemoryUsage() const
+{
+  size_t memoryUsage = m_EncodedDifference.capacity();
+
+  if (m_zlibSliceContainer.IsNotNull())
+    memoryUsage += m_zlibSliceContainer->GetCompressedSizeInBytes();
+
+  return memoryUsage;
+}
+
+bool mitk::DiffSliceOperation::EncodeDifference(mitk::Image* slice, mitk::Image* referenceSlice)
+{
+  if (!slice || !referenceSlice)
+    return false;
+
+  if (slice->GetPixelType() != referenceSlice->GetPixelType())
+    return false;
+
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    if (slice->GetDimension(i) != referenceSlice->GetDimension(i))
+      return false;
+  }
+  if (slice->GetDimension() > 3 || (slice->GetDimension() == 3 && slice->GetDimension(2) != 1))
+    return false;
+
+  const unsigned int width = slice->GetDimension(0);
+  const unsigned int height = slice->GetDimension(1);
+  const size_t pixelSize = slice->GetPixelType().GetBpe() / 8;
+  if (width == 0 || height == 0 || pixelSize == 0)
+    return false;
+
+  mitk::ImageReadAccessor sliceAccess(slice);
+  mitk::ImageReadAccessor referenceAccess(referenceSlice);
+  const unsigned char* sliceData = static_cast<const unsigned char*>(sliceAccess.GetData());
+  const unsigned char* referenceData = static_cast<const unsigned char*>(referenceAccess.GetData());
+
+  // bounding box of the pixels that differ
+  unsigned int xMin = width, xMax = 0, yMin = height, yMax = 0;
+  const size_t lineSize = width * pixelSize;
+  for (unsigned int y = 0; y < height; ++y)
+  {
+    const unsigned char* sliceLine = sliceData + y * lineSize;
+    const unsigned char* referenceLine = referenceData + y * lineSize;
+    if (std::memcmp(sliceLine, referenceLine, lineSize) == 0)
+      continue;
+
+    for (unsigned int x = 0; x < width; ++x)
+    {
+      if (std::memcmp(sliceLine + x * pixelSize, referenceLine + x * pixelSize, pixelSize) != 0)
+      {
+        xMin = std::min(xMin, x);
+        xMax = std::max(xMax, x);
+        yMin = std::min(yMin, y);
+        yMax = std::max(yMax, y);
+      }
+    }
+  }
+
+  m_SliceDimensions[0] = width;
+  m_SliceDimensions[1] = height;
+  m_PixelSize = pixelSize;
+  m_ReferenceChecksum = SliceChecksum(referenceData, height * lineSize);
+  m_EncodedDifference.clear();
+
+  if (xMin > xMax)
+  {
+    // nothing changed, the current content of the volume is the slice
+    m_DifferenceRegion[0] = 1;
+    m_DifferenceRegion[1] = 0;
+    m_DifferenceRegion[2] = 1;
+    m_DifferenceRegion[3] = 0;
+    m_SparseDifference = true;
+    return true;
+  }
+
+  m_DifferenceRegion[0] = xMin;
+  m_DifferenceRegion[1] = xMax;
+  m_DifferenceRegion[2] = yMin;
+  m_DifferenceRegion[3] = yMax;
+
+  // run-length encode the bounding box row by row, segmentations mostly consist of long runs of equal labels
+  for (unsigned int y = yMin; y <= yMax; ++y)
+  {
+    const unsigned char* pixel = sliceData + (y * width + xMin) * pixelSize;
+    unsigned int remaining = xMax - xMin + 1;
+    while (remaining > 0)
+    {
+      unsigned int runLength = 1;
+      while (runLength < remaining && runLength < MAX_RUN_LENGTH
+             && std::memcmp(pixel, pixel + runLength * pixelSize, pixelSize) == 0)
+      {
+        ++runLength;
+      }
+
+      m_EncodedDifference.push_back(static_cast<unsigned char>(runLength & 0xFF));
+      m_EncodedDifference.push_back(static_cast<unsigned char>(runLength >> 8));
+      m_EncodedDifference.insert(m_EncodedDifference.end(), pixel, pixel + pixelSize);
+
+      pixel += runLength * pixelSize;
+      remaining -= runLength;
+    }
+  }
+
+  std::vector<unsigned char>(m_EncodedDifference).swap(m_EncodedDifference);
+  m_SparseDifference = true;
+  return true;
+}
+
+mitk::Image::Pointer mitk::DiffSliceOperation::DecodeDifference()
+{
+  // extract the slice exactly as it is overwritten later on (see DiffSliceOperationApplier)
+  vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
+  reslice->SetOverwriteMode(false);
+  reslice->Modified();
+
+  mitk::ExtractSliceFilter::Pointer extractor = mitk::ExtractSliceFilter::New(reslice);
+  extractor->SetInput( m_Image );
+  extractor->SetTimeStep( m_TimeStep );
+  extractor->SetWorldGeometry( dynamic_cast<PlaneGeometry*>(m_WorldGeometry.GetPointer()) );
+  extractor->SetVtkOutputRequest(false);
+  extractor->SetResliceTransformByGeometry( m_Image->GetTimeGeometry()->GetGeometryForTimeStep( m_TimeStep ) );
+  extractor->Modified();
+  extractor->Update();
+
+  Image::Pointer slice = extractor->GetOutput();
+  slice->DisconnectPipeline();
+
+  // the difference only restores the slice if the volume still contains the reference slice,
+  // which is not the case if it has been edited outside of the undo stack (e.g. by a 3D tool)
+  bool matchesReference = slice->GetDimension(0) == m_SliceDimensions[0] && slice->GetDimension(1) == m_SliceDimensions[1]
+    && slice->GetPixelType().GetBpe() / 8 == m_PixelSize;
+  if (matchesReference)
+  {
+    mitk::ImageReadAccessor currentAccess(slice);
+    const size_t sliceSize = static_cast<size_t>(m_SliceDimensions[0]) * m_SliceDimensions[1] * m_PixelSize;
+    matchesReference = SliceChecksum(static_cast<const unsigned char*>(currentAccess.GetData()), sliceSize) == m_ReferenceChecksum;
+  }
+  if (!matchesReference)
+  {
+    MITK_WARN << "Slice of the volume has been modified since the operation was stored, the whole slice is restored.";
+    return m_zlibSliceContainer->GetImage();
+  }
+
+  if (m_EncodedDifference.empty())
+    return slice;
+
+  mitk::ImageWriteAccessor sliceAccess(slice);
+  unsigned char* sliceData = static_cast<unsigned char*>(sliceAccess.GetData());
+
+  const unsigned int xMin = m_DifferenceRegion[0];
+  const unsigned int regionWidth = m_DifferenceRegion[1] - xMin + 1;
+  auto run = m_EncodedDifference.begin();
+  for (unsigned int y = m_DifferenceRegion[2]; y <= m_DifferenceRegion[3]; ++y)
+  {
+    unsigned char* pixel = sliceData + (y * m_SliceDimensions[0] + xMin) * m_PixelSize;
+    unsigned int remaining = regionWidth;
+    while (remaining > 0 && run != m_EncodedDifference.end())
+    {
+      const unsigned int runLength = run[0] | (run[1] << 8);
+      const unsigned char* value = &run[2];
+      for (unsigned int i = 0; i < runLength; ++i)
+      {
+        std::memcpy(pixel, value, m_PixelSize);
+        pixel += m_PixelSize;
+      }
+      run += 2 + m_PixelSize;
+      remaining -= runLength;
+    }
+  }
+
+  return slice;
 }
 
 void mitk::DiffSliceOperation::OnImageDeleted()
@@ -23,6 +23,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <vtkSmartPointer.h>
 
+#include <vector>
+#include <stdint.h>
+
 
 namespace mitk
 {
@@ -40,6 +43,13 @@ class Image;
      currentWorldGeometry   specifies the axis where the slice has to be applied in the volume.
 
     This Operation can be used to realize undo-redo functionality for e.g. segmentation purposes.
+
+    The whole slice is stored compressed. If a reference slice is given, i.e. the content of the volume at
+    the time the operation is applied, the bounding box of the pixels that differ from the reference slice
+    is stored as well (run-length encoded), together with a checksum of the reference slice. When the
+    operation is applied and the volume still contains the reference slice, only the difference is written
+    into the current content of the volume. If the volume has been modified outside of the undo stack,
+    the compressed slice is restored instead.
   */
   class MITKSEGMENTATION_EXPORT DiffSliceOperation : public Operation
   {
@@ -61,6 +71,14 @@ class Image;
     /** \brief */
     DiffSliceOperation( mitk::Image* imageVolume, mitk::Image* slice, SlicedGeometry3D* sliceGeometry, unsigned int timestep, BaseGeometry* currentWorldGeometry);
 
+    /** \brief Creates an operation that stores only the difference between slice and referenceSlice.
+
+      referenceSlice is the content of imageVolume at the given position when this operation is executed,
+      e.g. for an undo operation the edited slice and for a redo operation the original slice.
+      If both slices do not match in size and pixel type, only the whole slice is stored.
+    */
+    DiffSliceOperation( mitk::Image* imageVolume, mitk::Image* slice, mitk::Image* referenceSlice, SlicedGeometry3D* sliceGeometry, unsigned int timestep, BaseGeometry* currentWorldGeometry);
+
     /** \brief Check if it is a valid operation.*/
     bool IsValid();
 
@@ -89,6 +107,9 @@ class Image;
     /** \brief Get the axis where the slice has to be applied in the volume.*/
     BaseGeometry* GetWorldGeometry(){return this->m_WorldGeometry;}
 
+    /** \brief Returns the memory in bytes held for the slice, i.e. the compressed slice and the encoded difference.*/
+    virtual size_t GetMemoryUsage() const override;
+
   protected:
 
     virtual ~DiffSliceOperation();
@@ -96,8 +117,29 @@ class Image;
     /** \brief Callback for image observer.*/
     void OnImageDeleted();
 
+    /** \brief Observes the volume to invalidate the operation when it is deleted.*/
+    void ObserveImage(mitk::Image* imageVolume);
+
+    /** \brief Stores the run-length encoded bounding box of the pixels of slice that differ from referenceSlice
+      and the checksum of referenceSlice. Returns false if the slices cannot be compared.*/
+    bool EncodeDifference(mitk::Image* slice, mitk::Image* referenceSlice);
+
+    /** \brief Extracts the current slice from the volume and overwrites the stored bounding box.
+      Returns the compressed slice if the current slice differs from the reference slice.*/
+    Image::Pointer DecodeDifference();
+
     CompressedImageContainer::Pointer m_zlibSliceContainer;
 
+    /** \brief Bounding box of the differing pixels as [xmin, xmax, ymin, ymax], valid if m_SparseDifference is true.*/
+    bool m_SparseDifference;
+    unsigned int m_DifferenceRegion[4];
+    unsigned int m_SliceDimensions[2];
+    size_t m_PixelSize;
+    uint64_t m_ReferenceChecksum;
+
+    /** \brief Runs of equal pixels in the bounding box, each stored as a 2 byte count followed by the pixel value.*/
+    std::vector<unsigned char> m_EncodedDifference;
+
     mitk::Image* m_Image;
 
     vtkSmartPointer<vtkImageData> m_Slice;
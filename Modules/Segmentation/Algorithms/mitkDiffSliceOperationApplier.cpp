@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkDiffSliceOperation.h"
 #include <mitkExtractSliceFilter.h>
+#include <mitkImageSliceModifiedEvent.h>
 #include "mitkRenderingManager.h"
 #include "mitkSegTool2D.h"
 #include <mitkVtkImageOverwrite.h>
@@ -69,6 +70,7 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation( Operation* operation )
 
     //make sure the modification is rendered
     RenderingManager::GetInstance()->RequestUpdateAll();
+    imageOperation->GetImage()->InvokeEvent( ImageSliceModifiedEvent( dynamic_cast<PlaneGeometry*>(imageOperation->GetWorldGeometry()), imageOperation->GetTimeStep() ) );
     imageOperation->GetImage()->Modified();
 
     mitk::ExtractSliceFilter::Pointer extractor2 = mitk::ExtractSliceFilter::New();
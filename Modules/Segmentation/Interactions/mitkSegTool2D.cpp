@@ -47,6 +47,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkDiffSliceOperationApplier.h>
 #include "mitkOperationEvent.h"
+#include "mitkImageSliceModifiedEvent.h"
 #include "mitkUndoController.h"
 
 #include "mitkAbstractTransformGeometry.h"
@@ -335,9 +336,8 @@ void mitk::SegTool2D::WriteSliceToVolume(mitk::SegTool2D::SliceInformation slice
   Image* image = dynamic_cast<Image*>(workingNode->GetData());
 
   /*============= BEGIN undo/redo feature block ========================*/
-  // Create undo operation by caching the not yet modified slices
+  // Cache the not yet modified slice for the undo operation
   mitk::Image::Pointer originalSlice = GetAffectedImageSliceAs2DImage(sliceInfo.plane, image, sliceInfo.timestep);
-  DiffSliceOperation* undoOperation = new DiffSliceOperation(const_cast<mitk::Image*>(image), originalSlice, dynamic_cast<SlicedGeometry3D*>(originalSlice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
   /*============= END undo/redo feature block ========================*/
 
   //Make sure that for reslicing and overwriting the same alogrithm is used. We can specify the mode of the vtk reslicer
@@ -361,12 +361,15 @@ void mitk::SegTool2D::WriteSliceToVolume(mitk::SegTool2D::SliceInformation slice
   extractor->Update();
 
   //the image was modified within the pipeline, but not marked so
+  image->InvokeEvent( ImageSliceModifiedEvent(sliceInfo.plane, sliceInfo.timestep) );
   image->Modified();
   image->GetVtkImageData()->Modified();
 
   /*============= BEGIN undo/redo feature block ========================*/
-  //specify the undo operation with the edited slice
-  DiffSliceOperation* doOperation = new DiffSliceOperation(image, extractor->GetOutput(),dynamic_cast<SlicedGeometry3D*>(sliceInfo.slice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
+  //create undo and redo operation; both only store the difference between the original and the edited slice
+  mitk::Image::Pointer editedSlice = extractor->GetOutput();
+  DiffSliceOperation* undoOperation = new DiffSliceOperation(image, originalSlice, editedSlice, dynamic_cast<SlicedGeometry3D*>(originalSlice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
+  DiffSliceOperation* doOperation = new DiffSliceOperation(image, editedSlice, originalSlice, dynamic_cast<SlicedGeometry3D*>(sliceInfo.slice->GetGeometry()), sliceInfo.timestep, sliceInfo.plane);
 
   //create an operation event for the undo stack
   OperationEvent* undoStackItem = new OperationEvent( DiffSliceOperationApplier::GetInstance(), doOperation, undoOperation, "Segmentation" );
@@ -15,6 +15,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkUSImageLoggingFilter.h"
+#include "mitkUSImageLogReader.h"
 #include <mitkTestingMacros.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingConfig.h>
@@ -41,6 +42,8 @@ class mitkUSImageLoggingFilterTestSuite : public mitk::TestFixture
   MITK_TEST(TestFilterWithEmptyImages);
   MITK_TEST(TestFilterWithInvalidPath);
   MITK_TEST(TestJpgFileExtension);
+  MITK_TEST(TestStreamingImages);
+  MITK_TEST(TestStreamingToInvalidPath);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -180,6 +183,62 @@ public:
   std::remove(csvFileName.c_str());
   }
 
+  void TestStreamingImages()
+  {
+  std::string fileName = m_TemporaryTestDirectory + "USImageLoggingFilterTest.usl";
+  m_TestFilter->StartStreaming(fileName);
+  CPPUNIT_ASSERT_MESSAGE("Testing if streaming is started",m_TestFilter->IsStreaming());
+
+  //alternate the inputs, so that every Update() logs an image
+  std::vector<mitk::Image::Pointer> images;
+  for(int i=0; i<6; i++)
+    {
+    images.push_back(i%2==0 ? m_RandomSingleSliceImage : m_RandomRestImage1);
+    m_TestFilter->SetInput(images.back());
+    m_TestFilter->Update();
+    if(i==3)
+      {
+      m_TestFilter->AddMessageToCurrentImage("first message");
+      m_TestFilter->AddMessageToCurrentImage("second message");
+      }
+    }
+  m_TestFilter->StopStreaming();
+  CPPUNIT_ASSERT_MESSAGE("Testing if streaming is stopped",!m_TestFilter->IsStreaming());
+  CPPUNIT_ASSERT_MESSAGE("Testing number of streamed images",m_TestFilter->GetNumberOfStreamedImages() == 6);
+  CPPUNIT_ASSERT_MESSAGE("Testing that no image was dropped",m_TestFilter->GetNumberOfDroppedImages() == 0);
+
+  mitk::USImageLogReader::Pointer reader = mitk::USImageLogReader::New();
+  reader->Open(fileName);
+  CPPUNIT_ASSERT_MESSAGE("Testing number of images in the log",reader->GetNumberOfImages() == 6);
+  for(unsigned int i=0; i<reader->GetNumberOfImages(); i++)
+    {
+    CPPUNIT_ASSERT_MESSAGE("Testing logged image",mitk::Equal(*images[i],*reader->GetImage(i),mitk::eps,true));
+    if(i>0)
+      CPPUNIT_ASSERT_MESSAGE("Testing order of timestamps",reader->GetTimeStamp(i) >= reader->GetTimeStamp(i-1));
+    }
+  std::vector<std::string> messages = reader->GetMessages(3);
+  CPPUNIT_ASSERT_MESSAGE("Testing logged messages",messages.size() == 2 && messages[0] == "first message" && messages[1] == "second message");
+  CPPUNIT_ASSERT_MESSAGE("Testing images without messages",reader->GetMessages(2).empty());
+  reader->Close();
+
+  //clean up
+  std::remove(fileName.c_str());
+  }
+
+  void TestStreamingToInvalidPath()
+  {
+  #ifdef WIN32
+  std::string filename = "XV:/342INVALID<>/log.usl"; //invalid filename for windows
+  #else
+  std::string filename = "/dsfdsf:$342INVALID/log.usl"; //invalid filename for linux
+  #endif
+
+  CPPUNIT_ASSERT_THROW_MESSAGE("Testing if correct exception if thrown if an invalid path is given.",
+                               m_TestFilter->StartStreaming(filename),
+                               mitk::Exception);
+  CPPUNIT_ASSERT_MESSAGE("Testing if streaming is not started",!m_TestFilter->IsStreaming());
+  }
+
   void TestSetFileExtension()
   {
     CPPUNIT_ASSERT_MESSAGE("Testing if PIC extension can be set.",m_TestFilter->SetImageFilesExtension("PIC"));
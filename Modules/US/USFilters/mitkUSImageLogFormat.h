@@ -0,0 +1,75 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSIMAGELOGFORMAT_H_HEADER_INCLUDED_
+#define MITKUSIMAGELOGFORMAT_H_HEADER_INCLUDED_
+
+#include <cstdint>
+
+namespace mitk {
+  /**
+  * \brief Layout of the append-only file format of mitk::USImageLogStreamWriter.
+  *
+  * All values are stored in the byte order of the writing machine, which is detected by
+  * m_ByteOrderMark. A file consists of a FileHeader followed by a sequence of records, each
+  * starting with a RecordHeader:
+  * - ImageRecord: an ImageHeader followed by the pixel data of all time steps, compressed with zlib,
+  * - MessageRecord: the text of a message (not zero terminated) which belongs to image m_ImageIndex.
+  *
+  * The last record may be incomplete if a recording was interrupted, readers ignore it.
+  */
+  namespace USImageLogFormat
+  {
+    const char Magic[8] = { 'M', 'I', 'T', 'K', 'U', 'S', 'L', '\0' };
+    const std::uint32_t ByteOrderMark = 0x01020304;
+    const std::uint32_t Version = 1;
+
+    enum RecordType
+    {
+      ImageRecord = 1,
+      MessageRecord = 2
+    };
+
+    struct FileHeader
+    {
+      char m_Magic[8];
+      std::uint32_t m_ByteOrderMark;
+      std::uint32_t m_Version;
+    };
+
+    struct RecordHeader
+    {
+      std::uint32_t m_Type;
+      std::uint32_t m_ImageIndex;
+      std::uint64_t m_Size;                ///< number of bytes following the record header
+    };
+
+    struct ImageHeader
+    {
+      double m_TimeStamp;                  ///< system time stamp in ms as given by mitk::RealTimeClock
+      double m_Matrix[9];                  ///< index to world matrix of the first time step, row by row
+      double m_Offset[3];                  ///< index to world offset of the first time step
+      std::uint32_t m_ComponentType;       ///< itk::ImageIOBase::IOComponentType
+      std::uint32_t m_PixelType;           ///< itk::ImageIOBase::IOPixelType
+      std::uint32_t m_NumberOfComponents;
+      std::uint32_t m_Dimension;
+      std::uint32_t m_Dimensions[4];
+      std::uint64_t m_DataSize;            ///< size of the uncompressed pixel data in bytes
+    };
+  }
+}
+
+#endif // MITKUSIMAGELOGFORMAT_H_HEADER_INCLUDED_
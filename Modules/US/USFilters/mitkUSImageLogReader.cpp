@@ -0,0 +1,225 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageLogReader.h"
+#include <mitkExceptionMacro.h>
+
+#include <itkRGBAPixel.h>
+#include <itkRGBPixel.h>
+#include <itkVectorImage.h>
+
+#include "itk_zlib.h"
+
+#include <cstring>
+
+namespace
+{
+  template <typename TComponentType>
+  mitk::PixelType MakeLoggedPixelType(std::uint32_t pixelType, std::uint32_t numberOfComponents)
+  {
+    switch (pixelType)
+    {
+    case itk::ImageIOBase::SCALAR:
+      return mitk::MakeScalarPixelType<TComponentType>();
+    case itk::ImageIOBase::RGB:
+      return mitk::MakePixelType<itk::Image<itk::RGBPixel<TComponentType>, 3> >();
+    case itk::ImageIOBase::RGBA:
+      return mitk::MakePixelType<itk::Image<itk::RGBAPixel<TComponentType>, 3> >();
+    default:
+      return mitk::MakePixelType<itk::VectorImage<TComponentType, 3> >(numberOfComponents);
+    }
+  }
+
+  mitk::PixelType MakeLoggedPixelType(const mitk::USImageLogFormat::ImageHeader& header)
+  {
+    switch (header.m_ComponentType)
+    {
+    case itk::ImageIOBase::UCHAR:
+      return MakeLoggedPixelType<unsigned char>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::CHAR:
+      return MakeLoggedPixelType<char>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::USHORT:
+      return MakeLoggedPixelType<unsigned short>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::SHORT:
+      return MakeLoggedPixelType<short>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::UINT:
+      return MakeLoggedPixelType<unsigned int>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::INT:
+      return MakeLoggedPixelType<int>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::FLOAT:
+      return MakeLoggedPixelType<float>(header.m_PixelType, header.m_NumberOfComponents);
+    case itk::ImageIOBase::DOUBLE:
+      return MakeLoggedPixelType<double>(header.m_PixelType, header.m_NumberOfComponents);
+    default:
+      mitkThrow() << "Logged images with component type " << header.m_ComponentType << " are not supported.";
+    }
+  }
+}
+
+mitk::USImageLogReader::USImageLogReader()
+  : itk::Object()
+{
+}
+
+mitk::USImageLogReader::~USImageLogReader()
+{
+}
+
+void mitk::USImageLogReader::Open(const std::string& fileName)
+{
+  this->Close();
+
+  m_FileStream.open(fileName.c_str(), std::ios::in | std::ios::binary);
+  if (!m_FileStream.good())
+  {
+    m_FileStream.close();
+    mitkThrow() << "File '" << fileName << "' could not be opened for reading.";
+  }
+  m_FileName = fileName;
+
+  m_FileStream.seekg(0, std::ios::end);
+  const std::streamoff fileSize = m_FileStream.tellg();
+  m_FileStream.seekg(0, std::ios::beg);
+
+  USImageLogFormat::FileHeader fileHeader;
+  m_FileStream.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+  if (!m_FileStream.good() || std::memcmp(fileHeader.m_Magic, USImageLogFormat::Magic, sizeof(fileHeader.m_Magic)) != 0)
+  {
+    this->Close();
+    mitkThrow() << "'" << fileName << "' is not an ultrasound image log.";
+  }
+  if (fileHeader.m_ByteOrderMark != USImageLogFormat::ByteOrderMark || fileHeader.m_Version != USImageLogFormat::Version)
+  {
+    this->Close();
+    mitkThrow() << "'" << fileName << "' was written in an unsupported version or byte order.";
+  }
+
+  while (true)
+  {
+    USImageLogFormat::RecordHeader recordHeader;
+    m_FileStream.read(reinterpret_cast<char*>(&recordHeader), sizeof(recordHeader));
+    const std::streamoff position = m_FileStream.tellg();
+    if (!m_FileStream.good() || static_cast<std::uint64_t>(fileSize - position) < recordHeader.m_Size)
+      break;
+
+    if (recordHeader.m_Type == USImageLogFormat::ImageRecord && recordHeader.m_Size >= sizeof(USImageLogFormat::ImageHeader))
+    {
+      ImageEntry entry;
+      m_FileStream.read(reinterpret_cast<char*>(&entry.m_Header), sizeof(entry.m_Header));
+      entry.m_DataPosition = position + static_cast<std::streamoff>(sizeof(entry.m_Header));
+      entry.m_CompressedSize = recordHeader.m_Size - sizeof(entry.m_Header);
+      m_Images.push_back(entry);
+    }
+    else if (recordHeader.m_Type == USImageLogFormat::MessageRecord)
+    {
+      std::string message(static_cast<std::size_t>(recordHeader.m_Size), '\0');
+      m_FileStream.read(&message[0], message.size());
+      m_Messages[recordHeader.m_ImageIndex].push_back(message);
+    }
+
+    // records of unknown types are skipped
+    m_FileStream.seekg(position + static_cast<std::streamoff>(recordHeader.m_Size), std::ios::beg);
+  }
+
+  // the end of the file was reached, further reads need a good stream
+  m_FileStream.clear();
+}
+
+void mitk::USImageLogReader::Close()
+{
+  if (m_FileStream.is_open())
+    m_FileStream.close();
+  m_FileStream.clear();
+  m_Images.clear();
+  m_Messages.clear();
+}
+
+unsigned int mitk::USImageLogReader::GetNumberOfImages() const
+{
+  return static_cast<unsigned int>(m_Images.size());
+}
+
+double mitk::USImageLogReader::GetTimeStamp(unsigned int index) const
+{
+  this->CheckIndex(index);
+  return m_Images[index].m_Header.m_TimeStamp;
+}
+
+std::vector<std::string> mitk::USImageLogReader::GetMessages(unsigned int index) const
+{
+  this->CheckIndex(index);
+  std::map<unsigned int, std::vector<std::string> >::const_iterator it = m_Messages.find(index);
+  if (it == m_Messages.end())
+    return std::vector<std::string>();
+  return it->second;
+}
+
+mitk::Image::Pointer mitk::USImageLogReader::GetImage(unsigned int index)
+{
+  this->CheckIndex(index);
+  const ImageEntry& entry = m_Images[index];
+  const USImageLogFormat::ImageHeader& header = entry.m_Header;
+
+  m_CompressedData.resize(static_cast<std::size_t>(entry.m_CompressedSize));
+  m_FileStream.seekg(entry.m_DataPosition, std::ios::beg);
+  m_FileStream.read(reinterpret_cast<char*>(m_CompressedData.data()), m_CompressedData.size());
+  if (!m_FileStream.good())
+  {
+    m_FileStream.clear();
+    mitkThrow() << "Reading image " << index << " from '" << m_FileName << "' failed.";
+  }
+
+  m_Data.resize(static_cast<std::size_t>(header.m_DataSize));
+  ::uLongf dataSize = static_cast< ::uLongf>(m_Data.size());
+  int zlibRetVal = ::uncompress(reinterpret_cast< ::Bytef*>(m_Data.data()), &dataSize,
+    m_CompressedData.data(), static_cast< ::uLong>(m_CompressedData.size()));
+  if (zlibRetVal != Z_OK || dataSize != m_Data.size())
+  {
+    mitkThrow() << "Decompressing image " << index << " from '" << m_FileName << "' failed with zlib error " << zlibRetVal << ".";
+  }
+
+  mitk::Image::Pointer image = mitk::Image::New();
+  image->Initialize(MakeLoggedPixelType(header), header.m_Dimension, header.m_Dimensions);
+
+  mitk::AffineTransform3D::MatrixType matrix;
+  mitk::AffineTransform3D::OutputVectorType offset;
+  for (unsigned int row = 0; row < 3; ++row)
+  {
+    for (unsigned int column = 0; column < 3; ++column)
+      matrix[row][column] = header.m_Matrix[row * 3 + column];
+    offset[row] = header.m_Offset[row];
+  }
+
+  const std::size_t volumeSize = m_Data.size() / image->GetTimeSteps();
+  for (unsigned int t = 0; t < image->GetTimeSteps(); ++t)
+  {
+    mitk::AffineTransform3D::Pointer transform = mitk::AffineTransform3D::New();
+    transform->SetMatrix(matrix);
+    transform->SetOffset(offset);
+    image->GetGeometry(t)->SetIndexToWorldTransform(transform);
+    image->SetImportVolume(&m_Data[t * volumeSize], t);
+  }
+
+  return image;
+}
+
+void mitk::USImageLogReader::CheckIndex(unsigned int index) const
+{
+  if (index >= m_Images.size())
+  {
+    mitkThrow() << "Image " << index << " was requested, but the log contains only " << m_Images.size() << " images.";
+  }
+}
@@ -0,0 +1,94 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSIMAGELOGREADER_H_HEADER_INCLUDED_
+#define MITKUSIMAGELOGREADER_H_HEADER_INCLUDED_
+
+#include <MitkUSExports.h>
+#include "mitkUSImageLogFormat.h"
+#include <mitkImage.h>
+#include <itkObject.h>
+
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace mitk {
+  /**
+  * \brief Reads the files written by mitk::USImageLogStreamWriter.
+  *
+  * Open() only reads the headers of all records, an image is read and decompressed
+  * when it is requested by GetImage(). A record which was not written completely,
+  * e.g. because the application crashed during logging, is ignored.
+  *
+  * All methods throw mitk::Exception if the file cannot be read.
+  *
+  * \ingroup US
+  */
+  class MITKUS_EXPORT USImageLogReader : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageLogReader, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /**
+    * \brief Opens the file and reads the time stamps and messages of all images.
+    */
+    void Open(const std::string& fileName);
+
+    void Close();
+
+    unsigned int GetNumberOfImages() const;
+
+    /**
+    * \brief Returns the system time stamp which was logged together with the image.
+    */
+    double GetTimeStamp(unsigned int index) const;
+
+    /**
+    * \brief Returns all messages which were added to the image, in the order they were added.
+    */
+    std::vector<std::string> GetMessages(unsigned int index) const;
+
+    /**
+    * \brief Reads and decompresses the image with the given index.
+    */
+    mitk::Image::Pointer GetImage(unsigned int index);
+
+  protected:
+    USImageLogReader();
+    virtual ~USImageLogReader();
+
+    struct ImageEntry
+    {
+      USImageLogFormat::ImageHeader m_Header;
+      std::streamoff m_DataPosition;   ///< position of the compressed pixel data in the file
+      std::uint64_t m_CompressedSize;
+    };
+
+    void CheckIndex(unsigned int index) const;
+
+    std::ifstream m_FileStream;
+    std::string m_FileName;
+    std::vector<ImageEntry> m_Images;
+    std::map<unsigned int, std::vector<std::string> > m_Messages;
+
+    std::vector<unsigned char> m_CompressedData; ///< reused for every image
+    std::vector<char> m_Data;                    ///< reused for every image
+  };
+} // namespace mitk
+
+#endif // MITKUSIMAGELOGREADER_H_HEADER_INCLUDED_
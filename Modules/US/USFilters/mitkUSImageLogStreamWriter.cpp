@@ -0,0 +1,190 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageLogStreamWriter.h"
+#include <mitkExceptionMacro.h>
+#include <mitkImageReadAccessor.h>
+
+#include "itk_zlib.h"
+
+#include <cstring>
+
+mitk::USImageLogStreamWriter::USImageLogStreamWriter()
+  : itk::Object(), m_NumberOfImages(0), m_CompressionLevel(1)
+{
+}
+
+mitk::USImageLogStreamWriter::~USImageLogStreamWriter()
+{
+  try
+  {
+    this->Close();
+  }
+  catch (const mitk::Exception& e)
+  {
+    MITK_ERROR("USImageLogStreamWriter") << e.GetDescription();
+  }
+}
+
+void mitk::USImageLogStreamWriter::CopyImage(const mitk::Image* image, double timeStamp, Frame& frame)
+{
+  if (image == nullptr || !image->IsInitialized())
+  {
+    mitkThrow() << "Cannot log an image which is not initialized.";
+  }
+  if (image->GetDimension() > 4)
+  {
+    mitkThrow() << "Cannot log an image with " << image->GetDimension() << " dimensions.";
+  }
+
+  USImageLogFormat::ImageHeader& header = frame.m_Header;
+  header.m_TimeStamp = timeStamp;
+
+  const mitk::AffineTransform3D* transform = image->GetGeometry()->GetIndexToWorldTransform();
+  for (unsigned int row = 0; row < 3; ++row)
+  {
+    for (unsigned int column = 0; column < 3; ++column)
+      header.m_Matrix[row * 3 + column] = transform->GetMatrix()[row][column];
+    header.m_Offset[row] = transform->GetOffset()[row];
+  }
+
+  const mitk::PixelType pixelType = image->GetPixelType();
+  header.m_ComponentType = static_cast<std::uint32_t>(pixelType.GetComponentType());
+  header.m_PixelType = static_cast<std::uint32_t>(pixelType.GetPixelType());
+  header.m_NumberOfComponents = static_cast<std::uint32_t>(pixelType.GetNumberOfComponents());
+  header.m_Dimension = image->GetDimension();
+
+  std::uint64_t dataSize = pixelType.GetSize();
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    header.m_Dimensions[i] = i < header.m_Dimension ? image->GetDimension(i) : 1;
+    dataSize *= header.m_Dimensions[i];
+  }
+  header.m_DataSize = dataSize;
+
+  // the capacity of a reused frame is kept, so this does not allocate for images of the same size
+  frame.m_Data.resize(static_cast<std::size_t>(dataSize));
+  mitk::ImageReadAccessor accessor(image);
+  std::memcpy(frame.m_Data.data(), accessor.GetData(), frame.m_Data.size());
+}
+
+void mitk::USImageLogStreamWriter::Open(const std::string& fileName)
+{
+  this->Close();
+
+  m_FileStream.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_FileStream.good())
+  {
+    m_FileStream.close();
+    mitkThrow() << "File '" << fileName << "' could not be opened for writing.";
+  }
+  m_FileName = fileName;
+  m_NumberOfImages = 0;
+
+  USImageLogFormat::FileHeader header;
+  std::memcpy(header.m_Magic, USImageLogFormat::Magic, sizeof(header.m_Magic));
+  header.m_ByteOrderMark = USImageLogFormat::ByteOrderMark;
+  header.m_Version = USImageLogFormat::Version;
+  this->WriteBytes(&header, sizeof(header));
+}
+
+void mitk::USImageLogStreamWriter::AddImage(const mitk::Image* image, double timeStamp)
+{
+  CopyImage(image, timeStamp, m_Frame);
+  this->AddFrame(m_Frame);
+}
+
+void mitk::USImageLogStreamWriter::AddFrame(const Frame& frame)
+{
+  if (!this->IsOpen())
+  {
+    mitkThrow() << "Cannot write image, no file is open.";
+  }
+
+  ::uLongf compressedSize = ::compressBound(static_cast< ::uLong>(frame.m_Data.size()));
+  m_CompressedData.resize(compressedSize);
+  int zlibRetVal = ::compress2(m_CompressedData.data(), &compressedSize,
+    reinterpret_cast<const ::Bytef*>(frame.m_Data.data()), static_cast< ::uLong>(frame.m_Data.size()), m_CompressionLevel);
+  if (zlibRetVal != Z_OK)
+  {
+    mitkThrow() << "Compressing image " << m_NumberOfImages << " failed with zlib error " << zlibRetVal << ".";
+  }
+
+  USImageLogFormat::RecordHeader recordHeader;
+  recordHeader.m_Type = USImageLogFormat::ImageRecord;
+  recordHeader.m_ImageIndex = m_NumberOfImages;
+  recordHeader.m_Size = sizeof(frame.m_Header) + compressedSize;
+
+  this->WriteBytes(&recordHeader, sizeof(recordHeader));
+  this->WriteBytes(&frame.m_Header, sizeof(frame.m_Header));
+  this->WriteBytes(m_CompressedData.data(), compressedSize);
+
+  ++m_NumberOfImages;
+}
+
+void mitk::USImageLogStreamWriter::AddMessage(unsigned int imageIndex, const std::string& message)
+{
+  if (!this->IsOpen())
+  {
+    mitkThrow() << "Cannot write message, no file is open.";
+  }
+
+  USImageLogFormat::RecordHeader recordHeader;
+  recordHeader.m_Type = USImageLogFormat::MessageRecord;
+  recordHeader.m_ImageIndex = imageIndex;
+  recordHeader.m_Size = message.size();
+
+  this->WriteBytes(&recordHeader, sizeof(recordHeader));
+  this->WriteBytes(message.data(), message.size());
+}
+
+void mitk::USImageLogStreamWriter::WriteBytes(const void* data, std::size_t length)
+{
+  m_FileStream.write(static_cast<const char*>(data), length);
+  if (!m_FileStream.good())
+  {
+    mitkThrow() << "Writing to '" << m_FileName << "' failed.";
+  }
+}
+
+void mitk::USImageLogStreamWriter::Flush()
+{
+  if (this->IsOpen())
+    m_FileStream.flush();
+}
+
+void mitk::USImageLogStreamWriter::Close()
+{
+  if (!this->IsOpen())
+    return;
+
+  m_FileStream.close();
+  if (m_FileStream.fail())
+  {
+    m_FileStream.clear();
+    mitkThrow() << "Closing '" << m_FileName << "' failed.";
+  }
+}
+
+bool mitk::USImageLogStreamWriter::IsOpen() const
+{
+  return m_FileStream.is_open();
+}
+
+unsigned int mitk::USImageLogStreamWriter::GetNumberOfImages() const
+{
+  return m_NumberOfImages;
+}
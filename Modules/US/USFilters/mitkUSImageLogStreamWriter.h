@@ -0,0 +1,113 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSIMAGELOGSTREAMWRITER_H_HEADER_INCLUDED_
+#define MITKUSIMAGELOGSTREAMWRITER_H_HEADER_INCLUDED_
+
+#include <MitkUSExports.h>
+#include "mitkUSImageLogFormat.h"
+#include <mitkImage.h>
+#include <itkObject.h>
+
+#include <fstream>
+#include <vector>
+
+namespace mitk {
+  /**
+  * \brief Appends images, their time stamps and messages to a file in the format described in mitk::USImageLogFormat.
+  *
+  * Each image is compressed and written as soon as it is added, nothing is kept in memory. The
+  * files are read with mitk::USImageLogReader.
+  *
+  * All methods throw mitk::Exception if the file cannot be written.
+  *
+  * \ingroup US
+  */
+  class MITKUS_EXPORT USImageLogStreamWriter : public itk::Object
+  {
+  public:
+    mitkClassMacroItkParent(USImageLogStreamWriter, itk::Object);
+    itkFactorylessNewMacro(Self)
+
+    /**
+    * \brief Description and uncompressed pixel data of one image.
+    *
+    * A frame can be filled by CopyImage() and written later, so that the image itself
+    * may change in the meantime. The data vector keeps its capacity when a frame is reused.
+    */
+    struct Frame
+    {
+      USImageLogFormat::ImageHeader m_Header;
+      std::vector<char> m_Data;
+    };
+
+    /**
+    * \brief Copies description and pixel data of the image into the frame.
+    */
+    static void CopyImage(const mitk::Image* image, double timeStamp, Frame& frame);
+
+    /**
+    * \brief Creates the file and writes the header. A previously opened file is closed first.
+    */
+    void Open(const std::string& fileName);
+
+    /**
+    * \brief Appends an image with the given time stamp.
+    */
+    void AddImage(const mitk::Image* image, double timeStamp);
+
+    /**
+    * \brief Appends an image which was copied into a frame before.
+    */
+    void AddFrame(const Frame& frame);
+
+    /**
+    * \brief Appends a message which belongs to the image with the given index.
+    */
+    void AddMessage(unsigned int imageIndex, const std::string& message);
+
+    /** \brief Writes buffered data to the file. */
+    void Flush();
+
+    /** \brief Flushes and closes the file. Does nothing if no file is open. */
+    void Close();
+
+    bool IsOpen() const;
+
+    /** \brief Returns the number of images written since the file was opened. */
+    unsigned int GetNumberOfImages() const;
+
+    /** \brief zlib compression level from 0 (no compression) to 9 (best compression), default is 1. */
+    itkSetClampMacro(CompressionLevel, int, 0, 9);
+    itkGetConstMacro(CompressionLevel, int);
+
+  protected:
+    USImageLogStreamWriter();
+    virtual ~USImageLogStreamWriter();
+
+    void WriteBytes(const void* data, std::size_t length);
+
+    std::ofstream m_FileStream;
+    std::string m_FileName;
+    unsigned int m_NumberOfImages;
+    int m_CompressionLevel;
+
+    Frame m_Frame;                          ///< reused by AddImage()
+    std::vector<unsigned char> m_CompressedData; ///< reused for every image
+  };
+} // namespace mitk
+
+#endif // MITKUSIMAGELOGSTREAMWRITER_H_HEADER_INCLUDED_
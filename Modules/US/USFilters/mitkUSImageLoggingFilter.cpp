@@ -26,12 +26,22 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 mitk::USImageLoggingFilter::USImageLoggingFilter() : m_SystemTimeClock(RealTimeClock::New()),
-                                                     m_ImageExtension(".nrrd")
+                                                     m_ImageExtension(".nrrd"),
+                                                     m_MaxNumberOfPendingImages(32),
+                                                     m_CompressionLevel(1),
+                                                     m_MultiThreader(itk::MultiThreader::New()),
+                                                     m_ThreadID(-1),
+                                                     m_EntryAvailable(itk::ConditionVariable::New()),
+                                                     m_NumberOfPendingImages(0),
+                                                     m_StopWriterThread(false),
+                                                     m_NumberOfStreamedImages(0),
+                                                     m_NumberOfDroppedImages(0)
 {
 }
 
 mitk::USImageLoggingFilter::~USImageLoggingFilter()
 {
+  this->StopStreaming();
 }
 
 void mitk::USImageLoggingFilter::GenerateData()
@@ -45,6 +55,51 @@ void mitk::USImageLoggingFilter::GenerateData()
     return;
     }
 
+  if (this->IsStreaming())
+    {
+    double timeStamp = m_SystemTimeClock->GetCurrentStamp();
+
+    // devices overwrite their output image with the next frame, so the pixel data is copied
+    // into a frame that was already written; compression and writing is left to the writer thread
+    std::unique_ptr<Frame> frame;
+    m_EntryMutex.Lock();
+    bool dropped = m_NumberOfPendingImages >= m_MaxNumberOfPendingImages;
+    if (dropped)
+      {
+      ++m_NumberOfDroppedImages;
+      }
+    else if (!m_FreeFrames.empty())
+      {
+      frame = std::move(m_FreeFrames.back());
+      m_FreeFrames.pop_back();
+      }
+    m_EntryMutex.Unlock();
+
+    if (dropped)
+      {
+      MITK_WARN << "Writing the image log cannot keep up, dropped an image.";
+      return;
+      }
+
+    if (!frame)
+      frame.reset(new Frame);
+
+    try
+      {
+      mitk::USImageLogStreamWriter::CopyImage(inputImage, timeStamp, *frame);
+      }
+    catch (const mitk::Exception& e)
+      {
+      MITK_WARN << "Cannot log image: " << e.GetDescription();
+      return;
+      }
+
+    LogEntry entry;
+    entry.m_Frame = std::move(frame);
+    this->HandOverEntry(entry);
+    return;
+    }
+
   //a clone is needed for a output and to store it.
   mitk::Image::Pointer inputClone = inputImage->Clone();
 
@@ -83,6 +138,20 @@ void mitk::USImageLoggingFilter::GenerateData()
 
 void mitk::USImageLoggingFilter::AddMessageToCurrentImage(std::string message)
 {
+  if (this->IsStreaming())
+  {
+    if (this->GetNumberOfStreamedImages() == 0)
+    {
+      MITK_WARN << "No image was logged yet, ignoring message \"" << message << "\".";
+      return;
+    }
+
+    LogEntry entry;
+    entry.m_Message = message;
+    this->HandOverEntry(entry);
+    return;
+  }
+
   m_LoggedMessages.insert(std::make_pair(static_cast<int>(m_LoggedImages.size()-1),message));
 }
 
@@ -163,3 +232,151 @@ bool mitk::USImageLoggingFilter::SetImageFilesExtension(std::string extension)
   }
   return false;
  }
+
+void mitk::USImageLoggingFilter::StartStreaming(const std::string& fileName)
+{
+  this->StopStreaming();
+
+  mitk::USImageLogStreamWriter::Pointer streamWriter = mitk::USImageLogStreamWriter::New();
+  streamWriter->SetCompressionLevel(m_CompressionLevel);
+  streamWriter->Open(fileName);
+  m_StreamWriter = streamWriter;
+
+  m_StopWriterThread = false;
+  m_NumberOfPendingImages = 0;
+  m_NumberOfStreamedImages = 0;
+  m_NumberOfDroppedImages = 0;
+
+  m_ThreadID = m_MultiThreader->SpawnThread(this->ThreadStartWriting, this);
+}
+
+void mitk::USImageLoggingFilter::StopStreaming()
+{
+  if (!this->IsStreaming())
+    return;
+
+  m_EntryMutex.Lock();
+  m_StopWriterThread = true;
+  m_EntryMutex.Unlock();
+  m_EntryAvailable->Broadcast();
+
+  // waits until the thread wrote the remaining entries
+  m_MultiThreader->TerminateThread(m_ThreadID);
+  m_ThreadID = -1;
+
+  try
+  {
+    m_StreamWriter->Close();
+  }
+  catch (const mitk::Exception& e)
+  {
+    MITK_ERROR << "Closing the image log failed: " << e.GetDescription();
+  }
+  m_StreamWriter = nullptr;
+  m_FreeFrames.clear();
+}
+
+bool mitk::USImageLoggingFilter::IsStreaming() const
+{
+  return m_ThreadID >= 0;
+}
+
+unsigned long mitk::USImageLoggingFilter::GetNumberOfStreamedImages()
+{
+  m_EntryMutex.Lock();
+  unsigned long numberOfStreamedImages = m_NumberOfStreamedImages;
+  m_EntryMutex.Unlock();
+  return numberOfStreamedImages;
+}
+
+unsigned long mitk::USImageLoggingFilter::GetNumberOfDroppedImages()
+{
+  m_EntryMutex.Lock();
+  unsigned long numberOfDroppedImages = m_NumberOfDroppedImages;
+  m_EntryMutex.Unlock();
+  return numberOfDroppedImages;
+}
+
+void mitk::USImageLoggingFilter::HandOverEntry(LogEntry& entry)
+{
+  m_EntryMutex.Lock();
+  if (entry.m_Frame)
+  {
+    entry.m_ImageIndex = m_NumberOfStreamedImages++;
+    ++m_NumberOfPendingImages;
+  }
+  else
+  {
+    // messages belong to the last image
+    entry.m_ImageIndex = m_NumberOfStreamedImages - 1;
+  }
+  m_PendingEntries.push_back(std::move(entry));
+  m_EntryMutex.Unlock();
+  m_EntryAvailable->Signal();
+}
+
+ITK_THREAD_RETURN_TYPE mitk::USImageLoggingFilter::ThreadStartWriting(void* pInfoStruct)
+{
+  /* extract this pointer from Thread Info structure */
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+  if (pInfo == nullptr)
+  {
+    return ITK_THREAD_RETURN_VALUE;
+  }
+  USImageLoggingFilter* filter = static_cast<USImageLoggingFilter*>(pInfo->UserData);
+  if (filter != nullptr)
+  {
+    filter->WriteEntries();
+  }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::USImageLoggingFilter::WriteEntries()
+{
+  bool failed = false;
+
+  m_EntryMutex.Lock();
+  while (true)
+  {
+    while (m_PendingEntries.empty() && !m_StopWriterThread)
+      m_EntryAvailable->Wait(&m_EntryMutex);
+
+    // only stop after all entries are written
+    if (m_PendingEntries.empty())
+      break;
+
+    LogEntry entry = std::move(m_PendingEntries.front());
+    m_PendingEntries.pop_front();
+    bool flush = m_PendingEntries.empty();
+    m_EntryMutex.Unlock();
+
+    if (!failed)
+    {
+      try
+      {
+        if (entry.m_Frame)
+          m_StreamWriter->AddFrame(*entry.m_Frame);
+        else
+          m_StreamWriter->AddMessage(entry.m_ImageIndex, entry.m_Message);
+
+        // whenever the writer caught up, everything logged so far is on the disk
+        if (flush)
+          m_StreamWriter->Flush();
+      }
+      catch (const mitk::Exception& e)
+      {
+        // the logging goes on, but nothing more is written
+        MITK_ERROR << "Writing the image log failed: " << e.GetDescription();
+        failed = true;
+      }
+    }
+
+    m_EntryMutex.Lock();
+    if (entry.m_Frame)
+    {
+      --m_NumberOfPendingImages;
+      m_FreeFrames.push_back(std::move(entry.m_Frame));
+    }
+  }
+  m_EntryMutex.Unlock();
+}
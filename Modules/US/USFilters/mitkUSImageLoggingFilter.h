@@ -21,7 +21,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <MitkUSExports.h>
 #include <mitkImageToImageFilter.h>
 #include <mitkRealTimeClock.h>
+#include "mitkUSImageLogStreamWriter.h"
 
+#include <itkConditionVariable.h>
+#include <itkMultiThreader.h>
+#include <itkMutexLock.h>
+
+#include <deque>
+#include <memory>
 
 namespace mitk {
   /** An object of this class is a filter which saves/logs a clone of the current image whenever
@@ -29,6 +36,13 @@ namespace mitk {
    *  add messages. All data (images, timestamps and messages) is written to the harddisc when
    *  the method SaveImages(...) is called.
    *
+   *  For long acquisitions, call StartStreaming(...) instead. No image is kept in memory then: Update()
+   *  only copies the pixel data into a reused buffer and hands it to a writer thread, which compresses
+   *  the images and appends them together with their timestamps and messages to a single file
+   *  (see mitk::USImageLogStreamWriter, read it with mitk::USImageLogReader). If the writer falls behind
+   *  by more than MaxNumberOfPendingImages images, further images are dropped and counted by
+   *  GetNumberOfDroppedImages().
+   *
    *  Caution: only supports logging of one input at the moment, multiple inputs are ignored!
    *
    *  \ingroup US
@@ -50,6 +64,32 @@ namespace mitk {
      */
     void AddMessageToCurrentImage(std::string message);
 
+    /** Opens the given file and starts the writer thread. From now on, every Update() appends the image to
+     *  this file instead of keeping it in memory, and messages are written next to the images. Images
+     *  logged before are not written to the file, they can still be saved with SaveImages(...).
+     *  @throw mitk::Exception Throws an exception if the file cannot be opened.
+     */
+    void StartStreaming(const std::string& fileName);
+
+    /** Writes all pending images, stops the writer thread and closes the file. Called by the destructor. */
+    void StopStreaming();
+
+    bool IsStreaming() const;
+
+    /** Returns the number of images handed to the writer thread since StartStreaming(...) was called. */
+    unsigned long GetNumberOfStreamedImages();
+
+    /** Returns the number of images which were dropped because the writer thread could not keep up. */
+    unsigned long GetNumberOfDroppedImages();
+
+    /** Maximum number of images waiting for the writer thread, default is 32. */
+    itkSetMacro(MaxNumberOfPendingImages, unsigned int);
+    itkGetMacro(MaxNumberOfPendingImages, unsigned int);
+
+    /** zlib compression level of the streamed images from 0 to 9, default is 1. Takes effect with the next StartStreaming(...). */
+    itkSetClampMacro(CompressionLevel, int, 0, 9);
+    itkGetMacro(CompressionLevel, int);
+
     /** Saves all logged data to the given path. Every image is written to a separate image file.
      *  Additionaly a csv file containing a list of all images together with timestamps and messages is saved.
      *  For one call of this method all files will start with a unique number to avoid overwrite of old files.
@@ -89,6 +129,39 @@ namespace mitk {
     std::vector<double> m_LoggedMITKSystemTimes; ///< Logged system times for every logged image
     std::string m_ImageExtension; ///< stores the image extension, default is ".nrrd"
 
+    //members for streaming
+    typedef mitk::USImageLogStreamWriter::Frame Frame;
+
+    /** An image or a message which waits for the writer thread. */
+    struct LogEntry
+    {
+      std::unique_ptr<Frame> m_Frame; ///< NULL for a message
+      unsigned int m_ImageIndex;
+      std::string m_Message;
+    };
+
+    static ITK_THREAD_RETURN_TYPE ThreadStartWriting(void* data);
+
+    /** Body of the writer thread, writes entries until StopStreaming() is called. */
+    void WriteEntries();
+
+    void HandOverEntry(LogEntry& entry);
+
+    unsigned int m_MaxNumberOfPendingImages;
+    int m_CompressionLevel;
+    mitk::USImageLogStreamWriter::Pointer m_StreamWriter;
+    itk::MultiThreader::Pointer m_MultiThreader;
+    int m_ThreadID;
+
+    itk::SimpleMutexLock m_EntryMutex;             ///< guards all members below
+    itk::ConditionVariable::Pointer m_EntryAvailable;
+    std::deque<LogEntry> m_PendingEntries;
+    std::vector<std::unique_ptr<Frame> > m_FreeFrames; ///< written frames, reused to avoid allocations
+    unsigned int m_NumberOfPendingImages;
+    bool m_StopWriterThread;
+    unsigned long m_NumberOfStreamedImages;
+    unsigned long m_NumberOfDroppedImages;
+
   };
 } // namespace mitk
 #endif /* MITKUSImageSource_H_HEADER_INCLUDED_ */
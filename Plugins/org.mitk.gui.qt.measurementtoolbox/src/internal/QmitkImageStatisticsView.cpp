@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <qclipboard.h>
 #include <qscrollbar.h>
 #include <QVector>
+#include <QTimer>
 
 // berry includes
 #include <berryIWorkbenchPage.h>
@@ -47,12 +48,19 @@ QmitkImageStatisticsView::QmitkImageStatisticsView(QObject* /*parent*/, const ch
   m_ImageMaskObserverTag( -1 ),
   m_PlanarFigureObserverTag( -1 ),
   m_TimeObserverTag( -1 ),
+  m_IncrementalCalculatorObserverTag( -1 ),
+  m_FullStatisticsUpdateTimer( NULL ),
   m_CurrentStatisticsValid( false ),
   m_StatisticsUpdatePending( false ),
   m_DataNodeSelectionChanged ( false ),
   m_Visible(false)
 {
   this->m_CalculationThread = new QmitkImageStatisticsCalculationThread;
+
+  // while a mask is edited, the incremental statistics are shown and the full calculation waits for a pause
+  m_FullStatisticsUpdateTimer = new QTimer(this);
+  m_FullStatisticsUpdateTimer->setSingleShot(true);
+  m_FullStatisticsUpdateTimer->setInterval(1000);
 }
 
 QmitkImageStatisticsView::~QmitkImageStatisticsView()
@@ -63,6 +71,7 @@ QmitkImageStatisticsView::~QmitkImageStatisticsView()
     m_SelectedImageMask->RemoveObserver( m_ImageMaskObserverTag );
   if ( m_SelectedPlanarFigure != NULL )
     m_SelectedPlanarFigure->RemoveObserver( m_PlanarFigureObserverTag );
+  this->RemoveIncrementalStatisticsCalculator();
 
   while(this->m_CalculationThread->isRunning()) // wait until thread has finished
   {
@@ -99,6 +108,7 @@ void QmitkImageStatisticsView::CreateConnections()
     connect( (QObject*) (this->m_Controls->m_lineRadioButton), SIGNAL(clicked()), (QObject*) (this->m_Controls->m_JSHistogram), SLOT(OnLineRadioButtonSelected()));
     connect( (QObject*) (this->m_Controls->m_HistogramBinSizeSpinbox), SIGNAL(editingFinished()), this, SLOT(OnHistogramBinSizeBoxValueChanged()));
     connect( (QObject*)(this->m_Controls->m_UseDefaultBinSizeBox), SIGNAL(clicked()),(QObject*) this, SLOT(OnDefaultBinSizeBoxChanged()) );
+    connect( m_FullStatisticsUpdateTimer, SIGNAL(timeout()), this, SLOT(OnFullStatisticsUpdateTimeout()) );
   }
 }
 
@@ -491,6 +501,7 @@ void QmitkImageStatisticsView::ReinitData()
     this->m_SelectedPlanarFigure->RemoveObserver( this->m_PlanarFigureObserverTag);
     this->m_SelectedPlanarFigure = NULL;
   }
+  this->RemoveIncrementalStatisticsCalculator();
   this->m_SelectedDataNodes.clear();
   this->m_StatisticsUpdatePending = false;
 
@@ -534,6 +545,10 @@ void QmitkImageStatisticsView::UpdateStatistics()
   // reset data from last run
   ITKCommandType::Pointer changeListener = ITKCommandType::New();
   changeListener->SetCallbackFunction( this, &QmitkImageStatisticsView::SelectedDataModified );
+  ITKCommandType::Pointer imageChangeListener = ITKCommandType::New();
+  imageChangeListener->SetCallbackFunction( this, &QmitkImageStatisticsView::SelectedImageModified );
+  ITKCommandType::Pointer maskChangeListener = ITKCommandType::New();
+  maskChangeListener->SetCallbackFunction( this, &QmitkImageStatisticsView::SelectedImageMaskModified );
 
   mitk::DataNode::Pointer planarFigureNode;
   for( int i= 0 ; i < this->m_SelectedDataNodes.size(); ++i)
@@ -548,7 +563,7 @@ void QmitkImageStatisticsView::UpdateStatistics()
       if( this->m_SelectedImageMask == NULL && isMask)
       {
         this->m_SelectedImageMask = dynamic_cast<mitk::Image*>(this->m_SelectedDataNodes.at(i)->GetData());
-        this->m_ImageMaskObserverTag = this->m_SelectedImageMask->AddObserver(itk::ModifiedEvent(), changeListener);
+        this->m_ImageMaskObserverTag = this->m_SelectedImageMask->AddObserver(itk::ModifiedEvent(), maskChangeListener);
 
         maskName = this->m_SelectedDataNodes.at(i)->GetName();
         maskType = m_SelectedImageMask->GetNameOfClass();
@@ -559,7 +574,7 @@ void QmitkImageStatisticsView::UpdateStatistics()
         if(this->m_SelectedImage == NULL)
         {
           this->m_SelectedImage = static_cast<mitk::Image*>(this->m_SelectedDataNodes.at(i)->GetData());
-          this->m_ImageObserverTag = this->m_SelectedImage->AddObserver(itk::ModifiedEvent(), changeListener);
+          this->m_ImageObserverTag = this->m_SelectedImage->AddObserver(itk::ModifiedEvent(), imageChangeListener);
         }
         featureImageName = this->m_SelectedDataNodes.at(i)->GetName();
       }
@@ -615,7 +630,7 @@ void QmitkImageStatisticsView::UpdateStatistics()
           if(this->m_SelectedImage == NULL)
           {
             this->m_SelectedImage = static_cast<mitk::Image*>(node->GetData());
-            this->m_ImageObserverTag = this->m_SelectedImage->AddObserver(itk::ModifiedEvent(), changeListener);
+            this->m_ImageObserverTag = this->m_SelectedImage->AddObserver(itk::ModifiedEvent(), imageChangeListener);
           }
         }
       }
@@ -682,6 +697,8 @@ void QmitkImageStatisticsView::UpdateStatistics()
           QString(")"));
     }
 
+    this->UpdateIncrementalStatisticsCalculator( timeStep );
+
     //// initialize thread and trigger it
     this->m_CalculationThread->SetIgnoreZeroValueVoxel( m_Controls->m_IgnoreZerosCheckbox->isChecked() );
     this->m_CalculationThread->Initialize( m_SelectedImage, m_SelectedImageMask, m_SelectedPlanarFigure );
@@ -741,6 +758,124 @@ void QmitkImageStatisticsView::SelectedDataModified()
   }
 }
 
+void QmitkImageStatisticsView::SelectedImageModified()
+{
+  // the incremental statistics refer to the old pixel values
+  this->RemoveIncrementalStatisticsCalculator();
+  this->SelectedDataModified();
+}
+
+void QmitkImageStatisticsView::SelectedImageMaskModified()
+{
+  // edits of the mask are followed by the incremental calculator, see IncrementalStatisticsModified()
+  if ( m_IncrementalCalculator.IsNull() )
+  {
+    this->SelectedDataModified();
+  }
+}
+
+void QmitkImageStatisticsView::UpdateIncrementalStatisticsCalculator( unsigned int timeStep )
+{
+  // the incremental calculator supports label masks of 3D images (or a time step of 3D+t images) without ignored pixels
+  bool useIncrementalCalculator = m_SelectedImage != NULL && m_SelectedImageMask != NULL && m_SelectedPlanarFigure == NULL
+      && m_SelectedImage->GetDimension() >= 3 && m_SelectedImage->GetTimeSteps() == m_SelectedImageMask->GetTimeSteps()
+      && !m_Controls->m_IgnoreZerosCheckbox->isChecked();
+
+  if ( !useIncrementalCalculator )
+  {
+    this->RemoveIncrementalStatisticsCalculator();
+    return;
+  }
+
+  if ( m_IncrementalCalculator.IsNull() )
+  {
+    // it is initialized by the first edit of the mask
+    m_IncrementalCalculator = mitk::IncrementalImageStatisticsCalculator::New();
+    m_IncrementalCalculator->SetImage( m_SelectedImage );
+    m_IncrementalCalculator->SetImageMask( m_SelectedImageMask );
+
+    ITKCommandType::Pointer incrementalListener = ITKCommandType::New();
+    incrementalListener->SetCallbackFunction( this, &QmitkImageStatisticsView::IncrementalStatisticsModified );
+    m_IncrementalCalculatorObserverTag = m_IncrementalCalculator->AddObserver( itk::ModifiedEvent(), incrementalListener );
+  }
+  m_IncrementalCalculator->SetTimeStep( timeStep );
+}
+
+void QmitkImageStatisticsView::RemoveIncrementalStatisticsCalculator()
+{
+  if ( m_IncrementalCalculator.IsNotNull() )
+  {
+    m_IncrementalCalculator->RemoveObserver( m_IncrementalCalculatorObserverTag );
+    m_IncrementalCalculator = NULL;
+  }
+  if ( m_FullStatisticsUpdateTimer != NULL )
+  {
+    m_FullStatisticsUpdateTimer->stop();
+  }
+}
+
+void QmitkImageStatisticsView::IncrementalStatisticsModified()
+{
+  if ( m_IncrementalCalculator.IsNull() )
+  {
+    return;
+  }
+
+  if ( !m_IncrementalCalculator->IsUpToDate() )
+  {
+    // the mask was changed in an unknown region, e.g. by a 3D tool, or before the first edit was tracked
+    m_FullStatisticsUpdateTimer->stop();
+    this->SelectedDataModified();
+    return;
+  }
+
+  // the table shows the statistics of the first label, like the full calculation does
+  const mitk::IncrementalImageStatisticsCalculator::StatisticsContainer statistics = m_IncrementalCalculator->GetStatistics();
+  const unsigned int t = m_IncrementalCalculator->GetTimeStep();
+  if ( statistics.empty() || !m_CurrentStatisticsValid || static_cast<int>(t) >= m_Controls->m_StatisticsTable->columnCount() )
+  {
+    this->SelectedDataModified();
+    return;
+  }
+
+  mitk::PixelType doublePix = mitk::MakeScalarPixelType< double >();
+  mitk::PixelType floatPix = mitk::MakeScalarPixelType< float >();
+  int decimals = 2;
+  if (m_SelectedImage->GetPixelType()==doublePix || m_SelectedImage->GetPixelType()==floatPix)
+  {
+    decimals = 5;
+  }
+  this->FillStatisticsTableColumn( statistics.front(), t, m_SelectedImage, decimals, false );
+
+  mitk::Point3D index;
+  if ( t < m_WorldMaxList.size() )
+  {
+    for ( unsigned int i = 0; i < 3; ++i )
+      index[i] = statistics.front().GetMaxIndex()[i];
+    m_SelectedImage->GetGeometry()->IndexToWorld(index, m_WorldMaxList[t]);
+  }
+  if ( t < m_WorldMinList.size() )
+  {
+    for ( unsigned int i = 0; i < 3; ++i )
+      index[i] = statistics.front().GetMinIndex()[i];
+    m_SelectedImage->GetGeometry()->IndexToWorld(index, m_WorldMinList[t]);
+  }
+
+  // median, histogram, entropy etc. follow once the editing pauses
+  m_FullStatisticsUpdateTimer->start();
+}
+
+void QmitkImageStatisticsView::OnFullStatisticsUpdateTimeout()
+{
+  if ( m_StatisticsUpdatePending )
+  {
+    // the calculation that is running has started before the last edit
+    m_FullStatisticsUpdateTimer->start();
+    return;
+  }
+  emit StatisticsUpdate();
+}
+
 void QmitkImageStatisticsView::NodeRemoved(const mitk::DataNode *node)
 {
   while(this->m_CalculationThread->isRunning()) // wait until thread has finished
@@ -928,73 +1063,7 @@ void QmitkImageStatisticsView::FillStatisticsTableView(
       this->m_WorldMinList.push_back(min);
     }
 
-    this->m_Controls->m_StatisticsTable->setItem( 0, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetMean(), 0, 'f', decimals) ) );
-    this->m_Controls->m_StatisticsTable->setItem( 1, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetMedian(), 0, 'f', decimals) ) );
-    this->m_Controls->m_StatisticsTable->setItem( 2, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetSigma(), 0, 'f', decimals) ) );
-    this->m_Controls->m_StatisticsTable->setItem( 3, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetRMS(), 0, 'f', decimals) ) );
-
-    QString max; max.append(QString("%1").arg(s[t].GetMax(), 0, 'f', decimals));
-    max += " (";
-    for (int i=0; i<s[t].GetMaxIndex().size(); i++)
-    {
-      max += QString::number(s[t].GetMaxIndex()[i]);
-      if (i<s[t].GetMaxIndex().size()-1)
-        max += ",";
-    }
-    max += ")";
-    this->m_Controls->m_StatisticsTable->setItem( 4, t, new QTableWidgetItem( max ) );
-
-    QString min; min.append(QString("%1").arg(s[t].GetMin(), 0, 'f', decimals));
-    min += " (";
-    for (int i=0; i<s[t].GetMinIndex().size(); i++)
-    {
-      min += QString::number(s[t].GetMinIndex()[i]);
-      if (i<s[t].GetMinIndex().size()-1)
-        min += ",";
-    }
-    min += ")";
-    this->m_Controls->m_StatisticsTable->setItem( 5, t, new QTableWidgetItem( min ) );
-
-    this->m_Controls->m_StatisticsTable->setItem( 6, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetN()) ) );
-
-    const mitk::BaseGeometry *geometry = image->GetGeometry();
-    if ( geometry != NULL )
-    {
-      const mitk::Vector3D &spacing = image->GetGeometry()->GetSpacing();
-      double volume = spacing[0] * spacing[1] * spacing[2] * (double) s[t].GetN();
-      this->m_Controls->m_StatisticsTable->setItem( 7, t, new QTableWidgetItem(
-          QString("%1").arg(volume, 0, 'f', decimals) ) );
-    }
-    else
-    {
-      this->m_Controls->m_StatisticsTable->setItem( 7, t, new QTableWidgetItem(
-          "NA" ) );
-    }
-
-    //statistics of higher order should have 5 decimal places because they used to be very small
-    this->m_Controls->m_StatisticsTable->setItem( 8, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetSkewness(), 0, 'f', 5) ) );
-
-    this->m_Controls->m_StatisticsTable->setItem( 9, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetKurtosis(), 0, 'f', 5) ) );
-
-    this->m_Controls->m_StatisticsTable->setItem( 10, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetUniformity(), 0, 'f', 5) ) );
-
-    this->m_Controls->m_StatisticsTable->setItem( 11, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetEntropy(), 0, 'f', 5) ) );
-
-    this->m_Controls->m_StatisticsTable->setItem( 12, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetMPP(), 0, 'f', decimals) ) );
-
-    this->m_Controls->m_StatisticsTable->setItem( 13, t, new QTableWidgetItem(
-        QString("%1").arg(s[t].GetUPP(), 0, 'f', 5) ) );
-
+    this->FillStatisticsTableColumn( s[t], t, image, decimals, true );
   }
 
 
@@ -1056,6 +1125,78 @@ void QmitkImageStatisticsView::FillStatisticsTableView(
   this->m_Controls->m_StatisticsTable->setItem( 9, t, new QTableWidgetItem( hotspotMin ) );*/
 }
 
+void QmitkImageStatisticsView::FillStatisticsTableColumn(
+    const mitk::ImageStatisticsCalculator::Statistics &s, unsigned int t,
+    const mitk::Image *image, int decimals, bool histogramStatisticsValid )
+{
+  this->m_Controls->m_StatisticsTable->setItem( 0, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetMean(), 0, 'f', decimals) ) );
+  this->m_Controls->m_StatisticsTable->setItem( 1, t, new QTableWidgetItem( histogramStatisticsValid ?
+      QString("%1").arg(s.GetMedian(), 0, 'f', decimals) : QString("NA") ) );
+  this->m_Controls->m_StatisticsTable->setItem( 2, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetSigma(), 0, 'f', decimals) ) );
+  this->m_Controls->m_StatisticsTable->setItem( 3, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetRMS(), 0, 'f', decimals) ) );
+
+  QString max; max.append(QString("%1").arg(s.GetMax(), 0, 'f', decimals));
+  max += " (";
+  for (int i=0; i<s.GetMaxIndex().size(); i++)
+  {
+    max += QString::number(s.GetMaxIndex()[i]);
+    if (i<s.GetMaxIndex().size()-1)
+      max += ",";
+  }
+  max += ")";
+  this->m_Controls->m_StatisticsTable->setItem( 4, t, new QTableWidgetItem( max ) );
+
+  QString min; min.append(QString("%1").arg(s.GetMin(), 0, 'f', decimals));
+  min += " (";
+  for (int i=0; i<s.GetMinIndex().size(); i++)
+  {
+    min += QString::number(s.GetMinIndex()[i]);
+    if (i<s.GetMinIndex().size()-1)
+      min += ",";
+  }
+  min += ")";
+  this->m_Controls->m_StatisticsTable->setItem( 5, t, new QTableWidgetItem( min ) );
+
+  this->m_Controls->m_StatisticsTable->setItem( 6, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetN()) ) );
+
+  const mitk::BaseGeometry *geometry = image->GetGeometry();
+  if ( geometry != NULL )
+  {
+    const mitk::Vector3D &spacing = image->GetGeometry()->GetSpacing();
+    double volume = spacing[0] * spacing[1] * spacing[2] * (double) s.GetN();
+    this->m_Controls->m_StatisticsTable->setItem( 7, t, new QTableWidgetItem(
+        QString("%1").arg(volume, 0, 'f', decimals) ) );
+  }
+  else
+  {
+    this->m_Controls->m_StatisticsTable->setItem( 7, t, new QTableWidgetItem(
+        "NA" ) );
+  }
+
+  //statistics of higher order should have 5 decimal places because they used to be very small
+  this->m_Controls->m_StatisticsTable->setItem( 8, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetSkewness(), 0, 'f', 5) ) );
+
+  this->m_Controls->m_StatisticsTable->setItem( 9, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetKurtosis(), 0, 'f', 5) ) );
+
+  this->m_Controls->m_StatisticsTable->setItem( 10, t, new QTableWidgetItem( histogramStatisticsValid ?
+      QString("%1").arg(s.GetUniformity(), 0, 'f', 5) : QString("NA") ) );
+
+  this->m_Controls->m_StatisticsTable->setItem( 11, t, new QTableWidgetItem( histogramStatisticsValid ?
+      QString("%1").arg(s.GetEntropy(), 0, 'f', 5) : QString("NA") ) );
+
+  this->m_Controls->m_StatisticsTable->setItem( 12, t, new QTableWidgetItem(
+      QString("%1").arg(s.GetMPP(), 0, 'f', decimals) ) );
+
+  this->m_Controls->m_StatisticsTable->setItem( 13, t, new QTableWidgetItem( histogramStatisticsValid ?
+      QString("%1").arg(s.GetUPP(), 0, 'f', 5) : QString("NA") ) );
+}
+
 std::vector<QString> QmitkImageStatisticsView::CalculateStatisticsForPlanarFigure( const mitk::Image *image)
 {
   std::vector<QString> result;
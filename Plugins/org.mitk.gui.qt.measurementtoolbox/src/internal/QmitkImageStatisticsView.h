@@ -25,8 +25,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "QmitkImageStatisticsCalculationThread.h"
 #include <berryIPartListener.h>
 
+class QTimer;
+
 // mitk includes
 #include "mitkImageStatisticsCalculator.h"
+#include "mitkIncrementalImageStatisticsCalculator.h"
 #include "mitkILifecycleAwarePart.h"
 #include "mitkPlanarLine.h"
 
@@ -97,6 +100,8 @@ public:
       void JumpToCoordinates(int row, int col);
       /** \brief Toogle GUI elements if histogram default bin size checkbox value changed. */
       void OnDefaultBinSizeBoxChanged();
+      /** \brief Runs the full statistics calculation once the mask has not been edited for a while. */
+      void OnFullStatisticsUpdateTimeout();
 
 signals:
       /** \brief Method to set the data to the member and start the threaded statistics update */
@@ -107,6 +112,10 @@ protected:
   void FillStatisticsTableView( const std::vector<mitk::ImageStatisticsCalculator::Statistics> &s,
     const mitk::Image *image );
 
+  /** \brief  Writes the statistics of one time step to its column, histogram based values are shown as NA if not calculated */
+  void FillStatisticsTableColumn( const mitk::ImageStatisticsCalculator::Statistics &s, unsigned int t,
+    const mitk::Image *image, int decimals, bool histogramStatisticsValid );
+
 
   std::vector<QString> CalculateStatisticsForPlanarFigure( const mitk::Image *image);
 
@@ -139,6 +148,16 @@ protected:
 
   /** \brief Method called when itkModifiedEvent is called by selected data. */
   void SelectedDataModified();
+  /** \brief Method called when itkModifiedEvent is called by the selected image. */
+  void SelectedImageModified();
+  /** \brief Method called when itkModifiedEvent is called by the selected mask. */
+  void SelectedImageMaskModified();
+  /** \brief Creates or removes the incremental calculator for the current selection and time step. */
+  void UpdateIncrementalStatisticsCalculator( unsigned int timeStep );
+  /** \brief Removes the incremental calculator and its observer */
+  void RemoveIncrementalStatisticsCalculator();
+  /** \brief Method called when the incremental calculator has applied an edit of the mask (or lost track of it). */
+  void IncrementalStatisticsModified();
   /** \brief  Method called when the data manager selection changes */
   void SelectionChanged(const QList<mitk::DataNode::Pointer> &selectedNodes);
   /** \brief  Method called to remove old selection when a new selection is present */
@@ -175,6 +194,11 @@ protected:
   long m_ImageMaskObserverTag;
   long m_PlanarFigureObserverTag;
   long m_TimeObserverTag;
+  long m_IncrementalCalculatorObserverTag;
+
+  // keeps the statistics of an edited mask up to date between the full calculations
+  mitk::IncrementalImageStatisticsCalculator::Pointer m_IncrementalCalculator;
+  QTimer* m_FullStatisticsUpdateTimer;
 
   SelectedDataNodeVectorType m_SelectedDataNodes;
 